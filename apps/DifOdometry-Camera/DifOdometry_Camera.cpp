@@ -35,6 +35,7 @@ void CDifodoCamera::loadConfiguration(const utils::CConfigFileBase& ini)
 	cols = ini.read_int("DIFODO_CONFIG", "cols", 320, true);
 	fps = ini.read_int("DIFODO_CONFIG", "fps", 30, false);
 	ctf_levels = ini.read_int("DIFODO_CONFIG", "ctf_levels", 5, true);
+	num_threads = ini.read_int("DIFODO_CONFIG", "num_threads", 0, false);
 
 	//			Resize Matrices and adjust parameters
 	//=========================================================
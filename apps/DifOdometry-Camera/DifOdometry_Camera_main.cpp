@@ -33,7 +33,10 @@ const char* default_cfg_txt =
 	";Indicate the number of rows and columns. \n"
 	"rows = 240 \n"
 	"cols = 320 \n"
-	"ctf_levels = 5 \n\n";
+	"ctf_levels = 5 \n\n"
+
+	";Number of threads (0: as many as cores) \n"
+	"num_threads = 0 \n\n";
 
 // ------------------------------------------------------
 //						MAIN
@@ -142,8 +145,7 @@ int main(int num_arg, char* argv[])
 					odo.odometryCalculation();
 					if (odo.save_results == 1) odo.writeTrajectoryFile();
 
-					cout << endl
-						 << "Difodo runtime(ms): " << odo.execution_time;
+					odo.printRuntime();
 					odo.updateScene();
 					break;
 
@@ -177,7 +179,7 @@ int main(int num_arg, char* argv[])
 				odo.odometryCalculation();
 				if (odo.save_results == 1) odo.writeTrajectoryFile();
 
-				cout << endl << "Difodo runtime(ms): " << odo.execution_time;
+				odo.printRuntime();
 				odo.updateScene();
 			}
 		}
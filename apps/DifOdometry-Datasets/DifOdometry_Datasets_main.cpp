@@ -31,6 +31,9 @@ const char* default_cfg_txt =
 	"cols = 320 \n"
 	"ctf_levels = 5 \n\n"
 
+	";Number of threads (0: as many as cores) \n"
+	"num_threads = 0 \n\n"
+
 	";Absolute path of the rawlog file \n"
 	"filename = "
 	"C:/Users/Mariano/Desktop/rawlog_rgbd_dataset_freiburg1_desk/"
@@ -149,8 +152,7 @@ int main(int num_arg, char* argv[])
 						odo.odometryCalculation();
 						if (odo.save_results == 1) odo.writeTrajectoryFile();
 
-						cout << endl
-							 << "Difodo runtime(ms): " << odo.execution_time;
+						odo.printRuntime();
 						odo.updateScene();
 					}
 
@@ -182,8 +184,7 @@ int main(int num_arg, char* argv[])
 					odo.odometryCalculation();
 					if (odo.save_results == 1) odo.writeTrajectoryFile();
 
-					cout << endl
-						 << "Difodo runtime(ms): " << odo.execution_time;
+					odo.printRuntime();
 					odo.updateScene();
 				}
 			}
@@ -518,6 +518,7 @@ void navlog_viewer_GUI_designDialog::loadLogfile(const std::string& filName)
 
 	m_log_first_tim = INVALID_TIMESTAMP;
 	m_log_last_tim = INVALID_TIMESTAMP;
+	CLogFileRecord::Ptr prev_logptr;
 
 	for (;;)
 	{
@@ -542,6 +543,12 @@ void navlog_viewer_GUI_designDialog::loadLogfile(const std::string& filName)
 			{
 				const CLogFileRecord::Ptr logptr =
 					std::dynamic_pointer_cast<CLogFileRecord>(obj);
+				// Delta-encoded logs: recover data not repeated in each
+				// record:
+				if (logptr->static_fields_omitted && prev_logptr)
+					logptr->restoreStaticFieldsFrom(*prev_logptr);
+				prev_logptr = logptr;
+
 				const auto it = logptr->timestamps.find("tim_start_iteration");
 				if (it != logptr->timestamps.end()) m_log_last_tim = it->second;
 
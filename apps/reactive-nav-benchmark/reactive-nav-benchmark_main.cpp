@@ -0,0 +1,272 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+/*---------------------------------------------------------------
+	APPLICATION: reactive-nav-benchmark
+	PURPOSE: Headless batch simulation of reactive navigators, reporting
+			 latency statistics and success rates. Intended for
+			 performance regression tests.
+
+	See the "--help" output for the list of arguments, and the example
+	scenarios file in:
+	 share/mrpt/config_files/navigation-ptgs/reactive-nav-benchmark.ini
+ ---------------------------------------------------------------*/
+
+#include <mrpt/nav/reactive/CReactiveNavBatchSimulator.h>
+#include <mrpt/utils/CConfigFile.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt/system/os.h>
+#include <mrpt/otherlibs/tclap/CmdLine.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace mrpt;
+using namespace mrpt::nav;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+// Declare the supported command line switches ===========
+TCLAP::CmdLine cmd("reactive-nav-benchmark", ' ', MRPT_getVersion().c_str());
+
+TCLAP::ValueArg<std::string> arg_scenarios_file(
+	"i", "input", "Scenarios .ini file (required). Each section is a scenario.",
+	true, "", "scenarios.ini", cmd);
+TCLAP::ValueArg<unsigned int> arg_threads(
+	"t", "threads", "Number of worker threads (default: one per core)", false,
+	0, "N", cmd);
+TCLAP::ValueArg<unsigned int> arg_repeat(
+	"r", "repeat", "Run each scenario N times (default: 1)", false, 1, "N",
+	cmd);
+TCLAP::ValueArg<std::string> arg_csv(
+	"", "csv", "Save per-scenario results to this CSV file", false, "",
+	"results.csv", cmd);
+TCLAP::ValueArg<double> arg_max_p95(
+	"", "max-latency-p95",
+	"Exit with an error code if the 95th percentile of navigationStep() "
+	"latency is above this value (milliseconds)",
+	false, 0, "ms", cmd);
+TCLAP::ValueArg<double> arg_min_success(
+	"", "min-success-rate",
+	"Exit with an error code if the ratio of successful scenarios is below "
+	"this value [0,1]",
+	false, 0, "ratio", cmd);
+TCLAP::SwitchArg arg_quiet("q", "quiet", "Terse output", cmd, false);
+
+static std::string readTextFile(const std::string& fil)
+{
+	std::ifstream f(fil);
+	if (!f.is_open())
+		THROW_EXCEPTION_FMT("Cannot open file: `%s`", fil.c_str());
+	std::stringstream ss;
+	ss << f.rdbuf();
+	return ss.str();
+}
+
+// Relative paths are relative to the scenarios file:
+static std::string resolvePath(
+	const std::string& base_dir, const std::string& fil)
+{
+	if (fil.empty() || fil[0] == '/' || fileExists(fil)) return fil;
+	return base_dir + std::string("/") + fil;
+}
+
+static void loadScenarios(
+	const std::string& scenarios_file,
+	std::vector<CReactiveNavBatchSimulator::TScenario>& scenarios)
+{
+	CConfigFile cfg(scenarios_file);
+	const std::string base_dir = extractFileDirectory(scenarios_file);
+
+	vector_string sections;
+	cfg.getAllSections(sections);
+	for (const auto& sect : sections)
+	{
+		CReactiveNavBatchSimulator::TScenario s;
+		s.name = sect;
+		s.nav_config_text = readTextFile(resolvePath(
+			base_dir, cfg.read_string(sect, "nav_config_file", "", true)));
+		s.navigator_class =
+			cfg.read_string(sect, "navigator_class", s.navigator_class);
+		s.holonomic_method =
+			cfg.read_string(sect, "holonomic_method", s.holonomic_method);
+
+		const std::string kin =
+			cfg.read_string(sect, "kinematics", "diff_driven");
+		if (kin == "diff_driven")
+			s.kinematics = CReactiveNavBatchSimulator::kinDiffDriven;
+		else if (kin == "holonomic")
+			s.kinematics = CReactiveNavBatchSimulator::kinHolonomic;
+		else
+			THROW_EXCEPTION_FMT(
+				"[%s] Invalid `kinematics`: `%s` (valid values: "
+				"diff_driven, holonomic)",
+				sect.c_str(), kin.c_str());
+
+		s.map = std::make_shared<mrpt::maps::COccupancyGridMap2D>();
+		const std::string map_file =
+			resolvePath(base_dir, cfg.read_string(sect, "map_file", ""));
+		if (map_file.empty())
+		{
+			// Empty world:
+			const double L = cfg.read_double(sect, "world_size", 40.0);
+			s.map->setSize(-0.5 * L, 0.5 * L, -0.5 * L, 0.5 * L, 0.1f);
+			s.map->fill(0.9f);
+		}
+		else if (extractFileExtension(map_file, true) == "gridmap")
+		{
+			CFileGZInputStream f(map_file);
+			f >> *s.map;
+		}
+		else
+		{
+			if (!s.map->loadFromBitmapFile(
+					map_file, cfg.read_float(sect, "map_resolution", 0.05f)))
+				THROW_EXCEPTION_FMT(
+					"Error loading map image: `%s`", map_file.c_str());
+		}
+
+		s.start_pose.x = cfg.read_double(sect, "start_x", 0.0);
+		s.start_pose.y = cfg.read_double(sect, "start_y", 0.0);
+		s.start_pose.phi =
+			DEG2RAD(cfg.read_double(sect, "start_phi_deg", 0.0));
+		s.target.x = cfg.read_double(sect, "target_x", 0.0, true);
+		s.target.y = cfg.read_double(sect, "target_y", 0.0, true);
+		s.target_allowed_distance = cfg.read_double(
+			sect, "target_allowed_distance", s.target_allowed_distance);
+		s.sim_period = cfg.read_double(sect, "sim_period", s.sim_period);
+		s.max_sim_time = cfg.read_double(sect, "max_sim_time", s.max_sim_time);
+		s.laser_max_range =
+			cfg.read_double(sect, "laser_max_range", s.laser_max_range);
+		s.laser_rays = cfg.read_int(sect, "laser_rays", s.laser_rays);
+		s.laser_height = cfg.read_double(sect, "laser_height", s.laser_height);
+
+		scenarios.push_back(s);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		// Parse arguments:
+		if (!cmd.parse(argc, argv))
+			throw std::runtime_error("");  // should exit.
+
+		const bool verbose = !arg_quiet.getValue();
+
+		CReactiveNavBatchSimulator sim;
+		sim.setMinLoggingLevel(verbose ? LVL_INFO : LVL_ERROR);
+		sim.num_threads = arg_threads.getValue();
+
+		std::vector<CReactiveNavBatchSimulator::TScenario> scenarios;
+		loadScenarios(arg_scenarios_file.getValue(), scenarios);
+		for (unsigned int r = 0; r < arg_repeat.getValue(); r++)
+			for (const auto& s : scenarios)
+			{
+				sim.scenarios.push_back(s);
+				if (arg_repeat.getValue() > 1)
+					sim.scenarios.back().name += format("#%u", r);
+			}
+
+		std::vector<CReactiveNavBatchSimulator::TResult> results;
+		sim.run(results);
+		const auto st = CReactiveNavBatchSimulator::computeStatistics(
+			results, sim.getLastRunTime());
+
+		if (verbose)
+		{
+			for (const auto& r : results)
+				printf(
+					"%-30s %-8s steps=%6u sim_time=%8.2fs path=%8.2fm "
+					"dist_to_target=%6.2fm %s\n",
+					r.name.c_str(),
+					r.success ? "OK"
+							  : r.collision
+									? "COLLIS."
+									: r.nav_error
+										  ? "NAV_ERR"
+										  : r.timeout ? "TIMEOUT" : "FAIL",
+					static_cast<unsigned int>(r.step_latencies.size()),
+					r.sim_time, r.path_length, r.final_distance_to_target,
+					r.error_msg.c_str());
+		}
+
+		printf(
+			"Scenarios: %u  success: %u (%.1f%%)  collisions: %u  nav errors: "
+			"%u  timeouts: %u\n",
+			static_cast<unsigned int>(st.num_scenarios),
+			static_cast<unsigned int>(st.num_success), 100.0 * st.success_rate,
+			static_cast<unsigned int>(st.num_collisions),
+			static_cast<unsigned int>(st.num_nav_errors),
+			static_cast<unsigned int>(st.num_timeouts));
+		printf(
+			"navigationStep() latency over %u steps [ms]: mean=%.3f "
+			"median=%.3f p95=%.3f p99=%.3f max=%.3f\n",
+			static_cast<unsigned int>(st.num_steps), 1e3 * st.latency_mean,
+			1e3 * st.latency_median, 1e3 * st.latency_p95,
+			1e3 * st.latency_p99, 1e3 * st.latency_max);
+		printf(
+			"Wall-clock time: %.3f s  (%.1fx real time)\n",
+			sim.getLastRunTime(), st.realtime_factor);
+
+		if (arg_csv.isSet())
+		{
+			std::ofstream f(arg_csv.getValue());
+			if (!f.is_open())
+				THROW_EXCEPTION_FMT(
+					"Cannot create: `%s`", arg_csv.getValue().c_str());
+			f << "name,success,collision,nav_error,timeout,steps,sim_time,"
+				 "path_length,final_distance_to_target,latency_mean,"
+				 "latency_max\n";
+			for (const auto& r : results)
+			{
+				double lat_sum = 0, lat_max = 0;
+				for (const double l : r.step_latencies)
+				{
+					lat_sum += l;
+					keep_max(lat_max, l);
+				}
+				f << r.name << "," << r.success << "," << r.collision << ","
+				  << r.nav_error << "," << r.timeout << ","
+				  << r.step_latencies.size() << "," << r.sim_time << ","
+				  << r.path_length << "," << r.final_distance_to_target << ","
+				  << (r.step_latencies.empty()
+						  ? 0.0
+						  : lat_sum / r.step_latencies.size())
+				  << "," << lat_max << "\n";
+			}
+		}
+
+		// Pass/fail criteria for CI:
+		int ret = 0;
+		if (arg_max_p95.isSet() &&
+			1e3 * st.latency_p95 > arg_max_p95.getValue())
+		{
+			cerr << "FAILED: latency p95 " << 1e3 * st.latency_p95
+				 << " ms > " << arg_max_p95.getValue() << " ms\n";
+			ret = 1;
+		}
+		if (arg_min_success.isSet() &&
+			st.success_rate < arg_min_success.getValue())
+		{
+			cerr << "FAILED: success rate " << st.success_rate << " < "
+				 << arg_min_success.getValue() << "\n";
+			ret = 1;
+		}
+		return ret;
+	}
+	catch (std::exception& e)
+	{
+		if (strlen(e.what())) std::cerr << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -40,3 +40,4 @@ DEFINE_SSE_VAR(SSE3)
 DEFINE_SSE_VAR(SSE4_1)
 DEFINE_SSE_VAR(SSE4_2)
 DEFINE_SSE_VAR(SSE4_A)
+DEFINE_SSE_VAR(AVX2)
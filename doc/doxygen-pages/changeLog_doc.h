@@ -23,16 +23,63 @@
 	- All pointer typedefs are now in their respective classes.
 	- Using a variant type from the mapbox variant library, and added serialization with variants(To be replaced by std::variant eventually).
 - <b>Detailed list of changes:</b>
+	- Changes in apps:
+		- New app reactive-nav-benchmark: headless batch simulation of reactive navigators, reporting latency statistics and success rates.
 	- Changes in libraries:
 		- \ref mrpt_base_grp
 			- Removed functions (replaced by C++11/14 standard library):
 				- mrpt::math::erf, mrpt::math::erfc, std::isfinite, mrpt::math::std::isnan
+			- New class mrpt::math::CSparseBlockCholesky: block-sparse Cholesky factorization with reusable symbolic analysis.
+			- New class mrpt::utils::CMemoryMappedFile: read-only memory mapping of a whole file.
+			- New header <mrpt/utils/parallel.h>: simple fork-join parallel loops (mrpt::utils::parallel_for_ranges(), mrpt::utils::parallel_for_jobs()), shared by the multithreaded algorithms of MRPT.
+			- New method mrpt::math::ModelSearch::ransacParallel(): RANSAC with hypotheses evaluated in parallel by deterministic rounds, samples scored by blocks (with an optional, vectorizable `testSamples()` method of the model), early bailout of hypotheses which cannot beat the best one, optional PROSAC-like sampling and no per-hypothesis allocations. mrpt::math::ModelSearch::ransacSingleModel() only builds the inlier list of the best model.
+			- mrpt::math::RANSAC_Template::execute() evaluates hypotheses in rounds, in parallel if enabled with mrpt::math::RANSAC_Template::setNumThreads(), with results independent of the number of threads.
+			- mrpt::math::ransac_detect_3D_planes() and mrpt::math::ransac_detect_2D_lines() use mrpt::math::ModelSearch::ransacParallel() with Eigen-vectorized point-to-model distances.
+		- \ref mrpt_graphs_grp
+			- New class mrpt::graphs::CCompressedGraph: compressed sparse row (CSR) index of the nodes and edges of a graph, with an append buffer.
+			- mrpt::graphs::CDijkstra runs on a mrpt::graphs::CCompressedGraph with a binary heap, and can reuse a prebuilt index. Its results are unchanged.
+			- mrpt::graphs::CNetworkOfPoses::extractSubGraph() can use a mrpt::graphs::CCompressedGraph to visit only the edges of the selected nodes.
+			- New class mrpt::graphs::CShortestPathTrees: cache of Dijkstra shortest-path trees from several sources, which are repaired instead of recomputed when nodes and edges are appended to the graph.
+			- mrpt::graphs::CGraphPartitioner: sparse versions of the spectral partition methods, which compute the Fiedler vector with a multilevel (heavy-edge coarsening + Lanczos refinement) eigen-solver instead of a dense eigen-decomposition.
+			- mrpt::graphs::CNetworkOfPoses::loadFromTextFile() parses memory-mapped files in place, with a faster number parser.
+			- New methods mrpt::graphs::CNetworkOfPoses::saveToBinaryFile() and mrpt::graphs::CNetworkOfPoses::loadFromBinaryFile(): compact binary graph files, with the same contents than text files at full precision.
+			- mrpt::graphs::ScalarFactorGraph keeps the sparsity pattern and the symbolic factorization of the system between calls to updateEstimation(), evaluates the factors in parallel and grouped by type (without virtual calls for types registered with registerFactorType()), and has new solvers (sparse Cholesky, preconditioned conjugate gradient) and robust kernels (Huber, Cauchy). See mrpt::graphs::ScalarFactorGraph::solverOptions.
+		- \ref mrpt_graphslam_grp
+			- mrpt::graphslam::optimize_graph_spa_levmarq() does the symbolic analysis of the Hessian only once per call, and factors it with mrpt::math::CSparseBlockCholesky.
+			- mrpt::graphslam::optimize_graph_spa_levmarq() evaluates Jacobians, errors and the Hessian of the edges in parallel (new parameter `num_threads`), using a flat index-based layout of nodes and edges.
+			- New class mrpt::graphslam::CIncrementalSmoother, which keeps the Cholesky factor of a pose graph between updates and only recomputes the part affected by new nodes, new edges and relinearized nodes (iSAM2-like).
+			- New optimizer mrpt::graphslam::optimizers::CIncrementalSmootherGSO, available in `graphslam-engine`.
+			- mrpt::graphslam::deciders::CLoopCloserERD: the uncertainty paths between the nodes of each partition follow shortest-path trees (mrpt::graphs::CShortestPathTrees) which are kept up to date incrementally and computed in one batch per partition, instead of running a Dijkstra projection for every pair of nodes.
+			- New class mrpt::graphslam::CJobScheduler: a small pool of worker threads for batches of independent jobs.
+			- The ICP alignments of mrpt::graphslam::deciders::CICPCriteriaERD and mrpt::graphslam::deciders::CLoopCloserERD (neighbor nodes and loop-closure hypotheses) run in parallel (new ICP parameter `num_threads`). CLoopCloserERD may cancel the pending alignments once enough valid hypotheses are found (new parameter `LC_enough_valid_hypots`).
+			- New function mrpt::graphslam::marginalize_graph_nodes(): marginalizes out nodes of a graph into dense prior factors (mrpt::graphslam::TMarginalPriors, Schur complement of their edges), which mrpt::graphslam::optimize_graph_spa_levmarq() takes into account (new optional argument).
+			- mrpt::graphslam::optimizers::CLevMarqGSO: new sliding-window mode (parameter `marginalization_window`), which marginalizes out the nodes older than the window so the size of the linear system to solve stays bounded.
+		- \ref mrpt_vision_grp
+			- mrpt::vision::matchFeatures() only compares the features near each epipolar line (sorted by rows, or bucketed in a grid for a fundamental matrix), computes SIFT/SURF/ORB descriptor distances with SIMD and popcount kernels, and runs in parallel (new option mrpt::vision::TMatchingOptions::num_threads). Its results are unchanged. New ratio test for ORB descriptors (mrpt::vision::TMatchingOptions::ORB_RATIO).
+			- New class mrpt::vision::CCompactFeatureList: features stored as arrays of keypoint fields plus one contiguous, 16-byte aligned matrix per descriptor type (mrpt::vision::TDescriptorMatrix), convertible from/to mrpt::vision::CFeatureList. Accepted by new overloads of mrpt::vision::matchFeatures(), mrpt::vision::CFeatureExtraction::detectFeatures() and computeDescriptors() (ORB writes the descriptors directly), mrpt::vision::find_descriptor_pairings() and the descriptor KD-trees, which now read the descriptors from such a matrix.
+			- mrpt::vision::CFeatureExtraction::detectFeatures() can run the detector on all the octaves of an image pyramid in parallel (new options mrpt::vision::CFeatureExtraction::TOptions::multiScaleOptions). The FASTER detectors run on tiles of each octave, with non-maximum suppression of the FAST score, and the merged features (sorted by response) are spread over the image with a grid. New AVX2 version of the FASTER corner test (new CMake flag `CMAKE_MRPT_HAS_AVX2`, autodetected as the SSE ones).
+			- mrpt::vision::CFeatureTracker_KL no longer calls OpenCV's cvCalcOpticalFlowPyrLK(): it keeps the pyramid of the last image (mrpt::vision::TKLTPyramid) to reuse it in the next call, tracks features in parallel batches (new parameter `num_threads`) with SSE2/AVX2 bilinear sampling and Gauss-Newton sums, and reports the convergence of each feature in mrpt::vision::CFeatureTracker_KL::last_tracking_stats. New parameter `LK_min_eigenvalue`.
+			- New function mrpt::vision::bundle_adj_sparse(): bundle adjustment for large problems, with the Schur complement onto the camera poses in a block-sparse matrix whose pattern is analyzed once, solved with mrpt::math::CSparseBlockCholesky or preconditioned conjugate gradient, parallel evaluation of residuals, Jacobians and the Schur complement, and robust kernels (mrpt::math::RobustKernel) applied to the gradient and the Hessian.
+			- mrpt::vision::CUndistortMap and mrpt::vision::CStereoRectifyMap keep their maps as fixed-point look-up tables (new struct mrpt::vision::TRemapLUT), computed without OpenCV, and remap images with SSE2/AVX2 bilinear kernels by blocks of rows in parallel (new methods `setNumThreads()`); both stereo images are processed by the same pool of threads.
+			- New class mrpt::vision::CStereoSGM: dense stereo matching (Semi-Global Matching on census costs, with SSE2/AVX2 path aggregation and multithreaded scanlines and rows), which converts rectified mrpt::obs::CObservationStereoImages into the depth image of a mrpt::obs::CObservation3DRangeScan.
+			- New class mrpt::vision::pnp::CPnPRansac: robust PnP with P3P hypotheses generated in parallel, SSE2/AVX reprojection-error scoring, early rejection of bad models (SPRT) and LO-RANSAC refinement, for one or a batch of correspondence sets, returning the inliers and timings.
+			- mrpt::vision::CDifodo: the stages of the coarse-to-fine odometry (pyramid, warping, derivatives, weights and linear system) run on blocks of columns in parallel (CDifodo::num_threads), with Eigen-vectorized per-column kernels and the warping fused with the computation of the "average" coordinates and temporal derivative. Per-stage runtimes are kept in CDifodo::stage_times and printed by the new CDifodo::printRuntime().
 		- \ref mrpt_slam_grp
 			- rbpf-slam: Add support for simplemap continuation.
+			- mrpt::slam::CIncrementalMapPartitioner uses the sparse spectral partition of mrpt::graphs::CGraphPartitioner by default (new option `useSparsePartitioner`).
 		- \ref mrpt_nav_grp
 			- Removed deprecated mrpt::nav::THolonomicMethod.
+			- New class mrpt::nav::CReactiveNavBatchSimulator to run many simulated robots and navigators in parallel.
+			- mrpt::nav::CReactiveNavigationSystem3D keeps sensed obstacles in a rolling, robot-centered grid per height level, with optional obstacle memory (new params `obstacle_grid_resolution`, `obstacle_memory_time`).
+			- Reactive navigation log files are now written from a background thread, and mrpt::nav::CLogFileRecord (v27) omits the robot shape and PTG descriptions when they did not change.
 	- BUG FIXES:
 		- Fix reactive navigator inconsistent state if navigation API is called from within rnav callbacks.
+		- mrpt::graphslam::optimize_graph_spa_levmarq(): the Hessian kept accumulating the values of previous iterations.
+		- mrpt::graphs::CNetworkOfPoses::loadFromTextFile(): three entries of the information matrix of 3D edges were lost.
+		- mrpt::vision::TMatchingOptions::maxORB_dist was not initialized.
+		- mrpt::vision::TSURFDescriptorsKDTreeIndex used the length of the SIFT descriptors, and mrpt::vision::find_descriptor_pairings() did not build for kd-trees with non-double distances.
+		- The SSE2 versions of the FASTER detectors (mrpt::vision::CFeatureExtraction::detectFeatures_SSE2_FASTER9() etc.) gave wrong corners for images whose rows are padded (row stride different than the width).
+		- mrpt::vision::CFeatureTracker_KL: the parameter `LK_epsilon` was truncated to an integer.
 
 <hr>
 <a name="1.5.0">
@@ -108,6 +155,7 @@
 			- mrpt::maps::CPointsMap `liblas` import/export methods are now in a separate header. See \ref mrpt_maps_liblas_grp and \ref dep-liblas
 			- New class mrpt::maps::CRandomFieldGridMap3D
 			- New class mrpt::maps::CPointCloudFilterByDistance
+			- mrpt::maps::CRandomFieldGridMap2D and mrpt::maps::CRandomFieldGridMap3D: new GMRF options `GMRF_solver` and `GMRF_num_threads`.
 		- \ref mrpt_obs_grp
 			- [ABI change] mrpt::obs::CObservation2DRangeScan
 				- range scan vectors are now protected for safety.
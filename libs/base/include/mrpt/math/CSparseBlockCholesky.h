@@ -0,0 +1,352 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/CSparseMatrix.h>  // CSparse API (cs_amd), exceptions
+#include <mrpt/utils/aligned_containers.h>
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace mrpt
+{
+namespace math
+{
+/** Cholesky factorization of symmetric, positive-definite block-sparse
+ * matrices made of dense BLOCK_SIZE x BLOCK_SIZE blocks, typical of
+ * Hessians in pose-graph optimization and bundle adjustment.
+ *
+ * Intended for iterative solvers, where many matrices with the same sparsity
+ * pattern but different values must be factored:
+ *  - setPattern() does all the symbolic work once: fill-reducing AMD
+ *    ordering of the block graph, elimination tree and structure of the
+ *    factor L, and a map from each input block to its place in L.
+ *  - The user fills the values of the matrix blocks in place (see entry()),
+ *    and calls factorize(), which does not allocate memory.
+ *  - The numeric factorization works at block level: each block column of L
+ *    is a supernode of fixed width BLOCK_SIZE processed with dense,
+ *    fixed-size Eigen kernels.
+ *
+ * Usage:
+ * \code
+ * CSparseBlockCholesky<3> chol;
+ * std::vector<size_t> idxs;
+ * chol.setPattern(nBlocks, lower_blocks, idxs);
+ * chol.setZero();
+ * chol.entry(i) += ...;  // diagonal blocks are entries [0,nBlocks)
+ * chol.entry(idxs[k]) += ...;  // k'th block in lower_blocks
+ * chol.factorize(lambda);  // Factor A + lambda*I
+ * chol.solve(b, x);
+ * \endcode
+ *
+ * \sa CSparseMatrix::CholeskyDecomp
+ * \ingroup mrpt_base_grp
+ */
+template <int BLOCK_SIZE, typename Scalar = double>
+class CSparseBlockCholesky
+{
+   public:
+	typedef Eigen::Matrix<Scalar, BLOCK_SIZE, BLOCK_SIZE> block_t;
+	typedef Eigen::Matrix<Scalar, BLOCK_SIZE, 1> block_vector_t;
+	typedef typename mrpt::aligned_containers<block_t>::vector_t block_list_t;
+
+	CSparseBlockCholesky() : m_nBlocks(0) {}
+
+	/** Defines the block sparsity pattern and does the symbolic analysis.
+	 * \param[in] nBlocks Number of block rows (and columns) of the matrix.
+	 * \param[in] lower_blocks Coordinates (row,col) of the off-diagonal
+	 * blocks in the lower triangular part (row>col). Repeated coordinates are
+	 * allowed. Diagonal blocks are always part of the pattern.
+	 * \param[out] out_entry_indices The index for each of `lower_blocks` to
+	 * be used in entry(). Diagonal block `i` has always index `i`.
+	 */
+	void setPattern(
+		const size_t nBlocks,
+		const std::vector<std::pair<size_t, size_t>>& lower_blocks,
+		std::vector<size_t>& out_entry_indices);
+
+	/** Number of blocks in the pattern (diagonal + unique lower blocks) */
+	size_t getPatternSize() const { return m_A.size(); }
+	/** Number of blocks in the lower triangular factor L */
+	size_t getFactorSize() const { return m_L.size(); }
+	/** Number of block rows (and columns) of the matrix */
+	size_t getBlockCount() const { return m_nBlocks; }
+
+	/** Block `idx` of the matrix to factor, see setPattern() */
+	block_t& entry(const size_t idx) { return m_A[idx]; }
+	const block_t& entry(const size_t idx) const { return m_A[idx]; }
+	/** Sets all matrix blocks to zero, keeping the pattern */
+	void setZero()
+	{
+		for (auto& b : m_A) b.setZero();
+	}
+
+	/** Computes the factorization L*L^t = P * (A + diag_add * I) * P^t.
+	 * \exception mrpt::math::CExceptionNotDefPos If A+diag_add*I is not
+	 * positive definite.
+	 */
+	void factorize(const Scalar diag_add = 0);
+
+	/** Solves A*x=b using the last factorization. `b` and `x` have
+	 * getBlockCount()*BLOCK_SIZE elements, and can be the same array. */
+	void solve(const Scalar* b, Scalar* x) const;
+
+	template <class VECTOR1, class VECTOR2>
+	void solve(const VECTOR1& b, VECTOR2& x) const
+	{
+		ASSERT_EQUAL_(size_t(b.size()), m_nBlocks * BLOCK_SIZE)
+		x.resize(b.size());
+		solve(&b[0], &x[0]);
+	}
+
+   private:
+	size_t m_nBlocks;
+	/** Matrix blocks: the m_nBlocks diagonal blocks, then lower blocks */
+	block_list_t m_A;
+	/** For each entry of m_A: its index in m_L, and whether it must be
+	 * transposed (the permutation may move it to the upper triangle) */
+	std::vector<std::pair<size_t, bool>> m_A2L;
+	/** Block-CSC structure of L (in permuted order). The first block of each
+	 * column is the diagonal one; the rest are sorted by row. */
+	std::vector<size_t> m_L_colptr, m_L_rows;
+	block_list_t m_L;
+	/** Permutation: m_perm[k] is the original index of the k'th block row */
+	std::vector<size_t> m_perm;
+};
+
+template <int BLOCK_SIZE, typename Scalar>
+void CSparseBlockCholesky<BLOCK_SIZE, Scalar>::setPattern(
+	const size_t nBlocks,
+	const std::vector<std::pair<size_t, size_t>>& lower_blocks,
+	std::vector<size_t>& out_entry_indices)
+{
+	MRPT_START
+
+	m_nBlocks = nBlocks;
+	const size_t nIn = lower_blocks.size();
+
+	// 1) Unique off-diagonal entries:
+	std::vector<std::pair<std::pair<size_t, size_t>, size_t>> sorted(nIn);
+	for (size_t i = 0; i < nIn; i++)
+	{
+		const auto& e = lower_blocks[i];
+		ASSERTMSG_(
+			e.first > e.second && e.first < nBlocks,
+			"setPattern: entries must be in the strictly lower triangle");
+		sorted[i] = std::make_pair(std::make_pair(e.second, e.first), i);
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	std::vector<std::pair<size_t, size_t>> entries;  // (row,col)
+	entries.reserve(nIn);
+	out_entry_indices.resize(nIn);
+	for (size_t i = 0; i < nIn; i++)
+	{
+		const auto& rc = sorted[i].first;  // (col,row)
+		if (i == 0 || rc != sorted[i - 1].first)
+			entries.push_back(std::make_pair(rc.second, rc.first));
+		out_entry_indices[sorted[i].second] = nBlocks + entries.size() - 1;
+	}
+
+	m_A.assign(nBlocks + entries.size(), block_t::Zero());
+
+	// 2) Fill-reducing ordering of the block graph:
+	m_perm.resize(nBlocks);
+	std::vector<size_t> pinv(nBlocks);
+	{
+		cs* T = cs_spalloc(nBlocks, nBlocks, entries.size() + 1, 0, 1);
+		for (const auto& e : entries) cs_entry(T, e.first, e.second, 0);
+		cs* A = cs_compress(T);
+		cs_spfree(T);
+		int* P = cs_amd(1 /* Cholesky */, A);
+		cs_spfree(A);
+		if (P)
+		{
+			for (size_t k = 0; k < nBlocks; k++) m_perm[k] = P[k];
+			cs_free(P);
+		}
+		else
+		{
+			for (size_t k = 0; k < nBlocks; k++) m_perm[k] = k;
+		}
+		for (size_t k = 0; k < nBlocks; k++) pinv[m_perm[k]] = k;
+	}
+
+	// 3) Lower pattern of the permuted matrix, by columns:
+	std::vector<size_t> adj_ptr(nBlocks + 1, 0), adj_rows(entries.size());
+	for (const auto& e : entries)
+		adj_ptr[std::min(pinv[e.first], pinv[e.second]) + 1]++;
+	for (size_t k = 0; k < nBlocks; k++) adj_ptr[k + 1] += adj_ptr[k];
+	{
+		std::vector<size_t> next(adj_ptr.begin(), adj_ptr.end() - 1);
+		for (const auto& e : entries)
+		{
+			const size_t pr = pinv[e.first], pc = pinv[e.second];
+			adj_rows[next[std::min(pr, pc)]++] = std::max(pr, pc);
+		}
+	}
+
+	// 4) Symbolic factorization: struct(L_k) is the union of the pattern of
+	// A below the diagonal with the structures of its children in the
+	// elimination tree (without k).
+	const size_t NONE = static_cast<size_t>(-1);
+	std::vector<size_t> marker(nBlocks, NONE);
+	std::vector<size_t> child_head(nBlocks, NONE), child_next(nBlocks, NONE);
+	m_L_colptr.assign(nBlocks + 1, 0);
+	m_L_rows.clear();
+	m_L_rows.reserve(nBlocks + 2 * entries.size());
+	for (size_t k = 0; k < nBlocks; k++)
+	{
+		m_L_colptr[k] = m_L_rows.size();
+		m_L_rows.push_back(k);  // Diagonal first
+		marker[k] = k;
+		for (size_t p = adj_ptr[k]; p < adj_ptr[k + 1]; p++)
+		{
+			const size_t r = adj_rows[p];
+			if (marker[r] != k)
+			{
+				marker[r] = k;
+				m_L_rows.push_back(r);
+			}
+		}
+		for (size_t c = child_head[k]; c != NONE; c = child_next[c])
+		{
+			for (size_t p = m_L_colptr[c] + 1; p < m_L_colptr[c + 1]; p++)
+			{
+				const size_t r = m_L_rows[p];
+				if (marker[r] != k)
+				{
+					marker[r] = k;
+					m_L_rows.push_back(r);
+				}
+			}
+		}
+		const auto itBeg = m_L_rows.begin() + m_L_colptr[k] + 1;
+		std::sort(itBeg, m_L_rows.end());
+		if (itBeg != m_L_rows.end())
+		{
+			// Parent in the elimination tree: first row below the diagonal
+			const size_t parent = *itBeg;
+			child_next[k] = child_head[parent];
+			child_head[parent] = k;
+		}
+	}
+	m_L_colptr[nBlocks] = m_L_rows.size();
+	m_L.assign(m_L_rows.size(), block_t::Zero());
+
+	// 5) Where each block of A goes in L:
+	m_A2L.resize(m_A.size());
+	for (size_t i = 0; i < nBlocks; i++)
+		m_A2L[i] = std::make_pair(m_L_colptr[pinv[i]], false);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const size_t pr = pinv[entries[i].first], pc = pinv[entries[i].second];
+		const bool transp = pr < pc;
+		const size_t r = std::max(pr, pc), c = std::min(pr, pc);
+		const auto itBeg = m_L_rows.begin() + m_L_colptr[c] + 1,
+				   itEnd = m_L_rows.begin() + m_L_colptr[c + 1];
+		const auto it = std::lower_bound(itBeg, itEnd, r);
+		ASSERT_(it != itEnd && *it == r)
+		m_A2L[nBlocks + i] =
+			std::make_pair(static_cast<size_t>(it - m_L_rows.begin()), transp);
+	}
+
+	MRPT_END
+}
+
+template <int BLOCK_SIZE, typename Scalar>
+void CSparseBlockCholesky<BLOCK_SIZE, Scalar>::factorize(
+	const Scalar diag_add)
+{
+	// Scatter A into L:
+	for (auto& b : m_L) b.setZero();
+	for (size_t i = 0; i < m_A.size(); i++)
+	{
+		block_t& dst = m_L[m_A2L[i].first];
+		if (m_A2L[i].second)
+			dst = m_A[i].transpose();
+		else
+			dst = m_A[i];
+	}
+	if (diag_add != 0)
+		for (size_t k = 0; k < m_nBlocks; k++)
+			m_L[m_L_colptr[k]].diagonal().array() += diag_add;
+
+	// Right-looking block factorization:
+	for (size_t k = 0; k < m_nBlocks; k++)
+	{
+		const size_t p0 = m_L_colptr[k], p1 = m_L_colptr[k + 1];
+
+		// Diagonal block:
+		Eigen::LLT<block_t> llt(m_L[p0]);
+		if (llt.info() != Eigen::Success)
+			throw mrpt::math::CExceptionNotDefPos(
+				"CSparseBlockCholesky: Not positive definite matrix.");
+		m_L[p0] = llt.matrixL();
+		const block_t Ukk = m_L[p0].transpose();
+
+		// L_ik = A_ik * L_kk^{-T}
+		for (size_t p = p0 + 1; p < p1; p++)
+			Ukk.template triangularView<Eigen::Upper>()
+				.template solveInPlace<Eigen::OnTheRight>(m_L[p]);
+
+		// Update the trailing submatrix: A_ij -= L_ik * L_jk^T
+		for (size_t pb = p0 + 1; pb < p1; pb++)
+		{
+			const size_t j = m_L_rows[pb];
+			const block_t& Ljk = m_L[pb];
+			// Diagonal block (i=j):
+			m_L[m_L_colptr[j]].noalias() -= Ljk * Ljk.transpose();
+			// Blocks below: rows of column k are a subset of those of j
+			size_t q = m_L_colptr[j] + 1;
+			for (size_t pa = pb + 1; pa < p1; pa++)
+			{
+				const size_t i = m_L_rows[pa];
+				while (m_L_rows[q] != i) q++;
+				m_L[q].noalias() -= m_L[pa] * Ljk.transpose();
+			}
+		}
+	}
+}
+
+template <int BLOCK_SIZE, typename Scalar>
+void CSparseBlockCholesky<BLOCK_SIZE, Scalar>::solve(
+	const Scalar* b, Scalar* x) const
+{
+	typedef typename mrpt::aligned_containers<block_vector_t>::vector_t
+		vec_list_t;
+	vec_list_t y(m_nBlocks);
+	for (size_t k = 0; k < m_nBlocks; k++)
+		y[k] = Eigen::Map<const block_vector_t>(b + BLOCK_SIZE * m_perm[k]);
+
+	// L*z = y
+	for (size_t k = 0; k < m_nBlocks; k++)
+	{
+		const size_t p0 = m_L_colptr[k], p1 = m_L_colptr[k + 1];
+		m_L[p0].template triangularView<Eigen::Lower>().solveInPlace(y[k]);
+		for (size_t p = p0 + 1; p < p1; p++)
+			y[m_L_rows[p]].noalias() -= m_L[p] * y[k];
+	}
+	// L^T*w = z
+	for (size_t k = m_nBlocks; k-- > 0;)
+	{
+		const size_t p0 = m_L_colptr[k], p1 = m_L_colptr[k + 1];
+		for (size_t p = p0 + 1; p < p1; p++)
+			y[k].noalias() -= m_L[p].transpose() * y[m_L_rows[p]];
+		m_L[p0].transpose().template triangularView<Eigen::Upper>().solveInPlace(
+			y[k]);
+	}
+
+	for (size_t k = 0; k < m_nBlocks; k++)
+		Eigen::Map<block_vector_t>(x + BLOCK_SIZE * m_perm[k]) = y[k];
+}
+
+}  // End of namespace
+}  // End of namespace
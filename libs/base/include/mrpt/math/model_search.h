@@ -36,9 +36,19 @@ namespace math
  * value that indicates how well a sample fits to the model. This way the
  * thresholding is moved to the searching procedure and the model just tells how
  * good a sample is.
+  *    - (Optional) void testSamples( size_t first, size_t count, const Model&
+ * model, Real* out ) const : the same as testSample() for the \a count
+ * samples starting at \a first. If provided, it is used instead of
+ * testSample() to score samples in blocks, so it can be vectorized (e.g. with
+ * Eigen array expressions over data in structure-of-arrays layout).
   *
   *  There are two methods provided in this class to fit a model:
   *    - \a ransacSingleModel (RANSAC): Just like mrpt::math::RANSAC_Template
+  *
+  *    - \a ransacParallel (RANSAC): Hypotheses are evaluated in parallel by
+ * rounds, scored in blocks, with early bailout of hypotheses which cannot beat
+ * the best one, optional PROSAC-like sampling and no per-hypothesis
+ * allocations. See \a options.
   *
   *    - \a geneticSingleModel (Genetic): Provides a mixture of a genetic and
  * the ransac algorithm.
@@ -64,6 +74,53 @@ namespace math
   */
 class BASE_IMPEXP ModelSearch
 {
+   public:
+	/** Parameters of ransacParallel() */
+	struct TOptions
+	{
+		TOptions()
+			: prob_good_sample(0.999),
+			  max_iterations(2000),
+			  num_threads(0),
+			  prosac(false),
+			  early_exit_inliers(0),
+			  seed(1)
+		{
+		}
+
+		/** Probability of having drawn an outlier-free sample when stopping
+		 * (default=0.999) */
+		double prob_good_sample;
+		/** Maximum number of hypotheses (default=2000) */
+		size_t max_iterations;
+		/** Number of threads (0: as many as cores, the default). fitModel()
+		 * and testSample() must be thread-safe if it is not 1. Results do not
+		 * depend on the number of threads. */
+		unsigned int num_threads;
+		/** PROSAC-like sampling (default=false): samples must be sorted by
+		 * decreasing quality (e.g. matching score), and hypotheses are drawn
+		 * from a growing set of the best ones, so good models are found
+		 * earlier. The stop criterion is the usual one, so it is useful
+		 * together with \a early_exit_inliers. */
+		bool prosac;
+		/** Stop as soon as a model has at least this number of inliers
+		 * (default=0: disabled) */
+		size_t early_exit_inliers;
+		/** Seed of the random sampling of ransacParallel() (default=1) */
+		uint64_t seed;
+	};
+
+	/** Statistics of a ransacParallel() search */
+	struct TStats
+	{
+		TStats() : num_hypotheses(0), num_degenerate(0), num_bailouts(0) {}
+		/** Number of hypotheses drawn, of those for which no non-degenerate
+		 * sample was found, and of those whose scoring was abandoned */
+		size_t num_hypotheses, num_degenerate, num_bailouts;
+	};
+
+	TOptions options;
+
    private:
 	//! Select random (unique) indices from the 0..p_size sequence
 	void pickRandomIndex(size_t p_size, size_t p_pick, vector_size_t& p_ind);
@@ -80,6 +137,18 @@ class BASE_IMPEXP ModelSearch
 		const typename TModelFit::Real& p_fitnessThreshold,
 		typename TModelFit::Model& p_bestModel, vector_size_t& p_inliers);
 
+	/** Run the ransac algorithm searching for a single model, evaluating
+	 * hypotheses in parallel (see \a options). The samples with a fitness
+	 * below \a p_fitnessThreshold are the inliers.
+	  * \return false if no model was found.
+	  */
+	template <typename TModelFit>
+	bool ransacParallel(
+		const TModelFit& p_state, size_t p_kernelSize,
+		const typename TModelFit::Real& p_fitnessThreshold,
+		typename TModelFit::Model& p_bestModel, vector_size_t& p_inliers,
+		TStats* p_stats = nullptr) const;
+
    private:
 	template <typename TModelFit>
 	struct TSpecies
@@ -14,12 +14,138 @@
 #include "model_search.h"
 #endif
 
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/utils/parallel.h>
+
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <type_traits>
+#include <utility>
 
 namespace mrpt
 {
 namespace math
 {
+namespace detail
+{
+/** Samples are scored by blocks of this size */
+const size_t MODEL_SEARCH_BLOCK = 256;
+
+/** Whether TModelFit has the optional testSamples() method */
+template <class T, class = void>
+struct has_testSamples : std::false_type
+{
+};
+template <class T>
+struct has_testSamples<
+	T, decltype(void(std::declval<const T&>().testSamples(
+		   size_t(0), size_t(0), std::declval<const typename T::Model&>(),
+		   static_cast<typename T::Real*>(nullptr))))> : std::true_type
+{
+};
+
+template <class TModelFit>
+inline void test_samples(
+	const TModelFit& fit, const size_t first, const size_t count,
+	const typename TModelFit::Model& model, typename TModelFit::Real* out,
+	std::true_type)
+{
+	fit.testSamples(first, count, model, out);
+}
+template <class TModelFit>
+inline void test_samples(
+	const TModelFit& fit, const size_t first, const size_t count,
+	const typename TModelFit::Model& model, typename TModelFit::Real* out,
+	std::false_type)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = fit.testSample(first + i, model);
+}
+
+/** Scores the samples [first,first+count) with a model, with testSamples()
+ * if available */
+template <class TModelFit>
+inline void test_samples(
+	const TModelFit& fit, const size_t first, const size_t count,
+	const typename TModelFit::Model& model, typename TModelFit::Real* out)
+{
+	test_samples(fit, first, count, model, out, has_testSamples<TModelFit>());
+}
+
+/** Counts the samples with a fitness below \a threshold. \a buf must have
+ * room for MODEL_SEARCH_BLOCK values.
+  * \return false if the count was abandoned because the number of outliers
+ * reached \a max_outliers.
+  */
+template <class TModelFit>
+bool count_inliers(
+	const TModelFit& fit, const typename TModelFit::Model& model,
+	const typename TModelFit::Real threshold, const size_t max_outliers,
+	typename TModelFit::Real* buf, size_t& inliers)
+{
+	const size_t N = fit.getSampleCount();
+	inliers = 0;
+	for (size_t first = 0; first < N; first += MODEL_SEARCH_BLOCK)
+	{
+		const size_t count = std::min(MODEL_SEARCH_BLOCK, N - first);
+		test_samples(fit, first, count, model, buf);
+		for (size_t i = 0; i < count; i++) inliers += (buf[i] < threshold);
+		if (first + count - inliers >= max_outliers) return false;
+	}
+	return true;
+}
+
+/** Fills \a inliers with the indices of the samples with a fitness below
+ * \a threshold */
+template <class TModelFit>
+void find_inliers(
+	const TModelFit& fit, const typename TModelFit::Model& model,
+	const typename TModelFit::Real threshold, vector_size_t& inliers)
+{
+	const size_t N = fit.getSampleCount();
+	typename TModelFit::Real buf[MODEL_SEARCH_BLOCK];
+	inliers.clear();
+	for (size_t first = 0; first < N; first += MODEL_SEARCH_BLOCK)
+	{
+		const size_t count = std::min(MODEL_SEARCH_BLOCK, N - first);
+		test_samples(fit, first, count, model, buf);
+		for (size_t i = 0; i < count; i++)
+			if (buf[i] < threshold) inliers.push_back(first + i);
+	}
+}
+
+/** A small and fast random generator (splitmix64). Each hypothesis of
+ * ModelSearch::ransacParallel() has its own one, so samples do not depend on
+ * the order in which threads run. */
+struct TModelSearchRandom
+{
+	uint64_t state;
+	explicit TModelSearchRandom(const uint64_t seed) : state(seed) {}
+	uint64_t operator()()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+	/** Fills ind[first..] with different indices in [0,n), also different
+	 * from ind[0..first) */
+	void pickIndices(vector_size_t& ind, const size_t first, const size_t n)
+	{
+		for (size_t i = first; i < ind.size(); i++)
+		{
+			size_t c;
+			do
+				c = static_cast<size_t>((*this)() % n);
+			while (std::find(ind.begin(), ind.begin() + i, c) !=
+				   ind.begin() + i);
+			ind[i] = c;
+		}
+	}
+};
+}  // end NS detail
+
 //----------------------------------------------------------------------
 //! Run the ransac algorithm searching for a single model
 template <typename TModelFit>
@@ -35,6 +161,7 @@ bool ModelSearch::ransacSingleModel(
 	p_inliers.clear();
 	size_t nSamples = p_state.getSampleCount();
 	vector_size_t ind(p_kernelSize);
+	typename TModelFit::Real buf[detail::MODEL_SEARCH_BLOCK];
 
 	while (iter < softIterLimit && iter < hardIterLimit)
 	{
@@ -49,17 +176,13 @@ bool ModelSearch::ransacSingleModel(
 			if (i > 100) return false;
 		}
 
-		vector_size_t inliers;
-
-		for (size_t i = 0; i < nSamples; i++)
-		{
-			if (p_state.testSample(i, currentModel) < p_fitnessThreshold)
-				inliers.push_back(i);
-		}
-		ASSERT_(inliers.size() > 0);
-
-		// Find the number of inliers to this model.
-		const size_t ninliers = inliers.size();
+		// Find the number of inliers to this model (their list is only built
+		// for the best one, at the end):
+		size_t ninliers;
+		detail::count_inliers(
+			p_state, currentModel, p_fitnessThreshold,
+			std::numeric_limits<size_t>::max(), buf, ninliers);
+		ASSERT_(ninliers > 0);
 		bool update_estim_num_iters =
 			(iter == 0);  // Always update on the first iteration, regardless of
 		// the result (even for ninliers=0)
@@ -69,7 +192,6 @@ bool ModelSearch::ransacSingleModel(
 		{
 			bestScore = ninliers;
 			p_bestModel = currentModel;
-			p_inliers = inliers;
 			update_estim_num_iters = true;
 		}
 
@@ -88,9 +210,161 @@ bool ModelSearch::ransacSingleModel(
 		iter++;
 	}
 
+	detail::find_inliers(p_state, p_bestModel, p_fitnessThreshold, p_inliers);
 	return true;
 }
 
+//----------------------------------------------------------------------
+//! Run the ransac algorithm, evaluating hypotheses in parallel
+template <typename TModelFit>
+bool ModelSearch::ransacParallel(
+	const TModelFit& p_state, size_t p_kernelSize,
+	const typename TModelFit::Real& p_fitnessThreshold,
+	typename TModelFit::Model& p_bestModel, vector_size_t& p_inliers,
+	TStats* p_stats) const
+{
+	MRPT_START
+
+	typedef typename TModelFit::Real Real;
+	typedef typename TModelFit::Model Model;
+
+	// Hypotheses are drawn and scored by rounds of ROUND_SIZE, in jobs of
+	// JOB_SIZE hypotheses each, then compared in order: results only depend
+	// on the seed, not on the number of threads.
+	const size_t ROUND_SIZE = 64, JOB_SIZE = 8;
+	const size_t NUM_JOBS = ROUND_SIZE / JOB_SIZE;
+	const size_t MAX_DEGENERATE_TRIES = 100;
+
+	const size_t N = p_state.getSampleCount();
+	const size_t m = p_kernelSize;
+	ASSERT_(m > 0 && N >= m);
+	ASSERT_(options.prob_good_sample > 0 && options.prob_good_sample < 1);
+	ASSERT_(options.max_iterations > 0);
+
+	TStats stats;
+	p_inliers.clear();
+
+	// Sample subset size of each hypothesis in the round (PROSAC), N for
+	// uniform sampling:
+	std::vector<size_t> subset(ROUND_SIZE, N);
+	size_t prosac_n = m;
+	double prosac_Tn = static_cast<double>(options.max_iterations);
+	double prosac_Tn_prime = 1;
+	if (options.prosac)
+		for (size_t i = 0; i < m; i++)
+			prosac_Tn *= (m - i) / static_cast<double>(N - i);
+
+	// Everything is allocated once:
+	std::vector<vector_size_t> inds(ROUND_SIZE, vector_size_t(m));
+	std::vector<Model> models(ROUND_SIZE);
+	std::vector<size_t> scores(ROUND_SIZE);
+	std::vector<char> states(ROUND_SIZE);  // 0:ok, 1:degenerate, 2:bailout
+	std::vector<Real> bufs(NUM_JOBS * detail::MODEL_SEARCH_BLOCK);
+
+	size_t best_score = 0, iter = 0, iter_limit = options.max_iterations;
+	while (iter < iter_limit)
+	{
+		const size_t round_size = std::min(ROUND_SIZE, iter_limit - iter);
+		for (size_t k = 0; k < round_size; k++)
+		{
+			if (options.prosac && prosac_n < N &&
+				static_cast<double>(iter + k + 1) >= prosac_Tn_prime)
+			{
+				// Grow the subset of samples to draw hypotheses from:
+				const double Tn_next = prosac_Tn * (prosac_n + 1) /
+									   static_cast<double>(prosac_n + 1 - m);
+				prosac_Tn_prime += std::ceil(Tn_next - prosac_Tn);
+				prosac_Tn = Tn_next;
+				prosac_n++;
+			}
+			subset[k] = options.prosac ? prosac_n : N;
+		}
+		const size_t max_outliers = N - best_score;
+
+		mrpt::utils::parallel_for_jobs(
+			(round_size + JOB_SIZE - 1) / JOB_SIZE, options.num_threads,
+			[&](const size_t job) {
+				Real* buf = &bufs[job * detail::MODEL_SEARCH_BLOCK];
+				const size_t k1 = std::min(round_size, (job + 1) * JOB_SIZE);
+				for (size_t k = job * JOB_SIZE; k < k1; k++)
+				{
+					detail::TModelSearchRandom rnd(
+						options.seed ^
+						((iter + k + 1) * 0xD1B54A32D192ED03ULL));
+					vector_size_t& ind = inds[k];
+					bool ok = false;
+					for (size_t t = 0; t < MAX_DEGENERATE_TRIES && !ok; t++)
+					{
+						if (subset[k] < N)
+						{
+							// PROSAC: the newest sample of the subset, plus
+							// random ones from the rest of it.
+							ind[0] = subset[k] - 1;
+							rnd.pickIndices(ind, 1, subset[k] - 1);
+						}
+						else
+							rnd.pickIndices(ind, 0, N);
+						ok = p_state.fitModel(ind, models[k]);
+					}
+					if (!ok)
+					{
+						states[k] = 1;
+						continue;
+					}
+					states[k] = detail::count_inliers(
+									p_state, models[k], p_fitnessThreshold,
+									max_outliers, buf, scores[k])
+									? 0
+									: 2;
+				}
+			});
+
+		// Reduce in order:
+		for (size_t k = 0; k < round_size; k++)
+		{
+			stats.num_hypotheses++;
+			if (states[k] == 1)
+				stats.num_degenerate++;
+			else if (states[k] == 2)
+				stats.num_bailouts++;
+			else if (scores[k] > best_score)
+			{
+				best_score = scores[k];
+				p_bestModel = models[k];
+			}
+		}
+		iter += round_size;
+
+		if (options.early_exit_inliers != 0 &&
+			best_score >= options.early_exit_inliers)
+			break;
+
+		if (best_score > 0)
+		{
+			// Number of hypotheses needed to draw an outlier-free sample
+			// with probability prob_good_sample:
+			const double w = best_score / static_cast<double>(N);
+			const double pw = std::pow(w, static_cast<double>(m));
+			const double eps = std::numeric_limits<double>::epsilon();
+			const double needed =
+				pw >= 1 - eps ? 0.0
+							  : std::ceil(
+									std::log(1 - options.prob_good_sample) /
+									std::log(1 - std::max(pw, eps)));
+			iter_limit = static_cast<size_t>(
+				std::min(needed, static_cast<double>(options.max_iterations)));
+		}
+	}
+
+	if (p_stats) *p_stats = stats;
+	if (best_score == 0) return false;
+
+	detail::find_inliers(p_state, p_bestModel, p_fitnessThreshold, p_inliers);
+	return true;
+
+	MRPT_END
+}
+
 //----------------------------------------------------------------------
 //! Run a generic programming version of ransac searching for a single model
 template <typename TModelFit>
@@ -147,8 +421,8 @@ bool ModelSearch::geneticSingleModel(
 				// pick two parents, from the species not yet refactored
 				// better elders has more chance to mate as they are removed
 				// later from the list
-				int r1 = rand();
-				int r2 = rand();
+				int r1 = mrpt::random::randomGenerator.drawUniform32bit() >> 1;
+				int r2 = mrpt::random::randomGenerator.drawUniform32bit() >> 1;
 				int p1 = r1 % se;
 				int p2 =
 					(p1 > se / 2) ? (r2 % p1) : p1 + 1 + (r2 % (se - p1 - 1));
@@ -163,7 +437,9 @@ bool ModelSearch::geneticSingleModel(
 				sampleSet.insert(b->sample.begin(), b->sample.end());
 				// mutate - add a random sample that will be selected with some
 				// (non-zero) probability
-				sampleSet.insert(rand() % sampleCount);
+				sampleSet.insert(
+					mrpt::random::randomGenerator.drawUniform32bit() %
+					sampleCount);
 				pickRandomIndex(sampleSet, p_kernelSize, sibling->sample);
 			}
 
@@ -182,6 +458,7 @@ bool ModelSearch::geneticSingleModel(
 			 it != population.end(); it++)
 		{
 			Species& s = **it;
+			s.inliers.clear();
 			if (p_state.fitModel(s.sample, s.model))
 			{
 				s.fitness = 0;
@@ -30,7 +30,10 @@ template <typename NUMTYPE = double>
 class BASE_IMPEXP RANSAC_Template : public mrpt::utils::COutputLogger
 {
    public:
-	RANSAC_Template() : mrpt::utils::COutputLogger("RANSAC_Template") {}
+	RANSAC_Template()
+		: mrpt::utils::COutputLogger("RANSAC_Template"), m_num_threads(1)
+	{
+	}
 	/** The type of the function passed to mrpt::math::ransac - See the
 	 * documentation for that method for more info. */
 	typedef void (*TRansacFitFunctor)(
@@ -64,6 +67,9 @@ class BASE_IMPEXP RANSAC_Template : public mrpt::utils::COutputLogger
 	  * \return false if no good solution can be found, true on success.
 	  * \note [MRPT 1.5.0] `verbose` parameter has been removed, supersedded by
 	 * COutputLogger settings.
+	  * \note Hypotheses are drawn and evaluated in rounds, in parallel if
+	 * setNumThreads() was called with a value other than 1. The result does
+	 * not depend on the number of threads.
 	  */
 	bool execute(
 		const CMatrixTemplateNumeric<NUMTYPE>& data, TRansacFitFunctor fit_func,
@@ -75,6 +81,18 @@ class BASE_IMPEXP RANSAC_Template : public mrpt::utils::COutputLogger
 		const double prob_good_sample = 0.999,
 		const size_t maxIter = 2000) const;
 
+	/** Number of threads to evaluate hypotheses in execute() (0: as many as
+	 * cores). The default is 1, since the fit, distance and degenerate
+	 * functions must be thread-safe for any other value. */
+	void setNumThreads(unsigned int num_threads)
+	{
+		m_num_threads = num_threads;
+	}
+	unsigned int getNumThreads() const { return m_num_threads; }
+
+   private:
+	unsigned int m_num_threads;
+
 };  // end class
 
 /** The default instance of RANSAC, for double type */
@@ -0,0 +1,65 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef CMemoryMappedFile_H
+#define CMemoryMappedFile_H
+
+#include <mrpt/base/link_pragmas.h>
+#include <cstddef>
+#include <string>
+
+namespace mrpt
+{
+namespace utils
+{
+/** Read-only view of the whole contents of a file, mapped into memory by the
+ * operating system (mmap() or MapViewOfFile()). Pages are read from disk on
+ * demand, so very large files can be parsed without copying them into
+ * buffers or streams.
+ *
+ * \sa CFileInputStream
+ * \ingroup mrpt_base_grp
+ */
+class BASE_IMPEXP CMemoryMappedFile
+{
+   public:
+	/** Default constructor */
+	CMemoryMappedFile();
+	/** Constructor, which maps the given file.
+	 * \exception std::exception On error opening or mapping the file.
+	 */
+	CMemoryMappedFile(const std::string& fileName);
+	CMemoryMappedFile(const CMemoryMappedFile&) = delete;
+	CMemoryMappedFile& operator=(const CMemoryMappedFile&) = delete;
+	~CMemoryMappedFile();
+
+	/** Maps a file, closing the previous one (if any).
+	 * \exception std::exception On error opening or mapping the file.
+	 */
+	void open(const std::string& fileName);
+	/** Unmaps the file. Pointers returned by data() become invalid. */
+	void close();
+	bool is_open() const { return m_is_open; }
+	/** The contents of the file. Can be nullptr for empty files. */
+	const char* data() const { return m_data; }
+	/** Size of the file, in bytes */
+	size_t size() const { return m_size; }
+	const char* begin() const { return m_data; }
+	const char* end() const { return m_data + m_size; }
+
+   private:
+	const char* m_data;
+	size_t m_size;
+	bool m_is_open;
+	/** OS handles of the file and the mapping (Windows only) */
+	void *m_file_handle, *m_map_handle;
+};
+
+}  // End of namespace
+}  // end of namespace
+#endif
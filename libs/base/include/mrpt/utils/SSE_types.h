@@ -37,4 +37,9 @@ extern "C" {
 #endif
 #endif
 
+// AVX2 types:
+#if MRPT_HAS_AVX2
+#include <immintrin.h>
+#endif
+
 #endif
@@ -0,0 +1,119 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace mrpt
+{
+namespace utils
+{
+/** \addtogroup mrpt_parallel Simple fork-join parallel loops (in #include
+ * <mrpt/utils/parallel.h>)
+  *  \ingroup mrpt_base_grp
+  *
+  * The loops below start their threads on each call (there is no pool), run
+  * one share of the work in the calling thread and return when all the
+  * threads are done. Exceptions thrown by the loop body in any thread are
+  * rethrown in the calling thread. In all of them, `num_threads=0` means
+  * "as many threads as cores".
+  * @{ */
+
+/** Returns \a num_threads, or the number of cores if it is 0 (at least 1) */
+inline unsigned int parallel_num_threads(const unsigned int num_threads)
+{
+	return num_threads != 0
+			   ? num_threads
+			   : std::max(1U, std::thread::hardware_concurrency());
+}
+
+/** Splits the items [0,num_items) into one contiguous range per thread, and
+ * runs `func(thread_index, first, last)` for each range [first,last). Range
+ * boundaries only depend on \a num_items and the number of threads.
+  * \param min_items_per_thread Fewer threads are used if needed so that each
+ * one gets at least this many items.
+  */
+template <class FUNCTOR>
+void parallel_for_ranges(
+	const size_t num_items, size_t num_threads, FUNCTOR func,
+	const size_t min_items_per_thread = 1)
+{
+	const size_t max_threads =
+		num_items / std::max<size_t>(1, min_items_per_thread);
+	num_threads = std::min<size_t>(
+		parallel_num_threads(static_cast<unsigned int>(num_threads)),
+		std::max<size_t>(1, max_threads));
+	if (num_threads <= 1)
+	{
+		func(size_t(0), size_t(0), num_items);
+		return;
+	}
+	std::vector<std::exception_ptr> errors(num_threads);
+	auto worker = [&](const size_t t) {
+		try
+		{
+			func(
+				t, num_items * t / num_threads,
+				num_items * (t + 1) / num_threads);
+		}
+		catch (...)
+		{
+			errors[t] = std::current_exception();
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (size_t t = 1; t < num_threads; t++) threads.emplace_back(worker, t);
+	worker(0);
+	for (auto& th : threads) th.join();
+	for (auto& e : errors)
+		if (e) std::rethrow_exception(e);
+}
+
+/** Runs `func(job)` for all the jobs [0,num_jobs), with each thread taking
+ * the next pending job when it finishes the previous one (for jobs of
+ * uneven cost). */
+template <class FUNCTOR>
+void parallel_for_jobs(
+	const size_t num_jobs, size_t num_threads, FUNCTOR func)
+{
+	num_threads = std::min<size_t>(
+		parallel_num_threads(static_cast<unsigned int>(num_threads)),
+		std::max<size_t>(1, num_jobs));
+	std::atomic<size_t> next_job(0);
+	std::vector<std::exception_ptr> errors(num_threads);
+	auto worker = [&](const size_t t) {
+		try
+		{
+			for (size_t job = next_job++; job < num_jobs; job = next_job++)
+				func(job);
+		}
+		catch (...)
+		{
+			errors[t] = std::current_exception();
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (size_t t = 1; t < num_threads; t++) threads.emplace_back(worker, t);
+	worker(0);
+	for (auto& th : threads) th.join();
+	for (auto& e : errors)
+		if (e) std::rethrow_exception(e);
+}
+
+/** @} */
+}  // End of namespace
+}  // end of namespace
@@ -0,0 +1,103 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/math/CSparseBlockCholesky.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::math;
+using namespace std;
+
+// Solves a random block-sparse SPD system and compares against a dense LLT.
+template <int B>
+void run_block_chol_test(const size_t nBlocks, const size_t nLoops)
+{
+	auto& rnd = mrpt::random::randomGenerator;
+	rnd.randomize(123);
+
+	// Pose-graph like pattern: odometry chain + random loop closures.
+	std::vector<std::pair<size_t, size_t>> lower;
+	for (size_t i = 1; i < nBlocks; i++) lower.emplace_back(i, i - 1);
+	for (size_t k = 0; k < nLoops; k++)
+	{
+		const size_t a = rnd.drawUniform32bit() % nBlocks,
+					 b = rnd.drawUniform32bit() % nBlocks;
+		if (a != b) lower.emplace_back(std::max(a, b), std::min(a, b));
+	}
+	lower.push_back(lower.front());  // Repeated entries are allowed
+
+	CSparseBlockCholesky<B> chol;
+	std::vector<size_t> idxs;
+	chol.setPattern(nBlocks, lower, idxs);
+	ASSERT_EQ(idxs.size(), lower.size());
+	EXPECT_EQ(idxs.front(), idxs.back());
+	EXPECT_GE(chol.getFactorSize(), chol.getPatternSize());
+
+	Eigen::MatrixXd D = Eigen::MatrixXd::Zero(nBlocks * B, nBlocks * B);
+	chol.setZero();
+	for (size_t k = 0; k < lower.size(); k++)
+	{
+		Eigen::Matrix<double, B, B> blk;
+		for (int r = 0; r < B; r++)
+			for (int c = 0; c < B; c++) blk(r, c) = rnd.drawGaussian1D(0, 1);
+		const size_t i = lower[k].first, j = lower[k].second;
+		chol.entry(idxs[k]) += blk;
+		D.block<B, B>(i * B, j * B) += blk;
+		D.block<B, B>(j * B, i * B) += blk.transpose();
+	}
+	// Make it diagonally dominant:
+	for (size_t i = 0; i < nBlocks; i++)
+	{
+		const double diag = 10.0 * B * (1 + D.block(i * B, 0, B, D.cols())
+												.cwiseAbs()
+												.rowwise()
+												.sum()
+												.maxCoeff());
+		Eigen::Matrix<double, B, B> blk =
+			Eigen::Matrix<double, B, B>::Identity() * diag;
+		if (B > 1) blk(0, B - 1) = blk(B - 1, 0) = 0.5;
+		chol.entry(i) = blk;
+		D.block<B, B>(i * B, i * B) = blk;
+	}
+
+	Eigen::VectorXd b(nBlocks * B), x;
+	for (int i = 0; i < b.size(); i++) b[i] = rnd.drawGaussian1D(0, 1);
+
+	const double lambda = 0.1;
+	chol.factorize(lambda);
+	chol.solve(b, x);
+
+	D.diagonal().array() += lambda;
+	const Eigen::VectorXd x_gt = D.llt().solve(b);
+	ASSERT_EQ(x.size(), x_gt.size());
+	EXPECT_LT((x - x_gt).norm(), 1e-9 * (1 + x_gt.norm()));
+
+	// Refactor with new values, reusing the symbolic analysis:
+	chol.factorize(0);
+	chol.solve(b, x);
+	D.diagonal().array() -= lambda;
+	EXPECT_LT(
+		(x - D.llt().solve(b)).norm(), 1e-9 * (1 + x_gt.norm()));
+}
+
+TEST(CSparseBlockCholesky, solve_1x1_blocks) { run_block_chol_test<1>(60, 30); }
+TEST(CSparseBlockCholesky, solve_3x3_blocks) { run_block_chol_test<3>(100, 40); }
+TEST(CSparseBlockCholesky, solve_6x6_blocks) { run_block_chol_test<6>(50, 20); }
+TEST(CSparseBlockCholesky, not_positive_definite)
+{
+	CSparseBlockCholesky<2> chol;
+	std::vector<size_t> idxs;
+	chol.setPattern(2, {{1, 0}}, idxs);
+	chol.setZero();
+	chol.entry(0) = -Eigen::Matrix2d::Identity();
+	chol.entry(1) = Eigen::Matrix2d::Identity();
+	EXPECT_THROW(chol.factorize(), CExceptionNotDefPos);
+	EXPECT_NO_THROW(chol.factorize(2.0));
+}
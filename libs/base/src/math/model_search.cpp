@@ -10,9 +10,26 @@
 #include "base-precomp.h"  // Precompiled headers
 
 #include <mrpt/math/model_search.h>
+#include <mrpt/random.h>
 
 using namespace mrpt;
 using namespace mrpt::math;
+using mrpt::random::randomGenerator;
+
+namespace
+{
+/** Moves \a p_pick random items to the front of \a items (a partial
+ * Fisher-Yates shuffle with randomGenerator), and returns them in \a p_ind */
+void pickRandomItems(
+	vector_size_t& items, const size_t p_pick, vector_size_t& p_ind)
+{
+	const size_t n = items.size();
+	for (size_t i = 0; i < p_pick; i++)
+		std::swap(
+			items[i], items[i + randomGenerator.drawUniform32bit() % (n - i)]);
+	p_ind.assign(items.begin(), items.begin() + p_pick);
+}
+}  // namespace
 
 //----------------------------------------------------------------------
 //! Select random (unique) indices from the 0..p_size sequence
@@ -21,12 +38,26 @@ void ModelSearch::pickRandomIndex(
 {
 	ASSERT_(p_size >= p_pick);
 
+	if (2 * p_pick <= p_size)
+	{
+		// Usual case (few indices out of many): draw them one by one,
+		// discarding repetitions, without an O(p_size) permutation.
+		p_ind.resize(p_pick);
+		for (size_t i = 0; i < p_pick; i++)
+		{
+			size_t c;
+			do
+				c = randomGenerator.drawUniform32bit() % p_size;
+			while (std::find(p_ind.begin(), p_ind.begin() + i, c) !=
+				   p_ind.begin() + i);
+			p_ind[i] = c;
+		}
+		return;
+	}
+
 	vector_size_t a(p_size);
 	for (size_t i = 0; i < p_size; i++) a[i] = i;
-
-	std::random_shuffle(a.begin(), a.end());
-	p_ind.resize(p_pick);
-	for (size_t i = 0; i < p_pick; i++) p_ind[i] = a[i];
+	pickRandomItems(a, p_pick, p_ind);
 }
 
 //----------------------------------------------------------------------
@@ -35,10 +66,7 @@ void ModelSearch::pickRandomIndex(
 void ModelSearch::pickRandomIndex(
 	std::set<size_t> p_set, size_t p_pick, vector_size_t& p_ind)
 {
-	p_ind.resize(p_pick);
+	ASSERT_(p_set.size() >= p_pick);
 	vector_size_t inds(p_set.begin(), p_set.end());
-
-	std::random_shuffle(inds.begin(), inds.end());
-	p_ind.resize(p_pick);
-	for (size_t i = 0; i < p_pick; i++) p_ind[i] = inds[i];
+	pickRandomItems(inds, p_pick, p_ind);
 }
@@ -0,0 +1,249 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/math/model_search.h>
+#include <mrpt/math/ransac.h>
+#include <mrpt/math/ransac_applications.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+namespace
+{
+// The plane x - y + z = 2
+const double PLANE_EQ[4] = {1, -1, 1, -2};
+
+struct Fit3DPlane
+{
+	typedef TPlane3D Model;
+	typedef double Real;
+
+	const std::vector<TPoint3D>& allData;
+
+	Fit3DPlane(const std::vector<TPoint3D>& _allData) : allData(_allData) {}
+	size_t getSampleCount(void) const { return allData.size(); }
+	bool fitModel(const vector_size_t& useIndices, TPlane3D& model) const
+	{
+		try
+		{
+			model = TPlane(
+				allData[useIndices[0]], allData[useIndices[1]],
+				allData[useIndices[2]]);
+		}
+		catch (exception&)
+		{
+			return false;
+		}
+		return true;
+	}
+	double testSample(size_t index, const TPlane3D& model) const
+	{
+		return model.distance(allData[index]);
+	}
+};
+
+// Points of the plane, the first n_outliers of them moved away from it
+std::vector<TPoint3D> generatePoints(
+	const size_t n_points, const size_t n_outliers)
+{
+	CRandomGenerator rnd(123);
+	std::vector<TPoint3D> data;
+	for (size_t i = 0; i < n_points; i++)
+	{
+		const double x = rnd.drawUniform(-3, 3), y = rnd.drawUniform(-3, 3);
+		const double z =
+			-(PLANE_EQ[3] + PLANE_EQ[0] * x + PLANE_EQ[1] * y) / PLANE_EQ[2];
+		data.push_back(TPoint3D(x, y, z));
+	}
+	for (size_t i = 0; i < n_outliers; i++)
+	{
+		// Move them along the normal of the plane:
+		const double d = rnd.drawUniform(0.1, 3);
+		data[i] += TPoint3D(d, -d, d);
+	}
+	return data;
+}
+
+// RANSAC_Template functions for planes, with points as the columns of data
+void planeFit(
+	const CMatrixDouble& data, const vector_size_t& useIndices,
+	std::vector<CMatrixDouble>& fitModels)
+{
+	fitModels.clear();
+	try
+	{
+		TPoint3D p[3];
+		for (int i = 0; i < 3; i++)
+			p[i] = TPoint3D(
+				data(0, useIndices[i]), data(1, useIndices[i]),
+				data(2, useIndices[i]));
+		const TPlane plane(p[0], p[1], p[2]);
+		fitModels.resize(1);
+		fitModels[0].setSize(1, 4);
+		for (int i = 0; i < 4; i++) fitModels[0](0, i) = plane.coefs[i];
+	}
+	catch (exception&)
+	{
+	}
+}
+
+void planeDistance(
+	const CMatrixDouble& data, const std::vector<CMatrixDouble>& testModels,
+	const double distanceThreshold, unsigned int& out_bestModelIndex,
+	vector_size_t& out_inlierIndices)
+{
+	out_bestModelIndex = 0;
+	TPlane plane;
+	for (int i = 0; i < 4; i++) plane.coefs[i] = testModels[0](0, i);
+	out_inlierIndices.clear();
+	for (size_t i = 0; i < size(data, 2); i++)
+		if (plane.distance(TPoint3D(data(0, i), data(1, i), data(2, i))) <
+			distanceThreshold)
+			out_inlierIndices.push_back(i);
+}
+
+bool planeDegenerate(const CMatrixDouble&, const vector_size_t&)
+{
+	return false;
+}
+
+void checkPlane(const TPlane& plane)
+{
+	TPlane p = plane;
+	p.unitarize();
+	const double s = (p.coefs[0] > 0 ? 1 : -1) / std::sqrt(3.0);
+	for (int i = 0; i < 4; i++) EXPECT_NEAR(p.coefs[i], PLANE_EQ[i] * s, 1e-6);
+}
+}  // namespace
+
+TEST(ModelSearch, ransacParallel)
+{
+	const std::vector<TPoint3D> data = generatePoints(2000, 1200);
+	const Fit3DPlane fit(data);
+
+	ModelSearch search;
+	TPlane3D model1;
+	vector_size_t inliers1;
+	ModelSearch::TStats stats;
+	search.options.num_threads = 1;
+	EXPECT_TRUE(search.ransacParallel(fit, 3, 0.01, model1, inliers1, &stats));
+	checkPlane(model1);
+	ASSERT_EQ(inliers1.size(), 800u);
+	EXPECT_EQ(inliers1.front(), 1200u);
+	EXPECT_LE(stats.num_hypotheses, search.options.max_iterations);
+	EXPECT_GT(stats.num_bailouts, 0u);
+
+	// The result does not depend on the number of threads:
+	for (unsigned int num_threads = 2; num_threads <= 4; num_threads++)
+	{
+		TPlane3D model2;
+		vector_size_t inliers2;
+		ModelSearch::TStats stats2;
+		search.options.num_threads = num_threads;
+		EXPECT_TRUE(
+			search.ransacParallel(fit, 3, 0.01, model2, inliers2, &stats2));
+		EXPECT_EQ(inliers1, inliers2);
+		EXPECT_EQ(stats.num_hypotheses, stats2.num_hypotheses);
+		for (int i = 0; i < 4; i++)
+			EXPECT_EQ(model1.coefs[i], model2.coefs[i]);
+	}
+}
+
+TEST(ModelSearch, RANSAC_TemplateThreads)
+{
+	const std::vector<TPoint3D> data = generatePoints(1000, 600);
+	CMatrixDouble M(3, data.size());
+	for (size_t i = 0; i < data.size(); i++)
+		M(0, i) = data[i].x, M(1, i) = data[i].y, M(2, i) = data[i].z;
+
+	vector_size_t inliers[2];
+	CMatrixDouble models[2];
+	for (int k = 0; k < 2; k++)
+	{
+		RANSAC ransac;
+		ransac.setVerbosityLevel(mrpt::utils::LVL_ERROR);
+		ransac.setNumThreads(k == 0 ? 1 : 4);
+		randomGenerator.randomize(456);
+		EXPECT_TRUE(
+			ransac.execute(
+				M, planeFit, planeDistance, planeDegenerate, 0.01, 3,
+				inliers[k], models[k]));
+	}
+	EXPECT_EQ(inliers[0].size(), 400u);
+	EXPECT_EQ(inliers[0], inliers[1]);
+	EXPECT_TRUE(models[0] == models[1]);
+}
+
+TEST(ModelSearch, ransacParallelPROSAC)
+{
+	// Most outliers, sorted with the inliers first (as if by quality):
+	std::vector<TPoint3D> data = generatePoints(2000, 1800);
+	std::reverse(data.begin(), data.end());
+	const Fit3DPlane fit(data);
+
+	// Stop when enough inliers are found:
+	ModelSearch search;
+	search.options.early_exit_inliers = 150;
+	TPlane3D model;
+	vector_size_t inliers;
+	ModelSearch::TStats stats_uniform, stats_prosac;
+	EXPECT_TRUE(
+		search.ransacParallel(fit, 3, 0.01, model, inliers, &stats_uniform));
+	checkPlane(model);
+	EXPECT_EQ(inliers.size(), 200u);
+
+	// The first hypotheses are drawn from the inliers:
+	search.options.prosac = true;
+	EXPECT_TRUE(
+		search.ransacParallel(fit, 3, 0.01, model, inliers, &stats_prosac));
+	checkPlane(model);
+	EXPECT_EQ(inliers.size(), 200u);
+	EXPECT_LT(stats_prosac.num_hypotheses, stats_uniform.num_hypotheses);
+	EXPECT_LE(stats_prosac.num_hypotheses, 64u);
+}
+
+TEST(ModelSearch, ransac_detect_3D_planes)
+{
+	// Two planes (z=0 and x=5) and random points:
+	CRandomGenerator rnd(321);
+	const size_t N = 3000;
+	Eigen::VectorXd x(N), y(N), z(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const double a = rnd.drawUniform(0, 4), b = rnd.drawUniform(0, 4);
+		switch (i % 3)
+		{
+			case 0:
+				x[i] = a, y[i] = b, z[i] = 0;
+				break;
+			case 1:
+				x[i] = 5, y[i] = a, z[i] = 1 + b;
+				break;
+			default:
+				x[i] = a, y[i] = b, z[i] = rnd.drawUniform(1, 4);
+		}
+	}
+
+	vector<pair<size_t, TPlane>> planes;
+	ransac_detect_3D_planes(x, y, z, planes, 0.01, 500);
+	ASSERT_EQ(planes.size(), 2u);
+	for (const auto& p : planes)
+	{
+		EXPECT_EQ(p.first, N / 3);
+		const bool is_z0 = std::abs(std::abs(p.second.coefs[2]) - 1) < 1e-6;
+		EXPECT_NEAR(
+			p.second.evaluatePoint(
+				is_z0 ? TPoint3D(1, 2, 0) : TPoint3D(5, 1, 2)),
+			0, 1e-6);
+	}
+}
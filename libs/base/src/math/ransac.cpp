@@ -11,6 +11,7 @@
 
 #include <mrpt/math/ransac.h>
 #include <mrpt/random.h>
+#include <mrpt/utils/parallel.h>
 
 using namespace mrpt;
 using namespace mrpt::utils;
@@ -18,6 +19,23 @@ using namespace mrpt::random;
 using namespace mrpt::math;
 using namespace std;
 
+namespace
+{
+/** Maximum number of hypotheses evaluated in one round */
+const size_t HYPOTHESES_PER_ROUND = 32;
+
+/** A hypothesis of one round */
+template <typename NUMTYPE>
+struct THypothesis
+{
+	uint32_t seed;
+	bool degenerate;
+	unsigned int bestModelIdx;
+	std::vector<CMatrixTemplateNumeric<NUMTYPE>> models;
+	mrpt::vector_size_t inliers;
+};
+}  // namespace
+
 /*---------------------------------------------------------------
 			ransac generic implementation
  ---------------------------------------------------------------*/
@@ -53,123 +71,142 @@ bool RANSAC_Template<NUMTYPE>::execute(
 	size_t bestscore = std::string::npos;  // npos will mean "none"
 	size_t N = 1;  // Dummy initialisation for number of trials.
 
-	vector_size_t ind(minimumSizeSamplesToFit);
+	// Hypotheses are evaluated by rounds (in parallel), each one with its own
+	// random generator whose seed is drawn sequentially, then accepted in
+	// order with the same logic than a sequential loop. Hypotheses beyond
+	// the estimated number of trials are discarded, so the result does not
+	// depend on the number of threads.
+	std::vector<THypothesis<NUMTYPE>> round(HYPOTHESES_PER_ROUND);
+	bool stop = false;
 
-	while (N > trialcount)
+	while (N > trialcount && !stop)
 	{
-		// Select at random s datapoints to form a trial model, M.
-		// In selecting these points we have to check that they are not in
-		// a degenerate configuration.
-		bool degenerate = true;
-		size_t count = 1;
-		std::vector<CMatrixTemplateNumeric<NUMTYPE>> MODELS;
-
-		while (degenerate)
+		const size_t round_size = std::min(
+			HYPOTHESES_PER_ROUND,
+			std::min(N - trialcount, maxIter + 1 - trialcount));
+		for (size_t k = 0; k < round_size; k++)
+			round[k].seed = randomGenerator.drawUniform32bit();
+
+		parallel_for_jobs(
+			round_size, m_num_threads,
+			[&](const size_t k) {
+				THypothesis<NUMTYPE>& h = round[k];
+				CRandomGenerator rnd(h.seed);
+				vector_size_t ind(minimumSizeSamplesToFit);
+
+				// Select at random s datapoints to form a trial model, M.
+				// In selecting these points we have to check that they are
+				// not in a degenerate configuration.
+				h.degenerate = true;
+				h.models.clear();
+				h.inliers.clear();
+				for (size_t count = 0;
+					 h.degenerate && count < maxDataTrials; count++)
+				{
+					// The +0.99... is due to the floor rounding afterwards
+					// when converting from random double samples to size_t
+					rnd.drawUniformVector(ind, 0.0, Npts - 1 + 0.999999);
+
+					// Test that these points are not a degenerate
+					// configuration.
+					h.degenerate = degen_func(data, ind);
+
+					if (!h.degenerate)
+					{
+						// Fit model to this random selection of data points.
+						// Note that M may represent a set of models that fit
+						// the data.
+						fit_func(data, ind, h.models);
+
+						// Depending on your problem it might be that the only
+						// way you can determine whether a data set is
+						// degenerate or not is to try to fit a model and see
+						// if it succeeds.  If it fails we reset degenerate to
+						// true.
+						h.degenerate = h.models.empty();
+					}
+				}
+
+				// Evaluate distances between points and model returning the
+				// indices of elements in x that are inliers.  Additionally, if
+				// M is a cell array of possible models 'distfn' will return
+				// the model that has the most inliers.
+				h.bestModelIdx = 1000;
+				if (!h.degenerate)
+				{
+					dist_func(
+						data, h.models, NUMTYPE(distanceThreshold),
+						h.bestModelIdx, h.inliers);
+					ASSERT_(h.bestModelIdx < h.models.size());
+				}
+			});
+
+		for (size_t k = 0; k < round_size && N > trialcount; k++)
 		{
-			// Generate s random indicies in the range 1..npts
-			ind.resize(minimumSizeSamplesToFit);
-
-			// The +0.99... is due to the floor rounding afterwards when
-			// converting from random double samples to size_t
-			randomGenerator.drawUniformVector(ind, 0.0, Npts - 1 + 0.999999);
+			THypothesis<NUMTYPE>& h = round[k];
+			if (h.degenerate)
+				MRPT_LOG_WARN("Unable to select a nondegenerate data set");
 
-			// Test that these points are not a degenerate configuration.
-			degenerate = degen_func(data, ind);
+			// Find the number of inliers to this model.
+			const size_t ninliers = h.inliers.size();
+			bool update_estim_num_iters =
+				(trialcount == 0);  // Always update on the first iteration,
+			// regardless of the result (even for
+			// ninliers=0)
 
-			if (!degenerate)
+			if (ninliers > bestscore ||
+				(bestscore == std::string::npos && ninliers != 0))
 			{
-				// Fit model to this random selection of data points.
-				// Note that M may represent a set of models that fit the data
-				fit_func(data, ind, MODELS);
-
-				// Depending on your problem it might be that the only way you
-				// can determine whether a data set is degenerate or not is to
-				// try to fit a model and see if it succeeds.  If it fails we
-				// reset degenerate to true.
-				degenerate = MODELS.empty();
+				bestscore = ninliers;  // Record data for this model
+
+				out_best_model = h.models[h.bestModelIdx];
+				out_best_inliers.swap(h.inliers);
+				update_estim_num_iters = true;
 			}
 
-			// Safeguard against being stuck in this loop forever
-			if (++count > maxDataTrials)
+			if (update_estim_num_iters)
 			{
-				MRPT_LOG_WARN("Unable to select a nondegenerate data set");
-				break;
+				// Update estimate of N, the number of trials to ensure we
+				// pick, with probability p, a data set with no outliers.
+				double fracinliers = ninliers / static_cast<double>(Npts);
+				double pNoOutliers =
+					1 -
+					pow(fracinliers,
+						static_cast<double>(minimumSizeSamplesToFit));
+
+				pNoOutliers = std::max(
+					std::numeric_limits<double>::epsilon(),
+					pNoOutliers);  // Avoid division by -Inf
+				pNoOutliers = std::min(
+					1.0 - std::numeric_limits<double>::epsilon(),
+					pNoOutliers);  // Avoid division by 0.
+				// Number of
+				N = static_cast<size_t>(log(1 - p) / log(pNoOutliers));
+				MRPT_LOG_DEBUG(
+					format(
+						"Iter #%u Estimated number of iters: %u  pNoOutliers "
+						"= %f  #inliers: %u\n",
+						(unsigned)trialcount, (unsigned)N, pNoOutliers,
+						(unsigned)ninliers));
 			}
-		}
-
-		// Once we are out here we should have some kind of model...
-		// Evaluate distances between points and model returning the indices
-		// of elements in x that are inliers.  Additionally, if M is a cell
-		// array of possible models 'distfn' will return the model that has
-		// the most inliers.  After this call M will be a non-cell objec
-		// representing only one model.
-		unsigned int bestModelIdx = 1000;
-		mrpt::vector_size_t inliers;
-		if (!degenerate)
-		{
-			dist_func(
-				data, MODELS, NUMTYPE(distanceThreshold), bestModelIdx,
-				inliers);
-			ASSERT_(bestModelIdx < MODELS.size());
-		}
 
-		// Find the number of inliers to this model.
-		const size_t ninliers = inliers.size();
-		bool update_estim_num_iters =
-			(trialcount == 0);  // Always update on the first iteration,
-		// regardless of the result (even for
-		// ninliers=0)
+			++trialcount;
 
-		if (ninliers > bestscore ||
-			(bestscore == std::string::npos && ninliers != 0))
-		{
-			bestscore = ninliers;  // Record data for this model
-
-			out_best_model = MODELS[bestModelIdx];
-			out_best_inliers = inliers;
-			update_estim_num_iters = true;
-		}
-
-		if (update_estim_num_iters)
-		{
-			// Update estimate of N, the number of trials to ensure we pick,
-			// with probability p, a data set with no outliers.
-			double fracinliers = ninliers / static_cast<double>(Npts);
-			double pNoOutliers =
-				1 -
-				pow(fracinliers, static_cast<double>(minimumSizeSamplesToFit));
-
-			pNoOutliers = std::max(
-				std::numeric_limits<double>::epsilon(),
-				pNoOutliers);  // Avoid division by -Inf
-			pNoOutliers = std::min(
-				1.0 - std::numeric_limits<double>::epsilon(),
-				pNoOutliers);  // Avoid division by 0.
-			// Number of
-			N = static_cast<size_t>(log(1 - p) / log(pNoOutliers));
 			MRPT_LOG_DEBUG(
 				format(
-					"Iter #%u Estimated number of iters: %u  pNoOutliers = %f  "
-					"#inliers: %u\n",
-					(unsigned)trialcount, (unsigned)N, pNoOutliers,
-					(unsigned)ninliers));
-		}
-
-		++trialcount;
+					"trial %u out of %u \r", (unsigned int)trialcount,
+					(unsigned int)ceil(static_cast<double>(N))));
 
-		MRPT_LOG_DEBUG(
-			format(
-				"trial %u out of %u \r", (unsigned int)trialcount,
-				(unsigned int)ceil(static_cast<double>(N))));
-
-		// Safeguard against being stuck in this loop forever
-		if (trialcount > maxIter)
-		{
-			MRPT_LOG_WARN(
-				format(
-					"Warning: maximum number of trials (%u) reached\n",
-					(unsigned)maxIter));
-			break;
+			// Safeguard against being stuck in this loop forever
+			if (trialcount > maxIter)
+			{
+				MRPT_LOG_WARN(
+					format(
+						"Warning: maximum number of trials (%u) reached\n",
+						(unsigned)maxIter));
+				stop = true;
+				break;
+			}
 		}
 	}
 
@@ -10,97 +10,134 @@
 #include "base-precomp.h"  // Precompiled headers
 
 #include <mrpt/math/ransac_applications.h>
+#include <mrpt/math/model_search.h>
 
 using namespace mrpt;
 using namespace mrpt::utils;
 using namespace mrpt::math;
 using namespace std;
 
-/*---------------------------------------------------------------
-		Aux. functions needed by ransac_detect_3D_planes
- ---------------------------------------------------------------*/
-namespace mrpt
-{
-namespace math
+namespace
 {
+/** Below this number of points, hypotheses are evaluated in the calling
+ * thread: launching threads would take longer than scoring them */
+const size_t MIN_POINTS_FOR_THREADS = 4096;
+
+/** Removes the elements with the given (sorted) indices from a vector */
 template <typename T>
-void ransac3Dplane_fit(
-	const CMatrixTemplateNumeric<T>& allData, const vector_size_t& useIndices,
-	vector<CMatrixTemplateNumeric<T>>& fitModels)
+void removeIndices(
+	Eigen::Matrix<T, Eigen::Dynamic, 1>& v, const vector_size_t& indices)
 {
-	ASSERT_(useIndices.size() == 3);
-
-	TPoint3D p1(
-		allData(0, useIndices[0]), allData(1, useIndices[0]),
-		allData(2, useIndices[0]));
-	TPoint3D p2(
-		allData(0, useIndices[1]), allData(1, useIndices[1]),
-		allData(2, useIndices[1]));
-	TPoint3D p3(
-		allData(0, useIndices[2]), allData(1, useIndices[2]),
-		allData(2, useIndices[2]));
-
-	try
-	{
-		TPlane plane(p1, p2, p3);
-		fitModels.resize(1);
-		CMatrixTemplateNumeric<T>& M = fitModels[0];
-
-		M.setSize(1, 4);
-		for (size_t i = 0; i < 4; i++) M(0, i) = T(plane.coefs[i]);
-	}
-	catch (exception&)
+	size_t j = 0, k = 0;
+	for (size_t i = 0; i < static_cast<size_t>(v.size()); i++)
 	{
-		fitModels.clear();
-		return;
+		if (k < indices.size() && indices[k] == i)
+			k++;
+		else
+			v[j++] = v[i];
 	}
+	v.conservativeResize(j);
 }
 
+/** The ModelSearch model of ransac_detect_3D_planes(). Points are kept in
+ * structure-of-arrays layout, so distances are computed by blocks with
+ * (vectorized) Eigen array expressions. */
 template <typename T>
-void ransac3Dplane_distance(
-	const CMatrixTemplateNumeric<T>& allData,
-	const vector<CMatrixTemplateNumeric<T>>& testModels,
-	const T distanceThreshold, unsigned int& out_bestModelIndex,
-	vector_size_t& out_inlierIndices)
+struct TPlaneFit
 {
-	ASSERT_(testModels.size() == 1)
-	out_bestModelIndex = 0;
-	const CMatrixTemplateNumeric<T>& M = testModels[0];
-
-	ASSERT_(size(M, 1) == 1 && size(M, 2) == 4)
-
-	TPlane plane;
-	plane.coefs[0] = M(0, 0);
-	plane.coefs[1] = M(0, 1);
-	plane.coefs[2] = M(0, 2);
-	plane.coefs[3] = M(0, 3);
-
-	const size_t N = size(allData, 2);
-	out_inlierIndices.clear();
-	out_inlierIndices.reserve(100);
-	for (size_t i = 0; i < N; i++)
+	typedef TPlane Model;
+	typedef T Real;
+	typedef Eigen::Matrix<T, Eigen::Dynamic, 1> Vector;
+	typedef Eigen::Array<T, Eigen::Dynamic, 1> Array;
+
+	const Vector &x, &y, &z;
+
+	TPlaneFit(const Vector& _x, const Vector& _y, const Vector& _z)
+		: x(_x), y(_y), z(_z)
 	{
-		const double d = plane.distance(
-			TPoint3D(
-				allData.get_unsafe(0, i), allData.get_unsafe(1, i),
-				allData.get_unsafe(2, i)));
-		if (d < distanceThreshold) out_inlierIndices.push_back(i);
 	}
-}
+	size_t getSampleCount() const { return x.size(); }
+	TPoint3D point(const size_t i) const { return TPoint3D(x[i], y[i], z[i]); }
+	bool fitModel(const vector_size_t& useIndices, TPlane& model) const
+	{
+		ASSERT_(useIndices.size() == 3);
+		try
+		{
+			model = TPlane(
+				point(useIndices[0]), point(useIndices[1]),
+				point(useIndices[2]));
+		}
+		catch (exception&)
+		{
+			return false;
+		}
+		return true;
+	}
+	T testSample(const size_t i, const TPlane& model) const
+	{
+		return T(model.distance(point(i)));
+	}
+	void testSamples(
+		const size_t first, const size_t count, const TPlane& model,
+		T* out) const
+	{
+		const double* c = model.coefs;
+		const T inv_norm =
+			T(1 / std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]));
+		Eigen::Map<Array>(out, count) =
+			(T(c[0]) * x.segment(first, count).array() +
+			 T(c[1]) * y.segment(first, count).array() +
+			 T(c[2]) * z.segment(first, count).array() + T(c[3]))
+				.abs() *
+			inv_norm;
+	}
+};
 
-/** Return "true" if the selected points are a degenerate (invalid) case.
-  */
+/** The ModelSearch model of ransac_detect_2D_lines() \sa TPlaneFit */
 template <typename T>
-bool ransac3Dplane_degenerate(
-	const CMatrixTemplateNumeric<T>& allData,
-	const mrpt::vector_size_t& useIndices)
+struct TLineFit
 {
-	MRPT_UNUSED_PARAM(allData);
-	MRPT_UNUSED_PARAM(useIndices);
-	return false;
-}
-}  // end namespace
-}  // end namespace
+	typedef TLine2D Model;
+	typedef T Real;
+	typedef Eigen::Matrix<T, Eigen::Dynamic, 1> Vector;
+	typedef Eigen::Array<T, Eigen::Dynamic, 1> Array;
+
+	const Vector &x, &y;
+
+	TLineFit(const Vector& _x, const Vector& _y) : x(_x), y(_y) {}
+	size_t getSampleCount() const { return x.size(); }
+	TPoint2D point(const size_t i) const { return TPoint2D(x[i], y[i]); }
+	bool fitModel(const vector_size_t& useIndices, TLine2D& model) const
+	{
+		ASSERT_(useIndices.size() == 2);
+		try
+		{
+			model = TLine2D(point(useIndices[0]), point(useIndices[1]));
+		}
+		catch (exception&)
+		{
+			return false;
+		}
+		return true;
+	}
+	T testSample(const size_t i, const TLine2D& model) const
+	{
+		return T(model.distance(point(i)));
+	}
+	void testSamples(
+		const size_t first, const size_t count, const TLine2D& model,
+		T* out) const
+	{
+		const double* c = model.coefs;
+		const T inv_norm = T(1 / std::sqrt(c[0] * c[0] + c[1] * c[1]));
+		Eigen::Map<Array>(out, count) =
+			(T(c[0]) * x.segment(first, count).array() +
+			 T(c[1]) * y.segment(first, count).array() + T(c[2]))
+				.abs() *
+			inv_norm;
+	}
+};
+}  // namespace
 
 /*---------------------------------------------------------------
 				ransac_detect_3D_planes
@@ -121,48 +158,40 @@ void mrpt::math::ransac_detect_3D_planes(
 
 	if (x.empty()) return;
 
-	// The running lists of remaining points after each plane, as a matrix:
-	CMatrixTemplateNumeric<NUMTYPE> remainingPoints(3, x.size());
-	remainingPoints.insertRow(0, x);
-	remainingPoints.insertRow(1, y);
-	remainingPoints.insertRow(2, z);
+	// The running lists of remaining points after each plane:
+	Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1> xs = x, ys = y, zs = z;
+	const TPlaneFit<NUMTYPE> fit(xs, ys, zs);
+
+	ModelSearch search;
+	search.options.prob_good_sample = 0.999;
+	search.options.num_threads =
+		static_cast<size_t>(x.size()) < MIN_POINTS_FOR_THREADS ? 1 : 0;
 
 	// ---------------------------------------------
 	// For each plane:
 	// ---------------------------------------------
-	for (;;)
+	while (xs.size() >= 3)
 	{
-		mrpt::vector_size_t this_best_inliers;
-		CMatrixTemplateNumeric<NUMTYPE> this_best_model;
-
-		math::RANSAC_Template<NUMTYPE> ransac;
-		ransac.setVerbosityLevel(mrpt::utils::LVL_INFO);
-		ransac.execute(
-			remainingPoints, ransac3Dplane_fit, ransac3Dplane_distance,
-			ransac3Dplane_degenerate, threshold,
-			3,  // Minimum set of points
-			this_best_inliers, this_best_model,
-			0.999  // Prob. of good result
-			);
+		vector_size_t this_best_inliers;
+		TPlane this_best_model;
+
+		search.ransacParallel(
+			fit, 3, NUMTYPE(threshold), this_best_model, this_best_inliers);
 
 		// Is this plane good enough?
 		if (this_best_inliers.size() >= min_inliers_for_valid_plane)
 		{
 			// Add this plane to the output list:
 			out_detected_planes.push_back(
-				std::make_pair(
-					this_best_inliers.size(),
-					TPlane(
-						double(this_best_model(0, 0)),
-						double(this_best_model(0, 1)),
-						double(this_best_model(0, 2)),
-						double(this_best_model(0, 3)))));
+				std::make_pair(this_best_inliers.size(), this_best_model));
 
 			out_detected_planes.rbegin()->second.unitarize();
 
 			// Discard the selected points so they are not used again for
 			// finding subsequent planes:
-			remainingPoints.removeColumns(this_best_inliers);
+			removeIndices(xs, this_best_inliers);
+			removeIndices(ys, this_best_inliers);
+			removeIndices(zs, this_best_inliers);
 		}
 		else
 		{
@@ -189,98 +218,14 @@ EXPLICIT_INST_ransac_detect_3D_planes(float)
 #endif
 
 	/*---------------------------------------------------------------
-			Aux. functions needed by ransac_detect_2D_lines
+					ransac_detect_2D_lines
 	 ---------------------------------------------------------------*/
-	namespace mrpt
-{
-	namespace math
-	{
-	template <typename T>
-	void ransac2Dline_fit(
-		const CMatrixTemplateNumeric<T>& allData,
-		const vector_size_t& useIndices,
-		vector<CMatrixTemplateNumeric<T>>& fitModels)
-	{
-		ASSERT_(useIndices.size() == 2);
-
-		TPoint2D p1(allData(0, useIndices[0]), allData(1, useIndices[0]));
-		TPoint2D p2(allData(0, useIndices[1]), allData(1, useIndices[1]));
-
-		try
-		{
-			TLine2D line(p1, p2);
-			fitModels.resize(1);
-			CMatrixTemplateNumeric<T>& M = fitModels[0];
-
-			M.setSize(1, 3);
-			for (size_t i = 0; i < 3; i++) M(0, i) = line.coefs[i];
-		}
-		catch (exception&)
-		{
-			fitModels.clear();
-			return;
-		}
-	}
-
-	template <typename T>
-	void ransac2Dline_distance(
-		const CMatrixTemplateNumeric<T>& allData,
-		const vector<CMatrixTemplateNumeric<T>>& testModels,
-		const T distanceThreshold, unsigned int& out_bestModelIndex,
-		vector_size_t& out_inlierIndices)
-	{
-		out_inlierIndices.clear();
-		out_bestModelIndex = 0;
-
-		if (testModels.empty()) return;  // No model, no inliers.
-
-		ASSERTMSG_(
-			testModels.size() == 1,
-			format(
-				"Expected testModels.size()=1, but it's = %u",
-				static_cast<unsigned int>(testModels.size())))
-		const CMatrixTemplateNumeric<T>& M = testModels[0];
-
-		ASSERT_(size(M, 1) == 1 && size(M, 2) == 3)
-
-		TLine2D line;
-		line.coefs[0] = M(0, 0);
-		line.coefs[1] = M(0, 1);
-		line.coefs[2] = M(0, 2);
-
-		const size_t N = size(allData, 2);
-		out_inlierIndices.reserve(100);
-		for (size_t i = 0; i < N; i++)
-		{
-			const double d = line.distance(
-				TPoint2D(allData.get_unsafe(0, i), allData.get_unsafe(1, i)));
-			if (d < distanceThreshold) out_inlierIndices.push_back(i);
-		}
-	}
-
-	/** Return "true" if the selected points are a degenerate (invalid) case.
-	  */
-	template <typename T>
-	bool ransac2Dline_degenerate(
-		const CMatrixTemplateNumeric<T>& allData,
-		const mrpt::vector_size_t& useIndices)
-	{
-		MRPT_UNUSED_PARAM(allData);
-		MRPT_UNUSED_PARAM(useIndices);
-		return false;
-	}
-	}  // end namespace
-}  // end namespace
-
-/*---------------------------------------------------------------
-				ransac_detect_2D_lines
- ---------------------------------------------------------------*/
-template <typename NUMTYPE>
-void mrpt::math::ransac_detect_2D_lines(
-	const Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1>& x,
-	const Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1>& y,
-	std::vector<std::pair<size_t, TLine2D>>& out_detected_lines,
-	const double threshold, const size_t min_inliers_for_valid_line)
+	template <typename NUMTYPE>
+	void mrpt::math::ransac_detect_2D_lines(
+		const Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1>& x,
+		const Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1>& y,
+		std::vector<std::pair<size_t, TLine2D>>& out_detected_lines,
+		const double threshold, const size_t min_inliers_for_valid_line)
 {
 	MRPT_START
 
@@ -290,50 +235,43 @@ void mrpt::math::ransac_detect_2D_lines(
 
 	if (x.empty()) return;
 
-	// The running lists of remaining points after each plane, as a matrix:
-	CMatrixTemplateNumeric<NUMTYPE> remainingPoints(2, x.size());
-	remainingPoints.insertRow(0, x);
-	remainingPoints.insertRow(1, y);
+	// The running lists of remaining points after each line:
+	Eigen::Matrix<NUMTYPE, Eigen::Dynamic, 1> xs = x, ys = y;
+	const TLineFit<NUMTYPE> fit(xs, ys);
+
+	ModelSearch search;
+	search.options.prob_good_sample = 0.99999;
+	search.options.num_threads =
+		static_cast<size_t>(x.size()) < MIN_POINTS_FOR_THREADS ? 1 : 0;
 
 	// ---------------------------------------------
 	// For each line:
 	// ---------------------------------------------
-	while (size(remainingPoints, 2) >= 2)
+	while (xs.size() >= 2)
 	{
-		mrpt::vector_size_t this_best_inliers;
-		CMatrixTemplateNumeric<NUMTYPE> this_best_model;
-
-		math::RANSAC_Template<NUMTYPE> ransac;
-		ransac.setVerbosityLevel(mrpt::utils::LVL_INFO);
-		ransac.execute(
-			remainingPoints, ransac2Dline_fit, ransac2Dline_distance,
-			ransac2Dline_degenerate, threshold,
-			2,  // Minimum set of points
-			this_best_inliers, this_best_model,
-			0.99999  // Prob. of good result
-			);
+		vector_size_t this_best_inliers;
+		TLine2D this_best_model;
 
-		// Is this plane good enough?
+		search.ransacParallel(
+			fit, 2, NUMTYPE(threshold), this_best_model, this_best_inliers);
+
+		// Is this line good enough?
 		if (this_best_inliers.size() >= min_inliers_for_valid_line)
 		{
-			// Add this plane to the output list:
+			// Add this line to the output list:
 			out_detected_lines.push_back(
-				std::make_pair(
-					this_best_inliers.size(),
-					TLine2D(
-						double(this_best_model(0, 0)),
-						double(this_best_model(0, 1)),
-						double(this_best_model(0, 2)))));
+				std::make_pair(this_best_inliers.size(), this_best_model));
 
 			out_detected_lines.rbegin()->second.unitarize();
 
 			// Discard the selected points so they are not used again for
-			// finding subsequent planes:
-			remainingPoints.removeColumns(this_best_inliers);
+			// finding subsequent lines:
+			removeIndices(xs, this_best_inliers);
+			removeIndices(ys, this_best_inliers);
 		}
 		else
 		{
-			break;  // Do not search for more planes.
+			break;  // Do not search for more lines.
 		}
 	}
 
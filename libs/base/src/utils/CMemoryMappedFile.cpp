@@ -0,0 +1,125 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "base-precomp.h"  // Precompiled headers
+
+#include <mrpt/utils/CMemoryMappedFile.h>
+#include <mrpt/utils/mrpt_macros.h>
+
+#ifdef MRPT_OS_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mrpt::utils;
+
+CMemoryMappedFile::CMemoryMappedFile()
+	: m_data(nullptr),
+	  m_size(0),
+	  m_is_open(false),
+	  m_file_handle(nullptr),
+	  m_map_handle(nullptr)
+{
+}
+
+CMemoryMappedFile::CMemoryMappedFile(const std::string& fileName)
+	: CMemoryMappedFile()
+{
+	open(fileName);
+}
+
+CMemoryMappedFile::~CMemoryMappedFile() { close(); }
+void CMemoryMappedFile::open(const std::string& fileName)
+{
+	MRPT_START
+
+	close();
+
+#ifdef MRPT_OS_WINDOWS
+	HANDLE hFile = CreateFileA(
+		fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		THROW_EXCEPTION_FMT("Error opening file '%s'", fileName.c_str());
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize))
+	{
+		CloseHandle(hFile);
+		THROW_EXCEPTION_FMT("Error reading size of file '%s'", fileName.c_str());
+	}
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_file_handle = hFile;
+	m_is_open = true;
+	if (m_size == 0) return;
+
+	HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMap)
+	{
+		close();
+		THROW_EXCEPTION_FMT("Error mapping file '%s'", fileName.c_str());
+	}
+	m_map_handle = hMap;
+	m_data =
+		static_cast<const char*>(MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0));
+	if (!m_data)
+	{
+		close();
+		THROW_EXCEPTION_FMT("Error mapping file '%s'", fileName.c_str());
+	}
+#else
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		THROW_EXCEPTION_FMT("Error opening file '%s'", fileName.c_str());
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		THROW_EXCEPTION_FMT("Error reading size of file '%s'", fileName.c_str());
+	}
+	m_size = static_cast<size_t>(st.st_size);
+	m_is_open = true;
+	if (m_size > 0)
+	{
+		void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			::close(fd);
+			m_is_open = false;
+			m_size = 0;
+			THROW_EXCEPTION_FMT("Error mapping file '%s'", fileName.c_str());
+		}
+		madvise(p, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(p);
+	}
+	// The mapping remains valid after closing the descriptor:
+	::close(fd);
+#endif
+
+	MRPT_END
+}
+
+void CMemoryMappedFile::close()
+{
+#ifdef MRPT_OS_WINDOWS
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_map_handle) CloseHandle(static_cast<HANDLE>(m_map_handle));
+	if (m_file_handle) CloseHandle(static_cast<HANDLE>(m_file_handle));
+#else
+	if (m_data) munmap(const_cast<char*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_is_open = false;
+	m_file_handle = nullptr;
+	m_map_handle = nullptr;
+}
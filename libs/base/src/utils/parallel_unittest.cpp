@@ -0,0 +1,64 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/parallel.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace mrpt::utils;
+using namespace std;
+
+TEST(parallel, parallel_for_ranges)
+{
+	for (size_t num_threads = 0; num_threads <= 5; num_threads++)
+	{
+		// Each item is visited once, and ranges are contiguous per thread:
+		const size_t N = 103;
+		vector<int> visits(N, 0);
+		vector<size_t> first_of_thread(max<size_t>(num_threads, 1), N);
+		parallel_for_ranges(
+			N, max<size_t>(num_threads, 1),
+			[&](const size_t t, const size_t first, const size_t last) {
+				first_of_thread[t] = first;
+				for (size_t i = first; i < last; i++) visits[i]++;
+			});
+		for (size_t i = 0; i < N; i++) EXPECT_EQ(visits[i], 1);
+		EXPECT_EQ(first_of_thread[0], 0u);
+	}
+
+	// Fewer threads than requested for few items:
+	vector<int> used(4, 0);
+	parallel_for_ranges(
+		10, 4, [&](const size_t t, size_t, size_t) { used[t] = 1; },
+		5 /*min_items_per_thread*/);
+	EXPECT_EQ(used[0] + used[1] + used[2] + used[3], 2);
+}
+
+TEST(parallel, parallel_for_jobs)
+{
+	for (size_t num_threads = 0; num_threads <= 5; num_threads++)
+	{
+		const size_t N = 57;
+		vector<int> visits(N, 0);
+		parallel_for_jobs(
+			N, num_threads, [&](const size_t job) { visits[job]++; });
+		for (size_t i = 0; i < N; i++) EXPECT_EQ(visits[i], 1);
+	}
+
+	// Exceptions are rethrown in the calling thread:
+	EXPECT_THROW(
+		parallel_for_jobs(
+			20, 4,
+			[](const size_t job) {
+				if (job == 13) throw std::runtime_error("job 13");
+			}),
+		std::runtime_error);
+	EXPECT_GE(parallel_num_threads(0), 1u);
+	EXPECT_EQ(parallel_num_threads(3), 3u);
+}
@@ -17,6 +17,8 @@
 #include <mrpt/graphs/CNetworkOfPoses.h>
 #include <mrpt/graphs/dijkstra.h>
 #include <mrpt/graphs/CDirectedGraph.h>
+#include <mrpt/graphs/CCompressedGraph.h>
+#include <mrpt/graphs/CShortestPathTrees.h>
 #include <mrpt/graphs/CDirectedTree.h>
 #include <mrpt/graphs/THypothesis.h>
 #include <mrpt/graphs/CHypothesisNotFoundException.h>
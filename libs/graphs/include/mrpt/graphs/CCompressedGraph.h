@@ -0,0 +1,337 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef MRPT_COMPRESSED_GRAPH_H
+#define MRPT_COMPRESSED_GRAPH_H
+
+#include <mrpt/graphs/CDirectedGraph.h>
+#include <algorithm>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphs
+{
+namespace detail
+{
+/** Appends the IDs in `g.nodes` (only for graphs with a `nodes` member, like
+ * CNetworkOfPoses) */
+template <class GRAPH_T>
+auto compressed_graph_collect_nodes(
+	const GRAPH_T& g, std::vector<TNodeID>& ids, int)
+	-> decltype(g.nodes.begin(), void())
+{
+	for (const auto& n : g.nodes) ids.push_back(n.first);
+}
+template <class GRAPH_T>
+void compressed_graph_collect_nodes(
+	const GRAPH_T&, std::vector<TNodeID>&, long)
+{
+}
+}
+
+/** \addtogroup mrpt_graphs_grp
+	@{ */
+
+/** A compressed sparse row (CSR) index of the nodes and edges of a
+ * mrpt::graphs::CDirectedGraph or any derived class (e.g.
+ * mrpt::graphs::CNetworkOfPoses).
+ *
+ * Nodes are stored in a contiguous, sorted array of IDs, and are referred to
+ * by their index in that array. Edges are stored in contiguous arrays with
+ * their endpoints (as node indices) and a pointer to the edge data in the
+ * original graph. The adjacency of each node (all edges incident to it,
+ * regardless of their direction) is a contiguous range of entries, sorted by
+ * the index of the neighbor node. This avoids the pointer chasing of
+ * `std::map` look-ups in graph traversals like CDijkstra.
+ *
+ * Usage:
+ *  - build() indexes the whole graph, and leaves the object "frozen".
+ *  - New edges added to the graph later on can be passed to appendEdge().
+ *    They go to an append buffer, with no effect on the current adjacency
+ *    until freeze() is called. Freezing merges the buffer in O(N+E), without
+ *    looking at the original graph again. Indices of existing edges never
+ *    change, and node indices only change if the new node IDs are not larger
+ *    than the existing ones.
+ *
+ * Since edge data is referred to by pointers, the original graph must
+ * outlive this object, and edges must not be erased from it while indexed.
+ *
+ * Within the adjacency of a node, all the edges to the same neighbor are
+ * contiguous, with the edges leaving the node first and then in the order
+ * they had in the graph. Hence, the first entry for each neighbor is the
+ * edge that `graph.edges.find()` would return for `(node, neighbor)` or,
+ * if there is none, for `(neighbor, node)`.
+ *
+ * \sa CDijkstra, CNetworkOfPoses::extractSubGraph
+ */
+template <class GRAPH_T>
+class CCompressedGraph
+{
+   public:
+	typedef GRAPH_T graph_t;
+	typedef typename graph_t::edge_t edge_t;
+
+	/** Invalid node or edge index */
+	static const size_t INVALID_IDX = static_cast<size_t>(-1);
+
+	/** One entry in the adjacency of a node */
+	struct TAdjacentEdge
+	{
+		/** Index of the neighbor node */
+		size_t node;
+		/** Index of the edge */
+		size_t edge;
+		/** false: node -> neighbor; true: neighbor -> node */
+		bool reverse;
+	};
+
+	CCompressedGraph() : m_graph(nullptr), m_ids_are_dense(true) {}
+	/** Builds the index of the given graph \sa build */
+	explicit CCompressedGraph(const graph_t& graph)
+		: m_graph(nullptr), m_ids_are_dense(true)
+	{
+		build(graph);
+	}
+
+	/** Indexes all the edges of the graph (and all the nodes, for graphs with
+	 * a `nodes` member, even if they have no edges). Clears any previous
+	 * content, including the append buffer. */
+	void build(const graph_t& graph)
+	{
+		clear();
+		m_graph = &graph;
+
+		m_node_ids.reserve(graph.edges.size() + 1);
+		detail::compressed_graph_collect_nodes(graph, m_node_ids, 0);
+		for (const auto& e : graph.edges)
+		{
+			m_node_ids.push_back(e.first.first);
+			m_node_ids.push_back(e.first.second);
+		}
+		sortNodeIDs();
+
+		m_edge_nodes.reserve(graph.edges.size());
+		m_edge_values.reserve(graph.edges.size());
+		for (const auto& e : graph.edges)
+		{
+			m_edge_nodes.push_back(
+				std::make_pair(
+					nodeIndex(e.first.first), nodeIndex(e.first.second)));
+			m_edge_values.push_back(&e);
+		}
+		buildAdjacency();
+	}
+
+	/** Adds an edge of the graph passed to build() to the append buffer. It
+	 * will not be visible until freeze() is called. */
+	void appendEdge(const typename graph_t::const_iterator& it)
+	{
+		m_pending_edges.push_back(&(*it));
+	}
+	/** Adds a node with no edges to the append buffer (nodes of new edges are
+	 * added automatically). */
+	void appendNode(const TNodeID id) { m_pending_nodes.push_back(id); }
+	/** Merges the append buffer into the compressed arrays. */
+	void freeze()
+	{
+		if (isFrozen()) return;
+		ASSERTMSG_(m_graph, "freeze() called before build()");
+
+		// New node IDs:
+		for (const auto* e : m_pending_edges)
+		{
+			m_pending_nodes.push_back(e->first.first);
+			m_pending_nodes.push_back(e->first.second);
+		}
+		std::vector<TNodeID> new_ids;
+		for (const TNodeID id : m_pending_nodes)
+			if (nodeIndex(id) == INVALID_IDX) new_ids.push_back(id);
+		m_pending_nodes.clear();
+		if (!new_ids.empty())
+		{
+			const bool nodes_appended_at_end =
+				m_node_ids.empty() ||
+				*std::min_element(new_ids.begin(), new_ids.end()) >
+					m_node_ids.back();
+			std::vector<TNodeID> old_ids;
+			if (!nodes_appended_at_end) old_ids = m_node_ids;
+			m_node_ids.insert(m_node_ids.end(), new_ids.begin(), new_ids.end());
+			sortNodeIDs();
+			// Renumber the endpoints of existing edges, if needed:
+			if (!nodes_appended_at_end)
+			{
+				for (auto& en : m_edge_nodes)
+				{
+					en.first = nodeIndex(old_ids[en.first]);
+					en.second = nodeIndex(old_ids[en.second]);
+				}
+			}
+		}
+
+		// New edges go after the existing ones:
+		for (const auto* e : m_pending_edges)
+		{
+			m_edge_nodes.push_back(
+				std::make_pair(
+					nodeIndex(e->first.first), nodeIndex(e->first.second)));
+			m_edge_values.push_back(e);
+		}
+		m_pending_edges.clear();
+		buildAdjacency();
+	}
+	/** Whether the append buffer is empty */
+	bool isFrozen() const
+	{
+		return m_pending_edges.empty() && m_pending_nodes.empty();
+	}
+	/** Empties all the arrays and the append buffer */
+	void clear()
+	{
+		m_graph = nullptr;
+		m_ids_are_dense = true;
+		m_node_ids.clear();
+		m_edge_nodes.clear();
+		m_edge_values.clear();
+		m_row_ptr.clear();
+		m_adjacency.clear();
+		m_pending_edges.clear();
+		m_pending_nodes.clear();
+	}
+
+	/** The graph passed to build(), or nullptr */
+	const graph_t* getGraph() const { return m_graph; }
+	/** @name Nodes
+		@{ */
+	size_t nodeCount() const { return m_node_ids.size(); }
+	/** All the node IDs, in ascending order */
+	const std::vector<TNodeID>& getNodeIDs() const { return m_node_ids; }
+	TNodeID nodeID(const size_t idx) const { return m_node_ids[idx]; }
+	/** The index of a node ID, or INVALID_IDX if it is not in the graph.
+	 * Constant time if the node IDs are consecutive, logarithmic otherwise */
+	size_t nodeIndex(const TNodeID id) const
+	{
+		if (m_node_ids.empty()) return INVALID_IDX;
+		if (m_ids_are_dense)
+		{
+			const TNodeID first = m_node_ids.front();
+			return (id >= first && id - first < m_node_ids.size())
+					   ? static_cast<size_t>(id - first)
+					   : INVALID_IDX;
+		}
+		const auto it =
+			std::lower_bound(m_node_ids.begin(), m_node_ids.end(), id);
+		return (it != m_node_ids.end() && *it == id)
+				   ? static_cast<size_t>(it - m_node_ids.begin())
+				   : INVALID_IDX;
+	}
+	/** Number of edges incident to a node (self-loops count twice) */
+	size_t degree(const size_t idx) const
+	{
+		return m_row_ptr[idx + 1] - m_row_ptr[idx];
+	}
+	/** The range [begin,end) of edges incident to a node */
+	const TAdjacentEdge* adjacencyBegin(const size_t idx) const
+	{
+		return m_adjacency.data() + m_row_ptr[idx];
+	}
+	const TAdjacentEdge* adjacencyEnd(const size_t idx) const
+	{
+		return m_adjacency.data() + m_row_ptr[idx + 1];
+	}
+	/** @} */
+
+	/** @name Edges
+		@{ */
+	size_t edgeCount() const { return m_edge_nodes.size(); }
+	/** Indices of the nodes (from,to) of an edge */
+	const std::pair<size_t, size_t>& edgeNodes(const size_t e) const
+	{
+		return m_edge_nodes[e];
+	}
+	/** IDs of the nodes (from,to) of an edge */
+	const TPairNodeIDs& edgeNodeIDs(const size_t e) const
+	{
+		return m_edge_values[e]->first;
+	}
+	/** The data of an edge, in the original graph */
+	const edge_t& edgeValue(const size_t e) const
+	{
+		return m_edge_values[e]->second;
+	}
+	/** @} */
+
+   private:
+	typedef typename graph_t::edges_map_t::value_type edge_entry_t;
+
+	const graph_t* m_graph;
+	bool m_ids_are_dense;
+	std::vector<TNodeID> m_node_ids;
+	std::vector<std::pair<size_t, size_t>> m_edge_nodes;
+	std::vector<const edge_entry_t*> m_edge_values;
+	/** Adjacency of node `i` is m_adjacency[m_row_ptr[i]:m_row_ptr[i+1]] */
+	std::vector<size_t> m_row_ptr;
+	std::vector<TAdjacentEdge> m_adjacency;
+	// Append buffer:
+	std::vector<const edge_entry_t*> m_pending_edges;
+	std::vector<TNodeID> m_pending_nodes;
+
+	void sortNodeIDs()
+	{
+		std::sort(m_node_ids.begin(), m_node_ids.end());
+		m_node_ids.erase(
+			std::unique(m_node_ids.begin(), m_node_ids.end()),
+			m_node_ids.end());
+		m_ids_are_dense =
+			m_node_ids.empty() ||
+			m_node_ids.back() - m_node_ids.front() + 1 == m_node_ids.size();
+	}
+
+	void buildAdjacency()
+	{
+		const size_t nNodes = m_node_ids.size(), nEdges = m_edge_nodes.size();
+
+		// Counting sort of the edge endpoints by node index:
+		m_row_ptr.assign(nNodes + 1, 0);
+		for (const auto& en : m_edge_nodes)
+		{
+			m_row_ptr[en.first + 1]++;
+			m_row_ptr[en.second + 1]++;
+		}
+		for (size_t i = 0; i < nNodes; i++) m_row_ptr[i + 1] += m_row_ptr[i];
+
+		m_adjacency.resize(2 * nEdges);
+		std::vector<size_t> next(m_row_ptr.begin(), m_row_ptr.end() - 1);
+		for (size_t e = 0; e < nEdges; e++)
+		{
+			const size_t from = m_edge_nodes[e].first,
+						 to = m_edge_nodes[e].second;
+			m_adjacency[next[from]++] = TAdjacentEdge{to, e, false};
+			m_adjacency[next[to]++] = TAdjacentEdge{from, e, true};
+		}
+
+		// Entries were added by increasing edge index. A stable sort by
+		// (neighbor, direction) keeps that order for parallel edges:
+		for (size_t i = 0; i < nNodes; i++)
+			std::stable_sort(
+				m_adjacency.begin() + m_row_ptr[i],
+				m_adjacency.begin() + m_row_ptr[i + 1],
+				[](const TAdjacentEdge& a, const TAdjacentEdge& b) {
+					return a.node < b.node ||
+						   (a.node == b.node && !a.reverse && b.reverse);
+				});
+	}
+};
+
+template <class GRAPH_T>
+const size_t CCompressedGraph<GRAPH_T>::INVALID_IDX;
+
+/** @} */
+}  // End of namespace
+}  // End of namespace
+#endif
@@ -14,6 +14,8 @@
 #include <mrpt/math/CMatrix.h>
 #include <mrpt/math/ops_matrices.h>
 
+#include <Eigen/SparseCore>
+
 namespace mrpt
 {
 /** Abstract graph and tree data structures, plus generic graph algorithms
@@ -35,6 +37,14 @@ namespace graphs
  * \tparam num_t The type of matrix elements, thresholds, etc. (typ: float or
  * double). Defaults to the type of matrix elements.
  *
+ * Besides the dense versions, which compute all the eigenvectors of the
+ * laplacian (O(n^3)), overloads for sparse weight matrices are provided. They
+ * only compute the Fiedler vector (the eigenvector of the second smallest
+ * eigenvalue of the laplacian) with a multilevel scheme: the graph is
+ * coarsened by heavy-edge matching down to a few nodes, the coarsest problem
+ * is solved exactly and the solution is refined back with Lanczos iterations.
+ * Use them for graphs of more than a few hundred nodes.
+ *
  * \note Prior to MRPT 1.0.0 this class wasn't a template and provided static
  * variables for debugging, which were removed since that version.
  */
@@ -42,6 +52,9 @@ template <class GRAPH_MATRIX, typename num_t = typename GRAPH_MATRIX::Scalar>
 class CGraphPartitioner : public mrpt::utils::COutputLogger
 {
    public:
+	/** Sparse weights matrix, for the sparse versions of the algorithms */
+	typedef Eigen::SparseMatrix<num_t> sparse_matrix_t;
+
 	/** Performs the spectral recursive partition into K-parts for a given
 	 * graph.
 	 *   The default threshold for the N-cut is 1, which correspond to a cut
@@ -142,6 +155,64 @@ class CGraphPartitioner : public mrpt::utils::COutputLogger
 		const GRAPH_MATRIX& in_A, const vector_uint& in_part1,
 		const vector_uint& in_part2);
 
+	/** @name Sparse graphs
+		@{ */
+
+	/** Sparse version of RecursiveSpectralPartition(), which always uses
+	 * spectral bisection. Non-stored elements of in_A are zero weights.
+	 * \sa SpectralBisection
+	 */
+	static void RecursiveSpectralPartition(
+		const sparse_matrix_t& in_A, std::vector<vector_uint>& out_parts,
+		num_t threshold_Ncut = 1, bool forceSimetry = true,
+		bool recursive = true, unsigned minSizeClusters = 1,
+		const bool verbose = false);
+
+	/** Sparse version of SpectralBisection(). The nodes are split according
+	 * to the Fiedler vector of the laplacian, computed with a multilevel
+	 * Lanczos method in O(nnz) time per iteration.
+	 *
+	 * If the graph is not connected the cut is zero: its connected
+	 * components are distributed between both parts, balancing their sizes.
+	 */
+	static void SpectralBisection(
+		const sparse_matrix_t& in_A, vector_uint& out_part1,
+		vector_uint& out_part2, num_t& out_cut_value, bool forceSimetry = true);
+
+	/** Sparse version of nCut() */
+	static num_t nCut(
+		const sparse_matrix_t& in_A, const vector_uint& in_part1,
+		const vector_uint& in_part2);
+
+	/** Computes the Fiedler vector (the eigenvector of the second smallest
+	 * eigenvalue) of the laplacian of a connected graph, given its symmetric
+	 * weights matrix.
+	 * \param in_A [IN] Symmetric weights matrix. Its diagonal is ignored.
+	 * \param out_fiedler [OUT] The normalized eigenvector.
+	 * \return The eigenvalue.
+	 */
+	static double FiedlerVector(
+		const sparse_matrix_t& in_A, Eigen::VectorXd& out_fiedler);
+	/** @} */
+
+   private:
+	typedef Eigen::SparseMatrix<double> sparse_laplacian_t;
+
+	/** Connected components of a symmetric sparse graph. \return The number
+	 * of components */
+	static size_t connectedComponents(
+		const sparse_matrix_t& A, std::vector<size_t>& out_component);
+	/** Coarsens a graph by heavy-edge matching: out_coarse_idx maps each
+	 * node to its node in the coarse graph */
+	static void coarsenGraph(
+		const sparse_laplacian_t& W, sparse_laplacian_t& out_coarse_W,
+		std::vector<size_t>& out_coarse_idx);
+	/** Refines an approximation of the Fiedler vector with restarted Lanczos
+	 * iterations. \return The eigenvalue */
+	static double refineFiedlerVector(
+		const sparse_laplacian_t& W, Eigen::VectorXd& x,
+		const size_t max_restarts);
+
 };  // End of class def.
 
 }  // End of namespace
@@ -351,5 +351,470 @@ void CGraphPartitioner<GRAPH_MATRIX, num_t>::exactBisection(
 	}
 }
 
+/*---------------------------------------------------------------
+					nCut (sparse)
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+num_t CGraphPartitioner<GRAPH_MATRIX, num_t>::nCut(
+	const sparse_matrix_t& in_A, const vector_uint& in_part1,
+	const vector_uint& in_part2)
+{
+	// Which part each node belongs to (0: none)
+	std::vector<uint8_t> side(in_A.rows(), 0);
+	for (size_t i = 0; i < in_part1.size(); i++) side[in_part1[i]] = 1;
+	for (size_t i = 0; i < in_part2.size(); i++) side[in_part2[i]] = 2;
+
+	num_t cut_AB = 0, assoc_AA = 0, assoc_BB = 0;
+	for (int k = 0; k < in_A.outerSize(); ++k)
+	{
+		for (typename sparse_matrix_t::InnerIterator it(in_A, k); it; ++it)
+		{
+			const size_t r = it.row(), c = it.col();
+			if (side[r] == 1 && side[c] == 2)
+				cut_AB += it.value();
+			else if (r < c && side[r] == side[c])
+			{
+				if (side[r] == 1) assoc_AA += it.value();
+				if (side[r] == 2) assoc_BB += it.value();
+			}
+		}
+	}
+
+	num_t assoc_AV = assoc_AA + cut_AB;
+	num_t assoc_BV = assoc_BB + cut_AB;
+
+	if (!cut_AB)
+		return 0;
+	else
+		return cut_AB / assoc_AV + cut_AB / assoc_BV;
+}
+
+/*---------------------------------------------------------------
+					SpectralBisection (sparse)
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+void CGraphPartitioner<GRAPH_MATRIX, num_t>::SpectralBisection(
+	const sparse_matrix_t& in_A, vector_uint& out_part1,
+	vector_uint& out_part2, num_t& out_cut_value, bool forceSimetry)
+{
+	MRPT_START
+
+	// Check matrix is square:
+	if (in_A.cols() != in_A.rows())
+		THROW_EXCEPTION("Weights matrix is not square!!");
+	const size_t nodeCount = in_A.rows();
+
+	// forceSimetry?
+	sparse_matrix_t Adj;
+	if (forceSimetry)
+	{
+		const sparse_matrix_t At = in_A.transpose();
+		Adj = (in_A + At) * num_t(0.5);
+	}
+	else
+		Adj = in_A;
+
+	out_part1.clear();
+	out_part2.clear();
+	if (nodeCount < 2)
+	{
+		for (size_t i = 0; i < nodeCount; i++) out_part1.push_back(i);
+		out_cut_value = 0;
+		return;
+	}
+
+	std::vector<size_t> component;
+	const size_t nComps = connectedComponents(Adj, component);
+	if (nComps > 1)
+	{
+		// A cut with no weight: distribute the connected components, largest
+		// first, into the smallest part.
+		std::vector<vector_uint> comps(nComps);
+		for (size_t i = 0; i < nodeCount; i++)
+			comps[component[i]].push_back(i);
+		std::stable_sort(
+			comps.begin(), comps.end(),
+			[](const vector_uint& a, const vector_uint& b) {
+				return a.size() > b.size();
+			});
+		for (size_t c = 0; c < nComps; c++)
+		{
+			vector_uint& part =
+				out_part1.size() <= out_part2.size() ? out_part1 : out_part2;
+			part.insert(part.end(), comps[c].begin(), comps[c].end());
+		}
+		std::sort(out_part1.begin(), out_part1.end());
+		std::sort(out_part2.begin(), out_part2.end());
+	}
+	else
+	{
+		Eigen::VectorXd fiedler;
+		FiedlerVector(Adj, fiedler);
+
+		const double mean = fiedler.mean();
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			if (fiedler[i] >= mean)
+				out_part1.push_back(i);
+			else
+				out_part2.push_back(i);
+		}
+
+		// Constant eigenvector: Split nodes in two equally sized parts
+		// arbitrarily:
+		if (!out_part1.size() || !out_part2.size())
+		{
+			out_part1.clear();
+			out_part2.clear();
+			for (size_t i = 0; i < nodeCount; i++)
+				if (i <= nodeCount / 2)
+					out_part1.push_back(i);
+				else
+					out_part2.push_back(i);
+		}
+	}
+
+	// Compute the N-cut value
+	out_cut_value = nCut(Adj, out_part1, out_part2);
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					RecursiveSpectralPartition (sparse)
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+void CGraphPartitioner<GRAPH_MATRIX, num_t>::RecursiveSpectralPartition(
+	const sparse_matrix_t& in_A, std::vector<vector_uint>& out_parts,
+	num_t threshold_Ncut, bool forceSimetry, bool recursive,
+	unsigned minSizeClusters, const bool verbose)
+{
+	MRPT_START
+
+	vector_uint p1, p2;
+	num_t cut_value;
+
+	out_parts.clear();
+
+	// Check matrix is square:
+	if (in_A.cols() != in_A.rows())
+		THROW_EXCEPTION("Weights matrix is not square!!");
+	const size_t nodeCount = in_A.rows();
+
+	if (nodeCount == 1)
+	{
+		// Don't split, there is just a node!
+		p1.push_back(0);
+		out_parts.push_back(p1);
+		return;
+	}
+
+	// forceSimetry?
+	sparse_matrix_t Adj;
+	if (forceSimetry)
+	{
+		const sparse_matrix_t At = in_A.transpose();
+		Adj = (in_A + At) * num_t(0.5);
+	}
+	else
+		Adj = in_A;
+
+	// Make bisection
+	SpectralBisection(Adj, p1, p2, cut_value, false);
+
+	if (verbose)
+		std::cout << format(
+			"Cut:%u=%u+%u,nCut=%.02f->", (unsigned int)nodeCount,
+			(unsigned int)p1.size(), (unsigned int)p2.size(), cut_value);
+
+	// Is it a useful partition?
+	if (cut_value > threshold_Ncut || p1.size() < minSizeClusters ||
+		p2.size() < minSizeClusters)
+	{
+		if (verbose) std::cout << "->NO!" << std::endl;
+
+		// No:
+		p1.clear();
+		for (size_t i = 0; i < nodeCount; i++) p1.push_back(i);
+		out_parts.push_back(p1);
+	}
+	else if (!recursive)
+	{
+		if (verbose) std::cout << "->YES!" << std::endl;
+
+		// Force bisection only:
+		out_parts.push_back(p1);
+		out_parts.push_back(p2);
+	}
+	else
+	{
+		if (verbose) std::cout << "->YES!" << std::endl;
+
+		// Split each part, and remap the indices of its partitions:
+		std::vector<int> local_idx(nodeCount);
+		for (int s = 0; s < 2; s++)
+		{
+			const vector_uint& p = s == 0 ? p1 : p2;
+
+			// sub-matrix:
+			std::fill(local_idx.begin(), local_idx.end(), -1);
+			for (size_t i = 0; i < p.size(); i++) local_idx[p[i]] = i;
+			std::vector<Eigen::Triplet<num_t>> triplets;
+			for (int k = 0; k < Adj.outerSize(); ++k)
+			{
+				if (local_idx[k] < 0) continue;
+				for (typename sparse_matrix_t::InnerIterator it(Adj, k); it;
+					 ++it)
+				{
+					if (local_idx[it.row()] < 0) continue;
+					triplets.push_back(Eigen::Triplet<num_t>(
+						local_idx[it.row()], local_idx[it.col()],
+						it.value()));
+				}
+			}
+			sparse_matrix_t A_s(p.size(), p.size());
+			A_s.setFromTriplets(triplets.begin(), triplets.end());
+
+			std::vector<vector_uint> p_parts;
+			RecursiveSpectralPartition(
+				A_s, p_parts, threshold_Ncut, false, recursive,
+				minSizeClusters);
+
+			for (size_t i = 0; i < p_parts.size(); i++)
+			{
+				for (size_t j = 0; j < p_parts[i].size(); j++)
+					p_parts[i][j] = p[p_parts[i][j]];
+				out_parts.push_back(p_parts[i]);
+			}
+		}
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					FiedlerVector
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+double CGraphPartitioner<GRAPH_MATRIX, num_t>::FiedlerVector(
+	const sparse_matrix_t& in_A, Eigen::VectorXd& out_fiedler)
+{
+	MRPT_START
+
+	// Graphs up to this size are solved with a dense eigen-decomposition:
+	const size_t max_dense_size = 200;
+	// Coarsening stops at this size:
+	const size_t coarsest_size = 100;
+
+	ASSERT_(in_A.rows() == in_A.cols() && in_A.rows() >= 2);
+
+	// The hierarchy of coarser graphs, with no self-loops (which don't
+	// change the laplacian), and the mapping of nodes between levels:
+	std::vector<sparse_laplacian_t> levels(1);
+	levels[0] = in_A.template cast<double>();
+	levels[0].prune([](const int r, const int c, const double) {
+		return r != c;
+	});
+	std::vector<std::vector<size_t>> coarse_idxs;
+	while (static_cast<size_t>(levels.back().rows()) > coarsest_size)
+	{
+		sparse_laplacian_t W_c;
+		std::vector<size_t> coarse_idx;
+		coarsenGraph(levels.back(), W_c, coarse_idx);
+		// Stop if the matching does not reduce the graph enough (e.g. stars)
+		if (W_c.rows() > 0.8 * levels.back().rows()) break;
+		levels.push_back(W_c);
+		coarse_idxs.push_back(coarse_idx);
+	}
+
+	// Solve the coarsest graph:
+	const sparse_laplacian_t& W_c = levels.back();
+	const size_t n_c = W_c.rows();
+	double lambda;
+	if (n_c <= max_dense_size)
+	{
+		Eigen::MatrixXd L = -Eigen::MatrixXd(W_c);
+		const Eigen::VectorXd deg = W_c * Eigen::VectorXd::Ones(n_c);
+		L.diagonal() += deg;
+		Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(L);
+		ASSERT_(es.info() == Eigen::Success);
+		out_fiedler = es.eigenvectors().col(1);
+		lambda = es.eigenvalues()[1];
+	}
+	else
+	{
+		// No good coarsening: start from a ramp along the node indices,
+		// which tend to follow the graph in SLAM problems.
+		out_fiedler = Eigen::VectorXd::LinSpaced(n_c, -1.0, 1.0);
+		lambda = refineFiedlerVector(W_c, out_fiedler, 500);
+	}
+
+	// Interpolate the solution to the finer graphs, and refine it:
+	for (size_t l = levels.size() - 1; l > 0; l--)
+	{
+		const std::vector<size_t>& coarse_idx = coarse_idxs[l - 1];
+		Eigen::VectorXd x(coarse_idx.size());
+		for (size_t i = 0; i < coarse_idx.size(); i++)
+			x[i] = out_fiedler[coarse_idx[i]];
+		out_fiedler.swap(x);
+		lambda = refineFiedlerVector(levels[l - 1], out_fiedler, 100);
+	}
+	return lambda;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					connectedComponents
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+size_t CGraphPartitioner<GRAPH_MATRIX, num_t>::connectedComponents(
+	const sparse_matrix_t& A, std::vector<size_t>& out_component)
+{
+	const size_t n = A.rows();
+	const size_t UNVISITED = std::numeric_limits<size_t>::max();
+	out_component.assign(n, UNVISITED);
+	size_t nComps = 0;
+	std::vector<size_t> stack;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (out_component[i] != UNVISITED) continue;
+		out_component[i] = nComps;
+		stack.push_back(i);
+		while (!stack.empty())
+		{
+			const size_t k = stack.back();
+			stack.pop_back();
+			for (typename sparse_matrix_t::InnerIterator it(A, k); it; ++it)
+			{
+				const size_t j = it.row();
+				if (it.value() == 0 || out_component[j] != UNVISITED)
+					continue;
+				out_component[j] = nComps;
+				stack.push_back(j);
+			}
+		}
+		nComps++;
+	}
+	return nComps;
+}
+
+/*---------------------------------------------------------------
+					coarsenGraph
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+void CGraphPartitioner<GRAPH_MATRIX, num_t>::coarsenGraph(
+	const sparse_laplacian_t& W, sparse_laplacian_t& out_coarse_W,
+	std::vector<size_t>& out_coarse_idx)
+{
+	const size_t n = W.rows();
+	const size_t UNMATCHED = std::numeric_limits<size_t>::max();
+	out_coarse_idx.assign(n, UNMATCHED);
+
+	// Match each node with its unmatched neighbor of largest weight:
+	size_t n_c = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (out_coarse_idx[i] != UNMATCHED) continue;
+		size_t best = UNMATCHED;
+		double best_w = 0;
+		for (sparse_laplacian_t::InnerIterator it(W, i); it; ++it)
+		{
+			const size_t j = it.row();
+			if (out_coarse_idx[j] == UNMATCHED && j != i &&
+				it.value() > best_w)
+			{
+				best = j;
+				best_w = it.value();
+			}
+		}
+		out_coarse_idx[i] = n_c;
+		if (best != UNMATCHED) out_coarse_idx[best] = n_c;
+		n_c++;
+	}
+
+	// Coarse weights are the sum of the weights between matched pairs:
+	std::vector<Eigen::Triplet<double>> triplets;
+	triplets.reserve(W.nonZeros());
+	for (int k = 0; k < W.outerSize(); ++k)
+	{
+		for (sparse_laplacian_t::InnerIterator it(W, k); it; ++it)
+		{
+			const size_t r = out_coarse_idx[it.row()],
+						 c = out_coarse_idx[it.col()];
+			if (r != c)
+				triplets.push_back(Eigen::Triplet<double>(r, c, it.value()));
+		}
+	}
+	out_coarse_W.resize(n_c, n_c);
+	out_coarse_W.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+/*---------------------------------------------------------------
+					refineFiedlerVector
+  ---------------------------------------------------------------*/
+template <class GRAPH_MATRIX, typename num_t>
+double CGraphPartitioner<GRAPH_MATRIX, num_t>::refineFiedlerVector(
+	const sparse_laplacian_t& W, Eigen::VectorXd& x,
+	const size_t max_restarts)
+{
+	const size_t n = W.rows();
+	const size_t m = std::min<size_t>(n - 1, 40);  // Krylov subspace size
+	const Eigen::VectorXd deg = W * Eigen::VectorXd::Ones(n);
+	const double norm_L = 2 * deg.maxCoeff();  // Bound of the eigenvalues
+
+	Eigen::MatrixXd V(n, m);
+	Eigen::VectorXd alpha(m), beta(m), w(n);
+	double theta = 0;
+	for (size_t restart = 0; restart <= max_restarts; restart++)
+	{
+		// Lanczos iterations on the laplacian L=D-W, in the subspace
+		// orthogonal to its null space (the constant vector), with full
+		// reorthogonalization:
+		x.array() -= x.mean();
+		const double x_norm = x.norm();
+		if (x_norm < 1e-12)
+		{
+			x = Eigen::VectorXd::LinSpaced(n, -1.0, 1.0);
+			x.normalize();
+		}
+		else
+			x /= x_norm;
+		V.col(0) = x;
+		size_t k = 0;
+		for (size_t j = 0; j < m; j++)
+		{
+			w = deg.cwiseProduct(V.col(j)) - W * V.col(j);
+			alpha[j] = V.col(j).dot(w);
+			for (int pass = 0; pass < 2; pass++)
+			{
+				w -= V.leftCols(j + 1) * (V.leftCols(j + 1).transpose() * w);
+				w.array() -= w.mean();
+			}
+			beta[j] = w.norm();
+			k = j + 1;
+			if (beta[j] <= 1e-12 * norm_L) break;  // Invariant subspace
+			if (j + 1 < m) V.col(j + 1) = w / beta[j];
+		}
+
+		// Ritz pair of the smallest eigenvalue:
+		Eigen::MatrixXd T = Eigen::MatrixXd::Zero(k, k);
+		T.diagonal() = alpha.head(k);
+		for (size_t j = 0; j + 1 < k; j++) T(j, j + 1) = T(j + 1, j) = beta[j];
+		Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(T);
+		theta = es.eigenvalues()[0];
+		const Eigen::VectorXd y = es.eigenvectors().col(0);
+		x = V.leftCols(k) * y;
+
+		// Residual norm: |L*x - theta*x| = beta_k * |y_k|. There is no need
+		// of an accurate eigenvector to split the graph: stop when the angle
+		// error (roughly residual/gap) is small.
+		const double residual = std::abs(beta[k - 1] * y[k - 1]);
+		const double gap = k > 1 ? es.eigenvalues()[1] - theta : norm_L;
+		if (residual <= std::max(1e-2 * gap, 1e-12 * norm_L)) break;
+	}
+	return theta;
+}
+
 }  // end NS
 }  // end NS
@@ -29,6 +29,7 @@
 #include <mrpt/system/os.h>
 #include <mrpt/opengl/CSetOfObjects.h>
 #include <mrpt/graphs/dijkstra.h>
+#include <mrpt/graphs/CCompressedGraph.h>
 #include <mrpt/graphs/TNodeAnnotations.h>
 #include <mrpt/graphs/TMRSlamNodeAnnotations.h>
 #include <mrpt/graphs/THypothesis.h>
@@ -282,6 +283,48 @@ class CNetworkOfPoses
 		if (collapse_dup_edges) this->collapseDuplicatedEdges();
 	}
 
+	/** Saves to a compact binary file, much faster to load than text files
+	 * for large graphs. The file holds the same data than the text format
+	 * (node poses, and the mean & information matrix of each edge, without
+	 * node annotations nor self-edges), at full precision.
+	 *
+	 * All the fields are 8-byte little-endian words: unsigned integers for
+	 * IDs and counts, IEEE-754 doubles for real values:
+	 *  - Header: the magic "MRPTGRF\0", the format version (1), the flags
+	 *    (bit 0: 3D graph, bit 1: edges_store_inverse_poses), the number of
+	 *    nodes, the number of edges and the root node ID.
+	 *  - Nodes: ID, followed by "x y phi" (2D) or "x y z yaw pitch roll" (3D).
+	 *  - Edges: source and target IDs, the mean as in nodes, and the upper
+	 *    triangle of the information matrix, row by row (6 or 21 values).
+	 *
+	 * \sa loadFromBinaryFile, saveToTextFile
+	 * \exception On any error
+	 */
+	inline void saveToBinaryFile(const std::string& fileName) const
+	{
+		detail::graph_ops<self_t>::save_graph_of_poses_to_binary_graph_file(
+			this, fileName);
+	}
+
+	/** Loads from a binary file created by saveToBinaryFile(). As with text
+	 * files, an exception will be raised if trying to load a 3D graph into a
+	 * 2D class.
+	 *
+	 * \param[in] fileName The file to load.
+	 * \param[in] collapse_dup_edges If true, \a collapseDuplicatedEdges will be
+	 * called automatically after loading.
+	 *
+	 * \sa saveToBinaryFile, loadFromTextFile
+	 * \exception On any error, as a truncated file.
+	 */
+	inline void loadFromBinaryFile(
+		const std::string& fileName, bool collapse_dup_edges = true)
+	{
+		detail::graph_ops<self_t>::load_graph_of_poses_from_binary_graph_file(
+			this, fileName);
+		if (collapse_dup_edges) this->collapseDuplicatedEdges();
+	}
+
 	/** @} */
 
 	/** @name Utility methods
@@ -365,11 +408,15 @@ class CNetworkOfPoses
 	 * If auto_expand_set is false  but there exist
 	 * non-consecutive nodes, virtual edges are inserted in the parts that
 	 * the graph is not connected
+	 * \param[in] compressed_graph Optional, frozen CCompressedGraph index of
+	 * this graph. If given, only the edges of the nodes in node_IDs are
+	 * visited, instead of all the edges in the graph.
 	 */
 	void extractSubGraph(
 		const std::set<TNodeID>& node_IDs, self_t* sub_graph,
 		const TNodeID root_node_in = INVALID_NODEID,
-		const bool& auto_expand_set = true) const
+		const bool& auto_expand_set = true,
+		const CCompressedGraph<self_t>* compressed_graph = nullptr) const
 	{
 		using namespace std;
 		using namespace mrpt;
@@ -435,22 +482,15 @@ class CNetworkOfPoses
 			 node_IDs_it != node_IDs_real.end(); ++node_IDs_it)
 		{
 			// assert that current node exists in *own* graph
-			typename global_poses_t::const_iterator own_it;
-			for (own_it = nodes.begin(); own_it != nodes.end(); ++own_it)
-			{
-				if (*node_IDs_it == own_it->first)
-				{
-					break;  // I throw exception afterwards
-				}
-			}
+			typename global_poses_t::const_iterator own_it =
+				nodes.find(*node_IDs_it);
 			ASSERTMSG_(
 				own_it != nodes.end(),
 				format(
 					"NodeID [%lu] can't be found in the initial graph.",
 					static_cast<unsigned long>(*node_IDs_it)));
 
-			global_pose_t curr_node(nodes.at(*node_IDs_it));
-			sub_graph->nodes.insert(make_pair(*node_IDs_it, curr_node));
+			sub_graph->nodes.insert(make_pair(*node_IDs_it, own_it->second));
 		}
 		// cout << "Extracting subgraph for nodeIDs: " <<
 		// getSTLContainerAsString(node_IDs_real) << endl;
@@ -472,18 +512,45 @@ class CNetworkOfPoses
 		// find all edges (in the initial graph), that exist in the given set
 		// of nodes; add them to the given graph
 		sub_graph->clearEdges();
-		for (typename BASE::const_iterator it = BASE::edges.begin();
-			 it != BASE::edges.end(); ++it)
+		if (compressed_graph)
 		{
-			const TNodeID& from = it->first.first;
-			const TNodeID& to = it->first.second;
-			const typename BASE::edge_t& curr_edge = it->second;
-
-			// if both nodes exist in the given set, add the corresponding edge
-			if (sub_graph->nodes.find(from) != sub_graph->nodes.end() &&
-				sub_graph->nodes.find(to) != sub_graph->nodes.end())
+			ASSERT_(compressed_graph->getGraph() == this);
+			ASSERT_(compressed_graph->isFrozen());
+			// visit the edges leaving each node of the subgraph
+			for (typename global_poses_t::const_iterator n_it =
+					 sub_graph->nodes.begin();
+				 n_it != sub_graph->nodes.end(); ++n_it)
 			{
-				sub_graph->insertEdge(from, to, curr_edge);
+				const size_t idx = compressed_graph->nodeIndex(n_it->first);
+				if (idx == CCompressedGraph<self_t>::INVALID_IDX) continue;
+				for (auto adj = compressed_graph->adjacencyBegin(idx);
+					 adj != compressed_graph->adjacencyEnd(idx); ++adj)
+				{
+					if (adj->reverse) continue;
+					const TNodeID to = compressed_graph->nodeID(adj->node);
+					if (sub_graph->nodes.find(to) != sub_graph->nodes.end())
+						sub_graph->insertEdge(
+							n_it->first, to,
+							compressed_graph->edgeValue(adj->edge));
+				}
+			}
+		}
+		else
+		{
+			for (typename BASE::const_iterator it = BASE::edges.begin();
+				 it != BASE::edges.end(); ++it)
+			{
+				const TNodeID& from = it->first.first;
+				const TNodeID& to = it->first.second;
+				const typename BASE::edge_t& curr_edge = it->second;
+
+				// if both nodes exist in the given set, add the
+				// corresponding edge
+				if (sub_graph->nodes.find(from) != sub_graph->nodes.end() &&
+					sub_graph->nodes.find(to) != sub_graph->nodes.end())
+				{
+					sub_graph->insertEdge(from, to, curr_edge);
+				}
 			}
 		}
 
@@ -10,7 +10,10 @@
 #define CONSTRAINED_POSE_NETWORK_IMPL_H
 
 #include <mrpt/graphs/dijkstra.h>
-#include <mrpt/utils/CTextFileLinesParser.h>
+#include <mrpt/graphs/TTextLineTokenizer.h>
+#include <mrpt/utils/CMemoryMappedFile.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/bits.h>  // reverseBytesInPlace()
 #include <mrpt/math/lightweight_geom_data.h>
 #include <mrpt/math/CArrayNumeric.h>
 #include <mrpt/math/wrap2pi.h>
@@ -107,7 +110,7 @@ struct graph_ops
 		  << edge.mean.x() << " " << edge.mean.y() << " " << edge.mean.phi()
 		  << " " << edge.cov_inv(0, 0) << " " << edge.cov_inv(0, 1) << " "
 		  << edge.cov_inv(1, 1) << " " << edge.cov_inv(2, 2) << " "
-		  << edge.cov_inv(0, 2) << " " << edge.cov_inv(1, 2) << endl;
+		  << edge.cov_inv(0, 2) << " " << edge.cov_inv(1, 2) << '\n';
 	}
 	static void write_EDGE_line(
 		const TPairNodeIDs& edgeIDs, const CPose3DPDFGaussianInf& edge,
@@ -132,7 +135,7 @@ struct graph_ops
 		  << edge.cov_inv(2, 4) << " " << edge.cov_inv(2, 3) << " "
 		  << edge.cov_inv(5, 5) << " " << edge.cov_inv(5, 4) << " "
 		  << edge.cov_inv(5, 3) << " " << edge.cov_inv(4, 4) << " "
-		  << edge.cov_inv(4, 3) << " " << edge.cov_inv(3, 3) << endl;
+		  << edge.cov_inv(4, 3) << " " << edge.cov_inv(3, 3) << '\n';
 	}
 	static void write_EDGE_line(
 		const TPairNodeIDs& edgeIDs, const CPosePDFGaussian& edge,
@@ -189,7 +192,7 @@ struct graph_ops
 			write_VERTEX_line(itNod->first, itNod->second, f);
 
 			// write whatever the NODE_ANNOTATION instance want's to write.
-			f << " | " << itNod->second.retAnnotsAsString() << endl;
+			f << " | " << itNod->second.retAnnotsAsString() << '\n';
 		}
 
 		// 2nd: Edges:
@@ -246,6 +249,273 @@ struct graph_ops
 		}
 	}
 
+	// =================================================================
+	//                     save/load_graph_of_poses_to_binary_graph_file
+	// =================================================================
+	/** 8 bytes (with the final null char) at the beginning of binary graph
+	 * files */
+	static const char* binary_graph_file_magic() { return "MRPTGRF"; }
+	enum
+	{
+		BINARY_GRAPH_FILE_VERSION = 1
+	};
+
+	/** Conversion of any type of edge to the mean+information matrix stored
+	 * in the graph files (as write_EDGE_line() does) */
+	static void edge_to_inf_pdf(
+		const CPosePDFGaussianInf& e, CPosePDFGaussianInf& out)
+	{
+		out = e;
+	}
+	static void edge_to_inf_pdf(
+		const CPosePDFGaussian& e, CPosePDFGaussianInf& out)
+	{
+		out.copyFrom(e);
+	}
+	static void edge_to_inf_pdf(
+		const mrpt::poses::CPose2D& e, CPosePDFGaussianInf& out)
+	{
+		out.mean = e;
+		out.cov_inv.unit(3, 1.0);
+	}
+	static void edge_to_inf_pdf(
+		const CPose3DPDFGaussianInf& e, CPose3DPDFGaussianInf& out)
+	{
+		out = e;
+	}
+	static void edge_to_inf_pdf(
+		const CPose3DPDFGaussian& e, CPose3DPDFGaussianInf& out)
+	{
+		out.copyFrom(e);
+	}
+	static void edge_to_inf_pdf(
+		const mrpt::poses::CPose3D& e, CPose3DPDFGaussianInf& out)
+	{
+		out.mean = e;
+		out.cov_inv.unit(6, 1.0);
+	}
+
+	/** Buffered writer of little-endian 64 bit words */
+	struct TBinaryGraphWriter
+	{
+		mrpt::utils::CFileOutputStream f;
+		std::vector<uint64_t> buf;
+		TBinaryGraphWriter(const std::string& fil) : f(fil)
+		{
+			buf.reserve(1 << 16);
+		}
+		void word(uint64_t w)
+		{
+#if MRPT_IS_BIG_ENDIAN
+			mrpt::utils::reverseBytesInPlace(w);
+#endif
+			buf.push_back(w);
+			if (buf.size() == buf.capacity()) flush();
+		}
+		void real(const double d)
+		{
+			uint64_t w;
+			std::memcpy(&w, &d, sizeof(w));
+			word(w);
+		}
+		void flush()
+		{
+			f.WriteBuffer(&buf[0], buf.size() * sizeof(uint64_t));
+			buf.clear();
+		}
+	};
+	static void write_binary_pose(
+		TBinaryGraphWriter& f, const mrpt::poses::CPose2D& p)
+	{
+		f.real(p.x());
+		f.real(p.y());
+		f.real(p.phi());
+	}
+	static void write_binary_pose(
+		TBinaryGraphWriter& f, const mrpt::poses::CPose3D& p)
+	{
+		f.real(p.x());
+		f.real(p.y());
+		f.real(p.z());
+		f.real(p.yaw());
+		f.real(p.pitch());
+		f.real(p.roll());
+	}
+	template <class PDF>
+	static void write_binary_edge(TBinaryGraphWriter& f, const PDF& edge)
+	{
+		write_binary_pose(f, edge.mean);
+		// Upper triangle of the information matrix, by rows:
+		for (int r = 0; r < edge.cov_inv.rows(); r++)
+			for (int c = r; c < edge.cov_inv.cols(); c++)
+				f.real(edge.cov_inv(r, c));
+	}
+
+	static void save_graph_of_poses_to_binary_graph_file(
+		const graph_t* g, const std::string& fil)
+	{
+		typedef typename graph_t::constraint_t CPOSE;
+		const bool graph_is_3D = CPOSE::is_3D();
+
+		size_t nEdges = 0;  // Self-edges are not saved
+		for (typename graph_t::const_iterator it = g->begin(); it != g->end();
+			 ++it)
+			if (it->first.first != it->first.second) nEdges++;
+
+		TBinaryGraphWriter f(fil);  // raises an exception on error
+
+		// Header:
+		uint64_t magic;
+		std::memcpy(&magic, binary_graph_file_magic(), sizeof(magic));
+#if MRPT_IS_BIG_ENDIAN
+		mrpt::utils::reverseBytesInPlace(magic);
+#endif
+		f.word(magic);
+		f.word(BINARY_GRAPH_FILE_VERSION);
+		f.word(
+			(graph_is_3D ? 1 : 0) | (g->edges_store_inverse_poses ? 2 : 0));
+		f.word(g->nodes.size());
+		f.word(nEdges);
+		f.word(g->root);
+
+		// 1st: Nodes
+		for (typename graph_t::global_poses_t::const_iterator itNod =
+				 g->nodes.begin();
+			 itNod != g->nodes.end(); ++itNod)
+		{
+			f.word(itNod->first);
+			write_binary_pose(f, itNod->second);
+		}
+
+		// 2nd: Edges:
+		typename std::conditional<CPOSE::is_3D_val != 0,
+								  CPose3DPDFGaussianInf,
+								  CPosePDFGaussianInf>::type edge;
+		for (typename graph_t::const_iterator it = g->begin(); it != g->end();
+			 ++it)
+		{
+			if (it->first.first == it->first.second) continue;
+			f.word(it->first.first);
+			f.word(it->first.second);
+			edge_to_inf_pdf(it->second, edge);
+			write_binary_edge(f, edge);
+		}
+		f.flush();
+	}
+
+	static void load_graph_of_poses_from_binary_graph_file(
+		graph_t* g, const std::string& fil)
+	{
+		typedef typename graph_t::constraint_t CPOSE;
+		typedef typename graph_t::constraint_t::type_value pose_t;
+
+		g->clear();
+		const bool graph_is_3D = CPOSE::is_3D();
+
+		// Map the whole file into memory, and read it in place:
+		CMemoryMappedFile mapped_file(fil);  // raises an exception on error
+		const char* p = mapped_file.data();
+		const size_t nWords = mapped_file.size() / sizeof(uint64_t);
+		const size_t HEADER_WORDS = 6;
+		size_t iWord = 0;
+		auto word = [&]() {
+			uint64_t w;
+			std::memcpy(&w, p + sizeof(uint64_t) * (iWord++), sizeof(w));
+#if MRPT_IS_BIG_ENDIAN
+			mrpt::utils::reverseBytesInPlace(w);
+#endif
+			return w;
+		};
+		auto real = [&]() {
+			const uint64_t w = word();
+			double d;
+			std::memcpy(&d, &w, sizeof(d));
+			return d;
+		};
+
+		// Header:
+		if (nWords < HEADER_WORDS ||
+			std::memcmp(p, binary_graph_file_magic(), sizeof(uint64_t)))
+			THROW_EXCEPTION_FMT(
+				"File '%s' is not a binary graph file", fil.c_str());
+		iWord++;
+		const uint64_t version = word();
+		if (version != BINARY_GRAPH_FILE_VERSION)
+			THROW_EXCEPTION_FMT(
+				"File '%s': unknown binary graph file version %u", fil.c_str(),
+				static_cast<unsigned int>(version));
+		const uint64_t flags = word();
+		const bool file_is_3D = (flags & 1) != 0;
+		if (file_is_3D && !graph_is_3D)
+			THROW_EXCEPTION_FMT(
+				"File '%s': Try to load a 3D graph into a 2D graph",
+				fil.c_str());
+		const size_t nNodes = word(), nEdges = word();
+		const TNodeID root = word();
+
+		const size_t pose_words = file_is_3D ? 6 : 3;
+		const size_t inf_words = file_is_3D ? 21 : 6;
+		const size_t node_words = 1 + pose_words;
+		const size_t edge_words = 2 + pose_words + inf_words;
+		// (divide before multiplying: the counts in a corrupt header could
+		// make the products overflow)
+		const size_t data_words = nWords - HEADER_WORDS;
+		if (nNodes > data_words / node_words ||
+			nEdges > (data_words - nNodes * node_words) / edge_words ||
+			data_words != nNodes * node_words + nEdges * edge_words)
+			THROW_EXCEPTION_FMT(
+				"File '%s': size does not match the number of nodes and edges "
+				"in its header",
+				fil.c_str());
+
+		// 1st: Nodes
+		for (size_t i = 0; i < nNodes; i++)
+		{
+			const TNodeID id = word();
+			if (file_is_3D)
+			{
+				const double x = real(), y = real(), z = real(),
+							 yaw = real(), pitch = real(), roll = real();
+				g->nodes[id] = pose_t(CPose3D(x, y, z, yaw, pitch, roll));
+			}
+			else
+			{
+				const double x = real(), y = real(), phi = real();
+				g->nodes[id] = pose_t(CPose2D(x, y, phi));
+			}
+		}
+
+		// 2nd: Edges. They were saved sorted, as in the edges multimap:
+		typename graph_t::edge_t newEdge;
+		for (size_t i = 0; i < nEdges; i++)
+		{
+			const TNodeID from_id = word(), to_id = word();
+			if (file_is_3D)
+			{
+				const double x = real(), y = real(), z = real(),
+							 yaw = real(), pitch = real(), roll = real();
+				CPose3DPDFGaussianInf pdf(CPose3D(x, y, z, yaw, pitch, roll));
+				for (int r = 0; r < 6; r++)
+					for (int c = r; c < 6; c++)
+						pdf.cov_inv(r, c) = pdf.cov_inv(c, r) = real();
+				TPosePDFHelper<CPOSE>::copyFrom3D(newEdge, pdf);
+			}
+			else
+			{
+				const double x = real(), y = real(), phi = real();
+				CPosePDFGaussianInf pdf(CPose2D(x, y, phi));
+				for (int r = 0; r < 3; r++)
+					for (int c = r; c < 3; c++)
+						pdf.cov_inv(r, c) = pdf.cov_inv(c, r) = real();
+				TPosePDFHelper<CPOSE>::copyFrom2D(newEdge, pdf);
+			}
+			g->insertEdgeAtEnd(from_id, to_id, newEdge);
+		}
+
+		g->root = root;
+		g->edges_store_inverse_poses = (flags & 2) != 0;
+	}
+
 	// =================================================================
 	//                     load_graph_of_poses_from_text_file
 	// =================================================================
@@ -268,7 +538,9 @@ struct graph_ops
 		//  it would be an unintentional loss of information:
 		const bool graph_is_3D = CPOSE::is_3D();
 
-		CTextFileLinesParser filParser(fil);  // raises an exception on error
+		// Map the whole file into memory, and parse it in place:
+		CMemoryMappedFile mapped_file(fil);  // raises an exception on error
+		TTextLineTokenizer s(mapped_file.begin(), mapped_file.end());
 
 		// -------------------------------------------
 		// 1st PASS: Read EQUIV entries only
@@ -280,18 +552,16 @@ struct graph_ops
 		// the lowest ID number.
 
 		// Read & process lines each at once until EOF:
-		istringstream s;
-		while (filParser.getNextLine(s))
+		string key;
+		while (s.getNextLine())
 		{
-			const unsigned int lineNum = filParser.getCurrentLineNumber();
-			const string lin = s.str();
+			const unsigned int lineNum = s.getCurrentLineNumber();
 
-			string key;
 			if (!(s >> key) || key.empty())
 				THROW_EXCEPTION(
 					format(
 						"Line %u: Can't read string for entry type in: '%s'",
-						lineNum, lin.c_str()));
+						lineNum, s.getLine().c_str()));
 
 			if (mrpt::system::strCmpI(key, "EQUIV"))
 			{
@@ -301,7 +571,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Can't read id1 & id2 in EQUIV line: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 				lstEquivs[std::max(id1, id2)] = std::min(id1, id2);
 			}
 		}  // end 1st pass
@@ -309,13 +579,12 @@ struct graph_ops
 		// -------------------------------------------
 		// 2nd PASS: Read all other entries
 		// -------------------------------------------
-		filParser.rewind();
+		s.rewind();
 
 		// Read & process lines each at once until EOF:
-		while (filParser.getNextLine(s))
+		while (s.getNextLine())
 		{
-			const unsigned int lineNum = filParser.getCurrentLineNumber();
-			const string lin = s.str();
+			const unsigned int lineNum = s.getCurrentLineNumber();
 
 			// Recognized strings:
 			//  VERTEX2 id x y phi
@@ -330,12 +599,11 @@ struct graph_ops
 			//  EDGE_SE3:QUAT from_id to_id Ax Ay Az qx qy qz qw inf_11 inf_12
 			//  .. inf_16 inf_22 .. inf_66
 			//  EQUIV id1 id2
-			string key;
 			if (!(s >> key) || key.empty())
 				THROW_EXCEPTION(
 					format(
 						"Line %u: Can't read string for entry type in: '%s'",
-						lineNum, lin.c_str()));
+						lineNum, s.getLine().c_str()));
 
 			if (strCmpI(key, "VERTEX2") || strCmpI(key, "VERTEX") ||
 				strCmpI(key, "VERTEX_SE2"))
@@ -346,7 +614,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing VERTEX2 line: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				// Make sure the node is new:
 				if (g->nodes.find(id) != g->nodes.end())
@@ -355,7 +623,7 @@ struct graph_ops
 							"Line %u: Error, duplicated verted ID %u in line: "
 							"'%s'",
 							lineNum, static_cast<unsigned int>(id),
-							lin.c_str()));
+							s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -382,7 +650,7 @@ struct graph_ops
 						format(
 							"Line %u: Try to load VERTEX3 into a 2D graph: "
 							"'%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				//  VERTEX3 id x y z roll pitch yaw
 				TNodeID id;
@@ -394,7 +662,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing VERTEX3 line: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				// Make sure the node is new:
 				if (g->nodes.find(id) != g->nodes.end())
@@ -403,7 +671,7 @@ struct graph_ops
 							"Line %u: Error, duplicated verted ID %u in line: "
 							"'%s'",
 							lineNum, static_cast<unsigned int>(id),
-							lin.c_str()));
+							s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -428,7 +696,7 @@ struct graph_ops
 						format(
 							"Line %u: Try to load VERTEX_SE3:QUAT into a 2D "
 							"graph: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				// VERTEX_SE3:QUAT id x y z qx qy qz qw
 				TNodeID id;
@@ -438,7 +706,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing VERTEX_SE3:QUAT line: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				// Make sure the node is new:
 				if (g->nodes.find(id) != g->nodes.end())
@@ -447,7 +715,7 @@ struct graph_ops
 							"Line %u: Error, duplicated verted ID %u in line: "
 							"'%s'",
 							lineNum, static_cast<unsigned int>(id),
-							lin.c_str()));
+							s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -483,7 +751,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing EDGE2 line: '%s'", lineNum,
-							lin.c_str()));
+							s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -509,7 +777,7 @@ struct graph_ops
 						THROW_EXCEPTION(
 							format(
 								"Line %u: Error parsing EDGE2 line: '%s'",
-								lineNum, lin.c_str()));
+								lineNum, s.getLine().c_str()));
 
 					// Complete low triangular part of inf matrix:
 					Ap_cov_inv(1, 0) = Ap_cov_inv(0, 1);
@@ -530,7 +798,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Try to load EDGE3 into a 2D graph: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				//  EDGE3 from_id to_id Ax Ay Az Aroll Apitch Ayaw inf_11 inf_12
 				//  .. inf_16 inf_22 .. inf_66
@@ -539,7 +807,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing EDGE3 line: '%s'", lineNum,
-							lin.c_str()));
+							s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -565,7 +833,7 @@ struct graph_ops
 						THROW_EXCEPTION(
 							format(
 								"Line %u: Error parsing EDGE3 line: '%s'",
-								lineNum, lin.c_str()));
+								lineNum, s.getLine().c_str()));
 
 					// **CAUTION** Indices are shuffled to the change YAW(3) <->
 					// ROLL(5) in the order of the data.
@@ -577,8 +845,8 @@ struct graph_ops
 						  Ap_cov_inv(1, 3) >> Ap_cov_inv(2, 2) >>
 						  Ap_cov_inv(2, 5) >> Ap_cov_inv(2, 4) >>
 						  Ap_cov_inv(2, 3) >> Ap_cov_inv(5, 5) >>
-						  Ap_cov_inv(5, 4) >> Ap_cov_inv(5, 3) >>
-						  Ap_cov_inv(4, 4) >> Ap_cov_inv(4, 3) >>
+						  Ap_cov_inv(4, 5) >> Ap_cov_inv(3, 5) >>
+						  Ap_cov_inv(4, 4) >> Ap_cov_inv(3, 4) >>
 						  Ap_cov_inv(3, 3)))
 					{
 						// Cov may be omitted in the file:
@@ -616,7 +884,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Try to load EDGE3 into a 2D graph: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				//  EDGE_SE3:QUAT from_id to_id Ax Ay Az qx qy qz qw inf_11
 				//  inf_12 .. inf_16 inf_22 .. inf_66
@@ -627,7 +895,7 @@ struct graph_ops
 					THROW_EXCEPTION(
 						format(
 							"Line %u: Error parsing EDGE_SE3:QUAT line: '%s'",
-							lineNum, lin.c_str()));
+							lineNum, s.getLine().c_str()));
 
 				// EQUIV? Replace ID by new one.
 				{
@@ -652,7 +920,7 @@ struct graph_ops
 							format(
 								"Line %u: Error parsing EDGE_SE3:QUAT line: "
 								"'%s'",
-								lineNum, lin.c_str()));
+								lineNum, s.getLine().c_str()));
 
 					// **CAUTION** Indices are shuffled to the change YAW(3) <->
 					// ROLL(5) in the order of the data.
@@ -664,8 +932,8 @@ struct graph_ops
 						  Ap_cov_inv(1, 3) >> Ap_cov_inv(2, 2) >>
 						  Ap_cov_inv(2, 5) >> Ap_cov_inv(2, 4) >>
 						  Ap_cov_inv(2, 3) >> Ap_cov_inv(5, 5) >>
-						  Ap_cov_inv(5, 4) >> Ap_cov_inv(5, 3) >>
-						  Ap_cov_inv(4, 4) >> Ap_cov_inv(4, 3) >>
+						  Ap_cov_inv(4, 5) >> Ap_cov_inv(3, 5) >>
+						  Ap_cov_inv(4, 4) >> Ap_cov_inv(3, 4) >>
 						  Ap_cov_inv(3, 3)))
 					{
 						// Cov may be omitted in the file:
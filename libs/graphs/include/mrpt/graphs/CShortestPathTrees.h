@@ -0,0 +1,353 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef MRPT_SHORTEST_PATH_TREES_H
+#define MRPT_SHORTEST_PATH_TREES_H
+
+#include <mrpt/graphs/CCompressedGraph.h>
+
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphs
+{
+/** \addtogroup mrpt_graphs_grp
+	@{ */
+
+/** A cache of Dijkstra shortest-path trees from several source nodes of a
+ * graph that grows over time, as the graphs of graph-SLAM do.
+ *
+ * Usage:
+ *  - Call update() each time the graph may have changed. Edges appended to
+ *    the graph since the last call are indexed (see CCompressedGraph) and the
+ *    cached trees are repaired instead of recomputed: appending edges can only
+ *    make distances shorter, so only the nodes whose distance decreases are
+ *    visited again. If edges were removed, or the graph object is a different
+ *    one, everything is rebuilt.
+ *  - Call computeTrees() with all the source nodes you are about to query.
+ *    Trees already in the cache are reused; the missing ones are computed in
+ *    a batch which shares the graph index and the edge weights.
+ *  - Query distances and paths with getDistance() and getShortestPath().
+ *
+ * Edges are traversed in both directions, as in CDijkstra. If there are
+ * several edges between two nodes, the one with the lowest weight is used.
+ *
+ * Edge weights are computed once per edge, when it is first seen, so the
+ * weight functor must only depend on the edge data, which must not change
+ * afterwards. Weights must not be negative. Without a functor, all edges
+ * weight the unity.
+ *
+ * The graph passed to update() must outlive this object (or until the next
+ * update() or clear()).
+ *
+ * \sa CDijkstra, CCompressedGraph
+ */
+template <class GRAPH_T>
+class CShortestPathTrees
+{
+   public:
+	/** @name Useful typedefs
+		@{ */
+	typedef GRAPH_T graph_t;
+	typedef typename graph_t::edge_t edge_t;
+	typedef CCompressedGraph<graph_t> compressed_graph_t;
+	/** A list of edges used to describe a path on the graph */
+	typedef std::list<TPairNodeIDs> edge_list_t;
+	typedef double (*functor_edge_weight_t)(
+		const graph_t& graph, const TNodeID id_from, const TNodeID id_to,
+		const edge_t& edge);
+	/** @} */
+
+	/** \param functor_edge_weight Weight of each edge, or nullptr for unit
+	 * weights.
+	 * \param max_trees Maximum number of trees to keep in the cache (0: no
+	 * limit). When exceeded, the least recently requested ones are dropped.
+	 */
+	explicit CShortestPathTrees(
+		functor_edge_weight_t functor_edge_weight = nullptr,
+		size_t max_trees = 0)
+		: m_functor_edge_weight(functor_edge_weight),
+		  m_max_trees(max_trees),
+		  m_use_counter(0)
+	{
+	}
+
+	/** Synchronizes the index and the cached trees with the graph.
+	 * \return false if nothing changed since the last call, true otherwise.
+	 */
+	bool update(const graph_t& graph)
+	{
+		if (&graph != m_cg.getGraph())
+		{
+			rebuild(graph);
+			return true;
+		}
+
+		// Look for edges we don't know about, and for removed ones:
+		std::vector<typename graph_t::const_iterator> new_edges;
+		size_t nKnown = 0;
+		for (auto it = graph.edges.begin(); it != graph.edges.end(); ++it)
+		{
+			if (m_known_edges.count(&(*it)))
+				nKnown++;
+			else
+				new_edges.push_back(it);
+		}
+		if (nKnown != m_cg.edgeCount())
+		{
+			rebuild(graph);
+			return true;
+		}
+		if (new_edges.empty()) return false;
+
+		const size_t old_nodes = m_cg.nodeCount(),
+					 old_edges = m_cg.edgeCount();
+		const TNodeID old_last_id =
+			old_nodes ? m_cg.nodeID(old_nodes - 1) : INVALID_NODEID;
+		for (const auto& it : new_edges)
+		{
+			m_cg.appendEdge(it);
+			m_known_edges.insert(&(*it));
+		}
+		m_cg.freeze();
+		appendWeights(old_edges);
+
+		// Node indices only change if new IDs were inserted between the
+		// existing ones. Then, just let the trees be computed again:
+		if (old_nodes && m_cg.nodeID(old_nodes - 1) != old_last_id)
+		{
+			m_trees.clear();
+			return true;
+		}
+
+		// Repair the trees: relax the new edges, then propagate the
+		// decreases through the graph.
+		const size_t nNodes = m_cg.nodeCount(), nEdges = m_cg.edgeCount();
+		for (auto& t : m_trees)
+		{
+			TTree& tree = t.second;
+			tree.dist.resize(nNodes, std::numeric_limits<double>::max());
+			tree.prev_edge.resize(nNodes, compressed_graph_t::INVALID_IDX);
+
+			heap_t heap;
+			for (size_t e = old_edges; e < nEdges; e++)
+			{
+				const std::pair<size_t, size_t>& en = m_cg.edgeNodes(e);
+				relax(tree, en.first, en.second, e, heap);
+				relax(tree, en.second, en.first, e, heap);
+			}
+			propagate(tree, heap);
+		}
+		return true;
+	}
+
+	/** Makes sure the trees from all the given sources are in the cache.
+	 * Sources not in the graph are ignored.
+	 * \sa update, getDistance, getShortestPath */
+	void computeTrees(const std::vector<TNodeID>& sources)
+	{
+		m_use_counter++;
+		for (const TNodeID src : sources)
+		{
+			const size_t src_idx = m_cg.nodeIndex(src);
+			if (src_idx == compressed_graph_t::INVALID_IDX) continue;
+
+			TTree& tree = m_trees[src];
+			tree.last_used = m_use_counter;
+			if (!tree.dist.empty()) continue;  // Already there
+
+			tree.dist.assign(
+				m_cg.nodeCount(), std::numeric_limits<double>::max());
+			tree.prev_edge.assign(
+				m_cg.nodeCount(), compressed_graph_t::INVALID_IDX);
+			tree.dist[src_idx] = 0;
+			heap_t heap;
+			heap.push(heap_entry_t(0, src_idx));
+			propagate(tree, heap);
+		}
+
+		// Drop the least recently used trees, but none of the requested ones:
+		while (m_max_trees && m_trees.size() > m_max_trees)
+		{
+			auto oldest = m_trees.begin();
+			for (auto it = m_trees.begin(); it != m_trees.end(); ++it)
+				if (it->second.last_used < oldest->second.last_used)
+					oldest = it;
+			if (oldest->second.last_used == m_use_counter) break;
+			m_trees.erase(oldest);
+		}
+	}
+	/** Whether the tree from the given source is in the cache */
+	bool hasTree(const TNodeID source) const
+	{
+		return m_trees.find(source) != m_trees.end();
+	}
+	/** Number of trees in the cache */
+	size_t getTreeCount() const { return m_trees.size(); }
+
+	/** @name Query the trees
+		@{ */
+
+	/** Distance between two nodes. Returns
+	 * std::numeric_limits<double>::max() if the target is not reachable.
+	 * \exception std::exception If the tree from source was not computed
+	 * \sa computeTrees */
+	double getDistance(const TNodeID source, const TNodeID target) const
+	{
+		const TTree& tree = getTree(source);
+		const size_t idx = m_cg.nodeIndex(target);
+		return idx == compressed_graph_t::INVALID_IDX
+				   ? std::numeric_limits<double>::max()
+				   : tree.dist[idx];
+	}
+	/** Shortest path between two nodes, as a list of arcs like
+	 * CDijkstra::getShortestPathTo returns: the first one contains the
+	 * source and the last one the target. The path is empty if both nodes
+	 * are the same.
+	 * \return false if the target is not reachable.
+	 * \exception std::exception If the tree from source was not computed
+	 * \sa computeTrees */
+	bool getShortestPath(
+		const TNodeID source, const TNodeID target,
+		edge_list_t& out_path) const
+	{
+		const TTree& tree = getTree(source);
+		out_path.clear();
+		size_t idx = m_cg.nodeIndex(target);
+		if (idx == compressed_graph_t::INVALID_IDX ||
+			tree.dist[idx] == std::numeric_limits<double>::max())
+			return false;
+
+		const size_t src_idx = m_cg.nodeIndex(source);
+		while (idx != src_idx)
+		{
+			const size_t e = tree.prev_edge[idx];
+			out_path.push_front(m_cg.edgeNodeIDs(e));
+			const std::pair<size_t, size_t>& en = m_cg.edgeNodes(e);
+			idx = (en.first == idx) ? en.second : en.first;
+		}
+		return true;
+	}
+	/** @} */
+
+	/** The index of the graph, as of the last update() */
+	const compressed_graph_t& getCompressedGraph() const { return m_cg; }
+	/** Drops the cached trees, but keeps the index of the graph */
+	void clearTrees() { m_trees.clear(); }
+	/** Drops everything: the next update() will index the graph again */
+	void clear()
+	{
+		m_cg.clear();
+		m_known_edges.clear();
+		m_weights.clear();
+		m_trees.clear();
+	}
+
+   private:
+	/** Distances and the edge towards the source of every node, indexed by
+	 * node index in m_cg */
+	struct TTree
+	{
+		std::vector<double> dist;
+		std::vector<size_t> prev_edge;
+		size_t last_used;
+	};
+	typedef std::pair<double, size_t> heap_entry_t;
+	typedef std::priority_queue<
+		heap_entry_t, std::vector<heap_entry_t>, std::greater<heap_entry_t>>
+		heap_t;
+
+	functor_edge_weight_t m_functor_edge_weight;
+	size_t m_max_trees;
+	size_t m_use_counter;
+
+	compressed_graph_t m_cg;
+	/** Addresses of the graph edges in m_cg */
+	std::unordered_set<const void*> m_known_edges;
+	/** Weight of each edge, by edge index in m_cg */
+	std::vector<double> m_weights;
+	std::map<TNodeID, TTree> m_trees;
+
+	void rebuild(const graph_t& graph)
+	{
+		clear();
+		m_cg.build(graph);
+		for (const auto& e : graph.edges) m_known_edges.insert(&e);
+		appendWeights(0);
+	}
+
+	void appendWeights(const size_t first_edge)
+	{
+		const graph_t& graph = *m_cg.getGraph();
+		m_weights.resize(m_cg.edgeCount(), 1.);
+		if (!m_functor_edge_weight) return;
+		for (size_t e = first_edge; e < m_cg.edgeCount(); e++)
+		{
+			const TPairNodeIDs& ids = m_cg.edgeNodeIDs(e);
+			m_weights[e] = (*m_functor_edge_weight)(
+				graph, ids.first, ids.second, m_cg.edgeValue(e));
+			ASSERTMSG_(m_weights[e] >= 0, "Negative edge weight");
+		}
+	}
+
+	const TTree& getTree(const TNodeID source) const
+	{
+		const auto it = m_trees.find(source);
+		if (it == m_trees.end())
+			THROW_EXCEPTION_FMT(
+				"No shortest-path tree from node_ID=%lu: call computeTrees() "
+				"first",
+				static_cast<unsigned long>(source));
+		return it->second;
+	}
+
+	void relax(
+		TTree& tree, const size_t from, const size_t to, const size_t edge,
+		heap_t& heap) const
+	{
+		if (from == to ||
+			tree.dist[from] == std::numeric_limits<double>::max())
+			return;
+		const double d = tree.dist[from] + m_weights[edge];
+		if (d < tree.dist[to])
+		{
+			tree.dist[to] = d;
+			tree.prev_edge[to] = edge;
+			heap.push(heap_entry_t(d, to));
+		}
+	}
+
+	/** Dijkstra's main loop, from the nodes in the heap */
+	void propagate(TTree& tree, heap_t& heap) const
+	{
+		while (!heap.empty())
+		{
+			const heap_entry_t top = heap.top();
+			heap.pop();
+			const size_t u = top.second;
+			if (top.first > tree.dist[u]) continue;  // Stale entry
+			for (auto adj = m_cg.adjacencyBegin(u),
+					  adj_end = m_cg.adjacencyEnd(u);
+				 adj != adj_end; ++adj)
+				relax(tree, u, adj->node, adj->edge, heap);
+		}
+	}
+};
+
+/** @} */
+}  // End of namespace
+}  // End of namespace
+#endif
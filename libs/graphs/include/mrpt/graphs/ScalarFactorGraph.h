@@ -12,7 +12,11 @@
 #include <mrpt/utils/types_math.h>
 #include <mrpt/utils/COutputLogger.h>
 #include <mrpt/utils/CTimeLogger.h>
+#include <mrpt/utils/pimpl.h>
+#include <mrpt/utils/TEnumType.h>
 #include <deque>
+#include <typeinfo>
+#include <type_traits>
 
 #include <mrpt/graphs/link_pragmas.h>
 
@@ -31,14 +35,22 @@ namespace graphs
  *  Assumptions/limitations:
  *   - Linear error functions (for now).
  *   - Scalar (1-dim) error functions.
- *   - Gaussian factors.
- *   - Solver: Eigen SparseQR.
+ *   - Gaussian factors, optionally down-weighted with a robust kernel.
+ *   - Solvers: Eigen SparseQR (default), sparse Cholesky or preconditioned
+ * conjugate gradient, see TSolverOptions.
  *
  *  Usage:
  *   - Call initialize() to set the number of nodes.
  *   - Call addConstraints() to insert constraints. This may be called more than
  * once.
- *   - Call updateEstimation() to run one step of the linear SparseQR solver.
+ *   - Call updateEstimation() to run one step of the linear solver.
+ *
+ *  The sparsity pattern of the system and its symbolic factorization are kept
+ * between calls to updateEstimation(), and are only rebuilt after adding or
+ * removing constraints (the pattern of the normal equations, used by the
+ * Cholesky and PCG solvers, only depends on binary constraints). Factors are
+ * evaluated grouped by type, in parallel for large graphs, and types
+ * registered with registerFactorType() are evaluated without virtual calls.
  *
  * \ingroup mrpt_graph_grp
  * \note [New in MRPT 1.5.0] Requires Eigen>=3.1
@@ -73,6 +85,126 @@ class GRAPHS_IMPEXP ScalarFactorGraph : public mrpt::utils::COutputLogger
 		virtual void evalJacobian(double& dr_dxi, double& dr_dxj) const = 0;
 	};
 
+	/** Linear solvers for updateEstimation() */
+	enum TSolverType
+	{
+		/** Sparse QR decomposition of the Jacobian (default) */
+		SOLVER_SPARSE_QR = 0,
+		/** Sparse Cholesky decomposition of the normal equations. Faster
+		 * than QR, but all nodes must be constrained. */
+		SOLVER_SPARSE_CHOLESKY,
+		/** Conjugate gradient on the normal equations, preconditioned with an
+		 * incomplete Cholesky factorization. Iterations start from the current
+		 * estimate (a null increment), thus they are few when new constraints
+		 * only change the solution locally. Intended for very large graphs
+		 * without variances, since computing them requires the sparse Cholesky
+		 * decomposition, which is then used to solve the system too. */
+		SOLVER_PCG
+	};
+
+	/** Robust kernels, to down-weight constraints with large errors (e.g.
+	 * outlier observations) */
+	enum TRobustKernel
+	{
+		ROBUST_KERNEL_NONE = 0,
+		/** Weight = 1 for errors up to `k` std. deviations, `k/|e|` above */
+		ROBUST_KERNEL_HUBER,
+		/** Weight = `1/(1+(e/k)^2)` */
+		ROBUST_KERNEL_CAUCHY
+	};
+
+	/** Parameters of updateEstimation() */
+	struct GRAPHS_IMPEXP TSolverOptions
+	{
+		TSolverOptions();
+
+		/** (Default: SOLVER_SPARSE_QR) */
+		TSolverType solver;
+		/** (Default: 0) Number of threads to evaluate the factors and build
+		 * the system (0: one per hardware thread). Small graphs always use
+		 * one thread. */
+		size_t num_threads;
+		/** [SOLVER_PCG] (Default: 1e-8) Relative tolerance of the residual */
+		double pcg_tolerance;
+		/** [SOLVER_PCG] (Default: 0) Maximum number of iterations (0: twice
+		 * the number of nodes) */
+		size_t pcg_max_iterations;
+		/** (Default: ROBUST_KERNEL_NONE) */
+		TRobustKernel robust_kernel;
+		/** (Default: 3.0) The parameter `k` of the robust kernel, in std.
+		 * deviations of each constraint */
+		double robust_kernel_param;
+	};
+
+	TSolverOptions solverOptions;
+
+	/** Signatures of the functions that evaluate the residuals, information
+	 * and Jacobians of `count` unary/binary factors of the same type */
+	typedef void (*unary_batch_evaluator_t)(
+		const UnaryFactorVirtualBase* const* factors, size_t count,
+		double* residuals, double* informations, double* dr_dx);
+	typedef void (*binary_batch_evaluator_t)(
+		const BinaryFactorVirtualBase* const* factors, size_t count,
+		double* residuals, double* informations, double* dr_dxi,
+		double* dr_dxj);
+
+	/** Batch evaluator of factors of type FACTOR, calling its methods
+	 * directly (without virtual calls) so they may be inlined. */
+	template <
+		class FACTOR,
+		bool IS_UNARY = std::is_base_of<UnaryFactorVirtualBase, FACTOR>::value>
+	struct TFactorBatchEvaluator
+	{
+		static void eval(
+			const UnaryFactorVirtualBase* const* factors, size_t count,
+			double* residuals, double* informations, double* dr_dx)
+		{
+			for (size_t k = 0; k < count; k++)
+			{
+				const FACTOR& f = static_cast<const FACTOR&>(*factors[k]);
+				residuals[k] = f.FACTOR::evaluateResidual();
+				informations[k] = f.FACTOR::getInformation();
+				f.FACTOR::evalJacobian(dr_dx[k]);
+			}
+		}
+	};
+	template <class FACTOR>
+	struct TFactorBatchEvaluator<FACTOR, false>
+	{
+		static void eval(
+			const BinaryFactorVirtualBase* const* factors, size_t count,
+			double* residuals, double* informations, double* dr_dxi,
+			double* dr_dxj)
+		{
+			for (size_t k = 0; k < count; k++)
+			{
+				const FACTOR& f = static_cast<const FACTOR&>(*factors[k]);
+				residuals[k] = f.FACTOR::evaluateResidual();
+				informations[k] = f.FACTOR::getInformation();
+				f.FACTOR::evalJacobian(dr_dxi[k], dr_dxj[k]);
+			}
+		}
+	};
+
+	/** Optional: lets factors whose dynamic type is exactly FACTOR be
+	 * evaluated with non-virtual calls. FACTOR must implement all the
+	 * methods of its base. Registrations are kept by clear(). */
+	template <class FACTOR>
+	void registerFactorType()
+	{
+		static_assert(
+			std::is_base_of<UnaryFactorVirtualBase, FACTOR>::value ||
+				std::is_base_of<BinaryFactorVirtualBase, FACTOR>::value,
+			"FACTOR must derive from UnaryFactorVirtualBase or "
+			"BinaryFactorVirtualBase");
+		registerFactorType(
+			typeid(FACTOR), &TFactorBatchEvaluator<FACTOR>::eval);
+	}
+	void registerFactorType(
+		const std::type_info& type, unary_batch_evaluator_t evaluator);
+	void registerFactorType(
+		const std::type_info& type, binary_batch_evaluator_t evaluator);
+
 	/** Reset state: remove all constraints and nodes. */
 	void clear();
 
@@ -87,6 +219,8 @@ class GRAPHS_IMPEXP ScalarFactorGraph : public mrpt::utils::COutputLogger
 	 * being responsability of the caller. This is
 	  * done such that arrays/vectors of constraints can be more efficiently
 	 * allocated if their type is known at build time.
+	  * The node indices of a constraint must not change while it is in the
+	 * graph, since they define the cached sparsity pattern of the system.
 	  */
 	void addConstraint(const UnaryFactorVirtualBase& listOfConstraints);
 	void addConstraint(const BinaryFactorVirtualBase& listOfConstraints);
@@ -94,8 +228,8 @@ class GRAPHS_IMPEXP ScalarFactorGraph : public mrpt::utils::COutputLogger
 	/** Removes a constraint. Return true if found and deleted correctly. */
 	bool eraseConstraint(const FactorBase& c);
 
-	void clearAllConstraintsByType_Unary() { m_factors_unary.clear(); }
-	void clearAllConstraintsByType_Binary() { m_factors_binary.clear(); }
+	void clearAllConstraintsByType_Unary();
+	void clearAllConstraintsByType_Binary();
 	void updateEstimation(
 		/** Output increment of the current estimate. Caller must add this
 		   vector to current state vector to obtain the optimal estimation. */
@@ -105,6 +239,9 @@ class GRAPHS_IMPEXP ScalarFactorGraph : public mrpt::utils::COutputLogger
 
 	bool isProfilerEnabled() const { return m_enable_profiler; }
 	void enableProfiler(bool enable = true) { m_enable_profiler = enable; }
+	/** Internal: cached patterns, factorizations and factor evaluations */
+	struct TSolverData;
+
    private:
 	/** number of nodes in the graph */
 	size_t m_numNodes;
@@ -112,10 +249,48 @@ class GRAPHS_IMPEXP ScalarFactorGraph : public mrpt::utils::COutputLogger
 	std::deque<const UnaryFactorVirtualBase*> m_factors_unary;
 	std::deque<const BinaryFactorVirtualBase*> m_factors_binary;
 
+	PIMPL_DECLARE_TYPE(TSolverData, m_solver_data);
+
 	mrpt::utils::CTimeLogger m_timelogger;
 	bool m_enable_profiler;
 
 };  // End of class def.
 
+}  // End of namespace
+
+// Specializations MUST occur at the same namespace:
+namespace utils
+{
+template <>
+struct TEnumTypeFiller<graphs::ScalarFactorGraph::TSolverType>
+{
+	typedef graphs::ScalarFactorGraph::TSolverType enum_t;
+	static void fill(bimap<enum_t, std::string>& m_map)
+	{
+		m_map.insert(
+			graphs::ScalarFactorGraph::SOLVER_SPARSE_QR, "SOLVER_SPARSE_QR");
+		m_map.insert(
+			graphs::ScalarFactorGraph::SOLVER_SPARSE_CHOLESKY,
+			"SOLVER_SPARSE_CHOLESKY");
+		m_map.insert(graphs::ScalarFactorGraph::SOLVER_PCG, "SOLVER_PCG");
+	}
+};
+template <>
+struct TEnumTypeFiller<graphs::ScalarFactorGraph::TRobustKernel>
+{
+	typedef graphs::ScalarFactorGraph::TRobustKernel enum_t;
+	static void fill(bimap<enum_t, std::string>& m_map)
+	{
+		m_map.insert(
+			graphs::ScalarFactorGraph::ROBUST_KERNEL_NONE,
+			"ROBUST_KERNEL_NONE");
+		m_map.insert(
+			graphs::ScalarFactorGraph::ROBUST_KERNEL_HUBER,
+			"ROBUST_KERNEL_HUBER");
+		m_map.insert(
+			graphs::ScalarFactorGraph::ROBUST_KERNEL_CAUCHY,
+			"ROBUST_KERNEL_CAUCHY");
+	}
+};
 }  // End of namespace
 }  // End of namespace
@@ -0,0 +1,238 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef TTEXTLINETOKENIZER_H
+#define TTEXTLINETOKENIZER_H
+
+#include <cstdint>
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <string>
+
+namespace mrpt
+{
+namespace graphs
+{
+namespace detail
+{
+/** Reads the lines of a text file held in memory (typically, mapped with
+ * mrpt::utils::CMemoryMappedFile) and the whitespace-separated fields of
+ * each line.
+ *
+ * Lines are filtered as mrpt::utils::CTextFileLinesParser does: empty lines
+ * and lines starting with "#", "//" or "%" are skipped. Fields are read with
+ * the operators >>, which behave like those of a std::istringstream with
+ * the line contents (including the "fail" state, which is cleared by
+ * getNextLine()), but numbers are parsed in place, without any copy, stream
+ * or locale overhead. Decimal numbers with up to 15 significant digits and
+ * small exponents (the usual case) are converted exactly; any other number
+ * is handed to std::istream.
+ *
+ * \ingroup mrpt_graphs_grp
+ */
+class TTextLineTokenizer
+{
+   public:
+	TTextLineTokenizer(const char* begin, const char* end)
+		: m_begin(begin), m_end(end)
+	{
+		rewind();
+	}
+
+	/** Go back to the beginning of the text */
+	void rewind()
+	{
+		m_next_line = m_begin;
+		m_line_begin = m_line_end = m_pos = m_begin;
+		m_line_num = 0;
+		m_fail = true;
+	}
+
+	/** Moves to the next non-empty and non-comment line.
+	 * \return false on EOF. */
+	bool getNextLine()
+	{
+		while (m_next_line < m_end)
+		{
+			const char* eol = static_cast<const char*>(
+				memchr(m_next_line, '\n', m_end - m_next_line));
+			if (!eol) eol = m_end;
+			m_line_num++;
+			m_line_begin = m_next_line;
+			m_line_end = eol;
+			m_next_line = eol + 1;
+
+			// trim:
+			while (m_line_begin < m_line_end && isSpace(*m_line_begin))
+				m_line_begin++;
+			while (m_line_end > m_line_begin && isSpace(m_line_end[-1]))
+				m_line_end--;
+			if (m_line_begin == m_line_end) continue;  // Empty line
+			const char c = *m_line_begin;
+			if (c == '#' || c == '%' ||
+				(c == '/' && m_line_end - m_line_begin > 1 &&
+				 m_line_begin[1] == '/'))
+				continue;  // Comment line
+
+			m_pos = m_line_begin;
+			m_fail = false;
+			return true;
+		}
+		m_line_begin = m_line_end = m_pos = m_end;
+		m_fail = true;
+		return false;
+	}
+
+	/** Number of the current line (the first one is 1) */
+	size_t getCurrentLineNumber() const { return m_line_num; }
+	/** The current line, without leading nor trailing whitespaces */
+	std::string getLine() const
+	{
+		return std::string(m_line_begin, m_line_end);
+	}
+
+	/** Whether all the reads since the last getNextLine() succeeded */
+	explicit operator bool() const { return !m_fail; }
+	bool operator!() const { return m_fail; }
+	TTextLineTokenizer& operator>>(std::string& s)
+	{
+		const char *tok, *tok_end;
+		if (nextToken(tok, tok_end)) s.assign(tok, tok_end);
+		return *this;
+	}
+	TTextLineTokenizer& operator>>(uint64_t& v)
+	{
+		const char *tok, *tok_end;
+		if (!nextToken(tok, tok_end)) return *this;
+		if (*tok == '+') tok++;
+		uint64_t val = 0;
+		const char* p = tok;
+		for (; p < tok_end && isDigit(*p); p++)
+		{
+			const uint64_t d = *p - '0';
+			if (val > (UINT64_MAX - d) / 10) break;  // overflow
+			val = val * 10 + d;
+		}
+		if (p == tok || p != tok_end)
+			m_fail = true;
+		else
+			v = val;
+		return *this;
+	}
+	TTextLineTokenizer& operator>>(double& v)
+	{
+		const char *tok, *tok_end;
+		if (!nextToken(tok, tok_end)) return *this;
+		if (!parseDecimal(tok, tok_end, v))
+		{
+			std::istringstream ss(std::string(tok, tok_end));
+			ss.imbue(std::locale::classic());
+			if (!(ss >> v)) m_fail = true;
+		}
+		return *this;
+	}
+
+   private:
+	const char *m_begin, *m_end;
+	const char *m_next_line, *m_line_begin, *m_line_end, *m_pos;
+	size_t m_line_num;
+	bool m_fail;
+
+	static bool isSpace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+	static bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+	bool nextToken(const char*& tok, const char*& tok_end)
+	{
+		if (m_fail) return false;
+		while (m_pos < m_line_end && isSpace(*m_pos)) m_pos++;
+		if (m_pos == m_line_end)
+		{
+			m_fail = true;
+			return false;
+		}
+		tok = m_pos;
+		while (m_pos < m_line_end && !isSpace(*m_pos)) m_pos++;
+		tok_end = m_pos;
+		return true;
+	}
+
+	/** Parses [+-]digits[.digits][(e|E)[+-]digits] if the result is exact,
+	 * that is, the mantissa fits in a double and 10^exponent too.
+	 * \return false if the token is anything else */
+	static bool parseDecimal(const char* p, const char* end, double& v)
+	{
+		static const double pow10[] = {
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+			1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+			1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+		const bool neg = (*p == '-');
+		if (*p == '-' || *p == '+') p++;
+
+		uint64_t mantissa = 0;
+		int nDigits = 0, exponent = 0;
+		bool any_digit = false;
+		for (; p < end && isDigit(*p); p++)
+		{
+			any_digit = true;
+			if (mantissa == 0 && *p == '0') continue;  // leading zeros
+			mantissa = mantissa * 10 + (*p - '0');
+			if (++nDigits > 15) return false;
+		}
+		if (p < end && *p == '.')
+		{
+			for (p++; p < end && isDigit(*p); p++)
+			{
+				any_digit = true;
+				exponent--;
+				if (mantissa == 0 && *p == '0') continue;
+				mantissa = mantissa * 10 + (*p - '0');
+				if (++nDigits > 15) return false;
+			}
+		}
+		if (!any_digit) return false;
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			p++;
+			const bool exp_neg = (p < end && *p == '-');
+			if (p < end && (*p == '-' || *p == '+')) p++;
+			if (p == end) return false;
+			int e = 0;
+			for (; p < end && isDigit(*p); p++)
+			{
+				e = e * 10 + (*p - '0');
+				if (e > 1000) return false;
+			}
+			exponent += exp_neg ? -e : e;
+		}
+		if (p != end) return false;
+
+		// Both the mantissa (<10^15) and 10^|exponent| are exact doubles,
+		// thus the result of one multiplication/division is correctly
+		// rounded:
+		double d = static_cast<double>(mantissa);
+		if (mantissa != 0)
+		{
+			if (exponent < -22 || exponent > 22) return false;
+			if (exponent < 0)
+				d /= pow10[-exponent];
+			else
+				d *= pow10[exponent];
+		}
+		v = neg ? -d : d;
+		return true;
+	}
+};
+
+}  // end namespace
+}  // end namespace
+}  // end namespace
+
+#endif
@@ -11,12 +11,14 @@
 
 #include <mrpt/graphs/CDirectedGraph.h>
 #include <mrpt/graphs/CDirectedTree.h>
+#include <mrpt/graphs/CCompressedGraph.h>
 #include <mrpt/utils/traits_map.h>
 #include <mrpt/math/utils.h>
 
 #include <limits>
 #include <iostream>  // TODO - remove me
 #include <vector>
+#include <queue>
 #include <utility>
 #include <exception>
 
@@ -89,6 +91,12 @@ class NotConnectedGraph : public std::exception
  *  implementation which is much faster, but can be only used if the
  *  TNodeID's start in 0 or a low value.
  *
+ *  Internally, the graph is indexed with a mrpt::graphs::CCompressedGraph
+ *  and the search uses a binary heap, for a cost of O((N+E) log N). When
+ *  running Dijkstra several times on the same graph, build the
+ *  CCompressedGraph once and pass it to the constructor instead of the
+ *  graph.
+ *
  * See <a
  * href="http://www.mrpt.org/Example:Dijkstra_optimal_path_search_in_graphs"
  * > this page </a> for a complete example.
@@ -140,12 +148,12 @@ class CDijkstra
 	// Intermediary and final results:
 	/** All the distances */
 	id2dist_map_t m_distances;
-	std::map<TNodeID, TDistance>
-		m_distances_non_visited;  // Use a std::map here in all cases.
 	id2id_map_t m_prev_node;
 	id2pairIDs_map_t m_prev_arc;
 	std::set<TNodeID> m_lstNode_IDs;
-	list_all_neighbors_t m_allNeighbors;
+	/** Only computed upon request: see getCachedAdjacencyMatrix() */
+	mutable list_all_neighbors_t m_allNeighbors;
+	mutable bool m_allNeighbors_computed = false;
 
    public:
 	/** @name Useful typedefs
@@ -158,6 +166,8 @@ class CDijkstra
 	typedef typename graph_t::edge_t edge_t;
 	/** A list of edges used to describe a path on the graph */
 	typedef std::list<TPairNodeIDs> edge_list_t;
+	/** The compressed (CSR) index of graph_t used internally */
+	typedef CCompressedGraph<graph_t> compressed_graph_t;
 
 	/** @} */
 
@@ -186,6 +196,40 @@ class CDijkstra
 		void (*functor_on_progress)(const graph_t& graph, size_t visitedCount) =
 			nullptr)
 		: m_cached_graph(graph), m_source_node_ID(source_node_ID)
+	{
+		const compressed_graph_t compressed(graph);
+		run(compressed, functor_edge_weight, functor_on_progress);
+	}
+
+	/** Like the constructor above, but reusing a CCompressedGraph index of
+	 * the graph. Useful to run Dijkstra several times on the same graph,
+	 * since building the index is the most expensive part of the
+	 * algorithm. The index must be frozen and the graph it was built from
+	 * must outlive this object. */
+	CDijkstra(
+		const compressed_graph_t& compressed_graph,
+		const TNodeID source_node_ID,
+		double (*functor_edge_weight)(
+			const graph_t& graph, const TNodeID id_from, const TNodeID id_to,
+			const edge_t& edge) = nullptr,
+		void (*functor_on_progress)(const graph_t& graph, size_t visitedCount) =
+			nullptr)
+		: m_cached_graph(*compressed_graph.getGraph()),
+		  m_source_node_ID(source_node_ID)
+	{
+		ASSERTMSG_(
+			compressed_graph.isFrozen(),
+			"The CCompressedGraph must be frozen before running Dijkstra");
+		run(compressed_graph, functor_edge_weight, functor_on_progress);
+	}
+
+   protected:
+	void run(
+		const compressed_graph_t& cg,
+		double (*functor_edge_weight)(
+			const graph_t& graph, const TNodeID id_from, const TNodeID id_to,
+			const edge_t& edge),
+		void (*functor_on_progress)(const graph_t& graph, size_t visitedCount))
 	{
 		/*
 		1  function Dijkstra(G, w, s)
@@ -206,103 +250,49 @@ class CDijkstra
 		13                        m_distances[v] := m_distances[u] + w(u,v)
 		14                        m_prev_node[v] := u
 		*/
-
-		// Make a list of all the nodes in the graph:
-		graph.getAllNodes(m_lstNode_IDs);
+		const graph_t& graph = m_cached_graph;
+		const size_t INVALID_IDX = compressed_graph_t::INVALID_IDX;
+
+		// Make a list of all the nodes in the edges of the graph:
+		const size_t nAllNodes = cg.nodeCount();
+		for (size_t i = 0; i < nAllNodes; i++)
+			if (cg.degree(i) > 0)
+				m_lstNode_IDs.insert(m_lstNode_IDs.end(), cg.nodeID(i));
 		const size_t nNodes = m_lstNode_IDs.size();
 
-		if (m_lstNode_IDs.find(source_node_ID) == m_lstNode_IDs.end())
+		const size_t source_idx = cg.nodeIndex(m_source_node_ID);
+		if (source_idx == INVALID_IDX || cg.degree(source_idx) == 0)
 		{
 			THROW_EXCEPTION_FMT(
 				"Cannot find the source node_ID=%lu in the graph",
-				static_cast<unsigned long>(source_node_ID));
+				static_cast<unsigned long>(m_source_node_ID));
 		}
 
-		// Init:
-		// m_distances: already initialized to infinity by default.
-		// m_prev_node: idem
-		// m_prev_arc: idem
-		// m_visited: idem
-		size_t visitedCount = 0;
-		m_distances[source_node_ID] = 0;
-		m_distances_non_visited[source_node_ID] = 0;
-
-		// Precompute all neighbors of all the nodes in the given graph:
-		graph.getAdjacencyMatrix(m_allNeighbors);
-
-		using namespace std;
-
-		TNodeID u;
-		// as long as there are nodes not yet visited.
-		do
-		{  // The algorithm:
-			// Find the nodeID with the minimum known distance so far
-			// considered:
-			double min_d = std::numeric_limits<double>::max();
-			u = INVALID_NODEID;
-
-			// No need to check if the min. distance node is not visited yet,
-			// since we
-			// keep two lists: m_distances_non_visited & m_distances
-			for (typename std::map<TNodeID, TDistance>::const_iterator itDist =
-					 m_distances_non_visited.begin();
-				 itDist != m_distances_non_visited.end(); ++itDist)
-			{
-				// TODO - remove these
-				// cout << "Current min distance: " << min_d << endl;
-				// cout << "itDist->first: " << itDist->first << endl;
-				// cout << "itDist->second (distance to this node): " <<
-				// itDist->second.dist << endl;
-
-				if (itDist->second.dist < min_d)
-				{
-					u = itDist->first;
-					min_d = itDist->second.dist;
-					// cout << "updating u, min_d... " << endl;
-				}
-				// cout << "finished for." << endl;
-			}
-
-			// make sure we have found the next nodeID from the available
-			// non-visited distances
-			if (u == INVALID_NODEID)
-			{
-				std::set<TNodeID> nodeIDs_unconnected;
-
-				// for all the nodes in the graph
-				for (typename TYPE_GRAPH::global_poses_t::const_iterator n_it =
-						 graph.nodes.begin();
-					 n_it != graph.nodes.end(); ++n_it)
-				{
-					// have I already visited this node in Dijkstra?
-					bool have_traversed = false;
-					for (typename id2dist_map_t::const_iterator d_it =
-							 m_distances.begin();
-						 d_it != m_distances.end(); ++d_it)
-					{
-						if (n_it->first == d_it->first)
-						{
-							have_traversed = true;
-							break;
-						}
-					}
-
-					if (!have_traversed)
-					{
-						nodeIDs_unconnected.insert(n_it->first);
-					}
-				}
+		// Work with dense arrays indexed by the node index in "cg", and a
+		// binary heap of (distance,index) pairs with lazy deletion. Ties are
+		// resolved in favor of the lowest node ID.
+		std::vector<double> dist(nAllNodes, std::numeric_limits<double>::max());
+		std::vector<size_t> prev_edge(nAllNodes, INVALID_IDX);
+		std::vector<char> visited(nAllNodes, 0);
+		typedef std::pair<double, size_t> heap_entry_t;
+		std::priority_queue<
+			heap_entry_t, std::vector<heap_entry_t>,
+			std::greater<heap_entry_t>>
+			non_visited;
 
-				std::string err_str =
-					mrpt::format("Graph is not fully connected!");
-				throw mrpt::graphs::detail::NotConnectedGraph(
-					nodeIDs_unconnected, err_str);
-			}
+		size_t visitedCount = 0;
+		dist[source_idx] = 0;
+		non_visited.push(heap_entry_t(0, source_idx));
 
-			// Update distance (for possible future reference...) and remove
-			// this node from "non-visited":
-			m_distances[u] = m_distances_non_visited[u];
-			m_distances_non_visited.erase(u);
+		while (!non_visited.empty())
+		{
+			// Find the node with the minimum known distance so far:
+			const heap_entry_t top = non_visited.top();
+			non_visited.pop();
+			const size_t u = top.second;
+			if (visited[u] || top.first > dist[u]) continue;  // Stale entry
+			visited[u] = 1;
+			const double min_d = dist[u];
 
 			visitedCount++;
 
@@ -310,70 +300,64 @@ class CDijkstra
 			if (functor_on_progress)
 				(*functor_on_progress)(graph, visitedCount);
 
-			// For each arc from "u":
-			const std::set<TNodeID>& neighborsOfU =
-				m_allNeighbors[u];  // graph.getNeighborsOf(u,neighborsOfU);
-			for (std::set<TNodeID>::const_iterator itNei = neighborsOfU.begin();
-				 itNei != neighborsOfU.end(); ++itNei)
+			// For each neighbor of "u". Its first adjacency entry is the
+			// edge u->i (or i->u, if there is none) to use:
+			for (auto adj = cg.adjacencyBegin(u), adj_end = cg.adjacencyEnd(u);
+				 adj != adj_end;)
 			{
-				const TNodeID i = *itNei;
+				const size_t i = adj->node, edge_ui = adj->edge;
+				while (adj != adj_end && adj->node == i) ++adj;
 				if (i == u) continue;  // ignore self-loops...
 
-				// the "edge_ui" may be searched here or a bit later, so the
-				// "bool" var will tell us.
-				typename graph_t::const_iterator edge_ui;
-				bool edge_ui_reverse = false;
-				bool edge_ui_found = false;
-
 				// Get weight of edge u<->i
 				double edge_ui_weight;
 				if (!functor_edge_weight)
 					edge_ui_weight = 1.;
 				else
-				{  // edge may be i->u or u->i:
-					edge_ui = graph.edges.find(std::make_pair(u, i));
-					if (edge_ui == graph.edges.end())
-					{
-						edge_ui = graph.edges.find(std::make_pair(i, u));
-						edge_ui_reverse = true;
-					}
-					ASSERT_(edge_ui != graph.edges.end());
+				{
+					const TPairNodeIDs& ids = cg.edgeNodeIDs(edge_ui);
 					edge_ui_weight = (*functor_edge_weight)(
-						graph, edge_ui->first.first, edge_ui->first.second,
-						edge_ui->second);
-					edge_ui_found = true;
+						graph, ids.first, ids.second, cg.edgeValue(edge_ui));
 				}
 
-				if ((min_d + edge_ui_weight) < m_distances[i].dist)
-				{  // the [] creates the entry if needed
-					// update m_distances, m_distances_non_visited
-					m_distances_non_visited[i].dist = min_d + edge_ui_weight;
-					m_distances[i].dist = min_d + edge_ui_weight;
-
-					m_prev_node[i].id = u;
-					// If still not done above, detect the direction of the arc
-					// now:
-					if (!edge_ui_found)
-					{
-						edge_ui = graph.edges.find(std::make_pair(u, i));
-						if (edge_ui == graph.edges.end())
-						{
-							edge_ui = graph.edges.find(std::make_pair(i, u));
-							edge_ui_reverse = true;
-						}
-						ASSERT_(edge_ui != graph.edges.end());
-					}
-
-					if (!edge_ui_reverse)
-						m_prev_arc[i] = std::make_pair(u, i);  // *u -> *i
-					else
-						m_prev_arc[i] = std::make_pair(i, u);  // *i -> *u
+				if ((min_d + edge_ui_weight) < dist[i])
+				{
+					dist[i] = min_d + edge_ui_weight;
+					prev_edge[i] = edge_ui;
+					non_visited.push(heap_entry_t(dist[i], i));
 				}
 			}
-		} while (visitedCount < nNodes);
+		}
+
+		if (visitedCount < nNodes)
+		{
+			std::set<TNodeID> nodeIDs_unconnected;
+			for (size_t i = 0; i < nAllNodes; i++)
+				if (!visited[i])
+					nodeIDs_unconnected.insert(
+						nodeIDs_unconnected.end(), cg.nodeID(i));
+
+			std::string err_str = mrpt::format("Graph is not fully connected!");
+			throw mrpt::graphs::detail::NotConnectedGraph(
+				nodeIDs_unconnected, err_str);
+		}
 
+		// Save the results:
+		for (size_t i = 0; i < nAllNodes; i++)
+		{
+			if (!visited[i]) continue;
+			const TNodeID id = cg.nodeID(i);
+			m_distances[id] = dist[i];
+			if (i == source_idx) continue;
+
+			const TPairNodeIDs& arc = cg.edgeNodeIDs(prev_edge[i]);
+			m_prev_node[id].id = (arc.first == id) ? arc.second : arc.first;
+			m_prev_arc[id] = arc;
+		}
 	}  // end Dijkstra
 
+   public:
+
 	/** @name Query Dijkstra results
 	  @{ */
 
@@ -400,14 +384,19 @@ class CDijkstra
 
 	/** Return the node ID of the tree root, as passed in the constructor */
 	inline TNodeID getRootNodeID() const { return m_source_node_ID; }
-	/** Return the adjacency matrix of the input graph, which is cached at
-	 * construction so if needed later just use this copy to avoid
-	 * recomputing it
+	/** Return the adjacency matrix of the input graph. It is computed in the
+	 * first call and cached, so if needed later just use this copy to avoid
+	 * recomputing it.
 	 *
 	 * \sa  mrpt::graphs::CDirectedGraph::getAdjacencyMatrix
 	 * */
 	inline const list_all_neighbors_t& getCachedAdjacencyMatrix() const
 	{
+		if (!m_allNeighbors_computed)
+		{
+			m_cached_graph.getAdjacencyMatrix(m_allNeighbors);
+			m_allNeighbors_computed = true;
+		}
 		return m_allNeighbors;
 	}
 
@@ -0,0 +1,208 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/graphs/CCompressedGraph.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace mrpt::utils;
+using namespace std;
+
+typedef CNetworkOfPoses2D graph_t;
+typedef CCompressedGraph<graph_t> compressed_t;
+typedef CDijkstra<graph_t> dijkstra_t;
+
+static double edge_length(
+	const graph_t&, const TNodeID, const TNodeID, const graph_t::edge_t& edge)
+{
+	return edge.norm();
+}
+
+// Random graph with node IDs 10, 10+step, 10+2*step... : a chain plus random
+// links in both directions. Each pair of nodes has at most one edge.
+static void create_graph(
+	graph_t& graph, const size_t N, const size_t nLinks,
+	const TNodeID step = 2)
+{
+	auto& rnd = mrpt::random::randomGenerator;
+	graph.clear();
+	graph.root = 10;
+	set<pair<TNodeID, TNodeID>> used;
+	auto add = [&](TNodeID a, TNodeID b) {
+		if (a == b || !used.insert(make_pair(min(a, b), max(a, b))).second)
+			return;
+		graph.insertEdge(
+			a, b, CPose2D(
+					  rnd.drawUniform(0.1, 2.0), rnd.drawUniform(-1, 1), 0));
+	};
+	for (size_t i = 0; i < N; i++) graph.nodes[10 + step * i] = CPose2D();
+	for (size_t i = 1; i < N; i++) add(10 + step * (i - 1), 10 + step * i);
+	for (size_t k = 0; k < nLinks; k++)
+		add(10 + step * (rnd.drawUniform32bit() % N),
+			10 + step * (rnd.drawUniform32bit() % N));
+}
+
+TEST(CCompressedGraph, build)
+{
+	mrpt::random::randomGenerator.randomize(1);
+	graph_t graph;
+	create_graph(graph, 50, 40);
+	graph.nodes[1000] = CPose2D();  // A node with no edges
+
+	const compressed_t cg(graph);
+	EXPECT_TRUE(cg.isFrozen());
+	EXPECT_EQ(cg.nodeCount(), graph.nodes.size());
+	EXPECT_EQ(cg.edgeCount(), graph.edges.size());
+	EXPECT_EQ(cg.degree(cg.nodeIndex(1000)), 0U);
+	EXPECT_EQ(cg.nodeIndex(11), compressed_t::INVALID_IDX);
+
+	size_t sum_degrees = 0;
+	for (size_t i = 0; i < cg.nodeCount(); i++)
+	{
+		sum_degrees += cg.degree(i);
+		for (auto a = cg.adjacencyBegin(i); a != cg.adjacencyEnd(i); ++a)
+		{
+			const TPairNodeIDs& ids = cg.edgeNodeIDs(a->edge);
+			EXPECT_EQ(ids.first, cg.nodeID(a->reverse ? a->node : i));
+			EXPECT_EQ(ids.second, cg.nodeID(a->reverse ? i : a->node));
+			EXPECT_EQ(
+				&cg.edgeValue(a->edge), &graph.getEdge(ids.first, ids.second));
+		}
+	}
+	EXPECT_EQ(sum_degrees, 2 * graph.edges.size());
+}
+
+TEST(CCompressedGraph, dijkstra)
+{
+	mrpt::random::randomGenerator.randomize(2);
+	graph_t graph;
+	create_graph(graph, 80, 60);
+
+	const dijkstra_t dij(graph, graph.root, &edge_length);
+
+	// Bellman-Ford, as ground truth:
+	map<TNodeID, double> dist;
+	for (const auto& n : graph.nodes)
+		dist[n.first] = std::numeric_limits<double>::max();
+	dist[graph.root] = 0;
+	for (size_t iter = 0; iter < graph.nodes.size(); iter++)
+		for (const auto& e : graph.edges)
+		{
+			const double w = e.second.norm();
+			const TNodeID a = e.first.first, b = e.first.second;
+			if (dist[a] + w < dist[b]) dist[b] = dist[a] + w;
+			if (dist[b] + w < dist[a]) dist[a] = dist[b] + w;
+		}
+
+	for (const auto& n : graph.nodes)
+	{
+		EXPECT_NEAR(dij.getNodeDistanceToRoot(n.first), dist[n.first], 1e-9);
+
+		// The path must be made of existing edges, and add up to the
+		// distance:
+		dijkstra_t::edge_list_t path;
+		dij.getShortestPathTo(n.first, path);
+		double len = 0;
+		TNodeID cur = graph.root;
+		for (const auto& arc : path)
+		{
+			ASSERT_TRUE(arc.first == cur || arc.second == cur);
+			cur = (arc.first == cur) ? arc.second : arc.first;
+			len += graph.getEdge(arc.first, arc.second).norm();
+		}
+		EXPECT_EQ(cur, n.first);
+		EXPECT_NEAR(len, dist[n.first], 1e-9);
+	}
+
+	// Unconnected graphs:
+	graph.insertEdge(2000, 2001, CPose2D(1, 0, 0));
+	EXPECT_THROW(
+		dijkstra_t(graph, graph.root), mrpt::graphs::detail::NotConnectedGraph);
+}
+
+TEST(CCompressedGraph, append_and_freeze)
+{
+	mrpt::random::randomGenerator.randomize(3);
+	graph_t full_graph;
+	create_graph(full_graph, 60, 50);
+
+	// Build from the first half of the edges, then append the rest, with
+	// new node IDs both at the end and in between the existing ones:
+	graph_t graph;
+	graph.root = full_graph.root;
+	auto it = full_graph.edges.begin();
+	for (size_t i = 0; i < full_graph.edges.size() / 2; i++, ++it)
+		graph.edges.insert(*it);
+	compressed_t cg(graph);
+	for (; it != full_graph.edges.end(); ++it)
+	{
+		cg.appendEdge(graph.edges.insert(*it));
+		EXPECT_FALSE(cg.isFrozen());
+	}
+	graph.insertEdge(11, 10, CPose2D(1, 0, 0));
+	cg.appendEdge(graph.edges.find(make_pair(11, 10)));
+	cg.freeze();
+	ASSERT_TRUE(cg.isFrozen());
+	EXPECT_EQ(cg.edgeCount(), graph.edges.size());
+
+	const compressed_t cg_ref(graph);
+	ASSERT_EQ(cg.nodeCount(), cg_ref.nodeCount());
+	for (size_t i = 0; i < cg.nodeCount(); i++)
+	{
+		ASSERT_EQ(cg.nodeID(i), cg_ref.nodeID(i));
+		ASSERT_EQ(cg.degree(i), cg_ref.degree(i));
+		for (auto a = cg.adjacencyBegin(i), b = cg_ref.adjacencyBegin(i);
+			 a != cg.adjacencyEnd(i); ++a, ++b)
+		{
+			EXPECT_EQ(a->node, b->node);
+			EXPECT_EQ(a->reverse, b->reverse);
+			EXPECT_EQ(&cg.edgeValue(a->edge), &cg_ref.edgeValue(b->edge));
+		}
+	}
+
+	// Same results from the graph and from the compressed index:
+	const dijkstra_t dij1(graph, graph.root, &edge_length);
+	const dijkstra_t dij2(cg, graph.root, &edge_length);
+	for (const TNodeID id : dij1.getListOfAllNodes())
+	{
+		dijkstra_t::edge_list_t p1, p2;
+		dij1.getShortestPathTo(id, p1);
+		dij2.getShortestPathTo(id, p2);
+		EXPECT_TRUE(p1 == p2);
+	}
+}
+
+TEST(CCompressedGraph, extractSubGraph)
+{
+	mrpt::random::randomGenerator.randomize(4);
+	graph_t graph;
+	create_graph(graph, 40, 30, 1);
+	const compressed_t cg(graph);
+
+	set<TNodeID> sub_nodes;
+	for (TNodeID id = 20; id <= 35; id++) sub_nodes.insert(id);
+
+	graph_t sub1, sub2;
+	graph.extractSubGraph(sub_nodes, &sub1);
+	graph.extractSubGraph(sub_nodes, &sub2, INVALID_NODEID, true, &cg);
+
+	EXPECT_EQ(sub1.root, sub2.root);
+	EXPECT_EQ(sub1.nodes.size(), sub2.nodes.size());
+	ASSERT_EQ(sub1.edges.size(), sub2.edges.size());
+	for (auto e1 = sub1.edges.begin(), e2 = sub2.edges.begin();
+		 e1 != sub1.edges.end(); ++e1, ++e2)
+	{
+		EXPECT_EQ(e1->first, e2->first);
+		EXPECT_TRUE(e1->second == e2->second);
+	}
+}
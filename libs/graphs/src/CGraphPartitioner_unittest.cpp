@@ -0,0 +1,136 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CGraphPartitioner.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::math;
+using namespace std;
+
+typedef CGraphPartitioner<CMatrixDouble> partitioner_t;
+typedef partitioner_t::sparse_matrix_t sparse_t;
+
+// Clusters of nodes along a line, each node linked to the next "width" ones,
+// with weak links between clusters:
+static sparse_t clusters_graph(
+	const size_t nClusters, const size_t clusterSize, const size_t width)
+{
+	vector<Eigen::Triplet<double>> triplets;
+	const size_t n = nClusters * clusterSize;
+	for (size_t i = 0; i < n; i++)
+	{
+		for (size_t d = 1; d <= width && i + d < n; d++)
+		{
+			double w = 1.0 / d;
+			if (i / clusterSize != (i + d) / clusterSize) w *= 1e-5;
+			triplets.push_back(Eigen::Triplet<double>(i, i + d, w));
+			triplets.push_back(Eigen::Triplet<double>(i + d, i, w));
+		}
+	}
+	sparse_t A(n, n);
+	A.setFromTriplets(triplets.begin(), triplets.end());
+	return A;
+}
+
+static set<vector_uint> sorted_parts(vector<vector_uint> parts)
+{
+	for (auto& p : parts) std::sort(p.begin(), p.end());
+	return set<vector_uint>(parts.begin(), parts.end());
+}
+
+TEST(CGraphPartitioner, SparseMatchesDense)
+{
+	mrpt::random::randomGenerator.randomize(1);
+	const size_t n = 30;
+	CMatrixDouble A(n, n);
+	A.zeros();
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++)
+			if (i != j && (i / 10 == j / 10 ||
+						   mrpt::random::randomGenerator.drawUniform(0, 1) <
+							   0.05))
+				A(i, j) = mrpt::random::randomGenerator.drawUniform(
+					i / 10 == j / 10 ? 0.5 : 0.0, 1.0);
+	const sparse_t A_sparse = A.sparseView();
+
+	vector<vector_uint> dense_parts, sparse_parts;
+	partitioner_t::RecursiveSpectralPartition(A, dense_parts, 0.8);
+	partitioner_t::RecursiveSpectralPartition(A_sparse, sparse_parts, 0.8);
+	EXPECT_EQ(dense_parts.size(), 3U);
+	EXPECT_TRUE(sorted_parts(dense_parts) == sorted_parts(sparse_parts));
+
+	// nCut of the same (symmetric) graph:
+	CMatrixDouble A_sym = 0.5 * (A + A.transpose());
+	const sparse_t A_sym_sparse = A_sym.sparseView();
+	vector_uint p1, p2;
+	for (size_t i = 0; i < n; i++) (i % 3 ? p1 : p2).push_back(i);
+	EXPECT_NEAR(
+		partitioner_t::nCut(A_sym, p1, p2),
+		partitioner_t::nCut(A_sym_sparse, p1, p2), 1e-9);
+}
+
+TEST(CGraphPartitioner, FiedlerVector)
+{
+	// Large enough to be coarsened:
+	const sparse_t A = clusters_graph(2, 450, 6);
+	const size_t n = A.rows();
+
+	Eigen::VectorXd fiedler;
+	const double lambda = partitioner_t::FiedlerVector(A, fiedler);
+
+	const Eigen::MatrixXd W(A);
+	Eigen::MatrixXd L = -W;
+	L.diagonal() += W.rowwise().sum();
+	Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(L);
+	EXPECT_NEAR(lambda, es.eigenvalues()[1], 5e-2 * es.eigenvalues()[1]);
+	EXPECT_EQ(fiedler.size(), static_cast<int>(n));
+	EXPECT_GT(std::abs(fiedler.dot(es.eigenvectors().col(1))), 0.99);
+}
+
+TEST(CGraphPartitioner, DisconnectedGraph)
+{
+	// Components: {0..4}, {5,6,7}, {8,9}
+	sparse_t A(10, 10);
+	for (int i = 0; i < 4; i++) A.insert(i, i + 1) = 1;
+	A.insert(5, 6) = 1;
+	A.insert(6, 7) = 1;
+	A.insert(8, 9) = 1;
+
+	vector_uint p1, p2;
+	double cut;
+	partitioner_t::SpectralBisection(A, p1, p2, cut);
+	EXPECT_EQ(cut, 0);
+	EXPECT_TRUE(p1 == vector_uint({0, 1, 2, 3, 4}));
+	EXPECT_TRUE(p2 == vector_uint({5, 6, 7, 8, 9}));
+
+	vector<vector_uint> parts;
+	partitioner_t::RecursiveSpectralPartition(A, parts, 0.1, true, true, 2);
+	const set<vector_uint> expected = {
+		{0, 1, 2, 3, 4}, {5, 6, 7}, {8, 9}};
+	EXPECT_TRUE(sorted_parts(parts) == expected);
+}
+
+TEST(CGraphPartitioner, LargeSparseGraph)
+{
+	const size_t nClusters = 8, clusterSize = 2500;
+	const sparse_t A = clusters_graph(nClusters, clusterSize, 8);
+
+	vector<vector_uint> parts;
+	partitioner_t::RecursiveSpectralPartition(A, parts, 1e-3);
+	ASSERT_EQ(parts.size(), nClusters);
+	for (const auto& p : sorted_parts(parts))
+	{
+		ASSERT_EQ(p.size(), clusterSize);
+		EXPECT_EQ(p.front() % clusterSize, 0U);
+		EXPECT_EQ(p.back(), p.front() + clusterSize - 1);
+	}
+}
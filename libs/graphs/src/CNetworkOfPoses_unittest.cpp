@@ -0,0 +1,228 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/graphs/TTextLineTokenizer.h>
+#include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+template <class GRAPH>
+static void fill_random_graph(GRAPH& g, const size_t N)
+{
+	typedef typename GRAPH::constraint_t::type_value pose_t;
+	randomGenerator.randomize(123);
+	for (size_t i = 0; i < N; i++)
+	{
+		g.nodes[i] = pose_t(
+			CPose3D(
+				randomGenerator.drawUniform(-10, 10),
+				randomGenerator.drawUniform(-10, 10),
+				randomGenerator.drawUniform(-10, 10),
+				randomGenerator.drawUniform(-M_PI, M_PI),
+				randomGenerator.drawUniform(-1, 1),
+				randomGenerator.drawUniform(-M_PI, M_PI)));
+	}
+	for (size_t i = 0; i < 3 * N; i++)
+	{
+		const TNodeID from = i % N,
+					  to = randomGenerator.drawUniform32bit() % N;
+		if (from == to) continue;
+		typename GRAPH::edge_t e;
+		e.mean = (g.nodes[to] - g.nodes[from]);
+		e.cov_inv.zeros();
+		for (int r = 0; r < e.cov_inv.rows(); r++)
+			for (int c = r; c < e.cov_inv.cols(); c++)
+				e.cov_inv(r, c) = e.cov_inv(c, r) =
+					(r == c ? 100.0 : 0.0) +
+					randomGenerator.drawUniform(-1, 1);
+		g.insertEdge(from, to, e);
+	}
+	g.root = 1;
+}
+
+template <class GRAPH>
+static void expect_equal_graphs(
+	const GRAPH& g1, const GRAPH& g2, const double tol)
+{
+	ASSERT_EQ(g1.nodes.size(), g2.nodes.size());
+	ASSERT_EQ(g1.edges.size(), g2.edges.size());
+	for (auto it1 = g1.nodes.begin(), it2 = g2.nodes.begin();
+		 it1 != g1.nodes.end(); ++it1, ++it2)
+	{
+		EXPECT_EQ(it1->first, it2->first);
+		EXPECT_NEAR(
+			(CPose3D(it1->second).getAsVectorVal() -
+			 CPose3D(it2->second).getAsVectorVal())
+				.array()
+				.abs()
+				.maxCoeff(),
+			0, tol);
+	}
+	for (auto it1 = g1.edges.begin(), it2 = g2.edges.begin();
+		 it1 != g1.edges.end(); ++it1, ++it2)
+	{
+		EXPECT_EQ(it1->first, it2->first);
+		EXPECT_NEAR(
+			(CPose3D(it1->second.mean).getAsVectorVal() -
+			 CPose3D(it2->second.mean).getAsVectorVal())
+				.array()
+				.abs()
+				.maxCoeff(),
+			0, tol);
+		EXPECT_NEAR(
+			(it1->second.cov_inv - it2->second.cov_inv)
+				.array()
+				.abs()
+				.maxCoeff(),
+			0, tol * 100);
+	}
+}
+
+template <class GRAPH>
+static void test_round_trips()
+{
+	GRAPH g, g_txt, g_bin;
+	fill_random_graph(g, 200);
+	const string fil = mrpt::system::getTempFileName();
+
+	// Text files have limited precision, and do not store the root:
+	g.saveToTextFile(fil);
+	g_txt.loadFromTextFile(fil, false);
+	expect_equal_graphs(g, g_txt, 1e-4);
+	g_txt.root = g.root;
+
+	g.saveToBinaryFile(fil);
+	g_bin.loadFromBinaryFile(fil, false);
+	expect_equal_graphs(g, g_bin, 1e-12);
+	EXPECT_EQ(g_bin.root, g.root);
+	// Binary files hold exactly the same data than text files:
+	g_txt.saveToBinaryFile(fil);
+	g_bin.loadFromBinaryFile(fil, false);
+	expect_equal_graphs(g_txt, g_bin, 1e-12);
+
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CNetworkOfPoses, FileRoundTrips2D)
+{
+	test_round_trips<CNetworkOfPoses2DInf>();
+}
+TEST(CNetworkOfPoses, FileRoundTrips3D)
+{
+	test_round_trips<CNetworkOfPoses3DInf>();
+}
+
+TEST(CNetworkOfPoses, LoadTextFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		ofstream f(fil.c_str(), ios::binary);
+		f << "# comment\r\n"
+			 "\r\n"
+			 "VERTEX2 0 1.5 -2 0.25\r\n"
+			 "  VERTEX2 1 3e-1 .5 -1E-2  \n"
+			 "// another comment\n"
+			 "% and another one\n"
+			 "VERTEX2 5 0 0 0\n"
+			 "EQUIV 5 1\n"
+			 "EDGE2 0 1 1.0 2.0 0.5 10 0 20 30 0 0\n"
+			 "EDGE2 1 0 1.0 2.0 0.5 10 0 20 30 0 0";  // No final newline
+	}
+	CNetworkOfPoses2DInf g;
+	g.loadFromTextFile(fil, false);
+	ASSERT_EQ(g.nodes.size(), 2U);
+	EXPECT_EQ(g.nodes[0].x(), 1.5);
+	EXPECT_EQ(g.nodes[0].phi(), 0.25);
+	EXPECT_EQ(g.nodes[1].x(), 0.3);
+	EXPECT_EQ(g.nodes[1].y(), 0.5);
+	EXPECT_EQ(g.nodes[1].phi(), -0.01);
+	ASSERT_EQ(g.edges.size(), 2U);
+	const auto& e = g.edges.find(make_pair(TNodeID(0), TNodeID(1)))->second;
+	EXPECT_EQ(e.mean.y(), 2.0);
+	EXPECT_EQ(e.cov_inv(1, 1), 20.0);
+	EXPECT_EQ(e.cov_inv(2, 2), 30.0);
+
+	// Malformed lines:
+	{
+		ofstream f(fil.c_str());
+		f << "VERTEX2 0 1.5 -2 0.25\nVERTEX2 1 1.5 x 0.25\n";
+	}
+	EXPECT_ANY_THROW(g.loadFromTextFile(fil));
+	// 3D graph into a 2D one:
+	{
+		ofstream f(fil.c_str());
+		f << "VERTEX3 0 1 2 3 0 0 0\n";
+	}
+	EXPECT_ANY_THROW(g.loadFromTextFile(fil));
+	CNetworkOfPoses3DInf g3;
+	EXPECT_NO_THROW(g3.loadFromTextFile(fil));
+	EXPECT_EQ(g3.nodes[0].z(), 3.0);
+	// Not a binary graph file:
+	EXPECT_ANY_THROW(g3.loadFromBinaryFile(fil));
+
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CNetworkOfPoses, LoadCorruptBinaryFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	CNetworkOfPoses2DInf g;
+	g.nodes[0] = CPose2D(1, 2, 0.5);
+	g.saveToBinaryFile(fil);
+	{
+		// Overwrite the number of nodes with one such that the expected file
+		// size overflows to the actual one (4*(2^62+1) = 4 mod 2^64):
+		fstream f(fil.c_str(), ios::in | ios::out | ios::binary);
+		f.seekp(3 * sizeof(uint64_t));
+		const uint64_t nNodes = (uint64_t(1) << 62) + 1;
+		for (int i = 0; i < 8; i++) f.put(char((nNodes >> (8 * i)) & 0xFF));
+	}
+	EXPECT_ANY_THROW(g.loadFromBinaryFile(fil));
+
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CNetworkOfPoses, TextLineTokenizerNumbers)
+{
+	const string txt =
+		"0 1 -1 +7 3.14159 -2.5e-3 1e22 1e-22 123456789012345 "
+		"0.1234567890123456789 1e300 -4.9e-320 0.30000000000000004 "
+		"18446744073709551615 18446744073709551616 abc";
+	mrpt::graphs::detail::TTextLineTokenizer s(
+		&txt[0], &txt[0] + txt.size());
+	ASSERT_TRUE(s.getNextLine());
+	std::istringstream ss(txt);
+	for (int i = 0; i < 13; i++)
+	{
+		double d, d_ref;
+		string tok;
+		ss >> tok;
+		d_ref = strtod(tok.c_str(), nullptr);
+		s >> d;
+		ASSERT_TRUE(s);
+		EXPECT_EQ(d, d_ref) << tok;
+	}
+	uint64_t v;
+	s >> v;
+	EXPECT_TRUE(s);
+	EXPECT_EQ(v, UINT64_MAX);
+	s >> v;
+	EXPECT_FALSE(s);  // overflow
+	EXPECT_FALSE(s.getNextLine());
+}
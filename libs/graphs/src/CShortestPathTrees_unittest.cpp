@@ -0,0 +1,151 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/graphs/CShortestPathTrees.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace mrpt::utils;
+using namespace std;
+
+typedef CNetworkOfPoses2D graph_t;
+typedef CShortestPathTrees<graph_t> spt_t;
+typedef CDijkstra<graph_t> dijkstra_t;
+
+static double edge_length(
+	const graph_t&, const TNodeID, const TNodeID, const graph_t::edge_t& edge)
+{
+	return edge.norm();
+}
+
+static void random_edge(graph_t& graph, const TNodeID a, const TNodeID b)
+{
+	auto& rnd = mrpt::random::randomGenerator;
+	graph.insertEdge(
+		a, b, CPose2D(rnd.drawUniform(0.1, 2.0), rnd.drawUniform(-1, 1), 0));
+}
+
+// Checks all the distances and paths from the given sources against CDijkstra
+static void check_trees(
+	const graph_t& graph, const spt_t& spt, const vector<TNodeID>& sources)
+{
+	for (const TNodeID src : sources)
+	{
+		ASSERT_TRUE(spt.hasTree(src));
+		const dijkstra_t dij(graph, src, &edge_length);
+		for (const TNodeID id : dij.getListOfAllNodes())
+		{
+			const double d = dij.getNodeDistanceToRoot(id);
+			EXPECT_NEAR(spt.getDistance(src, id), d, 1e-9);
+
+			spt_t::edge_list_t path;
+			ASSERT_TRUE(spt.getShortestPath(src, id, path));
+			double len = 0;
+			TNodeID cur = src;
+			for (const auto& arc : path)
+			{
+				ASSERT_TRUE(arc.first == cur || arc.second == cur);
+				cur = (arc.first == cur) ? arc.second : arc.first;
+				len += graph.getEdge(arc.first, arc.second).norm();
+			}
+			EXPECT_EQ(cur, id);
+			EXPECT_NEAR(len, d, 1e-9);
+		}
+	}
+}
+
+// A robot trajectory: odometry edges between consecutive nodes, plus a few
+// loop closures, added over time.
+TEST(CShortestPathTrees, incremental_updates)
+{
+	mrpt::random::randomGenerator.randomize(1);
+	graph_t graph;
+	graph.root = 0;
+	spt_t spt(&edge_length);
+
+	const vector<TNodeID> sources = {0, 5, 17};
+	for (TNodeID n = 1; n < 120; n++)
+	{
+		random_edge(graph, n - 1, n);
+		if (n > 30 && n % 7 == 0)
+			random_edge(
+				graph, n, mrpt::random::randomGenerator.drawUniform32bit() %
+							  (n - 20));
+
+		EXPECT_TRUE(spt.update(graph));
+		if (n < 17) continue;
+		spt.computeTrees(sources);
+		if (n % 10 == 0) check_trees(graph, spt, sources);
+	}
+	EXPECT_FALSE(spt.update(graph));
+	EXPECT_EQ(spt.getTreeCount(), sources.size());
+	check_trees(graph, spt, sources);
+
+	// A parallel, shorter edge:
+	graph.insertEdge(3, 4, CPose2D(0.01, 0, 0));
+	EXPECT_TRUE(spt.update(graph));
+	EXPECT_NEAR(spt.getDistance(0, 4), spt.getDistance(0, 3) + 0.01, 1e-9);
+
+	// Removing an edge rebuilds the index and drops the trees:
+	graph.edges.erase(graph.edges.find(make_pair(3, 4)));
+	EXPECT_TRUE(spt.update(graph));
+	EXPECT_EQ(spt.getTreeCount(), 0U);
+	EXPECT_THROW(spt.getDistance(0, 4), std::exception);
+	spt.computeTrees(sources);
+	check_trees(graph, spt, sources);
+}
+
+TEST(CShortestPathTrees, unreachable_and_renumbered_nodes)
+{
+	mrpt::random::randomGenerator.randomize(2);
+	graph_t graph;
+	for (TNodeID n = 11; n < 40; n += 2) random_edge(graph, n - 2, n);
+	random_edge(graph, 100, 101);
+
+	spt_t spt(&edge_length);
+	spt.update(graph);
+	spt.computeTrees({9, 100, 12345});
+	EXPECT_EQ(spt.getTreeCount(), 2U);
+	spt_t::edge_list_t path;
+	EXPECT_FALSE(spt.getShortestPath(9, 100, path));
+	EXPECT_EQ(spt.getDistance(9, 101), std::numeric_limits<double>::max());
+	EXPECT_TRUE(spt.getShortestPath(9, 9, path));
+	EXPECT_TRUE(path.empty());
+
+	// New node IDs between the existing ones:
+	for (TNodeID n = 10; n < 40; n += 2) random_edge(graph, n - 1, n);
+	random_edge(graph, 39, 100);
+	spt.update(graph);
+	spt.computeTrees({9, 100});
+	check_trees(graph, spt, {9, 100});
+}
+
+TEST(CShortestPathTrees, max_trees)
+{
+	mrpt::random::randomGenerator.randomize(3);
+	graph_t graph;
+	for (TNodeID n = 1; n < 20; n++) random_edge(graph, n - 1, n);
+
+	spt_t spt(&edge_length, 3);
+	spt.update(graph);
+	spt.computeTrees({0, 1});
+	spt.computeTrees({2, 3});
+	EXPECT_EQ(spt.getTreeCount(), 3U);
+	EXPECT_FALSE(spt.hasTree(0) && spt.hasTree(1));
+	EXPECT_TRUE(spt.hasTree(2) && spt.hasTree(3));
+
+	// The requested trees are never dropped:
+	spt.computeTrees({4, 5, 6, 7});
+	EXPECT_EQ(spt.getTreeCount(), 4U);
+	check_trees(graph, spt, {4, 5, 6, 7});
+}
@@ -11,6 +11,11 @@
 
 #include <mrpt/graphs/ScalarFactorGraph.h>
 #include <mrpt/utils/CTicTac.h>
+#include <mrpt/utils/parallel.h>
+
+#include <algorithm>
+#include <map>
+#include <typeindex>
 
 using namespace mrpt;
 using namespace mrpt::graphs;
@@ -20,12 +25,284 @@ using namespace std;
 #if EIGEN_VERSION_AT_LEAST(3, 1, 0)  // Requires Eigen>=3.1
 #include <Eigen/SparseCore>
 #include <Eigen/SparseQR>
+#include <Eigen/SparseCholesky>
+#endif
+#if EIGEN_VERSION_AT_LEAST(3, 3, 0)  // IncompleteCholesky requires Eigen>=3.3
+#include <Eigen/IterativeLinearSolvers>
+#define GMRF_HAS_PCG 1
+#else
+#define GMRF_HAS_PCG 0
+#endif
+
+typedef ScalarFactorGraph::UnaryFactorVirtualBase unary_factor_t;
+typedef ScalarFactorGraph::BinaryFactorVirtualBase binary_factor_t;
+typedef ScalarFactorGraph::unary_batch_evaluator_t unary_evaluator_t;
+typedef ScalarFactorGraph::binary_batch_evaluator_t binary_evaluator_t;
+
+namespace
+{
+/** Minimum number of factors per thread worth the cost of starting it */
+const size_t MIN_FACTORS_PER_THREAD = 20000;
+
+/** Evaluators for types not registered with registerFactorType() */
+void evalUnaryVirtual(
+	const unary_factor_t* const* factors, size_t count, double* residuals,
+	double* informations, double* dr_dx)
+{
+	for (size_t k = 0; k < count; k++)
+	{
+		residuals[k] = factors[k]->evaluateResidual();
+		informations[k] = factors[k]->getInformation();
+		factors[k]->evalJacobian(dr_dx[k]);
+	}
+}
+void evalBinaryVirtual(
+	const binary_factor_t* const* factors, size_t count, double* residuals,
+	double* informations, double* dr_dxi, double* dr_dxj)
+{
+	for (size_t k = 0; k < count; k++)
+	{
+		residuals[k] = factors[k]->evaluateResidual();
+		informations[k] = factors[k]->getInformation();
+		factors[k]->evalJacobian(dr_dxi[k], dr_dxj[k]);
+	}
+}
+
+/** Consecutive factors [first,last) of the same type */
+template <class EVALUATOR>
+struct TFactorRun
+{
+	EVALUATOR eval;
+	size_t first, last;
+};
+
+/** Sorts the factors by type (stable), and returns the runs of each type */
+template <class FACTOR, class EVALUATOR>
+void groupFactorsByType(
+	const std::deque<const FACTOR*>& factors,
+	const std::map<std::type_index, EVALUATOR>& evaluators,
+	const EVALUATOR default_evaluator, std::vector<const FACTOR*>& grouped,
+	std::vector<TFactorRun<EVALUATOR>>& runs)
+{
+	const size_t m = factors.size();
+	std::vector<size_t> factor_group(m);
+	std::vector<size_t> group_count;
+	std::vector<EVALUATOR> group_eval;
+	std::map<std::type_index, size_t> type2group;
+	const std::type_info* last_type = nullptr;
+	size_t last_group = 0;
+	for (size_t i = 0; i < m; i++)
+	{
+		ASSERT_(factors[i] != nullptr);
+		const std::type_info& type = typeid(*factors[i]);
+		if (!last_type || type != *last_type)
+		{
+			auto it = type2group.find(std::type_index(type));
+			if (it == type2group.end())
+			{
+				it = type2group
+						 .insert(
+							 std::make_pair(
+								 std::type_index(type), group_count.size()))
+						 .first;
+				group_count.push_back(0);
+				const auto it_eval = evaluators.find(std::type_index(type));
+				group_eval.push_back(
+					it_eval != evaluators.end() ? it_eval->second
+												: default_evaluator);
+			}
+			last_type = &type;
+			last_group = it->second;
+		}
+		factor_group[i] = last_group;
+		group_count[last_group]++;
+	}
+
+	runs.resize(group_count.size());
+	size_t first = 0;
+	for (size_t g = 0; g < group_count.size(); g++)
+	{
+		runs[g].eval = group_eval[g];
+		runs[g].first = runs[g].last = first;
+		first += group_count[g];
+	}
+	grouped.resize(m);
+	for (size_t i = 0; i < m; i++)
+		grouped[runs[factor_group[i]].last++] = factors[i];
+}
+
+/** A factor which contributes to the diagonal of the normal equations and
+ * the gradient at one node */
+struct TNodeFactor
+{
+	enum TKind
+	{
+		UNARY = 0,
+		BINARY_I,
+		BINARY_J,
+		/** Binary factor with node_id_i==node_id_j */
+		BINARY_BOTH
+	};
+	size_t factor;
+	TKind kind;
+};
+
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+/** Diagonal of inv(L*L'), with L a sparse lower triangular matrix (with the
+ * diagonal first in each column), as in a Cholesky decomposition. The
+ * Takahashi equations give the entries of the inverse in the pattern of L,
+ * from the last column backwards. perm[i] is the original index of row i. */
+template <class PERM_INDICES>
+void variancesFromCholeskyFactor(
+	const Eigen::SparseMatrix<double>& L, const PERM_INDICES& perm,
+	Eigen::VectorXd& variances)
+{
+	const int n = L.cols();
+	const int* outer = L.outerIndexPtr();
+	const int* inner = L.innerIndexPtr();
+	const double* vals = L.valuePtr();
+	// Entries of the inverse in the pattern of L:
+	std::vector<double> sigma(L.nonZeros(), .0);
+	auto sigma_at = [&](int i, int j) {
+		if (i > j) std::swap(i, j);
+		const int* it = std::lower_bound(inner + outer[i], inner + outer[i + 1], j);
+		return (it != inner + outer[i + 1] && *it == j) ? sigma[it - inner]
+														: .0;
+	};
+
+	variances.resize(n);
+	for (int l = n - 1; l >= 0; l--)
+	{
+		const int k0 = outer[l], k1 = outer[l + 1];
+		const bool has_diag = (k0 < k1 && inner[k0] == l);
+		const double R_ll = has_diag ? vals[k0] : .0;
+		const int k_first = has_diag ? k0 + 1 : k0;
+
+		// Off-diagonal entries: Sigma(l,j) = -1/R_ll * sum_i R(l,i)Sigma(i,j)
+		double subSigmas = 0.0;
+		for (int p = k_first; p < k1; p++)
+		{
+			const int j = inner[p];
+			double sum = 0.0;
+			for (int q = k_first; q < k1; q++)
+				sum += vals[q] * sigma_at(inner[q], j);
+			sigma[p] = -sum / R_ll;
+			subSigmas += vals[p] * sigma[p];
+		}
+		const double var = (1 / R_ll) * (1 / R_ll - subSigmas);
+		if (has_diag) sigma[k0] = var;
+		variances[perm[l]] = var;
+	}
+}
+#endif
+}  // namespace
+
+struct ScalarFactorGraph::TSolverData
+{
+	std::map<std::type_index, unary_evaluator_t> unary_evaluators;
+	std::map<std::type_index, binary_evaluator_t> binary_evaluators;
+
+	/** Factors grouped by type, with their evaluators */
+	bool unary_valid, binary_valid;
+	std::vector<const unary_factor_t*> unary;
+	std::vector<TFactorRun<unary_evaluator_t>> unary_runs;
+	std::vector<const binary_factor_t*> binary;
+	std::vector<TFactorRun<binary_evaluator_t>> binary_runs;
+
+	/** Whitened residuals and Jacobians of each factor (information is only
+	 * used while evaluating them) */
+	std::vector<double> unary_r, unary_info, unary_J;
+	std::vector<double> binary_r, binary_info, binary_Ji, binary_Jj;
+
+	/** Factors of each node (CSR), for the normal equations */
+	bool node_factors_valid;
+	std::vector<size_t> node_factors_ptr;
+	std::vector<TNodeFactor> node_factors;
+
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+	/** Normal equations (both triangles), and the binary factors of each of
+	 * its off-diagonal entries (CSR, by entry) */
+	bool H_valid;
+	Eigen::SparseMatrix<double> H;
+	std::vector<size_t> H_factors_ptr, H_factors;
+	Eigen::SimplicialLLT<Eigen::SparseMatrix<double>> llt;
+	bool llt_analyzed;
+#if GMRF_HAS_PCG
+	Eigen::ConjugateGradient<Eigen::SparseMatrix<double>,
+							 Eigen::Lower | Eigen::Upper,
+							 Eigen::IncompleteCholesky<double>>
+		pcg;
+	bool pcg_analyzed;
+#endif
+
+	/** Whitened Jacobian (one row per factor) and the position of each
+	 * factor in its values */
+	bool A_valid;
+	Eigen::SparseMatrix<double> A;
+	std::vector<size_t> A_pos_unary, A_pos_binary_i, A_pos_binary_j;
+	Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>
+		qr;
+	bool qr_analyzed;
+#endif
+
+	TSolverData()
+	{
+		invalidateUnary();
+		invalidateBinary();
+	}
+	/** Copies only the registered evaluators: everything else refers to the
+	 * factors of the source graph, and is rebuilt on demand */
+	TSolverData& operator=(const TSolverData& o)
+	{
+		unary_evaluators = o.unary_evaluators;
+		binary_evaluators = o.binary_evaluators;
+		invalidateUnary();
+		invalidateBinary();
+		return *this;
+	}
+
+	void invalidateUnary()
+	{
+		unary_valid = false;
+		node_factors_valid = false;
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+		A_valid = false;
+#endif
+	}
+	void invalidateBinary()
+	{
+		binary_valid = false;
+		node_factors_valid = false;
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+		A_valid = false;
+		H_valid = false;
+#endif
+	}
+
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+	void buildJacobianPattern(const size_t n);
+	void buildNodeFactors(const size_t n);
+	void buildNormalEquationsPattern(const size_t n);
 #endif
+};
+
+PIMPL_IMPLEMENT(ScalarFactorGraph::TSolverData);
 
 ScalarFactorGraph::FactorBase::~FactorBase() {}
+ScalarFactorGraph::TSolverOptions::TSolverOptions()
+	: solver(SOLVER_SPARSE_QR),
+	  num_threads(0),
+	  pcg_tolerance(1e-8),
+	  pcg_max_iterations(0),
+	  robust_kernel(ROBUST_KERNEL_NONE),
+	  robust_kernel_param(3.0)
+{
+}
+
 ScalarFactorGraph::ScalarFactorGraph()
-	: COutputLogger("GMRF"), m_enable_profiler(false)
+	: COutputLogger("GMRF"), m_numNodes(0), m_enable_profiler(false)
 {
+	PIMPL_CONSTRUCT(TSolverData, m_solver_data);
 }
 
 void ScalarFactorGraph::clear()
@@ -35,6 +312,8 @@ void ScalarFactorGraph::clear()
 	m_numNodes = 0;
 	m_factors_unary.clear();
 	m_factors_binary.clear();
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateUnary();
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateBinary();
 }
 
 void ScalarFactorGraph::initialize(const size_t nodeCount)
@@ -42,15 +321,45 @@ void ScalarFactorGraph::initialize(const size_t nodeCount)
 	MRPT_LOG_DEBUG_STREAM("initialize() called, nodeCount=" << nodeCount);
 
 	m_numNodes = nodeCount;
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateUnary();
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateBinary();
+}
+
+void ScalarFactorGraph::registerFactorType(
+	const std::type_info& type, unary_batch_evaluator_t evaluator)
+{
+	TSolverData& d = PIMPL_GET_REF(TSolverData, m_solver_data);
+	d.unary_evaluators[std::type_index(type)] = evaluator;
+	d.invalidateUnary();
+}
+void ScalarFactorGraph::registerFactorType(
+	const std::type_info& type, binary_batch_evaluator_t evaluator)
+{
+	TSolverData& d = PIMPL_GET_REF(TSolverData, m_solver_data);
+	d.binary_evaluators[std::type_index(type)] = evaluator;
+	d.invalidateBinary();
 }
 
 void ScalarFactorGraph::addConstraint(const UnaryFactorVirtualBase& c)
 {
 	m_factors_unary.push_back(&c);
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateUnary();
 }
 void ScalarFactorGraph::addConstraint(const BinaryFactorVirtualBase& c)
 {
 	m_factors_binary.push_back(&c);
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateBinary();
+}
+
+void ScalarFactorGraph::clearAllConstraintsByType_Unary()
+{
+	m_factors_unary.clear();
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateUnary();
+}
+void ScalarFactorGraph::clearAllConstraintsByType_Binary()
+{
+	m_factors_binary.clear();
+	PIMPL_GET_REF(TSolverData, m_solver_data).invalidateBinary();
 }
 
 bool ScalarFactorGraph::eraseConstraint(const FactorBase& c)
@@ -60,6 +369,7 @@ bool ScalarFactorGraph::eraseConstraint(const FactorBase& c)
 		if (it != m_factors_unary.end())
 		{
 			m_factors_unary.erase(it);
+			PIMPL_GET_REF(TSolverData, m_solver_data).invalidateUnary();
 			return true;
 		}
 	}
@@ -69,18 +379,201 @@ bool ScalarFactorGraph::eraseConstraint(const FactorBase& c)
 		if (it != m_factors_binary.end())
 		{
 			m_factors_binary.erase(it);
+			PIMPL_GET_REF(TSolverData, m_solver_data).invalidateBinary();
 			return true;
 		}
 	}
 	return false;
 }
 
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+void ScalarFactorGraph::TSolverData::buildJacobianPattern(const size_t n)
+{
+	const size_t m1 = unary.size(), m2 = binary.size();
+
+	// Count the entries of each column:
+	std::vector<int> outer(n + 1, 0);
+	for (const auto f : unary)
+	{
+		ASSERT_BELOW_(f->node_id, n);
+		outer[f->node_id + 1]++;
+	}
+	for (const auto f : binary)
+	{
+		ASSERT_BELOW_(f->node_id_i, n);
+		ASSERT_BELOW_(f->node_id_j, n);
+		outer[f->node_id_i + 1]++;
+		if (f->node_id_j != f->node_id_i) outer[f->node_id_j + 1]++;
+	}
+	for (size_t c = 0; c < n; c++) outer[c + 1] += outer[c];
+
+	A.resize(m1 + m2, n);
+	A.resizeNonZeros(outer[n]);
+	std::copy(outer.begin(), outer.end(), A.outerIndexPtr());
+	std::fill(A.valuePtr(), A.valuePtr() + outer[n], .0);
+	int* inner = A.innerIndexPtr();
+
+	// Rows are visited in order, thus they end up sorted in each column:
+	A_pos_unary.resize(m1);
+	for (size_t k = 0; k < m1; k++)
+	{
+		const int pos = outer[unary[k]->node_id]++;
+		inner[pos] = k;
+		A_pos_unary[k] = pos;
+	}
+	A_pos_binary_i.resize(m2);
+	A_pos_binary_j.resize(m2);
+	for (size_t k = 0; k < m2; k++)
+	{
+		const size_t i = binary[k]->node_id_i, j = binary[k]->node_id_j;
+		const int row = m1 + k;
+		// Keep the order of columns i, j:
+		const int pos_i = outer[i]++;
+		inner[pos_i] = row;
+		A_pos_binary_i[k] = pos_i;
+		if (j != i)
+		{
+			const int pos_j = outer[j]++;
+			inner[pos_j] = row;
+			A_pos_binary_j[k] = pos_j;
+		}
+		else
+			A_pos_binary_j[k] = pos_i;
+	}
+	A_valid = true;
+	qr_analyzed = false;
+}
+
+void ScalarFactorGraph::TSolverData::buildNodeFactors(const size_t n)
+{
+	const size_t m1 = unary.size(), m2 = binary.size();
+	node_factors_ptr.assign(n + 1, 0);
+	for (const auto f : unary)
+	{
+		ASSERT_BELOW_(f->node_id, n);
+		node_factors_ptr[f->node_id + 1]++;
+	}
+	for (const auto f : binary)
+	{
+		ASSERT_BELOW_(f->node_id_i, n);
+		ASSERT_BELOW_(f->node_id_j, n);
+		node_factors_ptr[f->node_id_i + 1]++;
+		if (f->node_id_j != f->node_id_i) node_factors_ptr[f->node_id_j + 1]++;
+	}
+	for (size_t c = 0; c < n; c++)
+		node_factors_ptr[c + 1] += node_factors_ptr[c];
+
+	node_factors.resize(node_factors_ptr[n]);
+	std::vector<size_t> next(node_factors_ptr.begin(), node_factors_ptr.end() - 1);
+	for (size_t k = 0; k < m1; k++)
+	{
+		TNodeFactor& nf = node_factors[next[unary[k]->node_id]++];
+		nf.factor = k;
+		nf.kind = TNodeFactor::UNARY;
+	}
+	for (size_t k = 0; k < m2; k++)
+	{
+		const size_t i = binary[k]->node_id_i, j = binary[k]->node_id_j;
+		if (i == j)
+		{
+			TNodeFactor& nf = node_factors[next[i]++];
+			nf.factor = k;
+			nf.kind = TNodeFactor::BINARY_BOTH;
+			continue;
+		}
+		TNodeFactor& nf_i = node_factors[next[i]++];
+		nf_i.factor = k;
+		nf_i.kind = TNodeFactor::BINARY_I;
+		TNodeFactor& nf_j = node_factors[next[j]++];
+		nf_j.factor = k;
+		nf_j.kind = TNodeFactor::BINARY_J;
+	}
+	node_factors_valid = true;
+}
+
+void ScalarFactorGraph::TSolverData::buildNormalEquationsPattern(
+	const size_t n)
+{
+	const size_t m2 = binary.size();
+
+	// (row, factor) of the off-diagonal entries of each column:
+	std::vector<size_t> col_ptr(n + 1, 0);
+	for (const auto f : binary)
+	{
+		ASSERT_BELOW_(f->node_id_i, n);
+		ASSERT_BELOW_(f->node_id_j, n);
+		if (f->node_id_i == f->node_id_j) continue;
+		col_ptr[f->node_id_i + 1]++;
+		col_ptr[f->node_id_j + 1]++;
+	}
+	for (size_t c = 0; c < n; c++) col_ptr[c + 1] += col_ptr[c];
+	std::vector<std::pair<int, size_t>> entries(col_ptr[n]);
+	{
+		std::vector<size_t> next(col_ptr.begin(), col_ptr.end() - 1);
+		for (size_t k = 0; k < m2; k++)
+		{
+			const size_t i = binary[k]->node_id_i, j = binary[k]->node_id_j;
+			if (i == j) continue;
+			entries[next[i]++] = std::make_pair(int(j), k);
+			entries[next[j]++] = std::make_pair(int(i), k);
+		}
+	}
+
+	// Merge them, with the diagonal, into the sorted pattern of H:
+	std::vector<int> outer(n + 1, 0), inner;
+	inner.reserve(n + entries.size());
+	H_factors_ptr.assign(1, 0);
+	H_factors_ptr.reserve(n + entries.size() + 1);
+	H_factors.clear();
+	H_factors.reserve(entries.size());
+	for (size_t c = 0; c < n; c++)
+	{
+		const auto b = entries.begin() + col_ptr[c],
+				   e = entries.begin() + col_ptr[c + 1];
+		std::sort(b, e);
+		bool diag_done = false;
+		for (auto it = b;;)
+		{
+			if (!diag_done && (it == e || it->first > int(c)))
+			{
+				inner.push_back(c);
+				H_factors_ptr.push_back(H_factors.size());
+				diag_done = true;
+			}
+			if (it == e) break;
+			const int row = it->first;
+			inner.push_back(row);
+			for (; it != e && it->first == row; ++it)
+				H_factors.push_back(it->second);
+			H_factors_ptr.push_back(H_factors.size());
+		}
+		outer[c + 1] = inner.size();
+	}
+
+	H.resize(n, n);
+	H.resizeNonZeros(inner.size());
+	std::copy(outer.begin(), outer.end(), H.outerIndexPtr());
+	std::copy(inner.begin(), inner.end(), H.innerIndexPtr());
+	std::fill(H.valuePtr(), H.valuePtr() + inner.size(), .0);
+
+	H_valid = true;
+	llt_analyzed = false;
+#if GMRF_HAS_PCG
+	pcg_analyzed = false;
+#endif
+}
+#endif
+
 /* Method:
   (\Sigma)^{-1/2) *  d( h(x) )/d( x )  * x_incr = - (\Sigma)^{-1/2) * r(x)
   ===================================            ========================
 			  =A                                           =b
 
    A * x_incr = b         --> SparseQR.
+   A'A * x_incr = A'b     --> Sparse Cholesky / PCG.
+
+  With a robust kernel, the information of each factor is scaled by the
+  weight of its current error (one step of iteratively reweighted LSQ).
 */
 void ScalarFactorGraph::updateEstimation(
 	/** Output increment of the current estimate. Caller must add this
@@ -94,6 +587,7 @@ void ScalarFactorGraph::updateEstimation(
 	m_timelogger.enable(m_enable_profiler);
 
 #if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+	TSolverData& d = PIMPL_GET_REF(TSolverData, m_solver_data);
 
 	// Number of vertices:
 	const size_t n = m_numNodes;
@@ -103,146 +597,304 @@ void ScalarFactorGraph::updateEstimation(
 	const size_t m1 = m_factors_unary.size(), m2 = m_factors_binary.size();
 	const size_t m = m1 + m2;
 
-	// Build Ax=b
-	// -----------------------
-	m_timelogger.enter("GMRF.build_A_tri");
-
-	std::vector<Eigen::Triplet<double>> A_tri;
-	A_tri.reserve(m1 + 2 * m2);
-
-	Eigen::VectorXd g;  // Error vector
-
-	g.setZero(m);
-	int edge_counter = 0;
-	for (const auto& e : m_factors_unary)
-	{
-		ASSERT_(e != nullptr);
-		// Jacob:
-		const double w = std::sqrt(e->getInformation());
-		double dr_dx;
-		e->evalJacobian(dr_dx);
-		const int node_id = e->node_id;
-		A_tri.push_back(
-			Eigen::Triplet<double>(edge_counter, node_id, w * dr_dx));
-		// gradient:
-		g[edge_counter] -= w * e->evaluateResidual();
-
-		++edge_counter;
-	}
-	for (const auto& e : m_factors_binary)
-	{
-		ASSERT_(e != nullptr);
-		// Jacob:
-		const double w = std::sqrt(e->getInformation());
-		double dr_dxi, dr_dxj;
-		e->evalJacobian(dr_dxi, dr_dxj);
-		const int node_id_i = e->node_id_i, node_id_j = e->node_id_j;
-		A_tri.push_back(
-			Eigen::Triplet<double>(edge_counter, node_id_i, w * dr_dxi));
-		A_tri.push_back(
-			Eigen::Triplet<double>(edge_counter, node_id_j, w * dr_dxj));
-		// gradient:
-		g[edge_counter] -= w * e->evaluateResidual();
-
-		++edge_counter;
-	}
-	m_timelogger.leave("GMRF.build_A_tri");
-
-	// Compress sparse
-	// -----------------------
-	Eigen::SparseMatrix<double> A(m, n);
-	{
-		mrpt::utils::CTimeLoggerEntry tle(
-			m_timelogger, "GMRF.build_A_compress");
+	const size_t num_threads = std::max<size_t>(
+		1, std::min<size_t>(
+			   mrpt::utils::parallel_num_threads(solverOptions.num_threads),
+			   m / MIN_FACTORS_PER_THREAD));
 
-		A.setFromTriplets(A_tri.begin(), A_tri.end());
-		A.makeCompressed();
-	}
+	TSolverType solver = solverOptions.solver;
+	// Variances need a direct factorization, use it to solve too:
+	if (solver == SOLVER_PCG && (solved_variances || !GMRF_HAS_PCG))
+		solver = SOLVER_SPARSE_CHOLESKY;
 
-	// Solve increment
+	// Group factors by type
 	// -----------------------
-	Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>
-		solver;
+	if (!d.unary_valid || !d.binary_valid)
 	{
-		mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.solve");
-
-		solver.compute(A);
-		solved_x_inc = solver.solve(g);
+		mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.group_factors");
+		if (!d.unary_valid)
+		{
+			groupFactorsByType(
+				m_factors_unary, d.unary_evaluators,
+				static_cast<unary_evaluator_t>(&evalUnaryVirtual), d.unary,
+				d.unary_runs);
+			d.unary_r.resize(m1);
+			d.unary_info.resize(m1);
+			d.unary_J.resize(m1);
+			d.unary_valid = true;
+		}
+		if (!d.binary_valid)
+		{
+			groupFactorsByType(
+				m_factors_binary, d.binary_evaluators,
+				static_cast<binary_evaluator_t>(&evalBinaryVirtual), d.binary,
+				d.binary_runs);
+			d.binary_r.resize(m2);
+			d.binary_info.resize(m2);
+			d.binary_Ji.resize(m2);
+			d.binary_Jj.resize(m2);
+			d.binary_valid = true;
+		}
 	}
 
-	// Recover covariance
+	// Evaluate factors: residuals & Jacobians, whitened with sqrt(weight *
+	// information)
 	// -----------------------
-	if (solved_variances)
-	{
-		mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.variance");
-
-		solved_variances->resize(n);
-
-		// VARIANCE SIGMA = inv(P) * inv( P*H*inv(P) ) * P
-		// Get triangular supperior P*H*inv(P) = UT' * UT = P * R'*R * inv(P)
-		// (QR factor: Use UT=R)
-
-		MRPT_TODO("Use compressed access instead of coeff() below");
+	m_timelogger.enter("GMRF.eval_factors");
+	const TRobustKernel kernel = solverOptions.robust_kernel;
+	const double kernel_k = solverOptions.robust_kernel_param;
+	auto sqrt_weight = [kernel, kernel_k](const double r, const double info) {
+		const double w = std::sqrt(info);
+		const double e = std::abs(w * r);
+		switch (kernel)
+		{
+			case ROBUST_KERNEL_HUBER:
+				return e <= kernel_k ? w : w * std::sqrt(kernel_k / e);
+			case ROBUST_KERNEL_CAUCHY:
+				return w / std::sqrt(1 + (e / kernel_k) * (e / kernel_k));
+			default:
+				return w;
+		};
+	};
+	mrpt::utils::parallel_for_ranges(
+		m1, num_threads, [&](size_t, size_t first, size_t last) {
+			for (const auto& run : d.unary_runs)
+			{
+				const size_t a = std::max(first, run.first),
+							 b = std::min(last, run.last);
+				if (a < b)
+					run.eval(
+						&d.unary[a], b - a, &d.unary_r[a], &d.unary_info[a],
+						&d.unary_J[a]);
+			}
+			for (size_t k = first; k < last; k++)
+			{
+				const double s = sqrt_weight(d.unary_r[k], d.unary_info[k]);
+				d.unary_r[k] *= s;
+				d.unary_J[k] *= s;
+			}
+		});
+	mrpt::utils::parallel_for_ranges(
+		m2, num_threads, [&](size_t, size_t first, size_t last) {
+			for (const auto& run : d.binary_runs)
+			{
+				const size_t a = std::max(first, run.first),
+							 b = std::min(last, run.last);
+				if (a < b)
+					run.eval(
+						&d.binary[a], b - a, &d.binary_r[a], &d.binary_info[a],
+						&d.binary_Ji[a], &d.binary_Jj[a]);
+			}
+			for (size_t k = first; k < last; k++)
+			{
+				const double s = sqrt_weight(d.binary_r[k], d.binary_info[k]);
+				d.binary_r[k] *= s;
+				d.binary_Ji[k] *= s;
+				d.binary_Jj[k] *= s;
+			}
+		});
+	m_timelogger.leave("GMRF.eval_factors");
 
-		Eigen::SparseMatrix<double> UT = solver.matrixR();
-		Eigen::SparseMatrix<double> solved_covariance(n, n);
-		solved_covariance.reserve(UT.nonZeros());
+	// Factorization of the system:
+	// (permuted, lower triangular) and the original index of each row:
+	Eigen::SparseMatrix<double> L;
+	Eigen::VectorXi L_perm;
 
-		// Apply custom equations to obtain the inverse -> inv( P*H*inv(P) )
-		const int show_progress_steps = std::max(int(20), int(n / 20));
-		for (int l = n - 1; l >= 0; l--)
+	if (solver == SOLVER_SPARSE_QR)
+	{
+		// Build A x = g
+		// -----------------------
+		if (!d.A_valid)
 		{
-			if (!(l % show_progress_steps))
-				MRPT_LOG_DEBUG_FMT(
-					"Computing variance %6.02f%%... \r",
-					(100.0 * (n - l - 1)) / n);
+			mrpt::utils::CTimeLoggerEntry tle(
+				m_timelogger, "GMRF.build_A_pattern");
+			d.buildJacobianPattern(n);
+		}
+		Eigen::VectorXd g(m);  // Error vector
+		{
+			mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.build_A");
+			double* A_vals = d.A.valuePtr();
+			mrpt::utils::parallel_for_ranges(
+				m1, num_threads, [&](size_t, size_t first, size_t last) {
+					for (size_t k = first; k < last; k++)
+					{
+						A_vals[d.A_pos_unary[k]] = d.unary_J[k];
+						g[k] = -d.unary_r[k];
+					}
+				});
+			mrpt::utils::parallel_for_ranges(
+				m2, num_threads, [&](size_t, size_t first, size_t last) {
+					for (size_t k = first; k < last; k++)
+					{
+						if (d.A_pos_binary_i[k] == d.A_pos_binary_j[k])
+							A_vals[d.A_pos_binary_i[k]] =
+								d.binary_Ji[k] + d.binary_Jj[k];
+						else
+						{
+							A_vals[d.A_pos_binary_i[k]] = d.binary_Ji[k];
+							A_vals[d.A_pos_binary_j[k]] = d.binary_Jj[k];
+						}
+						g[m1 + k] = -d.binary_r[k];
+					}
+				});
+		}
 
-			// Computes variances in the inferior submatrix of "l"
-			double subSigmas = 0.0;
-			for (size_t j = l + 1; j < n; j++)
+		// Solve increment
+		// -----------------------
+		{
+			mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.solve");
+			if (!d.qr_analyzed)
 			{
-				if (UT.coeff(l, j) != 0)
-				{
-					// Compute off-diagonal variances Sigma(j,l) = Sigma(l,j);
+				d.qr.analyzePattern(d.A);
+				d.qr_analyzed = true;
+			}
+			d.qr.factorize(d.A);
+			solved_x_inc = d.qr.solve(g);
+		}
 
-					// SUM 1
-					double sum = 0.0;
-					for (size_t i = l + 1; i <= j; i++)
+		if (solved_variances)
+		{
+			// QR factor: A*P = Q*R --> P'*H*P = R'*R, thus L=R'
+			Eigen::SparseMatrix<double> R = d.qr.matrixR();
+			R.conservativeResize(n, n);
+			L = R.transpose();
+			L_perm = d.qr.colsPermutation().indices();
+		}
+	}
+	else
+	{
+		// Build H x = g
+		// -----------------------
+		if (!d.node_factors_valid || !d.H_valid)
+		{
+			mrpt::utils::CTimeLoggerEntry tle(
+				m_timelogger, "GMRF.build_H_pattern");
+			if (!d.node_factors_valid) d.buildNodeFactors(n);
+			if (!d.H_valid) d.buildNormalEquationsPattern(n);
+		}
+		Eigen::VectorXd g(n);  // Gradient
+		{
+			mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.build_H");
+			const int* outer = d.H.outerIndexPtr();
+			const int* inner = d.H.innerIndexPtr();
+			double* H_vals = d.H.valuePtr();
+			// Each thread fills whole columns:
+			mrpt::utils::parallel_for_ranges(
+				n, num_threads, [&](size_t, size_t first, size_t last) {
+					for (size_t c = first; c < last; c++)
 					{
-						if (UT.coeff(l, i) != 0)
+						double diag = 0, grad = 0;
+						for (size_t p = d.node_factors_ptr[c];
+							 p < d.node_factors_ptr[c + 1]; p++)
 						{
-							sum +=
-								UT.coeff(l, i) * solved_covariance.coeff(i, j);
+							const TNodeFactor& nf = d.node_factors[p];
+							double J, r;
+							switch (nf.kind)
+							{
+								case TNodeFactor::UNARY:
+									J = d.unary_J[nf.factor];
+									r = d.unary_r[nf.factor];
+									break;
+								case TNodeFactor::BINARY_I:
+									J = d.binary_Ji[nf.factor];
+									r = d.binary_r[nf.factor];
+									break;
+								case TNodeFactor::BINARY_J:
+									J = d.binary_Jj[nf.factor];
+									r = d.binary_r[nf.factor];
+									break;
+								default:
+									J = d.binary_Ji[nf.factor] +
+										d.binary_Jj[nf.factor];
+									r = d.binary_r[nf.factor];
+							};
+							diag += J * J;
+							grad -= J * r;
 						}
-					}
-					// SUM 2
-					for (size_t i = j + 1; i < n; ++i)
-					{
-						if (UT.coeff(l, i) != 0)
+						g[c] = grad;
+						for (int k = outer[c]; k < outer[c + 1]; k++)
 						{
-							sum +=
-								UT.coeff(l, i) * solved_covariance.coeff(j, i);
+							if (inner[k] == int(c))
+							{
+								H_vals[k] = diag;
+								continue;
+							}
+							double v = 0;
+							for (size_t q = d.H_factors_ptr[k];
+								 q < d.H_factors_ptr[k + 1]; q++)
+							{
+								const size_t f = d.H_factors[q];
+								v += d.binary_Ji[f] * d.binary_Jj[f];
+							}
+							H_vals[k] = v;
 						}
 					}
-					// Save off-diagonal variance (only Upper triangular)
-					solved_covariance.insert(l, j) = (-sum / UT.coeff(l, l));
-					subSigmas += UT.coeff(l, j) * solved_covariance.coeff(l, j);
-				}
-			}
-
-			solved_covariance.insert(l, l) =
-				(1 / UT.coeff(l, l)) * (1 / UT.coeff(l, l) - subSigmas);
+				});
 		}
 
-		MRPT_LOG_DEBUG_FMT("Computing variance %6.02f%%... \r", 100.0);
-
-		for (unsigned int i = 0; i < n; i++)
+		// Solve increment
+		// -----------------------
+		mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.solve");
+		if (solver == SOLVER_SPARSE_CHOLESKY)
 		{
-			const int idx = (int)solver.colsPermutation().indices().coeff(i);
-			const double variance = solved_covariance.coeff(i, i);
-			(*solved_variances)[idx] = variance;
+			if (!d.llt_analyzed)
+			{
+				d.llt.analyzePattern(d.H);
+				d.llt_analyzed = true;
+			}
+			d.llt.factorize(d.H);
+			ASSERTMSG_(
+				d.llt.info() == Eigen::Success,
+				"Sparse Cholesky failed: the system is not positive definite. "
+				"Are all nodes constrained?");
+			solved_x_inc = d.llt.solve(g);
+
+			if (solved_variances)
+			{
+				// P*H*P' = L*L'
+				L = d.llt.matrixL();
+				L_perm = d.llt.permutationPinv().indices();
+			}
 		}
+#if GMRF_HAS_PCG
+		else
+		{
+			if (!d.pcg_analyzed)
+			{
+				d.pcg.analyzePattern(d.H);
+				d.pcg_analyzed = true;
+			}
+			d.pcg.factorize(d.H);
+			ASSERTMSG_(
+				d.pcg.info() == Eigen::Success,
+				"Incomplete Cholesky failed: the system is not positive "
+				"definite. Are all nodes constrained?");
+			d.pcg.setTolerance(solverOptions.pcg_tolerance);
+			d.pcg.setMaxIterations(
+				solverOptions.pcg_max_iterations
+					? solverOptions.pcg_max_iterations
+					: 2 * n);
+			solved_x_inc = d.pcg.solveWithGuess(g, Eigen::VectorXd::Zero(n));
+			if (d.pcg.info() != Eigen::Success)
+				MRPT_LOG_WARN_FMT(
+					"PCG did not converge after %u iterations (error=%e)",
+					static_cast<unsigned int>(d.pcg.iterations()),
+					d.pcg.error());
+			else
+				MRPT_LOG_DEBUG_FMT(
+					"PCG converged in %u iterations (error=%e)",
+					static_cast<unsigned int>(d.pcg.iterations()),
+					d.pcg.error());
+		}
+#endif
+	}
 
+	// Recover covariance
+	// -----------------------
+	if (solved_variances)
+	{
+		mrpt::utils::CTimeLoggerEntry tle(m_timelogger, "GMRF.variance");
+		variancesFromCholeskyFactor(L, L_perm, *solved_variances);
 	}  // end calc variances
 
 #else
@@ -174,4 +174,145 @@ TEST(ScalarFactorGraph, MiniMRF_BinaryEdges)
 	}
 }
 
+// A grid of WxH nodes with priors between neighbors, and some observations:
+struct GridGMRF
+{
+	GridGMRF(const size_t W, const size_t H) : map(W * H, .0)
+	{
+		for (size_t y = 0; y < H; y++)
+			for (size_t x = 0; x < W; x++)
+			{
+				const size_t j = x + y * W;
+				if (x + 1 < W)
+					priors.push_back(MySimpleBinaryEdge(map, j + 1, j, 1.0));
+				if (y + 1 < H)
+					priors.push_back(MySimpleBinaryEdge(map, j + W, j, 1.0));
+				obs.push_back(
+					MySimpleUnaryEdge(
+						map, j, std::sin(0.1 * x) + 0.05 * y,
+						(j % 7) ? 1e-4 : 10.0));
+			}
+	}
+	void addTo(ScalarFactorGraph& gmrf)
+	{
+		gmrf.initialize(map.size());
+		for (const auto& e : priors) gmrf.addConstraint(e);
+		for (const auto& e : obs) gmrf.addConstraint(e);
+	}
+	vector<double> map;
+	std::deque<MySimpleBinaryEdge> priors;
+	std::deque<MySimpleUnaryEdge> obs;
+};
+
+TEST(ScalarFactorGraph, Solvers)
+{
+	GridGMRF grid(30, 20);
+	ScalarFactorGraph gmrf;
+	grid.addTo(gmrf);
+
+	Eigen::VectorXd x_qr, var_qr, x, var;
+	gmrf.updateEstimation(x_qr, &var_qr);
+
+	gmrf.solverOptions.solver = ScalarFactorGraph::SOLVER_SPARSE_CHOLESKY;
+	gmrf.updateEstimation(x, &var);
+	EXPECT_LT((x - x_qr).array().abs().maxCoeff(), 1e-8);
+	EXPECT_LT((var - var_qr).array().abs().maxCoeff(), 1e-8);
+
+	gmrf.solverOptions.solver = ScalarFactorGraph::SOLVER_PCG;
+	gmrf.updateEstimation(x);
+	EXPECT_LT((x - x_qr).array().abs().maxCoeff(), 1e-5);
+
+	// Variances (with PCG, solved with Cholesky):
+	gmrf.updateEstimation(x, &var);
+	EXPECT_LT((x - x_qr).array().abs().maxCoeff(), 1e-8);
+	EXPECT_LT((var - var_qr).array().abs().maxCoeff(), 1e-8);
+}
+
+TEST(ScalarFactorGraph, CachedPatternAndThreads)
+{
+	// Large enough to be solved in parallel:
+	GridGMRF grid(200, 150);
+	ScalarFactorGraph gmrf;
+	gmrf.solverOptions.solver = ScalarFactorGraph::SOLVER_SPARSE_CHOLESKY;
+	gmrf.solverOptions.num_threads = 1;
+	grid.addTo(gmrf);
+
+	Eigen::VectorXd x1, var1, x;
+	gmrf.updateEstimation(x1, &var1);
+
+	// Same results: with several threads, and with devirtualized factors:
+	gmrf.solverOptions.num_threads = 4;
+	gmrf.updateEstimation(x);
+	EXPECT_EQ((x - x1).array().abs().maxCoeff(), 0);
+	gmrf.registerFactorType<MySimpleUnaryEdge>();
+	gmrf.registerFactorType<MySimpleBinaryEdge>();
+	gmrf.updateEstimation(x);
+	EXPECT_EQ((x - x1).array().abs().maxCoeff(), 0);
+
+	// New constraints, and a change of the current estimate:
+	grid.obs.push_back(MySimpleUnaryEdge(grid.map, 1234, 5.0, 100.0));
+	gmrf.addConstraint(grid.obs.back());
+	for (size_t i = 0; i < grid.map.size(); i++) grid.map[i] = x1[i];
+	gmrf.updateEstimation(x);
+
+	ScalarFactorGraph gmrf_new;
+	gmrf_new.solverOptions.solver = ScalarFactorGraph::SOLVER_SPARSE_CHOLESKY;
+	grid.addTo(gmrf_new);
+	Eigen::VectorXd x2;
+	gmrf_new.updateEstimation(x2);
+	EXPECT_LT((x - x2).array().abs().maxCoeff(), 1e-8);
+	EXPECT_GT(std::abs(x[1234]), 1.0);
+
+	// Removing it goes back to the first solution:
+	EXPECT_TRUE(gmrf.eraseConstraint(grid.obs.back()));
+	gmrf.updateEstimation(x);
+	EXPECT_LT(x.array().abs().maxCoeff(), 1e-8);
+}
+
+TEST(ScalarFactorGraph, RobustKernels)
+{
+	const size_t N = 2;
+	vector<double> my_map(N, .0);
+	// Several observations of node 0 (one of them, an outlier), and node 1
+	// tied to node 0:
+	std::deque<MySimpleUnaryEdge> obs;
+	for (int i = 0; i < 5; i++)
+		obs.push_back(MySimpleUnaryEdge(my_map, 0, 1.0 + 0.01 * i, 1.0));
+	obs.push_back(MySimpleUnaryEdge(my_map, 0, 50.0, 1.0));
+	MySimpleBinaryEdge edge_01(my_map, 0, 1, 1.0);
+
+	for (int kernel = ScalarFactorGraph::ROBUST_KERNEL_NONE;
+		 kernel <= ScalarFactorGraph::ROBUST_KERNEL_CAUCHY; kernel++)
+	{
+		ScalarFactorGraph gmrf;
+		gmrf.solverOptions.robust_kernel =
+			static_cast<ScalarFactorGraph::TRobustKernel>(kernel);
+		gmrf.initialize(N);
+		for (const auto& e : obs) gmrf.addConstraint(e);
+		gmrf.addConstraint(edge_01);
+
+		// Iteratively reweighted LSQ:
+		my_map.assign(N, .0);
+		Eigen::VectorXd x_incr;
+		for (int iter = 0; iter < 20; iter++)
+		{
+			gmrf.updateEstimation(x_incr);
+			for (size_t i = 0; i < N; i++) my_map[i] += x_incr[i];
+		}
+		const double k = gmrf.solverOptions.robust_kernel_param;
+		if (kernel == ScalarFactorGraph::ROBUST_KERNEL_NONE)
+			EXPECT_NEAR(my_map[0], (5.1 + 50.0) / 6, 1e-6);
+		else if (kernel == ScalarFactorGraph::ROBUST_KERNEL_HUBER)
+			// The outlier pulls with a constant "force" k (the inliers have
+			// residuals below k): 5*(x-1.02) = k
+			EXPECT_NEAR(my_map[0], 1.02 + k / 5, 1e-6);
+		else  // Cauchy: the influence of the outlier almost vanishes
+		{
+			EXPECT_GT(my_map[0], 1.02);
+			EXPECT_LT(my_map[0], 1.1);
+		}
+		EXPECT_NEAR(my_map[1], my_map[0], 1e-6);
+	}
+}
+
 #endif  // Eigen>=3.1
@@ -15,6 +15,7 @@
 
 // Graph SLAM: Batch solvers
 #include "graphslam/levmarq.h"
+#include "graphslam/marginalization.h"
 
 // Interfaces for implementing deciders/optimizers
 #include "graphslam/interfaces/CRegistrationDeciderOrOptimizer.h"
@@ -36,6 +37,7 @@
 // GraphSlamOptimizers
 #include "graphslam/GSO/CEmptyGSO.h"
 #include "graphslam/GSO/CLevMarqGSO.h"
+#include "graphslam/GSO/CIncrementalSmootherGSO.h"
 
 // Graph SLAM Engine - Relevant headers
 #include "graphslam/misc/CRangeScanOps.h"
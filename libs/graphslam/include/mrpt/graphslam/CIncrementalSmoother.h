@@ -0,0 +1,565 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/graphslam/types.h>
+#include <mrpt/graphslam/levmarq.h>
+#include <mrpt/utils/aligned_containers.h>
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphslam
+{
+/** Incremental smoothing of pose graphs, in the spirit of iSAM2: the
+ * Cholesky factor of the Gauss-Newton system is kept between calls to
+ * update(), and only the part affected by new nodes, new edges or
+ * relinearized nodes is recomputed.
+ *
+ * Each call to update():
+ *  - Detects the nodes and edges added to the graph since the last call.
+ *    Each new node becomes a variable, with its current pose in
+ *    `graph.nodes` as initial linearization point. The root node is fixed.
+ *  - Fluid relinearization: nodes whose last computed increment is larger
+ *    than TOptions::relinearize_threshold get their linearization point
+ *    updated, and all their edges are relinearized.
+ *  - Recomputes the block-columns of the Cholesky factor L from the first
+ *    affected variable, and does the back-substitution only for those
+ *    variables whose increment changes more than
+ *    TOptions::wildfire_threshold ("wildfire" propagation).
+ *  - Writes the new estimates of the updated nodes into `graph.nodes`.
+ *
+ * Variables are ordered as they are added, that is, by node ID for each
+ * batch of new nodes. For trajectories this ordering keeps the affected part
+ * of the factor small: adding a node with odometry edges costs a constant
+ * time, and a loop closure between nodes `i` and `j` refactors the columns
+ * from `i` onwards. Variables are never reordered.
+ *
+ * If the system turns out not to be positive definite, the whole graph is
+ * optimized with optimize_graph_spa_levmarq() and the factorization is
+ * rebuilt from scratch. Removing edges or changing the root node also resets
+ * the smoother.
+ *
+ * The graph must be the same object in all calls to update(), and its
+ * nodes should not be modified by the user in between.
+ *
+ * \sa optimize_graph_spa_levmarq(),
+ * mrpt::graphslam::optimizers::CIncrementalSmootherGSO
+ * \ingroup mrpt_graphslam_grp
+ */
+template <class GRAPH_T>
+class CIncrementalSmoother
+{
+   public:
+	typedef graphslam_traits<GRAPH_T> gst;
+	typedef typename gst::graph_t::constraint_t::type_value pose_t;
+	static const int DIMS_POSE = gst::SE_TYPE::VECTOR_SIZE;
+	typedef Eigen::Matrix<double, DIMS_POSE, DIMS_POSE> block_t;
+	typedef Eigen::Matrix<double, DIMS_POSE, 1> vector_t;
+	typedef typename mrpt::aligned_containers<block_t>::vector_t block_list_t;
+
+	struct TOptions
+	{
+		TOptions()
+			: relinearize_threshold(0.1),
+			  relinearize_skip(1),
+			  wildfire_threshold(1e-3)
+		{
+		}
+		/** Relinearize a node when the absolute value of any component of its
+		 * increment (in the SE(2)/SE(3) tangent space) is above this. */
+		double relinearize_threshold;
+		/** Check for nodes to relinearize only once every N updates. */
+		unsigned int relinearize_skip;
+		/** Stop the back-substitution at variables whose increment changes
+		 * less than this (inf-norm). */
+		double wildfire_threshold;
+	};
+	TOptions options;
+
+	/** Statistics of the last call to update() */
+	struct TUpdateInfo
+	{
+		TUpdateInfo()
+			: new_nodes(0),
+			  new_edges(0),
+			  relinearized_nodes(0),
+			  refactored_columns(0),
+			  updated_poses(0),
+			  full_reset(false)
+		{
+		}
+		size_t new_nodes, new_edges;
+		/** Nodes whose linearization point was updated */
+		size_t relinearized_nodes;
+		/** Block-columns of the Cholesky factor that were recomputed */
+		size_t refactored_columns;
+		/** Nodes whose estimate changed in `graph.nodes` */
+		size_t updated_poses;
+		/** Whether the whole graph had to be optimized in batch */
+		bool full_reset;
+	};
+
+	CIncrementalSmoother() : m_num_updates(0), m_root(0) {}
+	/** Incorporates the new nodes and edges of `graph`, and updates the node
+	 * poses in `graph.nodes` with the new estimate.
+	 * \exception mrpt::math::CExceptionNotDefPos If the problem is not
+	 * well-posed (e.g. nodes not connected to the root).
+	 */
+	void update(GRAPH_T& graph, TUpdateInfo* out_info = nullptr);
+
+	/** Forgets all the variables, edges and the factorization. */
+	void clear();
+
+	/** Number of nodes being optimized (all but the root) */
+	size_t getVariableCount() const { return m_vars.size(); }
+	/** Number of non-zero blocks in the Cholesky factor */
+	size_t getFactorSize() const
+	{
+		size_t n = 0;
+		for (const auto& c : m_L) n += c.rows.size();
+		return n;
+	}
+
+   private:
+	static const size_t INVALID_IDX = static_cast<size_t>(-1);
+
+	struct TVariable
+	{
+		mrpt::utils::TNodeID id;
+		pose_t lin_point;
+		/** Increment (minus) of the last solution: x = exp(-delta) * lin_pt */
+		vector_t delta;
+		/** Right hand side after forward substitution: L*y = grad */
+		vector_t y;
+		/** Indices in m_factors of the edges involving this node */
+		std::vector<size_t> factors;
+	};
+	struct TFactor
+	{
+		typename gst::edge_const_iterator edge;
+		/** Variable indices, or INVALID_IDX for the fixed root node */
+		size_t var1, var2;
+		typename gst::matrix_VxV_t J1, J2;
+		typename gst::Array_O err;
+	};
+	/** Block-column of L: the diagonal block first, then sorted rows */
+	struct TColumn
+	{
+		std::vector<size_t> rows;
+		block_list_t blocks;
+	};
+
+	typename mrpt::aligned_containers<TVariable>::vector_t m_vars;
+	std::map<mrpt::utils::TNodeID, size_t> m_id2var;
+	typename mrpt::aligned_containers<TFactor>::vector_t m_factors;
+	/** Edges already incorporated (addresses of the elements in
+	 * graph.edges) */
+	std::unordered_set<const void*> m_known_edges;
+	std::vector<TColumn> m_L;
+	/** For each row j, the sorted columns i<j with L(j,i)!=0 */
+	std::vector<std::vector<size_t>> m_L_row_cols;
+	/** Variables whose increment changed in the last updates */
+	std::vector<size_t> m_relin_candidates;
+	size_t m_num_updates;
+	mrpt::utils::TNodeID m_root;
+	/** Workspace for refactorize(), kept to avoid O(N) allocations */
+	std::vector<size_t> m_ws_pos;
+	std::vector<char> m_ws_queued;
+
+	const pose_t& nodePose(
+		const GRAPH_T& graph, const mrpt::utils::TNodeID id) const
+	{
+		const auto it = graph.nodes.find(id);
+		ASSERTMSG_(
+			it != graph.nodes.end(),
+			"Node in an edge does not have a global pose in 'graph.nodes'.")
+		return it->second;
+	}
+	void linearize(const GRAPH_T& graph, TFactor& f) const;
+	/** Recomputes the columns [k,N) of L and y. */
+	void refactorize(const size_t k);
+	/** Back-substitution with wildfire propagation. Returns the variables
+	 * whose increment was recomputed. */
+	void backsubstitute(const size_t k, std::vector<size_t>& out_visited);
+	void incrementalUpdate(GRAPH_T& graph, TUpdateInfo& info);
+};
+
+template <class GRAPH_T>
+const int CIncrementalSmoother<GRAPH_T>::DIMS_POSE;
+template <class GRAPH_T>
+const size_t CIncrementalSmoother<GRAPH_T>::INVALID_IDX;
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::clear()
+{
+	m_vars.clear();
+	m_id2var.clear();
+	m_factors.clear();
+	m_known_edges.clear();
+	m_L.clear();
+	m_L_row_cols.clear();
+	m_relin_candidates.clear();
+	m_num_updates = 0;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::update(
+	GRAPH_T& graph, TUpdateInfo* out_info)
+{
+	MRPT_START
+
+	TUpdateInfo info;
+	// Edges removed or a new root invalidate all our state:
+	if (graph.edges.size() < m_known_edges.size() ||
+		(!m_vars.empty() && graph.root != m_root))
+		clear();
+	m_root = graph.root;
+
+	try
+	{
+		incrementalUpdate(graph, info);
+	}
+	catch (mrpt::math::CExceptionNotDefPos&)
+	{
+		// Batch optimization, then start over from its solution:
+		TResultInfoSpaLevMarq levmarq_info;
+		optimize_graph_spa_levmarq(graph, levmarq_info);
+		clear();
+		info = TUpdateInfo();
+		incrementalUpdate(graph, info);
+		info.full_reset = true;
+	}
+	m_num_updates++;
+	if (out_info) *out_info = info;
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::incrementalUpdate(
+	GRAPH_T& graph, TUpdateInfo& info)
+{
+	// First variable whose column in L must be recomputed:
+	size_t k = m_vars.size();
+	std::vector<size_t> factors_to_linearize;
+
+	// 1) New edges and nodes:
+	if (graph.edges.size() != m_known_edges.size())
+	{
+		std::vector<typename gst::edge_const_iterator> new_edges;
+		std::set<mrpt::utils::TNodeID> new_ids;  // Sorted
+		for (typename gst::edge_const_iterator it = graph.edges.begin();
+			 it != graph.edges.end(); ++it)
+		{
+			if (!m_known_edges.insert(&(*it)).second) continue;
+			new_edges.push_back(it);
+			for (const mrpt::utils::TNodeID id :
+				 {it->first.first, it->first.second})
+				if (id != graph.root && m_id2var.find(id) == m_id2var.end())
+					new_ids.insert(id);
+		}
+		for (const mrpt::utils::TNodeID id : new_ids)
+		{
+			TVariable v;
+			v.id = id;
+			v.lin_point = nodePose(graph, id);
+			v.delta.setZero();
+			v.y.setZero();
+			m_id2var[id] = m_vars.size();
+			m_vars.push_back(v);
+		}
+		for (const auto& it : new_edges)
+		{
+			TFactor f;
+			f.edge = it;
+			const auto it1 = m_id2var.find(it->first.first);
+			const auto it2 = m_id2var.find(it->first.second);
+			f.var1 = (it1 != m_id2var.end()) ? it1->second : INVALID_IDX;
+			f.var2 = (it2 != m_id2var.end()) ? it2->second : INVALID_IDX;
+			if (f.var1 == INVALID_IDX && f.var2 == INVALID_IDX) continue;
+
+			const size_t fi = m_factors.size();
+			m_factors.push_back(f);
+			factors_to_linearize.push_back(fi);
+			if (f.var1 != INVALID_IDX)
+			{
+				m_vars[f.var1].factors.push_back(fi);
+				k = std::min(k, f.var1);
+			}
+			if (f.var2 != INVALID_IDX && f.var2 != f.var1)
+			{
+				m_vars[f.var2].factors.push_back(fi);
+				k = std::min(k, f.var2);
+			}
+		}
+		info.new_nodes = new_ids.size();
+		info.new_edges = factors_to_linearize.size();
+	}
+
+	// 2) Fluid relinearization:
+	if (options.relinearize_skip <= 1 ||
+		(m_num_updates % options.relinearize_skip) == 0)
+	{
+		std::sort(m_relin_candidates.begin(), m_relin_candidates.end());
+		m_relin_candidates.erase(
+			std::unique(m_relin_candidates.begin(), m_relin_candidates.end()),
+			m_relin_candidates.end());
+		for (const size_t v : m_relin_candidates)
+		{
+			TVariable& var = m_vars[v];
+			if (var.delta.template lpNorm<Eigen::Infinity>() <=
+				options.relinearize_threshold)
+				continue;
+
+			typename gst::Array_O exp_delta;
+			for (int i = 0; i < DIMS_POSE; i++) exp_delta[i] = -var.delta[i];
+			pose_t exp_delta_pose(mrpt::poses::UNINITIALIZED_POSE);
+			gst::SE_TYPE::exp(exp_delta, exp_delta_pose);
+			const pose_t old_lin_point = var.lin_point;
+			var.lin_point.composeFrom(exp_delta_pose, old_lin_point);
+			var.delta.setZero();
+			info.relinearized_nodes++;
+
+			for (const size_t fi : var.factors)
+			{
+				factors_to_linearize.push_back(fi);
+				const TFactor& f = m_factors[fi];
+				if (f.var1 != INVALID_IDX) k = std::min(k, f.var1);
+				if (f.var2 != INVALID_IDX) k = std::min(k, f.var2);
+			}
+		}
+		m_relin_candidates.clear();
+	}
+
+	if (k >= m_vars.size()) return;  // Nothing changed
+
+	// 3) Linearize new and affected edges:
+	std::sort(factors_to_linearize.begin(), factors_to_linearize.end());
+	factors_to_linearize.erase(
+		std::unique(factors_to_linearize.begin(), factors_to_linearize.end()),
+		factors_to_linearize.end());
+	for (const size_t fi : factors_to_linearize)
+		linearize(graph, m_factors[fi]);
+
+	// 4) Update the factorization and solve:
+	refactorize(k);
+	info.refactored_columns = m_vars.size() - k;
+
+	std::vector<size_t> visited;
+	backsubstitute(k, visited);
+
+	// 5) New estimates:
+	for (const size_t j : visited)
+	{
+		const TVariable& var = m_vars[j];
+		typename gst::Array_O exp_delta;
+		for (int i = 0; i < DIMS_POSE; i++) exp_delta[i] = -var.delta[i];
+		pose_t exp_delta_pose(mrpt::poses::UNINITIALIZED_POSE);
+		gst::SE_TYPE::exp(exp_delta, exp_delta_pose);
+
+		pose_t& P = graph.nodes[var.id];
+		P.composeFrom(exp_delta_pose, var.lin_point);
+	}
+	info.updated_poses = visited.size();
+	m_relin_candidates.insert(
+		m_relin_candidates.end(), visited.begin(), visited.end());
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::linearize(
+	const GRAPH_T& graph, TFactor& f) const
+{
+	const pose_t& P1 = f.var1 != INVALID_IDX
+						   ? m_vars[f.var1].lin_point
+						   : nodePose(graph, f.edge->first.first);
+	const pose_t& P2 = f.var2 != INVALID_IDX
+						   ? m_vars[f.var2].lin_point
+						   : nodePose(graph, f.edge->first.second);
+
+	// P1DP2inv = P1 * EDGE * inv(P2), as in computeJacobiansAndErrors()
+	pose_t P1DP2inv(mrpt::poses::UNINITIALIZED_POSE);
+	{
+		pose_t P1D(mrpt::poses::UNINITIALIZED_POSE);
+		P1D.composeFrom(P1, f.edge->second.getPoseMean());
+		const pose_t P2inv = -P2;
+		P1DP2inv.composeFrom(P1D, P2inv);
+	}
+	detail::AuxErrorEval<typename gst::edge_t, gst>::computePseudoLnError(
+		P1DP2inv, f.err, f.edge);
+	gst::SE_TYPE::jacobian_dP1DP2inv_depsilon(P1DP2inv, &f.J1, &f.J2);
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::refactorize(const size_t k)
+{
+	typedef detail::AuxErrorEval<typename gst::edge_t, gst> aux_t;
+	const size_t N = m_vars.size();
+	m_L.resize(N);
+	m_L_row_cols.resize(N);
+	m_ws_pos.resize(N, INVALID_IDX);
+
+	// Columns >=k will be rebuilt:
+	for (size_t r = k; r < N; r++)
+	{
+		auto& rc = m_L_row_cols[r];
+		rc.erase(std::lower_bound(rc.begin(), rc.end(), k), rc.end());
+	}
+
+	std::vector<size_t> rows;
+	block_list_t acc;
+	typename gst::matrix_VxV_t JtJ;
+	for (size_t j = k; j < N; j++)
+	{
+		rows.clear();
+		acc.clear();
+		auto entry = [&](const size_t r) -> block_t& {
+			if (m_ws_pos[r] == INVALID_IDX)
+			{
+				m_ws_pos[r] = rows.size();
+				rows.push_back(r);
+				acc.push_back(block_t::Zero());
+			}
+			return acc[m_ws_pos[r]];
+		};
+		entry(j);
+
+		// Column j of H = J^t*Inf*J and gradient J^t*Inf*err:
+		typename gst::Array_O grad;
+		grad.fill(0);
+		for (const size_t fi : m_vars[j].factors)
+		{
+			const TFactor& f = m_factors[fi];
+			if (f.var1 == j)
+			{
+				aux_t::multiplyJtLambdaJ(f.J1, JtJ, f.edge);
+				entry(j) += JtJ;
+				aux_t::multiply_Jt_W_err(f.J1, f.edge, f.err, grad);
+			}
+			if (f.var2 == j)
+			{
+				aux_t::multiplyJtLambdaJ(f.J2, JtJ, f.edge);
+				entry(j) += JtJ;
+				aux_t::multiply_Jt_W_err(f.J2, f.edge, f.err, grad);
+			}
+			if (f.var1 == INVALID_IDX || f.var2 == INVALID_IDX) continue;
+			// JtJ = H(var1,var2)
+			aux_t::multiplyJ1tLambdaJ2(f.J1, f.J2, JtJ, f.edge);
+			if (f.var1 == f.var2)
+			{
+				entry(j) += JtJ;
+				entry(j) += JtJ.transpose();
+			}
+			else if (f.var1 == j && f.var2 > j)
+				entry(f.var2) += JtJ.transpose();
+			else if (f.var2 == j && f.var1 > j)
+				entry(f.var1) += JtJ;
+		}
+		vector_t rhs;
+		for (int i = 0; i < DIMS_POSE; i++) rhs[i] = grad[i];
+
+		// Left-looking update with the previous columns: for each i<j with
+		// L(j,i)!=0, H(r,j) -= L(r,i)*L(j,i)^T for r>=j
+		for (const size_t i : m_L_row_cols[j])
+		{
+			const TColumn& ci = m_L[i];
+			const size_t p =
+				std::lower_bound(ci.rows.begin() + 1, ci.rows.end(), j) -
+				ci.rows.begin();
+			const block_t& Lji = ci.blocks[p];
+			for (size_t q = p; q < ci.rows.size(); q++)
+				entry(ci.rows[q]).noalias() -= ci.blocks[q] * Lji.transpose();
+			rhs.noalias() -= Lji * m_vars[i].y;
+		}
+
+		// Build column j:
+		TColumn& cj = m_L[j];
+		cj.rows.assign(1, j);
+		std::vector<size_t> sorted_rows(rows.begin() + 1, rows.end());
+		std::sort(sorted_rows.begin(), sorted_rows.end());
+		cj.rows.insert(cj.rows.end(), sorted_rows.begin(), sorted_rows.end());
+
+		Eigen::LLT<block_t> llt(acc[0]);
+		if (llt.info() != Eigen::Success)
+		{
+			for (const size_t r : rows) m_ws_pos[r] = INVALID_IDX;
+			throw mrpt::math::CExceptionNotDefPos(
+				"CIncrementalSmoother: Not positive definite matrix.");
+		}
+		const block_t Ljj = llt.matrixL();
+		const block_t Ujj = Ljj.transpose();
+		cj.blocks.resize(cj.rows.size());
+		cj.blocks[0] = Ljj;
+		for (size_t q = 1; q < cj.rows.size(); q++)
+		{
+			const size_t r = cj.rows[q];
+			block_t& Lrj = cj.blocks[q];
+			Lrj = acc[m_ws_pos[r]];
+			Ujj.template triangularView<Eigen::Upper>()
+				.template solveInPlace<Eigen::OnTheRight>(Lrj);
+			m_L_row_cols[r].push_back(j);
+		}
+		for (const size_t r : rows) m_ws_pos[r] = INVALID_IDX;
+
+		// Forward substitution: L(j,j) * y_j = rhs
+		Ljj.template triangularView<Eigen::Lower>().solveInPlace(rhs);
+		m_vars[j].y = rhs;
+	}
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::backsubstitute(
+	const size_t k, std::vector<size_t>& out_visited)
+{
+	const size_t N = m_vars.size();
+	m_ws_queued.resize(N, 0);
+	std::priority_queue<size_t> queue;  // Largest index first
+	for (size_t j = k; j < N; j++)
+	{
+		queue.push(j);
+		m_ws_queued[j] = 1;
+	}
+	out_visited.clear();
+	while (!queue.empty())
+	{
+		const size_t j = queue.top();
+		queue.pop();
+		m_ws_queued[j] = 0;
+		out_visited.push_back(j);
+
+		// L(j,j)^T * delta_j = y_j - sum_r L(r,j)^T * delta_r
+		const TColumn& cj = m_L[j];
+		vector_t d = m_vars[j].y;
+		for (size_t q = 1; q < cj.rows.size(); q++)
+			d.noalias() -= cj.blocks[q].transpose() * m_vars[cj.rows[q]].delta;
+		const block_t Ujj = cj.blocks[0].transpose();
+		Ujj.template triangularView<Eigen::Upper>().solveInPlace(d);
+
+		const double change =
+			(d - m_vars[j].delta).template lpNorm<Eigen::Infinity>();
+		m_vars[j].delta = d;
+		if (change <= options.wildfire_threshold) continue;
+
+		// Propagate to the variables depending on this one:
+		for (const size_t i : m_L_row_cols[j])
+		{
+			if (m_ws_queued[i]) continue;
+			m_ws_queued[i] = 1;
+			queue.push(i);
+		}
+	}
+}
+
+}  // End of namespace
+}  // End of namespace
@@ -185,59 +185,68 @@ void CICPCriteriaERD<GRAPH_T>::checkRegistrationCondition2D(
 	// commence only if I have the current laser scan
 	if (curr_laser_scan)
 	{
-		// try adding ICP constraints with each node in the previous set
+		// get the ICP edges between the current and each node in the previous
+		// set, all at once. Laser scans are kept alive in the nodes map.
+		std::vector<mrpt::utils::TNodeID> job_nodes;
+		std::vector<typename range_ops_t::template TICPEdgeJob<
+			CObservation2DRangeScan>>
+			icp_jobs;
 		for (std::set<mrpt::utils::TNodeID>::const_iterator node_it =
 				 nodes_set.begin();
 			 node_it != nodes_set.end(); ++node_it)
 		{
-			// get the ICP edge between current and last node
-			constraint_t rel_edge;
-			mrpt::slam::CICP::TReturnInfo icp_info;
-			CObservation2DRangeScan::Ptr prev_laser_scan;
-
 			// search for prev_laser_scan
 			search = this->m_nodes_to_laser_scans2D.find(*node_it);
 			if (search != this->m_nodes_to_laser_scans2D.end())
 			{
-				prev_laser_scan = search->second;
-
+				icp_jobs.resize(icp_jobs.size() + 1);
+				icp_jobs.back().from_scan = search->second.get();
+				icp_jobs.back().to_scan = curr_laser_scan.get();
 				// make use of initial node position difference for the ICP edge
-				pose_t initial_pose = this->m_graph->nodes[curr_nodeID] -
-									  this->m_graph->nodes[*node_it];
-
-				this->m_time_logger.enter("CICPCriteriaERD::getICPEdge");
-				this->getICPEdge(
-					*prev_laser_scan, *curr_laser_scan, &rel_edge,
-					&initial_pose, &icp_info);
-				this->m_time_logger.leave("CICPCriteriaERD::getICPEdge");
-
-				// Debugging statements
-				MRPT_LOG_DEBUG_STREAM(
-					">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>"
-					">>>>>>>>>");
-				MRPT_LOG_DEBUG_STREAM(
-					"ICP constraint between NON-successive nodes: "
-					<< *node_it << " => " << curr_nodeID << std::endl
-					<< "\tnIterations = " << icp_info.nIterations
-					<< "\tgoodness = " << icp_info.goodness);
-				MRPT_LOG_DEBUG_STREAM(
-					"ICP_goodness_thresh: " << params.ICP_goodness_thresh);
-				MRPT_LOG_DEBUG_STREAM(
-					"<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<"
-					"<<<<<<<<<");
-
-				// criterion for registering a new node
-				if (icp_info.goodness > params.ICP_goodness_thresh)
+				icp_jobs.back().initial_pose =
+					this->m_graph->nodes[curr_nodeID] -
+					this->m_graph->nodes[*node_it];
+				icp_jobs.back().has_initial_pose = true;
+				job_nodes.push_back(*node_it);
+			}
+		}
+		this->m_time_logger.enter("CICPCriteriaERD::getICPEdge");
+		this->getICPEdges(icp_jobs);
+		this->m_time_logger.leave("CICPCriteriaERD::getICPEdge");
+
+		// try adding ICP constraints with each node in the previous set
+		for (size_t i = 0; i < icp_jobs.size(); i++)
+		{
+			const mrpt::utils::TNodeID node = job_nodes[i];
+			const constraint_t& rel_edge = icp_jobs[i].rel_edge;
+			const mrpt::slam::CICP::TReturnInfo& icp_info =
+				icp_jobs[i].icp_info;
+
+			// Debugging statements
+			MRPT_LOG_DEBUG_STREAM(
+				">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>"
+				">>>>>>>>>");
+			MRPT_LOG_DEBUG_STREAM(
+				"ICP constraint between NON-successive nodes: "
+				<< node << " => " << curr_nodeID << std::endl
+				<< "\tnIterations = " << icp_info.nIterations
+				<< "\tgoodness = " << icp_info.goodness);
+			MRPT_LOG_DEBUG_STREAM(
+				"ICP_goodness_thresh: " << params.ICP_goodness_thresh);
+			MRPT_LOG_DEBUG_STREAM(
+				"<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<"
+				"<<<<<<<<<");
+
+			// criterion for registering a new node
+			if (icp_info.goodness > params.ICP_goodness_thresh)
+			{
+				this->registerNewEdge(node, curr_nodeID, rel_edge);
+				m_edge_types_to_nums["ICP2D"]++;
+				// in case of loop closure
+				if (absDiff(curr_nodeID, node) > params.LC_min_nodeid_diff)
 				{
-					this->registerNewEdge(*node_it, curr_nodeID, rel_edge);
-					m_edge_types_to_nums["ICP2D"]++;
-					// in case of loop closure
-					if (absDiff(curr_nodeID, *node_it) >
-						params.LC_min_nodeid_diff)
-					{
-						m_edge_types_to_nums["LC"]++;
-						this->m_just_inserted_lc = true;
-					}
+					m_edge_types_to_nums["LC"]++;
+					this->m_just_inserted_lc = true;
 				}
 			}
 		}
@@ -268,41 +277,49 @@ void CICPCriteriaERD<GRAPH_T>::checkRegistrationCondition3D(
 	// commence only if I have the current laser scan
 	if (curr_laser_scan)
 	{
-		// try adding ICP constraints with each node in the previous set
+		// get the ICP edges between the current and each node in the previous
+		// set, all at once. Laser scans are kept alive in the nodes map.
+		std::vector<mrpt::utils::TNodeID> job_nodes;
+		std::vector<typename range_ops_t::template TICPEdgeJob<
+			CObservation3DRangeScan>>
+			icp_jobs;
 		for (set<mrpt::utils::TNodeID>::const_iterator node_it =
 				 nodes_set.begin();
 			 node_it != nodes_set.end(); ++node_it)
 		{
-			// get the ICP edge between current and last node
-			constraint_t rel_edge;
-			mrpt::slam::CICP::TReturnInfo icp_info;
-			CObservation3DRangeScan::Ptr prev_laser_scan;
-
 			// search for prev_laser_scan
 			search = m_nodes_to_laser_scans3D.find(*node_it);
 			if (search != m_nodes_to_laser_scans3D.end())
 			{
-				prev_laser_scan = search->second;
-
 				// TODO - use initial edge estimation
-				this->m_time_logger.enter("CICPCriteriaERD::getICPEdge");
-				this->getICPEdge(
-					*prev_laser_scan, *curr_laser_scan, &rel_edge, nullptr,
-					&icp_info);
-				this->m_time_logger.leave("CICPCriteriaERD::getICPEdge");
-
-				// criterion for registering a new node
-				if (icp_info.goodness > params.ICP_goodness_thresh)
+				icp_jobs.resize(icp_jobs.size() + 1);
+				icp_jobs.back().from_scan = search->second.get();
+				icp_jobs.back().to_scan = curr_laser_scan.get();
+				job_nodes.push_back(*node_it);
+			}
+		}
+		this->m_time_logger.enter("CICPCriteriaERD::getICPEdge");
+		this->getICPEdges(icp_jobs);
+		this->m_time_logger.leave("CICPCriteriaERD::getICPEdge");
+
+		// try adding ICP constraints with each node in the previous set
+		for (size_t i = 0; i < icp_jobs.size(); i++)
+		{
+			const mrpt::utils::TNodeID node = job_nodes[i];
+			const constraint_t& rel_edge = icp_jobs[i].rel_edge;
+			const mrpt::slam::CICP::TReturnInfo& icp_info =
+				icp_jobs[i].icp_info;
+
+			// criterion for registering a new node
+			if (icp_info.goodness > params.ICP_goodness_thresh)
+			{
+				this->registerNewEdge(node, curr_nodeID, rel_edge);
+				m_edge_types_to_nums["ICP3D"]++;
+				// in case of loop closure
+				if (absDiff(curr_nodeID, node) > params.LC_min_nodeid_diff)
 				{
-					this->registerNewEdge(*node_it, curr_nodeID, rel_edge);
-					m_edge_types_to_nums["ICP3D"]++;
-					// in case of loop closure
-					if (absDiff(curr_nodeID, *node_it) >
-						params.LC_min_nodeid_diff)
-					{
-						m_edge_types_to_nums["LC"]++;
-						this->m_just_inserted_lc = true;
-					}
+					m_edge_types_to_nums["LC"]++;
+					this->m_just_inserted_lc = true;
 				}
 			}
 		}
@@ -44,6 +44,7 @@
 #include <mrpt/graphslam/misc/TNodeProps.h>
 #include <mrpt/graphs/THypothesis.h>
 #include <mrpt/graphs/CHypothesisNotFoundException.h>
+#include <mrpt/graphs/CShortestPathTrees.h>
 
 #include <Eigen/Dense>
 
@@ -218,6 +219,17 @@ exponential.
  *   + \a Description   : Minimum ratio of the two dominant eigenvalues for a
  *   loop closing hypotheses set to be considered valid
  *
+ * - \b LC_enough_valid_hypots
+ *   + \a Section       : EdgeRegistrationDeciderParameters
+ *   + \a Default value : 0
+ *   + \a Required      : FALSE
+ *   + \a Description   : The ICP alignments between the groups of a
+ *   partition run in parallel (see the \b num_threads parameter of the ICP
+ *   section). Once this many valid hypotheses have been found, the pending
+ *   alignments are cancelled and the consistency test goes on with the
+ *   hypotheses found so far. Since alignments finish in any order, the
+ *   results are not deterministic. 0 disables the early cancellation.
+ *
  * - \b LC_check_curr_partition_only
  *   + \a Section       : EdgeRegistrationDeciderParameters
  *   + \a Default value : TRUE
@@ -256,6 +268,9 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 	typedef typename GRAPH_T::global_pose_t global_pose_t;
 	typedef CLoopCloserERD<GRAPH_T> decider_t; /**< self type - Handy typedef */
 	typedef typename parent_t::range_ops_t range_ops_t;
+	typedef typename range_ops_t::template TICPEdgeJob<
+		mrpt::obs::CObservation2DRangeScan>
+		icp_job_t;
 	typedef typename parent_t::nodes_to_scans2D_t nodes_to_scans2D_t;
 	/**\brief Typedef for referring to a list of partitions */
 	typedef std::vector<mrpt::vector_uint> partitions_t;
@@ -517,6 +532,10 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 		 * By default this is set to 2.
 		 */
 		double LC_eigenvalues_ratio_thresh;
+		/**\brief Valid hypotheses after which the pending ICP alignments of a
+		 * partition are cancelled (0: never).
+		 */
+		int LC_enough_valid_hypots;
 		/**\brief how many remote nodes (large nodID difference should there be
 		 * before I consider the potential loop closure.
 		 */
@@ -740,18 +759,63 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 		const mrpt::utils::TNodeID& from, const mrpt::utils::TNodeID& to,
 		constraint_t* rel_edge, mrpt::slam::CICP::TReturnInfo* icp_info = NULL,
 		const TGetICPEdgeAdParams* ad_params = NULL);
+	/**\brief Fetch the laser scans and the initial relative pose estimate
+	 * that getICPEdge uses for aligning the given nodes.
+	 *
+	 * Handy for running several alignments at once, with getICPEdges.
+	 *
+	 * \return True if both nodes contain valid laser scans, false otherwise.
+	 */
+	bool getICPEdgeInputs(
+		const mrpt::utils::TNodeID& from, const mrpt::utils::TNodeID& to,
+		mrpt::obs::CObservation2DRangeScan::Ptr* from_scan,
+		mrpt::obs::CObservation2DRangeScan::Ptr* to_scan,
+		pose_t* initial_estim, const TGetICPEdgeAdParams* ad_params = NULL);
 	/**\brief compute the minimum uncertainty of each node position with
 	 * regards to the graph root.
 	 *
+	 * Paths follow the shortest-path tree from starting_node (see
+	 * getShortestUncertaintyPath) and are stored in m_node_optimal_paths.
+	 *
 	 * \param[in] starting_node Node from which I start the Dijkstra projection
 	 * algorithm
 	 * \param[in] ending_node Specify the nodeID whose uncertainty wrt the
-	 * starting_node, we are interested in computing. If given, method
-	 * execution ends when this path is computed.
+	 * starting_node, we are interested in computing. If given, only the path
+	 * to this node is computed.
 	 */
 	void execDijkstraProjection(
 		mrpt::utils::TNodeID starting_node = 0,
 		mrpt::utils::TNodeID ending_node = INVALID_NODEID);
+	/**\brief Synchronize m_shortest_path_trees with the graph.
+	 *
+	 * Cheap if the graph has not changed since the last call, or if nodes and
+	 * edges have only been appended to it. Drops the paths cached in
+	 * m_shortest_uncertainty_paths if the graph has changed.
+	 */
+	void updateShortestPathTrees();
+	/**\brief Compute the uncertainty path between two nodes, along the
+	 * shortest path between them in m_shortest_path_trees.
+	 *
+	 * The path is composed hop by hop with getMinUncertaintyPath. Paths are
+	 * cached until the graph changes.
+	 *
+	 * \note Call updateShortestPathTrees first. The tree from node \a from is
+	 * computed if it is not in the cache.
+	 *
+	 * \return Pointer to the cached path, or NULL if the nodes are not
+	 * connected.
+	 */
+	const path_t* getShortestUncertaintyPath(
+		const mrpt::utils::TNodeID from, const mrpt::utils::TNodeID to);
+	/**\brief Edge weight used in m_shortest_path_trees: the trace of the
+	 * covariance matrix of the edge.
+	 *
+	 * Edges with an all-zeros (or invalid) information matrix weight as if it
+	 * were the identity, as in getMinUncertaintyPath.
+	 */
+	static double getEdgeUncertainty(
+		const GRAPH_T& graph, const mrpt::utils::TNodeID from,
+		const mrpt::utils::TNodeID to, const typename GRAPH_T::edge_t& edge);
 	/**\brief Given two nodeIDs compute and return the path connecting them.
 	 *
 	 * Method takes care of multiple edges, as well as edges with 0 covariance
@@ -858,6 +922,17 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 	 * execDijkstraProjection method
 	 */
 	typename std::map<mrpt::utils::TNodeID, path_t*> m_node_optimal_paths;
+	/**\brief Shortest-path trees of the graph, weighted by the uncertainty of
+	 * its edges (see getEdgeUncertainty).
+	 *
+	 * Updated incrementally as nodes and edges are registered, and shared by
+	 * all the loop closure evaluations.
+	 */
+	mrpt::graphs::CShortestPathTrees<GRAPH_T> m_shortest_path_trees;
+	/**\brief Uncertainty paths computed by getShortestUncertaintyPath, by
+	 * (from, to) nodeIDs
+	 */
+	std::map<mrpt::utils::TPairNodeIDs, path_t> m_shortest_uncertainty_paths;
 	/**\brief Keep track of the first recorded laser scan so that it can be
 	 * assigned to the root node when the NRD adds the first *two* nodes to the
 	 * graph.
@@ -23,6 +23,7 @@ CLoopCloserERD<GRAPH_T>::CLoopCloserERD()
 	: m_visualize_curr_node_covariance(false),
 	  m_curr_node_covariance_color(160, 160, 160, /*alpha = */ 255),
 	  m_partitions_full_update(false),
+	  m_shortest_path_trees(&decider_t::getEdgeUncertainty),
 	  m_is_first_time_node_reg(true),
 	  m_dijkstra_node_count_thresh(3)
 {
@@ -152,7 +153,9 @@ bool CLoopCloserERD<GRAPH_T>::updateState(
 
 		if (m_visualize_curr_node_covariance)
 		{
-			this->execDijkstraProjection();
+			this->execDijkstraProjection(
+				/*starting_node=*/this->m_graph->root,
+				/*ending_node=*/this->m_graph->nodeCount() - 1);
 		}
 
 		this->m_last_total_num_nodes = this->m_graph->nodeCount();
@@ -201,20 +204,45 @@ void CLoopCloserERD<GRAPH_T>::addScanMatchingEdges(
 	std::set<TNodeID> nodes_set;
 	this->fetchNodeIDsForScanMatching(curr_nodeID, &nodes_set);
 
-	// try adding ICP constraints with each node in the previous set
+	// run all the alignments at once, then go through them in order
+	std::vector<TNodeID> job_nodes;
+	std::vector<CObservation2DRangeScan::Ptr> job_scans;
+	std::vector<icp_job_t> icp_jobs;
 	for (std::set<TNodeID>::const_iterator node_it = nodes_set.begin();
 		 node_it != nodes_set.end(); ++node_it)
 	{
-		constraint_t rel_edge;
-		mrpt::slam::CICP::TReturnInfo icp_info;
-
 		MRPT_LOG_DEBUG_STREAM(
 			"Fetching laser scan for nodes: " << *node_it << "==> "
 											  << curr_nodeID);
 
-		bool found_edge =
-			this->getICPEdge(*node_it, curr_nodeID, &rel_edge, &icp_info);
-		if (!found_edge) continue;
+		CObservation2DRangeScan::Ptr from_scan, to_scan;
+		pose_t initial_estim;
+		if (!this->getICPEdgeInputs(
+				*node_it, curr_nodeID, &from_scan, &to_scan, &initial_estim))
+		{
+			continue;
+		}
+
+		icp_job_t job;
+		job.from_scan = from_scan.get();
+		job.to_scan = to_scan.get();
+		job.initial_pose = initial_estim;
+		job.has_initial_pose = true;
+		icp_jobs.push_back(job);
+		job_nodes.push_back(*node_it);
+		job_scans.push_back(from_scan);
+		job_scans.push_back(to_scan);
+	}
+	this->m_time_logger.enter("getICPEdge");
+	this->getICPEdges(icp_jobs);
+	this->m_time_logger.leave("getICPEdge");
+
+	// try adding ICP constraints with each node in the previous set
+	for (size_t i = 0; i < icp_jobs.size(); i++)
+	{
+		const TNodeID node = job_nodes[i];
+		const constraint_t& rel_edge = icp_jobs[i].rel_edge;
+		const mrpt::slam::CICP::TReturnInfo& icp_info = icp_jobs[i].icp_info;
 
 		// keep track of the recorded goodness values
 		// TODO - rethink on these condition.
@@ -236,12 +264,12 @@ void CLoopCloserERD<GRAPH_T>::addScanMatchingEdges(
 		// make sure that the suggested edge makes sense with regards to current
 		// graph config - check against the current position difference
 		bool accept_mahal_distance = this->mahalanobisDistanceOdometryToICPEdge(
-			*node_it, curr_nodeID, rel_edge);
+			node, curr_nodeID, rel_edge);
 
 		// criterion for registering a new node
 		if (accept_goodness && accept_mahal_distance)
 		{
-			this->registerNewEdge(*node_it, curr_nodeID, rel_edge);
+			this->registerNewEdge(node, curr_nodeID, rel_edge);
 		}
 	}
 
@@ -255,7 +283,37 @@ bool CLoopCloserERD<GRAPH_T>::getICPEdge(
 {
 	MRPT_START;
 	ASSERT_(rel_edge);
+
+	using namespace mrpt::obs;
+
+	MRPT_LOG_DEBUG_STREAM("****In getICPEdge method: ");
+	CObservation2DRangeScan::Ptr from_scan, to_scan;
+	pose_t initial_estim;
+	if (!this->getICPEdgeInputs(
+			from, to, &from_scan, &to_scan, &initial_estim, ad_params))
+	{
+		return false;
+	}
+
 	this->m_time_logger.enter("getICPEdge");
+	range_ops_t::getICPEdge(
+		*from_scan, *to_scan, rel_edge, &initial_estim, icp_info);
+	MRPT_LOG_DEBUG_STREAM("*************");
+
+	this->m_time_logger.leave("getICPEdge");
+	return true;
+	MRPT_END;
+}  // end of getICPEdge
+
+template <class GRAPH_T>
+bool CLoopCloserERD<GRAPH_T>::getICPEdgeInputs(
+	const mrpt::utils::TNodeID& from, const mrpt::utils::TNodeID& to,
+	mrpt::obs::CObservation2DRangeScan::Ptr* from_scan,
+	mrpt::obs::CObservation2DRangeScan::Ptr* to_scan, pose_t* initial_estim,
+	const TGetICPEdgeAdParams* ad_params /*=NULL*/)
+{
+	MRPT_START;
+	ASSERT_(from_scan && to_scan && initial_estim);
 
 	using namespace mrpt::obs;
 	using namespace mrpt::utils;
@@ -265,11 +323,9 @@ bool CLoopCloserERD<GRAPH_T>::getICPEdge(
 	// fetch the relevant laser scans and poses of the nodeIDs
 	// If given in the additional params struct, use those values instead of
 	// searching in the class std::map(s)
-	CObservation2DRangeScan::Ptr from_scan, to_scan;
 	global_pose_t from_pose;
 	global_pose_t to_pose;
 
-	MRPT_LOG_DEBUG_STREAM("****In getICPEdge method: ");
 	if (ad_params)
 	{
 		MRPT_LOG_DEBUG_STREAM(
@@ -281,10 +337,11 @@ bool CLoopCloserERD<GRAPH_T>::getICPEdge(
 	const node_props_t* from_params =
 		ad_params ? &ad_params->from_params : NULL;
 	bool from_success = this->getPropsOfNodeID(
-		from, &from_pose, from_scan, from_params);  // TODO
+		from, &from_pose, *from_scan, from_params);  // TODO
 	// to-node parameters
 	const node_props_t* to_params = ad_params ? &ad_params->to_params : NULL;
-	bool to_success = this->getPropsOfNodeID(to, &to_pose, to_scan, to_params);
+	bool to_success =
+		this->getPropsOfNodeID(to, &to_pose, *to_scan, to_params);
 
 	if (!from_success || !to_success)
 	{
@@ -297,28 +354,21 @@ bool CLoopCloserERD<GRAPH_T>::getICPEdge(
 
 	// make use of initial node position difference for the ICP edge
 	// from_node pose
-	pose_t initial_estim;
 	if (ad_params)
 	{
-		initial_estim = ad_params->init_estim;
+		*initial_estim = ad_params->init_estim;
 	}
 	else
 	{
-		initial_estim = to_pose - from_pose;
+		*initial_estim = to_pose - from_pose;
 	}
 
 	MRPT_LOG_DEBUG_STREAM(
 		"from_pose: " << from_pose << "| to_pose: " << to_pose
-					  << "| init_estim: " << initial_estim);
-
-	range_ops_t::getICPEdge(
-		*from_scan, *to_scan, rel_edge, &initial_estim, icp_info);
-	MRPT_LOG_DEBUG_STREAM("*************");
-
-	this->m_time_logger.leave("getICPEdge");
+					  << "| init_estim: " << *initial_estim);
 	return true;
 	MRPT_END;
-}  // end of getICPEdge
+}  // end of getICPEdgeInputs
 
 template <class GRAPH_T>
 bool CLoopCloserERD<GRAPH_T>::fillNodePropsFromGroupParams(
@@ -563,6 +613,13 @@ void CLoopCloserERD<GRAPH_T>::evaluatePartitionsForLC(
 			partition, &groupA, &groupB,
 			/*max_nodes_in_group=*/5);
 
+		// shortest-path trees from all the nodes of the groups, in one batch.
+		// Previous hypotheses may have been registered in the meantime.
+		this->updateShortestPathTrees();
+		std::vector<TNodeID> tree_sources(groupA.begin(), groupA.end());
+		tree_sources.insert(tree_sources.end(), groupB.begin(), groupB.end());
+		m_shortest_path_trees.computeTrees(tree_sources);
+
 		// generate hypotheses pool
 		hypotsp_t hypots_pool;
 		this->generateHypotsPool(groupA, groupB, &hypots_pool);
@@ -750,7 +807,9 @@ void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
 {
 	MRPT_START;
 	using namespace mrpt::utils;
+	using namespace mrpt::obs;
 	using namespace mrpt;
+	using namespace std;
 
 	ASSERTMSG_(
 		generated_hypots,
@@ -793,6 +852,12 @@ void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
 	int hypot_counter = 0;
 	int invalid_hypots = 0;  // just for keeping track of them.
 	{
+		// ICP alignments of the hypotheses, run all at once.
+		// Scans are kept in job_scans until the alignments are done
+		std::vector<icp_job_t> icp_jobs;
+		std::vector<hypot_t*> job_hypots;
+		std::vector<CObservation2DRangeScan::Ptr> job_scans;
+
 		// iterate over all the nodes in both groups
 		for (vector_uint::const_iterator  // B - from
 			 b_it = groupB.begin();
@@ -810,6 +875,7 @@ void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
 				hypot->from = *b_it;
 				hypot->to = *a_it;
 				hypot->id = hypot_counter++;
+				generated_hypots->push_back(hypot);
 
 				// [from] *b_it ====[edge]===> [to]  *a_it
 
@@ -817,72 +883,103 @@ void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
 				//
 				// even if icp_ad_params NULL, it will be handled appropriately
 				// by the
-				// getICPEdge fun.
-				// bool from_success, to_success;
+				// getICPEdgeInputs fun.
 				TGetICPEdgeAdParams* icp_ad_params = NULL;
 				if (ad_params)
 				{
 					icp_ad_params = new TGetICPEdgeAdParams;
-					// from_success = fillNodePropsFromGroupParams(
 					fillNodePropsFromGroupParams(
 						*b_it, ad_params->groupB_params,
 						&icp_ad_params->from_params);
-					// to_success = fillNodePropsFromGroupParams(
 					fillNodePropsFromGroupParams(
 						*a_it, ad_params->groupA_params,
 						&icp_ad_params->to_params);
-
-					// MRPT_LOG_DEBUG_STREAM(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
-					// MRPT_LOG_DEBUG_STREAM("From nodeID (other): " << *b_it);
-					// MRPT_LOG_DEBUG_STREAM("From params (other): "
-					//<< icp_ad_params->from_params.getAsString());
-					// MRPT_LOG_DEBUG_STREAM("from_success: " << (from_success?
-					// "TRUE" : "FALSE"));
-					// MRPT_LOG_DEBUG_STREAM("**********");
-					// MRPT_LOG_DEBUG_STREAM("To nodeID (own)   : " << *a_it);
-					// MRPT_LOG_DEBUG_STREAM("To params (own)   : "
-					//<< icp_ad_params->to_params.getAsString());
-					// MRPT_LOG_DEBUG_STREAM("to_success: " << (to_success?
-					// "TRUE" : "FALSE"));
-					// MRPT_LOG_DEBUG_STREAM("<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<");
 				}
 
-				// fetch the ICP constraint bi => ai
-				mrpt::slam::CICP::TReturnInfo icp_info;
-				constraint_t edge;
-				bool found_edge = this->getICPEdge(
-					*b_it, *a_it, &edge, &icp_info, icp_ad_params);
-
-				hypot->setEdge(edge);
-				hypot->goodness =
-					icp_info.goodness;  // goodness related to the edge
+				// inputs of the ICP constraint bi => ai
+				CObservation2DRangeScan::Ptr from_scan, to_scan;
+				pose_t initial_estim;
+				bool found_scans = this->getICPEdgeInputs(
+					*b_it, *a_it, &from_scan, &to_scan, &initial_estim,
+					icp_ad_params);
+				// delete pointer to getICPEdge additional parameters if they
+				// were
+				// initialized
+				delete icp_ad_params;
 
-				// Check if invalid
-				//
-				// Goodness Threshold
-				double goodness_thresh =
-					m_laser_params.goodness_threshold_win.getMedian() *
-					m_lc_icp_constraint_factor;
-				bool accept_goodness = icp_info.goodness > goodness_thresh;
-				MRPT_LOG_DEBUG_STREAM(
-					"generateHypotsPool:\nCurr. Goodness: "
-					<< icp_info.goodness << "|\t Threshold: " << goodness_thresh
-					<< " => " << (accept_goodness ? "ACCEPT" : "REJECT")
-					<< endl);
-
-				if (!found_edge || !accept_goodness)
+				if (!found_scans)
 				{
+					hypot->setEdge(constraint_t());
+					hypot->goodness = mrpt::slam::CICP::TReturnInfo().goodness;
 					hypot->is_valid = false;
 					invalid_hypots++;
+					MRPT_LOG_DEBUG_STREAM(hypot->getAsString());
+					continue;
 				}
-				generated_hypots->push_back(hypot);
-				MRPT_LOG_DEBUG_STREAM(hypot->getAsString());
 
-				// delete pointer to getICPEdge additional parameters if they
-				// were
-				// initialized
-				delete icp_ad_params;
+				icp_job_t job;
+				job.from_scan = from_scan.get();
+				job.to_scan = to_scan.get();
+				job.initial_pose = initial_estim;
+				job.has_initial_pose = true;
+				icp_jobs.push_back(job);
+				job_hypots.push_back(hypot);
+				job_scans.push_back(from_scan);
+				job_scans.push_back(to_scan);
+			}
+		}
+
+		// Goodness Threshold
+		const double goodness_thresh =
+			m_laser_params.goodness_threshold_win.getMedian() *
+			m_lc_icp_constraint_factor;
+
+		// fetch the ICP constraints - stop once there are enough valid ones
+		const size_t enough_valid_hypots =
+			std::max(0, m_lc_params.LC_enough_valid_hypots);
+		size_t valid_hypots = 0;
+		this->m_time_logger.enter("getICPEdge");
+		const size_t nDone = this->getICPEdges(
+			icp_jobs, [&icp_jobs, &valid_hypots, goodness_thresh,
+					   enough_valid_hypots](size_t idx) {
+				if (icp_jobs[idx].icp_info.goodness > goodness_thresh)
+				{
+					valid_hypots++;
+				}
+				return !enough_valid_hypots ||
+					   valid_hypots < enough_valid_hypots;
+			});
+		this->m_time_logger.leave("getICPEdge");
+		if (nDone < icp_jobs.size())
+		{
+			MRPT_LOG_DEBUG_STREAM(
+				"Found " << valid_hypots << " valid hypotheses - cancelled "
+						 << icp_jobs.size() - nDone << " ICP alignments");
+		}
+
+		for (size_t i = 0; i < icp_jobs.size(); ++i)
+		{
+			hypot_t* hypot = job_hypots[i];
+			const icp_job_t& job = icp_jobs[i];
+
+			hypot->setEdge(job.rel_edge);
+			hypot->goodness =
+				job.icp_info.goodness;  // goodness related to the edge
+
+			// Check if invalid
+			bool accept_goodness =
+				job.is_done && job.icp_info.goodness > goodness_thresh;
+			MRPT_LOG_DEBUG_STREAM(
+				"generateHypotsPool:\nCurr. Goodness: "
+				<< job.icp_info.goodness << "|\t Threshold: " << goodness_thresh
+				<< " => " << (accept_goodness ? "ACCEPT" : "REJECT") << endl);
+
+			if (!accept_goodness)
+			{
+				hypot->is_valid = false;
+				invalid_hypots++;
 			}
+			MRPT_LOG_DEBUG_STREAM(hypot->getAsString());
 		}
 		MRPT_LOG_DEBUG_STREAM(
 			"Generated pool of hypotheses...\tsize = "
@@ -1159,10 +1256,7 @@ double CLoopCloserERD<GRAPH_T>::generatePWConsistencyElement(
 	const path_t* path_a1_a2;
 	if (!opt_paths || opt_paths->begin()->isEmpty())
 	{
-		MRPT_LOG_DEBUG_STREAM(
-			"Running dijkstra [a1] " << a1 << " => [a2] " << a2);
-		execDijkstraProjection(/*starting_node=*/a1, /*ending_node=*/a2);
-		path_a1_a2 = this->queryOptimalPath(a2);
+		path_a1_a2 = this->getShortestUncertaintyPath(a1, a2);
 	}
 	else
 	{  // fetch the path from the opt_paths arg
@@ -1174,12 +1268,9 @@ double CLoopCloserERD<GRAPH_T>::generatePWConsistencyElement(
 
 	// b1 ==> b2
 	const path_t* path_b1_b2;
-	if (!opt_paths || opt_paths->rend()->isEmpty())
+	if (!opt_paths || opt_paths->rbegin()->isEmpty())
 	{
-		MRPT_LOG_DEBUG_STREAM(
-			"Running djkstra [b1] " << b1 << " => [b2] " << b2);
-		execDijkstraProjection(/*starting_node=*/b1, /*ending_node=*/b2);
-		path_b1_b2 = this->queryOptimalPath(b2);
+		path_b1_b2 = this->getShortestUncertaintyPath(b1, b2);
 	}
 	else
 	{  // fetch the path from the opt_paths arg
@@ -1346,10 +1437,10 @@ void CLoopCloserERD<GRAPH_T>::execDijkstraProjection(
 	// for the full algorithm see
 	// - Recognizing places using spectrally clustered local matches - E.Olson,
 	// p.6
-
-	this->m_time_logger.enter("Dijkstra Projection");
-	const std::string dijkstra_end =
-		"----------- Done with Dijkstra Projection... ----------";
+	//
+	// Instead of growing the paths with the lowest determinant from scratch,
+	// the paths follow the shortest-path tree of the graph weighted by the
+	// covariance trace of the edges, which is kept up to date incrementally.
 
 	// ending_node is either INVALID_NODEID or one of the already registered
 	// nodeIDs
@@ -1359,130 +1450,138 @@ void CLoopCloserERD<GRAPH_T>::execDijkstraProjection(
 	ASSERTMSG_(
 		starting_node != ending_node, "Starting and Ending nodes coincede");
 
-	// debugging message
-	stringstream ss_debug("");
-	ss_debug << "Executing Dijkstra Projection: " << starting_node << " => ";
-	if (ending_node == INVALID_NODEID)
-	{
-		ss_debug << "..." << endl;
-	}
-	else
-	{
-		ss_debug << ending_node << endl;
-	}
-
 	if (this->m_graph->nodeCount() < m_dijkstra_node_count_thresh)
 	{
 		return;
 	}
+	this->m_time_logger.enter("Dijkstra Projection");
 
-	// keep track of the nodes that I have visited
-	std::vector<bool> visited_nodes(this->m_graph->nodeCount(), false);
+	for (typename std::map<TNodeID, path_t*>::iterator it =
+			 m_node_optimal_paths.begin();
+		 it != m_node_optimal_paths.end(); ++it)
+	{
+		delete it->second;
+	}
 	m_node_optimal_paths.clear();
 
-	// get the neighbors of each node
-	std::map<TNodeID, std::set<TNodeID>> neighbors_of;
-	this->m_graph->getAdjacencyMatrix(neighbors_of);
-
-	// initialize a pool of TUncertaintyPaths - draw the minimum-uncertainty
-	// path during
-	// execution
-	std::set<path_t*> pool_of_paths;
-	// get the edge to each one of the neighboring nodes of the starting node
-	std::set<TNodeID> starting_node_neighbors(neighbors_of.at(starting_node));
-	for (std::set<TNodeID>::const_iterator n_it =
-			 starting_node_neighbors.begin();
-		 n_it != starting_node_neighbors.end(); ++n_it)
-	{
-		path_t* path_between_neighbors = new path_t();
-		this->getMinUncertaintyPath(
-			starting_node, *n_it, path_between_neighbors);
+	this->updateShortestPathTrees();
 
-		pool_of_paths.insert(path_between_neighbors);
+	std::vector<TNodeID> ending_nodes;
+	if (ending_node != INVALID_NODEID)
+	{
+		ending_nodes.push_back(ending_node);
 	}
-	// just visited the first node
-	visited_nodes.at(starting_node) = true;
-
-	//// TODO Remove these - >>>>>>>>>>>>>>>>>>>>
-	//// printing the pool for verification
-	// cout << "Pool of Paths: " << endl;
-	// for (typename std::set<path_t*>::const_iterator it =
-	// pool_of_paths.begin();
-	// it != pool_of_paths.end(); ++it) {
-	// printSTLContainer((*it)->nodes_traversed);
-	//}
-	// cout << "------ Done with the starting node ... ------" << endl;
-	// int iters = 0;
-	//// TODO Remove these - <<<<<<<<<<<<<<<<<<<<< vvvUNCOMMENT BELOW AS WELLvvv
-
-	while (true)
+	else
 	{
-		// if there is at least one false, exit loop
-		for (std::vector<bool>::const_iterator it = visited_nodes.begin();
-			 it != visited_nodes.end(); ++it)
+		for (typename GRAPH_T::global_poses_t::const_iterator n_it =
+				 this->m_graph->nodes.begin();
+			 n_it != this->m_graph->nodes.end(); ++n_it)
 		{
-			if (!*it)
+			if (n_it->first != starting_node)
 			{
-				break;
+				ending_nodes.push_back(n_it->first);
 			}
 		}
+	}
 
-		// if an ending nodeID has been specified, end the method when the path
-		// to
-		// it is found.
-		if (ending_node != INVALID_NODEID)
+	for (std::vector<TNodeID>::const_iterator n_it = ending_nodes.begin();
+		 n_it != ending_nodes.end(); ++n_it)
+	{
+		const path_t* path =
+			this->getShortestUncertaintyPath(starting_node, *n_it);
+		if (path)
 		{
-			if (visited_nodes.at(ending_node))
-			{
-				// MRPT_LOG_DEBUG_STREAM(dijkstra_end);
-				this->m_time_logger.leave("Dijkstra Projection");
-				return;
-			}
+			m_node_optimal_paths[*n_it] = new path_t(*path);
 		}
+	}
 
-		path_t* optimal_path = this->popMinUncertaintyPath(&pool_of_paths);
-		TNodeID dest = optimal_path->getDestination();
-
-		//// TODO Remove these - >>>>>>>>>>>>>>>>>>>> ^^^UNCOMMENT ABOVE AS
-		/// WELL^^^
-		// cout << iters << " " << std::string(40, '>') << endl;
-		// cout << "current path Destination: " << dest << endl;
-		//// printing the pool for verification
-		// cout << "Pool of Paths: " << endl;
-		// for (typename std::set<path_t*>::const_iterator
-		// it = pool_of_paths.begin();
-		// it != pool_of_paths.end(); ++it) {
-		// printSTLContainer((*it)->nodes_traversed);
-		//}
-		// cout << "Nodes visited: " << endl;
-		// std::vector<int> tmp_vec;
-		// for (int i = 0; i != visited_nodes.size(); ++i) {
-		// tmp_vec.push_back(i);
-		//}
-		// printSTLContainer(tmp_vec); cout << endl; // indices of numbers
-		// printSTLContainer(visited_nodes);         // actual flags
-		// cout << std::string(40, '<') << " " << iters++ << endl;
-		// mrpt::system::pause();
-		//// TODO Remove these - <<<<<<<<<<<<<<<<<<<<<
+	this->m_time_logger.leave("Dijkstra Projection");
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CLoopCloserERD<GRAPH_T>::updateShortestPathTrees()
+{
+	if (m_shortest_path_trees.update(*this->m_graph))
+	{
+		m_shortest_uncertainty_paths.clear();
+	}
+}
+
+template <class GRAPH_T>
+const typename CLoopCloserERD<GRAPH_T>::path_t*
+	CLoopCloserERD<GRAPH_T>::getShortestUncertaintyPath(
+		const mrpt::utils::TNodeID from, const mrpt::utils::TNodeID to)
+{
+	MRPT_START;
+	using namespace mrpt::utils;
+
+	const TPairNodeIDs ends(from, to);
+	typename std::map<TPairNodeIDs, path_t>::const_iterator search =
+		m_shortest_uncertainty_paths.find(ends);
+	if (search != m_shortest_uncertainty_paths.end())
+	{
+		return &search->second;
+	}
+
+	if (!m_shortest_path_trees.hasTree(from))
+	{
+		m_shortest_path_trees.computeTrees(std::vector<TNodeID>(1, from));
+		if (!m_shortest_path_trees.hasTree(from)) return NULL;
+	}
+	typename mrpt::graphs::CShortestPathTrees<GRAPH_T>::edge_list_t arcs;
+	if (!m_shortest_path_trees.getShortestPath(from, to, arcs) ||
+		arcs.empty())
+	{
+		return NULL;
+	}
 
-		if (!visited_nodes.at(dest))
+	// compose the minimum uncertainty paths of each hop
+	path_t path, hop;
+	TNodeID curr = from;
+	for (typename std::list<TPairNodeIDs>::const_iterator arc_it =
+			 arcs.begin();
+		 arc_it != arcs.end(); ++arc_it)
+	{
+		const TNodeID next =
+			(arc_it->first == curr) ? arc_it->second : arc_it->first;
+		this->getMinUncertaintyPath(curr, next, &hop);
+		if (arc_it == arcs.begin())
+		{
+			path = hop;
+		}
+		else
 		{
-			m_node_optimal_paths[dest] = optimal_path;
-			visited_nodes.at(dest) = true;
-
-			// for all the edges leaving this node .. compose the transforms
-			// with the
-			// current pool of paths.
-			this->addToPaths(
-				&pool_of_paths, *optimal_path, neighbors_of.at(dest));
+			path += hop;
 		}
+		curr = next;
 	}
 
-	// MRPT_LOG_DEBUG_STREAM(dijkstra_end);
-	this->m_time_logger.leave("Dijkstra Projection");
+	return &(m_shortest_uncertainty_paths[ends] = path);
 	MRPT_END;
 }
 
+template <class GRAPH_T>
+double CLoopCloserERD<GRAPH_T>::getEdgeUncertainty(
+	const GRAPH_T& graph, const mrpt::utils::TNodeID from,
+	const mrpt::utils::TNodeID to, const typename GRAPH_T::edge_t& edge)
+{
+	using namespace mrpt::math;
+	MRPT_UNUSED_PARAM(graph);
+	MRPT_UNUSED_PARAM(from);
+	MRPT_UNUSED_PARAM(to);
+
+	CMatrixDouble33 inf_mat;
+	edge.getInformationMatrix(inf_mat);
+	if (inf_mat == CMatrixDouble33() || std::isnan(inf_mat(0, 0)) ||
+		!(inf_mat.det() > 0))
+	{
+		// same as an identity information matrix
+		return inf_mat.rows();
+	}
+	return inf_mat.inv().trace();
+}
+
 template <class GRAPH_T>
 void CLoopCloserERD<GRAPH_T>::addToPaths(
 	std::set<path_t*>* pool_of_paths, const path_t& current_path,
@@ -2636,7 +2735,8 @@ void CLoopCloserERD<GRAPH_T>::TLaserParams::loadFromConfigFile(
 
 template <class GRAPH_T>
 CLoopCloserERD<GRAPH_T>::TLoopClosureParams::TLoopClosureParams()
-	: keystroke_map_partitions("b"),
+	: LC_enough_valid_hypots(0),
+	  keystroke_map_partitions("b"),
 	  balloon_elevation(3),
 	  balloon_radius(0.5),
 	  balloon_std_color(153, 0, 153),
@@ -2665,6 +2765,8 @@ void CLoopCloserERD<GRAPH_T>::TLoopClosureParams::dumpToTextStream(
 	   << LC_min_remote_nodes << endl;
 	ss << "Min EigenValues ratio for accepting a hypotheses set  = "
 	   << LC_eigenvalues_ratio_thresh << endl;
+	ss << "Valid hypotheses to cancel the pending alignments     = "
+	   << LC_enough_valid_hypots << endl;
 	ss << "Check only current node's partition for loop closures = "
 	   << (LC_check_curr_partition_only ? "TRUE" : "FALSE") << endl;
 	ss << "New registered nodes required for full partitioning   = "
@@ -2688,6 +2790,8 @@ void CLoopCloserERD<GRAPH_T>::TLoopClosureParams::loadFromConfigFile(
 		source.read_int(section, "LC_min_remote_nodes", 3, false);
 	LC_eigenvalues_ratio_thresh =
 		source.read_double(section, "LC_eigenvalues_ratio_thresh", 2, false);
+	LC_enough_valid_hypots =
+		source.read_int(section, "LC_enough_valid_hypots", 0, false);
 	LC_check_curr_partition_only =
 		source.read_bool(section, "LC_check_curr_partition_only", true, false);
 	full_partition_per_nodes =
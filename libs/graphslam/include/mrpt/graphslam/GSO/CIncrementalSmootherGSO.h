@@ -0,0 +1,130 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#ifndef CINCREMENTALSMOOTHERGSO_H
+#define CINCREMENTALSMOOTHERGSO_H
+
+#include <mrpt/graphslam/GSO/CLevMarqGSO.h>
+#include <mrpt/graphslam/CIncrementalSmoother.h>
+
+namespace mrpt
+{
+namespace graphslam
+{
+namespace optimizers
+{
+/**\brief Incremental smoothing (iSAM2-like) graph slam optimization scheme.
+ *
+ * ## Description
+ *
+ * Instead of re-optimizing a window of nodes or the whole graph, this
+ * optimizer keeps the factorization of the problem between calls, and only
+ * updates the part of it affected by the new nodes/edges and by the nodes
+ * whose estimate moved beyond a threshold. Hence, the cost per new node stays
+ * roughly constant and loop closures do not trigger a full optimization.
+ * Refer to graphslam::CIncrementalSmoother for the details.
+ *
+ * The visualization of the graph and the related .ini parameters are those
+ * of CLevMarqGSO. Manually triggering a full optimization (see
+ * \b keystroke_optimize_graph in CLevMarqGSO) runs a Levenberg-Marquardt
+ * optimization of the whole graph and restarts the incremental smoother.
+ *
+ * ### .ini Configuration Parameters
+ *
+ * \htmlinclude graphslam-engine_config_params_preamble.txt
+ *
+ * All the parameters of CLevMarqGSO, plus:
+ *
+ * - \b relinearize_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 0.1
+ *  + \a Required      : FALSE
+ *  + \a Description   : Relinearize a node when any component of its
+ *  increment is above this value.
+ *
+ * - \b relinearize_skip
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1
+ *  + \a Required      : FALSE
+ *  + \a Description   : Look for nodes to relinearize only once every N
+ *  updates.
+ *
+ * - \b wildfire_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1e-3
+ *  + \a Required      : FALSE
+ *  + \a Description   : Do not propagate the changes of the solution to older
+ *  nodes when they are smaller than this value.
+ *
+ * \ingroup mrpt_graphslam_grp
+ */
+template <class GRAPH_T = typename mrpt::graphs::CNetworkOfPoses2DInf>
+class CIncrementalSmootherGSO
+	: public mrpt::graphslam::optimizers::CLevMarqGSO<GRAPH_T>
+{
+   public:
+	/**\brief Handy typedefs */
+	/**\{*/
+	typedef mrpt::graphslam::optimizers::CLevMarqGSO<GRAPH_T> parent;
+	typedef mrpt::graphslam::CIncrementalSmoother<GRAPH_T> smoother_t;
+	/**\}*/
+
+	CIncrementalSmootherGSO();
+	~CIncrementalSmootherGSO();
+
+	bool updateState(
+		mrpt::obs::CActionCollection::Ptr action,
+		mrpt::obs::CSensoryFrame::Ptr observations,
+		mrpt::obs::CObservation::Ptr observation);
+	void notifyOfWindowEvents(
+		const std::map<std::string, bool>& events_occurred);
+
+	void loadParams(const std::string& source_fname);
+	void printParams() const;
+	void getDescriptiveReport(std::string* report_str) const;
+
+	/**\brief Parameters of the incremental smoother */
+	struct IncrementalParams : public mrpt::utils::CLoadableOptions
+	{
+	   public:
+		IncrementalParams();
+		~IncrementalParams();
+
+		void loadFromConfigFile(
+			const mrpt::utils::CConfigFileBase& source,
+			const std::string& section);
+		void dumpToTextStream(mrpt::utils::CStream& out) const;
+
+		typename smoother_t::TOptions options;
+	};
+	IncrementalParams inc_params;
+
+   protected:
+	/**\brief Incorporate the latest nodes and edges to the smoother.
+	 *
+	 * Assumes the graph section is already locked.
+	 */
+	void _updateSmoother();
+	/**\brief Locks the graph section and then calls _updateSmoother().
+	 *
+	 * Used in multithreaded optimization.
+	 */
+	void optimizeGraph();
+
+	smoother_t m_smoother;
+	/**\brief Statistics of the last smoother update */
+	typename smoother_t::TUpdateInfo m_last_update_info;
+};
+}
+}
+}  // end of namespaces
+
+#include "CIncrementalSmootherGSO_impl.h"
+
+#endif /* end of include guard: CINCREMENTALSMOOTHERGSO_H */
@@ -0,0 +1,236 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#ifndef CINCREMENTALSMOOTHERGSO_IMPL_H
+#define CINCREMENTALSMOOTHERGSO_IMPL_H
+
+namespace mrpt
+{
+namespace graphslam
+{
+namespace optimizers
+{
+// Ctors, Dtors
+//////////////////////////////////////////////////////////////
+
+template <class GRAPH_T>
+CIncrementalSmootherGSO<GRAPH_T>::CIncrementalSmootherGSO()
+{
+	MRPT_START;
+	this->initializeLoggers("CIncrementalSmootherGSO");
+	MRPT_END;
+}
+template <class GRAPH_T>
+CIncrementalSmootherGSO<GRAPH_T>::~CIncrementalSmootherGSO()
+{
+	if (this->m_thread_optimize.joinable()) this->m_thread_optimize.join();
+}
+
+// Member function implementations
+//////////////////////////////////////////////////////////////
+template <class GRAPH_T>
+bool CIncrementalSmootherGSO<GRAPH_T>::updateState(
+	mrpt::obs::CActionCollection::Ptr action,
+	mrpt::obs::CSensoryFrame::Ptr observations,
+	mrpt::obs::CObservation::Ptr observation)
+{
+	MRPT_START;
+	MRPT_LOG_DEBUG("In updateOptimizerState... ");
+
+	if (this->m_graph->nodeCount() > this->m_last_total_num_of_nodes)
+	{
+		this->m_last_total_num_of_nodes = this->m_graph->nodeCount();
+		this->registered_new_node = true;
+
+		if (this->opt_params.optimization_on_second_thread)
+		{
+			// join the previous optimization thread
+			if (this->m_thread_optimize.joinable())
+				this->m_thread_optimize.join();
+
+			// update the smoother - run on a seperate thread
+			this->m_thread_optimize =
+				std::thread(&CIncrementalSmootherGSO::optimizeGraph, this);
+		}
+		else
+		{  // single threaded implementation
+			this->_updateSmoother();
+		}
+	}
+
+	return true;
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::notifyOfWindowEvents(
+	const std::map<std::string, bool>& events_occurred)
+{
+	MRPT_START;
+	parent::notifyOfWindowEvents(events_occurred);
+
+	// A full Levenberg-Marquardt optimization was just run by the parent
+	// class: start over from its solution.
+	if (this->opt_params.optimization_distance > 0)
+	{
+		const auto it =
+			events_occurred.find(this->opt_params.keystroke_optimize_graph);
+		if (it != events_occurred.end() && it->second)
+		{
+			MRPT_LOG_DEBUG("Full graph optimization, restarting smoother.");
+			m_smoother.clear();
+		}
+	}
+
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::optimizeGraph()
+{
+	MRPT_START;
+	std::lock_guard<std::mutex> m_graph_lock(*this->m_graph_section);
+	this->_updateSmoother();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::_updateSmoother()
+{
+	MRPT_START;
+	// if less than X nodes exist overall, do not try optimizing
+	if (this->m_min_nodes_for_optimization > this->m_graph->nodes.size())
+	{
+		return;
+	}
+
+	this->m_time_logger.enter("CIncrementalSmootherGSO::_updateSmoother");
+	m_smoother.options = inc_params.options;
+	m_smoother.update(*this->m_graph, &m_last_update_info);
+	this->m_time_logger.leave("CIncrementalSmootherGSO::_updateSmoother");
+
+	this->m_just_fully_optimized_graph = m_last_update_info.full_reset;
+
+	MRPT_LOG_DEBUG_FMT(
+		"Smoother update: %u new nodes, %u new edges, %u relinearized, %u "
+		"refactored columns, %u updated poses%s",
+		static_cast<unsigned int>(m_last_update_info.new_nodes),
+		static_cast<unsigned int>(m_last_update_info.new_edges),
+		static_cast<unsigned int>(m_last_update_info.relinearized_nodes),
+		static_cast<unsigned int>(m_last_update_info.refactored_columns),
+		static_cast<unsigned int>(m_last_update_info.updated_poses),
+		m_last_update_info.full_reset ? " (FULL RESET)" : "");
+
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::printParams() const
+{
+	parent::printParams();
+	inc_params.dumpToConsole();
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::loadParams(
+	const std::string& source_fname)
+{
+	MRPT_START;
+	parent::loadParams(source_fname);
+	inc_params.loadFromConfigFileName(source_fname, "OptimizerParameters");
+	m_smoother.options = inc_params.options;
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::getDescriptiveReport(
+	std::string* report_str) const
+{
+	MRPT_START;
+	using namespace std;
+
+	const std::string report_sep(2, '\n');
+	const std::string header_sep(80, '#');
+
+	stringstream class_props_ss;
+	class_props_ss << "Incremental Smoother Optimization Summary: " << endl;
+	class_props_ss << header_sep << endl;
+	class_props_ss << "Optimized nodes               : "
+				   << m_smoother.getVariableCount() << endl;
+	class_props_ss << "Non-zero blocks in the factor : "
+				   << m_smoother.getFactorSize() << endl;
+
+	// time and output logging
+	const std::string time_res = this->m_time_logger.getStatsAsText();
+	const std::string output_res = this->getLogAsString();
+
+	// merge the individual reports
+	report_str->clear();
+	parent::parent::getDescriptiveReport(report_str);
+
+	*report_str += class_props_ss.str();
+	*report_str += report_sep;
+
+	*report_str += time_res;
+	*report_str += report_sep;
+
+	*report_str += output_res;
+	*report_str += report_sep;
+
+	MRPT_END;
+}
+
+// IncrementalParams
+//////////////////////////////////////////////////////////////
+template <class GRAPH_T>
+CIncrementalSmootherGSO<GRAPH_T>::IncrementalParams::IncrementalParams()
+{
+}
+template <class GRAPH_T>
+CIncrementalSmootherGSO<GRAPH_T>::IncrementalParams::~IncrementalParams()
+{
+}
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::IncrementalParams::dumpToTextStream(
+	mrpt::utils::CStream& out) const
+{
+	MRPT_START;
+
+	out.printf(
+		"------------------[ Incremental Smoother ]------------------\n");
+	out.printf(
+		"Relinearize threshold          = %f\n",
+		options.relinearize_threshold);
+	out.printf(
+		"Relinearize skip               = %u\n", options.relinearize_skip);
+	out.printf(
+		"Wildfire threshold             = %f\n", options.wildfire_threshold);
+
+	MRPT_END;
+}
+template <class GRAPH_T>
+void CIncrementalSmootherGSO<GRAPH_T>::IncrementalParams::loadFromConfigFile(
+	const mrpt::utils::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_START;
+	options.relinearize_threshold = source.read_double(
+		section, "relinearize_threshold", options.relinearize_threshold,
+		false);
+	options.relinearize_skip = source.read_int(
+		section, "relinearize_skip", options.relinearize_skip, false);
+	options.wildfire_threshold = source.read_double(
+		section, "wildfire_threshold", options.wildfire_threshold, false);
+	ASSERT_ABOVE_(options.relinearize_threshold, 0)
+	MRPT_END;
+}
+}
+}
+}  // end of namespaces
+
+#endif /* end of include guard: CINCREMENTALSMOOTHERGSO_IMPL_H */
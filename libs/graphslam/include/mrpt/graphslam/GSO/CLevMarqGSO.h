@@ -82,6 +82,20 @@ namespace optimizers
  *  graph node are optimized according to the corresponding constraints between
  *  them
  *
+ * - \b marginalization_window
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 0
+ *  + \a Required      : FALSE
+ *  + \a Description   : If >0, only the latest nodes (this number of them)
+ *  and the root are optimized: older nodes are marginalized out into dense
+ *  prior factors (see mrpt::graphslam::marginalize_graph_nodes()), so the
+ *  size of the linear system solved on each iteration stays bounded.
+ *  Marginalized nodes are kept in the graph with their last estimated poses,
+ *  which are fixed from then on: the edges registered to them afterwards
+ *  (e.g. loop closures) are still used, with those poses fixed. The graph
+ *  does not shrink, so each optimization still goes through all its nodes
+ *  and edges.
+ *
  * - \b verbose
  *  + \a Section       : OptimizerParameters
  *  + \a Default value : FALSE
@@ -191,6 +205,9 @@ class CLevMarqGSO
 		std::string keystroke_optimization_distance;
 		/**\brief Keystroke to manually trigger a full graph optimization */
 		std::string keystroke_optimize_graph;
+		/**\brief If >0, marginalize out the nodes older than this number of
+		 * latest nodes (but the root) */
+		int marginalization_window;
 
 		// nodeID difference for an edge to be considered loop closure
 		int LC_min_nodeid_diff;
@@ -336,6 +353,10 @@ class CLevMarqGSO
 	/**\brief Get a list of the nodeIDs whose position is within a certain
 	 * distance to the specified nodeID
 	 */
+	/**\brief Marginalize the nodes which have left the window of
+	 * optimized nodes, if \b marginalization_window is set.
+	 */
+	void marginalizeOldNodes();
 	void getNearbyNodesOf(
 		std::set<mrpt::utils::TNodeID>* nodes_set,
 		const mrpt::utils::TNodeID& cur_nodeID, double distance);
@@ -408,6 +429,13 @@ class CLevMarqGSO
 
 	/**\brief Minimum number of nodes before we try optimizing the graph */
 	size_t m_min_nodes_for_optimization;
+
+	/**\brief Priors of the marginalized nodes
+	 * \sa marginalizeOldNodes
+	 */
+	mrpt::graphslam::TMarginalPriors<GRAPH_T> m_marginal_priors;
+	/**\brief First node which has not been marginalized yet */
+	mrpt::utils::TNodeID m_next_node_to_marginalize;
 };
 }
 }
@@ -29,7 +29,8 @@ CLevMarqGSO<GRAPH_T>::CLevMarqGSO()
 	  m_curr_used_consec_lcs(0),
 	  m_curr_ignored_consec_lcs(0),
 	  m_just_fully_optimized_graph(false),
-	  m_min_nodes_for_optimization(3)
+	  m_min_nodes_for_optimization(3),
+	  m_next_node_to_marginalize(0)
 {
 	MRPT_START;
 	using namespace mrpt::utils;
@@ -439,6 +440,8 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	CTicTac optimization_timer;
 	optimization_timer.Tic();
 
+	this->marginalizeOldNodes();
+
 	// set of nodes for which the optimization procedure will take place
 	std::set<mrpt::utils::TNodeID>* nodes_to_optimize;
 
@@ -470,7 +473,8 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	// Execute the optimization
 	mrpt::graphslam::optimize_graph_spa_levmarq(
 		*(this->m_graph), levmarq_info, nodes_to_optimize, opt_params.cfg,
-		&CLevMarqGSO<GRAPH_T>::levMarqFeedback);  // functor feedback
+		&CLevMarqGSO<GRAPH_T>::levMarqFeedback,  // functor feedback
+		&m_marginal_priors);
 
 	if (is_full_update)
 	{
@@ -495,6 +499,39 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	MRPT_END;
 }  // end of _optimizeGraph
 
+template <class GRAPH_T>
+void CLevMarqGSO<GRAPH_T>::marginalizeOldNodes()
+{
+	MRPT_START;
+	using namespace mrpt::utils;
+
+	if (opt_params.marginalization_window <= 0) return;
+	const size_t window_size = opt_params.marginalization_window;
+	const size_t node_count = this->m_graph->nodeCount();
+	if (node_count <= window_size + m_next_node_to_marginalize) return;
+
+	// Marginalized nodes are kept in the graph, since the deciders refer to
+	// the nodes by their IDs:
+	std::set<TNodeID> nodes_to_marginalize;
+	for (TNodeID id = m_next_node_to_marginalize;
+		 id < node_count - window_size; id++)
+		if (id != this->m_graph->root) nodes_to_marginalize.insert(id);
+	m_next_node_to_marginalize = node_count - window_size;
+
+	this->m_time_logger.enter("CLevMarqGSO::marginalizeOldNodes");
+	mrpt::graphslam::marginalize_graph_nodes(
+		*this->m_graph, nodes_to_marginalize, m_marginal_priors,
+		/*remove_from_graph=*/false);
+	this->m_time_logger.leave("CLevMarqGSO::marginalizeOldNodes");
+
+	MRPT_LOG_DEBUG_FMT(
+		"Marginalized %u nodes, %u marginal priors",
+		static_cast<unsigned int>(nodes_to_marginalize.size()),
+		static_cast<unsigned int>(m_marginal_priors.priors.size()));
+
+	MRPT_END;
+}
+
 template <class GRAPH_T>
 bool CLevMarqGSO<GRAPH_T>::checkForLoopClosures()
 {
@@ -743,7 +780,8 @@ template <class GRAPH_T>
 CLevMarqGSO<GRAPH_T>::OptimizationParams::OptimizationParams()
 	: optimization_distance_color(0, 201, 87),
 	  keystroke_optimization_distance("u"),
-	  keystroke_optimize_graph("w")
+	  keystroke_optimize_graph("w"),
+	  marginalization_window(0)
 {
 }
 template <class GRAPH_T>
@@ -765,6 +803,8 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::dumpToTextStream(
 	out.printf(
 		"Optimize nodes in distance     = %.2f\n", optimization_distance);
 	out.printf("Min. node difference for LC    = %d\n", LC_min_nodeid_diff);
+	out.printf(
+		"Marginalization window         = %d\n", marginalization_window);
 
 	out.printf("%s", cfg.getAsString().c_str());
 	std::cout << std::endl;
@@ -788,6 +828,8 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::loadFromConfigFile(
 		format(
 			"Invalid value for optimization distance: %.2f",
 			optimization_distance));
+	marginalization_window =
+		source.read_int(section, "marginalization_window", 0, false);
 
 	// optimization parameters
 	cfg["verbose"] = source.read_bool(section, "verbose", 0, false);
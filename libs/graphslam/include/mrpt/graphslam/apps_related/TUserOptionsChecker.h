@@ -24,6 +24,7 @@
 #include <mrpt/graphslam/ERD/CEmptyERD.h>
 #include <mrpt/graphslam/ERD/CLoopCloserERD.h>
 #include <mrpt/graphslam/GSO/CLevMarqGSO.h>
+#include <mrpt/graphslam/GSO/CIncrementalSmootherGSO.h>
 
 #include <string>
 #include <iostream>
@@ -62,6 +62,8 @@ void TUserOptionsChecker<GRAPH_t>::createDeciderOptimizerMappings()
 	// optimizers
 	optimizers_map["CLevMarqGSO"] =
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
+	optimizers_map["CIncrementalSmootherGSO"] =
+		&createGraphSlamOptimizer<CIncrementalSmootherGSO<GRAPH_t>>;
 	optimizers_map["CEmptyGSO"] =
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
 
@@ -428,6 +430,19 @@ void TUserOptionsChecker<GRAPH_t>::populateDeciderOptimizerProperties()
 		optimizers_descriptions.push_back(opt);
 	}
 
+	{  // CIncrementalSmootherGSO
+		TOptimizerProps* opt = new TOptimizerProps;
+		opt->name = "CIncrementalSmootherGSO";
+		opt->description =
+			"Incremental smoother - updates only the affected part of the "
+			"factorization after each new node";
+		opt->is_mr_slam_class = true;
+		opt->is_slam_2d = true;
+		opt->is_slam_3d = true;
+
+		optimizers_descriptions.push_back(opt);
+	}
+
 	MRPT_END
 }
 }
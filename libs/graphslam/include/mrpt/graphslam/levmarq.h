@@ -11,8 +11,9 @@
 
 #include <mrpt/graphslam/types.h>
 #include <mrpt/utils/TParameters.h>
-#include <mrpt/utils/stl_containers_utils.h>  // find_in_vector()
 #include <mrpt/graphslam/levmarq_impl.h>  // Aux classes
+#include <mrpt/graphslam/marginalization.h>
+#include <mrpt/math/CSparseBlockCholesky.h>
 
 #include <iterator>  // ostream_iterator
 
@@ -46,6 +47,12 @@ namespace graphslam
   * \param[in] functor_feedback Optional: a pointer to a user function can be
   *set here to be called on each LM loop iteration (eg to refresh the current
   *state and error, refresh a GUI, etc.)
+  * \param[in] marginal_priors Optional: dense prior factors of marginalized
+  *nodes (see marginalize_graph_nodes()), added to the cost function. Nodes
+  *marginalized but kept in the graph are fixed, and the edges already
+  *summarized in the priors are ignored (but not the newer edges of those
+  *nodes). The errors of the priors (which may be negative) are included in
+  *TResultInfoSpaLevMarq::final_total_sq_error.
   *
   * List of optional parameters by name in "extra_params":
   *		- "verbose": (default=0) If !=0, produce verbose ouput.
@@ -62,6 +69,9 @@ namespace graphslam
   *		- "e2": (default=1e-6) Lev-marq algorithm iteration stopping criterion
   *#2:
   *|delta_incr| < e2*(x_norm+e2)
+  *		- "num_threads": (default=0) Number of threads to evaluate the
+  *Jacobians, errors and the Hessian. 0 means automatic: one per CPU core, but
+  *not more than one per 1000 edges.
   *
   * \note The following graph types are supported:
   *mrpt::graphs::CNetworkOfPoses2D, mrpt::graphs::CNetworkOfPoses3D,
@@ -82,7 +92,9 @@ void optimize_graph_spa_levmarq(
 	const mrpt::utils::TParametersDouble& extra_params =
 		mrpt::utils::TParametersDouble(),
 	typename graphslam_traits<GRAPH_T>::TFunctorFeedback functor_feedback =
-		nullptr)
+		nullptr,
+	const TMarginalPriors<typename graphslam_traits<GRAPH_T>::graph_t>*
+		marginal_priors = nullptr)
 {
 	using namespace mrpt;
 	using namespace mrpt::poses;
@@ -137,7 +149,9 @@ void optimize_graph_spa_levmarq(
 		for (typename gst::graph_t::global_poses_t::const_iterator it =
 				 graph.nodes.begin();
 			 it != graph.nodes.end(); ++it)
-			if (it->first != graph.root)  // Root node is fixed.
+			if (it->first != graph.root &&  // Root node is fixed.
+				!(marginal_priors &&
+				  marginal_priors->isMarginalized(it->first)))
 				nodes_to_optimize_auxlist.insert(
 					nodes_to_optimize_auxlist.end(),
 					it->first);  // Provide the "first guess" insert position
@@ -146,8 +160,19 @@ void optimize_graph_spa_levmarq(
 	}
 	profiler.leave("optimize_graph_spa_levmarq.list_IDs");  // ---------------/
 
+	// Flat, index-based layout of the problem: free nodes are numbered in
+	// [0,nFreeNodes-1] as ordered in "*nodes_to_optimize", and we keep direct
+	// pointers to their poses to avoid map look-ups in the main loop.
+	// Marginalized nodes are never free.
+	typedef typename gst::graph_t::constraint_t::type_value pose_t;
+	vector<TNodeID> free_node_IDs;  // Sorted
+	free_node_IDs.reserve(nodes_to_optimize->size());
+	for (const TNodeID id : *nodes_to_optimize)
+		if (!marginal_priors || !marginal_priors->isMarginalized(id))
+			free_node_IDs.push_back(id);
+
 	// Number of nodes to optimize, or free variables:
-	const size_t nFreeNodes = nodes_to_optimize->size();
+	const size_t nFreeNodes = free_node_IDs.size();
 	ASSERT_ABOVE_(nFreeNodes, 0)
 
 	if (verbose)
@@ -163,11 +188,33 @@ void optimize_graph_spa_levmarq(
 		cout << endl;
 	}
 
+	vector<pose_t*> free_node_poses(nFreeNodes);
+	for (size_t i = 0; i < nFreeNodes; i++)
+	{
+		typename gst::graph_t::global_poses_t::iterator itP =
+			graph.nodes.find(free_node_IDs[i]);
+		ASSERTMSG_(
+			itP != graph.nodes.end(),
+			"Node to optimize does not have a global pose in 'graph.nodes'.")
+		free_node_poses[i] = &itP->second;
+	}
+	// Index of a node in [0,nFreeNodes-1], or "-1" if that node is fixed:
+	auto free_node_index = [&free_node_IDs](const TNodeID id) -> size_t {
+		const auto it =
+			std::lower_bound(free_node_IDs.begin(), free_node_IDs.end(), id);
+		return (it != free_node_IDs.end() && *it == id)
+				   ? static_cast<size_t>(it - free_node_IDs.begin())
+				   : string::npos;
+	};
+
 	// The list of those edges that will be considered in this optimization
 	// (many may be discarded
 	//  if we are optimizing just a subset of all the nodes):
 	typedef typename gst::observation_info_t observation_info_t;
 	vector<observation_info_t> lstObservationData;
+	// For each observation, the indices of its two nodes in
+	// [0,nFreeNodes-1], or "-1" if that node is fixed:
+	vector<pair<size_t, size_t>> observationIndex_to_relatedFreeNodeIndex;
 
 	// Note: We'll need those Jacobians{i->j} where at least one "i" or "j"
 	//        is a free variable (i.e. it's in nodes_to_optimize)
@@ -178,9 +225,12 @@ void optimize_graph_spa_levmarq(
 		const TPairNodeIDs& ids = it->first;
 		const typename gst::graph_t::edge_t& edge = it->second;
 
-		if (nodes_to_optimize->find(ids.first) == nodes_to_optimize->end() &&
-			nodes_to_optimize->find(ids.second) == nodes_to_optimize->end())
+		const size_t idx1 = free_node_index(ids.first);
+		const size_t idx2 = free_node_index(ids.second);
+		if (idx1 == string::npos && idx2 == string::npos)
 			continue;  // Skip this edge, none of the IDs are free variables.
+		if (marginal_priors && marginal_priors->isMarginalizedEdge(graph, it))
+			continue;  // Already summarized in the marginal priors.
 
 		// get the current global poses of both nodes in this constraint:
 		typename gst::graph_t::global_poses_t::iterator itP1 =
@@ -205,24 +255,62 @@ void optimize_graph_spa_levmarq(
 		new_entry.P2 = &itP2->second;
 
 		lstObservationData.push_back(new_entry);
+		observationIndex_to_relatedFreeNodeIndex.push_back(
+			std::make_pair(idx1, idx2));
 	}
 
 	// The number of constraints, or observations actually implied in this
 	// problem:
 	const size_t nObservations = lstObservationData.size();
-	ASSERT_ABOVE_(nObservations, 0)
 
-	// Cholesky object, as a pointer to reuse it between iterations:
-
-	typedef std::unique_ptr<CSparseMatrix::CholeskyDecomp>
-		SparseCholeskyDecompPtr;
-	SparseCholeskyDecompPtr ptrCh;
+	// The marginal priors with any free node, and the indices of their nodes
+	// in [0,nFreeNodes-1], or "-1" for fixed nodes:
+	typedef typename TMarginalPriors<GRAPH_T>::TPrior prior_t;
+	vector<const prior_t*> lstPriors;
+	vector<vector<size_t>> priorIndex_to_relatedFreeNodeIndex;
+	if (marginal_priors)
+	{
+		for (const prior_t& p : marginal_priors->priors)
+		{
+			vector<size_t> idxs(p.nodes.size());
+			for (size_t i = 0; i < p.nodes.size(); i++)
+				idxs[i] = free_node_index(p.nodes[i]);
+			if (std::all_of(idxs.begin(), idxs.end(), [](const size_t i) {
+					return i == string::npos;
+				}))
+				continue;
+			lstPriors.push_back(&p);
+			priorIndex_to_relatedFreeNodeIndex.push_back(idxs);
+		}
+	}
+	const size_t nPriors = lstPriors.size();
+	ASSERT_ABOVE_(nObservations + nPriors, 0)
+	// Errors of the marginal priors at the current poses:
+	auto priors_sqr_err = [&]() {
+		double err = 0;
+		Eigen::VectorXd delta;
+		for (const prior_t* p : lstPriors)
+			err += detail::evalMarginalPrior(graph, *p, delta);
+		return err;
+	};
+
+	// Edges are linearized in parallel, each thread taking a contiguous range
+	// of "lstObservationData":
+	size_t num_threads = extra_params.getWithDefaultVal("num_threads", 0);
+	if (num_threads == 0)
+	{
+		num_threads = std::min<size_t>(
+			mrpt::utils::parallel_num_threads(0), 1 + nObservations / 1000);
+	}
+	// (no more threads than edges, so all the accumulators below are used)
+	num_threads =
+		std::min<size_t>(num_threads, std::max<size_t>(1, nObservations));
 
 	// The list of Jacobians: for each constraint i->j,
 	//  we need the pair of Jacobians: { dh(xi,xj)_dxi, dh(xi,xj)_dxj },
 	//  which are "first" and "second" in each pair.
-	// Index of the map are the node IDs {i,j} for each contraint.
-	typename gst::map_pairIDs_pairJacobs_t lstJacobians;
+	// Same order than lstObservationData.
+	typename gst::vector_pairJacobs_t lstJacobians;
 	// The vector of errors: err_k = SE(2/3)::pseudo_Ln( P_i * EDGE_ij *
 	// inv(P_j) )
 	typename mrpt::aligned_containers<typename gst::Array_O>::vector_t
@@ -234,41 +322,91 @@ void optimize_graph_spa_levmarq(
 	// ===================================
 	profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 	double total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-		graph, lstObservationData, lstJacobians, errs);
+		graph, lstObservationData, lstJacobians, errs, num_threads);
+	total_sqr_err += priors_sqr_err();
 	profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
-	// Only once (since this will be static along iterations), build a quick
-	// look-up table with the
-	//  indices of the free nodes associated to the (first_id,second_id) of each
-	//  Jacobian pair:
-	// ------------------------------------------------------------------------
-	vector<pair<size_t, size_t>>
-		observationIndex_to_relatedFreeNodeIndex;  // "relatedFreeNodeIndex"
-	// means into
-	// [0,nFreeNodes-1], or "-1"
-	// if that node is fixed, as
-	// ordered in
-	// "nodes_to_optimize"
-	observationIndex_to_relatedFreeNodeIndex.reserve(nObservations);
-	ASSERTDEB_(lstJacobians.size() == nObservations)
-	for (typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ =
-			 lstJacobians.begin();
-		 itJ != lstJacobians.end(); ++itJ)
+	// Sparse Hessian and its Cholesky factorization. The sparsity pattern
+	// only depends on the graph topology, so the symbolic analysis
+	// (fill-reducing ordering, structure of the factor) is done only once
+	// here and reused in all the iterations below. Only the lower triangular
+	// part of H is stored, as DIMS_POSE x DIMS_POSE blocks.
+	profiler.enter("optimize_graph_spa_levmarq.sp_H:symbolic");
+	typedef mrpt::math::CSparseBlockCholesky<DIMS_POSE> hessian_t;
+	hessian_t sp_H;
+	// For each observation: index of its off-diagonal block in "sp_H", or
+	// "-1" if the edge does not connect two different free nodes.
+	vector<size_t> observationIndex_to_HblockIndex(nObservations, string::npos);
+	// For each prior with nodes a,b (a>b): the index of the block (a,b) in
+	// "sp_H" at [a*n+b], or "-1".
+	vector<vector<size_t>> priorIndex_to_HblockIndex(nPriors);
 	{
-		const TNodeID id1 = itJ->first.first;
-		const TNodeID id2 = itJ->first.second;
-		observationIndex_to_relatedFreeNodeIndex.push_back(
-			std::make_pair(
-				mrpt::utils::find_in_vector(id1, *nodes_to_optimize),
-				mrpt::utils::find_in_vector(id2, *nodes_to_optimize)));
+		vector<pair<size_t, size_t>> lower_blocks;
+		vector<size_t> lower_blocks_obs;
+		for (size_t idxObs = 0; idxObs < nObservations; ++idxObs)
+		{
+			const size_t idx1 =
+				observationIndex_to_relatedFreeNodeIndex[idxObs].first;
+			const size_t idx2 =
+				observationIndex_to_relatedFreeNodeIndex[idxObs].second;
+			if (idx1 == string::npos || idx2 == string::npos || idx1 == idx2)
+				continue;
+			lower_blocks.push_back(
+				std::make_pair(std::max(idx1, idx2), std::min(idx1, idx2)));
+			lower_blocks_obs.push_back(idxObs);
+		}
+		const size_t nEdgeBlocks = lower_blocks.size();
+		for (size_t idxPrior = 0; idxPrior < nPriors; ++idxPrior)
+		{
+			const vector<size_t>& idxs =
+				priorIndex_to_relatedFreeNodeIndex[idxPrior];
+			for (size_t a = 0; a < idxs.size(); a++)
+				for (size_t b = 0; b < a; b++)
+					if (idxs[a] != string::npos && idxs[b] != string::npos)
+						lower_blocks.push_back(
+							std::make_pair(
+								std::max(idxs[a], idxs[b]),
+								std::min(idxs[a], idxs[b])));
+		}
+		vector<size_t> block_indices;
+		sp_H.setPattern(nFreeNodes, lower_blocks, block_indices);
+		for (size_t k = 0; k < nEdgeBlocks; k++)
+			observationIndex_to_HblockIndex[lower_blocks_obs[k]] =
+				block_indices[k];
+		size_t k = nEdgeBlocks;
+		for (size_t idxPrior = 0; idxPrior < nPriors; ++idxPrior)
+		{
+			const vector<size_t>& idxs =
+				priorIndex_to_relatedFreeNodeIndex[idxPrior];
+			const size_t n = idxs.size();
+			priorIndex_to_HblockIndex[idxPrior].assign(n * n, string::npos);
+			for (size_t a = 0; a < n; a++)
+				for (size_t b = 0; b < a; b++)
+					if (idxs[a] != string::npos && idxs[b] != string::npos)
+						priorIndex_to_HblockIndex[idxPrior][a * n + b] =
+							block_indices[k++];
+		}
 	}
+	profiler.leave("optimize_graph_spa_levmarq.sp_H:symbolic");
 
 	// other important vars for the main loop:
 	CVectorDouble grad(nFreeNodes * DIMS_POSE);
 	grad.setZero();
-	typedef typename mrpt::aligned_containers<
-		TNodeID, typename gst::matrix_VxV_t>::map_t map_ID2matrix_VxV_t;
-	vector<map_ID2matrix_VxV_t> H_map(nFreeNodes);
+	typename mrpt::aligned_containers<typename gst::Array_O>::vector_t
+		grad_parts(nFreeNodes, array_O_zeros);
+	// Per-thread accumulators for the gradient and the Hessian blocks, added
+	// up after each linearization. Thread #0 uses "grad_parts" and "sp_H".
+	vector<typename mrpt::aligned_containers<typename gst::Array_O>::vector_t>
+		thread_grad_parts(num_threads - 1, grad_parts);
+	vector<typename hessian_t::block_list_t> thread_H_blocks(
+		num_threads - 1,
+		typename hessian_t::block_list_t(
+			sp_H.getPatternSize(), hessian_t::block_t::Zero()));
+	typename mrpt::aligned_containers<pose_t>::vector_t old_poses_backup(
+		nFreeNodes);
+	typename gst::vector_pairJacobs_t new_lstJacobians;
+	typename mrpt::aligned_containers<typename gst::Array_O>::vector_t
+		new_errs;
 
 	double lambda = initial_lambda;  // Will be actually set on first iteration.
 	double v = 1;  // was 2, changed since it's modified in the first pass.
@@ -293,65 +431,139 @@ void optimize_graph_spa_levmarq(
 			have_to_recompute_H_and_grad = false;
 
 			// ======================================================================
-			// Compute the gradient: grad = J^t * errs
+			// Linearization: compute the gradient grad = J^t * errs and
+			// the lower triangular part of the Hessian H = J^t * J, with
+			// blocks indexed by [0,N-1] as ordered in "*nodes_to_optimize":
+			//  grad_i += Ji^t * Inf * err, for each edge involving node i
+			//  H(i,i) += Ji^t * Inf * Ji, for each edge involving node i
+			//  H(i,j) += Ji^t * Inf * Jj, for each edge i<->j
+			// Each thread accumulates the edges in its range into its own
+			// blocks, which are added up at the end.
 			// ======================================================================
-			//  "grad" can be seen as composed of N independent arrays, each one
-			//  being:
-			//   grad_i = \sum_k J^t_{k->i} errs_k
-			// that is: g_i is the "dot-product" of the i'th (transposed)
-			// block-column of J and the vector of errors "errs"
-			profiler.enter("optimize_graph_spa_levmarq.grad");
-			typename mrpt::aligned_containers<typename gst::Array_O>::vector_t
-				grad_parts(nFreeNodes, array_O_zeros);
-
-			// "lstJacobians" is sorted in the same order than
-			// "lstObservationData":
+			profiler.enter("optimize_graph_spa_levmarq.grad&sp_H:build");
 			ASSERT_EQUAL_(lstJacobians.size(), lstObservationData.size())
+			mrpt::utils::parallel_for_ranges(
+				nObservations, num_threads, [&](const size_t thread_idx,
+												const size_t first,
+												const size_t last) {
+					typename gst::Array_O* g = &grad_parts[0];
+					typename hessian_t::block_t* H = &sp_H.entry(0);
+					if (thread_idx > 0)
+					{
+						g = &thread_grad_parts[thread_idx - 1][0];
+						H = &thread_H_blocks[thread_idx - 1][0];
+					}
+					for (size_t i = 0; i < nFreeNodes; i++) g[i].fill(0);
+					for (size_t i = 0; i < sp_H.getPatternSize(); i++)
+						H[i].setZero();
+
+					for (size_t idxObs = first; idxObs < last; ++idxObs)
+					{
+						const size_t idx1 =
+							observationIndex_to_relatedFreeNodeIndex[idxObs]
+								.first;
+						const size_t idx2 =
+							observationIndex_to_relatedFreeNodeIndex[idxObs]
+								.second;
+						const bool is_1_free_node = idx1 != string::npos;
+						const bool is_2_free_node = idx2 != string::npos;
+
+						const typename gst::edge_const_iterator& edge =
+							lstObservationData[idxObs].edge;
+						const typename gst::matrix_VxV_t& J1 =
+							lstJacobians[idxObs].first;
+						const typename gst::matrix_VxV_t& J2 =
+							lstJacobians[idxObs].second;
+
+						typename gst::matrix_VxV_t JtJ(
+							mrpt::math::UNINITIALIZED_MATRIX);
+						if (is_1_free_node)
+						{
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiply_Jt_W_err(
+									J1 /* J */, edge /* W */,
+									errs[idxObs] /* err */, g[idx1] /* out */);
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiplyJtLambdaJ(J1, JtJ, edge);
+							H[idx1] += JtJ;
+						}
+						if (is_2_free_node)
+						{
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiply_Jt_W_err(
+									J2 /* J */, edge /* W */,
+									errs[idxObs] /* err */, g[idx2] /* out */);
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiplyJtLambdaJ(J2, JtJ, edge);
+							H[idx2] += JtJ;
+						}
+						if (is_1_free_node && is_2_free_node)
+						{
+							// This is the block H(idx1,idx2):
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiplyJ1tLambdaJ2(J1, J2, JtJ, edge);
+							if (idx1 == idx2)
+							{
+								H[idx1] += JtJ;
+								H[idx1] += JtJ.transpose();
+							}
+							else if (idx1 > idx2)
+								H[observationIndex_to_HblockIndex[idxObs]] +=
+									JtJ;
+							else
+								H[observationIndex_to_HblockIndex[idxObs]] +=
+									JtJ.transpose();
+						}
+					}
+				});
 
+			// Reduction of the per-thread accumulators:
+			if (num_threads > 1)
 			{
-				size_t idx_obs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ;
+				mrpt::utils::parallel_for_ranges(
+					sp_H.getPatternSize(), num_threads,
+					[&](const size_t, const size_t first, const size_t last) {
+						for (const auto& H : thread_H_blocks)
+							for (size_t i = first; i < last; i++)
+								sp_H.entry(i) += H[i];
+					});
+				for (const auto& g : thread_grad_parts)
+					for (size_t i = 0; i < nFreeNodes; i++)
+						for (size_t k = 0; k < DIMS_POSE; k++)
+							grad_parts[i][k] += g[i][k];
+			}
 
-				for (idx_obs = 0, itJ = lstJacobians.begin();
-					 itJ != lstJacobians.end(); ++itJ, ++idx_obs)
+			// The marginal priors (a few, small dense factors):
+			//  grad_a += (H*delta+g)_a, for each free node a
+			//  H(a,b) += H_ab, for each pair of free nodes a,b
+			for (size_t idxPrior = 0; idxPrior < nPriors; ++idxPrior)
+			{
+				const prior_t& p = *lstPriors[idxPrior];
+				const vector<size_t>& idxs =
+					priorIndex_to_relatedFreeNodeIndex[idxPrior];
+				const size_t n = idxs.size();
+				Eigen::VectorXd delta, g;
+				detail::evalMarginalPrior(graph, p, delta, &g);
+				for (size_t a = 0; a < n; a++)
 				{
-					ASSERTDEB_(
-						itJ->first ==
-						lstObservationData[idx_obs].edge->first)  // make sure
-					// they're in
-					// the
-					// expected
-					// order!
-
-					//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
-					//    k: [0,nFreeNodes-1]     <-- IDs.first & IDs.second
-					//    i: [0,nObservations-1]  <--- idx_obs
-
-					// Get the corresponding indices in the vector of "free
-					// variables" being optimized:
-					const size_t idx1 =
-						observationIndex_to_relatedFreeNodeIndex[idx_obs].first;
-					const size_t idx2 =
-						observationIndex_to_relatedFreeNodeIndex[idx_obs]
-							.second;
-
-					if (idx1 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.first /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx1] /* out */
-								);
-
-					if (idx2 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.second /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx2] /* out */
-								);
+					if (idxs[a] == string::npos) continue;
+					for (size_t k = 0; k < DIMS_POSE; k++)
+						grad_parts[idxs[a]][k] += g[a * DIMS_POSE + k];
+					sp_H.entry(idxs[a]) +=
+						p.H.template block<DIMS_POSE, DIMS_POSE>(
+							a * DIMS_POSE, a * DIMS_POSE);
+					for (size_t b = 0; b < a; b++)
+					{
+						if (idxs[b] == string::npos) continue;
+						// Block (a,b) of the prior, or (b,a) if it is the
+						// upper one in "sp_H":
+						const size_t r = idxs[a] > idxs[b] ? a : b;
+						const size_t c = idxs[a] > idxs[b] ? b : a;
+						sp_H.entry(priorIndex_to_HblockIndex[idxPrior]
+												[a * n + b]) +=
+							p.H.template block<DIMS_POSE, DIMS_POSE>(
+								r * DIMS_POSE, c * DIMS_POSE);
+					}
 				}
 			}
 
@@ -360,7 +572,7 @@ void optimize_graph_spa_levmarq(
 				&grad[0], &grad_parts[0],
 				nFreeNodes * DIMS_POSE * sizeof(grad[0]));  // Ohh yeahh!
 			grad /= SCALE_HESSIAN;
-			profiler.leave("optimize_graph_spa_levmarq.grad");
+			profiler.leave("optimize_graph_spa_levmarq.grad&sp_H:build");
 
 			// End condition #1
 			const double grad_norm_inf = math::norm_inf(
@@ -377,93 +589,6 @@ void optimize_graph_spa_levmarq(
 				break;
 			}
 
-			profiler.enter("optimize_graph_spa_levmarq.sp_H:build map");
-			// ======================================================================
-			// Build sparse representation of the upper triangular part of
-			//  the Hessian matrix H = J^t * J
-			//
-			// Sparse memory structure is a vector of maps, such as:
-			//  - H_map[i]: corresponds to the i'th column of H.
-			//              Here "i" corresponds to [0,N-1] indices of
-			//              appearance in the map "*nodes_to_optimize".
-			//  - H_map[i][j] is the entry for the j'th row, with "j" also in
-			//  the range [0,N-1] as ordered in "*nodes_to_optimize".
-			// ======================================================================
-			{
-				size_t idxObs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator
-					itJacobPair;
-
-				for (idxObs = 0, itJacobPair = lstJacobians.begin();
-					 idxObs < nObservations; ++itJacobPair, ++idxObs)
-				{
-					// We sort IDs such as "i" < "j" and we can build just the
-					// upper triangular part of the Hessian.
-					const bool edge_straight =
-						itJacobPair->first.first < itJacobPair->first.second;
-
-					// Indices in the "H_map" vector:
-					const size_t idx_i =
-						edge_straight
-							? observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .first
-							: observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .second;
-					const size_t idx_j =
-						edge_straight
-							? observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .second
-							: observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .first;
-
-					const bool is_i_free_node = idx_i != string::npos;
-					const bool is_j_free_node = idx_j != string::npos;
-
-					// Take references to both Jacobians (wrt pose "i" and pose
-					// "j"), taking into account the possible
-					// switch in their order:
-
-					const typename gst::matrix_VxV_t& J1 =
-						edge_straight ? itJacobPair->second.first
-									  : itJacobPair->second.second;
-					const typename gst::matrix_VxV_t& J2 =
-						edge_straight ? itJacobPair->second.second
-									  : itJacobPair->second.first;
-
-					// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
-					if (is_i_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J1, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_i][idx_i] += JtJ;
-					}
-					// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
-					if (is_j_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_j] += JtJ;
-					}
-					// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
-					if (is_i_free_node && is_j_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJ1tLambdaJ2(
-								J1, J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_i] += JtJ;
-					}
-				}
-			}
-			profiler.leave("optimize_graph_spa_levmarq.sp_H:build map");
-
 			// Just in the first iteration, we need to calculate an estimate for
 			// the first value of "lamdba":
 			if (lambda <= 0 && iter == 0)
@@ -472,20 +597,9 @@ void optimize_graph_spa_levmarq(
 					"optimize_graph_spa_levmarq.lambda_init");  // ---\  .
 				double H_diagonal_max = 0;
 				for (size_t i = 0; i < nFreeNodes; i++)
-					for (typename map_ID2matrix_VxV_t::const_iterator it =
-							 H_map[i].begin();
-						 it != H_map[i].end(); ++it)
-					{
-						const size_t j =
-							it->first;  // entry submatrix is for (i,j).
-						if (i == j)
-						{
-							for (size_t k = 0; k < DIMS_POSE; k++)
-								mrpt::utils::keep_max(
-									H_diagonal_max,
-									it->second.get_unsafe(k, k));
-						}
-					}
+					for (size_t k = 0; k < DIMS_POSE; k++)
+						mrpt::utils::keep_max(
+							H_diagonal_max, sp_H.entry(i)(k, k));
 				lambda = tau * H_diagonal_max;
 
 				profiler.leave(
@@ -498,9 +612,6 @@ void optimize_graph_spa_levmarq(
 			}
 			utils::keep_max(lambda, 1e-200);  // JL: Avoids underflow!
 			v = 2;
-#if 0
-					{ mrpt::math::CMatrixDouble H; sp_H.get_dense(H); H.saveToTextFile("d:\\H.txt"); }
-#endif
 		}  // end "have_to_recompute_H_and_grad"
 
 		if (verbose)
@@ -516,52 +627,7 @@ void optimize_graph_spa_levmarq(
 			(*functor_feedback)(graph, iter, max_iters, total_sqr_err);
 		}
 
-		profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
-		// Now, build the actual sparse matrix H:
-		// Note: we only need to fill out the upper diagonal part, since
-		// Cholesky will later on ignore the other part.
-		CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
-		for (size_t i = 0; i < nFreeNodes; i++)
-		{
-			const size_t i_offset = i * DIMS_POSE;
-
-			for (typename map_ID2matrix_VxV_t::const_iterator it =
-					 H_map[i].begin();
-				 it != H_map[i].end(); ++it)
-			{
-				const size_t j = it->first;  // entry submatrix is for (i,j).
-				const size_t j_offset = j * DIMS_POSE;
-
-				// For i==j (diagonal blocks), it's different, since we only
-				// need to insert their
-				// upper-diagonal half and also we have to add the lambda*I to
-				// the diagonal from the Lev-Marq. algorithm:
-				if (i == j)
-				{
-					for (size_t r = 0; r < DIMS_POSE; r++)
-					{
-						// c=r: add lambda from LM
-						sp_H.insert_entry_fast(
-							j_offset + r, i_offset + r,
-							it->second.get_unsafe(r, r) + lambda);
-						// c>r:
-						for (size_t c = r + 1; c < DIMS_POSE; c++)
-							sp_H.insert_entry_fast(
-								j_offset + r, i_offset + c,
-								it->second.get_unsafe(r, c));
-					}
-				}
-				else
-				{
-					sp_H.insert_submatrix(j_offset, i_offset, it->second);
-				}
-			}
-		}  // end for each free node, build sp_H
-
-		sp_H.compressFromTriplet();
-		profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
-
-		// Use the cparse Cholesky decomposition to efficiently solve:
+		// Use the sparse Cholesky decomposition to efficiently solve:
 		//   (H+\lambda*I) \delta = -J^t * (f(x)-z)
 		//          A         x   =  b         -->       x = A^{-1} * b
 		//
@@ -570,15 +636,11 @@ void optimize_graph_spa_levmarq(
 		try
 		{
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:chol");
-			if (!ptrCh.get())
-				ptrCh = SparseCholeskyDecompPtr(
-					new CSparseMatrix::CholeskyDecomp(sp_H));
-			else
-				ptrCh.get()->update(sp_H);
+			sp_H.factorize(lambda);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:chol");
 
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:backsub");
-			ptrCh->backsub(grad, delta);
+			sp_H.solve(grad, delta);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:backsub");
 		}
 		catch (CExceptionNotDefPos&)
@@ -606,13 +668,9 @@ void optimize_graph_spa_levmarq(
 		profiler.enter("optimize_graph_spa_levmarq.x_norm");
 		double x_norm = 0;
 		{
-			for (set<TNodeID>::const_iterator it = nodes_to_optimize->begin();
-				 it != nodes_to_optimize->end(); ++it)
+			for (size_t n = 0; n < nFreeNodes; n++)
 			{
-				typename gst::graph_t::global_poses_t::const_iterator itP =
-					graph.nodes.find(*it);
-				const typename gst::graph_t::constraint_t::type_value& P =
-					itP->second;
+				const pose_t& P = *free_node_poses[n];
 				for (size_t i = 0; i < DIMS_POSE; i++) x_norm += square(P[i]);
 			}
 			x_norm = std::sqrt(x_norm);
@@ -639,19 +697,13 @@ void optimize_graph_spa_levmarq(
 			//  new_x = old_x [+] (-delta)    , with [+] being the "manifold
 			//  exp()+add" operation.
 			// =====================================================================================
-			typename gst::graph_t::global_poses_t old_poses_backup;
-
 			{
-				ASSERTDEB_(
-					delta.size() == nodes_to_optimize->size() * DIMS_POSE)
+				ASSERTDEB_(delta.size() == nFreeNodes * DIMS_POSE)
 				const double* delta_ptr = &delta[0];
-				for (set<TNodeID>::const_iterator it =
-						 nodes_to_optimize->begin();
-					 it != nodes_to_optimize->end(); ++it)
+				for (size_t n = 0; n < nFreeNodes; n++)
 				{
 					// exp_delta_i = Exp_SE( delta_i )
-					typename gst::graph_t::constraint_t::type_value
-						exp_delta_pose(UNINITIALIZED_POSE);
+					pose_t exp_delta_pose(UNINITIALIZED_POSE);
 					typename gst::Array_O exp_delta;
 					for (size_t i = 0; i < DIMS_POSE; i++)
 						exp_delta[i] = -*delta_ptr++;  // The "-" sign is for
@@ -661,25 +713,21 @@ void optimize_graph_spa_levmarq(
 					gst::SE_TYPE::exp(exp_delta, exp_delta_pose);
 
 					// new_x_i =  exp_delta_i (+) old_x_i
-					typename gst::graph_t::global_poses_t::iterator
-						it_old_value = graph.nodes.find(*it);
-					old_poses_backup[*it] =
-						it_old_value->second;  // back up the old pose as a copy
-					it_old_value->second.composeFrom(
-						exp_delta_pose, it_old_value->second);
+					old_poses_backup[n] =
+						*free_node_poses[n];  // back up the old pose as a copy
+					free_node_poses[n]->composeFrom(
+						exp_delta_pose, old_poses_backup[n]);
 				}
 			}
 
 			// =============================================================
 			// Compute Jacobians & errors with the new "graph.nodes" info:
 			// =============================================================
-			typename gst::map_pairIDs_pairJacobs_t new_lstJacobians;
-			typename mrpt::aligned_containers<typename gst::Array_O>::vector_t
-				new_errs;
-
 			profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 			double new_total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-				graph, lstObservationData, new_lstJacobians, new_errs);
+				graph, lstObservationData, new_lstJacobians, new_errs,
+				num_threads);
+			new_total_sqr_err += priors_sqr_err();
 			profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 			// Now, to decide whether to accept the change:
@@ -697,10 +745,8 @@ void optimize_graph_spa_levmarq(
 			{
 				// Nope...
 				// We have to revert the "graph.nodes" to "old_poses_backup"
-				for (typename gst::graph_t::global_poses_t::const_iterator it =
-						 old_poses_backup.begin();
-					 it != old_poses_backup.end(); ++it)
-					graph.nodes[it->first] = it->second;
+				for (size_t n = 0; n < nFreeNodes; n++)
+					*free_node_poses[n] = old_poses_backup[n];
 
 				if (verbose)
 					cout << "[" << __CURRENT_FUNCTION_NAME__
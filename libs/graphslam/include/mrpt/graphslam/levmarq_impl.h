@@ -12,7 +12,9 @@
 #include <mrpt/graphs/CNetworkOfPoses.h>
 #include <mrpt/utils/CTimeLogger.h>
 #include <mrpt/math/CSparseMatrix.h>
+#include <mrpt/utils/parallel.h>
 
+#include <algorithm>
 #include <memory>
 
 namespace mrpt
@@ -183,71 +185,72 @@ struct AuxErrorEval<CPose3DPDFGaussianInf, gst>
 
 // Compute, at once, jacobians and the error vectors for each constraint in
 // "lstObservationData", returns the overall squared error.
+// Jacobians and errors are stored in the same order than the observations.
+// The edges are split in "num_threads" ranges evaluated in parallel (0: one
+// per core).
 template <class GRAPH_T>
 double computeJacobiansAndErrors(
 	const GRAPH_T& graph,
 	const std::vector<typename graphslam_traits<GRAPH_T>::observation_info_t>&
 		lstObservationData,
-	typename graphslam_traits<GRAPH_T>::map_pairIDs_pairJacobs_t& lstJacobians,
+	typename graphslam_traits<GRAPH_T>::vector_pairJacobs_t& lstJacobians,
 	typename mrpt::aligned_containers<
-		typename graphslam_traits<GRAPH_T>::Array_O>::vector_t& errs)
+		typename graphslam_traits<GRAPH_T>::Array_O>::vector_t& errs,
+	const size_t num_threads = 1)
 {
 	MRPT_UNUSED_PARAM(graph);
 	typedef graphslam_traits<GRAPH_T> gst;
 
-	lstJacobians.clear();
-	errs.clear();
-
 	const size_t nObservations = lstObservationData.size();
-
-	for (size_t i = 0; i < nObservations; i++)
-	{
-		const typename gst::observation_info_t& obs = lstObservationData[i];
-		typename gst::edge_const_iterator it = obs.edge;
-		const typename gst::graph_t::constraint_t::type_value* EDGE_POSE =
-			obs.edge_mean;
-		typename gst::graph_t::constraint_t::type_value* P1 = obs.P1;
-		typename gst::graph_t::constraint_t::type_value* P2 = obs.P2;
-
-		const mrpt::utils::TPairNodeIDs& ids = it->first;
-		const typename gst::graph_t::edge_t& edge = it->second;
-
-		// Compute the residual pose error of these pair of nodes + its
-		// constraint,
-		//  that is: P1DP2inv = P1 * EDGE * inv(P2)
-		typename gst::graph_t::constraint_t::type_value P1DP2inv(
-			mrpt::poses::UNINITIALIZED_POSE);
-		{
-			typename gst::graph_t::constraint_t::type_value P1D(
-				mrpt::poses::UNINITIALIZED_POSE);
-			P1D.composeFrom(*P1, *EDGE_POSE);
-			const typename gst::graph_t::constraint_t::type_value P2inv =
-				-(*P2);  // Pose inverse (NOT just switching signs!)
-			P1DP2inv.composeFrom(P1D, P2inv);
-		}
-
-		// Add to vector of errors:
-		errs.resize(errs.size() + 1);
-		detail::AuxErrorEval<typename gst::edge_t, gst>::computePseudoLnError(
-			P1DP2inv, errs.back(), edge);
-
-		// Compute the jacobians:
-		MRPT_ALIGN16
-		std::pair<mrpt::utils::TPairNodeIDs, typename gst::TPairJacobs>
-			newMapEntry;
-		newMapEntry.first = ids;
-		gst::SE_TYPE::jacobian_dP1DP2inv_depsilon(
-			P1DP2inv, &newMapEntry.second.first, &newMapEntry.second.second);
-
-		// And insert into map of jacobians:
-		lstJacobians.insert(lstJacobians.end(), newMapEntry);
-	}
-
-	// return overall square error:  (Was:
-	// std::accumulate(...,mrpt::math::squareNorm_accum<>), but led to GCC
-	// errors when enabling parallelization)
+	lstJacobians.resize(nObservations);
+	errs.resize(nObservations);
+
+	// Partial squared errors of each thread, added up in a fixed order so
+	// the result is reproducible for a given number of threads (a different
+	// number of threads changes the summation order, hence the last bits):
+	const unsigned int n_threads = mrpt::utils::parallel_num_threads(
+		static_cast<unsigned int>(num_threads));
+	std::vector<double> thread_sqr_err(n_threads, 0.0);
+
+	mrpt::utils::parallel_for_ranges(
+		nObservations, n_threads,
+		[&](const size_t thread_idx, const size_t first, const size_t last) {
+			double sqr_err = 0;
+			for (size_t i = first; i < last; i++)
+			{
+				const typename gst::observation_info_t& obs =
+					lstObservationData[i];
+				const typename gst::graph_t::edge_t& edge = obs.edge->second;
+
+				// Compute the residual pose error of these pair of nodes + its
+				// constraint,
+				//  that is: P1DP2inv = P1 * EDGE * inv(P2)
+				typename gst::graph_t::constraint_t::type_value P1DP2inv(
+					mrpt::poses::UNINITIALIZED_POSE);
+				{
+					typename gst::graph_t::constraint_t::type_value P1D(
+						mrpt::poses::UNINITIALIZED_POSE);
+					P1D.composeFrom(*obs.P1, *obs.edge_mean);
+					const typename gst::graph_t::constraint_t::type_value
+						P2inv = -(*obs.P2);  // Pose inverse (NOT just
+					// switching signs!)
+					P1DP2inv.composeFrom(P1D, P2inv);
+				}
+
+				detail::AuxErrorEval<typename gst::edge_t, gst>::
+					computePseudoLnError(P1DP2inv, errs[i], edge);
+				sqr_err += errs[i].squaredNorm();
+
+				// Compute the jacobians:
+				gst::SE_TYPE::jacobian_dP1DP2inv_depsilon(
+					P1DP2inv, &lstJacobians[i].first, &lstJacobians[i].second);
+			}
+			thread_sqr_err[thread_idx] = sqr_err;
+		});
+
+	// return overall square error:
 	double ret_err = 0.0;
-	for (size_t i = 0; i < errs.size(); i++) ret_err += errs[i].squaredNorm();
+	for (const double e : thread_sqr_err) ret_err += e;
 	return ret_err;
 }
 
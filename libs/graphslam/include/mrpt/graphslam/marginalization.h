@@ -0,0 +1,378 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef GRAPH_SLAM_MARGINALIZATION_H
+#define GRAPH_SLAM_MARGINALIZATION_H
+
+#include <mrpt/graphslam/types.h>
+#include <mrpt/graphslam/levmarq_impl.h>
+#include <mrpt/utils/aligned_containers.h>
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphslam
+{
+/** \addtogroup mrpt_graphslam_grp
+  *  @{ */
+
+/** Dense prior factors which summarize the information that the edges of
+ * marginalized nodes had on the rest of the graph. See
+ * marginalize_graph_nodes() and optimize_graph_spa_levmarq().
+ *
+ * Each prior is a quadratic cost on the poses of its nodes:
+ * \f$ \frac{1}{2} d^\top H d + g^\top d \f$, with \f$ d \f$ the stacked
+ * pseudo-logarithms (see mrpt::poses::SE_traits::pseudo_ln) of the pose of
+ * each node composed with the inverse of its linearization pose, that is,
+ * the increments of the nodes since the prior was built.
+ *
+ * \tparam GRAPH_T Normally a
+ * mrpt::graphs::CNetworkOfPoses<EDGE_TYPE,MAPS_IMPLEMENTATION>
+ */
+template <class GRAPH_T>
+struct TMarginalPriors
+{
+	typedef typename GRAPH_T::constraint_t::type_value pose_t;
+
+	struct TPrior
+	{
+		/** The nodes of this prior, sorted */
+		std::vector<mrpt::utils::TNodeID> nodes;
+		/** The poses of `nodes` when the prior was built */
+		typename mrpt::aligned_containers<pose_t>::vector_t
+			linearization_poses;
+		/** Information matrix and gradient, by blocks in the order of
+		 * `nodes` */
+		Eigen::MatrixXd H;
+		Eigen::VectorXd g;
+	};
+
+	/** The list of prior factors */
+	std::vector<TPrior> priors;
+	/** Marginalized nodes that were kept in the graph (see
+	 * marginalize_graph_nodes()): their poses are not optimized any more. */
+	std::set<mrpt::utils::TNodeID> marginalized_nodes;
+	/** The edges accounted for by `priors` which were kept in the graph: for
+	 * each pair of nodes, the number of such edges between them, which are
+	 * the first ones with that pair in the multimap `GRAPH_T::edges` (new
+	 * edges are inserted after the existing ones). Edges inserted later on
+	 * are not, even if they involve marginalized nodes. */
+	std::map<mrpt::utils::TPairNodeIDs, size_t> marginalized_edges;
+
+	bool isMarginalized(const mrpt::utils::TNodeID id) const
+	{
+		return marginalized_nodes.find(id) != marginalized_nodes.end();
+	}
+	/** Whether the edge `it` of `graph` is accounted for by `priors` */
+	bool isMarginalizedEdge(
+		const GRAPH_T& graph,
+		const typename GRAPH_T::edges_map_t::const_iterator& it) const
+	{
+		const auto itM = marginalized_edges.find(it->first);
+		if (itM == marginalized_edges.end()) return false;
+		const typename GRAPH_T::edges_map_t::const_iterator first =
+			graph.edges.lower_bound(it->first);
+		return static_cast<size_t>(std::distance(first, it)) < itM->second;
+	}
+	bool empty() const
+	{
+		return priors.empty() && marginalized_nodes.empty();
+	}
+	void clear()
+	{
+		priors.clear();
+		marginalized_nodes.clear();
+		marginalized_edges.clear();
+	}
+};
+
+namespace detail
+{
+/** Evaluates a prior of mrpt::graphslam::TMarginalPriors at the current
+ * poses in `graph`: stores the stacked increments of its nodes in `delta`,
+ * and the gradient `H*delta+g` in `grad` (if not nullptr).
+ * \return The prior error, in the same units than the squared errors of the
+ * edges: `delta^t*H*delta + 2*g^t*delta` */
+template <class GRAPH_T>
+double evalMarginalPrior(
+	const GRAPH_T& graph,
+	const typename TMarginalPriors<GRAPH_T>::TPrior& prior,
+	Eigen::VectorXd& delta, Eigen::VectorXd* grad = nullptr)
+{
+	typedef graphslam_traits<GRAPH_T> gst;
+	static const unsigned int DIMS_POSE = gst::SE_TYPE::VECTOR_SIZE;
+
+	const size_t n = prior.nodes.size();
+	delta.resize(n * DIMS_POSE);
+	for (size_t i = 0; i < n; i++)
+	{
+		const auto itP = graph.nodes.find(prior.nodes[i]);
+		ASSERTMSG_(
+			itP != graph.nodes.end(),
+			"Node of a marginal prior does not have a global pose in "
+			"'graph.nodes'.")
+		typename TMarginalPriors<GRAPH_T>::pose_t incr(
+			mrpt::poses::UNINITIALIZED_POSE);
+		incr.composeFrom(itP->second, -prior.linearization_poses[i]);
+		typename gst::Array_O d;
+		gst::SE_TYPE::pseudo_ln(incr, d);
+		for (size_t k = 0; k < DIMS_POSE; k++)
+			delta[i * DIMS_POSE + k] = d[k];
+	}
+	const Eigen::VectorXd Hd = prior.H * delta;
+	if (grad) *grad = Hd + prior.g;
+	return delta.dot(Hd + 2 * prior.g);
+}
+}  // end NS detail
+
+/** Marginalizes out a set of nodes of a graph of pose constraints: the edges
+ * of these nodes (and the existing priors involving them) are
+ * linearized at the current node poses and replaced by one dense prior
+ * factor on the remaining nodes they were connected to (its Markov
+ * blanket), computed as the Schur complement of the marginalized nodes in
+ * the information matrix of those edges.
+ *
+ * The resulting priors are taken into account by
+ * optimize_graph_spa_levmarq(), so that only the latest nodes of a growing
+ * graph need to be optimized, without losing the information of the older
+ * ones.
+ *
+ * Marginalizing nodes at an optimum of the graph does not change that
+ * optimum for the remaining nodes, but the linearization is never
+ * revisited: later changes of the remaining nodes are only approximated
+ * to first order by the priors.
+ *
+ * \param[in,out] graph The graph. Marginalized nodes can not be the root,
+ * which may be in the blanket of a prior, as a fixed node.
+ * \param[in] nodes_to_marginalize The nodes to marginalize out.
+ * \param[in,out] marginal_priors The existing priors (updated with the new
+ * one).
+ * \param[in] remove_from_graph If true, the marginalized nodes and their
+ * edges are erased from `graph`. Otherwise, they are kept and recorded in
+ * TMarginalPriors::marginalized_nodes and
+ * TMarginalPriors::marginalized_edges: the poses of these nodes are fixed
+ * from now on, and their current edges are ignored by
+ * optimize_graph_spa_levmarq() and later marginalizations. The edges
+ * inserted later on between them and other nodes (e.g. loop closures) are
+ * still used, with the marginalized poses fixed. This is useful when other
+ * code refers to the node IDs of the graph, but note that the graph does
+ * not shrink then, and optimize_graph_spa_levmarq() still goes through all
+ * its nodes and edges on each call.
+ *
+ * \note Implementation can be found in file \a marginalization.h
+ * \sa TMarginalPriors, optimize_graph_spa_levmarq
+ */
+template <class GRAPH_T>
+void marginalize_graph_nodes(
+	GRAPH_T& graph,
+	const std::set<mrpt::utils::TNodeID>& nodes_to_marginalize,
+	TMarginalPriors<GRAPH_T>& marginal_priors,
+	const bool remove_from_graph = true)
+{
+	using namespace mrpt::utils;
+	typedef graphslam_traits<GRAPH_T> gst;
+	typedef typename TMarginalPriors<GRAPH_T>::TPrior prior_t;
+	static const unsigned int DIMS_POSE = gst::SE_TYPE::VECTOR_SIZE;
+
+	MRPT_START
+
+	if (nodes_to_marginalize.empty()) return;
+	ASSERTMSG_(
+		nodes_to_marginalize.find(graph.root) == nodes_to_marginalize.end(),
+		"The root node can not be marginalized.")
+	auto is_marginalized = [&nodes_to_marginalize](const TNodeID id) {
+		return nodes_to_marginalize.find(id) != nodes_to_marginalize.end();
+	};
+
+	// The edges of the nodes to marginalize, and the nodes in the blanket.
+	// Edges already summarized in the priors are skipped, but not the newer
+	// edges of previously marginalized nodes, which enter the blanket as
+	// fixed nodes.
+	std::vector<typename gst::observation_info_t> lstObservationData;
+	std::vector<typename GRAPH_T::edges_map_t::iterator> edges_to_erase;
+	std::set<TNodeID> blanket;
+	for (auto it = graph.edges.begin(); it != graph.edges.end(); ++it)
+	{
+		const TPairNodeIDs& ids = it->first;
+		const bool m1 = is_marginalized(ids.first);
+		const bool m2 = is_marginalized(ids.second);
+		if (!m1 && !m2) continue;
+		if (marginal_priors.isMarginalizedEdge(graph, it)) continue;
+
+		const auto itP1 = graph.nodes.find(ids.first);
+		const auto itP2 = graph.nodes.find(ids.second);
+		ASSERTMSG_(
+			itP1 != graph.nodes.end() && itP2 != graph.nodes.end(),
+			"Node in an edge does not have a global pose in 'graph.nodes'.")
+		if (!m1) blanket.insert(ids.first);
+		if (!m2) blanket.insert(ids.second);
+
+		typename gst::observation_info_t new_entry;
+		new_entry.edge = it;
+		new_entry.edge_mean = &it->second.getPoseMean();
+		new_entry.P1 = &itP1->second;
+		new_entry.P2 = &itP2->second;
+		lstObservationData.push_back(new_entry);
+		edges_to_erase.push_back(it);
+	}
+
+	// The existing priors of the nodes to marginalize are merged into the
+	// new one:
+	std::vector<prior_t> merged_priors;
+	for (size_t i = 0; i < marginal_priors.priors.size();)
+	{
+		prior_t& p = marginal_priors.priors[i];
+		if (std::none_of(p.nodes.begin(), p.nodes.end(), is_marginalized))
+		{
+			i++;
+			continue;
+		}
+		for (const TNodeID id : p.nodes)
+			if (!is_marginalized(id)) blanket.insert(id);
+		merged_priors.push_back(std::move(p));
+		if (i + 1 != marginal_priors.priors.size())
+			p = std::move(marginal_priors.priors.back());
+		marginal_priors.priors.pop_back();
+	}
+
+	// Linear system of all these factors around the current poses: the
+	// marginalized nodes first, then the blanket (sorted).
+	const size_t nM = nodes_to_marginalize.size(), nB = blanket.size();
+	std::map<TNodeID, size_t> var_index;
+	for (const TNodeID id : nodes_to_marginalize)
+		var_index.insert(std::make_pair(id, var_index.size()));
+	for (const TNodeID id : blanket)
+		var_index.insert(std::make_pair(id, var_index.size()));
+	const size_t N = (nM + nB) * DIMS_POSE;
+	Eigen::MatrixXd H = Eigen::MatrixXd::Zero(N, N);
+	Eigen::VectorXd g = Eigen::VectorXd::Zero(N);
+
+	typename gst::vector_pairJacobs_t lstJacobians;
+	typename mrpt::aligned_containers<typename gst::Array_O>::vector_t errs;
+	computeJacobiansAndErrors<GRAPH_T>(
+		graph, lstObservationData, lstJacobians, errs);
+	for (size_t k = 0; k < lstObservationData.size(); k++)
+	{
+		const auto& edge = lstObservationData[k].edge;
+		const size_t i1 = var_index[edge->first.first] * DIMS_POSE;
+		const size_t i2 = var_index[edge->first.second] * DIMS_POSE;
+		const typename gst::matrix_VxV_t& J1 = lstJacobians[k].first;
+		const typename gst::matrix_VxV_t& J2 = lstJacobians[k].second;
+
+		typename gst::matrix_VxV_t JtJ(mrpt::math::UNINITIALIZED_MATRIX);
+		typename gst::Array_O grad1, grad2;
+		grad1.fill(0);
+		grad2.fill(0);
+		detail::AuxErrorEval<typename gst::edge_t, gst>::multiply_Jt_W_err(
+			J1, edge, errs[k], grad1);
+		detail::AuxErrorEval<typename gst::edge_t, gst>::multiply_Jt_W_err(
+			J2, edge, errs[k], grad2);
+		for (unsigned int r = 0; r < DIMS_POSE; r++)
+		{
+			g[i1 + r] += grad1[r];
+			g[i2 + r] += grad2[r];
+		}
+		detail::AuxErrorEval<typename gst::edge_t, gst>::multiplyJtLambdaJ(
+			J1, JtJ, edge);
+		H.block<DIMS_POSE, DIMS_POSE>(i1, i1) += JtJ;
+		detail::AuxErrorEval<typename gst::edge_t, gst>::multiplyJtLambdaJ(
+			J2, JtJ, edge);
+		H.block<DIMS_POSE, DIMS_POSE>(i2, i2) += JtJ;
+		detail::AuxErrorEval<typename gst::edge_t, gst>::multiplyJ1tLambdaJ2(
+			J1, J2, JtJ, edge);
+		H.block<DIMS_POSE, DIMS_POSE>(i1, i2) += JtJ;
+		H.block<DIMS_POSE, DIMS_POSE>(i2, i1) += JtJ.transpose();
+	}
+	for (const prior_t& p : merged_priors)
+	{
+		// The prior, as a function of the increments from the current poses:
+		Eigen::VectorXd delta, grad;
+		detail::evalMarginalPrior(graph, p, delta, &grad);
+		const size_t n = p.nodes.size();
+		for (size_t a = 0; a < n; a++)
+		{
+			const size_t ia = var_index[p.nodes[a]] * DIMS_POSE;
+			g.segment<DIMS_POSE>(ia) += grad.segment<DIMS_POSE>(a * DIMS_POSE);
+			for (size_t b = 0; b < n; b++)
+				H.block<DIMS_POSE, DIMS_POSE>(
+					ia, var_index[p.nodes[b]] * DIMS_POSE) +=
+					p.H.template block<DIMS_POSE, DIMS_POSE>(
+						a * DIMS_POSE, b * DIMS_POSE);
+		}
+	}
+
+	// (A prior on fixed nodes alone would have no effect)
+	if (std::any_of(blanket.begin(), blanket.end(), [&](const TNodeID id) {
+			return id != graph.root && !marginal_priors.isMarginalized(id);
+		}))
+	{
+		// Schur complement of the marginalized nodes. Their information
+		// matrix may be singular (e.g. nodes only connected among them), so
+		// its pseudo-inverse is used:
+		const size_t nm = nM * DIMS_POSE, nb = nB * DIMS_POSE;
+		Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(
+			H.topLeftCorner(nm, nm));
+		const Eigen::VectorXd& ev = es.eigenvalues();
+		const double thres =
+			std::numeric_limits<double>::epsilon() * nm *
+			std::max(std::abs(ev[0]), std::abs(ev[ev.size() - 1]));
+		Eigen::VectorXd ev_inv(nm);
+		for (size_t i = 0; i < nm; i++)
+			ev_inv[i] = ev[i] > thres ? 1.0 / ev[i] : 0.0;
+		// H_BM * inv(H_MM) = (H_BM * V) * inv(D) * V^t
+		const Eigen::MatrixXd HbmV =
+			H.bottomLeftCorner(nb, nm) * es.eigenvectors();
+		const Eigen::MatrixXd HbmHmmInv =
+			(HbmV * ev_inv.asDiagonal()) * es.eigenvectors().transpose();
+
+		prior_t new_prior;
+		new_prior.nodes.assign(blanket.begin(), blanket.end());
+		for (const TNodeID id : blanket)
+			new_prior.linearization_poses.push_back(graph.nodes[id]);
+		new_prior.H = H.bottomRightCorner(nb, nb) -
+					  HbmHmmInv * H.topRightCorner(nm, nb);
+		// Force exact symmetry:
+		new_prior.H = 0.5 * (new_prior.H + new_prior.H.transpose()).eval();
+		new_prior.g = g.tail(nb) - HbmHmmInv * g.head(nm);
+		marginal_priors.priors.push_back(std::move(new_prior));
+	}
+
+	if (remove_from_graph)
+	{
+		for (auto& it : edges_to_erase)
+		{
+			marginal_priors.marginalized_edges.erase(it->first);
+			graph.edges.erase(it);
+		}
+		for (const TNodeID id : nodes_to_marginalize) graph.nodes.erase(id);
+	}
+	else
+	{
+		marginal_priors.marginalized_nodes.insert(
+			nodes_to_marginalize.begin(), nodes_to_marginalize.end());
+		// All the edges of each pair are folded now, so they stay the first
+		// ones of their pair:
+		for (const auto& it : edges_to_erase)
+			marginal_priors.marginalized_edges[it->first]++;
+	}
+
+	MRPT_END
+}
+
+/**  @} */  // end of grouping
+
+}  // End of namespace
+}  // End of namespace
+
+#endif
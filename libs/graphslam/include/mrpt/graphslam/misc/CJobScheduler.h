@@ -0,0 +1,99 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#ifndef CJOBSCHEDULER_H
+#define CJOBSCHEDULER_H
+
+#include <mrpt/graphslam/link_pragmas.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphslam
+{
+/**\brief Pool of worker threads that runs batches of independent jobs, e.g.
+ * the ICP alignments between a node and its candidate neighbors.
+ *
+ * ## Description
+ *
+ * Jobs are added with submit() and start as soon as a worker is idle. wait()
+ * blocks until all of them are done, and optionally lets the caller inspect
+ * each finished job (in the calling thread, in order of completion) and
+ * cancel the ones that have not started yet.
+ *
+ * With a single thread no workers are created, and jobs run in the thread
+ * that calls wait(), in order of submission.
+ *
+ * Jobs must not call methods of the scheduler. If any of them throws, the
+ * first exception is rethrown by wait() once all the others are done.
+ *
+ * \ingroup mrpt_graphslam_grp
+ */
+class GRAPHSLAM_IMPEXP CJobScheduler
+{
+   public:
+	typedef std::function<void()> job_t;
+	/**\brief Called for each finished job with its index within the batch.
+	 * Return false to cancel the pending jobs. */
+	typedef std::function<bool(size_t)> on_done_t;
+
+	/**\param[in] num_threads Number of worker threads. 0 means one per
+	 * hardware thread */
+	CJobScheduler(size_t num_threads = 0);
+	~CJobScheduler();
+	CJobScheduler(const CJobScheduler&) = delete;
+	CJobScheduler& operator=(const CJobScheduler&) = delete;
+
+	/**\brief Change the number of worker threads (0: one per hardware
+	 * thread). Must not be called while a batch is running. */
+	void setNumThreads(size_t num_threads);
+	size_t getNumThreads() const { return m_num_threads; }
+	/**\brief Add a job to the current batch.
+	 * \return Index of the job within the batch
+	 */
+	size_t submit(const job_t& job);
+	/**\brief Wait for all the jobs of the current batch, and start a new one.
+	 *
+	 * \param[in] on_done Optional callback for each finished job.
+	 * \return Number of jobs that were run (i.e. not cancelled)
+	 */
+	size_t wait(const on_done_t& on_done = on_done_t());
+
+   private:
+	void workerLoop();
+	void stopWorkers();
+
+	size_t m_num_threads;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	/**\brief Signals workers about new jobs, or about stopping */
+	std::condition_variable m_cv_jobs;
+	/**\brief Signals wait() about finished jobs */
+	std::condition_variable m_cv_done;
+	/**\brief Jobs not started yet, with their index in the batch */
+	std::deque<std::pair<size_t, job_t>> m_pending;
+	/**\brief Indices of finished jobs not yet reported by wait() */
+	std::deque<size_t> m_finished;
+	size_t m_batch_size;
+	size_t m_running;
+	bool m_stop;
+	std::exception_ptr m_error;
+};
+}
+}  // end of namespaces
+
+#endif /* end of include guard: CJOBSCHEDULER_H */
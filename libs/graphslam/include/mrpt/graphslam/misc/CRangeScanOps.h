@@ -23,6 +23,7 @@
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/system/os.h>
+#include <mrpt/graphslam/misc/CJobScheduler.h>
 
 #include <iostream>
 #include <vector>
@@ -73,6 +74,13 @@ namespace deciders
  *   Used for converting 3DRangeScan to 2DRangesScan so that they are
  *   visualized on the 2D surface
  *
+ * - \b num_threads
+ *   + \a Default value : 0
+ *   + \a Required      : FALSE
+ *   + \a Description   : Number of threads for running several ICP
+ *   alignments at once (see getICPEdges). 0 means one per hardware thread,
+ *   1 disables multithreading.
+ *
  * \note Class contains an instance of the mrpt::slam::CICP class and it parses
  * the configuration parameters of the latter from the
  * "ICP" section. Refer to
@@ -118,6 +126,49 @@ class CRangeScanOps
 		const mrpt::obs::CObservation3DRangeScan& to, constraint_t* rel_edge,
 		const mrpt::poses::CPose2D* initial_pose = nullptr,
 		mrpt::slam::CICP::TReturnInfo* icp_info = nullptr);
+	/**\brief Inputs and results of one of the ICP alignments run by
+	 * getICPEdges.
+	 *
+	 * \tparam SCAN_T mrpt::obs::CObservation2DRangeScan or
+	 * mrpt::obs::CObservation3DRangeScan
+	 */
+	template <class SCAN_T>
+	struct TICPEdgeJob
+	{
+		TICPEdgeJob()
+			: from_scan(nullptr),
+			  to_scan(nullptr),
+			  has_initial_pose(false),
+			  is_done(false)
+		{
+		}
+		/**\brief Scans to align. They must outlive the getICPEdges call */
+		const SCAN_T* from_scan;
+		const SCAN_T* to_scan;
+		/**\brief Initial guess of the alignment, if has_initial_pose */
+		mrpt::poses::CPose2D initial_pose;
+		bool has_initial_pose;
+
+		constraint_t rel_edge;
+		mrpt::slam::CICP::TReturnInfo icp_info;
+		/**\brief False if the alignment was cancelled */
+		bool is_done;
+	};
+	/**\brief Run getICPEdge for each one of the given jobs, in parallel (see
+	 * TParams::num_threads).
+	 *
+	 * \param[in] on_done Optional callback, called from this thread for
+	 * each finished job with its index in jobs, in order of completion.
+	 * Returning false cancels the alignments not started yet, e.g. when the
+	 * results so far are enough to make a decision.
+	 *
+	 * \return Number of jobs that were run
+	 */
+	template <class SCAN_T>
+	size_t getICPEdges(
+		std::vector<TICPEdgeJob<SCAN_T>>& jobs,
+		const mrpt::graphslam::CJobScheduler::on_done_t& on_done =
+			mrpt::graphslam::CJobScheduler::on_done_t());
 	/**\brief Reduce the size of the given CPointsMap by keeping one out of
 	 * "keep_point_every" points.
 	 *
@@ -156,10 +207,14 @@ class CRangeScanOps
 		 * range scan conversion.
 		 */
 		mrpt::obs::T3DPointsTo2DScanParams conversion_params;
+		/**\brief Threads for running ICP alignments in parallel */
+		int num_threads;
 
 		bool has_read_config;
 	};
 	TParams params;
+	/**\brief Worker threads of getICPEdges */
+	mrpt::graphslam::CJobScheduler m_icp_scheduler;
 };
 }
 }
@@ -26,7 +26,6 @@ void CRangeScanOps<GRAPH_T>::getICPEdge(
 	MRPT_START;
 
 	mrpt::maps::CSimplePointsMap m1, m2;
-	float running_time;
 	mrpt::slam::CICP::TReturnInfo info;
 
 	// have them initialized prior - and then just clear them
@@ -41,7 +40,7 @@ void CRangeScanOps<GRAPH_T>::getICPEdge(
 	}
 
 	mrpt::poses::CPosePDF::Ptr pdf =
-		params.icp.Align(&m1, &m2, initial_pose, &running_time, (void*)&info);
+		params.icp.Align(&m1, &m2, initial_pose, nullptr, (void*)&info);
 
 	// return the edge regardless of the goodness of the alignment
 	rel_edge->copyFrom(*pdf);
@@ -69,7 +68,6 @@ void CRangeScanOps<GRAPH_T>::getICPEdge(
 
 	// TODO - have this as a class member
 	mrpt::maps::CSimplePointsMap m1, m2;
-	float running_time;
 	mrpt::slam::CICP::TReturnInfo info;
 
 	m1.insertObservation(&from);
@@ -88,7 +86,7 @@ void CRangeScanOps<GRAPH_T>::getICPEdge(
 	}
 
 	mrpt::poses::CPose3DPDF::Ptr pdf =
-		params.icp.Align3D(&m1, &m2, initial_pose, &running_time, (void*)&info);
+		params.icp.Align3D(&m1, &m2, initial_pose, nullptr, (void*)&info);
 
 	// return the edge regardless of the goodness of the alignment
 	// copy from the 3D PDF
@@ -109,6 +107,33 @@ void CRangeScanOps<GRAPH_T>::getICPEdge(
 	MRPT_END;
 }
 
+template <class GRAPH_T>
+template <class SCAN_T>
+size_t CRangeScanOps<GRAPH_T>::getICPEdges(
+	std::vector<TICPEdgeJob<SCAN_T>>& jobs,
+	const mrpt::graphslam::CJobScheduler::on_done_t& on_done)
+{
+	MRPT_START;
+
+	m_icp_scheduler.setNumThreads(std::max(0, params.num_threads));
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		TICPEdgeJob<SCAN_T>* job = &jobs[i];
+		job->is_done = false;
+		ASSERT_(job->from_scan && job->to_scan);
+		m_icp_scheduler.submit([this, job]() {
+			this->getICPEdge(
+				*job->from_scan, *job->to_scan, &job->rel_edge,
+				job->has_initial_pose ? &job->initial_pose : nullptr,
+				&job->icp_info);
+			job->is_done = true;
+		});
+	}
+	return m_icp_scheduler.wait(on_done);
+
+	MRPT_END;
+}
+
 template <class GRAPH_T>
 void CRangeScanOps<GRAPH_T>::decimatePointsMap(
 	mrpt::maps::CPointsMap* m, size_t keep_point_every, /* = 4 */
@@ -176,7 +201,8 @@ bool CRangeScanOps<GRAPH_T>::convert3DTo2DRangeScan(
 // //////////////////////////////////
 
 template <class GRAPH_T>
-CRangeScanOps<GRAPH_T>::TParams::TParams() : has_read_config(false)
+CRangeScanOps<GRAPH_T>::TParams::TParams()
+	: num_threads(0), has_read_config(false)
 {
 }
 
@@ -206,6 +232,9 @@ void CRangeScanOps<GRAPH_T>::TParams::dumpToTextStream(
 	out.printf(
 		"3D=>2D LaserScan Conversion Z minimum          = %.2f\n",
 		conversion_params.z_min);
+	out.printf(
+		"ICP alignments threads                         = %d\n",
+		num_threads);
 
 	icp.options.dumpToTextStream(out);
 
@@ -227,6 +256,7 @@ void CRangeScanOps<GRAPH_T>::TParams::loadFromConfigFile(
 		section, "conversion_oversampling_ratio", 1.1, false);
 	conversion_params.z_min = source.read_double(
 		section, "conversion_z_min", 0, false);  // TODO - is this accurate?
+	num_threads = source.read_int(section, "num_threads", 0, false);
 
 	// load the icp parameters - from "ICP" section explicitly
 	icp.options.loadFromConfigFile(source, "ICP");
@@ -0,0 +1,158 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "graphslam-precomp.h"  // Precompiled headers
+
+#include <mrpt/graphslam/misc/CJobScheduler.h>
+#include <mrpt/utils/parallel.h>
+
+#include <algorithm>
+
+using namespace mrpt::graphslam;
+
+CJobScheduler::CJobScheduler(size_t num_threads /*= 0*/)
+	: m_num_threads(1), m_batch_size(0), m_running(0), m_stop(false)
+{
+	this->setNumThreads(num_threads);
+}
+
+CJobScheduler::~CJobScheduler() { this->stopWorkers(); }
+void CJobScheduler::setNumThreads(size_t num_threads)
+{
+	num_threads = mrpt::utils::parallel_num_threads(num_threads);
+	if (num_threads == m_num_threads) return;
+
+	// workers are started on demand, by submit()
+	this->stopWorkers();
+	m_num_threads = num_threads;
+}
+
+size_t CJobScheduler::submit(const job_t& job)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_num_threads > 1 && m_workers.empty())
+	{
+		m_stop = false;
+		for (size_t i = 0; i < m_num_threads; i++)
+		{
+			m_workers.push_back(std::thread(&CJobScheduler::workerLoop, this));
+		}
+	}
+	const size_t idx = m_batch_size++;
+	m_pending.push_back(std::make_pair(idx, job));
+	lock.unlock();
+	m_cv_jobs.notify_one();
+	return idx;
+}
+
+size_t CJobScheduler::wait(const on_done_t& on_done /*= on_done_t()*/)
+{
+	size_t nDone = 0;
+	bool cancelled = false;
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_workers.empty())
+	{
+		// sequential execution, in this thread
+		while (!m_pending.empty())
+		{
+			std::pair<size_t, job_t> job = m_pending.front();
+			m_pending.pop_front();
+			if (cancelled) continue;
+			lock.unlock();
+			try
+			{
+				job.second();
+			}
+			catch (...)
+			{
+				if (!m_error) m_error = std::current_exception();
+			}
+			nDone++;
+			if (on_done && !m_error && !on_done(job.first)) cancelled = true;
+			lock.lock();
+		}
+	}
+	else
+	{
+		while (m_running || !m_pending.empty() || !m_finished.empty())
+		{
+			m_cv_done.wait(lock, [this]() {
+				return !m_finished.empty() ||
+					   (!m_running && m_pending.empty());
+			});
+			while (!m_finished.empty())
+			{
+				const size_t idx = m_finished.front();
+				m_finished.pop_front();
+				nDone++;
+				if (!on_done || m_error || cancelled) continue;
+				lock.unlock();
+				const bool go_on = on_done(idx);
+				lock.lock();
+				if (!go_on)
+				{
+					cancelled = true;
+					m_pending.clear();
+				}
+			}
+			if (m_error) m_pending.clear();
+		}
+	}
+
+	m_batch_size = 0;
+	std::exception_ptr error;
+	std::swap(error, m_error);
+	lock.unlock();
+	if (error) std::rethrow_exception(error);
+	return nDone;
+}
+
+void CJobScheduler::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_cv_jobs.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+		if (m_stop) return;
+
+		std::pair<size_t, job_t> job = m_pending.front();
+		m_pending.pop_front();
+		m_running++;
+		lock.unlock();
+		std::exception_ptr error;
+		try
+		{
+			job.second();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		lock.lock();
+		if (error && !m_error) m_error = error;
+		m_running--;
+		m_finished.push_back(job.first);
+		m_cv_done.notify_one();
+	}
+}
+
+void CJobScheduler::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv_jobs.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
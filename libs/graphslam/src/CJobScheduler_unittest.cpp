@@ -0,0 +1,87 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphslam/misc/CJobScheduler.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using namespace mrpt::graphslam;
+
+static void run_batches(CJobScheduler& scheduler)
+{
+	const size_t N = 50;
+	std::vector<int> results(N, 0);
+	std::atomic<size_t> nRun(0);
+
+	// All the jobs run, and each one is reported once:
+	for (size_t i = 0; i < N; i++)
+	{
+		const size_t idx = scheduler.submit([&results, &nRun, i]() {
+			results[i] = static_cast<int>(i * i);
+			nRun++;
+		});
+		EXPECT_EQ(idx, i);
+	}
+	std::vector<int> reported(N, 0);
+	size_t nDone = scheduler.wait([&reported](size_t idx) {
+		reported[idx]++;
+		return true;
+	});
+	EXPECT_EQ(nDone, N);
+	EXPECT_EQ(nRun, N);
+	for (size_t i = 0; i < N; i++)
+	{
+		EXPECT_EQ(results[i], static_cast<int>(i * i));
+		EXPECT_EQ(reported[i], 1);
+	}
+
+	// Cancellation: the pending jobs are dropped
+	nRun = 0;
+	for (size_t i = 0; i < N; i++)
+	{
+		scheduler.submit([&nRun]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			nRun++;
+		});
+	}
+	size_t nReported = 0;
+	nDone = scheduler.wait([&nReported](size_t) {
+		return ++nReported < 5;
+	});
+	EXPECT_EQ(nDone, nRun);
+	EXPECT_GE(nDone, 5U);
+	EXPECT_LT(nDone, N);
+	EXPECT_EQ(nReported, 5U);
+
+	// Exceptions are passed to the caller, and the scheduler is still usable
+	scheduler.submit([]() { throw std::runtime_error("job error"); });
+	scheduler.submit([]() {});
+	EXPECT_THROW(scheduler.wait(), std::runtime_error);
+	const size_t idx = scheduler.submit([]() {});
+	EXPECT_EQ(idx, 0U);
+	EXPECT_EQ(scheduler.wait(), 1U);
+}
+
+TEST(CJobScheduler, SingleThread)
+{
+	CJobScheduler scheduler(1);
+	run_batches(scheduler);
+}
+
+TEST(CJobScheduler, MultipleThreads)
+{
+	CJobScheduler scheduler(4);
+	EXPECT_EQ(scheduler.getNumThreads(), 4U);
+	run_batches(scheduler);
+	scheduler.setNumThreads(2);
+	run_batches(scheduler);
+}
@@ -0,0 +1,110 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "graph_slam_levmarq_test_common.h"
+#include <mrpt/graphslam/CIncrementalSmoother.h>
+
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::random;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::graphs;
+using namespace mrpt::math;
+using namespace std;
+
+template <class my_graph_t>
+class GraphSlamIncrementalTester : public GraphSlamLevMarqTest<my_graph_t>,
+								   public ::testing::Test
+{
+   protected:
+	virtual void SetUp() {}
+	virtual void TearDown() {}
+	// Feeds the ring path to the smoother one node at a time, as a
+	// graph-slam engine would do, and compares the result with the batch
+	// Levenberg-Marquardt solution.
+	void test_ring_path_incremental()
+	{
+		my_graph_t full_graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(full_graph);
+
+		// Batch solution:
+		my_graph_t graph_batch = full_graph;
+		TParametersDouble params;
+		params["max_iterations"] = 1000;
+		graphslam::TResultInfoSpaLevMarq levmarq_info;
+		graphslam::optimize_graph_spa_levmarq(
+			graph_batch, levmarq_info, nullptr, params);
+
+		// Incremental solution:
+		my_graph_t graph;
+		graph.root = full_graph.root;
+		graphslam::CIncrementalSmoother<my_graph_t> smoother;
+		typename graphslam::CIncrementalSmoother<my_graph_t>::TUpdateInfo
+			info;
+
+		for (const auto& n : full_graph.nodes)
+		{
+			graph.nodes[n.first] = n.second;
+			for (const auto& e : full_graph.edges)
+				if (std::max(e.first.first, e.first.second) == n.first)
+					graph.insertEdge(e.first.first, e.first.second, e.second);
+
+			smoother.update(graph, &info);
+			EXPECT_FALSE(info.full_reset);
+			EXPECT_EQ(info.new_nodes, n.first == graph.root ? 0U : 1U);
+		}
+		EXPECT_EQ(graph.edges.size(), full_graph.edges.size());
+		EXPECT_EQ(smoother.getVariableCount(), graph.nodes.size() - 1);
+
+		// A few more updates let the relinearization converge:
+		for (int i = 0; i < 20; i++) smoother.update(graph, &info);
+		EXPECT_EQ(info.new_nodes, 0U);
+		EXPECT_EQ(info.new_edges, 0U);
+
+		EXPECT_LE(graph.getGlobalSquareError(), 1e-2);
+		for (const auto& n : graph_batch.nodes)
+			EXPECT_NEAR(
+				0, (n.second.getAsVectorVal() -
+					graph.nodes[n.first].getAsVectorVal())
+					   .array()
+					   .abs()
+					   .sum(),
+				1e-2);
+
+		// Removing an edge resets the smoother:
+		graph.edges.erase(graph.edges.begin());
+		smoother.update(graph, &info);
+		EXPECT_EQ(info.new_nodes, graph.nodes.size() - 1);
+		EXPECT_EQ(info.new_edges, graph.edges.size());
+	}
+};
+
+typedef GraphSlamIncrementalTester<CNetworkOfPoses2D>
+	GraphSlamIncrementalTester2D;
+typedef GraphSlamIncrementalTester<CNetworkOfPoses3D>
+	GraphSlamIncrementalTester3D;
+
+TEST_F(GraphSlamIncrementalTester2D, OptimizeSampleRingPath)
+{
+	for (int seed = 1; seed < 3; seed++)
+	{
+		randomGenerator.randomize(seed);
+		test_ring_path_incremental();
+	}
+}
+TEST_F(GraphSlamIncrementalTester3D, OptimizeSampleRingPath)
+{
+	for (int seed = 1; seed < 3; seed++)
+	{
+		randomGenerator.randomize(seed);
+		test_ring_path_incremental();
+	}
+}
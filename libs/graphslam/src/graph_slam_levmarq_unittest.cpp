@@ -48,11 +48,73 @@ class GraphSlamLevMarqTester : public GraphSlamLevMarqTest<my_graph_t>,
 			graph, levmarq_info, nullptr, params);
 
 		// Do some basic checks on the results:
-		EXPECT_GE(levmarq_info.num_iters, 10U);
-		EXPECT_LE(levmarq_info.final_total_sq_error, 1e-2);
+		// (edges are noise-free: the optimum has zero error, and Gauss-Newton
+		// steps with the exact Hessian converge in a few iterations)
+		EXPECT_GE(levmarq_info.num_iters, 2U);
+		EXPECT_LE(levmarq_info.final_total_sq_error, 1e-6);
 
 	}  // end test_ring_path
 
+	void test_multithreaded()
+	{
+		my_graph_t graph1;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph1);
+		my_graph_t graph4 = graph1;
+
+		TParametersDouble params;
+		params["max_iterations"] = 1000;
+		graphslam::TResultInfoSpaLevMarq info1, info4;
+
+		params["num_threads"] = 1;
+		graphslam::optimize_graph_spa_levmarq(graph1, info1, nullptr, params);
+		params["num_threads"] = 4;
+		graphslam::optimize_graph_spa_levmarq(graph4, info4, nullptr, params);
+
+		// Only the order of floating point additions may differ:
+		EXPECT_NEAR(
+			info1.final_total_sq_error, info4.final_total_sq_error, 1e-6);
+		ASSERT_EQ(graph1.nodes.size(), graph4.nodes.size());
+		for (const auto& n : graph1.nodes)
+			EXPECT_NEAR(
+				0, (n.second.getAsVectorVal() -
+					graph4.nodes[n.first].getAsVectorVal())
+					   .array()
+					   .abs()
+					   .sum(),
+				1e-4);
+	}
+
+	void test_more_threads_than_edges()
+	{
+		// A few nodes, with fewer edges than threads:
+		my_graph_t graph1;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph1, 4, 40);
+		ASSERT_LT(graph1.edges.size(), 16u);
+		my_graph_t graph16 = graph1;
+
+		TParametersDouble params;
+		params["max_iterations"] = 1000;
+		graphslam::TResultInfoSpaLevMarq info1, info16;
+
+		params["num_threads"] = 1;
+		graphslam::optimize_graph_spa_levmarq(graph1, info1, nullptr, params);
+		params["num_threads"] = 16;
+		graphslam::optimize_graph_spa_levmarq(
+			graph16, info16, nullptr, params);
+
+		EXPECT_LE(info16.final_total_sq_error, 1e-6);
+		EXPECT_NEAR(
+			info1.final_total_sq_error, info16.final_total_sq_error, 1e-6);
+		for (const auto& n : graph1.nodes)
+			EXPECT_NEAR(
+				0, (n.second.getAsVectorVal() -
+					graph16.nodes[n.first].getAsVectorVal())
+					   .array()
+					   .abs()
+					   .sum(),
+				1e-4);
+	}
+
 	void test_graph_bin_serialization()
 	{
 		my_graph_t graph;
@@ -99,6 +161,16 @@ TEST_F(GraphSlamLevMarqTester2D, OptimizeSampleRingPath)
 		test_ring_path();
 	}
 }
+TEST_F(GraphSlamLevMarqTester2D, OptimizeMultithreaded)
+{
+	randomGenerator.randomize(1);
+	test_multithreaded();
+}
+TEST_F(GraphSlamLevMarqTester2D, MoreThreadsThanEdges)
+{
+	randomGenerator.randomize(1);
+	test_more_threads_than_edges();
+}
 TEST_F(GraphSlamLevMarqTester2D, BinarySerialization)
 {
 	randomGenerator.randomize(123);
@@ -113,6 +185,16 @@ TEST_F(GraphSlamLevMarqTester3D, OptimizeSampleRingPath)
 		test_ring_path();
 	}
 }
+TEST_F(GraphSlamLevMarqTester3D, OptimizeMultithreaded)
+{
+	randomGenerator.randomize(1);
+	test_multithreaded();
+}
+TEST_F(GraphSlamLevMarqTester3D, MoreThreadsThanEdges)
+{
+	randomGenerator.randomize(1);
+	test_more_threads_than_edges();
+}
 TEST_F(GraphSlamLevMarqTester3D, BinarySerialization)
 {
 	randomGenerator.randomize(123);
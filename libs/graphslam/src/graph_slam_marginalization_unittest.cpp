@@ -0,0 +1,241 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "graph_slam_levmarq_test_common.h"
+#include <mrpt/graphslam/marginalization.h>
+
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::random;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::graphs;
+using namespace mrpt::math;
+using namespace std;
+
+template <class my_graph_t>
+class GraphSlamMarginalizationTester : public GraphSlamLevMarqTest<my_graph_t>,
+									   public ::testing::Test
+{
+   protected:
+	virtual void SetUp() {}
+	virtual void TearDown() {}
+	typedef graphslam::TMarginalPriors<my_graph_t> priors_t;
+
+	TParametersDouble params;
+
+	// The ring path, with noisy edges, at its optimum:
+	void create_optimized_graph(my_graph_t& graph)
+	{
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph);
+		for (auto& e : graph.edges)
+			e.second += typename my_graph_t::edge_t(
+				CPose3D(
+					randomGenerator.drawGaussian1D(0, 0.05),
+					randomGenerator.drawGaussian1D(0, 0.05),
+					randomGenerator.drawGaussian1D(0, 0.05),
+					randomGenerator.drawGaussian1D(0, DEG2RAD(1)),
+					randomGenerator.drawGaussian1D(0, DEG2RAD(1)),
+					randomGenerator.drawGaussian1D(0, DEG2RAD(1))));
+		params["max_iterations"] = 1000;
+		params["e1"] = 1e-12;
+		params["e2"] = 1e-12;
+		graphslam::TResultInfoSpaLevMarq info;
+		graphslam::optimize_graph_spa_levmarq(graph, info, nullptr, params);
+	}
+
+	static set<TNodeID> node_range(const TNodeID first, const TNodeID last)
+	{
+		set<TNodeID> s;
+		for (TNodeID i = first; i <= last; i++) s.insert(i);
+		return s;
+	}
+
+	static void perturb_nodes(my_graph_t& graph, const priors_t& priors)
+	{
+		for (auto& n : graph.nodes)
+			if (n.first != graph.root && !priors.isMarginalized(n.first))
+				n.second += typename my_graph_t::edge_t::type_value(
+					CPose3D(
+						randomGenerator.drawGaussian1D(0, 0.02),
+						randomGenerator.drawGaussian1D(0, 0.02),
+						randomGenerator.drawGaussian1D(0, 0.02),
+						randomGenerator.drawGaussian1D(0, DEG2RAD(0.5)),
+						randomGenerator.drawGaussian1D(0, DEG2RAD(0.5)),
+						randomGenerator.drawGaussian1D(0, DEG2RAD(0.5))));
+	}
+
+	static double max_pose_diff(
+		const typename my_graph_t::constraint_t::type_value& a,
+		const typename my_graph_t::constraint_t::type_value& b)
+	{
+		return (a.getAsVectorVal() - b.getAsVectorVal())
+			.array()
+			.abs()
+			.maxCoeff();
+	}
+
+	// Marginalizing nodes at the optimum keeps the optimum of the rest:
+	void test_marginalize_at_optimum(const bool remove_from_graph)
+	{
+		my_graph_t graph;
+		create_optimized_graph(graph);
+		const my_graph_t graph_opt = graph;
+
+		priors_t priors;
+		graphslam::marginalize_graph_nodes(
+			graph, node_range(1, 9), priors, remove_from_graph);
+		graphslam::marginalize_graph_nodes(
+			graph, node_range(10, 19), priors, remove_from_graph);
+		EXPECT_EQ(priors.priors.size(), 1U);
+		if (remove_from_graph)
+		{
+			EXPECT_EQ(graph.nodes.size(), graph_opt.nodes.size() - 19);
+			EXPECT_TRUE(priors.marginalized_nodes.empty());
+			for (const auto& e : graph.edges)
+			{
+				EXPECT_TRUE(graph.nodes.count(e.first.first));
+				EXPECT_TRUE(graph.nodes.count(e.first.second));
+			}
+		}
+		else
+		{
+			EXPECT_EQ(graph.nodes.size(), graph_opt.nodes.size());
+			EXPECT_EQ(graph.edges.size(), graph_opt.edges.size());
+			EXPECT_EQ(priors.marginalized_nodes, node_range(1, 19));
+		}
+
+		perturb_nodes(graph, priors);
+		graphslam::TResultInfoSpaLevMarq info;
+		graphslam::optimize_graph_spa_levmarq(
+			graph, info, nullptr, params, nullptr, &priors);
+
+		for (const auto& n : graph.nodes)
+			EXPECT_NEAR(
+				0, max_pose_diff(n.second, graph_opt.nodes.at(n.first)), 1e-5)
+				<< "node: " << n.first;
+	}
+
+	// Edges inserted after marginalizing a node kept in the graph are used,
+	// with the marginalized pose fixed:
+	void test_later_edges()
+	{
+		my_graph_t graph;
+		create_optimized_graph(graph);
+		const my_graph_t graph_opt = graph;
+
+		priors_t priors;
+		graphslam::marginalize_graph_nodes(
+			graph, node_range(1, 9), priors, false);
+		const size_t nFolded = priors.marginalized_edges.size();
+		EXPECT_GT(nFolded, 0U);
+		for (auto it = graph.edges.begin(); it != graph.edges.end(); ++it)
+			EXPECT_EQ(
+				priors.isMarginalizedEdge(graph, it),
+				priors.isMarginalized(it->first.first) ||
+					priors.isMarginalized(it->first.second));
+
+		// A "loop closure" to a marginalized node, which disagrees with the
+		// current poses:
+		const TNodeID old_id = 5, new_id = 40;
+		typename my_graph_t::constraint_t::type_value rel =
+			graph.nodes[new_id] - graph.nodes[old_id];
+		rel += typename my_graph_t::constraint_t::type_value(
+			CPose3D(0.5, 0, 0, 0, 0, 0));
+		graph.insertEdge(old_id, new_id, typename my_graph_t::edge_t(rel));
+		auto itNew = graph.edges.find(TPairNodeIDs(old_id, new_id));
+		ASSERT_TRUE(itNew != graph.edges.end());
+		EXPECT_FALSE(priors.isMarginalizedEdge(graph, itNew));
+
+		graphslam::TResultInfoSpaLevMarq info;
+		graphslam::optimize_graph_spa_levmarq(
+			graph, info, nullptr, params, nullptr, &priors);
+		EXPECT_EQ(
+			max_pose_diff(graph.nodes[old_id], graph_opt.nodes.at(old_id)),
+			0);
+		EXPECT_GT(
+			max_pose_diff(graph.nodes[new_id], graph_opt.nodes.at(new_id)),
+			0.05);
+
+		// Marginalizing other nodes does not fold it:
+		graphslam::marginalize_graph_nodes(
+			graph, node_range(10, 19), priors, false);
+		EXPECT_GT(priors.marginalized_edges.size(), nFolded);
+		itNew = graph.edges.find(TPairNodeIDs(old_id, new_id));
+		EXPECT_FALSE(priors.isMarginalizedEdge(graph, itNew));
+	}
+
+	// Marginalizing in several steps is the same than at once:
+	void test_chained_marginalization()
+	{
+		my_graph_t graph;
+		create_optimized_graph(graph);
+		perturb_nodes(graph, priors_t());  // Far from the optimum
+		my_graph_t graph2 = graph;
+
+		priors_t priors, priors2;
+		graphslam::marginalize_graph_nodes(graph, node_range(1, 5), priors);
+		graphslam::marginalize_graph_nodes(graph, node_range(6, 12), priors);
+		graphslam::marginalize_graph_nodes(graph, node_range(13, 19), priors);
+		graphslam::marginalize_graph_nodes(graph2, node_range(1, 19), priors2);
+
+		ASSERT_EQ(priors.priors.size(), 1U);
+		ASSERT_EQ(priors2.priors.size(), 1U);
+		const auto &p = priors.priors[0], &p2 = priors2.priors[0];
+		EXPECT_EQ(p.nodes, p2.nodes);
+		EXPECT_EQ(p.nodes.front(), graph.root);
+		const double scale = p2.H.array().abs().maxCoeff();
+		EXPECT_NEAR(0, (p.H - p2.H).array().abs().maxCoeff(), 1e-9 * scale);
+		EXPECT_NEAR(0, (p.g - p2.g).array().abs().maxCoeff(), 1e-9 * scale);
+		for (size_t i = 0; i < p.nodes.size(); i++)
+			EXPECT_EQ(
+				max_pose_diff(
+					p.linearization_poses[i], p2.linearization_poses[i]),
+				0);
+	}
+};
+
+typedef GraphSlamMarginalizationTester<CNetworkOfPoses2D>
+	GraphSlamMarginalizationTester2D;
+typedef GraphSlamMarginalizationTester<CNetworkOfPoses3D>
+	GraphSlamMarginalizationTester3D;
+
+TEST_F(GraphSlamMarginalizationTester2D, MarginalizeAtOptimum)
+{
+	randomGenerator.randomize(1);
+	test_marginalize_at_optimum(true);
+	test_marginalize_at_optimum(false);
+}
+TEST_F(GraphSlamMarginalizationTester3D, MarginalizeAtOptimum)
+{
+	randomGenerator.randomize(1);
+	test_marginalize_at_optimum(true);
+	test_marginalize_at_optimum(false);
+}
+TEST_F(GraphSlamMarginalizationTester2D, ChainedMarginalization)
+{
+	randomGenerator.randomize(2);
+	test_chained_marginalization();
+}
+TEST_F(GraphSlamMarginalizationTester3D, ChainedMarginalization)
+{
+	randomGenerator.randomize(2);
+	test_chained_marginalization();
+}
+TEST_F(GraphSlamMarginalizationTester2D, LaterEdgesOfMarginalizedNodes)
+{
+	randomGenerator.randomize(3);
+	test_later_edges();
+}
+TEST_F(GraphSlamMarginalizationTester3D, LaterEdgesOfMarginalizedNodes)
+{
+	randomGenerator.randomize(3);
+	test_later_edges();
+}
@@ -312,6 +312,11 @@ class CRandomFieldGridMap2D
 		/** (Default:false) Skip the computation of the variance, just compute
 		 * the mean */
 		bool GMRF_skip_variance;
+		/** (Default:SOLVER_SPARSE_QR) Sparse solver of the GMRF */
+		mrpt::graphs::ScalarFactorGraph::TSolverType GMRF_solver;
+		/** (Default:0) Number of threads to build the GMRF system (0: one per
+		 * hardware thread) */
+		size_t GMRF_num_threads;
 		/** @} */
 	};
 
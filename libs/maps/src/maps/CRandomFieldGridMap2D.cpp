@@ -60,6 +60,10 @@ CRandomFieldGridMap2D::CRandomFieldGridMap2D(
 	// We need all derived classes to call ::clear() in their constructors so we
 	// reach internal_clear()
 	//  and set there that variable...
+
+	// Evaluate our own factors without virtual calls:
+	m_gmrf.registerFactorType<TObservationGMRF>();
+	m_gmrf.registerFactorType<TPriorFactorGMRF>();
 }
 
 CRandomFieldGridMap2D::~CRandomFieldGridMap2D() {}
@@ -706,7 +710,9 @@ CRandomFieldGridMap2D::TInsertionOptionsCommon::TInsertionOptionsCommon()
 
 	  GMRF_saturate_min(-std::numeric_limits<double>::max()),
 	  GMRF_saturate_max(std::numeric_limits<double>::max()),
-	  GMRF_skip_variance(false)
+	  GMRF_skip_variance(false),
+	  GMRF_solver(mrpt::graphs::ScalarFactorGraph::SOLVER_SPARSE_QR),
+	  GMRF_num_threads(0)
 {
 }
 
@@ -760,6 +766,14 @@ void CRandomFieldGridMap2D::TInsertionOptionsCommon::
 	out.printf(
 		"GMRF_gridmap_image_cy                   = %u\n",
 		static_cast<unsigned int>(GMRF_gridmap_image_cy));
+	out.printf(
+		"GMRF_solver                             = %s\n",
+		mrpt::utils::TEnumType<mrpt::graphs::ScalarFactorGraph::TSolverType>::
+			value2name(GMRF_solver)
+				.c_str());
+	out.printf(
+		"GMRF_num_threads                        = %u\n",
+		static_cast<unsigned int>(GMRF_num_threads));
 }
 
 /*---------------------------------------------------------------
@@ -805,6 +819,9 @@ void CRandomFieldGridMap2D::TInsertionOptionsCommon::
 		iniFile.read_int(section.c_str(), "gridmap_image_cx", 0, false);
 	GMRF_gridmap_image_cy =
 		iniFile.read_int(section.c_str(), "gridmap_image_cy", 0, false);
+	GMRF_solver = iniFile.read_enum(section, "GMRF_solver", GMRF_solver);
+	GMRF_num_threads = iniFile.read_uint64_t(
+		section, "GMRF_num_threads", GMRF_num_threads);
 }
 
 /*---------------------------------------------------------------
@@ -2568,6 +2585,8 @@ void CRandomFieldGridMap2D::insertObservation_GMRF(
 void CRandomFieldGridMap2D::updateMapEstimation_GMRF()
 {
 	Eigen::VectorXd x_incr, x_var;
+	m_gmrf.solverOptions.solver = m_insertOptions_common->GMRF_solver;
+	m_gmrf.solverOptions.num_threads = m_insertOptions_common->GMRF_num_threads;
 	m_gmrf.updateEstimation(
 		x_incr, m_insertOptions_common->GMRF_skip_variance ? NULL : &x_var);
 
@@ -45,6 +45,10 @@ CRandomFieldGridMap3D::CRandomFieldGridMap3D(
 		  voxel_size /*z*/),
 	  COutputLogger("CRandomFieldGridMap3D")
 {
+	// Evaluate our own factors without virtual calls:
+	m_gmrf.registerFactorType<TObservationGMRF>();
+	m_gmrf.registerFactorType<TPriorFactorGMRF>();
+
 	if (call_initialize_now) this->internal_initialize();
 }
 
@@ -196,7 +200,9 @@ void CRandomFieldGridMap3D::internal_initialize(bool erase_prev_contents)
 CRandomFieldGridMap3D::TInsertionOptions::TInsertionOptions()
 	: GMRF_lambdaPrior(0.01f),  // [GMRF model] The information (Lambda) of
 	  // fixed map constraints
-	  GMRF_skip_variance(false)
+	  GMRF_skip_variance(false),
+	  GMRF_solver(mrpt::graphs::ScalarFactorGraph::SOLVER_SPARSE_QR),
+	  GMRF_num_threads(0)
 {
 }
 
@@ -207,6 +213,14 @@ void CRandomFieldGridMap3D::TInsertionOptions::dumpToTextStream(
 	out.printf(
 		"GMRF_skip_variance                   = %s\n",
 		GMRF_skip_variance ? "true" : "false");
+	out.printf(
+		"GMRF_solver                          = %s\n",
+		mrpt::utils::TEnumType<mrpt::graphs::ScalarFactorGraph::TSolverType>::
+			value2name(GMRF_solver)
+				.c_str());
+	out.printf(
+		"GMRF_num_threads                     = %u\n",
+		static_cast<unsigned int>(GMRF_num_threads));
 }
 
 void CRandomFieldGridMap3D::TInsertionOptions::loadFromConfigFile(
@@ -216,6 +230,9 @@ void CRandomFieldGridMap3D::TInsertionOptions::loadFromConfigFile(
 		section.c_str(), "GMRF_lambdaPrior", GMRF_lambdaPrior);
 	GMRF_skip_variance = iniFile.read_bool(
 		section.c_str(), "GMRF_skip_variance", GMRF_skip_variance);
+	GMRF_solver = iniFile.read_enum(section, "GMRF_solver", GMRF_solver);
+	GMRF_num_threads = iniFile.read_uint64_t(
+		section, "GMRF_num_threads", GMRF_num_threads);
 }
 
 /** Save the current estimated grid to a VTK file (.vts) as a "structured grid".
@@ -312,6 +329,8 @@ void CRandomFieldGridMap3D::updateMapEstimation()
 		"Cannot update a map with no observations!");
 
 	Eigen::VectorXd x_incr, x_var;
+	m_gmrf.solverOptions.solver = insertionOptions.GMRF_solver;
+	m_gmrf.solverOptions.num_threads = insertionOptions.GMRF_num_threads;
 	m_gmrf.updateEstimation(
 		x_incr, insertionOptions.GMRF_skip_variance ? NULL : &x_var);
 
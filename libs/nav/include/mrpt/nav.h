@@ -14,6 +14,7 @@
 #include <mrpt/nav/reactive/CNavigatorManualSequence.h>
 #include <mrpt/nav/reactive/CAbstractNavigator.h>
 #include <mrpt/nav/reactive/CRobot2NavInterfaceForSimulator.h>
+#include <mrpt/nav/reactive/CReactiveNavBatchSimulator.h>
 #include <mrpt/nav/reactive/CMultiObjectiveMotionOptimizerBase.h>
 #include <mrpt/nav/reactive/CMultiObjMotionOpt_Scalarization.h>
 
@@ -29,4 +30,5 @@
 #include <mrpt/nav/tpspace/CPTG_Holo_Blend.h>
 
 #include <mrpt/nav/planners/PlannerSimple2D.h>
+#include <mrpt/nav/planners/PlannerDStarLite2D.h>
 #include <mrpt/nav/planners/PlannerRRT_SE2_TPS.h>
@@ -0,0 +1,197 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/nav/link_pragmas.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/poses/CPose2D.h>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+namespace mrpt
+{
+namespace nav
+{
+/** \addtogroup nav_planners Path planning
+  * \ingroup mrpt_nav_grp
+  * @{ */
+
+/** Searches for collision-free paths in 2D occupancy grids for holonomic
+ * circular robots, with incremental replanning (D* Lite).
+ *
+ * Unlike PlannerSimple2D, this planner keeps its state between calls to
+ * computePath():
+ *  - The inflated cost map (obstacles enlarged by `robotRadius`) is kept as a
+ *    per-cell count of nearby obstacles. In each call, only cells whose
+ *    occupancy changed w.r.t. the previous call are re-inflated.
+ *  - The search (from the target backwards, on an 8-connected grid with an
+ *    octile heuristic) is kept alive while the target and the map geometry do
+ *    not change: a moving origin and changed cells only repair the affected
+ *    part of the search tree, as in D* Lite (S. Koenig, M. Likhachev, 2002).
+ *  - All per-cell buffers are preallocated and reused among calls.
+ *
+ * If `anyAnglePaths` is enabled, the grid path is shortened by keeping only
+ * those waypoints required to keep a line of sight in the inflated map
+ * (Theta*-like any-angle paths).
+ *
+ * Notice that this planner does not take into account robot kinematic
+ * constraints.
+ *
+ * \sa PlannerSimple2D
+ */
+class NAV_IMPEXP PlannerDStarLite2D
+{
+   public:
+	/** Default constructor */
+	PlannerDStarLite2D();
+	/** Destructor */
+	virtual ~PlannerDStarLite2D() {}
+	/** The maximum occupancy probability to consider a cell as an obstacle,
+	 * default=0.5  */
+	float occupancyThreshold;
+
+	/** The minimum distance between points in the returned found path
+	 * (default=0.4). Notice that full grid resolution is used in path
+	 * finding, this is only a way to reduce the amount of redundant
+	 * information to be returned.
+	 * Only used if anyAnglePaths=false: any-angle paths only keep the
+	 * corners needed for line of sight, and none of them can be dropped. */
+	float minStepInReturnedPath;
+
+	/** The aproximate robot radius used in the planification. Default is 0.35m
+	 */
+	float robotRadius;
+
+	/** Shorten returned paths with line-of-sight checks (default=true).
+	 * minStepInReturnedPath is ignored in this mode. */
+	bool anyAnglePaths;
+
+	/** Statistics of the last call to computePath() */
+	struct NAV_IMPEXP TStats
+	{
+		/** Whether the costmap and search were rebuilt from scratch */
+		bool full_replan;
+		/** Number of grid cells whose occupancy changed since the last call */
+		size_t changed_cells;
+		/** Number of cells expanded by the search */
+		size_t expanded_cells;
+		TStats() : full_replan(true), changed_cells(0), expanded_cells(0) {}
+	};
+
+	/** This method compute the optimal path for a circular robot, in the given
+	  *   occupancy grid map, from the origin location to a target point.
+	  * Successive calls with the same target reuse the previous search.
+	  *
+	  * \param theMap	[IN] The occupancy gridmap used to the planning.
+	  * \param origin	[IN] The starting pose of the robot, in coordinates of
+	  * "map".
+	  * \param target	[IN] The desired target pose for the robot, in
+	  * coordinates of "map".
+	  * \param path		[OUT] The found path, in global coordinates relative
+	  * to "map".
+	  * \param notFound	[OUT] Will be true if no path has been found.
+	  * \param maxSearchPathLength [IN] The maximum path length to search for,
+	  * in meters (-1 = no limit)
+	  *
+	  * \exception std::exception On any error
+	  */
+	void computePath(
+		const mrpt::maps::COccupancyGridMap2D& theMap,
+		const mrpt::poses::CPose2D& origin, const mrpt::poses::CPose2D& target,
+		std::deque<mrpt::math::TPoint2D>& path, bool& notFound,
+		float maxSearchPathLength = -1);
+
+	/** Forgets all cached costmap and search data, so the next call to
+	 * computePath() starts from scratch */
+	void resetCache();
+
+	/** Statistics of the last call to computePath() */
+	const TStats& getLastStats() const { return m_stats; }
+
+   protected:
+	/** Cached grid geometry and parameters the costmap was built for */
+	int m_size_x, m_size_y;
+	float m_x_min, m_y_min, m_resolution, m_cached_occ_threshold,
+		m_cached_radius;
+
+	/** 1 for obstacle cells in the last seen gridmap */
+	std::vector<uint8_t> m_occupied;
+	/** Number of obstacle cells within robot radius of each cell (>0 means
+	 * the cell is not traversable) */
+	std::vector<uint32_t> m_inflation;
+	/** Offsets (dx,dy) of the cells within robot radius */
+	std::vector<std::pair<int, int>> m_disc;
+	/** Cells whose traversability changed in the last costmap update */
+	std::vector<uint32_t> m_changed_cells;
+
+	/** D* Lite state: */
+	std::vector<float> m_g, m_rhs, m_open_k1, m_open_k2;
+	std::vector<uint8_t> m_in_open;
+	/** Cells data is only valid if m_stamp[i]==m_search_id, so starting a new
+	 * search does not require clearing the buffers */
+	std::vector<uint32_t> m_stamp;
+	uint32_t m_search_id;
+	struct TOpenEntry
+	{
+		float k1, k2;
+		uint32_t idx;
+		bool operator>(const TOpenEntry& o) const
+		{
+			return k1 > o.k1 || (k1 == o.k1 && k2 > o.k2);
+		}
+	};
+	/** Binary heap with lazy removal (stale entries are skipped) */
+	std::vector<TOpenEntry> m_open;
+	bool m_search_valid;
+	uint32_t m_goal_idx, m_start_idx, m_last_start_idx;
+	float m_km;
+
+	TStats m_stats;
+
+	/** Scratch buffer for path extraction */
+	std::vector<uint32_t> m_path_cells;
+
+	/** Brings the inflated costmap up to date with `theMap`. Returns false if
+	 * it had to be rebuilt from scratch. */
+	bool updateCostmap(const mrpt::maps::COccupancyGridMap2D& theMap);
+	void changeObstacleCount(const int cx, const int cy, const int incr);
+
+	inline bool isBlocked(const uint32_t idx) const
+	{
+		return m_inflation[idx] != 0 && idx != m_goal_idx;
+	}
+	inline void touch(const uint32_t idx)
+	{
+		if (m_stamp[idx] == m_search_id) return;
+		m_stamp[idx] = m_search_id;
+		m_g[idx] = m_rhs[idx] = std::numeric_limits<float>::infinity();
+		m_in_open[idx] = 0;
+	}
+	inline float gValue(const uint32_t idx) const
+	{
+		return m_stamp[idx] == m_search_id
+				   ? m_g[idx]
+				   : std::numeric_limits<float>::infinity();
+	}
+	float heuristic(const uint32_t a, const uint32_t b) const;
+	void calcKey(const uint32_t idx, float& k1, float& k2) const;
+	void updateOpen(const uint32_t idx);
+	void updateVertex(const uint32_t idx);
+	/** Recomputes rhs(idx) from its neighbors */
+	void updateRHS(const uint32_t idx);
+	bool topKey(float& k1, float& k2);
+	void computeShortestPath();
+	bool lineOfSight(const uint32_t a, const uint32_t b) const;
+};
+
+/** @} */
+}  // End of namespace
+}  // End of namespace
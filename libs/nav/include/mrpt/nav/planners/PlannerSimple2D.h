@@ -30,6 +30,8 @@ namespace nav
  *
  * Notice that this simple planner does not take into account robot kinematic
  * constraints.
+ *
+ * \sa PlannerDStarLite2D, for repeated replanning on large or changing maps.
  */
 class NAV_IMPEXP PlannerSimple2D
 {
@@ -17,6 +17,12 @@
 #include <mrpt/nav/tpspace/CParameterizedTrajectoryGenerator.h>
 #include <mrpt/nav/link_pragmas.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 namespace mrpt
 {
 namespace nav
@@ -70,7 +76,12 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 			  edge_to_parent(edge_to_parent_)
 		{
 		}
-		node_t() {}
+		node_t()
+			: node_id(INVALID_NODEID),
+			  parent_id(INVALID_NODEID),
+			  edge_to_parent(NULL)
+		{
+		}
 	};
 
 	typedef mrpt::graphs::CDirectedTree<EDGE_TYPE> base_t;
@@ -82,7 +93,19 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	/** A topological path up-tree */
 	typedef std::list<node_t> path_t;
 
-	/** Finds the nearest node to a given pose, using the given metric */
+	TMoveTree()
+		: m_index_cell_size(1.0),
+		  m_index_min_cx(0),
+		  m_index_max_cx(0),
+		  m_index_min_cy(0),
+		  m_index_max_cy(0)
+	{
+	}
+
+	/** Finds the nearest node to a given pose, using the given metric.
+	 * Nodes are looked up in the (x,y) bucket index, visiting rings of cells
+	 * around the query until no farther cell can contain a nearer node.
+	 * \sa getKNearestNodes, getNodesWithinRadius */
 	template <class NODE_TYPE_FOR_METRIC>
 	mrpt::utils::TNodeID getNearestNode(
 		const NODE_TYPE_FOR_METRIC& query_pt,
@@ -92,28 +115,51 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	{
 		ASSERT_(!m_nodes.empty())
 
-		double min_d = std::numeric_limits<double>::max();
-		mrpt::utils::TNodeID min_id = INVALID_NODEID;
-		for (typename node_map_t::const_iterator it = m_nodes.begin();
-			 it != m_nodes.end(); ++it)
-		{
-			if (ignored_nodes &&
-				ignored_nodes->find(it->first) != ignored_nodes->end())
-				continue;  // ignore it
-			const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
-			const NODE_TYPE_FOR_METRIC ptFrom(it->second.state);
-			if (distanceMetricEvaluator.cannotBeNearerThan(ptFrom, ptTo, min_d))
-				continue;  // Skip the more expensive calculation of exact
-			// distance
-			double d = distanceMetricEvaluator.distance(ptFrom, ptTo);
-			if (d < min_d)
-			{
-				min_d = d;
-				min_id = it->first;
-			}
-		}
-		if (out_distance) *out_distance = min_d;
-		return min_id;
+		std::vector<std::pair<double, mrpt::utils::TNodeID>> found;
+		internal_kNearest(
+			query_pt, distanceMetricEvaluator, 1, ignored_nodes, found);
+
+		if (out_distance)
+			*out_distance = found.empty() ? std::numeric_limits<double>::max()
+										  : found[0].first;
+		return found.empty() ? INVALID_NODEID : found[0].second;
+	}
+
+	/** Finds the (up to) `k` nearest nodes to a given pose, using the given
+	 * metric. Results are sorted by ascending distance. Nodes at an infinite
+	 * (unreachable) distance are never returned. */
+	template <class NODE_TYPE_FOR_METRIC>
+	void getKNearestNodes(
+		const NODE_TYPE_FOR_METRIC& query_pt,
+		const PoseDistanceMetric<NODE_TYPE_FOR_METRIC>& distanceMetricEvaluator,
+		const size_t k,
+		std::vector<std::pair<double, mrpt::utils::TNodeID>>& out_nodes,
+		const std::set<mrpt::utils::TNodeID>* ignored_nodes = NULL) const
+	{
+		internal_kNearest(
+			query_pt, distanceMetricEvaluator, k, ignored_nodes, out_nodes);
+	}
+
+	/** Finds all nodes whose distance to a given pose (using the given metric)
+	 * is `<=max_distance`, e.g. for RRT*-like rewiring. Results are sorted by
+	 * ascending distance. */
+	template <class NODE_TYPE_FOR_METRIC>
+	void getNodesWithinRadius(
+		const NODE_TYPE_FOR_METRIC& query_pt,
+		const PoseDistanceMetric<NODE_TYPE_FOR_METRIC>& distanceMetricEvaluator,
+		const double max_distance,
+		std::vector<std::pair<double, mrpt::utils::TNodeID>>& out_nodes,
+		const std::set<mrpt::utils::TNodeID>* ignored_nodes = NULL) const
+	{
+		out_nodes.clear();
+		internal_visitNodesByProximity(
+			query_pt, distanceMetricEvaluator, ignored_nodes,
+			[&](const double d, const mrpt::utils::TNodeID id) {
+				if (d <= max_distance) out_nodes.emplace_back(d, id);
+				return max_distance;
+			},
+			max_distance);
+		std::sort(out_nodes.begin(), out_nodes.end());
 	}
 
 	void insertNodeAndEdge(
@@ -130,9 +176,11 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 				new_child_id, false /*direction_child_to_parent*/,
 				new_edge_data));
 		// node:
+		internal_unindexNode(new_child_id);
 		m_nodes[new_child_id] = node_t(
 			new_child_id, parent_id, &edges_of_parent.back().data,
 			new_child_node_data);
+		internal_indexNode(new_child_id);
 	}
 
 	/** Insert a node without edges (should be used only for a tree root node)
@@ -140,9 +188,25 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	void insertNode(
 		const mrpt::utils::TNodeID node_id, const NODE_TYPE_DATA& node_data)
 	{
+		internal_unindexNode(node_id);
 		m_nodes[node_id] = node_t(node_id, INVALID_NODEID, NULL, node_data);
+		internal_indexNode(node_id);
 	}
 
+	/** Changes the size (in meters, default=1.0) of the (x,y) cells used to
+	 * index nodes for nearest-neighbor queries, rebuilding the index. Best
+	 * performance is attained for sizes in the order of the typical distance
+	 * between a node and its nearest neighbor. */
+	void setNodeIndexCellSize(const double cell_size)
+	{
+		ASSERT_ABOVE_(cell_size, 0.0);
+		m_index_cell_size = cell_size;
+		m_index.clear();
+		for (typename node_map_t::const_iterator it = m_nodes.begin();
+			 it != m_nodes.end(); ++it)
+			if (it->second.node_id == it->first) internal_indexNode(it->first);
+	}
+	double getNodeIndexCellSize() const { return m_index_cell_size; }
 	mrpt::utils::TNodeID getNextFreeNodeID() const { return m_nodes.size(); }
 	const node_map_t& getAllNodes() const { return m_nodes; }
 	/** Builds the path (sequence of nodes, with info about next edge) up-tree
@@ -184,6 +248,154 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	/** Info per node */
 	node_map_t m_nodes;
 
+	/** Spatial index of nodes: (x,y) bucket => IDs of nodes in it. Heading is
+	 * not indexed: angle wrapping is left to the metric being queried. */
+	typedef std::unordered_map<uint64_t, std::vector<mrpt::utils::TNodeID>>
+		node_index_t;
+	node_index_t m_index;
+	double m_index_cell_size;
+	/** Bounding box of occupied cells in m_index (only valid if not empty) */
+	int32_t m_index_min_cx, m_index_max_cx, m_index_min_cy, m_index_max_cy;
+
+	inline int32_t internal_coordToCell(const double c) const
+	{
+		return static_cast<int32_t>(std::floor(c / m_index_cell_size));
+	}
+	static inline uint64_t internal_cellKey(const int32_t cx, const int32_t cy)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+			   static_cast<uint32_t>(cy);
+	}
+
+	void internal_indexNode(const mrpt::utils::TNodeID id)
+	{
+		const node_t& n = m_nodes.find(id)->second;
+		const int32_t cx = internal_coordToCell(n.state.x),
+					  cy = internal_coordToCell(n.state.y);
+		if (m_index.empty())
+		{
+			m_index_min_cx = m_index_max_cx = cx;
+			m_index_min_cy = m_index_max_cy = cy;
+		}
+		else
+		{
+			mrpt::utils::keep_min(m_index_min_cx, cx);
+			mrpt::utils::keep_max(m_index_max_cx, cx);
+			mrpt::utils::keep_min(m_index_min_cy, cy);
+			mrpt::utils::keep_max(m_index_max_cy, cy);
+		}
+		m_index[internal_cellKey(cx, cy)].push_back(id);
+	}
+
+	/** Removes a node from the index, if it exists (for overwritten IDs) */
+	void internal_unindexNode(const mrpt::utils::TNodeID id)
+	{
+		typename node_map_t::const_iterator it = m_nodes.find(id);
+		if (it == m_nodes.end() || it->second.node_id != id) return;
+		typename node_index_t::iterator itCell = m_index.find(
+			internal_cellKey(
+				internal_coordToCell(it->second.state.x),
+				internal_coordToCell(it->second.state.y)));
+		if (itCell == m_index.end()) return;
+		std::vector<mrpt::utils::TNodeID>& ids = itCell->second;
+		ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+	}
+
+	template <class NODE_TYPE_FOR_METRIC>
+	void internal_kNearest(
+		const NODE_TYPE_FOR_METRIC& query_pt,
+		const PoseDistanceMetric<NODE_TYPE_FOR_METRIC>& metric, const size_t k,
+		const std::set<mrpt::utils::TNodeID>* ignored_nodes,
+		std::vector<std::pair<double, mrpt::utils::TNodeID>>& found) const
+	{
+		found.clear();
+		if (!k) return;
+		found.reserve(k + 1);
+		internal_visitNodesByProximity(
+			query_pt, metric, ignored_nodes,
+			[&](const double d, const mrpt::utils::TNodeID id) {
+				if (d < std::numeric_limits<double>::max() &&
+					(found.size() < k || d < found.back().first))
+				{
+					// Sorted insertion:
+					const std::pair<double, mrpt::utils::TNodeID> e(d, id);
+					found.insert(
+						std::upper_bound(found.begin(), found.end(), e), e);
+					if (found.size() > k) found.pop_back();
+				}
+				return found.size() < k ? std::numeric_limits<double>::max()
+										: found.back().first;
+			},
+			std::numeric_limits<double>::max());
+	}
+
+	/** Visits nodes cell-ring by cell-ring around the query, invoking
+	 * `visitor(distance,id)` for those not discarded by the metric. The
+	 * visitor returns the current maximum distance of interest, used to prune
+	 * nodes and to stop the search once no remaining ring can be nearer. */
+	template <class NODE_TYPE_FOR_METRIC, class VISITOR>
+	void internal_visitNodesByProximity(
+		const NODE_TYPE_FOR_METRIC& query_pt,
+		const PoseDistanceMetric<NODE_TYPE_FOR_METRIC>& metric,
+		const std::set<mrpt::utils::TNodeID>* ignored_nodes, VISITOR visitor,
+		double max_d) const
+	{
+		if (m_index.empty()) return;
+		const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
+		const int32_t cx = internal_coordToCell(query_pt.state.x),
+					  cy = internal_coordToCell(query_pt.state.y);
+		// Beyond this ring, there are no more occupied cells:
+		const int32_t max_ring = std::max(
+			std::max(cx - m_index_min_cx, m_index_max_cx - cx),
+			std::max(cy - m_index_min_cy, m_index_max_cy - cy));
+
+		auto visit_cell = [&](const int32_t ix, const int32_t iy) {
+			if (ix < m_index_min_cx || ix > m_index_max_cx ||
+				iy < m_index_min_cy || iy > m_index_max_cy)
+				return;
+			typename node_index_t::const_iterator itCell =
+				m_index.find(internal_cellKey(ix, iy));
+			if (itCell == m_index.end()) return;
+			for (const mrpt::utils::TNodeID id : itCell->second)
+			{
+				if (ignored_nodes &&
+					ignored_nodes->find(id) != ignored_nodes->end())
+					continue;  // ignore it
+				const NODE_TYPE_FOR_METRIC ptFrom(
+					m_nodes.find(id)->second.state);
+				if (max_d < std::numeric_limits<double>::max() &&
+					metric.cannotBeNearerThan(ptFrom, ptTo, max_d))
+					continue;  // Skip the more expensive calculation of exact
+				// distance
+				max_d = visitor(metric.distance(ptFrom, ptTo), id);
+			}
+		};
+
+		for (int32_t r = 0; r <= max_ring; r++)
+		{
+			// Nodes in ring "r" are, at least, (r-1) cells away in x or y:
+			if (r > 0 &&
+				metric.minDistanceForXYSeparation((r - 1) * m_index_cell_size) >
+					max_d)
+				break;
+			if (r == 0)
+			{
+				visit_cell(cx, cy);
+				continue;
+			}
+			for (int32_t i = -r; i <= r; i++)
+			{
+				visit_cell(cx + i, cy - r);
+				visit_cell(cx + i, cy + r);
+			}
+			for (int32_t i = -r + 1; i <= r - 1; i++)
+			{
+				visit_cell(cx - r, cy + i);
+				visit_cell(cx + r, cy + i);
+			}
+		}
+	}
+
 };  // end TMoveTree
 
 /** An edge for the move tree used for planning in SE2 and TP-space */
@@ -233,10 +445,17 @@ struct PoseDistanceMetric<TNodeSE2>
 	bool cannotBeNearerThan(
 		const TNodeSE2& a, const TNodeSE2& b, const double d) const
 	{
-		if (std::abs(a.state.x - b.state.x) > d) return true;
-		if (std::abs(a.state.y - b.state.y) > d) return true;
+		// distance() is squared:
+		if (mrpt::math::square(a.state.x - b.state.x) > d) return true;
+		if (mrpt::math::square(a.state.y - b.state.y) > d) return true;
 		return false;
 	}
+	/** Lower bound of distance() for two poses whose x or y coordinates differ
+	 * by at least `xy_sep` */
+	double minDistanceForXYSeparation(const double xy_sep) const
+	{
+		return mrpt::math::square(xy_sep);
+	}
 
 	double distance(const TNodeSE2& a, const TNodeSE2& b) const
 	{
@@ -268,6 +487,13 @@ struct PoseDistanceMetric<TNodeSE2_TP>
 		if (std::abs(a.state.y - b.state.y) > d) return true;
 		return false;
 	}
+	/** Lower bound of distance() for two poses whose x or y coordinates differ
+	 * by at least `xy_sep`: paths along PTGs are never shorter than the
+	 * straight line */
+	double minDistanceForXYSeparation(const double xy_sep) const
+	{
+		return xy_sep;
+	}
 	double distance(const TNodeSE2_TP& src, const TNodeSE2_TP& dst) const
 	{
 		double d;
@@ -22,6 +22,10 @@
 #include <mrpt/math/CPolygon.h>
 #include <mrpt/maps/CPointCloudFilterBase.h>
 #include <memory>  // unique_ptr
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace mrpt
 {
@@ -160,7 +164,11 @@ class NAV_IMPEXP CAbstractPTGBasedReactive : public CWaypointsNavigator
 		m_enableKeepLogRecords = enable;
 	}
 
-	/** Enables/disables saving log files. */
+	/** Enables/disables saving log files.
+	 * Records are serialized and written to disk by a background thread, so
+	 * the navigation step only pays for a copy of the record. The robot shape
+	 * and PTG descriptions are only stored when they change (see
+	 * CLogFileRecord::static_fields_omitted). */
 	void enableLogFile(bool enable);
 
 	/** Changes the prefix for new log files. */
@@ -295,6 +303,23 @@ class NAV_IMPEXP CAbstractPTGBasedReactive : public CWaypointsNavigator
 	bool m_enableKeepLogRecords;
 	/** The last log */
 	CLogFileRecord lastLogRecord;
+
+	/** @name Asynchronous writing of log files
+		@{ */
+	/** Records pending to be written to m_logFile by m_logfile_thread */
+	std::deque<CLogFileRecord::Ptr> m_logfile_queue;
+	std::mutex m_logfile_queue_mtx;
+	std::condition_variable m_logfile_queue_cv;
+	std::thread m_logfile_thread;
+	bool m_logfile_thread_quit;
+	/** Last record written with all its static fields (for delta-encoding) */
+	CLogFileRecord::Ptr m_logfile_last_full_record;
+	/** Thread main function: writes records from m_logfile_queue */
+	void thread_logfile_writer();
+	/** Writes out all pending records and joins the writer thread */
+	void stopLogFileWriterThread();
+	/** @} */
+
 	/** Last velocity commands */
 	mrpt::kinematics::CVehicleVelCmd::Ptr m_last_vel_cmd;
 
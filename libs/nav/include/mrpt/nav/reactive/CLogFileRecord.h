@@ -130,6 +130,24 @@ class NAV_IMPEXP CLogFileRecord : public mrpt::utils::CSerializable
 		rel_pose_PTG_origin_wrt_sense_NOP;
 	mrpt::nav::CParameterizedTrajectoryGenerator::TNavDynamicState
 		ptg_last_navDynState;
+
+	/** @name Delta-encoding of log files
+		@{ */
+	/** If true, the robot shape and the PTG descriptions were not saved with
+	 * this record since they were identical to those of a previous record in
+	 * the same log file. After loading, call restoreStaticFieldsFrom() with
+	 * the previous record to recover them. */
+	bool static_fields_omitted;
+
+	/** Returns true if the robot shape and PTG descriptions are identical */
+	bool hasSameStaticFieldsAs(const CLogFileRecord& o) const;
+	/** Empties the robot shape and PTG descriptions, setting
+	 * `static_fields_omitted=true` */
+	void omitStaticFields();
+	/** If `static_fields_omitted` is set, copies the robot shape and PTG
+	 * descriptions from the (previous) record `prev` */
+	void restoreStaticFieldsFrom(const CLogFileRecord& prev);
+	/** @} */
 };
 DEFINE_SERIALIZABLE_POST_CUSTOM_BASE_LINKAGE(
 	CLogFileRecord, mrpt::utils::CSerializable, NAV_IMPEXP)
@@ -0,0 +1,187 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/nav/link_pragmas.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/math/lightweight_geom_data.h>
+#include <mrpt/utils/COutputLogger.h>
+#include <string>
+#include <vector>
+
+namespace mrpt
+{
+namespace nav
+{
+/** Headless batch simulator for benchmarking reactive navigators.
+ *
+ * Each scenario (see TScenario) defines an independent simulated robot: its
+ * own navigator (CReactiveNavigationSystem or CReactiveNavigationSystem3D,
+ * loaded from an .ini configuration text), its own occupancy grid map, used
+ * both as the world and to simulate a 2D laser scanner, the kinematic model
+ * of the vehicle, and the start and target poses.
+ *
+ * Scenarios are run in parallel in a pool of worker threads, each of them
+ * stepping its simulator as fast as possible (simulated time is decoupled
+ * from wall-clock time), so a whole batch typically runs much faster than
+ * real time.
+ *
+ * For each scenario, a TResult is returned with the success/failure reason
+ * and the wall-clock latency of every call to navigationStep(). Use
+ * computeStatistics() to obtain latency percentiles and success rates, e.g.
+ * to detect performance regressions in continuous integration tests.
+ *
+ * Usage:
+ * \code
+ * mrpt::nav::CReactiveNavBatchSimulator sim;
+ * mrpt::nav::CReactiveNavBatchSimulator::TScenario s;
+ * s.map = my_grid_ptr;
+ * s.nav_config_text = mrpt::system::loadTextFile("reactive2d_config.ini");
+ * s.target = mrpt::math::TPose2D(5.0, 2.0, 0);
+ * sim.scenarios.push_back(s);
+ *
+ * std::vector<mrpt::nav::CReactiveNavBatchSimulator::TResult> results;
+ * sim.run(results);
+ * const auto stats =
+ *   mrpt::nav::CReactiveNavBatchSimulator::computeStatistics(results);
+ * \endcode
+ *
+ * \sa CRobot2NavInterfaceForSimulator_DiffDriven,
+ * CRobot2NavInterfaceForSimulator_Holo, app `reactive-nav-benchmark`
+ * \ingroup nav_reactive
+ */
+class NAV_IMPEXP CReactiveNavBatchSimulator : public mrpt::utils::COutputLogger
+{
+   public:
+	CReactiveNavBatchSimulator();
+
+	/** Kinematic model of the simulated vehicles */
+	enum TKinematics
+	{
+		kinDiffDriven = 0,
+		kinHolonomic
+	};
+
+	/** One simulated robot, with its own navigator, map and mission */
+	struct NAV_IMPEXP TScenario
+	{
+		TScenario();
+
+		/** A name to identify the scenario in results */
+		std::string name;
+		/** The world. It is only read during simulation, so one map can be
+		 * shared among several scenarios. */
+		mrpt::maps::COccupancyGridMap2D::Ptr map;
+		/** Contents of the navigator .ini config file (see
+		 * CReactiveNavigationSystem) */
+		std::string nav_config_text;
+		/** "CReactiveNavigationSystem" (default) or
+		 * "CReactiveNavigationSystem3D" */
+		std::string navigator_class;
+		/** If not empty, overrides the holonomic method in nav_config_text */
+		std::string holonomic_method;
+		TKinematics kinematics;
+		mrpt::math::TPose2D start_pose;
+		mrpt::math::TPose2D target;
+		/** Distance to target to consider it reached (default=0.35 m) */
+		double target_allowed_distance;
+		/** Simulation period between navigation steps (default=0.1 s) */
+		double sim_period;
+		/** Give up after this simulated time (default=120 s) */
+		double max_sim_time;
+		/** Simulated laser scanner: field of view (default=270 deg), maximum
+		 * range (default=20 m), number of rays (default=180) and height
+		 * (default=0.4 m). */
+		double laser_fov, laser_max_range, laser_height;
+		unsigned int laser_rays;
+		/** Probability of occupancy above which a cell is an obstacle */
+		float occupied_threshold;
+	};
+
+	/** The outcome of running one scenario */
+	struct NAV_IMPEXP TResult
+	{
+		TResult();
+
+		std::string name;
+		/** Target reached without collisions */
+		bool success;
+		/** The robot center entered an occupied cell of the map */
+		bool collision;
+		/** The navigator entered the NAV_ERROR state */
+		bool nav_error;
+		/** max_sim_time elapsed before the end of navigation */
+		bool timeout;
+		/** Any exception message (navigator could not be created, etc.) */
+		std::string error_msg;
+
+		/** Final simulated time (seconds) */
+		double sim_time;
+		/** Length of the path actually followed by the robot (meters) */
+		double path_length;
+		/** Final distance between the robot and the target (meters) */
+		double final_distance_to_target;
+		/** Wall-clock time of each call to navigationStep() (seconds) */
+		std::vector<double> step_latencies;
+	};
+
+	/** Aggregated statistics of a batch of results */
+	struct NAV_IMPEXP TStatistics
+	{
+		TStatistics();
+
+		size_t num_scenarios, num_success, num_collisions, num_nav_errors,
+			num_timeouts;
+		/** num_success / num_scenarios */
+		double success_rate;
+		/** Total number of navigation steps in all scenarios */
+		size_t num_steps;
+		/** Latency of navigationStep() over all steps of all scenarios
+		 * (seconds) */
+		double latency_mean, latency_median, latency_p95, latency_p99,
+			latency_max;
+		/** Simulated time / wall-clock time of the whole batch */
+		double realtime_factor;
+	};
+
+	/** The list of scenarios to run */
+	std::vector<TScenario> scenarios;
+
+	/** Number of worker threads. 0 (default) means one per hardware
+	 * thread. */
+	unsigned int num_threads;
+
+	/** Directory where each worker stores PTG cache files (default=temporary
+	 * directory). Each worker uses its own subdirectory so concurrent
+	 * navigators do not write to the same files. */
+	std::string ptg_cache_directory;
+
+	/** Runs all scenarios. Results are returned in the same order than
+	 * `scenarios`. Failures in single scenarios are reported in each
+	 * TResult and do not throw. */
+	void run(std::vector<TResult>& results);
+
+	/** Wall-clock time of the last call to run() (seconds) */
+	double getLastRunTime() const { return m_last_run_time; }
+
+	/** Computes aggregated latency percentiles and success rates */
+	static TStatistics computeStatistics(
+		const std::vector<TResult>& results, const double batch_wall_time = 0);
+
+	/** Runs one single scenario in the calling thread */
+	static void runScenario(
+		const TScenario& sc, TResult& result,
+		const std::string& ptg_cache_dir = std::string("."));
+
+   private:
+	double m_last_run_time;
+};
+
+}  // End of namespace
+}  // End of namespace
@@ -122,6 +122,33 @@ class NAV_IMPEXP CReactiveNavigationSystem3D : public CAbstractPTGBasedReactive
 		// are replicated at each level)
 	}
 
+	struct NAV_IMPEXP TReactiveNavigator3DParams
+		: public mrpt::utils::CLoadableOptions
+	{
+		/** Cell size (meters) of the robot-centered obstacle grid where
+		 * sensed points are stored, one grid per height slice. Obstacles
+		 * are passed to the PTGs as one point per occupied cell (the last
+		 * point sensed in it, not the cell center, so obstacles are not
+		 * moved), which removes duplicated points. Set to 0 to use the raw
+		 * sensed points instead (no grid, no memory). Default=0.05 */
+		double obstacle_grid_resolution;
+		/** Time (seconds) that obstacles are remembered in the obstacle grid
+		 * after they were last sensed, so obstacles that leave the sensors
+		 * field of view are still taken into account. 0 (default) means
+		 * only obstacles sensed in the last step are used. */
+		double obstacle_memory_time;
+
+		virtual void loadFromConfigFile(
+			const mrpt::utils::CConfigFileBase& c,
+			const std::string& s) override;
+		virtual void saveToConfigFile(
+			mrpt::utils::CConfigFileBase& c,
+			const std::string& s) const override;
+		TReactiveNavigator3DParams();
+	};
+
+	TReactiveNavigator3DParams params_reactive_nav_3d;
+
 	virtual void loadConfigFile(const mrpt::utils::CConfigFileBase& c)
 		override;  // See base class docs!
 	virtual void saveConfigFile(mrpt::utils::CConfigFileBase& c)
@@ -152,6 +179,39 @@ class NAV_IMPEXP CReactiveNavigationSystem3D : public CAbstractPTGBasedReactive
 	 * robot local frame */
 	std::vector<mrpt::maps::CSimplePointsMap> m_WS_Obstacles_inlevels;
 
+	/** One cell of the rolling obstacle grid, see TObstacleGridSlice */
+	struct TObstacleGridCell
+	{
+		/** Cell coordinates (in odometry frame) currently stored here */
+		int32_t cx, cy;
+		/** Time (seconds since m_obsgrid_t0) the cell was last seen occupied */
+		double last_seen;
+		/** Last point sensed in the cell (x,y in odometry frame) */
+		double x, y;
+		float z;
+		/** Whether the cell is in TObstacleGridSlice::occupied */
+		bool listed;
+	};
+	/** Rolling 2D obstacle grid for one height slice. Cells are addressed
+	 * in the odometry frame by (cx mod N, cy mod N), so the grid follows the
+	 * robot without moving any data: a storage cell is reused as soon as
+	 * another cell N positions away is observed. */
+	struct TObstacleGridSlice
+	{
+		std::vector<TObstacleGridCell> cells;
+		/** Indices of the cells that may be occupied */
+		std::vector<uint32_t> occupied;
+	};
+	std::vector<TObstacleGridSlice> m_obsgrid;
+	/** Cells per side (N) and cell size of m_obsgrid */
+	int m_obsgrid_size;
+	double m_obsgrid_resolution;
+	mrpt::system::TTimeStamp m_obsgrid_t0;
+
+	/** Inserts the sensed points into m_obsgrid and rebuilds
+	 * m_WS_Obstacles_inlevels from its occupied cells */
+	void updateObstacleGrid(const mrpt::system::TTimeStamp obs_timestamp);
+
 	/** The robot 3D shape model */
 	TRobotShape m_robotShape;
 
@@ -163,6 +223,9 @@ class NAV_IMPEXP CReactiveNavigationSystem3D : public CAbstractPTGBasedReactive
 	// ----------------------------------------------------------------------------
 	virtual void STEP1_InitPTGs() override;
 
+	// See docs in parent class
+	void onStartNewNavigation() override;
+
 	// See docs in parent class
 	bool implementSenseObstacles(
 		mrpt::system::TTimeStamp& obs_timestamp) override;
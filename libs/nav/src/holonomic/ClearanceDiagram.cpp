@@ -85,6 +85,25 @@ void mrpt::nav::ClearanceDiagram::readFromStream(mrpt::utils::CStream& in)
 			this->resize(m_actual_num_paths, decim_num);
 			in >> m_raw_clearances;
 			break;
+		case 1:
+		{
+			uint32_t decim_num;
+			in.ReadAsAndCastTo<uint32_t, size_t>(m_actual_num_paths);
+			in >> decim_num;
+			this->resize(m_actual_num_paths, decim_num);
+			for (auto& c : m_raw_clearances)
+			{
+				uint32_t n;
+				in >> n;
+				for (uint32_t i = 0; i < n; i++)
+				{
+					float dist, clearance;
+					in >> dist >> clearance;
+					c[dist] = clearance;
+				}
+			}
+		}
+		break;
 		default:
 			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
 	};
@@ -92,11 +111,16 @@ void mrpt::nav::ClearanceDiagram::readFromStream(mrpt::utils::CStream& in)
 
 void mrpt::nav::ClearanceDiagram::writeToStream(mrpt::utils::CStream& out) const
 {
-	const uint8_t version = 0;
+	const uint8_t version = 1;
 	out << version;
 
 	out << uint32_t(m_actual_num_paths) << uint32_t(m_raw_clearances.size());
-	out << m_raw_clearances;
+	// v1: stored as floats, half the size of the std::map<double,double>
+	for (const auto& c : m_raw_clearances)
+	{
+		out << uint32_t(c.size());
+		for (const auto& e : c) out << float(e.first) << float(e.second);
+	}
 }
 
 ClearanceDiagram::dist2clearance_t& ClearanceDiagram::get_path_clearance(
@@ -0,0 +1,483 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "nav-precomp.h"  // Precompiled headers
+
+#include <mrpt/nav/planners/PlannerDStarLite2D.h>
+#include <algorithm>
+#include <functional>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::utils;
+using namespace mrpt::math;
+using namespace mrpt::poses;
+using namespace mrpt::nav;
+using namespace std;
+
+// 8-connected neighborhood:
+static const int NEIGH_DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int NEIGH_DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+static const float NEIGH_COST[8] = {1.0f,	  1.0f,		1.0f,	  1.0f,
+									 float(M_SQRT2), float(M_SQRT2),
+									 float(M_SQRT2), float(M_SQRT2)};
+static const float INF = std::numeric_limits<float>::infinity();
+
+// Invokes `f(neighbor_idx, move_cost)` for all in-range neighbors of a cell:
+template <class FUNCTOR>
+static inline void forEachNeighbor(
+	const uint32_t idx, const int size_x, const int size_y, FUNCTOR f)
+{
+	const int cx = int(idx % size_x), cy = int(idx / size_x);
+	for (int k = 0; k < 8; k++)
+	{
+		const int x = cx + NEIGH_DX[k], y = cy + NEIGH_DY[k];
+		if (x < 0 || y < 0 || x >= size_x || y >= size_y) continue;
+		f(uint32_t(x + y * size_x), NEIGH_COST[k]);
+	}
+}
+
+/*---------------------------------------------------------------
+						Constructor
+  ---------------------------------------------------------------*/
+PlannerDStarLite2D::PlannerDStarLite2D()
+	: occupancyThreshold(0.5f),
+	  minStepInReturnedPath(0.4f),
+	  robotRadius(0.35f),
+	  anyAnglePaths(true),
+	  m_size_x(0),
+	  m_size_y(0),
+	  m_x_min(0),
+	  m_y_min(0),
+	  m_resolution(0),
+	  m_cached_occ_threshold(0),
+	  m_cached_radius(0),
+	  m_search_id(0),
+	  m_search_valid(false),
+	  m_goal_idx(0),
+	  m_start_idx(0),
+	  m_last_start_idx(0),
+	  m_km(0)
+{
+}
+
+void PlannerDStarLite2D::resetCache()
+{
+	m_size_x = m_size_y = 0;
+	m_occupied.clear();
+	m_inflation.clear();
+	m_search_valid = false;
+}
+
+/*---------------------------------------------------------------
+						updateCostmap
+  ---------------------------------------------------------------*/
+void PlannerDStarLite2D::changeObstacleCount(
+	const int cx, const int cy, const int incr)
+{
+	for (const auto& d : m_disc)
+	{
+		const int x = cx + d.first, y = cy + d.second;
+		if (x < 0 || y < 0 || x >= m_size_x || y >= m_size_y) continue;
+		const uint32_t idx = x + y * m_size_x;
+		const uint32_t old_cnt = m_inflation[idx];
+		m_inflation[idx] = old_cnt + incr;
+		if ((old_cnt == 0) != (m_inflation[idx] == 0))
+			m_changed_cells.push_back(idx);
+	}
+}
+
+bool PlannerDStarLite2D::updateCostmap(const COccupancyGridMap2D& theMap)
+{
+	const int size_x = theMap.getSizeX(), size_y = theMap.getSizeY();
+	const std::vector<COccupancyGridMap2D::cellType>& raw =
+		theMap.getRawMap();
+
+	m_changed_cells.clear();
+	m_stats.changed_cells = 0;
+
+	const bool same_geometry =
+		size_x == m_size_x && size_y == m_size_y &&
+		theMap.getXMin() == m_x_min && theMap.getYMin() == m_y_min &&
+		theMap.getResolution() == m_resolution &&
+		occupancyThreshold == m_cached_occ_threshold &&
+		robotRadius == m_cached_radius;
+
+	if (same_geometry)
+	{
+		// Incremental update: only re-inflate cells that changed:
+		for (int y = 0, idx = 0; y < size_y; y++)
+			for (int x = 0; x < size_x; x++, idx++)
+			{
+				const uint8_t occ =
+					COccupancyGridMap2D::l2p(raw[idx]) > occupancyThreshold
+						? 0
+						: 1;
+				if (occ == m_occupied[idx]) continue;
+				m_occupied[idx] = occ;
+				m_stats.changed_cells++;
+				changeObstacleCount(x, y, occ ? +1 : -1);
+			}
+		return true;
+	}
+
+	// Rebuild from scratch:
+	m_size_x = size_x;
+	m_size_y = size_y;
+	m_x_min = theMap.getXMin();
+	m_y_min = theMap.getYMin();
+	m_resolution = theMap.getResolution();
+	m_cached_occ_threshold = occupancyThreshold;
+	m_cached_radius = robotRadius;
+
+	const int R = (int)(ceil(robotRadius / m_resolution));
+	m_disc.clear();
+	for (int dy = -R; dy <= R; dy++)
+		for (int dx = -R; dx <= R; dx++)
+			if (dx * dx + dy * dy <= R * R) m_disc.emplace_back(dx, dy);
+
+	const size_t N = size_t(size_x) * size_t(size_y);
+	m_occupied.assign(N, 0);
+	m_inflation.assign(N, 0);
+	m_g.resize(N);
+	m_rhs.resize(N);
+	m_open_k1.resize(N);
+	m_open_k2.resize(N);
+	m_in_open.resize(N);
+	m_stamp.assign(N, 0);
+	m_search_id = 0;
+	m_search_valid = false;
+
+	for (int y = 0, idx = 0; y < size_y; y++)
+		for (int x = 0; x < size_x; x++, idx++)
+		{
+			if (COccupancyGridMap2D::l2p(raw[idx]) > occupancyThreshold)
+				continue;
+			m_occupied[idx] = 1;
+			changeObstacleCount(x, y, +1);
+		}
+	m_changed_cells.clear();
+	return false;
+}
+
+/*---------------------------------------------------------------
+						D* Lite
+  ---------------------------------------------------------------*/
+float PlannerDStarLite2D::heuristic(const uint32_t a, const uint32_t b) const
+{
+	// Octile distance: admissible and consistent in 8-connected grids
+	const int dx = std::abs(int(a % m_size_x) - int(b % m_size_x));
+	const int dy = std::abs(int(a / m_size_x) - int(b / m_size_x));
+	return float(std::max(dx, dy)) +
+		   float(M_SQRT2 - 1.0) * float(std::min(dx, dy));
+}
+
+void PlannerDStarLite2D::calcKey(
+	const uint32_t idx, float& k1, float& k2) const
+{
+	k2 = std::min(m_g[idx], m_rhs[idx]);
+	k1 = k2 + heuristic(m_start_idx, idx) + m_km;
+}
+
+void PlannerDStarLite2D::updateOpen(const uint32_t idx)
+{
+	if (m_g[idx] == m_rhs[idx])
+	{
+		m_in_open[idx] = 0;  // Stale heap entries are skipped in topKey()
+		return;
+	}
+	TOpenEntry e;
+	calcKey(idx, e.k1, e.k2);
+	e.idx = idx;
+	if (m_in_open[idx] && m_open_k1[idx] == e.k1 && m_open_k2[idx] == e.k2)
+		return;  // Already queued with this key
+	m_in_open[idx] = 1;
+	m_open_k1[idx] = e.k1;
+	m_open_k2[idx] = e.k2;
+	m_open.push_back(e);
+	std::push_heap(m_open.begin(), m_open.end(), std::greater<TOpenEntry>());
+}
+
+void PlannerDStarLite2D::updateRHS(const uint32_t idx)
+{
+	float rhs = INF;
+	forEachNeighbor(
+		idx, m_size_x, m_size_y, [&](const uint32_t nidx, const float ncost) {
+			if (!isBlocked(nidx)) rhs = std::min(rhs, ncost + gValue(nidx));
+		});
+	m_rhs[idx] = rhs;
+}
+
+void PlannerDStarLite2D::updateVertex(const uint32_t idx)
+{
+	touch(idx);
+	if (idx != m_goal_idx) updateRHS(idx);
+	updateOpen(idx);
+}
+
+bool PlannerDStarLite2D::topKey(float& k1, float& k2)
+{
+	while (!m_open.empty())
+	{
+		const TOpenEntry& e = m_open.front();
+		if (m_in_open[e.idx] && m_stamp[e.idx] == m_search_id &&
+			m_open_k1[e.idx] == e.k1 && m_open_k2[e.idx] == e.k2)
+		{
+			k1 = e.k1;
+			k2 = e.k2;
+			return true;
+		}
+		// Stale entry:
+		std::pop_heap(m_open.begin(), m_open.end(), std::greater<TOpenEntry>());
+		m_open.pop_back();
+	}
+	return false;
+}
+
+void PlannerDStarLite2D::computeShortestPath()
+{
+	touch(m_start_idx);
+	float tk1, tk2;
+	while (topKey(tk1, tk2))
+	{
+		float sk1, sk2;
+		calcKey(m_start_idx, sk1, sk2);
+		const bool top_is_lower = tk1 < sk1 || (tk1 == sk1 && tk2 < sk2);
+		if (!top_is_lower && m_rhs[m_start_idx] == m_g[m_start_idx]) break;
+
+		const uint32_t u = m_open.front().idx;
+		std::pop_heap(m_open.begin(), m_open.end(), std::greater<TOpenEntry>());
+		m_open.pop_back();
+		m_in_open[u] = 0;
+		m_stats.expanded_cells++;
+
+		float nk1, nk2;
+		calcKey(u, nk1, nk2);
+		if (tk1 < nk1 || (tk1 == nk1 && tk2 < nk2))
+		{
+			// Key out of date: requeue
+			updateOpen(u);
+		}
+		else if (m_g[u] > m_rhs[u])
+		{
+			// Locally overconsistent: propagate the improved cost
+			m_g[u] = m_rhs[u];
+			if (isBlocked(u)) continue;  // Can't be entered from neighbors
+			forEachNeighbor(
+				u, m_size_x, m_size_y,
+				[&](const uint32_t nidx, const float ncost) {
+					touch(nidx);
+					if (nidx != m_goal_idx)
+						m_rhs[nidx] = std::min(m_rhs[nidx], ncost + m_g[u]);
+					updateOpen(nidx);
+				});
+		}
+		else
+		{
+			// Locally underconsistent: invalidate and let neighbors
+			// re-evaluate
+			const float g_old = m_g[u];
+			m_g[u] = INF;
+			if (!isBlocked(u))
+			{
+				forEachNeighbor(
+					u, m_size_x, m_size_y,
+					[&](const uint32_t nidx, const float ncost) {
+						touch(nidx);
+						if (nidx != m_goal_idx && m_rhs[nidx] == ncost + g_old)
+							updateRHS(nidx);
+						updateOpen(nidx);
+					});
+			}
+			updateVertex(u);
+		}
+	}
+}
+
+bool PlannerDStarLite2D::lineOfSight(const uint32_t a, const uint32_t b) const
+{
+	const int ax = a % m_size_x, ay = a / m_size_x;
+	const int bx = b % m_size_x, by = b / m_size_x;
+	const int n = 2 * std::max(std::abs(bx - ax), std::abs(by - ay));
+	for (int i = 1; i <= n; i++)
+	{
+		const int x = ax + int(std::round(double((bx - ax) * i) / n));
+		const int y = ay + int(std::round(double((by - ay) * i) / n));
+		if (isBlocked(x + y * m_size_x)) return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------
+						computePath
+  ---------------------------------------------------------------*/
+void PlannerDStarLite2D::computePath(
+	const COccupancyGridMap2D& theMap, const CPose2D& origin_,
+	const CPose2D& target_, std::deque<math::TPoint2D>& path, bool& notFound,
+	float maxSearchPathLength)
+{
+	const TPoint2D origin = TPoint2D(origin_);
+	const TPoint2D target = TPoint2D(target_);
+
+	// Check that origin and target falls inside the grid theMap!!
+	ASSERT_(
+		origin.x > theMap.getXMin() && origin.x < theMap.getXMax() &&
+		origin.y > theMap.getYMin() && origin.y < theMap.getYMax());
+	ASSERT_(
+		target.x > theMap.getXMin() && target.x < theMap.getXMax() &&
+		target.y > theMap.getYMin() && target.y < theMap.getYMax());
+
+	m_stats = TStats();
+
+	// Keep the inflated costmap up to date:
+	const bool incremental = updateCostmap(theMap);
+
+	const uint32_t start_idx =
+		theMap.x2idx(origin.x) + m_size_x * theMap.y2idx(origin.y);
+	const uint32_t goal_idx =
+		theMap.x2idx(target.x) + m_size_x * theMap.y2idx(target.y);
+
+	// Special case of origin and target in the same cell:
+	if (start_idx == goal_idx)
+	{
+		path.clear();
+		path.push_back(TPoint2D(target.x, target.y));
+		notFound = false;
+		return;
+	}
+
+	m_start_idx = start_idx;
+	if (!incremental || !m_search_valid || goal_idx != m_goal_idx)
+	{
+		// New search from scratch:
+		m_stats.full_replan = true;
+		if (++m_search_id == 0)
+		{
+			std::fill(m_stamp.begin(), m_stamp.end(), 0);
+			m_search_id = 1;
+		}
+		m_open.clear();
+		m_km = 0;
+		m_goal_idx = goal_idx;
+		m_last_start_idx = start_idx;
+		touch(m_goal_idx);
+		m_rhs[m_goal_idx] = 0;
+		updateOpen(m_goal_idx);
+		m_search_valid = true;
+	}
+	else
+	{
+		// Repair the existing search:
+		m_stats.full_replan = false;
+		m_km += heuristic(m_last_start_idx, start_idx);
+		m_last_start_idx = start_idx;
+
+		// A cell whose traversability changed modifies the cost of the edges
+		// entering it, i.e. the rhs of all its neighbors:
+		for (const uint32_t c : m_changed_cells)
+		{
+			updateVertex(c);
+			forEachNeighbor(
+				c, m_size_x, m_size_y,
+				[this](const uint32_t nidx, float) { updateVertex(nidx); });
+		}
+		// Purge stale heap entries if they are dominating the heap:
+		if (m_open.size() > m_g.size())
+		{
+			m_open.erase(
+				std::remove_if(
+					m_open.begin(), m_open.end(),
+					[this](const TOpenEntry& e) {
+						return !m_in_open[e.idx] ||
+							   m_stamp[e.idx] != m_search_id ||
+							   m_open_k1[e.idx] != e.k1 ||
+							   m_open_k2[e.idx] != e.k2;
+					}),
+				m_open.end());
+			std::make_heap(
+				m_open.begin(), m_open.end(), std::greater<TOpenEntry>());
+		}
+	}
+
+	computeShortestPath();
+
+	// Path not found:
+	const float path_len_cells = m_g[m_start_idx];
+	notFound =
+		(path_len_cells == INF ||
+		 (maxSearchPathLength > 0 &&
+		  path_len_cells * m_resolution > maxSearchPathLength));
+	if (notFound) return;
+
+	// Follow the gradient of "g" from the origin to the target:
+	m_path_cells.clear();
+	m_path_cells.push_back(m_start_idx);
+	for (uint32_t cur = m_start_idx; cur != m_goal_idx;)
+	{
+		float best = INF;
+		uint32_t best_idx = cur;
+		forEachNeighbor(
+			cur, m_size_x, m_size_y,
+			[&](const uint32_t nidx, const float ncost) {
+				if (isBlocked(nidx)) return;
+				const float c = ncost + gValue(nidx);
+				if (c < best)
+				{
+					best = c;
+					best_idx = nidx;
+				}
+			});
+		if (best == INF || m_path_cells.size() > m_g.size())
+		{
+			notFound = true;
+			return;
+		}
+		cur = best_idx;
+		m_path_cells.push_back(cur);
+	}
+
+	// Translate the path-of-cells to a path-of-2d-points:
+	path.clear();
+	const size_t n = m_path_cells.size();
+	if (anyAnglePaths)
+	{
+		// Only keep those cells required to keep line of sight (they are all
+		// needed, so minStepInReturnedPath does not apply here):
+		size_t anchor = 0;
+		for (size_t i = 1; i + 1 < n; i++)
+		{
+			if (lineOfSight(m_path_cells[anchor], m_path_cells[i + 1]))
+				continue;
+			path.push_back(
+				TPoint2D(
+					theMap.idx2x(m_path_cells[i] % m_size_x),
+					theMap.idx2y(m_path_cells[i] / m_size_x)));
+			anchor = i;
+		}
+	}
+	else
+	{
+		// Subsample with minStepInReturnedPath:
+		float last_xx = origin.x, last_yy = origin.y;
+		for (size_t i = 1; i + 1 < n; i++)
+		{
+			const float xx = theMap.idx2x(m_path_cells[i] % m_size_x);
+			const float yy = theMap.idx2y(m_path_cells[i] / m_size_x);
+			if (sqrt(square(xx - last_xx) + square(yy - last_yy)) >
+				minStepInReturnedPath)
+			{
+				path.push_back(TPoint2D(xx, yy));
+				last_xx = xx;
+				last_yy = yy;
+			}
+		}
+	}
+	// Add the target point:
+	path.push_back(TPoint2D(target.x, target.y));
+}
@@ -0,0 +1,100 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/planners/PlannerDStarLite2D.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::poses;
+using namespace mrpt::nav;
+
+static double pathLength(const TPoint2D& origin, const std::deque<TPoint2D>& p)
+{
+	double L = 0;
+	TPoint2D last = origin;
+	for (const auto& pt : p)
+	{
+		L += std::sqrt(square(pt.x - last.x) + square(pt.y - last.y));
+		last = pt;
+	}
+	return L;
+}
+
+// Vertical wall at x=5m, with a gap at y in [gap_y0,gap_y1]:
+static void drawWall(COccupancyGridMap2D& grid, double gap_y0, double gap_y1)
+{
+	const int cx = grid.x2idx(5.0);
+	for (int cy = 0; cy < int(grid.getSizeY()); cy++)
+	{
+		const double y = grid.idx2y(cy);
+		grid.setCell(cx, cy, (y >= gap_y0 && y <= gap_y1) ? 1.0f : 0.0f);
+	}
+}
+
+TEST(NavTests, PlannerDStarLite2D_incremental_vs_scratch)
+{
+	COccupancyGridMap2D grid(0, 10, 0, 10, 0.1f);
+	grid.fill(1.0f);  // All free
+	drawWall(grid, 7.0, 8.0);
+
+	const CPose2D origin(1.0, 2.0, 0), target(9.0, 2.0, 0);
+
+	PlannerDStarLite2D planner;
+	planner.anyAnglePaths = false;
+	planner.minStepInReturnedPath = 0;
+	planner.robotRadius = 0.2f;
+
+	std::deque<TPoint2D> path;
+	bool notFound;
+	planner.computePath(grid, origin, target, path, notFound);
+	ASSERT_FALSE(notFound);
+	EXPECT_TRUE(planner.getLastStats().full_replan);
+	ASSERT_FALSE(path.empty());
+	EXPECT_NEAR(path.back().x, target.x(), 1e-6);
+	EXPECT_NEAR(path.back().y, target.y(), 1e-6);
+	// The path must go through the gap:
+	EXPECT_GT(pathLength(TPoint2D(origin), path), 10.0);
+	for (const auto& p : path) EXPECT_GT(grid.getPos(p.x, p.y), 0.5f);
+
+	// Move the gap closer and move the robot: repair vs. plan from scratch
+	drawWall(grid, 3.0, 4.0);
+	const CPose2D origin2(1.5, 2.0, 0);
+	planner.computePath(grid, origin2, target, path, notFound);
+	ASSERT_FALSE(notFound);
+	EXPECT_FALSE(planner.getLastStats().full_replan);
+	EXPECT_GT(planner.getLastStats().changed_cells, 0u);
+
+	PlannerDStarLite2D planner2;
+	planner2.anyAnglePaths = false;
+	planner2.minStepInReturnedPath = 0;
+	planner2.robotRadius = 0.2f;
+	std::deque<TPoint2D> path2;
+	bool notFound2;
+	planner2.computePath(grid, origin2, target, path2, notFound2);
+	ASSERT_FALSE(notFound2);
+	EXPECT_NEAR(
+		pathLength(TPoint2D(origin2), path),
+		pathLength(TPoint2D(origin2), path2), 1e-3);
+
+	// Close the wall: no path at all.
+	drawWall(grid, -1, -1);
+	planner.computePath(grid, origin2, target, path, notFound);
+	EXPECT_TRUE(notFound);
+
+	// Any-angle paths are never longer than grid paths:
+	drawWall(grid, 3.0, 4.0);
+	planner.anyAnglePaths = true;
+	planner.computePath(grid, origin2, target, path, notFound);
+	ASSERT_FALSE(notFound);
+	EXPECT_LE(
+		pathLength(TPoint2D(origin2), path),
+		pathLength(TPoint2D(origin2), path2) + 1e-3);
+}
@@ -0,0 +1,86 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/planners/TMoveTree.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::nav;
+using namespace mrpt::math;
+using namespace mrpt::utils;
+
+// Brute-force search, for comparison against the indexed one:
+static std::vector<std::pair<double, TNodeID>> bruteForceDistances(
+	const TMoveTreeSE2_TP& tree, const TNodeSE2& q)
+{
+	const PoseDistanceMetric<TNodeSE2> metric;
+	std::vector<std::pair<double, TNodeID>> ret;
+	for (const auto& n : tree.getAllNodes())
+		ret.emplace_back(metric.distance(TNodeSE2(n.second.state), q), n.first);
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+TEST(NavTests, TMoveTree_nearest_nodes_vs_brute_force)
+{
+	random::CRandomGenerator rng(1234);
+	for (const double cell_size : {0.1, 0.5, 2.0})
+	{
+		TMoveTreeSE2_TP tree;
+		tree.setNodeIndexCellSize(cell_size);
+		tree.root = 0;
+		tree.insertNode(0, TNodeSE2_TP(TPose2D(0, 0, 0)));
+		for (TNodeID id = 1; id < 300; id++)
+		{
+			const TPose2D p(
+				rng.drawUniform(-10.0, 10.0), rng.drawUniform(-5.0, 5.0),
+				rng.drawUniform(-M_PI, M_PI));
+			tree.insertNodeAndEdge(
+				rng.drawUniform32bit() % id, id, TNodeSE2_TP(p),
+				TMoveEdgeSE2_TP(0, p));
+		}
+
+		const PoseDistanceMetric<TNodeSE2> metric;
+		for (int i = 0; i < 50; i++)
+		{
+			const TNodeSE2 q(
+				TPose2D(
+					rng.drawUniform(-15.0, 15.0), rng.drawUniform(-8.0, 8.0),
+					rng.drawUniform(-M_PI, M_PI)));
+			const auto gt = bruteForceDistances(tree, q);
+
+			double d;
+			const TNodeID nn = tree.getNearestNode(q, metric, &d);
+			EXPECT_EQ(gt[0].second, nn);
+			EXPECT_NEAR(gt[0].first, d, 1e-9);
+
+			std::vector<std::pair<double, TNodeID>> knn;
+			tree.getKNearestNodes(q, metric, 5, knn);
+			ASSERT_EQ(knn.size(), 5u);
+			for (size_t j = 0; j < knn.size(); j++)
+				EXPECT_EQ(gt[j].second, knn[j].second);
+
+			const double R = 1.5;
+			std::vector<std::pair<double, TNodeID>> in_radius;
+			tree.getNodesWithinRadius(q, metric, R, in_radius);
+			size_t n_gt = 0;
+			while (n_gt < gt.size() && gt[n_gt].first <= R) n_gt++;
+			ASSERT_EQ(n_gt, in_radius.size());
+			for (size_t j = 0; j < n_gt; j++)
+				EXPECT_EQ(gt[j].second, in_radius[j].second);
+
+			// Ignored nodes:
+			std::set<TNodeID> ignored;
+			ignored.insert(gt[0].second);
+			EXPECT_EQ(
+				gt[1].second, tree.getNearestNode(q, metric, NULL, &ignored));
+		}
+	}
+}
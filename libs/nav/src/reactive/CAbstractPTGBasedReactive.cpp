@@ -62,6 +62,7 @@ CAbstractPTGBasedReactive::CAbstractPTGBasedReactive(
 	  m_holonomicMethod(),
 	  m_prev_logfile(nullptr),
 	  m_enableKeepLogRecords(false),
+	  m_logfile_thread_quit(false),
 	  m_enableConsoleOutput(enableConsoleOutput),
 	  m_init_done(false),
 	  m_timelogger(false),  // default: disabled
@@ -98,6 +99,7 @@ void CAbstractPTGBasedReactive::preDestructor()
 	{
 	}
 
+	stopLogFileWriterThread();
 	m_logFile.reset();
 
 	// Free holonomic method:
@@ -140,6 +142,7 @@ void CAbstractPTGBasedReactive::enableLogFile(bool enable)
 				MRPT_LOG_DEBUG(
 					"[CAbstractPTGBasedReactive::enableLogFile] Stopping "
 					"logging.");
+				stopLogFileWriterThread();  // Flush pending records
 				m_logFile.reset();  // Close file:
 			}
 			else
@@ -187,6 +190,12 @@ void CAbstractPTGBasedReactive::enableLogFile(bool enable)
 				}
 			}
 
+			// Launch the writer thread:
+			m_logfile_last_full_record.reset();
+			m_logfile_thread_quit = false;
+			m_logfile_thread = std::thread(
+				&CAbstractPTGBasedReactive::thread_logfile_writer, this);
+
 			MRPT_LOG_DEBUG(
 				mrpt::format(
 					"[CAbstractPTGBasedReactive::enableLogFile] Logging to "
@@ -202,6 +211,55 @@ void CAbstractPTGBasedReactive::enableLogFile(bool enable)
 	}
 }
 
+void CAbstractPTGBasedReactive::stopLogFileWriterThread()
+{
+	if (!m_logfile_thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(m_logfile_queue_mtx);
+		m_logfile_thread_quit = true;
+	}
+	m_logfile_queue_cv.notify_one();
+	m_logfile_thread.join();
+}
+
+void CAbstractPTGBasedReactive::thread_logfile_writer()
+{
+	for (;;)
+	{
+		CLogFileRecord::Ptr rec;
+		{
+			std::unique_lock<std::mutex> lock(m_logfile_queue_mtx);
+			m_logfile_queue_cv.wait(lock, [this] {
+				return m_logfile_thread_quit || !m_logfile_queue.empty();
+			});
+			// On quit, keep going until all pending records are written:
+			if (m_logfile_queue.empty()) return;
+			rec = m_logfile_queue.front();
+			m_logfile_queue.pop_front();
+		}
+
+		// Delta-encoding: only store the robot shape and PTG descriptions
+		// when they change:
+		if (m_logfile_last_full_record &&
+			rec->hasSameStaticFieldsAs(*m_logfile_last_full_record))
+			rec->omitStaticFields();
+		else
+			m_logfile_last_full_record = rec;
+
+		try
+		{
+			(*m_logFile) << *rec;
+		}
+		catch (std::exception& e)
+		{
+			MRPT_LOG_ERROR_FMT(
+				"[CAbstractPTGBasedReactive::thread_logfile_writer] Error "
+				"writing log record: %s",
+				e.what());
+		}
+	}
+}
+
 void CAbstractPTGBasedReactive::getLastLogRecord(CLogFileRecord& o)
 {
 	std::lock_guard<std::recursive_mutex> lock(m_critZoneLastLog);
@@ -971,7 +1029,16 @@ void CAbstractPTGBasedReactive::STEP8_GenerateLogRecord(
 	{
 		mrpt::utils::CTimeLoggerEntry tle(
 			m_timelogger, "navigationStep.write_log_file");
-		if (m_logFile) (*m_logFile) << newLogRec;
+		if (m_logFile)
+		{
+			// Serialization and disk access happen in thread_logfile_writer
+			auto rec = std::make_shared<CLogFileRecord>(newLogRec);
+			{
+				std::lock_guard<std::mutex> lock(m_logfile_queue_mtx);
+				m_logfile_queue.push_back(rec);
+			}
+			m_logfile_queue_cv.notify_one();
+		}
 	}
 	// Set as last log record
 	{
@@ -37,7 +37,8 @@ CLogFileRecord::CLogFileRecord()
 	  ptg_index_NOP(-1),
 	  ptg_last_k_NOP(0),
 	  rel_cur_pose_wrt_last_vel_cmd_NOP(0, 0, 0),
-	  rel_pose_PTG_origin_wrt_sense_NOP(0, 0, 0)
+	  rel_pose_PTG_origin_wrt_sense_NOP(0, 0, 0),
+	  static_fields_omitted(false)
 {
 	infoPerPTG.clear();
 	WS_Obstacles.clear();
@@ -50,7 +51,7 @@ void CLogFileRecord::writeToStream(
 	mrpt::utils::CStream& out, int* version) const
 {
 	if (version)
-		*version = 26;
+		*version = 27;
 	else
 	{
 		uint32_t i, n;
@@ -144,6 +145,8 @@ void CLogFileRecord::writeToStream(
 		out << additional_debug_msgs;  // v18
 
 		navDynState.writeToStream(out);  // v24
+
+		out << static_fields_omitted;  // v27
 	}
 }
 
@@ -181,6 +184,7 @@ void CLogFileRecord::readFromStream(mrpt::utils::CStream& in, int version)
 		case 24:
 		case 25:
 		case 26:
+		case 27:
 		{
 			// Version 0 --------------
 			uint32_t i, n;
@@ -579,9 +583,47 @@ void CLogFileRecord::readFromStream(mrpt::utils::CStream& in, int version)
 				if (!WS_targets_relative.empty())
 					navDynState.relTarget = WS_targets_relative[0];
 			}
+
+			if (version >= 27)
+				in >> static_fields_omitted;
+			else
+				static_fields_omitted = false;
 		}
 		break;
 		default:
 			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
 	};
 }
+
+bool CLogFileRecord::hasSameStaticFieldsAs(const CLogFileRecord& o) const
+{
+	if (robotShape_x.size() != o.robotShape_x.size() ||
+		infoPerPTG.size() != o.infoPerPTG.size())
+		return false;
+	for (int i = 0; i < robotShape_x.size(); i++)
+		if (robotShape_x[i] != o.robotShape_x[i] ||
+			robotShape_y[i] != o.robotShape_y[i])
+			return false;
+	for (size_t i = 0; i < infoPerPTG.size(); i++)
+		if (infoPerPTG[i].PTG_desc != o.infoPerPTG[i].PTG_desc) return false;
+	return true;
+}
+
+void CLogFileRecord::omitStaticFields()
+{
+	robotShape_x.resize(0);
+	robotShape_y.resize(0);
+	for (auto& ipp : infoPerPTG) ipp.PTG_desc.clear();
+	static_fields_omitted = true;
+}
+
+void CLogFileRecord::restoreStaticFieldsFrom(const CLogFileRecord& prev)
+{
+	if (!static_fields_omitted) return;
+	robotShape_x = prev.robotShape_x;
+	robotShape_y = prev.robotShape_y;
+	for (size_t i = 0; i < infoPerPTG.size() && i < prev.infoPerPTG.size();
+		 i++)
+		infoPerPTG[i].PTG_desc = prev.infoPerPTG[i].PTG_desc;
+	static_fields_omitted = false;
+}
@@ -115,3 +115,39 @@ TEST(NavTests, NavLogLoadFromTestFile)
 			   << e.what() << endl;
 	}
 }
+
+// Delta-encoded records must be recovered after loading:
+TEST(NavTests, NavLogOmitStaticFields)
+{
+	CLogFileRecord r1, r2;
+	for (CLogFileRecord* r : {&r1, &r2})
+	{
+		r->robotShape_x.resize(3);
+		r->robotShape_y.resize(3);
+		for (int i = 0; i < 3; i++)
+		{
+			r->robotShape_x[i] = i * 0.1f;
+			r->robotShape_y[i] = -i * 0.2f;
+		}
+		r->infoPerPTG.resize(2);
+		r->infoPerPTG[0].PTG_desc = "PTG #0";
+		r->infoPerPTG[1].PTG_desc = "PTG #1";
+	}
+	r2.robotShape_radius = 0.4;
+	ASSERT_TRUE(r2.hasSameStaticFieldsAs(r1));
+	r2.omitStaticFields();
+	EXPECT_TRUE(r2.static_fields_omitted);
+
+	CMemoryStream buf;
+	buf << r2;
+	buf.Seek(0);
+	CLogFileRecord r3;
+	buf >> r3;
+	EXPECT_TRUE(r3.static_fields_omitted);
+	EXPECT_EQ(r3.robotShape_x.size(), 0);
+
+	r3.restoreStaticFieldsFrom(r1);
+	EXPECT_FALSE(r3.static_fields_omitted);
+	EXPECT_TRUE(r3.hasSameStaticFieldsAs(r1));
+	EXPECT_NEAR(r3.robotShape_radius, 0.4, 1e-9);
+}
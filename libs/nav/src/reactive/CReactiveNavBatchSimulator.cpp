@@ -0,0 +1,361 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "nav-precomp.h"  // Precomp header
+
+#include <mrpt/nav/reactive/CReactiveNavBatchSimulator.h>
+#include <mrpt/nav/reactive/CReactiveNavigationSystem.h>
+#include <mrpt/nav/reactive/CReactiveNavigationSystem3D.h>
+#include <mrpt/nav/reactive/CRobot2NavInterfaceForSimulator.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/utils/CConfigFileMemory.h>
+#include <mrpt/utils/CTicTac.h>
+#include <mrpt/utils/parallel.h>
+#include <mrpt/system/filesystem.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace mrpt::nav;
+
+namespace
+{
+/** Robot interface for the simulator SIMUL, sensing obstacles with a
+ * simulated 2D laser scanner on the scenario gridmap */
+template <class BASE_IF, class SIMUL>
+class TBatchSimulRobotIF : public BASE_IF
+{
+   public:
+	TBatchSimulRobotIF(
+		SIMUL& sim, const CReactiveNavBatchSimulator::TScenario& sc)
+		: BASE_IF(sim), m_sc(sc)
+	{
+		this->setMinLoggingLevel(mrpt::utils::LVL_ERROR);
+	}
+
+	void sendNavigationStartEvent() override {}
+	void sendNavigationEndEvent() override {}
+
+	bool senseObstacles(
+		mrpt::maps::CSimplePointsMap& obstacles,
+		mrpt::system::TTimeStamp& timestamp) override
+	{
+		obstacles.clear();
+		timestamp = mrpt::system::now();
+
+		mrpt::math::TPose2D curPose, odomPose;
+		std::string pose_frame_id;
+		mrpt::math::TTwist2D curVel;
+		mrpt::system::TTimeStamp pose_tim;
+		this->getCurrentPoseAndSpeeds(
+			curPose, curVel, pose_tim, odomPose, pose_frame_id);
+
+		m_scan.aperture = m_sc.laser_fov;
+		m_scan.maxRange = m_sc.laser_max_range;
+		m_scan.sensorPose.z(m_sc.laser_height);
+		m_sc.map->laserScanSimulator(
+			m_scan, mrpt::poses::CPose2D(curPose), m_sc.occupied_threshold,
+			m_sc.laser_rays);
+
+		obstacles.insertionOptions.minDistBetweenLaserPoints = .0;
+		obstacles.loadFromRangeScan(m_scan);
+		return true;
+	}
+
+   private:
+	const CReactiveNavBatchSimulator::TScenario& m_sc;
+	mrpt::obs::CObservation2DRangeScan m_scan;
+};
+
+/** Runs the simulation loop with an already created simulator and robot
+ * interface */
+void simulateScenario(
+	mrpt::kinematics::CVehicleSimulVirtualBase& sim, CRobot2NavInterface& rif,
+	const CReactiveNavBatchSimulator::TScenario& sc,
+	CReactiveNavBatchSimulator::TResult& res, const std::string& ptg_cache_dir)
+{
+	mrpt::utils::CConfigFileMemory cfg(sc.nav_config_text);
+	cfg.write(
+		"CAbstractPTGBasedReactive", "ptg_cache_files_directory",
+		ptg_cache_dir);
+	if (!sc.holonomic_method.empty())
+		cfg.write(
+			"CAbstractPTGBasedReactive", "holonomic_method",
+			sc.holonomic_method);
+
+	std::unique_ptr<CAbstractPTGBasedReactive> rnav;
+	if (sc.navigator_class.empty() ||
+		sc.navigator_class == "CReactiveNavigationSystem")
+		rnav.reset(
+			new CReactiveNavigationSystem(rif, false /*console output*/));
+	else if (sc.navigator_class == "CReactiveNavigationSystem3D")
+		rnav.reset(
+			new CReactiveNavigationSystem3D(rif, false /*console output*/));
+	else
+		THROW_EXCEPTION_FMT(
+			"Unknown navigator class: `%s`", sc.navigator_class.c_str());
+
+	rnav->enableTimeLog(false);
+	rnav->enableLogFile(false);
+	rnav->setMinLoggingLevel(mrpt::utils::LVL_ERROR);
+	rnav->loadConfigFile(cfg);
+	rnav->initialize();
+
+	sim.setCurrentGTPose(sc.start_pose);
+	sim.setCurrentOdometricPose(sc.start_pose);
+
+	CAbstractNavigator::TNavigationParams np;
+	np.target.target_coords = sc.target;
+	np.target.targetAllowedDistance = sc.target_allowed_distance;
+	rnav->navigate(&np);
+
+	const double t0 = sim.getTime();
+	const size_t max_steps = 1 + size_t(sc.max_sim_time / sc.sim_period);
+	res.step_latencies.reserve(max_steps);
+
+	mrpt::utils::CTicTac tictac;
+	mrpt::math::TPose2D last_pose = sim.getCurrentGTPose();
+	for (;;)
+	{
+		tictac.Tic();
+		rnav->navigationStep();
+		res.step_latencies.push_back(tictac.Tac());
+
+		const auto st = rnav->getCurrentState();
+		if (st == CAbstractNavigator::NAV_ERROR)
+		{
+			res.nav_error = true;
+			break;
+		}
+		if (st == CAbstractNavigator::IDLE) break;
+		if (sim.getTime() - t0 >= sc.max_sim_time)
+		{
+			res.timeout = true;
+			break;
+		}
+
+		sim.simulateOneTimeStep(sc.sim_period);
+
+		const mrpt::math::TPose2D& p = sim.getCurrentGTPose();
+		res.path_length += std::sqrt(
+			mrpt::utils::square(p.x - last_pose.x) +
+			mrpt::utils::square(p.y - last_pose.y));
+		last_pose = p;
+		if (sc.map->getPos(p.x, p.y) < 1.0f - sc.occupied_threshold)
+		{
+			res.collision = true;
+			break;
+		}
+	}
+
+	res.sim_time = sim.getTime() - t0;
+	res.final_distance_to_target = std::sqrt(
+		mrpt::utils::square(last_pose.x - sc.target.x) +
+		mrpt::utils::square(last_pose.y - sc.target.y));
+	// Small tolerance, as in the navigator own target-reached check:
+	res.success = !res.collision && !res.nav_error && !res.timeout &&
+				  res.final_distance_to_target <
+					  sc.target_allowed_distance + 0.05;
+}
+
+double percentile(const std::vector<double>& sorted, const double p)
+{
+	if (sorted.empty()) return 0;
+	const size_t idx = std::min(
+		sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+	return sorted[idx];
+}
+}  // namespace
+
+CReactiveNavBatchSimulator::TScenario::TScenario()
+	: navigator_class("CReactiveNavigationSystem"),
+	  kinematics(kinDiffDriven),
+	  start_pose(0, 0, 0),
+	  target(0, 0, 0),
+	  target_allowed_distance(0.35),
+	  sim_period(0.1),
+	  max_sim_time(120.0),
+	  laser_fov(mrpt::utils::DEG2RAD(270.0)),
+	  laser_max_range(20.0),
+	  laser_height(0.4),
+	  laser_rays(180),
+	  occupied_threshold(0.6f)
+{
+}
+
+CReactiveNavBatchSimulator::TResult::TResult()
+	: success(false),
+	  collision(false),
+	  nav_error(false),
+	  timeout(false),
+	  sim_time(0),
+	  path_length(0),
+	  final_distance_to_target(0)
+{
+}
+
+CReactiveNavBatchSimulator::TStatistics::TStatistics()
+	: num_scenarios(0),
+	  num_success(0),
+	  num_collisions(0),
+	  num_nav_errors(0),
+	  num_timeouts(0),
+	  success_rate(0),
+	  num_steps(0),
+	  latency_mean(0),
+	  latency_median(0),
+	  latency_p95(0),
+	  latency_p99(0),
+	  latency_max(0),
+	  realtime_factor(0)
+{
+}
+
+CReactiveNavBatchSimulator::CReactiveNavBatchSimulator()
+	: mrpt::utils::COutputLogger("CReactiveNavBatchSimulator"),
+	  num_threads(0),
+	  m_last_run_time(0)
+{
+}
+
+void CReactiveNavBatchSimulator::runScenario(
+	const TScenario& sc, TResult& result, const std::string& ptg_cache_dir)
+{
+	result = TResult();
+	result.name = sc.name;
+	try
+	{
+		ASSERTMSG_(sc.map, "TScenario::map is empty");
+		ASSERT_ABOVE_(sc.sim_period, .0);
+
+		switch (sc.kinematics)
+		{
+			case kinDiffDriven:
+			{
+				mrpt::kinematics::CVehicleSimul_DiffDriven sim;
+				TBatchSimulRobotIF<
+					CRobot2NavInterfaceForSimulator_DiffDriven,
+					mrpt::kinematics::CVehicleSimul_DiffDriven>
+					rif(sim, sc);
+				simulateScenario(sim, rif, sc, result, ptg_cache_dir);
+			}
+			break;
+			case kinHolonomic:
+			{
+				mrpt::kinematics::CVehicleSimul_Holo sim;
+				TBatchSimulRobotIF<
+					CRobot2NavInterfaceForSimulator_Holo,
+					mrpt::kinematics::CVehicleSimul_Holo>
+					rif(sim, sc);
+				simulateScenario(sim, rif, sc, result, ptg_cache_dir);
+			}
+			break;
+			default:
+				THROW_EXCEPTION("Unknown kinematics model");
+		};
+	}
+	catch (std::exception& e)
+	{
+		result.success = false;
+		result.error_msg = e.what();
+	}
+}
+
+void CReactiveNavBatchSimulator::run(std::vector<TResult>& results)
+{
+	MRPT_START
+
+	results.clear();
+	results.resize(scenarios.size());
+
+	// (Each thread needs its own PTG cache directory, so the scenarios are
+	// not run with mrpt::utils::parallel_for_jobs())
+	const unsigned int nThreads = std::min<unsigned int>(
+		mrpt::utils::parallel_num_threads(num_threads), scenarios.size());
+
+	const std::string base_cache_dir =
+		!ptg_cache_directory.empty()
+			? ptg_cache_directory
+			: mrpt::system::extractFileDirectory(
+				  mrpt::system::getTempFileName());
+
+	MRPT_LOG_INFO_STREAM(
+		"Running " << scenarios.size() << " scenarios in " << nThreads
+				   << " threads...");
+
+	mrpt::utils::CTicTac tictac;
+	std::atomic<size_t> next_scenario(0);
+	auto worker = [&](const unsigned int worker_idx) {
+		const std::string cache_dir = mrpt::format(
+			"%s/rnav_batch_ptgs_%u", base_cache_dir.c_str(), worker_idx);
+		mrpt::system::createDirectory(cache_dir);
+		for (;;)
+		{
+			const size_t i = next_scenario++;
+			if (i >= scenarios.size()) break;
+			runScenario(scenarios[i], results[i], cache_dir);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < nThreads; t++)
+		threads.emplace_back(worker, t);
+	worker(0);  // Also use the calling thread
+	for (auto& t : threads) t.join();
+
+	m_last_run_time = tictac.Tac();
+
+	for (const auto& r : results)
+	{
+		if (!r.error_msg.empty())
+			MRPT_LOG_ERROR_FMT(
+				"Scenario `%s` failed: %s", r.name.c_str(),
+				r.error_msg.c_str());
+	}
+
+	MRPT_END
+}
+
+CReactiveNavBatchSimulator::TStatistics
+	CReactiveNavBatchSimulator::computeStatistics(
+		const std::vector<TResult>& results, const double batch_wall_time)
+{
+	TStatistics s;
+	s.num_scenarios = results.size();
+
+	std::vector<double> lats;
+	double total_sim_time = 0;
+	for (const auto& r : results)
+	{
+		if (r.success) s.num_success++;
+		if (r.collision) s.num_collisions++;
+		if (r.nav_error) s.num_nav_errors++;
+		if (r.timeout) s.num_timeouts++;
+		total_sim_time += r.sim_time;
+		lats.insert(lats.end(), r.step_latencies.begin(), r.step_latencies.end());
+	}
+	if (s.num_scenarios)
+		s.success_rate = double(s.num_success) / s.num_scenarios;
+
+	s.num_steps = lats.size();
+	if (!lats.empty())
+	{
+		std::sort(lats.begin(), lats.end());
+		double sum = 0;
+		for (const double l : lats) sum += l;
+		s.latency_mean = sum / lats.size();
+		s.latency_median = percentile(lats, 0.50);
+		s.latency_p95 = percentile(lats, 0.95);
+		s.latency_p99 = percentile(lats, 0.99);
+		s.latency_max = lats.back();
+	}
+	if (batch_wall_time > 0) s.realtime_factor = total_sim_time / batch_wall_time;
+	return s;
+}
@@ -0,0 +1,96 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/reactive/CReactiveNavBatchSimulator.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+
+using namespace mrpt;
+using namespace mrpt::nav;
+using mrpt::math::TPose2D;
+
+TEST(CReactiveNavBatchSimulator, run_parallel_scenarios)
+{
+	const std::string sFil =
+		mrpt::system::find_mrpt_shared_dir() +
+		std::string("config_files/navigation-ptgs/reactive2d_config.ini");
+	if (!mrpt::system::fileExists(sFil))
+	{
+		std::cerr << "**WARNING* Skipping tests since file cannot be found: '"
+				  << sFil << "'\n";
+		return;
+	}
+	std::ifstream f(sFil);
+	std::stringstream ss;
+	ss << f.rdbuf();
+
+	// One map shared by all scenarios: free space with a block obstacle.
+	auto grid = std::make_shared<mrpt::maps::COccupancyGridMap2D>(
+		-10.0f, 30.0f, -10.0f, 10.0f, 0.10f);
+	grid->fill(0.9f);
+	for (int xi = grid->x2idx(4.0); xi < grid->x2idx(5.0); xi++)
+		for (int yi = grid->y2idx(-2.0); yi < grid->y2idx(2.0); yi++)
+			grid->setCell(xi, yi, 0);
+
+	CReactiveNavBatchSimulator sim;
+	sim.setMinLoggingLevel(mrpt::utils::LVL_ERROR);
+	sim.num_threads = 2;
+	for (const auto& holo : {"CHolonomicVFF", "CHolonomicND",
+							 "CHolonomicFullEval"})
+	{
+		CReactiveNavBatchSimulator::TScenario s;
+		s.name = holo;
+		s.map = grid;
+		s.nav_config_text = ss.str();
+		s.holonomic_method = holo;
+		s.sim_period = 0.2;
+		s.max_sim_time = 60.0;
+		s.target = TPose2D(9.0, 4.0, 0);
+		s.occupied_threshold = 0.4f;
+		sim.scenarios.push_back(s);
+	}
+	// A scenario with an invalid navigator must fail without affecting others
+	{
+		CReactiveNavBatchSimulator::TScenario s = sim.scenarios.front();
+		s.name = "bad";
+		s.navigator_class = "CNonExistingNavigator";
+		sim.scenarios.push_back(s);
+	}
+
+	std::vector<CReactiveNavBatchSimulator::TResult> results;
+	sim.run(results);
+	ASSERT_EQ(results.size(), sim.scenarios.size());
+
+	for (size_t i = 0; i + 1 < results.size(); i++)
+	{
+		const auto& r = results[i];
+		EXPECT_EQ(r.name, sim.scenarios[i].name);
+		EXPECT_TRUE(r.success) << "Scenario: " << r.name
+							   << " error: " << r.error_msg;
+		EXPECT_FALSE(r.collision);
+		EXPECT_FALSE(r.step_latencies.empty());
+		EXPECT_GT(r.path_length, 9.0);
+	}
+	EXPECT_FALSE(results.back().success);
+	EXPECT_FALSE(results.back().error_msg.empty());
+
+	const auto stats = CReactiveNavBatchSimulator::computeStatistics(
+		results, sim.getLastRunTime());
+	EXPECT_EQ(stats.num_scenarios, results.size());
+	EXPECT_EQ(stats.num_success, results.size() - 1);
+	EXPECT_NEAR(
+		stats.success_rate, double(results.size() - 1) / results.size(),
+		1e-9);
+	EXPECT_LE(stats.latency_median, stats.latency_p95);
+	EXPECT_LE(stats.latency_p95, stats.latency_p99);
+	EXPECT_LE(stats.latency_p99, stats.latency_max);
+	EXPECT_GT(stats.realtime_factor, 0.0);
+}
@@ -37,7 +37,10 @@ CReactiveNavigationSystem3D::CReactiveNavigationSystem3D(
 	bool enableLogToFile, const std::string& logFileDirectory)
 	: CAbstractPTGBasedReactive(
 		  react_iterf_impl, enableConsoleOutput, enableLogToFile,
-		  logFileDirectory)
+		  logFileDirectory),
+	  m_obsgrid_size(0),
+	  m_obsgrid_resolution(0),
+	  m_obsgrid_t0(INVALID_TIMESTAMP)
 {
 }
 
@@ -77,6 +80,34 @@ void CReactiveNavigationSystem3D::saveConfigFile(
 
 	unsigned int PTG_COUNT = m_ptgmultilevel.size();
 	MRPT_SAVE_CONFIG_VAR_COMMENT(PTG_COUNT, "Number of PTGs");
+
+	params_reactive_nav_3d.saveToConfigFile(c, s);
+}
+
+void CReactiveNavigationSystem3D::TReactiveNavigator3DParams::
+	loadFromConfigFile(
+		const mrpt::utils::CConfigFileBase& c, const std::string& s)
+{
+	MRPT_LOAD_CONFIG_VAR_CS(obstacle_grid_resolution, double);
+	MRPT_LOAD_CONFIG_VAR_CS(obstacle_memory_time, double);
+}
+
+void CReactiveNavigationSystem3D::TReactiveNavigator3DParams::saveToConfigFile(
+	mrpt::utils::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		obstacle_grid_resolution,
+		"Cell size [m] of the obstacle grid (one per height level). 0=use "
+		"raw sensed points");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		obstacle_memory_time,
+		"Time [s] to remember obstacles after they were last sensed");
+}
+
+CReactiveNavigationSystem3D::TReactiveNavigator3DParams::
+	TReactiveNavigator3DParams()
+	: obstacle_grid_resolution(0.05), obstacle_memory_time(0.0)
+{
 }
 
 void CReactiveNavigationSystem3D::loadConfigFile(
@@ -114,6 +145,8 @@ void CReactiveNavigationSystem3D::loadConfigFile(
 	// ---------------------------------------------
 	// levels = m_robotShape.heights.size()
 
+	params_reactive_nav_3d.loadFromConfigFile(c, s);
+
 	unsigned int num_ptgs = c.read_int(s, "PTG_COUNT", 1, true);
 	m_ptgmultilevel.resize(num_ptgs);
 
@@ -220,6 +253,14 @@ bool CReactiveNavigationSystem3D::implementSenseObstacles(
 			return false;
 	}
 
+	if (params_reactive_nav_3d.obstacle_grid_resolution > 0)
+	{
+		updateObstacleGrid(obstacles_timestamp);
+		m_timelogger.leave("navigationStep.STEP2_LoadAndSortObstacle");
+		return true;
+	}
+
+	// No obstacle grid: sort the raw points.
 	// Empty slice maps:
 	const size_t nSlices = m_robotShape.size();
 	m_WS_Obstacles_inlevels.resize(nSlices);
@@ -260,6 +301,134 @@ bool CReactiveNavigationSystem3D::implementSenseObstacles(
 	return true;
 }
 
+void CReactiveNavigationSystem3D::updateObstacleGrid(
+	const mrpt::system::TTimeStamp obs_timestamp)
+{
+	const size_t nSlices = m_robotShape.size();
+	const double res = params_reactive_nav_3d.obstacle_grid_resolution;
+	const float OBS_MAX_XY = params_abstract_ptg_navigator.ref_distance * 1.1f;
+
+	// The grid must hold, without aliasing, all cells within the robot-local
+	// box of half-side OBS_MAX_XY, whatever the robot heading:
+	const int N = 2 + static_cast<int>(std::ceil(2 * M_SQRT2 * OBS_MAX_XY / res));
+	if (m_obsgrid.size() != nSlices || m_obsgrid_size != N ||
+		m_obsgrid_resolution != res)
+	{
+		m_obsgrid.assign(nSlices, TObstacleGridSlice());
+		TObstacleGridCell empty_cell;
+		empty_cell.cx = empty_cell.cy = std::numeric_limits<int32_t>::max();
+		empty_cell.last_seen = -std::numeric_limits<double>::max();
+		empty_cell.listed = false;
+		empty_cell.x = empty_cell.y = 0;
+		empty_cell.z = 0;
+		for (auto& sl : m_obsgrid) sl.cells.assign(N * N, empty_cell);
+		m_obsgrid_size = N;
+		m_obsgrid_resolution = res;
+	}
+
+	if (m_obsgrid_t0 == INVALID_TIMESTAMP) m_obsgrid_t0 = obs_timestamp;
+	const double t_now =
+		mrpt::system::timeDifference(m_obsgrid_t0, obs_timestamp);
+
+	// Sensed points are in the robot frame. The grid is kept in the odometry
+	// frame, which is free of localization jumps:
+	const mrpt::math::TPose2D& odo = m_curPoseVel.rawOdometry;
+	const double ccos = std::cos(odo.phi), csin = std::sin(odo.phi);
+
+	// Upper limit of each height slice:
+	std::vector<float> slice_top(nSlices);
+	float h = 0;
+	for (size_t i = 0; i < nSlices; i++)
+		slice_top[i] = (h += m_robotShape.getHeight(i));
+
+	const auto wrap = [N](const int32_t c) {
+		const int32_t m = c % N;
+		return m < 0 ? m + N : m;
+	};
+
+	// Insert new points:
+	size_t nPts;
+	const float *xs, *ys, *zs;
+	m_WS_Obstacles_unsorted.getPointsBuffer(nPts, xs, ys, zs);
+	for (size_t j = 0; j < nPts; j++)
+	{
+		if (zs[j] < 0.01) continue;  // skip this points
+		if (xs[j] <= -OBS_MAX_XY || xs[j] >= OBS_MAX_XY ||
+			ys[j] <= -OBS_MAX_XY || ys[j] >= OBS_MAX_XY)
+			continue;
+		const size_t idxH =
+			std::upper_bound(slice_top.begin(), slice_top.end(), zs[j]) -
+			slice_top.begin();
+		if (idxH >= nSlices) continue;  // Above the robot
+
+		const double gx = odo.x + ccos * xs[j] - csin * ys[j];
+		const double gy = odo.y + csin * xs[j] + ccos * ys[j];
+		const int32_t cx = static_cast<int32_t>(std::floor(gx / res));
+		const int32_t cy = static_cast<int32_t>(std::floor(gy / res));
+
+		TObstacleGridSlice& sl = m_obsgrid[idxH];
+		const uint32_t idx = wrap(cx) + N * wrap(cy);
+		TObstacleGridCell& cell = sl.cells[idx];
+		cell.cx = cx;
+		cell.cy = cy;
+		cell.last_seen = t_now;
+		cell.x = gx;
+		cell.y = gy;
+		cell.z = zs[j];
+		if (!cell.listed)
+		{
+			cell.listed = true;
+			sl.occupied.push_back(idx);
+		}
+	}
+
+	// Build the per-slice obstacle lists, dropping cells that expired or
+	// are now too far from the robot:
+	m_WS_Obstacles_inlevels.resize(nSlices);
+	for (size_t i = 0; i < nSlices; i++)
+	{
+		TObstacleGridSlice& sl = m_obsgrid[i];
+		mrpt::maps::CSimplePointsMap& pts = m_WS_Obstacles_inlevels[i];
+		pts.clear();
+		pts.reserve(sl.occupied.size());
+
+		size_t n = 0;
+		for (const uint32_t idx : sl.occupied)
+		{
+			TObstacleGridCell& cell = sl.cells[idx];
+			if (t_now - cell.last_seen >
+				params_reactive_nav_3d.obstacle_memory_time)
+			{
+				cell.listed = false;
+				continue;
+			}
+			const double dx = cell.x - odo.x;
+			const double dy = cell.y - odo.y;
+			const double lx = ccos * dx + csin * dy;
+			const double ly = -csin * dx + ccos * dy;
+			if (lx <= -OBS_MAX_XY || lx >= OBS_MAX_XY || ly <= -OBS_MAX_XY ||
+				ly >= OBS_MAX_XY)
+			{
+				cell.listed = false;
+				continue;
+			}
+			sl.occupied[n++] = idx;
+			pts.insertPointFast(lx, ly, cell.z);
+		}
+		sl.occupied.resize(n);
+		pts.mark_as_modified();
+	}
+}
+
+void CReactiveNavigationSystem3D::onStartNewNavigation()
+{
+	// Odometry might have been reset, forget past obstacles:
+	m_obsgrid.clear();
+	m_obsgrid_t0 = INVALID_TIMESTAMP;
+
+	CAbstractPTGBasedReactive::onStartNewNavigation();
+}
+
 /*************************************************************************
 		Transform the obstacle into TP-Obstacles in TP-Spaces
 *************************************************************************/
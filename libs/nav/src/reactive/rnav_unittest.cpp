@@ -24,7 +24,8 @@ void run_rnav_test(
 	const TPoint2D& nav_target, const TPoint2D& world_topleft,
 	const TPoint2D& world_rightbottom,
 	const TPoint2D& block_obstacle_topleft = TPoint2D(0, 0),
-	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0))
+	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0),
+	const double obstacle_memory_time_3d = 0)
 {
 	using namespace std;
 	using namespace mrpt;
@@ -43,6 +44,10 @@ void run_rnav_test(
 
 	mrpt::utils::CConfigFile cfg(sFil);
 	cfg.write("CAbstractPTGBasedReactive", "holonomic_method", sHoloMethod);
+	if (obstacle_memory_time_3d > 0)
+		cfg.write(
+			"CReactiveNavigationSystem3D", "obstacle_memory_time",
+			obstacle_memory_time_3d);
 	cfg.discardSavingChanges();
 
 	// Create a grid map with a synthetic test environment with a simple
@@ -250,3 +255,10 @@ TEST(CReactiveNavigationSystem3D, with_obstacle_nav_FullEval)
 		"reactive3d_config.ini", "CHolonomicFullEval", with_obs_trg,
 		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br);
 }
+TEST(CReactiveNavigationSystem3D, with_obstacle_nav_FullEval_obstacle_memory)
+{
+	run_rnav_test<mrpt::nav::CReactiveNavigationSystem3D>(
+		"reactive3d_config.ini", "CHolonomicFullEval", with_obs_trg,
+		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br,
+		2.0 /*obstacle_memory_time*/);
+}
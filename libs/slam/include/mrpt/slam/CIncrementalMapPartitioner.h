@@ -96,6 +96,15 @@ class SLAM_IMPEXP CIncrementalMapPartitioner
 		 */
 		int minimumNumberElementsEachCluster;
 
+		/** If set to true (default), partitions are computed on a sparse
+		 * version of the adjacency matrix (only the links with a non-zero
+		 * weight), with a multilevel Lanczos eigen-solver which scales to
+		 * thousands of nodes. Otherwise, the dense O(n^3) eigen-decomposition
+		 * is used.
+		 * \sa mrpt::graphs::CGraphPartitioner
+		 */
+		bool useSparsePartitioner;
+
 	} options;
 
 	/**\name Add to the Map Frames
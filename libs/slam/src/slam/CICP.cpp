@@ -1047,7 +1047,7 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 {
 	MRPT_START
 
-	static CTicTac tictac;
+	CTicTac tictac;
 	TReturnInfo outInfo;
 	CPose3DPDF::Ptr resultPDF;
 
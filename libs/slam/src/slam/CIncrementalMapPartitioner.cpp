@@ -64,7 +64,8 @@ CIncrementalMapPartitioner::TOptions::TOptions()
 	  minMahaDistForCorrespondence(2.0f),
 	  forceBisectionOnly(false),
 	  useMapMatching(true),
-	  minimumNumberElementsEachCluster(1)
+	  minimumNumberElementsEachCluster(1),
+	  useSparsePartitioner(true)
 {
 }
 
@@ -83,6 +84,7 @@ void CIncrementalMapPartitioner::TOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(useMapMatching, bool, source, section);
 	MRPT_LOAD_CONFIG_VAR(
 		minimumNumberElementsEachCluster, int, source, section);
+	MRPT_LOAD_CONFIG_VAR(useSparsePartitioner, bool, source, section);
 
 	MRPT_END
 }
@@ -113,6 +115,9 @@ void CIncrementalMapPartitioner::TOptions::dumpToTextStream(
 	out.printf(
 		"minimumNumberElementsEachCluster        = %i\n",
 		minimumNumberElementsEachCluster);
+	out.printf(
+		"useSparsePartitioner                    = %c\n",
+		useSparsePartitioner ? 'Y' : 'N');
 }
 
 /*---------------------------------------------------------------
@@ -413,28 +418,53 @@ void CIncrementalMapPartitioner::updatePartitions(
 
 	if (mods.size() > 0)
 	{
+		// Partitions of the modified nodes
+		vector<vector_uint> mods_parts;
+		mods_parts.clear();
+
 		// Construct submatrix of adjacencies only with the nodes that are going
 		// to be regrouped
 		// -------------------------------------------------------------------
-		CMatrix A_mods;
-		A_mods.setSize(mods.size(), mods.size());
-		for (i = 0; i < mods.size(); i++)
+		if (options.useSparsePartitioner)
 		{
+			// Only the existing links:
+			std::vector<Eigen::Triplet<float>> links;
 			for (j = 0; j < mods.size(); j++)
 			{
-				A_mods(i, j) = m_A(mods[i], mods[j]);
+				for (i = 0; i < mods.size(); i++)
+				{
+					const double w = m_A(mods[i], mods[j]);
+					if (w != 0) links.push_back(Eigen::Triplet<float>(i, j, w));
+				}
 			}
+			CGraphPartitioner<CMatrix>::sparse_matrix_t A_mods(
+				mods.size(), mods.size());
+			A_mods.setFromTriplets(links.begin(), links.end());
+
+			CGraphPartitioner<CMatrix>::RecursiveSpectralPartition(
+				A_mods, mods_parts, options.partitionThreshold, true,
+				!options.forceBisectionOnly,
+				options.minimumNumberElementsEachCluster, false /* verbose */
+				);
 		}
+		else
+		{
+			CMatrix A_mods;
+			A_mods.setSize(mods.size(), mods.size());
+			for (i = 0; i < mods.size(); i++)
+			{
+				for (j = 0; j < mods.size(); j++)
+				{
+					A_mods(i, j) = m_A(mods[i], mods[j]);
+				}
+			}
 
-		// Partitions of the modified nodes
-		vector<vector_uint> mods_parts;
-		mods_parts.clear();
-
-		CGraphPartitioner<CMatrix>::RecursiveSpectralPartition(
-			A_mods, mods_parts, options.partitionThreshold, true, true,
-			!options.forceBisectionOnly,
-			options.minimumNumberElementsEachCluster, false /* verbose */
-			);
+			CGraphPartitioner<CMatrix>::RecursiveSpectralPartition(
+				A_mods, mods_parts, options.partitionThreshold, true, true,
+				!options.forceBisectionOnly,
+				options.minimumNumberElementsEachCluster, false /* verbose */
+				);
+		}
 
 		// Aggregate the results with the clusters that were not used and return
 		// them
@@ -20,6 +20,7 @@ MRPT_WARNING(
 
 #include <mrpt/vision/utils.h>
 #include <mrpt/vision/TSimpleFeature.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 #include <mrpt/vision/multiDesc_utils.h>
 #include <mrpt/vision/chessboard_camera_calib.h>
 #include <mrpt/vision/chessboard_stereo_camera_calib.h>
@@ -32,8 +33,10 @@ MRPT_WARNING(
 #include <mrpt/vision/descriptor_kdtrees.h>
 #include <mrpt/vision/descriptor_pairing.h>
 #include <mrpt/vision/bundle_adjustment.h>
+#include <mrpt/vision/TRemapLUT.h>
 #include <mrpt/vision/CUndistortMap.h>
 #include <mrpt/vision/CStereoRectifyMap.h>
+#include <mrpt/vision/CStereoSGM.h>
 #include <mrpt/vision/CImagePyramid.h>
 #include <mrpt/vision/CDifodo.h>
 
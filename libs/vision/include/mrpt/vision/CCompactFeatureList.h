@@ -0,0 +1,176 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef mrpt_vision_CCompactFeatureList_H
+#define mrpt_vision_CCompactFeatureList_H
+
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/utils/aligned_containers.h>
+#include <algorithm>
+
+namespace mrpt
+{
+namespace vision
+{
+/** \addtogroup  mrptvision_features
+	@{ */
+
+/** A set of visual descriptors of one type, one per row, stored in a single
+ * contiguous block of memory.
+  * Each row starts at a 16-byte aligned address and is padded with zeros up
+ * to stride() elements, so SIMD distance kernels may process whole rows (the
+ * zero padding does not change L2 nor Hamming distances).
+  * \sa CCompactFeatureList
+  */
+template <typename T>
+class TDescriptorMatrix
+{
+   public:
+	typedef T value_type;
+
+	TDescriptorMatrix() : m_rows(0), m_cols(0), m_stride(0) {}
+	/** Number of descriptors */
+	inline size_t rows() const { return m_rows; }
+	/** Length of the descriptors (0 if there are none) */
+	inline size_t cols() const { return m_cols; }
+	/** Number of elements from the start of a row to the next one */
+	inline size_t stride() const { return m_stride; }
+	/** Whether there are no descriptors of this type */
+	inline bool empty() const { return m_cols == 0; }
+	/** Sets the number of descriptors and their length, all set to zero */
+	void resize(const size_t rows, const size_t cols)
+	{
+		m_rows = rows;
+		m_cols = cols;
+		m_stride =
+			(cols + ALIGN_ELEMENTS - 1) / ALIGN_ELEMENTS * ALIGN_ELEMENTS;
+		m_data.assign(m_rows * m_stride, T(0));
+	}
+	/** Changes the number of descriptors, keeping the first ones (the new
+	 * ones are set to zero) */
+	void resizeRows(const size_t rows)
+	{
+		m_rows = rows;
+		m_data.resize(m_rows * m_stride, T(0));
+	}
+	void reserveRows(const size_t rows) { m_data.reserve(rows * m_stride); }
+	void clear() { resize(0, 0); }
+	/** Pointer to the i'th descriptor */
+	inline T* operator[](const size_t i) { return &m_data[i * m_stride]; }
+	inline const T* operator[](const size_t i) const
+	{
+		return &m_data[i * m_stride];
+	}
+	/** Copies a descriptor of length cols() into the i'th row */
+	void setRow(const size_t i, const std::vector<T>& desc)
+	{
+		ASSERT_EQUAL_(desc.size(), m_cols);
+		std::copy(desc.begin(), desc.end(), (*this)[i]);
+	}
+	/** Copies the i'th descriptor into a vector */
+	void getRow(const size_t i, std::vector<T>& desc) const
+	{
+		desc.assign((*this)[i], (*this)[i] + m_cols);
+	}
+
+   private:
+	/** Elements in 16 bytes (the length of rows is a multiple of this) */
+	static const size_t ALIGN_ELEMENTS =
+		sizeof(T) >= 16 ? 1 : 16 / sizeof(T);
+
+	size_t m_rows, m_cols, m_stride;
+	typename mrpt::aligned_containers<T>::vector_t m_data;
+};
+
+/** A list of visual features stored as a structure of arrays: one array for
+ * each field of the keypoints, and one contiguous TDescriptorMatrix for each
+ * type of descriptor.
+  * Detectors, matchers and KD-trees can go through these arrays directly,
+ * instead of following a pointer to a CFeature object (and then, to the
+ * vector of each descriptor) per feature as with CFeatureList.
+  *
+  * Only the SIFT, SURF and ORB descriptors are stored, and image patches are
+ * not. Use assign() and getAsFeatureList() to convert from and to
+ * CFeatureList.
+  *
+  * \sa CFeatureList, matchFeatures(), TSIFTDescriptorsKDTreeIndex,
+ * CFeatureExtraction::detectFeatures()
+  */
+class VISION_IMPEXP CCompactFeatureList
+{
+   public:
+	/** @name Keypoints (all these arrays have size() elements)
+		@{ */
+	/** Coordinates in the image */
+	std::vector<float> x, y;
+	std::vector<TFeatureID> ID;
+	std::vector<TFeatureType> type;
+	std::vector<TFeatureTrackStatus> track_status;
+	std::vector<float> response;
+	std::vector<float> orientation;
+	std::vector<float> scale;
+	/** @} */
+
+	/** @name Descriptors (either one per feature, or none)
+		@{ */
+	TDescriptorMatrix<uint8_t> SIFT;
+	TDescriptorMatrix<float> SURF;
+	TDescriptorMatrix<uint8_t> ORB;
+	/** @} */
+
+	/** Default constructor: an empty list */
+	CCompactFeatureList() {}
+	/** Constructor from a list of features. \sa assign */
+	explicit CCompactFeatureList(
+		const CFeatureList& feats,
+		const unsigned int descriptors = descSIFT | descSURF | descORB)
+	{
+		assign(feats, descriptors);
+	}
+
+	inline size_t size() const { return x.size(); }
+	inline bool empty() const { return x.empty(); }
+	/** Removes all the features, and the descriptor lengths */
+	void clear();
+	/** Sets the number of features. New features have all their fields and
+	 * descriptors set to zero */
+	void resize(const size_t N);
+	void reserve(const size_t N);
+	/** Appends a feature. Its descriptors must have the same length than
+	 * those of the list, or the list must be empty. */
+	void push_back(const CFeature& f);
+
+	/** Copies a list of features. The descriptors of the types in \a
+	 * descriptors (a bitwise OR of mrpt::vision::TDescriptorType values) are
+	 * copied if all the features have them, with the same length.
+	 * \exception std::exception If only some of the features have one of
+	 * those descriptors, or their lengths differ. */
+	void assign(
+		const CFeatureList& feats,
+		const unsigned int descriptors = descSIFT | descSURF | descORB);
+	/** Replaces the contents of \a feats with new CFeature objects with the
+	 * data of this list (without patches) */
+	void getAsFeatureList(CFeatureList& feats) const;
+
+	/** The type of the first feature in the list */
+	inline TFeatureType get_type() const
+	{
+		return empty() ? featNotDefined : type[0];
+	}
+	/** Whether the features have this kind of descriptor */
+	inline bool hasDescriptorSIFT() const { return !SIFT.empty(); }
+	/** Whether the features have this kind of descriptor */
+	inline bool hasDescriptorSURF() const { return !SURF.empty(); }
+	/** Whether the features have this kind of descriptor */
+	inline bool hasDescriptorORB() const { return !ORB.empty(); }
+};
+
+/** @} */  // End of add to module: mrptvision_features
+}
+}
+#endif
@@ -56,6 +56,13 @@ namespace vision
   * - DIC/2014: Reformulated and improved. The class now needs Eigen version
   *3.1.0 or above.
   *
+  *	The per-pixel stages (pyramid, warping, coordinates, derivatives, weights
+  *and the filling of the least-squares system) run in parallel on blocks of
+  *columns, with Eigen array expressions over the (contiguous) columns, in
+  *\a num_threads threads. The warping, the "average" coordinates and the
+  *temporal derivative are computed in a single pass. The execution time of
+  *each stage is kept in \a stage_times.
+  *
   *  \sa CDifodoCamera, CDifodoDatasets
   *  \ingroup mrpt_vision_grp
   */
@@ -146,6 +153,17 @@ class VISION_IMPEXP CDifodo
 	/**Default 0.5 */
 	float previous_speed_eig_weight;
 
+	/** Aux buffers of the per-pixel stages, kept between calls to avoid
+	 * reallocating them: warped image coordinates (-1 if out of the image)
+	 * and depth of each pixel, accumulated warped weights and connectivity
+	 * (rx_ninv, ry_ninv) */
+	Eigen::MatrixXf m_warp_u, m_warp_v, m_warp_d, m_warp_weights;
+	Eigen::MatrixXf m_rx_ninv, m_ry_ninv;
+	/** Accumulators of the warped depths and weights of each block of
+	 * columns, and range of target columns they cover */
+	std::vector<std::vector<float>> m_splat_acc;
+	std::vector<int> m_splat_first_col, m_splat_last_col;
+
 	/** Transformations of the coarse-to-fine levels */
 	std::vector<Eigen::MatrixXf> transformations;
 
@@ -169,11 +187,26 @@ class VISION_IMPEXP CDifodo
 	void performWarping();
 
 	/** Calculate the "average" coordinates of the points observed by the camera
-	 * between two consecutive frames and find the Null measurements */
+	 * between two consecutive frames, find the Null measurements and compute
+	 * the temporal depth derivative (dt) */
 	void calculateCoord();
 
-	/** Calculates the depth derivatives respect to u,v (rows and cols) and t
-	 * (time) */
+	/** Fused version of performWarping() followed by calculateCoord(): the
+	 * warped depths of each pixel are gathered, normalized and used for the
+	 * "average" coordinates and dt in a single pass */
+	void performWarpingAndCoord();
+
+	/** Transforms and projects the points, and accumulates the warped depths
+	 * of each block of columns (first part of performWarping()) */
+	void warpPoints();
+
+	/** Gathers the warped depths accumulated by warpPoints() (if \a
+	 * finish_warping) and/or computes the coordinates of calculateCoord()
+	 * (if \a coord) */
+	void finishWarpingAndCoord(const bool finish_warping, const bool coord);
+
+	/** Calculates the depth derivatives respect to u,v (rows and cols). The
+	 * derivative respect to t (time) is computed by calculateCoord() */
 	void calculateDepthDerivatives();
 
 	/** This method computes the weighting fuction associated to measurement and
@@ -211,6 +244,39 @@ class VISION_IMPEXP CDifodo
 	/** Execution time (ms) */
 	float execution_time;
 
+	/** Execution times (ms) of the stages of the last odometryCalculation(),
+	 * summed over the coarse-to-fine levels */
+	struct TStageTimes
+	{
+		TStageTimes()
+			: pyramid(0),
+			  warping(0),
+			  derivatives(0),
+			  weights(0),
+			  solver(0),
+			  filter(0)
+		{
+		}
+
+		/** Gaussian pyramid */
+		float pyramid;
+		/** Warping, "average" coordinates and temporal derivative */
+		float warping;
+		/** Spatial derivatives */
+		float derivatives;
+		/** Weights of the range flow constraints */
+		float weights;
+		/** Least-squares system and its solution */
+		float solver;
+		/** Velocity filter and pose update */
+		float filter;
+	};
+	TStageTimes stage_times;
+
+	/** Number of threads of the per-pixel stages (0: as many as cores, the
+	 * default). Results do not depend on it. */
+	unsigned int num_threads;
+
 	/** Camera poses */
 	/** Last camera pose */
 	mrpt::poses::CPose3D cam_pose;
@@ -222,6 +288,10 @@ class VISION_IMPEXP CDifodo
 		and updates the camera pose */
 	void odometryCalculation();
 
+	/** Print (to std::cout) the runtime of the last odometryCalculation(),
+	 * and of each of its stages (see \a stage_times) */
+	void printRuntime() const;
+
 	/** Get the rows and cols of the depth image that are considered by the
 	 * visual odometry method. */
 	inline void getRowsAndCols(
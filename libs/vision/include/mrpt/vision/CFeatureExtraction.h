@@ -13,6 +13,7 @@
 #include <mrpt/utils/CTicTac.h>
 #include <mrpt/vision/utils.h>
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 #include <mrpt/vision/TSimpleFeature.h>
 
 namespace mrpt
@@ -66,6 +67,12 @@ namespace vision
   *2D log-polar image centered at the interest point.
   *
   *
+  *  With TOptions::multiScaleOptions, detectFeatures() builds an image
+  *pyramid and runs the detector on all its octaves in parallel. The FASTER
+  *detectors are also run in parallel on square tiles of each octave, with
+  *non-maximum suppression of the FAST score (TOptions::FASTOptions) and an
+  *AVX2 version of the corner test if MRPT is built with AVX2.
+  *
   *  Apart from the normal entry point \a detectFeatures(), these other
   *low-level static methods are provided for convenience:
   *   - CFeatureExtraction::detectFeatures_SSE2_FASTER9()
@@ -276,6 +283,32 @@ class VISION_IMPEXP CFeatureExtraction
 			 * with:  W=num_angles,  H= rho_scale * log(radius) */
 			double rho_scale;
 		} LogPolarImagesOptions;
+
+		/** Multi-scale detection options (see detectFeatures())
+		  */
+		struct VISION_IMPEXP TMultiScaleOptions
+		{
+			/** (default=false) Whether detectFeatures() runs the detector on
+			 * all the octaves of an image pyramid, in parallel */
+			bool enabled;
+			/** (default=3) Number of octaves of the pyramid, including the
+			 * original image */
+			unsigned int nOctaves;
+			/** (default=true) Whether each octave is smoothed before halving
+			 * it (see CImagePyramid::buildPyramid) */
+			bool smooth_halves;
+			/** (default=0) Number of threads, or 0 to use as many as CPU
+			 * cores */
+			unsigned int num_threads;
+			/** (default=128) Size of the square tiles in which each octave is
+			 * split, in pixels of that octave (only for the FASTER detectors)
+			 */
+			unsigned int tile_size;
+			/** (default=64) Size of the cells of the grid used to spread the
+			 * features over the image when only \a nDesiredFeatures are
+			 * kept, in pixels of the original image (0: no grid) */
+			unsigned int grid_cell_size;
+		} multiScaleOptions;
 	};
 
 	/** Set all the parameters of the desired method here before calling
@@ -297,6 +330,11 @@ class VISION_IMPEXP CFeatureExtraction
 	* \param nDesiredFeatures (op. input) Number of features to be extracted.
 	* Default: all possible.
 	*
+	* If options.multiScaleOptions.enabled, the features of all the octaves of
+	* an image pyramid are returned sorted by decreasing response, with their
+	* coordinates in the original image and their octave in CFeature::scale
+	* (1, 2, 4...), and \a ROI is ignored. See extractFeaturesMultiScale().
+	*
 	* \sa computeDescriptors
 	*/
 	void detectFeatures(
@@ -332,6 +370,30 @@ class VISION_IMPEXP CFeatureExtraction
 		const mrpt::utils::CImage& in_img, CFeatureList& inout_features,
 		TDescriptorType in_descriptor_list) const;
 
+	/** Extract features from the image into a list stored as contiguous
+	 * arrays (see CCompactFeatureList), as detectFeatures() for CFeatureList.
+	 * ORB features and descriptors are written directly into the arrays; the
+	 * rest of detectors go through a temporary CFeatureList. No patches are
+	 * extracted.
+	 * \sa computeDescriptors
+	 */
+	void detectFeatures(
+		const mrpt::utils::CImage& img, CCompactFeatureList& feats,
+		const unsigned int init_ID = 0, const unsigned int nDesiredFeatures = 0,
+		const TImageROI& ROI = TImageROI()) const;
+
+	/** Compute SIFT, SURF and/or ORB descriptors for a list of features
+	 * stored as contiguous arrays (see CCompactFeatureList), as
+	 * computeDescriptors() for CFeatureList. ORB descriptors are written
+	 * directly into CCompactFeatureList::ORB; the rest go through a
+	 * temporary CFeatureList.
+	 * \exception std::exception For other descriptors, which cannot be
+	 * stored in a CCompactFeatureList.
+	 */
+	void computeDescriptors(
+		const mrpt::utils::CImage& in_img, CCompactFeatureList& inout_features,
+		TDescriptorType in_descriptor_list) const;
+
 #if 0  // Delete? see comments in .cpp
 			/** Extract more features from the image (apart from the provided ones) based on the method defined in TOptions.
 			* \param img (input) The image from where to extract the images.
@@ -435,6 +497,10 @@ class VISION_IMPEXP CFeatureExtraction
 	*/
 	void internal_computeORBDescriptors(
 		const mrpt::utils::CImage& in_img, CFeatureList& in_features) const;
+	/** \overload */
+	void internal_computeORBDescriptors(
+		const mrpt::utils::CImage& in_img,
+		CCompactFeatureList& in_features) const;
 
 	/** Compute the intensity-domain spin images descriptor of the provided
 	* features into the input image
@@ -497,6 +563,18 @@ class VISION_IMPEXP CFeatureExtraction
 		unsigned int init_ID = 0, unsigned int nDesiredFeatures = 0,
 		const TImageROI& ROI = TImageROI()) const;
 
+	/** Multi-scale detection (see TOptions::multiScaleOptions): builds an
+	* image pyramid and runs the detector on all its octaves in parallel (the
+	* FASTER detectors, on tiles of each octave). Then, all the features are
+	* sorted by response and, if \a nDesiredFeatures is not zero, the best
+	* ones are kept giving each cell of a grid over the image at most its
+	* share of them before taking the rest.
+	*/
+	void extractFeaturesMultiScale(
+		const mrpt::utils::CImage& img, CFeatureList& feats,
+		const unsigned int init_ID = 0,
+		const unsigned int nDesiredFeatures = 0) const;
+
 	// ------------------------------------------------------------------------------------
 	//											BCD
 	// ------------------------------------------------------------------------------------
@@ -540,6 +618,11 @@ class VISION_IMPEXP CFeatureExtraction
 		const mrpt::utils::CImage& img, CFeatureList& feats,
 		const unsigned int init_ID = 0, const unsigned int nDesiredFeatures = 0,
 		const TImageROI& ROI = TImageROI()) const;
+	/** \overload */
+	void extractFeaturesORB(
+		const mrpt::utils::CImage& img, CCompactFeatureList& feats,
+		const unsigned int init_ID = 0, const unsigned int nDesiredFeatures = 0,
+		const TImageROI& ROI = TImageROI()) const;
 
 	// ------------------------------------------------------------------------------------
 	//											SURF
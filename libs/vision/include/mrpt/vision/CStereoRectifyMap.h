@@ -13,6 +13,7 @@
 #include <mrpt/utils/CImage.h>
 #include <mrpt/obs/CObservationStereoImages.h>
 #include <mrpt/poses/CPose3DQuat.h>
+#include <mrpt/vision/TRemapLUT.h>
 
 #include <mrpt/vision/link_pragmas.h>
 
@@ -35,6 +36,13 @@ namespace vision
   *  original images, which can be retrieved with \a getRectifiedImageParams()
   *
   *  Works with grayscale or color images.
+  *
+  *  The rectification maps are fixed-point look-up tables (see TRemapLUT).
+ * With nearest neighbor or bilinear interpolation (the default), 8 bit images
+ * with 1 or 3 channels are remapped without OpenCV, by blocks of rows of both
+ * images at once in parallel (see \a setNumThreads()); other interpolation
+ * methods and image formats use OpenCV's remap(). OpenCV is still needed to
+ * compute the rectifying rotations and projections in \a setFromCamParams().
   *
   *  Refer to the program stereo-calib-gui for a tool that generates the
  * required stereo camera parameters
@@ -89,7 +97,7 @@ class VISION_IMPEXP CStereoRectifyMap
 	  *  Can be used within loops to determine the first usage of the object and
 	 * when it needs to be initialized.
 	  */
-	inline bool isSet() const { return !m_dat_mapx_left.empty(); }
+	inline bool isSet() const { return !m_lut_left.empty(); }
 	/** Prepares the mapping from the intrinsic, distortion and relative pose
 	 * parameters of a stereo camera.
 	  * Must be called before invoking \a rectify().
@@ -164,7 +172,9 @@ class VISION_IMPEXP CStereoRectifyMap
 	}
 
 	/** Change remap interpolation method (default=Lineal). This parameter can
-	 * be safely changed at any instant without consequences. */
+	 * be safely changed at any instant without consequences. Only
+	 * IMG_INTERP_NN and IMG_INTERP_LINEAR use the native (and faster)
+	 * implementation. */
 	void setInterpolationMethod(const mrpt::utils::TInterpolationMethod interp)
 	{
 		m_interpolation_method = interp;
@@ -202,14 +212,28 @@ class VISION_IMPEXP CStereoRectifyMap
 	{
 		return m_rot_right;
 	}
-	/** Direct input access to rectify maps */
+	/** Sets the number of threads for \a rectify() (default=0: as many as
+	 * cores). This parameter can be safely changed at any instant. */
+	void setNumThreads(unsigned int num_threads)
+	{
+		m_num_threads = num_threads;
+	}
+	/** \sa setNumThreads */
+	unsigned int getNumThreads() const { return m_num_threads; }
+	/** Direct access to the rectify maps of the left/right images */
+	const TRemapLUT& getLeftRectifyMap() const { return m_lut_left; }
+	/** \sa getLeftRectifyMap */
+	const TRemapLUT& getRightRectifyMap() const { return m_lut_right; }
+	/** Direct input access to rectify maps, in OpenCV's fixed-point format
+	 * (CV_16SC2 + CV_16UC1). The sizes of the source and rectified images are
+	 * taken from the current camera parameters and \a enableResizeOutput(). */
 	void setRectifyMaps(
 		const std::vector<int16_t>& left_x, const std::vector<uint16_t>& left_y,
 		const std::vector<int16_t>& right_x,
 		const std::vector<uint16_t>& right_y);
 
-	/** Direct input access to rectify maps. This method swaps the vectors so
-	 * the inputs are no longer available.*/
+	/** Direct input access to rectify maps. Like \a setRectifyMaps(), but
+	 * the input vectors are cleared (they are no longer available).*/
 	void setRectifyMapsFast(
 		std::vector<int16_t>& left_x, std::vector<uint16_t>& left_y,
 		std::vector<int16_t>& right_x, std::vector<uint16_t>& right_y);
@@ -246,6 +270,8 @@ class VISION_IMPEXP CStereoRectifyMap
 	 * rectification.
 	  * The only reason not to enable this cache is when multiple threads can
 	 * invoke this method simultaneously.
+	  * \note With the cache, the rectified images are swapped (not copied)
+	 * into \a left_image and \a right_image.
 	  */
 	void rectify(
 		mrpt::utils::CImage& left_image, mrpt::utils::CImage& right_image,
@@ -274,7 +300,9 @@ class VISION_IMPEXP CStereoRectifyMap
 
 	/** Just like rectify() but directly works with OpenCV's "IplImage*", which
 	 * must be passed as "void*" to avoid header dependencies
-	  *  Output images CANNOT coincide with the input images. */
+	  *  Output images CANNOT coincide with the input images. They must have
+	 * the size of the rectified images, and the depth and number of channels
+	 * of the inputs. */
 	void rectify_IPL(
 		const void* in_left_image, const void* in_right_image,
 		void* out_left_image, void* out_right_image) const;
@@ -287,12 +315,12 @@ class VISION_IMPEXP CStereoRectifyMap
 	bool m_enable_both_centers_coincide;
 	mrpt::utils::TImageSize m_resize_output_value;
 	mrpt::utils::TInterpolationMethod m_interpolation_method;
+	unsigned int m_num_threads;
 
 	/** Memory caches for in-place rectification speed-up. */
 	mutable mrpt::utils::CImage m_cache1, m_cache2;
 
-	std::vector<int16_t> m_dat_mapx_left, m_dat_mapx_right;
-	std::vector<uint16_t> m_dat_mapy_left, m_dat_mapy_right;
+	TRemapLUT m_lut_left, m_lut_right;
 
 	/** A copy of the data provided by the user */
 	mrpt::utils::TStereoCamera m_camera_params;
@@ -0,0 +1,155 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef mrpt_vision_CStereoSGM_H
+#define mrpt_vision_CStereoSGM_H
+
+#include <mrpt/utils/CImage.h>
+#include <mrpt/utils/CLoadableOptions.h>
+#include <mrpt/math/CMatrixTemplateNumeric.h>
+#include <mrpt/obs/CObservationStereoImages.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+
+#include <mrpt/vision/link_pragmas.h>
+
+namespace mrpt
+{
+namespace vision
+{
+/** Dense stereo matching with Semi-Global Matching (SGM, H. Hirschmuller,
+ * 2008) of rectified stereo images.
+  *
+  *  The pipeline is:
+  *  - Census transform of both images, in a 9x7 window (62 bits per pixel).
+  *  - Matching costs: Hamming distance between the census of each left pixel
+ * and those of the right pixels in its disparity range.
+  *  - Cost aggregation along 4 or 8 directions (see TOptions::num_paths),
+ * with penalties P1 (disparity changes of one pixel) and P2 (larger ones).
+ * Each direction is split into independent scanlines which are processed in
+ * parallel, with SSE2/AVX2 kernels over the disparities.
+  *  - Winner-takes-all disparity, with a uniqueness test, a left-right
+ * consistency check and sub-pixel refinement (parabola fit), by rows in
+ * parallel.
+  *
+  *  Results do not depend on the number of threads. Memory usage is about
+ * 3 bytes per pixel and disparity.
+  *
+  *  \a computeRangeScan() converts the disparity of a rectified
+ * mrpt::obs::CObservationStereoImages into the depth image of a
+ * mrpt::obs::CObservation3DRangeScan, which can be then used as those of
+ * RGB-D cameras (e.g. project3DPointsFromDepthImageInto()).
+  *
+  * Example of usage:
+  * \code
+  *   CStereoRectifyMap  rectify_map;
+  *   CStereoSGM         sgm;
+  *   sgm.options.num_disparities = 96;
+  *
+  *   CObservationStereoImages::Ptr obs = ...  // Grab stereo pair
+  *   if (!rectify_map.isSet()) rectify_map.setFromCamParams(*obs);
+  *   rectify_map.rectify(*obs);
+  *
+  *   CObservation3DRangeScan obs3D;
+  *   sgm.computeRangeScan(*obs, obs3D);
+  * \endcode
+  *
+  * \sa CStereoRectifyMap
+  * \ingroup mrpt_vision_grp
+  */
+class VISION_IMPEXP CStereoSGM
+{
+   public:
+	/** Disparity of the pixels without a valid match */
+	static const float INVALID_DISPARITY;
+
+	struct VISION_IMPEXP TOptions : public mrpt::utils::CLoadableOptions
+	{
+		TOptions();
+
+		void loadFromConfigFile(
+			const mrpt::utils::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			mrpt::utils::CStream& out) const override;  // See base docs
+
+		/** Smallest disparity searched (default=0) */
+		unsigned int min_disparity;
+		/** Number of disparities searched: [min_disparity,
+		 * min_disparity+num_disparities-1]. Must be a multiple of 16
+		 * (default=64) */
+		unsigned int num_disparities;
+		/** Penalty of disparity changes of one pixel between neighbors
+		 * (default=10, in units of census bits) */
+		unsigned int P1;
+		/** Penalty of larger disparity changes (default=120) */
+		unsigned int P2;
+		/** Number of aggregation directions: 4 (horizontal and vertical) or 8
+		 * (plus diagonals, the default) */
+		unsigned int num_paths;
+		/** A match is rejected if the cost of any disparity other than the
+		 * best one and its neighbors is below (1+uniqueness_ratio) times the
+		 * best cost (default=0.05, 0 disables the test) */
+		float uniqueness_ratio;
+		/** Reject matches whose disparity differs by more than \a
+		 * lr_max_diff from the one of the right image (default=true) */
+		bool left_right_check;
+		/** See \a left_right_check (default=1) */
+		unsigned int lr_max_diff;
+		/** Refine disparities with a parabola fit (default=true) */
+		bool subpixel;
+		/** Only for computeRangeScan(): larger depths are marked as invalid
+		 * (default=0, no limit) */
+		float max_depth;
+		/** Number of threads (0: as many as cores, the default) */
+		unsigned int num_threads;
+	};
+
+	/** Set all the parameters of the matcher here */
+	TOptions options;
+
+	CStereoSGM() {}
+	/** Computes the disparity image of a pair of rectified 8-bit grayscale
+	 * images (with strides in bytes).
+	  * \param disparity The width x height disparities, row by row, in
+	 * pixels (left x minus right x), or INVALID_DISPARITY.
+	  */
+	void computeDisparity(
+		const uint8_t* left, const size_t left_stride, const uint8_t* right,
+		const size_t right_stride, const unsigned int width,
+		const unsigned int height, std::vector<float>& disparity) const;
+
+	/** Computes the disparity image of a pair of rectified images (color
+	 * images are converted to grayscale). \sa computeDisparity */
+	void computeDisparity(
+		const mrpt::utils::CImage& left, const mrpt::utils::CImage& right,
+		mrpt::math::CMatrixFloat& disparity) const;
+
+	/** Computes the depth image of a stereo observation, which must be
+	 * already rectified (see CStereoRectifyMap::rectify()):
+	  *  - The range image has the depth of each pixel of the left image
+	 * (range_is_depth=true), or 0 for pixels without a valid match.
+	  *  - The intensity image is the left image, and both the depth and
+	 * intensity camera parameters are those of the left camera.
+	  *  - The sensor pose is the left camera pose.
+	  */
+	void computeRangeScan(
+		const mrpt::obs::CObservationStereoImages& stereo_obs,
+		mrpt::obs::CObservation3DRangeScan& out_obs) const;
+
+   private:
+	/** Memory kept between calls, to avoid reallocating it for each frame
+	 * (one object cannot be used by several threads at once) */
+	mutable std::vector<uint64_t> m_census_left, m_census_right;
+	/** Matching and aggregated costs, for each pixel and disparity */
+	mutable std::vector<uint8_t> m_costs;
+	mutable std::vector<uint16_t> m_aggr_costs;
+};
+
+}  // end namespace
+}  // end namespace
+#endif
@@ -11,6 +11,7 @@
 
 #include <mrpt/utils/TCamera.h>
 #include <mrpt/utils/CImage.h>
+#include <mrpt/vision/TRemapLUT.h>
 
 #include <mrpt/vision/link_pragmas.h>
 
@@ -26,6 +27,12 @@ namespace vision
  * times: 640x480 image -> 70% build map / 30% actual undistort).
   *
   *  Works with grayscale or color images.
+  *
+  *  The map is a fixed-point look-up table (see TRemapLUT) built without
+ * OpenCV, and images are undistorted with bilinear interpolation by blocks of
+ * rows in parallel (see \a setNumThreads()). Pixels which fall out of the
+ * source image are set to black. Images which are not 8-bit grayscale or
+ * RGB are undistorted with the same map by OpenCV's remap().
   *
   * Example of usage:
   * \code
@@ -60,7 +67,8 @@ class VISION_IMPEXP CUndistortMap
 	void setFromCamParams(const mrpt::utils::TCamera& params);
 
 	/** Undistort the input image and saves the result in the output one - \a
-	 * setFromCamParams() must have been set prior to calling this.
+	 * setFromCamParams() must have been set prior to calling this. Both can
+	 * be the same image.
 	  */
 	void undistort(
 		const mrpt::utils::CImage& in_img, mrpt::utils::CImage& out_img) const;
@@ -82,10 +90,21 @@ class VISION_IMPEXP CUndistortMap
 	  *  Can be used within loops to determine the first usage of the object and
 	 * when it needs to be initialized.
 	  */
-	inline bool isSet() const { return !m_dat_mapx.empty(); }
+	inline bool isSet() const { return !m_lut.empty(); }
+	/** Sets the number of threads for \a undistort() (default=0: as many as
+	 * cores) */
+	void setNumThreads(unsigned int num_threads)
+	{
+		m_num_threads = num_threads;
+	}
+	/** \sa setNumThreads */
+	unsigned int getNumThreads() const { return m_num_threads; }
+	/** Direct access to the undistortion map (empty until \a
+	 * setFromCamParams() is called) */
+	const TRemapLUT& getUndistortMap() const { return m_lut; }
    private:
-	std::vector<int16_t> m_dat_mapx;
-	std::vector<uint16_t> m_dat_mapy;
+	TRemapLUT m_lut;
+	unsigned int m_num_threads;
 
 	/** A copy of the data provided by the user */
 	mrpt::utils::TCamera m_camera_params;
@@ -0,0 +1,109 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef mrpt_vision_TRemapLUT_H
+#define mrpt_vision_TRemapLUT_H
+
+#include <mrpt/utils/TCamera.h>
+#include <mrpt/math/CMatrixFixedNumeric.h>
+
+#include <mrpt/vision/link_pragmas.h>
+
+namespace mrpt
+{
+namespace vision
+{
+/** A precomputed look-up table for remapping (undistorting and/or
+ * rectifying) 8-bit images, without OpenCV.
+  *
+  *  For each pixel of the output image, the table keeps the integer
+ * coordinates of the top-left pixel of the 2x2 source neighborhood and the
+ * fractional part of the source coordinates, quantized to 1/FRAC_ONE of a
+ * pixel (the same precision than OpenCV's fixed-point maps). Pixels whose
+ * source falls out of the source image are marked as INVALID and are set to
+ * zero (black).
+  *
+  *  Remapping is done with bilinear (or nearest neighbor) interpolation in
+ * integer arithmetic, with SSE2 or AVX2 kernels (if available) for grayscale
+ * and 3-channel images. Rows are independent, so \a remapRows() can be run by
+ * several threads on disjoint blocks of rows.
+  *
+  * \sa CUndistortMap, CStereoRectifyMap
+  * \ingroup mrpt_vision_grp
+  */
+struct VISION_IMPEXP TRemapLUT
+{
+	/** Bits of the fractional part of the source coordinates */
+	static const int FRAC_BITS = 5;
+	static const int FRAC_ONE = 1 << FRAC_BITS;
+	/** Value of \a frac_x for output pixels out of the source image */
+	static const uint8_t INVALID = 0xFF;
+
+	/** Size of the output image */
+	unsigned int width, height;
+	/** Size of the source image */
+	unsigned int src_width, src_height;
+	/** Top-left source pixel of each output pixel (row-major) */
+	std::vector<uint16_t> src_x, src_y;
+	/** Fractional source coordinates, in [0,FRAC_ONE] (INVALID in frac_x for
+	 * invalid pixels) */
+	std::vector<uint8_t> frac_x, frac_y;
+
+	TRemapLUT() : width(0), height(0), src_width(0), src_height(0) {}
+	inline bool empty() const { return frac_x.empty(); }
+	void clear();
+
+	/** Builds the table to undistort and rectify the images of a camera, with
+	 * the same model than OpenCV's initUndistortRectifyMap():
+	  * \param cam The camera intrinsic and distortion parameters, and the size
+	 * of the source images.
+	  * \param R The rotation from the camera to the rectified camera.
+	  * \param new_K The intrinsic parameters of the output image.
+	  * \param out_width, out_height Size of the output image.
+	  */
+	void setFromCamera(
+		const mrpt::utils::TCamera& cam, const mrpt::math::CMatrixDouble33& R,
+		const mrpt::math::CMatrixDouble33& new_K, unsigned int out_width,
+		unsigned int out_height);
+
+	/** Builds the table from OpenCV's fixed-point maps (types CV_16SC2 for \a
+	 * map_xy and CV_16UC1 for \a map_frac, with INTER_BITS=5) of an output
+	 * image of the given size. */
+	void setFromOpenCVMaps(
+		const std::vector<int16_t>& map_xy,
+		const std::vector<uint16_t>& map_frac, unsigned int out_width,
+		unsigned int out_height, unsigned int src_width,
+		unsigned int src_height);
+
+	/** The inverse of \a setFromOpenCVMaps(): invalid pixels are mapped to the
+	 * source pixel (-1,-1) */
+	void getAsOpenCVMaps(
+		std::vector<int16_t>& map_xy, std::vector<uint16_t>& map_frac) const;
+
+	/** Remaps the output rows [row0,row1) of an 8-bit image with \a nChannels
+	 * (1 or 3) interleaved channels. \a src must be a src_width x src_height
+	 * image; strides are in bytes.
+	  * \param nearest Use nearest neighbor instead of bilinear interpolation.
+	  */
+	void remapRows(
+		const uint8_t* src, const size_t src_stride, uint8_t* dst,
+		const size_t dst_stride, const unsigned int nChannels,
+		const unsigned int row0, const unsigned int row1,
+		const bool nearest = false) const;
+
+	/** Remaps a whole image, running \a remapRows() on blocks of rows in \a
+	 * num_threads threads (0: as many as cores). */
+	void remap(
+		const uint8_t* src, const size_t src_stride, uint8_t* dst,
+		const size_t dst_stride, const unsigned int nChannels,
+		const bool nearest = false, unsigned int num_threads = 1) const;
+};
+
+}  // end namespace
+}  // end namespace
+#endif
@@ -104,6 +104,46 @@ double VISION_IMPEXP bundle_adj_full(
 	const mrpt::vision::TBundleAdjustmentFeedbackFunctor user_feedback =
 		nullptr);
 
+/** Sparse Levenberg-Marquart bundle adjustment for large problems (many
+  *frames and landmarks): it solves the same problem than bundle_adj_full(),
+  *with the same inputs and outputs, but:
+  *		- The normal equations are reduced to the camera poses (Schur
+  *complement of the landmarks), kept as a matrix of 6x6 blocks whose sparsity
+  *pattern (the pairs of frames with common landmarks) is analyzed only once.
+  *		- The reduced system is solved with a sparse block Cholesky
+  *factorization (mrpt::math::CSparseBlockCholesky) or, for very large
+  *problems, with preconditioned conjugate gradient (PCG).
+  *		- Residuals, Jacobians, Hessian blocks and the Schur complement are
+  *computed in parallel.
+  *		- The robust kernel (see mrpt::math::RobustKernel) weights both the
+  *gradient and the Hessian (iteratively reweighted least squares).
+  *
+  *  List of optional parameters in "extra_params": all those of
+  *bundle_adj_full(), plus:
+  *		- "robust_kernel": A mrpt::math::TRobustKernelType: 0=least squares,
+  *1=pseudo-Huber (default=1)
+  *		- "num_threads": Number of threads (default=0: as many as cores)
+  *		- "solver": 0=sparse Cholesky, 1=PCG with a block-Jacobi
+  *preconditioner (default=0)
+  *		- "pcg_max_iterations": Maximum number of PCG iterations for each
+  *step (default=200)
+  *		- "pcg_tolerance": PCG stops when the norm of the residual is below
+  *this fraction of the norm of the right-hand side (default=1e-8)
+  *
+  * \return The final overall squared error.
+  * \sa bundle_adj_full
+  * \ingroup bundle_adj
+  */
+double VISION_IMPEXP bundle_adj_sparse(
+	const mrpt::vision::TSequenceFeatureObservations& observations,
+	const mrpt::utils::TCamera& camera_params,
+	mrpt::vision::TFramePosesVec& frame_poses,
+	mrpt::vision::TLandmarkLocationsVec& landmark_points,
+	const mrpt::utils::TParametersDouble& extra_params =
+		mrpt::utils::TParametersDouble(),
+	const mrpt::vision::TBundleAdjustmentFeedbackFunctor user_feedback =
+		nullptr);
+
 /** @} */
 
 /** @name Bundle-Adjustment Auxiliary methods
@@ -12,6 +12,7 @@
 
 #include <mrpt/vision/types.h>
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 
 namespace mrpt
 {
@@ -55,24 +56,46 @@ struct TSIFTDescriptorsKDTreeIndex
 
 	/** Constructor from a list of SIFT features.
 	  *  Automatically build the KD-tree index. The list of features must NOT be
-	 * empty or an exception will be raised.
+	 * empty or an exception will be raised. The descriptors are copied into
+	 * a contiguous matrix, which is updated by regenerate_kdtreee().
 	  */
 	TSIFTDescriptorsKDTreeIndex(const CFeatureList& feats)
-		: m_adaptor(feats), m_kdtree(nullptr), m_feats(feats)
+		: m_feats(&feats),
+		  m_own_descs(feats, descSIFT),
+		  m_descs(m_own_descs),
+		  m_adaptor(m_own_descs.SIFT),
+		  m_kdtree(nullptr)
 	{
 		ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSIFT())
 		this->regenerate_kdtreee();
 	}
 
+	/** Constructor from a list of features with SIFT descriptors, which are
+	 * used in place (the list must exist while this object is used).
+	  *  Automatically build the KD-tree index. The list of features must NOT be
+	 * empty or an exception will be raised.
+	  */
+	TSIFTDescriptorsKDTreeIndex(const CCompactFeatureList& feats)
+		: m_feats(nullptr),
+		  m_descs(feats),
+		  m_adaptor(feats.SIFT),
+		  m_kdtree(nullptr)
+	{
+		ASSERT_(!feats.empty() && feats.hasDescriptorSIFT())
+		this->regenerate_kdtreee();
+	}
+
 	/** Re-creates the kd-tree, which must be done whenever the data source (the
-	 * CFeatureList) changes. */
+	 * CFeatureList or CCompactFeatureList) changes. */
 	void regenerate_kdtreee()
 	{
 		if (m_kdtree) delete m_kdtree;
+		m_kdtree = nullptr;
+		if (m_feats) m_own_descs.assign(*m_feats, descSIFT);
 
 		nanoflann::KDTreeSingleIndexAdaptorParams params;
 		m_kdtree = new kdtree_t(
-			m_feats[0]->descriptors.SIFT.size() /* DIM */, m_adaptor, params);
+			m_descs.SIFT.cols() /* DIM */, m_adaptor, params);
 		m_kdtree->buildIndex();
 	}
 
@@ -86,10 +109,13 @@ struct TSIFTDescriptorsKDTreeIndex
 	}
 
    private:
+	/** The source list, if built from a CFeatureList */
+	const CFeatureList* m_feats;
+	/** The descriptors of m_feats, if built from a CFeatureList */
+	CCompactFeatureList m_own_descs;
+	const CCompactFeatureList& m_descs;
 	detail::TSIFTDesc2KDTree_Adaptor<distance_t> m_adaptor;
 	kdtree_t* m_kdtree;
-
-	const CFeatureList& m_feats;
 };  // end of TSIFTDescriptorsKDTreeIndex
 
 /** A kd-tree builder for sets of features with SURF descriptors.
@@ -111,26 +137,48 @@ struct TSURFDescriptorsKDTreeIndex
 		metric_t, detail::TSURFDesc2KDTree_Adaptor<distance_t>>
 		kdtree_t;
 
-	/** Constructor from a list of SIFT features.
+	/** Constructor from a list of SURF features.
 	  *  Automatically build the KD-tree index. The list of features must NOT be
-	 * empty or an exception will be raised.
+	 * empty or an exception will be raised. The descriptors are copied into
+	 * a contiguous matrix, which is updated by regenerate_kdtreee().
 	  */
 	TSURFDescriptorsKDTreeIndex(const CFeatureList& feats)
-		: m_adaptor(feats), m_kdtree(nullptr), m_feats(feats)
+		: m_feats(&feats),
+		  m_own_descs(feats, descSURF),
+		  m_descs(m_own_descs),
+		  m_adaptor(m_own_descs.SURF),
+		  m_kdtree(nullptr)
 	{
-		ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSIFT())
+		ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSURF())
+		this->regenerate_kdtreee();
+	}
+
+	/** Constructor from a list of features with SURF descriptors, which are
+	 * used in place (the list must exist while this object is used).
+	  *  Automatically build the KD-tree index. The list of features must NOT be
+	 * empty or an exception will be raised.
+	  */
+	TSURFDescriptorsKDTreeIndex(const CCompactFeatureList& feats)
+		: m_feats(nullptr),
+		  m_descs(feats),
+		  m_adaptor(feats.SURF),
+		  m_kdtree(nullptr)
+	{
+		ASSERT_(!feats.empty() && feats.hasDescriptorSURF())
 		this->regenerate_kdtreee();
 	}
 
 	/** Re-creates the kd-tree, which must be done whenever the data source (the
-	 * CFeatureList) changes. */
+	 * CFeatureList or CCompactFeatureList) changes. */
 	void regenerate_kdtreee()
 	{
 		if (m_kdtree) delete m_kdtree;
+		m_kdtree = nullptr;
+		if (m_feats) m_own_descs.assign(*m_feats, descSURF);
 
 		nanoflann::KDTreeSingleIndexAdaptorParams params;
 		m_kdtree = new kdtree_t(
-			m_feats[0]->descriptors.SIFT.size() /* DIM */, m_adaptor, params);
+			m_descs.SURF.cols() /* DIM */, m_adaptor, params);
 		m_kdtree->buildIndex();
 	}
 
@@ -144,10 +192,13 @@ struct TSURFDescriptorsKDTreeIndex
 	}
 
    private:
+	/** The source list, if built from a CFeatureList */
+	const CFeatureList* m_feats;
+	/** The descriptors of m_feats, if built from a CFeatureList */
+	CCompactFeatureList m_own_descs;
+	const CCompactFeatureList& m_descs;
 	detail::TSURFDesc2KDTree_Adaptor<distance_t> m_adaptor;
 	kdtree_t* m_kdtree;
-
-	const CFeatureList& m_feats;
 };  // end of TSURFDescriptorsKDTreeIndex
 
 /** @} */
@@ -157,17 +208,21 @@ namespace detail
 template <typename distance_t, typename element_t>
 struct TSIFTDesc2KDTree_Adaptor
 {
-	const CFeatureList& m_feats;
-	TSIFTDesc2KDTree_Adaptor(const CFeatureList& feats) : m_feats(feats) {}
+	/** One descriptor per row */
+	const TDescriptorMatrix<element_t>& m_descs;
+	TSIFTDesc2KDTree_Adaptor(const TDescriptorMatrix<element_t>& descs)
+		: m_descs(descs)
+	{
+	}
 	// Must return the number of data points
-	inline size_t kdtree_get_point_count() const { return m_feats.size(); }
+	inline size_t kdtree_get_point_count() const { return m_descs.rows(); }
 	// Must return the Euclidean (L2) distance between the vector "p1[0:size-1]"
 	// and the data point with index "idx_p2" stored in the class:
 	inline distance_t kdtree_distance(
 		const element_t* p1, const size_t idx_p2, size_t size) const
 	{
-		const size_t dim = m_feats[idx_p2]->descriptors.SIFT.size();
-		const element_t* p2 = &m_feats[idx_p2]->descriptors.SIFT[0];
+		const size_t dim = m_descs.cols();
+		const element_t* p2 = m_descs[idx_p2];
 		distance_t d = 0;
 		for (size_t i = 0; i < dim; i++)
 		{
@@ -180,7 +235,7 @@ struct TSIFTDesc2KDTree_Adaptor
 	// Must return the dim'th component of the idx'th point in the class:
 	inline element_t kdtree_get_pt(const size_t idx, int dim) const
 	{
-		return m_feats[idx]->descriptors.SIFT[dim];
+		return m_descs[idx][dim];
 	}
 	template <class BBOX>
 	bool kdtree_get_bbox(BBOX& bb) const
@@ -192,17 +247,21 @@ struct TSIFTDesc2KDTree_Adaptor
 template <typename distance_t, typename element_t>
 struct TSURFDesc2KDTree_Adaptor
 {
-	const CFeatureList& m_feats;
-	TSURFDesc2KDTree_Adaptor(const CFeatureList& feats) : m_feats(feats) {}
+	/** One descriptor per row */
+	const TDescriptorMatrix<element_t>& m_descs;
+	TSURFDesc2KDTree_Adaptor(const TDescriptorMatrix<element_t>& descs)
+		: m_descs(descs)
+	{
+	}
 	// Must return the number of data points
-	inline size_t kdtree_get_point_count() const { return m_feats.size(); }
+	inline size_t kdtree_get_point_count() const { return m_descs.rows(); }
 	// Must return the Euclidean (L2) distance between the vector "p1[0:size-1]"
 	// and the data point with index "idx_p2" stored in the class:
 	inline distance_t kdtree_distance(
 		const element_t* p1, const size_t idx_p2, size_t size) const
 	{
-		const size_t dim = m_feats[idx_p2]->descriptors.SURF.size();
-		const element_t* p2 = &m_feats[idx_p2]->descriptors.SURF[0];
+		const size_t dim = m_descs.cols();
+		const element_t* p2 = m_descs[idx_p2];
 		distance_t d = 0;
 		for (size_t i = 0; i < dim; i++)
 		{
@@ -215,7 +274,7 @@ struct TSURFDesc2KDTree_Adaptor
 	// Must return the dim'th component of the idx'th point in the class:
 	inline element_t kdtree_get_pt(const size_t idx, int dim) const
 	{
-		return m_feats[idx]->descriptors.SURF[dim];
+		return m_descs[idx][dim];
 	}
 	template <class BBOX>
 	bool kdtree_get_bbox(BBOX& bb) const
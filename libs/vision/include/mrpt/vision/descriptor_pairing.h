@@ -11,6 +11,7 @@
 #define mrpt_vision_descriptor_pairing_H
 
 #include <mrpt/vision/types.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 
 namespace mrpt
 {
@@ -51,7 +52,8 @@ template <class DESCRIPTOR_KDTREE>
 size_t find_descriptor_pairings(
 	std::vector<vector_size_t>* pairings_1_to_multi_2,
 	std::vector<std::pair<size_t, size_t>>* pairings_1_to_2,
-	const CFeatureList& feats_img1, const DESCRIPTOR_KDTREE& feats_img2_kdtree,
+	const CCompactFeatureList& feats_img1,
+	const DESCRIPTOR_KDTREE& feats_img2_kdtree,
 	const mrpt::vision::TDescriptorType descriptor = descSIFT,
 	const size_t max_neighbors = 4, const double max_relative_distance = 1.2,
 	const typename DESCRIPTOR_KDTREE::kdtree_t::DistanceType max_distance =
@@ -85,24 +87,22 @@ size_t find_descriptor_pairings(
 	if (descriptor == descSIFT)
 	{
 		ASSERTMSG_(
-			feats_img1[0]->descriptors.hasDescriptorSIFT(),
+			feats_img1.hasDescriptorSIFT(),
 			"Request to match SIFT features but feats_img1 has no SIFT "
 			"descriptors!")
 		ASSERTMSG_(
-			sizeof(KDTreeElementType) ==
-				sizeof(feats_img1[0]->descriptors.SIFT[0]),
+			sizeof(KDTreeElementType) == sizeof(feats_img1.SIFT[0][0]),
 			"Incorrect data type kd_tree::ElementType for SIFT (should be "
 			"uint8_t)")
 	}
 	else if (descriptor == descSURF)
 	{
 		ASSERTMSG_(
-			feats_img1[0]->descriptors.hasDescriptorSURF(),
+			feats_img1.hasDescriptorSURF(),
 			"Request to match SURF features but feats_img1 has no SURF "
 			"descriptors!")
 		ASSERTMSG_(
-			sizeof(KDTreeElementType) ==
-				sizeof(feats_img1[0]->descriptors.SURF[0]),
+			sizeof(KDTreeElementType) == sizeof(feats_img1.SURF[0][0]),
 			"Incorrect data type kd_tree::ElementType for SURF (should be "
 			"float)")
 	}
@@ -112,17 +112,15 @@ size_t find_descriptor_pairings(
 	}
 
 	std::vector<size_t> indices(max_neighbors);
-	std::vector<double> distances(max_neighbors);
+	std::vector<KDTreeDistanceType> distances(max_neighbors);
 
 	for (size_t i = 0; i < N; i++)
 	{
-		const CFeature::TDescriptors& descs = feats_img1[i]->descriptors;
-
 		const void* ptr_query;
 		if (descriptor == descSIFT)
-			ptr_query = &descs.SIFT[0];
-		else if (descriptor == descSURF)
-			ptr_query = &descs.SURF[0];
+			ptr_query = feats_img1.SIFT[i];
+		else
+			ptr_query = feats_img1.SURF[i];
 
 		feats_img2_kdtree.get_kdtree().knnSearch(
 			static_cast<const KDTreeElementType*>(ptr_query),  // Query point
@@ -133,7 +131,8 @@ size_t find_descriptor_pairings(
 		// Include all correspondences below the absolute and the relative
 		// threshold (indices comes ordered by distances):
 		const KDTreeDistanceType this_thresh =
-			std::min(max_relative_distance * distances[0], max_distance);
+			std::min<KDTreeDistanceType>(
+				max_relative_distance * distances[0], max_distance);
 		for (size_t j = 0; j < max_neighbors; j++)
 		{
 			if (distances[j] <= this_thresh)
@@ -152,6 +151,25 @@ size_t find_descriptor_pairings(
 	MRPT_END
 }
 
+/** \overload For a list of CFeature objects, whose descriptors are first
+ * copied into a CCompactFeatureList. */
+template <class DESCRIPTOR_KDTREE>
+size_t find_descriptor_pairings(
+	std::vector<vector_size_t>* pairings_1_to_multi_2,
+	std::vector<std::pair<size_t, size_t>>* pairings_1_to_2,
+	const CFeatureList& feats_img1, const DESCRIPTOR_KDTREE& feats_img2_kdtree,
+	const mrpt::vision::TDescriptorType descriptor = descSIFT,
+	const size_t max_neighbors = 4, const double max_relative_distance = 1.2,
+	const typename DESCRIPTOR_KDTREE::kdtree_t::DistanceType max_distance =
+		std::numeric_limits<
+			typename DESCRIPTOR_KDTREE::kdtree_t::DistanceType>::max())
+{
+	return find_descriptor_pairings(
+		pairings_1_to_multi_2, pairings_1_to_2,
+		CCompactFeatureList(feats_img1, descriptor), feats_img2_kdtree,
+		descriptor, max_neighbors, max_relative_distance, max_distance);
+}
+
 /** @} */
 }
 }
@@ -14,6 +14,8 @@
 #include <mrpt/vision/link_pragmas.h>
 #include <Eigen/Core>
 #include <Eigen/Dense>
+#include <vector>
+#include <cstdint>
 
 namespace mrpt
 {
@@ -212,6 +214,113 @@ class VISION_IMPEXP CPnP
 		Eigen::Ref<Eigen::MatrixXd> pose_mat);
 };
 
+/** Robust PnP: RANSAC with the P3P minimal solver (\cite kneip), for sets
+ * of 2D-3D correspondences with outliers, and for batches of them (e.g.
+ * relocalization against many candidate keyframes).
+ *
+ *  - Hypotheses are generated by rounds of a fixed size, in parallel. Each
+ * hypothesis uses its own random generator, seeded from its index, so the
+ * results do not depend on the number of threads.
+ *  - Models are scored by the reprojection error of all the points, with
+ * SSE2/AVX kernels (4/8 points at once, in float).
+ *  - Bad models are rejected early with Wald's Sequential Probability Ratio
+ * Test (SPRT, Chum & Matas 2008), whose parameters are adapted on the go.
+ *  - Each so-far-the-best model is refined (LO-RANSAC) by Gauss-Newton
+ * minimization of the reprojection error of its inliers, re-selecting the
+ * inliers after each iteration.
+ *
+ * Example of usage:
+ * \code
+ *   CPnPRansac ransac;
+ *   ransac.options.max_reproj_error = 3.0;
+ *   CPnPRansac::TResult res;
+ *   if (ransac.solve(obj_pts, img_pts, K, res))
+ *     cout << res.inliers.size() << " inliers\n";
+ * \endcode
+ */
+class VISION_IMPEXP CPnPRansac
+{
+   public:
+	struct VISION_IMPEXP TOptions
+	{
+		TOptions();
+
+		/** Inlier threshold for the reprojection error (pixels, default=2) */
+		double max_reproj_error;
+		/** Probability of having drawn an all-inlier sample when stopping
+		 * (default=0.99) */
+		double confidence;
+		/** Maximum number of hypotheses (default=1000) */
+		unsigned int max_iterations;
+		/** Minimum number of inliers of a valid solution (default=6) */
+		unsigned int min_inliers;
+		/** Refine so-far-the-best models (LO-RANSAC, default=true) */
+		bool local_optimization;
+		/** Maximum number of refine & re-select iterations of each local
+		 * optimization (default=5) */
+		unsigned int lo_iterations;
+		/** Reject bad models early with the SPRT (default=true) */
+		bool use_sprt;
+		/** Initial SPRT estimates of the probability of a point being
+		 * consistent with a good (epsilon, default=0.1) and a bad (delta,
+		 * default=0.01) model */
+		double sprt_epsilon, sprt_delta;
+		/** Number of threads (0: as many as cores, the default). solveBatch()
+		 * distributes the problems among them instead. */
+		unsigned int num_threads;
+		/** Seed of the random sampling (default=1) */
+		uint64_t seed;
+	};
+
+	struct VISION_IMPEXP TResult
+	{
+		TResult();
+
+		/** Whether a model with at least min_inliers was found */
+		bool success;
+		/** The pose: points in the camera frame are R*p+t */
+		Eigen::Matrix3d R;
+		Eigen::Vector3d t;
+		/** Indices of the inlier correspondences, in ascending order */
+		std::vector<size_t> inliers;
+		/** RMS reprojection error of the inliers (pixels) */
+		double rms_reproj_error;
+		/** Number of samples drawn, of models scored, of models rejected by
+		 * the SPRT and of local optimizations */
+		unsigned int num_hypotheses, num_models, num_sprt_rejected,
+			num_local_opt;
+		/** Timings (seconds): total (wall time), and of the hypothesis
+		 * generation plus scoring rounds, the local optimizations and the
+		 * final refinement */
+		double time_total, time_hypotheses, time_local_opt, time_refine;
+	};
+
+	/** Set all the parameters here */
+	TOptions options;
+
+	/** Estimates a pose with RANSAC.
+	 * @param[in] obj_pts Object points 3xn, one per column [X, Y, Z]
+	 * @param[in] img_pts Image points in pixels, 2xn or 3xn [u, v(, 1)]
+	 * @param[in] cam_intrinsic Camera intrinsic matrix
+	 * @param[out] result The pose, inliers and statistics
+	 * @return result.success
+	 */
+	bool solve(
+		const Eigen::Ref<const Eigen::MatrixXd>& obj_pts,
+		const Eigen::Ref<const Eigen::MatrixXd>& img_pts,
+		const Eigen::Matrix3d& cam_intrinsic, TResult& result) const;
+
+	/** Solves many independent problems (the i'th one with obj_pts[i] and
+	 * img_pts[i]) with the same camera, distributing them among
+	 * options.num_threads threads. Results are the same as those of solve().
+	 */
+	void solveBatch(
+		const std::vector<Eigen::MatrixXd>& obj_pts,
+		const std::vector<Eigen::MatrixXd>& img_pts,
+		const Eigen::Matrix3d& cam_intrinsic,
+		std::vector<TResult>& results) const;
+};
+
 /** @}  */  // end of grouping
 }
 }
@@ -297,12 +297,69 @@ struct VISION_IMPEXP CGenericFeatureTracker
 
 typedef std::unique_ptr<CGenericFeatureTracker> CGenericFeatureTrackerAutoPtr;
 
+/** An image pyramid of an 8-bit grayscale image, with the gradients of each
+ * level, as used by the pyramidal KLT tracker (see CFeatureTracker_KL).
+  * Each level is half the size of the previous one, smoothed with a 5x5
+ * binomial kernel. Levels are stored without padding, so each row of a level
+ * can be sampled with SIMD instructions up to its last pixel.
+  */
+struct VISION_IMPEXP TKLTPyramid
+{
+	/** Levels smaller than this (in width or height) are not built */
+	static const int MIN_LEVEL_SIZE = 16;
+
+	struct VISION_IMPEXP TLevel
+	{
+		TLevel() : width(0), height(0) {}
+		int width, height;
+		/** Gray levels, row by row (width*height elements) */
+		std::vector<uint8_t> img;
+		/** Scharr derivatives in x and y (32 times the change of intensity
+		 * per pixel), empty until computeGradients() is called */
+		std::vector<int16_t> grad_x, grad_y;
+	};
+	std::vector<TLevel> levels;
+
+	/** Builds the pyramid of a grayscale image with \a stride bytes per row,
+	 * with at most \a nLevels levels. Gradients are not computed. */
+	void build(
+		const uint8_t* data, const int width, const int height,
+		const int stride, const size_t nLevels);
+	/** Whether build() was last called with an identical image and the same
+	 * number of levels (i.e. the pyramid can be reused for that image) */
+	bool isBuiltFrom(
+		const uint8_t* data, const int width, const int height,
+		const int stride, const size_t nLevels) const;
+	/** Computes the gradients of all the levels, if not done yet */
+	void computeGradients();
+	inline bool hasGradients() const
+	{
+		return !levels.empty() && !levels[0].grad_x.empty();
+	}
+	/** Number of levels that build() creates for an image of that size */
+	static size_t numLevelsFor(
+		const int width, const int height, const size_t nLevels);
+};
+
 /** Track a set of features from old_img -> new_img using sparse optimal flow
   *(classic KL method).
   *
   *  See CGenericFeatureTracker for a more detailed explanation on how to use
   *this class.
   *
+  *  This is a pyramidal Lucas-Kanade tracker (Bouguet's formulation, as
+  *OpenCV's cvCalcOpticalFlowPyrLK), with its own implementation:
+  *		- The pyramid of the new image (see TKLTPyramid) is kept, and reused
+  *as the pyramid of the old image in the next call, if that image is the same
+  *(which is the usual case in video tracking). Gradients are only computed
+  *for the old image.
+  *		- Features are tracked in parallel, in batches of consecutive
+  *features.
+  *		- The bilinear sampling of patches and the Gauss-Newton sums use
+  *SSE2/AVX2 instructions, if available.
+  *		- The convergence of each feature is reported in
+  *last_tracking_stats.
+  *
   *   List of additional parameters in "extra_params" (apart from those in
   *CGenericFeatureTracker) accepted by this class:
   *		- "window_width"  (Default=15)
@@ -316,7 +373,14 @@ typedef std::unique_ptr<CGenericFeatureTracker> CGenericFeatureTrackerAutoPtr;
   *LK_tracking.
   *		- "LK_max_tracking_error" (Default=150.0) The maximum "tracking error"
   *of
-  *LK tracking such as a feature is marked as "lost".
+  *LK tracking such as a feature is marked as "lost". The error is the mean
+  *absolute difference of gray levels between the patches in both images.
+  *		- "LK_min_eigenvalue" (Default=0) Features whose window has a gradient
+  *matrix with a smaller minimum eigenvalue (divided by the number of pixels,
+  *with gradients in gray levels per pixel) are marked as "lost", since they
+  *cannot be tracked reliably (e.g. uniform areas or straight edges).
+  *		- "num_threads" (Default=0) Number of threads to track features (0:
+  *as many as cores).
   *
   *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
   */
@@ -330,6 +394,30 @@ struct VISION_IMPEXP CFeatureTracker_KL : public CGenericFeatureTracker
 	{
 	}
 
+	/** Convergence information of the tracking of one feature */
+	struct VISION_IMPEXP TTrackingStats
+	{
+		TTrackingStats()
+			: iterations(0), converged(false), residual(0), min_eigenvalue(0)
+		{
+		}
+		/** Total number of Gauss-Newton iterations, in all the levels */
+		unsigned int iterations;
+		/** Whether the last step in the finest level was below "LK_epsilon"
+		 * (false if "LK_max_iters" was reached first) */
+		bool converged;
+		/** Mean absolute difference of gray levels between both patches, at
+		 * the final position */
+		float residual;
+		/** Minimum eigenvalue of the gradient matrix in the finest level */
+		float min_eigenvalue;
+	};
+
+	/** Updated with each call to trackFeatures(): the stats of each feature,
+	 * in the order of the list of features passed to it (before lost features
+	 * are removed or new ones are added). */
+	std::vector<TTrackingStats> last_tracking_stats;
+
    protected:
 	virtual void trackFeatures_impl(
 		const mrpt::utils::CImage& old_img, const mrpt::utils::CImage& new_img,
@@ -346,6 +434,9 @@ struct VISION_IMPEXP CFeatureTracker_KL : public CGenericFeatureTracker
 	void trackFeatures_impl_templ(
 		const mrpt::utils::CImage& old_img, const mrpt::utils::CImage& new_img,
 		FEATLIST& inout_featureList);
+
+	/** Pyramids of the old and new images of the last call */
+	TKLTPyramid m_prev_pyramid, m_cur_pyramid;
 };
 
 /** Search for correspondences which are not in the same row and deletes them
@@ -438,6 +438,9 @@ struct VISION_IMPEXP TMatchingOptions : public mrpt::utils::CLoadableOptions
 	// ORB
 	/** Maximun distance between ORB descriptors */
 	double maxORB_dist;
+	/** Boundary Ratio between the two lowest ORB distances (the ratio test is
+	 * disabled with values >= 1, the default) */
+	float ORB_RATIO;
 
 	//			// To estimate depth
 	/** Whether or not estimate the 3D position of the real features for the
@@ -449,6 +452,10 @@ struct VISION_IMPEXP TMatchingOptions : public mrpt::utils::CLoadableOptions
 	/** Intrinsic parameters of the stereo rig */
 	//            double  fx,cx,cy,baseline;
 
+	/** Number of threads used by matchFeatures() (0: as many as cores).
+	 * The results do not depend on it. */
+	unsigned int num_threads;
+
 	/** Constructor */
 	TMatchingOptions();
 
@@ -474,7 +481,8 @@ struct VISION_IMPEXP TMatchingOptions : public mrpt::utils::CLoadableOptions
 			   CHECK_MEMBER(matching_method) &&
 			   CHECK_MEMBER(maxDepthThreshold) && CHECK_MEMBER(maxEDD_TH) &&
 			   CHECK_MEMBER(maxEDSD_TH) && CHECK_MEMBER(maxORB_dist) &&
-			   CHECK_MEMBER(maxSAD_TH) && CHECK_MEMBER(max_disp) &&
+			   CHECK_MEMBER(ORB_RATIO) && CHECK_MEMBER(maxSAD_TH) &&
+			   CHECK_MEMBER(max_disp) && CHECK_MEMBER(num_threads) &&
 			   CHECK_MEMBER(minCC_TH) && CHECK_MEMBER(minDCC_TH) &&
 			   CHECK_MEMBER(min_disp) && CHECK_MEMBER(parallelOpticalAxis) &&
 			   CHECK_MEMBER(rCC_TH) && CHECK_MEMBER(SAD_RATIO);
@@ -498,8 +506,10 @@ struct VISION_IMPEXP TMatchingOptions : public mrpt::utils::CLoadableOptions
 		COPY_MEMBER(maxEDD_TH)
 		COPY_MEMBER(maxEDSD_TH)
 		COPY_MEMBER(maxORB_dist)
+		COPY_MEMBER(ORB_RATIO)
 		COPY_MEMBER(maxSAD_TH)
 		COPY_MEMBER(max_disp)
+		COPY_MEMBER(num_threads)
 		COPY_MEMBER(minCC_TH)
 		COPY_MEMBER(minDCC_TH)
 		COPY_MEMBER(min_disp)
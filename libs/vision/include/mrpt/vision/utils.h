@@ -11,6 +11,7 @@
 #define mrpt_vision_utils_H
 
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 #include <mrpt/utils/CImage.h>
 #include <mrpt/utils/TStereoCamera.h>
 #include <mrpt/math/CMatrixTemplate.h>
@@ -214,6 +215,13 @@ void VISION_IMPEXP normalizeImage(
 
 /** Find the matches between two lists of features which must be of the same
  * type.
+  * Only the features of list2 near the epipolar line (or the same rows, for
+  * parallel optical axes) of each feature of list1 are compared, the
+  * descriptor distances are computed with SIMD kernels, and the features of
+  * list1 are processed in parallel (see TMatchingOptions::num_threads), with
+  * the same results than a sequential brute-force search.
+  * All the features must have the descriptor (or patch) required by
+  * TMatchingOptions::matching_method.
   * \param list1    [IN]    One list.
   * \param list2    [IN]    Other list.
   * \param matches  [OUT]   A vector of pairs of correspondences.
@@ -226,6 +234,23 @@ size_t VISION_IMPEXP matchFeatures(
 	const TMatchingOptions& options = TMatchingOptions(),
 	const TStereoSystemParams& params = TStereoSystemParams());
 
+/** Find the matches between two lists of features stored as contiguous
+ * arrays, without building CFeature objects. It is the same matching than
+ * the version for CFeatureList, but:
+  *  - Only the descriptor-based methods are supported, since the image
+ * patches are not stored in CCompactFeatureList.
+  *  - The depth filter of TMatchingOptions::estimateDepth is not applied.
+  * \param matches  [OUT]   The pairs of indices (in list1, in list2) of the
+ * matched features, sorted by the index in list1. They are appended to the
+ * previous contents if TMatchingOptions::addMatches is true.
+  * eturn Returns the number of elements in matches.
+  */
+size_t VISION_IMPEXP matchFeatures(
+	const CCompactFeatureList& list1, const CCompactFeatureList& list2,
+	std::vector<std::pair<size_t, size_t>>& matches,
+	const TMatchingOptions& options = TMatchingOptions(),
+	const TStereoSystemParams& params = TStereoSystemParams());
+
 /** Calculates the Sum of Absolutes Differences (range [0,1]) between two
  * patches. Both patches must have the same size.
   * \param mList    [IN]  The list of matched features.
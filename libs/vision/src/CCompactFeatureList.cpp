@@ -0,0 +1,189 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/CCompactFeatureList.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+namespace
+{
+/** Copies one type of descriptor of all the features, if all of them have
+ * it (see CCompactFeatureList::assign) */
+template <typename T, class GETTER>
+void assignDescriptors(
+	TDescriptorMatrix<T>& mat, const CFeatureList& feats, const bool wanted,
+	GETTER get_desc, const char* name)
+{
+	mat.clear();
+	if (!wanted || feats.empty()) return;
+
+	size_t n_with_desc = 0;
+	for (const auto& f : feats)
+		if (!get_desc(*f).empty()) n_with_desc++;
+	if (!n_with_desc) return;
+	if (n_with_desc != feats.size())
+		THROW_EXCEPTION_FMT(
+			"Only %u out of %u features have %s descriptors",
+			static_cast<unsigned>(n_with_desc),
+			static_cast<unsigned>(feats.size()), name);
+
+	mat.resize(feats.size(), get_desc(*feats[0]).size());
+	for (size_t i = 0; i < feats.size(); i++)
+		mat.setRow(i, get_desc(*feats[i]));
+}
+
+/** Appends the descriptor of a feature (see CCompactFeatureList::push_back)
+ */
+template <typename T>
+void pushDescriptor(
+	TDescriptorMatrix<T>& mat, const size_t n_feats,
+	const std::vector<T>& desc, const char* name)
+{
+	if (!n_feats && !desc.empty()) mat.resize(0, desc.size());
+	ASSERTMSG_(
+		desc.size() == mat.cols(),
+		mrpt::format(
+			"All the features must have %s descriptors of the same length",
+			name));
+	if (mat.empty()) return;
+	mat.resizeRows(n_feats + 1);
+	mat.setRow(n_feats, desc);
+}
+}  // namespace
+
+void CCompactFeatureList::clear()
+{
+	resize(0);
+	SIFT.clear();
+	SURF.clear();
+	ORB.clear();
+}
+
+void CCompactFeatureList::resize(const size_t N)
+{
+	x.resize(N, 0);
+	y.resize(N, 0);
+	ID.resize(N, 0);
+	type.resize(N, featNotDefined);
+	track_status.resize(N, status_IDLE);
+	response.resize(N, 0);
+	orientation.resize(N, 0);
+	scale.resize(N, 0);
+	if (!SIFT.empty()) SIFT.resizeRows(N);
+	if (!SURF.empty()) SURF.resizeRows(N);
+	if (!ORB.empty()) ORB.resizeRows(N);
+}
+
+void CCompactFeatureList::reserve(const size_t N)
+{
+	x.reserve(N);
+	y.reserve(N);
+	ID.reserve(N);
+	type.reserve(N);
+	track_status.reserve(N);
+	response.reserve(N);
+	orientation.reserve(N);
+	scale.reserve(N);
+	SIFT.reserveRows(N);
+	SURF.reserveRows(N);
+	ORB.reserveRows(N);
+}
+
+void CCompactFeatureList::push_back(const CFeature& f)
+{
+	MRPT_START
+	const size_t N = size();
+	pushDescriptor(SIFT, N, f.descriptors.SIFT, "SIFT");
+	pushDescriptor(SURF, N, f.descriptors.SURF, "SURF");
+	pushDescriptor(ORB, N, f.descriptors.ORB, "ORB");
+
+	x.push_back(f.x);
+	y.push_back(f.y);
+	ID.push_back(f.ID);
+	type.push_back(f.type);
+	track_status.push_back(f.track_status);
+	response.push_back(f.response);
+	orientation.push_back(f.orientation);
+	scale.push_back(f.scale);
+	MRPT_END
+}
+
+void CCompactFeatureList::assign(
+	const CFeatureList& feats, const unsigned int descriptors)
+{
+	MRPT_START
+	const size_t N = feats.size();
+	x.resize(N);
+	y.resize(N);
+	ID.resize(N);
+	type.resize(N);
+	track_status.resize(N);
+	response.resize(N);
+	orientation.resize(N);
+	scale.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const CFeature& f = *feats[i];
+		x[i] = f.x;
+		y[i] = f.y;
+		ID[i] = f.ID;
+		type[i] = f.type;
+		track_status[i] = f.track_status;
+		response[i] = f.response;
+		orientation[i] = f.orientation;
+		scale[i] = f.scale;
+	}
+
+	assignDescriptors(
+		SIFT, feats, (descriptors & descSIFT) != 0,
+		[](const CFeature& f) -> const std::vector<uint8_t>& {
+			return f.descriptors.SIFT;
+		},
+		"SIFT");
+	assignDescriptors(
+		SURF, feats, (descriptors & descSURF) != 0,
+		[](const CFeature& f) -> const std::vector<float>& {
+			return f.descriptors.SURF;
+		},
+		"SURF");
+	assignDescriptors(
+		ORB, feats, (descriptors & descORB) != 0,
+		[](const CFeature& f) -> const std::vector<uint8_t>& {
+			return f.descriptors.ORB;
+		},
+		"ORB");
+	MRPT_END
+}
+
+void CCompactFeatureList::getAsFeatureList(CFeatureList& feats) const
+{
+	const size_t N = size();
+	feats.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		CFeature::Ptr f = std::make_shared<CFeature>();
+		f->x = x[i];
+		f->y = y[i];
+		f->ID = ID[i];
+		f->type = type[i];
+		f->track_status = track_status[i];
+		f->response = response[i];
+		f->orientation = orientation[i];
+		f->scale = scale[i];
+		f->patchSize = 0;
+		if (!SIFT.empty()) SIFT.getRow(i, f->descriptors.SIFT);
+		if (!SURF.empty()) SURF.getRow(i, f->descriptors.SURF);
+		if (!ORB.empty()) ORB.getRow(i, f->descriptors.ORB);
+		feats[i] = f;
+	}
+}
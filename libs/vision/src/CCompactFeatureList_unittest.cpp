@@ -0,0 +1,234 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CCompactFeatureList.h>
+#include <mrpt/vision/utils.h>
+#include <mrpt/vision/descriptor_kdtrees.h>
+#include <mrpt/vision/descriptor_pairing.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::random;
+using namespace std;
+
+// Features with random coordinates and descriptors (SIFT of 128 bytes, SURF
+// of 64 floats, and ORB of 30 bytes, which is not a multiple of 16):
+static void createFeatures(
+	const size_t N, CFeatureList& feats, const unsigned int descriptors)
+{
+	feats.clear();
+	for (size_t i = 0; i < N; i++)
+	{
+		CFeature::Ptr f = std::make_shared<CFeature>();
+		f->ID = 100 + i;
+		f->type = featORB;
+		f->x = randomGenerator.drawUniform(0, 640);
+		f->y = randomGenerator.drawUniform(0, 480);
+		f->response = randomGenerator.drawUniform(0, 1);
+		f->orientation = randomGenerator.drawUniform(-M_PI, M_PI);
+		f->scale = i % 4;
+		if (descriptors & descSIFT)
+		{
+			f->descriptors.SIFT.resize(128);
+			for (auto& v : f->descriptors.SIFT)
+				v = randomGenerator.drawUniform32bit() % 256;
+		}
+		if (descriptors & descSURF)
+		{
+			f->descriptors.SURF.resize(64);
+			for (auto& v : f->descriptors.SURF)
+				v = randomGenerator.drawUniform(-0.1, 0.1);
+		}
+		if (descriptors & descORB)
+		{
+			f->descriptors.ORB.resize(30);
+			for (auto& v : f->descriptors.ORB)
+				v = randomGenerator.drawUniform32bit() % 256;
+		}
+		feats.push_back(f);
+	}
+}
+
+template <typename T>
+static void checkMatrixLayout(const TDescriptorMatrix<T>& m)
+{
+	EXPECT_EQ(m.stride() * sizeof(T) % 16, 0U);
+	EXPECT_GE(m.stride(), m.cols());
+	for (size_t i = 0; i < m.rows(); i++)
+	{
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(m[i]) % 16, 0U);
+		for (size_t k = m.cols(); k < m.stride(); k++)
+			EXPECT_EQ(m[i][k], T(0));
+	}
+}
+
+TEST(CCompactFeatureList, ConversionRoundTrip)
+{
+	randomGenerator.randomize(1);
+	CFeatureList feats;
+	createFeatures(50, feats, descSIFT | descSURF | descORB);
+
+	const CCompactFeatureList compact(feats);
+	ASSERT_EQ(compact.size(), feats.size());
+	EXPECT_TRUE(compact.hasDescriptorSIFT());
+	EXPECT_TRUE(compact.hasDescriptorSURF());
+	EXPECT_TRUE(compact.hasDescriptorORB());
+	EXPECT_EQ(compact.ORB.cols(), 30U);
+	EXPECT_EQ(compact.ORB.stride(), 32U);
+	checkMatrixLayout(compact.SIFT);
+	checkMatrixLayout(compact.SURF);
+	checkMatrixLayout(compact.ORB);
+
+	CFeatureList feats2;
+	compact.getAsFeatureList(feats2);
+	ASSERT_EQ(feats2.size(), feats.size());
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		const CFeature &f1 = *feats[i], &f2 = *feats2[i];
+		EXPECT_EQ(f1.ID, f2.ID);
+		EXPECT_EQ(f1.type, f2.type);
+		EXPECT_EQ(f1.x, f2.x);
+		EXPECT_EQ(f1.y, f2.y);
+		EXPECT_EQ(f1.response, f2.response);
+		EXPECT_EQ(f1.orientation, f2.orientation);
+		EXPECT_EQ(f1.scale, f2.scale);
+		EXPECT_TRUE(f1.descriptors.SIFT == f2.descriptors.SIFT);
+		EXPECT_TRUE(f1.descriptors.SURF == f2.descriptors.SURF);
+		EXPECT_TRUE(f1.descriptors.ORB == f2.descriptors.ORB);
+	}
+
+	// Only some of the descriptors:
+	const CCompactFeatureList only_orb(feats, descORB);
+	EXPECT_FALSE(only_orb.hasDescriptorSIFT());
+	EXPECT_FALSE(only_orb.hasDescriptorSURF());
+	EXPECT_TRUE(only_orb.hasDescriptorORB());
+
+	// Appending features one by one:
+	CCompactFeatureList appended;
+	for (const auto& f : feats) appended.push_back(*f);
+	ASSERT_EQ(appended.size(), feats.size());
+	checkMatrixLayout(appended.ORB);
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		EXPECT_EQ(appended.x[i], compact.x[i]);
+		EXPECT_TRUE(
+			std::equal(
+				compact.SIFT[i], compact.SIFT[i] + compact.SIFT.stride(),
+				appended.SIFT[i]));
+	}
+}
+
+TEST(CCompactFeatureList, MixedDescriptorsThrow)
+{
+	randomGenerator.randomize(2);
+	CFeatureList feats;
+	createFeatures(10, feats, descORB);
+	feats[3]->descriptors.ORB.clear();
+	CCompactFeatureList compact;
+	EXPECT_ANY_THROW(compact.assign(feats));
+	EXPECT_NO_THROW(compact.assign(feats, descSIFT | descSURF));
+
+	createFeatures(10, feats, descORB);
+	feats[3]->descriptors.ORB.resize(16);
+	EXPECT_ANY_THROW(compact.assign(feats));
+}
+
+TEST(CCompactFeatureList, MatchFeaturesAsCFeatureList)
+{
+	randomGenerator.randomize(3);
+	for (const auto method : {TMatchingOptions::mmDescriptorORB,
+							  TMatchingOptions::mmDescriptorSURF})
+	{
+		CFeatureList list1, list2;
+		createFeatures(300, list1, descSURF | descORB);
+		createFeatures(300, list2, descSURF | descORB);
+		// Some features of list2 similar to those of list1, in the same rows:
+		for (size_t i = 0; i < 200; i++)
+		{
+			*list2[i] = *list1[i];
+			list2[i]->ID = 1000 + i;
+			list2[i]->x -= randomGenerator.drawUniform(1, 50);
+			list2[i]->y += randomGenerator.drawUniform(-1, 1);
+			list2[i]->descriptors.ORB[i % 30] ^= 0x11;
+			list2[i]->descriptors.SURF[i % 64] += 0.01f;
+		}
+
+		TMatchingOptions opts;
+		opts.matching_method = method;
+		opts.parallelOpticalAxis = true;
+		opts.useXRestriction = true;
+
+		CMatchedFeatureList matches;
+		const size_t n = matchFeatures(list1, list2, matches, opts);
+		EXPECT_GT(n, 150U);
+
+		const CCompactFeatureList c1(list1), c2(list2);
+		std::vector<std::pair<size_t, size_t>> idx_matches;
+		EXPECT_EQ(matchFeatures(c1, c2, idx_matches, opts), n);
+
+		set<pair<TFeatureID, TFeatureID>> s1, s2;
+		for (const auto& m : matches)
+			s1.insert(make_pair(m.first->ID, m.second->ID));
+		for (const auto& m : idx_matches)
+			s2.insert(make_pair(c1.ID[m.first], c2.ID[m.second]));
+		EXPECT_TRUE(s1 == s2);
+	}
+}
+
+TEST(CCompactFeatureList, KDTreeAsCFeatureList)
+{
+	randomGenerator.randomize(4);
+	CFeatureList feats1, feats2;
+	createFeatures(100, feats1, descSIFT | descSURF);
+	createFeatures(200, feats2, descSIFT | descSURF);
+	const CCompactFeatureList compact1(feats1), compact2(feats2);
+
+	{
+		TSIFTDescriptorsKDTreeIndex<double> kd_list(feats2),
+			kd_compact(compact2);
+		std::vector<std::pair<size_t, size_t>> p_list, p_compact;
+		find_descriptor_pairings(
+			nullptr, &p_list, feats1, kd_list, descSIFT, 1);
+		find_descriptor_pairings(
+			nullptr, &p_compact, compact1, kd_compact, descSIFT, 1);
+		ASSERT_EQ(p_list.size(), feats1.size());
+		EXPECT_TRUE(p_list == p_compact);
+
+		// The nearest neighbor is found:
+		for (const auto& p : p_list)
+		{
+			double best = std::numeric_limits<double>::max();
+			size_t best_j = 0;
+			for (size_t j = 0; j < feats2.size(); j++)
+			{
+				const double d =
+					feats1[p.first]->descriptorSIFTDistanceTo(*feats2[j]);
+				if (d < best)
+				{
+					best = d;
+					best_j = j;
+				}
+			}
+			EXPECT_EQ(p.second, best_j);
+		}
+	}
+	{
+		TSURFDescriptorsKDTreeIndex<float> kd_list(feats2),
+			kd_compact(compact2);
+		std::vector<std::pair<size_t, size_t>> p_list, p_compact;
+		find_descriptor_pairings(
+			nullptr, &p_list, feats1, kd_list, descSURF, 1);
+		find_descriptor_pairings(
+			nullptr, &p_compact, compact1, kd_compact, descSURF, 1);
+		ASSERT_EQ(p_list.size(), feats1.size());
+		EXPECT_TRUE(p_list == p_compact);
+	}
+}
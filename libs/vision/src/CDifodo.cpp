@@ -12,8 +12,11 @@
 #include <mrpt/vision/CDifodo.h>
 #include <mrpt/utils/utils_defs.h>
 #include <mrpt/utils/CTicTac.h>
+#include <mrpt/utils/parallel.h>
 #include <mrpt/utils/round.h>
 
+#include <iostream>
+
 using namespace mrpt;
 using namespace mrpt::vision;
 using namespace mrpt::math;
@@ -22,6 +25,61 @@ using namespace Eigen;
 using mrpt::utils::round;
 using mrpt::math::square;
 
+namespace
+{
+/** Width of the blocks of columns processed by each job (the images are
+ * column-major) */
+const unsigned int BLOCK_COLS = 16;
+/** Smaller images are processed in the calling thread */
+const unsigned int MIN_PIXELS_FOR_THREADS = 16384;
+
+/** Runs `func(u0,u1,b)` for each block `b` of BLOCK_COLS columns [u0,u1) of
+ * a rows x cols image (0 threads: as many as cores) */
+template <class FUNCTOR>
+void for_each_column_block(
+	const unsigned int rows, const unsigned int cols,
+	unsigned int num_threads, FUNCTOR func)
+{
+	if (size_t(rows) * cols < MIN_PIXELS_FOR_THREADS) num_threads = 1;
+	const size_t num_blocks = (cols + BLOCK_COLS - 1) / BLOCK_COLS;
+	mrpt::utils::parallel_for_jobs(
+		num_blocks, num_threads,
+		[&](const size_t b) {
+			const unsigned int u0 = b * BLOCK_COLS;
+			func(u0, std::min(u0 + BLOCK_COLS, cols), b);
+		});
+}
+
+/** Spatial coordinates "xy" of the points of a depth image (0 for null
+ * depths) */
+void calculatePointsXY(
+	const MatrixXf& depth, const float fovh, const unsigned int num_threads,
+	MatrixXf& xx, MatrixXf& yy)
+{
+	const unsigned int rows = depth.rows(), cols = depth.cols();
+	const float inv_f_i = 2.f * tan(0.5f * fovh) / float(cols);
+	const float disp_u_i = 0.5f * (cols - 1);
+	const float disp_v_i = 0.5f * (rows - 1);
+	ArrayXf v_coef(rows);
+	for (unsigned int v = 0; v < rows; v++) v_coef(v) = v - disp_v_i;
+
+	xx.resize(rows, cols);
+	yy.resize(rows, cols);
+	for_each_column_block(
+		rows, cols, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, size_t) {
+			for (unsigned int u = u0; u < u1; u++)
+			{
+				const auto d = depth.col(u).array();
+				xx.col(u).array() =
+					(d > 0.f).select((u - disp_u_i) * d * inv_f_i, 0.f);
+				yy.col(u).array() =
+					(d > 0.f).select(v_coef * d * inv_f_i, 0.f);
+			}
+		});
+}
+}  // namespace
+
 CDifodo::CDifodo()
 {
 	rows = 60;
@@ -34,6 +92,7 @@ CDifodo::CDifodo()
 	width = 640 / (cam_mode * downsample);
 	height = 480 / (cam_mode * downsample);
 	fast_pyramid = true;
+	num_threads = 0;
 
 	// Resize pyramid
 	const unsigned int pyr_levels =
@@ -141,129 +200,131 @@ void CDifodo::buildCoordinatesPyramid()
 		//-----------------------------------------------------------------------------
 		else
 		{
-			for (unsigned int u = 0; u < cols_i; u++)
-				for (unsigned int v = 0; v < rows_i; v++)
-				{
-					const int u2 = 2 * u;
-					const int v2 = 2 * v;
-					const float dcenter = depth[i_1](v2, u2);
-
-					// Inner pixels
-					if ((v > 0) && (v < rows_i - 1) && (u > 0) &&
-						(u < cols_i - 1))
-					{
-						if (dcenter > 0.f)
+			const MatrixXf& prev = depth[i_1];
+			MatrixXf& cur = depth[i];
+
+			for_each_column_block(
+				rows_i, cols_i, num_threads,
+				[&](const unsigned int u0, const unsigned int u1, size_t) {
+					for (unsigned int u = u0; u < u1; u++)
+						for (unsigned int v = 0; v < rows_i; v++)
 						{
-							float sum = 0.f;
-							float weight = 0.f;
+							const int u2 = 2 * u;
+							const int v2 = 2 * v;
+							const float dcenter = prev(v2, u2);
 
-							for (int l = -2; l < 3; l++)
-								for (int k = -2; k < 3; k++)
+							// Inner pixels
+							if ((v > 0) && (v < rows_i - 1) && (u > 0) &&
+								(u < cols_i - 1))
+							{
+								if (dcenter > 0.f)
 								{
-									const float abs_dif = abs(
-										depth[i_1](v2 + k, u2 + l) - dcenter);
-									if (abs_dif < max_depth_dif)
-									{
-										const float aux_w =
-											g_mask[2 + k][2 + l] *
-											(max_depth_dif - abs_dif);
-										weight += aux_w;
-										sum +=
-											aux_w * depth[i_1](v2 + k, u2 + l);
-									}
+									float sum = 0.f;
+									float weight = 0.f;
+
+									for (int l = -2; l < 3; l++)
+										for (int k = -2; k < 3; k++)
+										{
+											const float abs_dif = abs(
+												prev(v2 + k, u2 + l) -
+												dcenter);
+											if (abs_dif < max_depth_dif)
+											{
+												const float aux_w =
+													g_mask[2 + k][2 + l] *
+													(max_depth_dif - abs_dif);
+												weight += aux_w;
+												sum += aux_w *
+													   prev(v2 + k, u2 + l);
+											}
+										}
+									cur(v, u) = sum / weight;
 								}
-							depth[i](v, u) = sum / weight;
-						}
-						else
-						{
-							float min_depth = 10.f;
-							for (int l = -2; l < 3; l++)
-								for (int k = -2; k < 3; k++)
+								else
 								{
-									const float d = depth[i_1](v2 + k, u2 + l);
-									if ((d > 0.f) && (d < min_depth))
-										min_depth = d;
+									float min_depth = 10.f;
+									for (int l = -2; l < 3; l++)
+										for (int k = -2; k < 3; k++)
+										{
+											const float d =
+												prev(v2 + k, u2 + l);
+											if ((d > 0.f) && (d < min_depth))
+												min_depth = d;
+										}
+
+									if (min_depth < 10.f)
+										cur(v, u) = min_depth;
+									else
+										cur(v, u) = 0.f;
 								}
+							}
 
-							if (min_depth < 10.f)
-								depth[i](v, u) = min_depth;
+							// Boundary
 							else
-								depth[i](v, u) = 0.f;
-						}
-					}
-
-					// Boundary
-					else
-					{
-						if (dcenter > 0.f)
-						{
-							float sum = 0.f;
-							float weight = 0.f;
-
-							for (int l = -2; l < 3; l++)
-								for (int k = -2; k < 3; k++)
+							{
+								if (dcenter > 0.f)
 								{
-									const int indv = v2 + k, indu = u2 + l;
-									if ((indv >= 0) && (indv < rows_i2) &&
-										(indu >= 0) && (indu < cols_i2))
-									{
-										const float abs_dif = abs(
-											depth[i_1](indv, indu) - dcenter);
-										if (abs_dif < max_depth_dif)
+									float sum = 0.f;
+									float weight = 0.f;
+
+									for (int l = -2; l < 3; l++)
+										for (int k = -2; k < 3; k++)
 										{
-											const float aux_w =
-												g_mask[2 + k][2 + l] *
-												(max_depth_dif - abs_dif);
-											weight += aux_w;
-											sum +=
-												aux_w * depth[i_1](indv, indu);
+											const int indv = v2 + k,
+													  indu = u2 + l;
+											if ((indv >= 0) &&
+												(indv < rows_i2) &&
+												(indu >= 0) && (indu < cols_i2))
+											{
+												const float abs_dif = abs(
+													prev(indv, indu) -
+													dcenter);
+												if (abs_dif < max_depth_dif)
+												{
+													const float aux_w =
+														g_mask[2 + k][2 + l] *
+														(max_depth_dif -
+														 abs_dif);
+													weight += aux_w;
+													sum += aux_w *
+														   prev(indv, indu);
+												}
+											}
 										}
-									}
+									cur(v, u) = sum / weight;
 								}
-							depth[i](v, u) = sum / weight;
-						}
-						else
-						{
-							float min_depth = 10.f;
-							for (int l = -2; l < 3; l++)
-								for (int k = -2; k < 3; k++)
+								else
 								{
-									const int indv = v2 + k, indu = u2 + l;
-									if ((indv >= 0) && (indv < rows_i2) &&
-										(indu >= 0) && (indu < cols_i2))
-									{
-										const float d = depth[i_1](indv, indu);
-										if ((d > 0.f) && (d < min_depth))
-											min_depth = d;
-									}
-								}
+									float min_depth = 10.f;
+									for (int l = -2; l < 3; l++)
+										for (int k = -2; k < 3; k++)
+										{
+											const int indv = v2 + k,
+													  indu = u2 + l;
+											if ((indv >= 0) &&
+												(indv < rows_i2) &&
+												(indu >= 0) && (indu < cols_i2))
+											{
+												const float d =
+													prev(indv, indu);
+												if ((d > 0.f) &&
+													(d < min_depth))
+													min_depth = d;
+											}
+										}
 
-							if (min_depth < 10.f)
-								depth[i](v, u) = min_depth;
-							else
-								depth[i](v, u) = 0.f;
+									if (min_depth < 10.f)
+										cur(v, u) = min_depth;
+									else
+										cur(v, u) = 0.f;
+								}
+							}
 						}
-					}
-				}
+				});
 		}
 
 		// Calculate coordinates "xy" of the points
-		const float inv_f_i = 2.f * tan(0.5f * fovh) / float(cols_i);
-		const float disp_u_i = 0.5f * (cols_i - 1);
-		const float disp_v_i = 0.5f * (rows_i - 1);
-
-		for (unsigned int u = 0; u < cols_i; u++)
-			for (unsigned int v = 0; v < rows_i; v++)
-				if (depth[i](v, u) > 0.f)
-				{
-					xx[i](v, u) = (u - disp_u_i) * depth[i](v, u) * inv_f_i;
-					yy[i](v, u) = (v - disp_v_i) * depth[i](v, u) * inv_f_i;
-				}
-				else
-				{
-					xx[i](v, u) = 0.f;
-					yy[i](v, u) = 0.f;
-				}
+		calculatePointsXY(depth[i], fovh, num_threads, xx[i], yy[i]);
 	}
 }
 
@@ -290,8 +351,6 @@ void CDifodo::buildCoordinatesPyramidFast()
 		unsigned int s = pow(2.f, int(i));
 		cols_i = width / s;
 		rows_i = height / s;
-		// const int rows_i2 = 2*rows_i;
-		// const int cols_i2 = 2*cols_i;
 		const int i_1 = i - 1;
 
 		if (i == 0) depth[i].swap(depth_wf);
@@ -300,91 +359,86 @@ void CDifodo::buildCoordinatesPyramidFast()
 		//-----------------------------------------------------------------------------
 		else
 		{
-			for (unsigned int u = 0; u < cols_i; u++)
-				for (unsigned int v = 0; v < rows_i; v++)
-				{
-					const int u2 = 2 * u;
-					const int v2 = 2 * v;
-
-					// Inner pixels
-					if ((v > 0) && (v < rows_i - 1) && (u > 0) &&
-						(u < cols_i - 1))
-					{
-						const Matrix4f d_block =
-							depth[i_1].block<4, 4>(v2 - 1, u2 - 1);
-						float depths[4] = {d_block(5), d_block(6), d_block(9),
-										   d_block(10)};
-						float dcenter;
-
-						// Sort the array (try to find a good/representative
-						// value)
-						for (signed char k = 2; k >= 0; k--)
-							if (depths[k + 1] < depths[k])
-								std::swap(depths[k + 1], depths[k]);
-						for (unsigned char k = 1; k < 3; k++)
-							if (depths[k] > depths[k + 1])
-								std::swap(depths[k + 1], depths[k]);
-						if (depths[2] < depths[1])
-							dcenter = depths[1];
-						else
-							dcenter = depths[2];
-
-						if (dcenter > 0.f)
+			const MatrixXf& prev = depth[i_1];
+			MatrixXf& cur = depth[i];
+
+			for_each_column_block(
+				rows_i, cols_i, num_threads,
+				[&](const unsigned int u0, const unsigned int u1, size_t) {
+					for (unsigned int u = u0; u < u1; u++)
+						for (unsigned int v = 0; v < rows_i; v++)
 						{
-							float sum = 0.f;
-							float weight = 0.f;
+							const int u2 = 2 * u;
+							const int v2 = 2 * v;
 
-							for (unsigned char k = 0; k < 16; k++)
+							// Inner pixels
+							if ((v > 0) && (v < rows_i - 1) && (u > 0) &&
+								(u < cols_i - 1))
 							{
-								const float abs_dif = abs(d_block(k) - dcenter);
-								if (abs_dif < max_depth_dif)
+								const Matrix4f d_block =
+									prev.block<4, 4>(v2 - 1, u2 - 1);
+								float depths[4] = {d_block(5), d_block(6),
+												   d_block(9), d_block(10)};
+								float dcenter;
+
+								// Sort the array (try to find a
+								// good/representative value)
+								for (signed char k = 2; k >= 0; k--)
+									if (depths[k + 1] < depths[k])
+										std::swap(depths[k + 1], depths[k]);
+								for (unsigned char k = 1; k < 3; k++)
+									if (depths[k] > depths[k + 1])
+										std::swap(depths[k + 1], depths[k]);
+								if (depths[2] < depths[1])
+									dcenter = depths[1];
+								else
+									dcenter = depths[2];
+
+								if (dcenter > 0.f)
 								{
-									const float aux_w =
-										f_mask(k) * (max_depth_dif - abs_dif);
-									weight += aux_w;
-									sum += aux_w * d_block(k);
+									float sum = 0.f;
+									float weight = 0.f;
+
+									for (unsigned char k = 0; k < 16; k++)
+									{
+										const float abs_dif =
+											abs(d_block(k) - dcenter);
+										if (abs_dif < max_depth_dif)
+										{
+											const float aux_w =
+												f_mask(k) *
+												(max_depth_dif - abs_dif);
+											weight += aux_w;
+											sum += aux_w * d_block(k);
+										}
+									}
+									cur(v, u) = sum / weight;
 								}
+								else
+									cur(v, u) = 0.f;
 							}
-							depth[i](v, u) = sum / weight;
-						}
-						else
-							depth[i](v, u) = 0.f;
-					}
 
-					// Boundary
-					else
-					{
-						const Matrix2f d_block = depth[i_1].block<2, 2>(v2, u2);
-						const float new_d = 0.25f * d_block.sumAll();
-						if (new_d < 0.4f)
-							depth[i](v, u) = 0.f;
-						else
-							depth[i](v, u) = new_d;
-					}
-				}
+							// Boundary
+							else
+							{
+								const Matrix2f d_block =
+									prev.block<2, 2>(v2, u2);
+								const float new_d = 0.25f * d_block.sumAll();
+								if (new_d < 0.4f)
+									cur(v, u) = 0.f;
+								else
+									cur(v, u) = new_d;
+							}
+						}
+				});
 		}
 
 		// Calculate coordinates "xy" of the points
-		const float inv_f_i = 2.f * tan(0.5f * fovh) / float(cols_i);
-		const float disp_u_i = 0.5f * (cols_i - 1);
-		const float disp_v_i = 0.5f * (rows_i - 1);
-
-		for (unsigned int u = 0; u < cols_i; u++)
-			for (unsigned int v = 0; v < rows_i; v++)
-				if (depth[i](v, u) > 0.f)
-				{
-					xx[i](v, u) = (u - disp_u_i) * depth[i](v, u) * inv_f_i;
-					yy[i](v, u) = (v - disp_v_i) * depth[i](v, u) * inv_f_i;
-				}
-				else
-				{
-					xx[i](v, u) = 0.f;
-					yy[i](v, u) = 0.f;
-				}
+		calculatePointsXY(depth[i], fovh, num_threads, xx[i], yy[i]);
 	}
 }
 
-void CDifodo::performWarping()
+void CDifodo::warpPoints()
 {
 	// Camera parameters (which also depend on the level resolution)
 	const float f = float(cols_i) / (2.f * tan(0.5f * fovh));
@@ -397,45 +451,92 @@ void CDifodo::performWarping()
 	for (unsigned int i = 1; i <= level; i++)
 		acu_trans = transformations[i - 1] * acu_trans;
 
-	MatrixXf wacu(rows_i, cols_i);
-	wacu.assign(0.f);
-	depth_warped[image_level].assign(0.f);
-
 	const float cols_lim = float(cols_i - 1);
 	const float rows_lim = float(rows_i - 1);
 
+	const MatrixXf& depth_l = depth[image_level];
+	const MatrixXf& xx_l = xx[image_level];
+	const MatrixXf& yy_l = yy[image_level];
+	m_warp_u.resize(rows_i, cols_i);
+	m_warp_v.resize(rows_i, cols_i);
+	m_warp_d.resize(rows_i, cols_i);
+
+	const size_t num_blocks = (cols_i + BLOCK_COLS - 1) / BLOCK_COLS;
+	m_splat_acc.resize(num_blocks);
+	m_splat_first_col.resize(num_blocks);
+	m_splat_last_col.resize(num_blocks);
+
 	//						Warping loop
 	//---------------------------------------------------------
-	for (unsigned int j = 0; j < cols_i; j++)
-		for (unsigned int i = 0; i < rows_i; i++)
-		{
-			const float z = depth[image_level](i, j);
-
-			if (z > 0.f)
+	// Each block of columns accumulates its warped pixels in its own buffer,
+	// which only covers the range of columns they fall in. They are gathered
+	// by finishWarpingAndCoord().
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, const size_t b) {
+			int first_col = cols_i, last_col = -1;
+			for (unsigned int j = u0; j < u1; j++)
 			{
-				// Transform point to the warped reference frame
-				const float depth_w = acu_trans(0, 0) * z +
-									  acu_trans(0, 1) * xx[image_level](i, j) +
-									  acu_trans(0, 2) * yy[image_level](i, j) +
-									  acu_trans(0, 3);
-				const float x_w = acu_trans(1, 0) * z +
-								  acu_trans(1, 1) * xx[image_level](i, j) +
-								  acu_trans(1, 2) * yy[image_level](i, j) +
-								  acu_trans(1, 3);
-				const float y_w = acu_trans(2, 0) * z +
-								  acu_trans(2, 1) * xx[image_level](i, j) +
-								  acu_trans(2, 2) * yy[image_level](i, j) +
-								  acu_trans(2, 3);
-
-				// Calculate warping
-				const float uwarp = f * x_w / depth_w + disp_u_i;
-				const float vwarp = f * y_w / depth_w + disp_v_i;
-
-				// The warped pixel (which is not integer in general)
-				// contributes to all the surrounding ones
-				if ((uwarp >= 0.f) && (uwarp < cols_lim) && (vwarp >= 0.f) &&
-					(vwarp < rows_lim))
+				const auto z = depth_l.col(j).array();
+				const auto x = xx_l.col(j).array();
+				const auto y = yy_l.col(j).array();
+				auto depth_w = m_warp_d.col(j).array();
+				auto uwarp = m_warp_u.col(j).array();
+				auto vwarp = m_warp_v.col(j).array();
+
+				// Transform point to the warped reference frame and calculate
+				// warping
+				depth_w = acu_trans(0, 0) * z + acu_trans(0, 1) * x +
+						  acu_trans(0, 2) * y + acu_trans(0, 3);
+				uwarp = f * (acu_trans(1, 0) * z + acu_trans(1, 1) * x +
+							 acu_trans(1, 2) * y + acu_trans(1, 3)) /
+							depth_w +
+						disp_u_i;
+				vwarp = f * (acu_trans(2, 0) * z + acu_trans(2, 1) * x +
+							 acu_trans(2, 2) * y + acu_trans(2, 3)) /
+							depth_w +
+						disp_v_i;
+
+				// Null points and points out of the image are marked with
+				// uwarp = -1
+				uwarp = (z > 0.f && uwarp >= 0.f && uwarp < cols_lim &&
+						 vwarp >= 0.f && vwarp < rows_lim)
+							.select(uwarp, -1.f);
+
+				for (unsigned int i = 0; i < rows_i; i++)
+					if (uwarp(i) >= 0.f)
+					{
+						first_col = std::min(first_col, int(uwarp(i)));
+						last_col = std::max(last_col, int(uwarp(i)) + 1);
+					}
+			}
+
+			m_splat_first_col[b] = first_col;
+			m_splat_last_col[b] = last_col;
+			if (last_col < first_col) return;
+
+			const size_t acc_size = size_t(last_col - first_col + 1) * rows_i;
+			std::vector<float>& acc = m_splat_acc[b];
+			acc.assign(2 * acc_size, 0.f);
+			float* acc_depth = &acc[0];
+			float* acc_weight = acc_depth + acc_size;
+			auto splat = [&](const int v, const int u, const float d,
+							 const float w) {
+				const size_t k = size_t(u - first_col) * rows_i + v;
+				acc_depth[k] += d;
+				acc_weight[k] += w;
+			};
+
+			for (unsigned int j = u0; j < u1; j++)
+				for (unsigned int i = 0; i < rows_i; i++)
 				{
+					const float uwarp = m_warp_u(i, j);
+					if (uwarp < 0.f) continue;
+					const float vwarp = m_warp_v(i, j);
+					const float depth_w = m_warp_d(i, j);
+
+					// The warped pixel (which is not integer in general)
+					// contributes to all the surrounding ones
 					const int uwarp_l = uwarp;
 					const int uwarp_r = uwarp_l + 1;
 					const int vwarp_d = vwarp;
@@ -446,174 +547,206 @@ void CDifodo::performWarping()
 					const float delta_d = vwarp - float(vwarp_d);
 
 					// Warped pixel very close to an integer value
-					if (abs(round(uwarp) - uwarp) + abs(round(vwarp) - vwarp) <
+					const float uwarp_round = std::round(uwarp);
+					const float vwarp_round = std::round(vwarp);
+					if (abs(uwarp_round - uwarp) + abs(vwarp_round - vwarp) <
 						0.05f)
 					{
-						depth_warped[image_level](round(vwarp), round(uwarp)) +=
-							depth_w;
-						wacu(round(vwarp), round(uwarp)) += 1.f;
+						splat(int(vwarp_round), int(uwarp_round), depth_w, 1.f);
 					}
 					else
 					{
 						const float w_ur = square(delta_l) + square(delta_d);
-						depth_warped[image_level](vwarp_u, uwarp_r) +=
-							w_ur * depth_w;
-						wacu(vwarp_u, uwarp_r) += w_ur;
+						splat(vwarp_u, uwarp_r, w_ur * depth_w, w_ur);
 
 						const float w_ul = square(delta_r) + square(delta_d);
-						depth_warped[image_level](vwarp_u, uwarp_l) +=
-							w_ul * depth_w;
-						wacu(vwarp_u, uwarp_l) += w_ul;
+						splat(vwarp_u, uwarp_l, w_ul * depth_w, w_ul);
 
 						const float w_dr = square(delta_l) + square(delta_u);
-						depth_warped[image_level](vwarp_d, uwarp_r) +=
-							w_dr * depth_w;
-						wacu(vwarp_d, uwarp_r) += w_dr;
+						splat(vwarp_d, uwarp_r, w_dr * depth_w, w_dr);
 
 						const float w_dl = square(delta_r) + square(delta_u);
-						depth_warped[image_level](vwarp_d, uwarp_l) +=
-							w_dl * depth_w;
-						wacu(vwarp_d, uwarp_l) += w_dl;
+						splat(vwarp_d, uwarp_l, w_dl * depth_w, w_dl);
 					}
 				}
-			}
-		}
+		});
+}
 
-	// Scale the averaged depth and compute spatial coordinates
+void CDifodo::finishWarpingAndCoord(
+	const bool finish_warping, const bool coord)
+{
+	const unsigned int l = image_level;
+	const float f = float(cols_i) / (2.f * tan(0.5f * fovh));
 	const float inv_f_i = 1.f / f;
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-		{
-			if (wacu(v, u) > 0.f)
-			{
-				depth_warped[image_level](v, u) /= wacu(v, u);
-				xx_warped[image_level](v, u) =
-					(u - disp_u_i) * depth_warped[image_level](v, u) * inv_f_i;
-				yy_warped[image_level](v, u) =
-					(v - disp_v_i) * depth_warped[image_level](v, u) * inv_f_i;
-			}
-			else
+	const float disp_u_i = 0.5f * float(cols_i - 1);
+	const float disp_v_i = 0.5f * float(rows_i - 1);
+	ArrayXf v_coef(rows_i);
+	for (unsigned int v = 0; v < rows_i; v++) v_coef(v) = v - disp_v_i;
+
+	if (finish_warping) m_warp_weights.resize(rows_i, cols_i);
+	if (coord)
+	{
+		null.resize(rows_i, cols_i);
+		dt.resize(rows_i, cols_i);
+	}
+	std::vector<unsigned int> block_valid_points(
+		(cols_i + BLOCK_COLS - 1) / BLOCK_COLS, 0);
+
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, const size_t b) {
+			for (unsigned int u = u0; u < u1; u++)
 			{
-				depth_warped[image_level](v, u) = 0.f;
-				xx_warped[image_level](v, u) = 0.f;
-				yy_warped[image_level](v, u) = 0.f;
+				if (finish_warping)
+				{
+					// Gather the depths warped by all the blocks of columns
+					// (in order, so results do not depend on the threads)
+					auto depth_w = depth_warped[l].col(u).array();
+					auto wacu = m_warp_weights.col(u).array();
+					depth_w.setZero();
+					wacu.setZero();
+					for (size_t k = 0; k < m_splat_acc.size(); k++)
+					{
+						const int first_col = m_splat_first_col[k];
+						const int last_col = m_splat_last_col[k];
+						if (int(u) < first_col || int(u) > last_col) continue;
+						const float* acc = &m_splat_acc[k][0];
+						const size_t acc_size =
+							size_t(last_col - first_col + 1) * rows_i;
+						const size_t col_start =
+							size_t(int(u) - first_col) * rows_i;
+						depth_w +=
+							Map<const ArrayXf>(acc + col_start, rows_i);
+						wacu += Map<const ArrayXf>(
+							acc + acc_size + col_start, rows_i);
+					}
+
+					// Scale the averaged depth and compute spatial coordinates
+					depth_w = (wacu > 0.f).select(depth_w / wacu, 0.f);
+					xx_warped[l].col(u).array() = (wacu > 0.f).select(
+						(u - disp_u_i) * depth_w * inv_f_i, 0.f);
+					yy_warped[l].col(u).array() =
+						(wacu > 0.f).select(v_coef * depth_w * inv_f_i, 0.f);
+				}
+
+				if (coord)
+				{
+					// "Average" coordinates, null measurements and temporal
+					// derivative
+					const auto d_old = depth_old[l].col(u).array();
+					const auto d_warped = depth_warped[l].col(u).array();
+					auto is_null = null.col(u).array();
+					is_null = (d_old == 0.f || d_warped == 0.f);
+
+					depth_inter[l].col(u).array() =
+						is_null.select(0.f, 0.5f * (d_old + d_warped));
+					xx_inter[l].col(u).array() = is_null.select(
+						0.f, 0.5f * (xx_old[l].col(u).array() +
+									 xx_warped[l].col(u).array()));
+					yy_inter[l].col(u).array() = is_null.select(
+						0.f, 0.5f * (yy_old[l].col(u).array() +
+									 yy_warped[l].col(u).array()));
+					dt.col(u).array() =
+						is_null.select(0.f, fps * (d_warped - d_old));
+
+					if ((u > 0) && (u < cols_i - 1))
+						block_valid_points[b] +=
+							rows_i - 2 - is_null.segment(1, rows_i - 2).count();
+				}
 			}
-		}
+		});
+
+	if (coord)
+	{
+		num_valid_points = 0;
+		for (unsigned int n : block_valid_points) num_valid_points += n;
+	}
 }
 
-void CDifodo::calculateCoord()
+void CDifodo::performWarping()
 {
-	null.resize(rows_i, cols_i);
-	null.assign(false);
-	num_valid_points = 0;
+	warpPoints();
+	finishWarpingAndCoord(true, false);
+}
 
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-		{
-			if ((depth_old[image_level](v, u)) == 0.f ||
-				(depth_warped[image_level](v, u) == 0.f))
-			{
-				depth_inter[image_level](v, u) = 0.f;
-				xx_inter[image_level](v, u) = 0.f;
-				yy_inter[image_level](v, u) = 0.f;
-				null(v, u) = true;
-			}
-			else
-			{
-				depth_inter[image_level](v, u) =
-					0.5f * (depth_old[image_level](v, u) +
-							depth_warped[image_level](v, u));
-				xx_inter[image_level](v, u) =
-					0.5f *
-					(xx_old[image_level](v, u) + xx_warped[image_level](v, u));
-				yy_inter[image_level](v, u) =
-					0.5f *
-					(yy_old[image_level](v, u) + yy_warped[image_level](v, u));
-				null(v, u) = false;
-				if ((u > 0) && (v > 0) && (u < cols_i - 1) && (v < rows_i - 1))
-					num_valid_points++;
-			}
-		}
+void CDifodo::calculateCoord() { finishWarpingAndCoord(false, true); }
+void CDifodo::performWarpingAndCoord()
+{
+	warpPoints();
+	finishWarpingAndCoord(true, true);
 }
 
 void CDifodo::calculateDepthDerivatives()
 {
-	dt.resize(rows_i, cols_i);
-	dt.assign(0.f);
+	const MatrixXf& d = depth_inter[image_level];
+	const MatrixXf& x = xx_inter[image_level];
+	const MatrixXf& y = yy_inter[image_level];
 	du.resize(rows_i, cols_i);
-	du.assign(0.f);
 	dv.resize(rows_i, cols_i);
-	dv.assign(0.f);
+	m_rx_ninv.resize(rows_i, cols_i);
+	m_ry_ninv.resize(rows_i, cols_i);
+	const unsigned int n = rows_i - 1;
 
 	// Compute connectivity
-	MatrixXf rx_ninv(rows_i, cols_i);
-	MatrixXf ry_ninv(rows_i, cols_i);
-	rx_ninv.assign(1.f);
-	ry_ninv.assign(1.f);
-
-	for (unsigned int u = 0; u < cols_i - 1; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-			if (null(v, u) == false)
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, size_t) {
+			for (unsigned int u = u0; u < u1; u++)
 			{
-				rx_ninv(v, u) = sqrtf(
-					square(
-						xx_inter[image_level](v, u + 1) -
-						xx_inter[image_level](v, u)) +
-					square(
-						depth_inter[image_level](v, u + 1) -
-						depth_inter[image_level](v, u)));
-			}
-
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i - 1; v++)
-			if (null(v, u) == false)
-			{
-				ry_ninv(v, u) = sqrtf(
-					square(
-						yy_inter[image_level](v + 1, u) -
-						yy_inter[image_level](v, u)) +
-					square(
-						depth_inter[image_level](v + 1, u) -
-						depth_inter[image_level](v, u)));
+				const auto is_null = null.col(u).array();
+				if (u < cols_i - 1)
+					m_rx_ninv.col(u).array() = is_null.select(
+						1.f, ((x.col(u + 1) - x.col(u)).array().square() +
+							  (d.col(u + 1) - d.col(u)).array().square())
+								 .sqrt());
+				else
+					m_rx_ninv.col(u).setConstant(1.f);
+
+				const auto yc = y.col(u).array();
+				const auto dc = d.col(u).array();
+				m_ry_ninv.col(u).head(n).array() = is_null.head(n).select(
+					1.f, ((yc.segment(1, n) - yc.head(n)).square() +
+						  (dc.segment(1, n) - dc.head(n)).square())
+							 .sqrt());
+				m_ry_ninv(n, u) = 1.f;
 			}
+		});
 
 	// Spatial derivatives
-	for (unsigned int v = 0; v < rows_i; v++)
-	{
-		for (unsigned int u = 1; u < cols_i - 1; u++)
-			if (null(v, u) == false)
-				du(v, u) =
-					(rx_ninv(v, u - 1) * (depth_inter[image_level](v, u + 1) -
-										  depth_inter[image_level](v, u)) +
-					 rx_ninv(v, u) * (depth_inter[image_level](v, u) -
-									  depth_inter[image_level](v, u - 1))) /
-					(rx_ninv(v, u) + rx_ninv(v, u - 1));
-
-		du(v, 0) = du(v, 1);
-		du(v, cols_i - 1) = du(v, cols_i - 2);
-	}
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, size_t) {
+			for (unsigned int u = u0; u < u1; u++)
+			{
+				const auto is_null = null.col(u).array();
+				const auto dc = d.col(u).array();
+				if ((u > 0) && (u < cols_i - 1))
+				{
+					const auto rx_l = m_rx_ninv.col(u - 1).array();
+					const auto rx_c = m_rx_ninv.col(u).array();
+					du.col(u).array() = is_null.select(
+						0.f, (rx_l * (d.col(u + 1).array() - dc) +
+							  rx_c * (dc - d.col(u - 1).array())) /
+								 (rx_c + rx_l));
+				}
 
-	for (unsigned int u = 0; u < cols_i; u++)
-	{
-		for (unsigned int v = 1; v < rows_i - 1; v++)
-			if (null(v, u) == false)
-				dv(v, u) =
-					(ry_ninv(v - 1, u) * (depth_inter[image_level](v + 1, u) -
-										  depth_inter[image_level](v, u)) +
-					 ry_ninv(v, u) * (depth_inter[image_level](v, u) -
-									  depth_inter[image_level](v - 1, u))) /
-					(ry_ninv(v, u) + ry_ninv(v - 1, u));
-
-		dv(0, u) = dv(1, u);
-		dv(rows_i - 1, u) = dv(rows_i - 2, u);
-	}
+				const auto ry_u = m_ry_ninv.col(u).head(n - 1).array();
+				const auto ry_c = m_ry_ninv.col(u).segment(1, n - 1).array();
+				dv.col(u).segment(1, n - 1).array() =
+					is_null.segment(1, n - 1)
+						.select(
+							0.f, (ry_u * (dc.segment(2, n - 1) -
+										  dc.segment(1, n - 1)) +
+								  ry_c * (dc.segment(1, n - 1) -
+										  dc.head(n - 1))) /
+									 (ry_c + ry_u));
+				dv(0, u) = dv(1, u);
+				dv(n, u) = dv(n - 1, u);
+			}
+		});
 
-	// Temporal derivative
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-			if (null(v, u) == false)
-				dt(v, u) = fps * (depth_warped[image_level](v, u) -
-								  depth_old[image_level](v, u));
+	du.col(0) = du.col(1);
+	du.col(cols_i - 1) = du.col(cols_i - 2);
 }
 
 void CDifodo::computeWeights()
@@ -646,108 +779,80 @@ void CDifodo::computeWeights()
 	const float k2dt = 5e-6f;
 	const float k2duv = 5e-6f;
 
-	for (unsigned int u = 1; u < cols_i - 1; u++)
-		for (unsigned int v = 1; v < rows_i - 1; v++)
-			if (null(v, u) == false)
-			{
-				//					Compute measurment error (simplified)
-				//-----------------------------------------------------------------------
-				const float z = depth_inter[image_level](v, u);
-				const float inv_d = 1.f / z;
-				// const float dycomp = du2(v,u)*f_inv_y*inv_d;
-				// const float dzcomp = dv2(v,u)*f_inv_z*inv_d;
-				const float z2 = z * z;
-				const float z4 = z2 * z2;
-
-				// const float var11 = kz2*z4;
-				// const float var12 =
-				// kz2*xx_inter[image_level](v,u)*z2*depth_inter[image_level](v,u);
-				// const float var13 =
-				// kz2*yy_inter[image_level](v,u)*z2*depth_inter[image_level](v,u);
-				// const float var22 =
-				// kz2*square(xx_inter[image_level](v,u))*z2;
-				// const float var23 =
-				// kz2*xx_inter[image_level](v,u)*yy_inter[image_level](v,u)*z2;
-				// const float var33 =
-				// kz2*square(yy_inter[image_level](v,u))*z2;
-				const float var44 = kz2 * z4 * square(fps);
-				const float var55 = kz2 * z4 * 0.25f;
-				const float var66 = var55;
-
-				// const float j1 =
-				// -2.f*inv_d*inv_d*(xx_inter[image_level](v,u)*dycomp +
-				// yy_inter[image_level](v,u)*dzcomp)*(kai_level[0] +
-				// yy_inter[image_level](v,u)*kai_level[4] -
-				// xx_inter[image_level](v,u)*kai_level[5])
-				//				+ inv_d*dycomp*(kai_level[1] -
-				// yy_inter[image_level](v,u)*kai_level[3]) +
-				// inv_d*dzcomp*(kai_level[2] +
-				// xx_inter[image_level](v,u)*kai_level[3]);
-				// const float j2 = inv_d*dycomp*(kai_level[0] +
-				// yy_inter[image_level](v,u)*kai_level[4] -
-				// 2.f*xx_inter[image_level](v,u)*kai_level[5]) -
-				// dzcomp*kai_level[3];
-				// const float j3 = inv_d*dzcomp*(kai_level[0] +
-				// 2.f*yy_inter[image_level](v,u)*kai_level[4] -
-				// xx_inter[image_level](v,u)*kai_level[5]) +
-				// dycomp*kai_level[3];
-
-				const float j4 = 1.f;
-				const float j5 =
-					xx_inter[image_level](v, u) * inv_d * inv_d * f_inv *
-						(kai_level[0] +
-						 yy_inter[image_level](v, u) * kai_level[4] -
-						 xx_inter[image_level](v, u) * kai_level[5]) +
-					inv_d * f_inv *
-						(-kai_level[1] - z * kai_level[5] +
-						 yy_inter[image_level](v, u) * kai_level[3]);
-				const float j6 =
-					yy_inter[image_level](v, u) * inv_d * inv_d * f_inv *
-						(kai_level[0] +
-						 yy_inter[image_level](v, u) * kai_level[4] -
-						 xx_inter[image_level](v, u) * kai_level[5]) +
-					inv_d * f_inv *
-						(-kai_level[2] + z * kai_level[4] -
-						 xx_inter[image_level](v, u) * kai_level[3]);
-
-				// error_measurement(v,u) = j1*(j1*var11+j2*var12+j3*var13) +
-				// j2*(j1*var12+j2*var22+j3*var23)
-				//						+j3*(j1*var13+j2*var23+j3*var33) +
-				// j4*j4*var44
-				//+
-				// j5*j5*var55 + j6*j6*var66;
-
-				const float error_m =
-					j4 * j4 * var44 + j5 * j5 * var55 + j6 * j6 * var66;
-
-				//					Compute linearization error
-				//-----------------------------------------------------------------------
-				const float ini_du = depth_old[image_level](v, u + 1) -
-									 depth_old[image_level](v, u - 1);
-				const float ini_dv = depth_old[image_level](v + 1, u) -
-									 depth_old[image_level](v - 1, u);
-				const float final_du = depth_warped[image_level](v, u + 1) -
-									   depth_warped[image_level](v, u - 1);
-				const float final_dv = depth_warped[image_level](v + 1, u) -
-									   depth_warped[image_level](v - 1, u);
-
-				const float dut = ini_du - final_du;
-				const float dvt = ini_dv - final_dv;
-				const float duu = du(v, u + 1) - du(v, u - 1);
-				const float dvv = dv(v + 1, u) - dv(v - 1, u);
-				const float dvu =
-					dv(v, u + 1) -
-					dv(v, u - 1);  // Completely equivalent to compute duv
-
-				const float error_l =
-					kdt * square(dt(v, u)) +
-					kduv * (square(du(v, u)) + square(dv(v, u))) +
-					k2dt * (square(dut) + square(dvt)) +
-					k2duv * (square(duu) + square(dvv) + square(dvu));
-
-				// Weight
-				weights(v, u) = sqrt(1.f / (error_m + error_l));
-			}
+	const MatrixXf& depth_inter_l = depth_inter[image_level];
+	const MatrixXf& xx_inter_l = xx_inter[image_level];
+	const MatrixXf& yy_inter_l = yy_inter[image_level];
+	const MatrixXf& depth_old_l = depth_old[image_level];
+	const MatrixXf& depth_warped_l = depth_warped[image_level];
+
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, size_t) {
+			for (unsigned int u = std::max(u0, 1U);
+				 u < std::min(u1, cols_i - 1); u++)
+				for (unsigned int v = 1; v < rows_i - 1; v++)
+					if (null(v, u) == false)
+					{
+						//			Compute measurment error (simplified)
+						//-------------------------------------------------------
+						const float z = depth_inter_l(v, u);
+						const float inv_d = 1.f / z;
+						const float z2 = z * z;
+						const float z4 = z2 * z2;
+
+						const float var44 = kz2 * z4 * square(fps);
+						const float var55 = kz2 * z4 * 0.25f;
+						const float var66 = var55;
+
+						const float x = xx_inter_l(v, u);
+						const float y = yy_inter_l(v, u);
+						const float j4 = 1.f;
+						const float j5 =
+							x * inv_d * inv_d * f_inv *
+								(kai_level[0] + y * kai_level[4] -
+								 x * kai_level[5]) +
+							inv_d * f_inv *
+								(-kai_level[1] - z * kai_level[5] +
+								 y * kai_level[3]);
+						const float j6 =
+							y * inv_d * inv_d * f_inv *
+								(kai_level[0] + y * kai_level[4] -
+								 x * kai_level[5]) +
+							inv_d * f_inv *
+								(-kai_level[2] + z * kai_level[4] -
+								 x * kai_level[3]);
+
+						const float error_m =
+							j4 * j4 * var44 + j5 * j5 * var55 + j6 * j6 * var66;
+
+						//			Compute linearization error
+						//-------------------------------------------------------
+						const float ini_du =
+							depth_old_l(v, u + 1) - depth_old_l(v, u - 1);
+						const float ini_dv =
+							depth_old_l(v + 1, u) - depth_old_l(v - 1, u);
+						const float final_du =
+							depth_warped_l(v, u + 1) - depth_warped_l(v, u - 1);
+						const float final_dv =
+							depth_warped_l(v + 1, u) - depth_warped_l(v - 1, u);
+
+						const float dut = ini_du - final_du;
+						const float dvt = ini_dv - final_dv;
+						const float duu = du(v, u + 1) - du(v, u - 1);
+						const float dvv = dv(v + 1, u) - dv(v - 1, u);
+						// Completely equivalent to compute duv
+						const float dvu = dv(v, u + 1) - dv(v, u - 1);
+
+						const float error_l =
+							kdt * square(dt(v, u)) +
+							kduv * (square(du(v, u)) + square(dv(v, u))) +
+							k2dt * (square(dut) + square(dvt)) +
+							k2duv * (square(duu) + square(dvv) + square(dvu));
+
+						// Weight
+						weights(v, u) = sqrt(1.f / (error_m + error_l));
+					}
+		});
 
 	// Normalize weights in the range [0,1]
 	const float inv_max = 1.f / weights.maximum();
@@ -758,42 +863,61 @@ void CDifodo::solveOneLevel()
 {
 	MatrixXf A(num_valid_points, 6);
 	MatrixXf B(num_valid_points, 1);
-	unsigned int cont = 0;
 
 	// Fill the matrix A and the vector B
 	// The order of the unknowns is (vz, vx, vy, wz, wx, wy)
 	// The points order will be (1,1), (1,2)...(1,cols-1), (2,1),
 	// (2,2)...(row-1,cols-1).
 
-	const float f_inv = float(cols_i) / (2.f * tan(0.5f * fovh));
-
+	// First row of each block of columns:
+	const size_t num_blocks = (cols_i + BLOCK_COLS - 1) / BLOCK_COLS;
+	std::vector<unsigned int> block_first_row(num_blocks + 1, 0);
 	for (unsigned int u = 1; u < cols_i - 1; u++)
-		for (unsigned int v = 1; v < rows_i - 1; v++)
-			if (null(v, u) == false)
-			{
-				// Precomputed expressions
-				const float d = depth_inter[image_level](v, u);
-				const float inv_d = 1.f / d;
-				const float x = xx_inter[image_level](v, u);
-				const float y = yy_inter[image_level](v, u);
-				const float dycomp = du(v, u) * f_inv * inv_d;
-				const float dzcomp = dv(v, u) * f_inv * inv_d;
-				const float tw = weights(v, u);
-
-				// Fill the matrix A
-				A(cont, 0) =
-					tw * (1.f + dycomp * x * inv_d + dzcomp * y * inv_d);
-				A(cont, 1) = tw * (-dycomp);
-				A(cont, 2) = tw * (-dzcomp);
-				A(cont, 3) = tw * (dycomp * y - dzcomp * x);
-				A(cont, 4) = tw * (y + dycomp * inv_d * y * x +
-								   dzcomp * (y * y * inv_d + d));
-				A(cont, 5) = tw * (-x - dycomp * (x * x * inv_d + d) -
-								   dzcomp * inv_d * y * x);
-				B(cont, 0) = tw * (-dt(v, u));
-
-				cont++;
-			}
+		block_first_row[u / BLOCK_COLS + 1] +=
+			rows_i - 2 - null.col(u).segment(1, rows_i - 2).count();
+	for (size_t b = 0; b < num_blocks; b++)
+		block_first_row[b + 1] += block_first_row[b];
+	ASSERT_(block_first_row[num_blocks] == num_valid_points);
+
+	const float f_inv = float(cols_i) / (2.f * tan(0.5f * fovh));
+	const MatrixXf& depth_inter_l = depth_inter[image_level];
+	const MatrixXf& xx_inter_l = xx_inter[image_level];
+	const MatrixXf& yy_inter_l = yy_inter[image_level];
+
+	for_each_column_block(
+		rows_i, cols_i, num_threads,
+		[&](const unsigned int u0, const unsigned int u1, const size_t b) {
+			unsigned int cont = block_first_row[b];
+			for (unsigned int u = std::max(u0, 1U);
+				 u < std::min(u1, cols_i - 1); u++)
+				for (unsigned int v = 1; v < rows_i - 1; v++)
+					if (null(v, u) == false)
+					{
+						// Precomputed expressions
+						const float d = depth_inter_l(v, u);
+						const float inv_d = 1.f / d;
+						const float x = xx_inter_l(v, u);
+						const float y = yy_inter_l(v, u);
+						const float dycomp = du(v, u) * f_inv * inv_d;
+						const float dzcomp = dv(v, u) * f_inv * inv_d;
+						const float tw = weights(v, u);
+
+						// Fill the matrix A
+						A(cont, 0) =
+							tw *
+							(1.f + dycomp * x * inv_d + dzcomp * y * inv_d);
+						A(cont, 1) = tw * (-dycomp);
+						A(cont, 2) = tw * (-dzcomp);
+						A(cont, 3) = tw * (dycomp * y - dzcomp * x);
+						A(cont, 4) = tw * (y + dycomp * inv_d * y * x +
+										   dzcomp * (y * y * inv_d + d));
+						A(cont, 5) = tw * (-x - dycomp * (x * x * inv_d + d) -
+										   dzcomp * inv_d * y * x);
+						B(cont, 0) = tw * (-dt(v, u));
+
+						cont++;
+					}
+		});
 
 	// Solve the linear system of equations using weighted least squares
 	MatrixXf AtA, AtB;
@@ -814,19 +938,23 @@ void CDifodo::solveOneLevel()
 
 void CDifodo::odometryCalculation()
 {
-	// Clock to measure the runtime
-	utils::CTicTac clock;
+	// Clocks to measure the runtime (of each stage)
+	utils::CTicTac clock, stage_clock;
 	clock.Tic();
+	stage_times = TStageTimes();
 
 	// Build the gaussian pyramid
 	if (fast_pyramid)
 		buildCoordinatesPyramidFast();
 	else
 		buildCoordinatesPyramid();
+	stage_times.pyramid = 1000.f * clock.Tac();
 
 	// Coarse-to-fines scheme
 	for (unsigned int i = 0; i < ctf_levels; i++)
 	{
+		stage_clock.Tic();
+
 		// Previous computations
 		transformations[i].setIdentity();
 
@@ -837,39 +965,60 @@ void CDifodo::odometryCalculation()
 		image_level =
 			ctf_levels - i + round(log(float(width / cols)) / log(2.f)) - 1;
 
-		// 1. Perform warping
+		// 1. Perform warping and 2. calculate inter coords, find null
+		// measurements and the temporal derivative
 		if (i == 0)
 		{
 			depth_warped[image_level] = depth[image_level];
 			xx_warped[image_level] = xx[image_level];
 			yy_warped[image_level] = yy[image_level];
+			calculateCoord();
 		}
 		else
-			performWarping();
-
-		// 2. Calculate inter coords and find null measurements
-		calculateCoord();
+			performWarpingAndCoord();
+		stage_times.warping += 1000.f * stage_clock.Tac();
 
 		// 3. Compute derivatives
+		stage_clock.Tic();
 		calculateDepthDerivatives();
+		stage_times.derivatives += 1000.f * stage_clock.Tac();
 
 		// 4. Compute weights
+		stage_clock.Tic();
 		computeWeights();
+		stage_times.weights += 1000.f * stage_clock.Tac();
 
 		// 5. Solve odometry
+		stage_clock.Tic();
 		if (num_valid_points > 6) solveOneLevel();
+		stage_times.solver += 1000.f * stage_clock.Tac();
 
 		// 6. Filter solution
+		stage_clock.Tic();
 		filterLevelSolution();
+		stage_times.filter += 1000.f * stage_clock.Tac();
 	}
 
 	// Update poses
+	stage_clock.Tic();
 	poseUpdate();
+	stage_times.filter += 1000.f * stage_clock.Tac();
 
 	// Save runtime
 	execution_time = 1000.f * clock.Tac();
 }
 
+void CDifodo::printRuntime() const
+{
+	cout << endl << "Difodo runtime(ms): " << execution_time;
+	cout << " (pyramid: " << stage_times.pyramid
+		 << ", warping: " << stage_times.warping
+		 << ", derivatives: " << stage_times.derivatives
+		 << ", weights: " << stage_times.weights
+		 << ", solver: " << stage_times.solver
+		 << ", filter: " << stage_times.filter << ")";
+}
+
 void CDifodo::filterLevelSolution()
 {
 	//		Calculate Eigenvalues and Eigenvectors
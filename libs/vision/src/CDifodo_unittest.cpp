@@ -0,0 +1,141 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CDifodo.h>
+#include <mrpt/utils/round.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+/** Camera displacement between frames (m), along its optical axis */
+static const float STEP = 0.02f;
+
+/** Depth frames rendered from a camera that moves STEP forward between
+ * frames, in front of a smooth surface x = 2 + f(y,z) */
+class CDifodoSynthetic : public CDifodo
+{
+   public:
+	CDifodoSynthetic(const unsigned int nthreads) : frame(0)
+	{
+		num_threads = nthreads;
+		fps = 30.f;
+		fast_pyramid = false;
+		// (the finest level is large enough to be processed in parallel)
+		rows = 120;
+		cols = 160;
+		ctf_levels = 3;
+		width = 320;
+		height = 240;
+
+		// Resize pyramid
+		const unsigned int pyr_levels =
+			utils::round(log(float(width / cols)) / log(2.f)) + ctf_levels;
+		for (auto v : {&depth, &depth_old, &depth_inter, &depth_warped, &xx,
+					   &xx_inter, &xx_old, &xx_warped, &yy, &yy_inter,
+					   &yy_old, &yy_warped})
+			v->resize(pyr_levels);
+		transformations.resize(pyr_levels);
+		for (unsigned int i = 0; i < pyr_levels; i++)
+		{
+			const unsigned int s = 1 << i;
+			cols_i = width / s;
+			rows_i = height / s;
+			for (auto v : {&depth, &depth_old, &depth_inter, &xx, &xx_inter,
+						   &xx_old, &yy, &yy_inter, &yy_old})
+			{
+				(*v)[i].resize(rows_i, cols_i);
+				(*v)[i].setZero();
+			}
+			transformations[i].resize(4, 4);
+			if (cols_i <= cols)
+			{
+				depth_warped[i].resize(rows_i, cols_i);
+				xx_warped[i].resize(rows_i, cols_i);
+				yy_warped[i].resize(rows_i, cols_i);
+			}
+		}
+		depth_wf.setSize(height, width);
+
+		// First frame
+		loadFrame();
+		buildCoordinatesPyramid();
+		cam_oldpose = cam_pose;
+	}
+
+	void loadFrame() override
+	{
+		const float cam_x = STEP * frame++;
+		const float inv_f = 2.f * tan(0.5f * fovh) / float(width);
+		for (unsigned int v = 0; v < height; v++)
+			for (unsigned int u = 0; u < width; u++)
+			{
+				// Intersect the ray of the pixel with the surface:
+				const float ry = (u - 0.5f * (width - 1)) * inv_f;
+				const float rz = (v - 0.5f * (height - 1)) * inv_f;
+				float d = 2.f - cam_x;
+				for (int it = 0; it < 30; it++)
+					d = 2.f - cam_x + surface(d * ry, d * rz);
+				depth_wf(v, u) = d;
+			}
+	}
+
+   private:
+	unsigned int frame;
+
+	static float surface(const float y, const float z)
+	{
+		return 0.15f * sin(4.f * y) * cos(3.f * z) +
+			   0.05f * sin(9.f * y + 7.f * z);
+	}
+};
+
+TEST(CDifodo, KnownMotion)
+{
+	CDifodoSynthetic odo(1);
+	const unsigned int num_frames = 10;
+	for (unsigned int i = 0; i < num_frames; i++)
+	{
+		odo.loadFrame();
+		odo.odometryCalculation();
+	}
+
+	// The camera moves forward, along its "x" axis:
+	const auto speed = odo.getLastSpeedAbs();
+	EXPECT_NEAR(speed(0), STEP * odo.fps, 0.05 * STEP * odo.fps);
+	for (int i = 1; i < 6; i++) EXPECT_NEAR(speed(i), 0, 0.05);
+	EXPECT_NEAR(odo.cam_pose.x(), STEP * num_frames, 0.05 * STEP * num_frames);
+	EXPECT_NEAR(odo.cam_pose.y(), 0, 0.02);
+	EXPECT_NEAR(odo.cam_pose.z(), 0, 0.02);
+}
+
+TEST(CDifodo, SameResultsWithAnyNumberOfThreads)
+{
+	CDifodoSynthetic odo1(1);
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		odo1.loadFrame();
+		odo1.odometryCalculation();
+	}
+	for (unsigned int num_threads = 2; num_threads <= 4; num_threads++)
+	{
+		CDifodoSynthetic odo2(num_threads);
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			odo2.loadFrame();
+			odo2.odometryCalculation();
+		}
+		EXPECT_EQ(odo1.num_valid_points, odo2.num_valid_points);
+		EXPECT_EQ(odo1.getSolverSolution(), odo2.getSolverSolution());
+		EXPECT_EQ(odo1.getLastSpeedAbs(), odo2.getLastSpeedAbs());
+		EXPECT_EQ(odo1.cam_pose, odo2.cam_pose);
+	}
+}
@@ -10,6 +10,7 @@
 #include "vision-precomp.h"  // Precompiled headers
 
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <cstring>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
@@ -20,90 +21,52 @@ using namespace mrpt::vision;
 using namespace mrpt::system;
 using namespace std;
 
-/************************************************************************************************
-*								extractFeaturesORB
-**
-************************************************************************************************/
-void CFeatureExtraction::extractFeaturesORB(
-	const mrpt::utils::CImage& inImg, CFeatureList& feats,
-	const unsigned int init_ID, const unsigned int nDesiredFeatures,
-	const TImageROI& ROI) const
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x240
+namespace
+{
+/** Detects up to \a n_feats_2_extract ORB keypoints and computes their
+ * descriptors (one per row of \a cv_descs), or only computes the descriptors
+ * of the keypoints in \a cv_feats if \a use_precomputed_feats. */
+void detectAndComputeORB(
+	const CImage& inImg, const CFeatureExtraction::TOptions& options,
+	const size_t n_feats_2_extract, vector<cv::KeyPoint>& cv_feats,
+	cv::Mat& cv_descs, const bool use_precomputed_feats)
 {
-	MRPT_UNUSED_PARAM(ROI);
-	MRPT_START
-
-#if MRPT_HAS_OPENCV
-#if MRPT_OPENCV_VERSION_NUM < 0x240
-	THROW_EXCEPTION("This function requires OpenCV > 2.4.0")
-#else
-
 	using namespace cv;
 
-	vector<KeyPoint> cv_feats;  // OpenCV keypoint output vector
-	Mat cv_descs;  // OpenCV descriptor output
-
-	const bool use_precomputed_feats = feats.size() > 0;
-
-	if (use_precomputed_feats)
-	{
-		cv_feats.resize(feats.size());
-		for (size_t k = 0; k < cv_feats.size(); ++k)
-		{
-			cv_feats[k].pt.x = feats[k]->x;
-			cv_feats[k].pt.y = feats[k]->y;
-		}
-	}
-
 	// Make sure we operate on a gray-scale version of the image:
 	const CImage inImg_gray(inImg, FAST_REF_OR_CONVERT_TO_GRAY);
 	const Mat cvImg = cv::cvarrToMat(inImg_gray.getAs<IplImage>());
 
 // The detector and descriptor
 #if MRPT_OPENCV_VERSION_NUM < 0x300
+	MRPT_UNUSED_PARAM(options);
+	MRPT_UNUSED_PARAM(n_feats_2_extract);
 	Ptr<Feature2D> orb = Algorithm::create<Feature2D>("Feature2D.ORB");
 	orb->operator()(cvImg, Mat(), cv_feats, cv_descs, use_precomputed_feats);
 #else
-	const size_t n_feats_2_extract =
-		nDesiredFeatures == 0 ? 1000 : 3 * nDesiredFeatures;
 	Ptr<cv::ORB> orb = cv::ORB::create(
 		n_feats_2_extract, options.ORBOptions.scale_factor,
 		options.ORBOptions.n_levels);
 	orb->detectAndCompute(
 		cvImg, Mat(), cv_feats, cv_descs, use_precomputed_feats);
 #endif
+}
 
-	const size_t n_feats = cv_feats.size();
+/** Selects, by decreasing response, up to \a nDesiredFeatures (0: all) of
+ * the detected keypoints that fulfill the options in \a
+ * options.ORBOptions, calling `add_feature(index_in_cv_feats)` for each one.
+ */
+template <class FUNCTOR>
+void selectORBKeypoints(
+	const CImage& inImg, const CFeatureExtraction::TOptions& options,
+	const vector<cv::KeyPoint>& cv_feats, const unsigned int nDesiredFeatures,
+	FUNCTOR add_feature)
+{
+	using namespace cv;
 
-	// if we had input features, just convert cv_feats to CFeatures and return
+	const size_t n_feats = cv_feats.size();
 	const unsigned int patch_size_2 = options.patchSize / 2;
-	unsigned int f_id = init_ID;
-	if (use_precomputed_feats)
-	{
-		for (size_t k = 0; k < n_feats; ++k)
-		{
-			feats[k]->descriptors.ORB.resize(cv_descs.cols);
-			for (int m = 0; m < cv_descs.cols; ++m)
-				feats[k]->descriptors.ORB[m] =
-					cv_descs.at<uchar>(k, m);  // to do: memcopy
-
-			/*
-			feats[k].response	= cv_feats[k].response;
-			feats[k].scale		= cv_feats[k].size;
-			feats[k].angle		= cv_feats[k].orientation;
-			feats[k].ID			= f_id++;
-			*/
-			feats[k]->type = featORB;
-
-			if (options.ORBOptions.extract_patch && options.patchSize > 0)
-			{
-				inImg.extract_patch(
-					feats[k]->patch, round(feats[k]->x) - patch_size_2,
-					round(feats[k]->y) - patch_size_2, options.patchSize,
-					options.patchSize);
-			}
-		}
-		return;
-	}
 
 	//  1) Sort the fearues by "response": It's ~100 times faster to sort a list
 	//  of
@@ -116,7 +79,7 @@ void CFeatureExtraction::extractFeaturesORB(
 		KeypointResponseSorter<vector<KeyPoint>>(cv_feats));
 
 	//  2) Filter by "min-distance" (in options.ORBOptions.min_distance)
-	//  3) Convert to MRPT CFeatureList format.
+	//  3) Pass the accepted ones to add_feature().
 	// Steps 2 & 3 are done together in the while() below.
 	// The "min-distance" filter is done by means of a 2D binary matrix where
 	// each cell is marked when one
@@ -149,9 +112,6 @@ void CFeatureExtraction::extractFeaturesORB(
 								   ? std::min(size_t(nDesiredFeatures), n_feats)
 								   : n_feats;
 
-	if (!options.addNewFeatures) feats.clear();
-	// feats.reserve( feats.size() + n_max_feats );
-
 	const size_t imgH = inImg.getHeight();
 	const size_t imgW = inImg.getWidth();
 	size_t k = 0;
@@ -201,35 +161,198 @@ void CFeatureExtraction::extractFeaturesORB(
 		}
 
 		// All tests passed: add new feature:
-		CFeature::Ptr ft = std::make_shared<CFeature>();
-		ft->type = featORB;
-		ft->ID = f_id++;
-		ft->x = kp.pt.x;
-		ft->y = kp.pt.y;
-		ft->response = kp.response;
-		ft->orientation = kp.angle;
-		ft->scale = kp.octave;
-		ft->patchSize = 0;
-
-		// descriptor
-		ft->descriptors.ORB.resize(cv_descs.cols);
-		for (int m = 0; m < cv_descs.cols; ++m)
-			ft->descriptors.ORB[m] = cv_descs.at<uchar>(idx, m);
+		add_feature(idx);
+		c_feats++;
+	}
+}
+}  // namespace
+#endif
 
-		if (options.ORBOptions.extract_patch && options.patchSize > 0)
+/************************************************************************************************
+*								extractFeaturesORB
+**
+************************************************************************************************/
+void CFeatureExtraction::extractFeaturesORB(
+	const mrpt::utils::CImage& inImg, CFeatureList& feats,
+	const unsigned int init_ID, const unsigned int nDesiredFeatures,
+	const TImageROI& ROI) const
+{
+	MRPT_UNUSED_PARAM(ROI);
+	MRPT_START
+
+#if MRPT_HAS_OPENCV
+#if MRPT_OPENCV_VERSION_NUM < 0x240
+	THROW_EXCEPTION("This function requires OpenCV > 2.4.0")
+#else
+
+	using namespace cv;
+
+	vector<KeyPoint> cv_feats;  // OpenCV keypoint output vector
+	Mat cv_descs;  // OpenCV descriptor output
+
+	const bool use_precomputed_feats = feats.size() > 0;
+
+	if (use_precomputed_feats)
+	{
+		cv_feats.resize(feats.size());
+		for (size_t k = 0; k < cv_feats.size(); ++k)
+		{
+			cv_feats[k].pt.x = feats[k]->x;
+			cv_feats[k].pt.y = feats[k]->y;
+		}
+	}
+
+	detectAndComputeORB(
+		inImg, options, nDesiredFeatures == 0 ? 1000 : 3 * nDesiredFeatures,
+		cv_feats, cv_descs, use_precomputed_feats);
+
+	const size_t n_feats = cv_feats.size();
+
+	// if we had input features, just convert cv_feats to CFeatures and return
+	const unsigned int patch_size_2 = options.patchSize / 2;
+	unsigned int f_id = init_ID;
+	if (use_precomputed_feats)
+	{
+		for (size_t k = 0; k < n_feats; ++k)
 		{
-			ft->patchSize = options.patchSize;  // The size of the feature patch
+			feats[k]->descriptors.ORB.assign(
+				cv_descs.ptr<uchar>(k), cv_descs.ptr<uchar>(k) + cv_descs.cols);
+
+			/*
+			feats[k].response	= cv_feats[k].response;
+			feats[k].scale		= cv_feats[k].size;
+			feats[k].angle		= cv_feats[k].orientation;
+			feats[k].ID			= f_id++;
+			*/
+			feats[k]->type = featORB;
 
-			inImg.extract_patch(
-				ft->patch, round(ft->x) - patch_size_2,
-				round(ft->y) - patch_size_2, options.patchSize,
-				options.patchSize);  // Image patch surronding the feature
+			if (options.ORBOptions.extract_patch && options.patchSize > 0)
+			{
+				inImg.extract_patch(
+					feats[k]->patch, round(feats[k]->x) - patch_size_2,
+					round(feats[k]->y) - patch_size_2, options.patchSize,
+					options.patchSize);
+			}
 		}
+		return;
+	}
 
-		feats.push_back(ft);
-		c_feats++;
+	if (!options.addNewFeatures) feats.clear();
+	// feats.reserve( feats.size() + n_max_feats );
+
+	// Filter and convert to MRPT CFeatureList format:
+	selectORBKeypoints(
+		inImg, options, cv_feats, nDesiredFeatures, [&](const size_t idx) {
+			const KeyPoint& kp = cv_feats[idx];
+			CFeature::Ptr ft = std::make_shared<CFeature>();
+			ft->type = featORB;
+			ft->ID = f_id++;
+			ft->x = kp.pt.x;
+			ft->y = kp.pt.y;
+			ft->response = kp.response;
+			ft->orientation = kp.angle;
+			ft->scale = kp.octave;
+			ft->patchSize = 0;
+
+			// descriptor
+			ft->descriptors.ORB.assign(
+				cv_descs.ptr<uchar>(idx),
+				cv_descs.ptr<uchar>(idx) + cv_descs.cols);
+
+			if (options.ORBOptions.extract_patch && options.patchSize > 0)
+			{
+				ft->patchSize =
+					options.patchSize;  // The size of the feature patch
+
+				inImg.extract_patch(
+					ft->patch, round(ft->x) - patch_size_2,
+					round(ft->y) - patch_size_2, options.patchSize,
+					options.patchSize);  // Image patch surronding the feature
+			}
+
+			feats.push_back(ft);
+		});
+#endif
+#endif
+	MRPT_END
+}
+
+void CFeatureExtraction::extractFeaturesORB(
+	const mrpt::utils::CImage& inImg, CCompactFeatureList& feats,
+	const unsigned int init_ID, const unsigned int nDesiredFeatures,
+	const TImageROI& ROI) const
+{
+	MRPT_UNUSED_PARAM(ROI);
+	MRPT_START
+
+#if MRPT_HAS_OPENCV
+#if MRPT_OPENCV_VERSION_NUM < 0x240
+	THROW_EXCEPTION("This function requires OpenCV > 2.4.0")
+#else
+
+	using namespace cv;
+
+	vector<KeyPoint> cv_feats;  // OpenCV keypoint output vector
+	Mat cv_descs;  // OpenCV descriptor output
+
+	const bool use_precomputed_feats = feats.size() > 0;
+
+	if (use_precomputed_feats)
+	{
+		cv_feats.resize(feats.size());
+		for (size_t k = 0; k < cv_feats.size(); ++k)
+		{
+			cv_feats[k].pt.x = feats.x[k];
+			cv_feats[k].pt.y = feats.y[k];
+		}
 	}
+
+	detectAndComputeORB(
+		inImg, options, nDesiredFeatures == 0 ? 1000 : 3 * nDesiredFeatures,
+		cv_feats, cv_descs, use_precomputed_feats);
+
+	const size_t desc_len = cv_descs.cols;
+
+	// if we had input features, just copy their descriptors and return
+	if (use_precomputed_feats)
+	{
+		const size_t n_feats = std::min(cv_feats.size(), feats.size());
+		feats.ORB.resize(feats.size(), desc_len);
+		for (size_t k = 0; k < n_feats; ++k)
+		{
+			std::memcpy(feats.ORB[k], cv_descs.ptr<uchar>(k), desc_len);
+			feats.type[k] = featORB;
+		}
+		return;
+	}
+
+	if (!options.addNewFeatures) feats.clear();
+	if (feats.empty()) feats.ORB.resize(0, desc_len);
+	ASSERT_EQUAL_(feats.ORB.cols(), desc_len);
+
+	// Filter and append to the arrays:
+	unsigned int f_id = init_ID;
+	selectORBKeypoints(
+		inImg, options, cv_feats, nDesiredFeatures, [&](const size_t idx) {
+			const KeyPoint& kp = cv_feats[idx];
+			const size_t i = feats.size();
+			feats.resize(i + 1);
+			feats.type[i] = featORB;
+			feats.ID[i] = f_id++;
+			feats.x[i] = kp.pt.x;
+			feats.y[i] = kp.pt.y;
+			feats.response[i] = kp.response;
+			feats.orientation[i] = kp.angle;
+			feats.scale[i] = kp.octave;
+			std::memcpy(feats.ORB[i], cv_descs.ptr<uchar>(idx), desc_len);
+		});
 #endif
+#else
+	MRPT_UNUSED_PARAM(inImg);
+	MRPT_UNUSED_PARAM(feats);
+	MRPT_UNUSED_PARAM(init_ID);
+	MRPT_UNUSED_PARAM(nDesiredFeatures);
+	THROW_EXCEPTION("MRPT has been compiled without OpenCV")
 #endif
 	MRPT_END
 }
@@ -244,7 +367,6 @@ void CFeatureExtraction::internal_computeORBDescriptors(
 	using namespace cv;
 
 	const size_t n_feats = in_features.size();
-	const CImage inImg_gray(in_img, FAST_REF_OR_CONVERT_TO_GRAY);
 
 	// convert from CFeatureList to vector<KeyPoint>
 	vector<KeyPoint> cv_feats(n_feats);
@@ -257,29 +379,57 @@ void CFeatureExtraction::internal_computeORBDescriptors(
 		kp.size = in_features[k]->scale;
 	}  // end-for
 
-	Mat cvImg(cv::cvarrToMat(inImg_gray.getAs<IplImage>()));
 	Mat cv_descs;
-
-#if MRPT_OPENCV_VERSION_NUM < 0x300
-	Ptr<Feature2D> orb = Algorithm::create<Feature2D>("Feature2D.ORB");
-	orb->operator()(
-		cvImg, Mat(), cv_feats, cv_descs, true /* use_precomputed_feats */);
-#else
-	Ptr<cv::ORB> orb = cv::ORB::create(
-		n_feats, options.ORBOptions.scale_factor, options.ORBOptions.n_levels);
-	orb->detectAndCompute(
-		cvImg, Mat(), cv_feats, cv_descs, true /* use_precomputed_feats */);
-#endif
+	detectAndComputeORB(
+		in_img, options, n_feats, cv_feats, cv_descs,
+		true /* use_precomputed_feats */);
 
 	// add descriptor to CFeatureList
 	for (size_t k = 0; k < n_feats; ++k)
 	{
-		in_features[k]->descriptors.ORB.resize(cv_descs.cols);
-		for (int i = 0; i < cv_descs.cols; ++i)
-			in_features[k]->descriptors.ORB[i] = cv_descs.at<uchar>(k, i);
-
+		in_features[k]->descriptors.ORB.assign(
+			cv_descs.ptr<uchar>(k), cv_descs.ptr<uchar>(k) + cv_descs.cols);
 	}  // end-for
 #endif
 #endif
 
 }  // end-internal_computeORBImageDescriptors
+
+void CFeatureExtraction::internal_computeORBDescriptors(
+	const CImage& in_img, CCompactFeatureList& in_features) const
+{
+#if MRPT_HAS_OPENCV
+#if MRPT_OPENCV_VERSION_NUM < 0x240
+	THROW_EXCEPTION("This function requires OpenCV > 2.4.0")
+#else
+	using namespace cv;
+
+	const size_t n_feats = in_features.size();
+
+	vector<KeyPoint> cv_feats(n_feats);
+	for (size_t k = 0; k < n_feats; ++k)
+	{
+		KeyPoint& kp = cv_feats[k];
+		kp.pt.x = in_features.x[k];
+		kp.pt.y = in_features.y[k];
+		kp.angle = in_features.orientation[k];
+		kp.size = in_features.scale[k];
+	}
+
+	Mat cv_descs;
+	detectAndComputeORB(
+		in_img, options, n_feats, cv_feats, cv_descs,
+		true /* use_precomputed_feats */);
+
+	// Copy the descriptors, row by row, into the matrix of the list:
+	const size_t desc_len = cv_descs.cols;
+	in_features.ORB.resize(n_feats, desc_len);
+	for (size_t k = 0; k < std::min(n_feats, size_t(cv_descs.rows)); ++k)
+		std::memcpy(in_features.ORB[k], cv_descs.ptr<uchar>(k), desc_len);
+#endif
+#else
+	MRPT_UNUSED_PARAM(in_img);
+	MRPT_UNUSED_PARAM(in_features);
+	THROW_EXCEPTION("MRPT has been compiled without OpenCV")
+#endif
+}
@@ -44,6 +44,12 @@ void CFeatureExtraction::detectFeatures(
 	const CImage& img, CFeatureList& feats, const unsigned int init_ID,
 	const unsigned int nDesiredFeatures, const TImageROI& ROI) const
 {
+	if (options.multiScaleOptions.enabled)
+	{
+		extractFeaturesMultiScale(img, feats, init_ID, nDesiredFeatures);
+		return;
+	}
+
 	switch (options.featsType)
 	{
 		case featHarris:
@@ -275,6 +281,52 @@ void CFeatureExtraction::computeDescriptors(
 	MRPT_END
 }
 
+void CFeatureExtraction::detectFeatures(
+	const CImage& img, CCompactFeatureList& feats, const unsigned int init_ID,
+	const unsigned int nDesiredFeatures, const TImageROI& ROI) const
+{
+	MRPT_START
+
+	if (options.featsType == featORB && !options.multiScaleOptions.enabled)
+	{
+		extractFeaturesORB(img, feats, init_ID, nDesiredFeatures, ROI);
+		return;
+	}
+
+	// The rest of detectors, through a list of CFeature objects (with the
+	// previous features, which may be used or kept by the detector):
+	CFeatureList aux_feats;
+	feats.getAsFeatureList(aux_feats);
+	detectFeatures(img, aux_feats, init_ID, nDesiredFeatures, ROI);
+	feats.assign(aux_feats);
+
+	MRPT_END
+}
+
+void CFeatureExtraction::computeDescriptors(
+	const CImage& in_img, CCompactFeatureList& inout_features,
+	TDescriptorType in_descriptor_list) const
+{
+	MRPT_START
+
+	ASSERTMSG_(
+		(in_descriptor_list & ~(descSIFT | descSURF | descORB)) == 0,
+		"CCompactFeatureList can only store SIFT, SURF and ORB descriptors");
+
+	if (in_descriptor_list == descORB)
+	{
+		this->internal_computeORBDescriptors(in_img, inout_features);
+		return;
+	}
+
+	CFeatureList aux_feats;
+	inout_features.getAsFeatureList(aux_feats);
+	computeDescriptors(in_img, aux_feats, in_descriptor_list);
+	inout_features.assign(aux_feats);
+
+	MRPT_END
+}
+
 /************************************************************************************************
 *								extractFeaturesBCD *
 ************************************************************************************************/
@@ -355,6 +407,14 @@ CFeatureExtraction::TOptions::TOptions(const TFeatureType _featsType)
 		16;  // Log-Polar image patch will have dimensions WxH, with:
 	// W=num_angles,  H= rho_scale * log(radius)
 	LogPolarImagesOptions.rho_scale = 5;
+
+	// Multi-scale detection:
+	multiScaleOptions.enabled = false;
+	multiScaleOptions.nOctaves = 3;
+	multiScaleOptions.smooth_halves = true;
+	multiScaleOptions.num_threads = 0;
+	multiScaleOptions.tile_size = 128;
+	multiScaleOptions.grid_cell_size = 64;
 }
 
 /*---------------------------------------------------------------
@@ -413,6 +473,13 @@ void CFeatureExtraction::TOptions::dumpToTextStream(
 	LOADABLEOPTS_DUMP_VAR(LogPolarImagesOptions.num_angles, int)
 	LOADABLEOPTS_DUMP_VAR(LogPolarImagesOptions.rho_scale, double)
 
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.enabled, bool)
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.nOctaves, int)
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.smooth_halves, bool)
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.num_threads, int)
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.tile_size, int)
+	LOADABLEOPTS_DUMP_VAR(multiScaleOptions.grid_cell_size, int)
+
 	out.printf("\n");
 }
 
@@ -478,4 +545,13 @@ void CFeatureExtraction::TOptions::loadFromConfigFile(
 		LogPolarImagesOptions.num_angles, int, iniFile, section)
 	MRPT_LOAD_CONFIG_VAR(
 		LogPolarImagesOptions.rho_scale, double, iniFile, section)
+
+	MRPT_LOAD_CONFIG_VAR(multiScaleOptions.enabled, bool, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(multiScaleOptions.nOctaves, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		multiScaleOptions.smooth_halves, bool, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(multiScaleOptions.num_threads, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(multiScaleOptions.tile_size, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		multiScaleOptions.grid_cell_size, int, iniFile, section)
 }
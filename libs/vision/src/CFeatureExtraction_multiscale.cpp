@@ -0,0 +1,283 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/vision/CImagePyramid.h>
+#include <mrpt/utils/parallel.h>
+
+// Universal include for all versions of OpenCV
+#include <mrpt/otherlibs/do_opencv_includes.h>
+
+#if MRPT_HAS_OPENCV
+#include "faster/faster_corner_prototypes.h"
+#endif
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_OPENCV
+namespace
+{
+/** Octaves smaller than this (in width or height) are not used */
+const unsigned int MIN_OCTAVE_SIZE = 16;
+
+/** A tile of an octave of the pyramid, [x0,x1)x[y0,y1) */
+struct TTile
+{
+	unsigned int octave;
+	int x0, y0, x1, y1;
+};
+
+/** A feature found in some octave, before being selected */
+struct TCandidate
+{
+	/** Coordinates in the original image */
+	float x, y;
+	float response;
+	unsigned int octave;
+	/** Index of the feature in its list */
+	size_t idx;
+	/** Its list: the tile (FASTER) or the octave (rest of detectors) */
+	size_t list;
+};
+}  // namespace
+#endif
+
+/************************************************************************************************
+*								extractFeaturesMultiScale
+************************************************************************************************/
+void CFeatureExtraction::extractFeaturesMultiScale(
+	const mrpt::utils::CImage& img, CFeatureList& feats,
+	const unsigned int init_ID, const unsigned int nDesiredFeatures) const
+{
+	MRPT_START
+
+#if MRPT_HAS_OPENCV
+	const TOptions::TMultiScaleOptions& ms = options.multiScaleOptions;
+	ASSERT_ABOVE_(ms.nOctaves, 0)
+	ASSERT_ABOVEEQ_(ms.tile_size, MIN_OCTAVE_SIZE)
+
+	const int imgW = img.getWidth(), imgH = img.getHeight();
+	unsigned int nOctaves = ms.nOctaves;
+	while (nOctaves > 1 &&
+		   (std::min(imgW, imgH) >> (nOctaves - 1)) < (int)MIN_OCTAVE_SIZE)
+		nOctaves--;
+
+	CImagePyramid pyramid;
+	pyramid.buildPyramid(img, nOctaves, ms.smooth_halves, true);
+
+	std::vector<TCandidate> candidates;
+	// FASTER: the corners of each tile; rest: the features of each octave.
+	std::vector<TSimpleFeatureList> tile_corners;
+	std::vector<CFeatureList> octave_feats;
+
+	const bool is_faster = options.featsType == featFASTER9 ||
+						   options.featsType == featFASTER10 ||
+						   options.featsType == featFASTER12;
+	if (is_faster)
+	{
+		const int N_fast = options.featsType == featFASTER9
+							   ? 9
+							   : (options.featsType == featFASTER10 ? 10 : 12);
+
+		std::vector<TTile> tiles;
+		for (unsigned int o = 0; o < nOctaves; o++)
+		{
+			const int w = pyramid.images[o].getWidth(),
+					  h = pyramid.images[o].getHeight();
+			for (int y = 0; y < h; y += ms.tile_size)
+				for (int x = 0; x < w; x += ms.tile_size)
+				{
+					const TTile t = {o, x, y,
+									 std::min<int>(w, x + ms.tile_size),
+									 std::min<int>(h, y + ms.tile_size)};
+					tiles.push_back(t);
+				}
+		}
+
+		tile_corners.resize(tiles.size());
+		mrpt::utils::parallel_for_jobs(
+			tiles.size(), ms.num_threads, [&](const size_t j) {
+				const TTile& t = tiles[j];
+				const CImage& octave_img = pyramid.images[t.octave];
+				const IplImage* I = octave_img.getAs<IplImage>();
+				TSimpleFeatureList& corners = tile_corners[j];
+				fast_corner_detect_tile(
+					N_fast, reinterpret_cast<const uint8_t*>(I->imageData),
+					I->width, I->height, I->widthStep, t.x0, t.y0, t.x1, t.y1,
+					options.FASTOptions.threshold,
+					options.FASTOptions.nonmax_suppression, corners);
+
+				if (options.FASTOptions.use_KLT_response)
+				{
+					const int KLT_half_win = 4;
+					const int max_x = I->width - 1 - KLT_half_win;
+					const int max_y = I->height - 1 - KLT_half_win;
+					for (size_t i = 0; i < corners.size(); i++)
+					{
+						const int x = corners[i].pt.x, y = corners[i].pt.y;
+						corners[i].response =
+							(x > KLT_half_win && y > KLT_half_win &&
+							 x <= max_x && y <= max_y)
+								? octave_img.KLT_response(x, y, KLT_half_win)
+								: -100;
+					}
+				}
+			});
+
+		for (size_t j = 0; j < tiles.size(); j++)
+			for (size_t i = 0; i < tile_corners[j].size(); i++)
+			{
+				const TSimpleFeature& c = tile_corners[j][i];
+				const TCandidate cand = {float(c.pt.x << tiles[j].octave),
+										 float(c.pt.y << tiles[j].octave),
+										 c.response,
+										 tiles[j].octave,
+										 i,
+										 j};
+				candidates.push_back(cand);
+			}
+	}
+	else
+	{
+		// The rest of detectors, once per octave:
+		CFeatureExtraction octave_fext;
+		octave_fext.options = options;
+		octave_fext.options.multiScaleOptions.enabled = false;
+		octave_fext.options.patchSize = 0;
+		octave_fext.options.addNewFeatures = false;
+
+		octave_feats.resize(nOctaves);
+		mrpt::utils::parallel_for_jobs(
+			nOctaves, ms.num_threads, [&](const size_t o) {
+				octave_fext.detectFeatures(pyramid.images[o], octave_feats[o]);
+			});
+
+		for (unsigned int o = 0; o < nOctaves; o++)
+			for (size_t i = 0; i < octave_feats[o].size(); i++)
+			{
+				const CFeature& f = *octave_feats[o][i];
+				const TCandidate cand = {f.x * (1 << o), f.y * (1 << o),
+										 f.response, o, i, o};
+				candidates.push_back(cand);
+			}
+	}
+
+	// Discard the features whose patch would be out of the image:
+	if (options.patchSize > 0)
+	{
+		const int size_2 = options.patchSize / 2;
+		std::vector<TCandidate> inside;
+		inside.reserve(candidates.size());
+		for (const auto& c : candidates)
+		{
+			const int x = c.x, y = c.y;
+			if (x + size_2 < imgW && x - size_2 > 0 && y + size_2 < imgH &&
+				y - size_2 > 0)
+				inside.push_back(c);
+		}
+		candidates.swap(inside);
+	}
+
+	// Merge all the octaves and tiles, by decreasing response. Ties (frequent
+	// with integer FAST scores) are broken by (octave,y,x), so the order does
+	// not depend on the tiles nor on the threads:
+	std::stable_sort(
+		candidates.begin(), candidates.end(),
+		[](const TCandidate& a, const TCandidate& b) {
+			if (a.response != b.response) return a.response > b.response;
+			if (a.octave != b.octave) return a.octave < b.octave;
+			if (a.y != b.y) return a.y < b.y;
+			return a.x < b.x;
+		});
+
+	// Select the best nDesiredFeatures, with at most ceil(nDesired/cells) of
+	// them in each cell of the grid, then fill up with the best of the rest:
+	const size_t N = candidates.size();
+	std::vector<bool> selected(N, true);
+	if (nDesiredFeatures != 0 && N > nDesiredFeatures)
+	{
+		selected.assign(N, false);
+		size_t n_selected = 0;
+		if (ms.grid_cell_size > 0)
+		{
+			const int cell = ms.grid_cell_size;
+			const int grid_lx = (imgW + cell - 1) / cell,
+					  grid_ly = (imgH + cell - 1) / cell;
+			const size_t max_per_cell =
+				(nDesiredFeatures + grid_lx * grid_ly - 1) /
+				(grid_lx * grid_ly);
+			std::vector<size_t> n_in_cell(grid_lx * grid_ly, 0);
+			for (size_t i = 0; i < N && n_selected < nDesiredFeatures; i++)
+			{
+				const int cx =
+					std::min(grid_lx - 1, int(candidates[i].x) / cell);
+				const int cy =
+					std::min(grid_ly - 1, int(candidates[i].y) / cell);
+				size_t& n = n_in_cell[cx + grid_lx * cy];
+				if (n >= max_per_cell) continue;
+				n++;
+				selected[i] = true;
+				n_selected++;
+			}
+		}
+		for (size_t i = 0; i < N && n_selected < nDesiredFeatures; i++)
+			if (!selected[i])
+			{
+				selected[i] = true;
+				n_selected++;
+			}
+	}
+
+	if (!options.addNewFeatures) feats.clear();
+
+	const int offset = (int)options.patchSize / 2 + 1;
+	TFeatureID nextID = init_ID;
+	for (size_t i = 0; i < N; i++)
+	{
+		if (!selected[i]) continue;
+		const TCandidate& c = candidates[i];
+
+		CFeature::Ptr ft;
+		if (is_faster)
+		{
+			ft = std::make_shared<CFeature>();
+			ft->type = options.featsType;
+			ft->orientation = 0;
+			ft->scale = 1 << c.octave;
+		}
+		else
+		{
+			ft = std::make_shared<CFeature>(*octave_feats[c.list][c.idx]);
+			ft->scale *= 1 << c.octave;
+		}
+		ft->ID = nextID++;
+		ft->x = c.x;
+		ft->y = c.y;
+		ft->response = c.response;
+		ft->patchSize = options.patchSize;
+		if (options.patchSize > 0)
+			img.extract_patch(
+				ft->patch, round(ft->x) - offset, round(ft->y) - offset,
+				options.patchSize, options.patchSize);
+		feats.push_back(ft);
+	}
+#else
+	MRPT_UNUSED_PARAM(img);
+	MRPT_UNUSED_PARAM(feats);
+	MRPT_UNUSED_PARAM(init_ID);
+	MRPT_UNUSED_PARAM(nDesiredFeatures);
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
+#endif
+	MRPT_END
+}
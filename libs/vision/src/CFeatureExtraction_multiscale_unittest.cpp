@@ -0,0 +1,140 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+#if MRPT_HAS_OPENCV  // CImage needs OpenCV
+
+// A grayscale image with random rectangles, which have plenty of corners:
+static CImage createImage(const int w, const int h)
+{
+	CImage img(w, h, CH_GRAY);
+	img.filledRectangle(0, 0, w - 1, h - 1, TColor(128, 128, 128));
+	for (int i = 0; i < 150; i++)
+	{
+		const int x = randomGenerator.drawUniform32bit() % w,
+				  y = randomGenerator.drawUniform32bit() % h;
+		const uint8_t v = randomGenerator.drawUniform32bit() % 256;
+		img.filledRectangle(
+			x, y, x + 5 + randomGenerator.drawUniform32bit() % 40,
+			y + 5 + randomGenerator.drawUniform32bit() % 40, TColor(v, v, v));
+	}
+	return img;
+}
+
+static void expectSameFeatures(const CFeatureList& f1, const CFeatureList& f2)
+{
+	ASSERT_EQ(f1.size(), f2.size());
+	for (size_t i = 0; i < f1.size(); i++)
+	{
+		EXPECT_EQ(f1[i]->x, f2[i]->x);
+		EXPECT_EQ(f1[i]->y, f2[i]->y);
+		EXPECT_EQ(f1[i]->scale, f2[i]->scale);
+		EXPECT_EQ(f1[i]->response, f2[i]->response);
+	}
+}
+
+TEST(CFeatureExtraction, MultiScaleFASTERIndependentOfTilesAndThreads)
+{
+	randomGenerator.randomize(1);
+	const CImage img = createImage(320, 240);
+
+	CFeatureExtraction fext;
+	fext.options.featsType = featFASTER9;
+	fext.options.patchSize = 0;
+	fext.options.multiScaleOptions.enabled = true;
+	fext.options.multiScaleOptions.num_threads = 1;
+	fext.options.multiScaleOptions.tile_size = 1000;
+
+	CFeatureList ref;
+	fext.detectFeatures(img, ref);
+	EXPECT_GT(ref.size(), 100U);
+	for (size_t i = 1; i < ref.size(); i++)
+		EXPECT_GE(ref[i - 1]->response, ref[i]->response);
+
+	for (unsigned int tile_size : {32U, 50U, 128U})
+	{
+		fext.options.multiScaleOptions.tile_size = tile_size;
+		fext.options.multiScaleOptions.num_threads = 4;
+		CFeatureList feats;
+		fext.detectFeatures(img, feats);
+		expectSameFeatures(ref, feats);
+	}
+}
+
+TEST(CFeatureExtraction, MultiScaleFASTERTiesIndependentOfTiles)
+{
+	// Identical rectangles: their corners have the same FAST scores
+	CImage img(320, 240, CH_GRAY);
+	img.filledRectangle(0, 0, 319, 239, TColor(128, 128, 128));
+	for (int x = 40; x < 300; x += 70)
+		for (int y = 30; y < 220; y += 70)
+			img.filledRectangle(x, y, x + 30, y + 30, TColor(30, 30, 30));
+
+	CFeatureExtraction fext;
+	fext.options.featsType = featFASTER9;
+	fext.options.patchSize = 0;
+	fext.options.multiScaleOptions.enabled = true;
+	fext.options.multiScaleOptions.tile_size = 1000;
+
+	// Fewer features than corners: ties decide which ones are kept
+	const unsigned int nDesired = 10;
+	CFeatureList ref;
+	fext.detectFeatures(img, ref, 0, nDesired);
+	ASSERT_EQ(ref.size(), nDesired);
+	for (size_t i = 1; i < ref.size(); i++)
+		if (ref[i - 1]->response == ref[i]->response &&
+			ref[i - 1]->scale == ref[i]->scale)
+			EXPECT_TRUE(
+				ref[i - 1]->y < ref[i]->y ||
+				(ref[i - 1]->y == ref[i]->y && ref[i - 1]->x < ref[i]->x));
+
+	for (unsigned int tile_size : {32U, 50U, 128U})
+	{
+		fext.options.multiScaleOptions.tile_size = tile_size;
+		CFeatureList feats;
+		fext.detectFeatures(img, feats, 0, nDesired);
+		expectSameFeatures(ref, feats);
+	}
+}
+
+TEST(CFeatureExtraction, MultiScaleGridDistribution)
+{
+	randomGenerator.randomize(2);
+	const CImage img = createImage(320, 240);
+
+	CFeatureExtraction fext;
+	fext.options.featsType = featFASTER9;
+	fext.options.patchSize = 0;
+	fext.options.multiScaleOptions.enabled = true;
+	fext.options.multiScaleOptions.grid_cell_size = 80;  // 4x3 cells
+
+	const unsigned int nDesired = 60;
+	CFeatureList feats;
+	fext.detectFeatures(img, feats, 0, nDesired);
+	ASSERT_EQ(feats.size(), nDesired);
+
+	// No cell gets more than its share (5) while other cells have room:
+	vector<size_t> n_in_cell(12, 0);
+	for (const auto& f : feats)
+		n_in_cell[int(f->x) / 80 + 4 * (int(f->y) / 80)]++;
+	size_t n_full = 0;
+	for (size_t n : n_in_cell) n_full += (n >= 5);
+	EXPECT_GE(n_full, 8U);
+}
+
+#endif
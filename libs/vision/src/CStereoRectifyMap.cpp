@@ -9,6 +9,7 @@
 
 #include "vision-precomp.h"  // Precompiled headers
 #include <mrpt/vision/CStereoRectifyMap.h>
+#include <mrpt/utils/parallel.h>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
@@ -19,23 +20,29 @@ using namespace mrpt::vision;
 using namespace mrpt::utils;
 using namespace mrpt::math;
 
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
+namespace
+{
+/** Output rows remapped by each thread at a time */
+const unsigned int ROWS_PER_JOB = 16;
+}  // namespace
+#endif
+
 // Ctor: Leave all vectors empty
 CStereoRectifyMap::CStereoRectifyMap()
 	: m_alpha(-1),
 	  m_resize_output(false),
 	  m_enable_both_centers_coincide(false),
 	  m_resize_output_value(0, 0),
-	  m_interpolation_method(mrpt::utils::IMG_INTERP_LINEAR)
+	  m_interpolation_method(mrpt::utils::IMG_INTERP_LINEAR),
+	  m_num_threads(0)
 {
 }
 
 void CStereoRectifyMap::internal_invalidate()
 {
-	m_dat_mapx_left
-		.clear();  // don't do a "strong clear" since memory is likely
-	m_dat_mapx_right.clear();  // to be reasigned soon.
-	m_dat_mapy_left.clear();
-	m_dat_mapy_right.clear();
+	m_lut_left.clear();  // don't do a "strong clear" since memory is likely
+	m_lut_right.clear();  // to be reasigned soon.
 }
 
 void CStereoRectifyMap::setAlpha(double alpha)
@@ -93,27 +100,6 @@ void CStereoRectifyMap::setFromCamParams(
 	// save a copy for future reference
 	m_camera_params = params;
 
-	// Create OpenCV's wrappers for output maps:
-	m_dat_mapx_left.resize(2 * nrows_out * ncols_out);
-	m_dat_mapy_left.resize(nrows_out * ncols_out);
-
-	m_dat_mapx_right.resize(2 * nrows_out * ncols_out);
-	m_dat_mapy_right.resize(nrows_out * ncols_out);
-
-	CvMat mapx_left =
-		cvMat(nrows_out, ncols_out, CV_16SC2, &m_dat_mapx_left[0]);
-	CvMat mapy_left =
-		cvMat(nrows_out, ncols_out, CV_16UC1, &m_dat_mapy_left[0]);
-	CvMat mapx_right =
-		cvMat(nrows_out, ncols_out, CV_16SC2, &m_dat_mapx_right[0]);
-	CvMat mapy_right =
-		cvMat(nrows_out, ncols_out, CV_16UC1, &m_dat_mapy_right[0]);
-
-	cv::Mat _mapx_left = cv::cvarrToMat(&mapx_left, false);
-	cv::Mat _mapy_left = cv::cvarrToMat(&mapy_left, false);
-	cv::Mat _mapx_right = cv::cvarrToMat(&mapx_right, false);
-	cv::Mat _mapy_right = cv::cvarrToMat(&mapy_right, false);
-
 	// right camera pose: Rotation
 	CMatrixDouble44 hMatrix;
 	// NOTE!: OpenCV seems to expect the INVERSE of the pose we keep, so invert
@@ -157,9 +143,7 @@ void CStereoRectifyMap::setFromCamParams(
 	cv::Mat Q(4, 4, CV_64F, _Q);
 
 	const cv::Size img_size(ncols, nrows);
-	const cv::Size real_trg_size =
-		m_resize_output ? trg_size
-						: img_size;  // Note: trg_size is Size() by default
+	const cv::Size real_trg_size(ncols_out, nrows_out);
 
 /*
 OpenCV 2.0:
@@ -215,10 +199,19 @@ validPixROI2=0 );
 // Rest of arguments -> default
 #endif
 
-	cv::initUndistortRectifyMap(
-		K1, D1, R1, P1, real_trg_size, CV_16SC2, _mapx_left, _mapy_left);
-	cv::initUndistortRectifyMap(
-		K2, D2, R2, P2, real_trg_size, CV_16SC2, _mapx_right, _mapy_right);
+	// The fixed-point maps, computed natively from the rectifying rotations
+	// and the new intrinsic parameters (as cv::initUndistortRectifyMap()):
+	CMatrixDouble33 RR_left, RR_right, KK_left, KK_right;
+	for (unsigned int i = 0; i < 3; ++i)
+		for (unsigned int j = 0; j < 3; ++j)
+		{
+			RR_left(i, j) = _R1[i][j];
+			RR_right(i, j) = _R2[i][j];
+			KK_left(i, j) = _P1[i][j];
+			KK_right(i, j) = _P2[i][j];
+		}
+	m_lut_left.setFromCamera(cam1, RR_left, KK_left, ncols_out, nrows_out);
+	m_lut_right.setFromCamera(cam2, RR_right, KK_right, ncols_out, nrows_out);
 
 	// Populate the parameter matrices of the output rectified images:
 	for (unsigned int i = 0; i < 3; ++i)
@@ -274,20 +267,16 @@ void CStereoRectifyMap::rectify(
 	MRPT_START
 
 #if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
-	const uint32_t ncols = m_camera_params.leftCamera.ncols;
-	const uint32_t nrows = m_camera_params.leftCamera.nrows;
-
-	const CvSize trg_size =
-		m_resize_output
-			? cvSize(m_resize_output_value.x, m_resize_output_value.y)
-			: cvSize(ncols, nrows);
+	if (!isSet())
+		THROW_EXCEPTION(
+			"Error: setFromCamParams() must be called prior to rectify().")
 
 	out_left_image.resize(
-		trg_size.width, trg_size.height, in_left_image.isColor() ? 3 : 1,
+		m_lut_left.width, m_lut_left.height, in_left_image.getChannelCount(),
 		in_left_image.isOriginTopLeft());
 	out_right_image.resize(
-		trg_size.width, trg_size.height, in_left_image.isColor() ? 3 : 1,
-		in_left_image.isOriginTopLeft());
+		m_lut_right.width, m_lut_right.height,
+		in_right_image.getChannelCount(), in_right_image.isOriginTopLeft());
 
 	const IplImage* in_left = in_left_image.getAs<IplImage>();
 	const IplImage* in_right = in_right_image.getAs<IplImage>();
@@ -308,64 +297,23 @@ void CStereoRectifyMap::rectify(
 {
 	MRPT_START
 
-#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
-	const uint32_t ncols = m_camera_params.leftCamera.ncols;
-	const uint32_t nrows = m_camera_params.leftCamera.nrows;
-
-	const CvSize trg_size =
-		m_resize_output
-			? cvSize(m_resize_output_value.x, m_resize_output_value.y)
-			: cvSize(ncols, nrows);
-
-	const IplImage* in_left = left_image.getAs<IplImage>();
-	const IplImage* in_right = right_image.getAs<IplImage>();
-
-	IplImage *out_left_image, *out_right_image;
-	if (use_internal_mem_cache)
-	{
-		m_cache1.resize(
-			trg_size.width, trg_size.height, left_image.isColor() ? 3 : 1,
-			left_image.isOriginTopLeft());
-		m_cache2.resize(
-			trg_size.width, trg_size.height, right_image.isColor() ? 3 : 1,
-			right_image.isOriginTopLeft());
-
-		out_left_image = m_cache1.getAs<IplImage>();
-		out_right_image = m_cache2.getAs<IplImage>();
-	}
-	else
-	{
-		out_left_image =
-			cvCreateImage(trg_size, in_left->depth, in_left->nChannels);
-		out_right_image =
-			cvCreateImage(trg_size, in_right->depth, in_right->nChannels);
-	}
-
-	this->rectify_IPL(in_left, in_right, out_left_image, out_right_image);
-
 	if (use_internal_mem_cache)
 	{
-		// Copy the data: we have avoided one allocation & one deallocation
-		// (If the sizes match, these calls have no effects)
-		left_image.resize(
-			trg_size.width, trg_size.height, left_image.isColor() ? 3 : 1,
-			left_image.isOriginTopLeft());
-		right_image.resize(
-			trg_size.width, trg_size.height, right_image.isColor() ? 3 : 1,
-			right_image.isOriginTopLeft());
-
-		cvCopy(out_left_image, left_image.getAs<IplImage>());
-		cvCopy(out_right_image, right_image.getAs<IplImage>());
+		// Rectify into the cached images and swap them with the inputs, which
+		// are reused as the cache in the next call (if sizes match, the
+		// resize() calls have no effect):
+		this->rectify(left_image, right_image, m_cache1, m_cache2);
+		left_image.swap(m_cache1);
+		right_image.swap(m_cache2);
 	}
 	else
 	{
-		// Move the internal pointers: but we deallocate the old contents and
-		// needed to allocate this one
-		left_image.setFromIplImage(out_left_image);
-		right_image.setFromIplImage(out_right_image);
+		mrpt::utils::CImage out_left, out_right;
+		this->rectify(left_image, right_image, out_left, out_right);
+		left_image.swap(out_left);
+		right_image.swap(out_right);
 	}
 
-#endif
 	MRPT_END
 }
 
@@ -415,43 +363,72 @@ void CStereoRectifyMap::rectify_IPL(
 			"Error: setFromCamParams() must be called prior to rectify().")
 
 #if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
-	const uint32_t ncols = m_camera_params.leftCamera.ncols;
-	const uint32_t nrows = m_camera_params.leftCamera.nrows;
+	const IplImage* const srcs[2] = {
+		static_cast<const IplImage*>(srcImg_left),
+		static_cast<const IplImage*>(srcImg_right)};
+	IplImage* const outs[2] = {static_cast<IplImage*>(outImg_left),
+							   static_cast<IplImage*>(outImg_right)};
+	const TRemapLUT* const luts[2] = {&m_lut_left, &m_lut_right};
+	for (int k = 0; k < 2; k++)
+	{
+		const IplImage *src = srcs[k], *out = outs[k];
+		const TRemapLUT& lut = *luts[k];
+		ASSERT_(src->depth == out->depth)
+		ASSERT_(src->nChannels == out->nChannels)
+		ASSERT_(
+			src->width == int(lut.src_width) &&
+			src->height == int(lut.src_height))
+		ASSERT_(out->width == int(lut.width) && out->height == int(lut.height))
+	}
 
-	const uint32_t ncols_out =
-		m_resize_output ? m_resize_output_value.x : ncols;
-	const uint32_t nrows_out =
-		m_resize_output ? m_resize_output_value.y : nrows;
+	// The tables only handle 8 bit images with 1 or 3 channels:
+	const bool nearest = m_interpolation_method == IMG_INTERP_NN;
+	bool use_lut = nearest || m_interpolation_method == IMG_INTERP_LINEAR;
+	for (int k = 0; k < 2; k++)
+		if (srcs[k]->depth != IPL_DEPTH_8U ||
+			(srcs[k]->nChannels != 1 && srcs[k]->nChannels != 3))
+			use_lut = false;
 
-	const CvMat mapx_left = cvMat(
-		nrows_out, ncols_out, CV_16SC2,
-		const_cast<int16_t*>(&m_dat_mapx_left[0]));
-	const CvMat mapy_left = cvMat(
-		nrows_out, ncols_out, CV_16UC1,
-		const_cast<uint16_t*>(&m_dat_mapy_left[0]));
-	const CvMat mapx_right = cvMat(
-		nrows_out, ncols_out, CV_16SC2,
-		const_cast<int16_t*>(&m_dat_mapx_right[0]));
-	const CvMat mapy_right = cvMat(
-		nrows_out, ncols_out, CV_16UC1,
-		const_cast<uint16_t*>(&m_dat_mapy_right[0]));
-
-	const cv::Mat mapx1 = cv::cvarrToMat(&mapx_left);
-	const cv::Mat mapy1 = cv::cvarrToMat(&mapy_left);
-	const cv::Mat mapx2 = cv::cvarrToMat(&mapx_right);
-	const cv::Mat mapy2 = cv::cvarrToMat(&mapy_right);
-
-	const cv::Mat src1 = cv::cvarrToMat(srcImg_left);
-	const cv::Mat src2 = cv::cvarrToMat(srcImg_right);
-	cv::Mat dst1 = cv::cvarrToMat(outImg_left);
-	cv::Mat dst2 = cv::cvarrToMat(outImg_right);
-
-	cv::remap(
-		src1, dst1, mapx1, mapy1, static_cast<int>(m_interpolation_method),
-		cv::BORDER_CONSTANT, cvScalarAll(0));
-	cv::remap(
-		src2, dst2, mapx2, mapy2, static_cast<int>(m_interpolation_method),
-		cv::BORDER_CONSTANT, cvScalarAll(0));
+	if (use_lut)
+	{
+		// Blocks of rows of both images are processed by the same pool of
+		// threads:
+		const size_t nBlocks = (m_lut_left.height + ROWS_PER_JOB - 1) /
+							   ROWS_PER_JOB,
+					 nJobs = 2 * nBlocks;
+		mrpt::utils::parallel_for_jobs(
+			nJobs, m_num_threads, [&](const size_t j) {
+				const int k = j < nBlocks ? 0 : 1;
+				const TRemapLUT& lut = *luts[k];
+				const unsigned int row0 = (j % nBlocks) * ROWS_PER_JOB;
+				lut.remapRows(
+					reinterpret_cast<const uint8_t*>(srcs[k]->imageData),
+					srcs[k]->widthStep,
+					reinterpret_cast<uint8_t*>(outs[k]->imageData),
+					outs[k]->widthStep, srcs[k]->nChannels, row0,
+					std::min(lut.height, row0 + ROWS_PER_JOB), nearest);
+			});
+	}
+	else
+	{
+		// Other methods and image formats: OpenCV's remap() with the maps in
+		// its format:
+		for (int k = 0; k < 2; k++)
+		{
+			std::vector<int16_t> map_xy;
+			std::vector<uint16_t> map_frac;
+			luts[k]->getAsOpenCVMaps(map_xy, map_frac);
+			const cv::Mat mapx(
+				luts[k]->height, luts[k]->width, CV_16SC2, &map_xy[0]);
+			const cv::Mat mapy(
+				luts[k]->height, luts[k]->width, CV_16UC1, &map_frac[0]);
+			const cv::Mat src = cv::cvarrToMat(srcs[k]);
+			cv::Mat dst = cv::cvarrToMat(outs[k]);
+			cv::remap(
+				src, dst, mapx, mapy, static_cast<int>(m_interpolation_method),
+				cv::BORDER_CONSTANT, cvScalarAll(0));
+		}
+	}
 #endif
 	MRPT_END
 }
@@ -484,23 +461,28 @@ void CStereoRectifyMap::setRectifyMaps(
 	const std::vector<int16_t>& left_x, const std::vector<uint16_t>& left_y,
 	const std::vector<int16_t>& right_x, const std::vector<uint16_t>& right_y)
 {
-	m_dat_mapx_left.resize(left_x.size());
-	m_dat_mapy_left.resize(left_y.size());
-	m_dat_mapx_right.resize(right_x.size());
-	m_dat_mapy_right.resize(right_y.size());
-
-	std::copy(left_x.begin(), left_x.end(), m_dat_mapx_left.begin());
-	std::copy(left_y.begin(), left_y.end(), m_dat_mapy_left.begin());
-	std::copy(right_x.begin(), right_x.end(), m_dat_mapx_right.begin());
-	std::copy(right_y.begin(), right_y.end(), m_dat_mapy_right.begin());
+	MRPT_START
+	const unsigned int ncols = m_camera_params.leftCamera.ncols;
+	const unsigned int nrows = m_camera_params.leftCamera.nrows;
+	const unsigned int ncols_out =
+		m_resize_output ? m_resize_output_value.x : ncols;
+	const unsigned int nrows_out =
+		m_resize_output ? m_resize_output_value.y : nrows;
+
+	m_lut_left.setFromOpenCVMaps(
+		left_x, left_y, ncols_out, nrows_out, ncols, nrows);
+	m_lut_right.setFromOpenCVMaps(
+		right_x, right_y, ncols_out, nrows_out, ncols, nrows);
+	MRPT_END
 }
 
 void CStereoRectifyMap::setRectifyMapsFast(
 	std::vector<int16_t>& left_x, std::vector<uint16_t>& left_y,
 	std::vector<int16_t>& right_x, std::vector<uint16_t>& right_y)
 {
-	left_x.swap(m_dat_mapx_left);
-	left_y.swap(m_dat_mapy_left);
-	right_x.swap(m_dat_mapx_right);
-	right_y.swap(m_dat_mapy_right);
+	setRectifyMaps(left_x, left_y, right_x, right_y);
+	left_x.clear();
+	left_y.clear();
+	right_x.clear();
+	right_y.clear();
 }
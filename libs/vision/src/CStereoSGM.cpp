@@ -0,0 +1,544 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/CStereoSGM.h>
+#include <mrpt/utils/CConfigFileBase.h>
+#include <mrpt/utils/SSE_types.h>
+#include <mrpt/utils/parallel.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace std;
+
+const float CStereoSGM::INVALID_DISPARITY = -1.0f;
+
+namespace
+{
+/** Half size of the census window (9x7) */
+const int CENSUS_HW = 4, CENSUS_HH = 3;
+/** Cost of the disparities out of the right image (the number of bits of the
+ * census, the worst possible cost) */
+const uint8_t MAX_COST = (2 * CENSUS_HW + 1) * (2 * CENSUS_HH + 1) - 1;
+/** Padding value of the aggregation buffers, so it's never the minimum */
+const int16_t BIG_COST = 0x3FFF;
+/** Padding of the aggregation buffers, at each side of the disparities */
+const size_t PAD = 16;
+
+const unsigned int ROWS_PER_JOB = 8;
+const size_t SCANLINES_PER_JOB = 16;
+
+inline unsigned int popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<unsigned int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/** Census transform of the rows [y0,y1) of an image: bit k of each pixel is
+ * set if the k'th pixel of its window (but the center) is darker. Pixels out
+ * of the image are replicated from the border. */
+void census_rows(
+	const uint8_t* img, const size_t stride, const int w, const int h,
+	const int y0, const int y1, uint64_t* out)
+{
+	// The rows of the window, with CENSUS_HW pixels replicated at each side:
+	const int pw = w + 2 * CENSUS_HW;
+	std::vector<uint8_t> rows((2 * CENSUS_HH + 1) * pw);
+	for (int y = y0; y < y1; y++)
+	{
+		for (int dy = -CENSUS_HH; dy <= CENSUS_HH; dy++)
+		{
+			const uint8_t* src =
+				img + stride * std::min(h - 1, std::max(0, y + dy));
+			uint8_t* row = &rows[(dy + CENSUS_HH) * pw];
+			memset(row, src[0], CENSUS_HW);
+			memcpy(row + CENSUS_HW, src, w);
+			memset(row + CENSUS_HW + w, src[w - 1], CENSUS_HW);
+		}
+		const uint8_t* center = &rows[CENSUS_HH * pw + CENSUS_HW];
+		uint64_t* c = out + size_t(y) * w;
+		for (int x = 0; x < w; x++) c[x] = 0;
+		unsigned int bit = 0;
+		for (int dy = -CENSUS_HH; dy <= CENSUS_HH; dy++)
+			for (int dx = -CENSUS_HW; dx <= CENSUS_HW; dx++)
+			{
+				if (!dx && !dy) continue;
+				const uint8_t* q =
+					&rows[(dy + CENSUS_HH) * pw + CENSUS_HW + dx];
+				for (int x = 0; x < w; x++)
+					c[x] |= uint64_t(q[x] < center[x]) << bit;
+				bit++;
+			}
+	}
+}
+
+/** One step of the aggregation along a path: from the costs \a C and the
+ * aggregated costs of the previous pixel \a Lp (with padding at both sides),
+ * computes those of this pixel \a Lc, adds them to \a S and returns their
+ * minimum. */
+inline int aggregate_pixel(
+	const uint8_t* C, const int16_t* Lp, const int minLp, const int P1,
+	const int P2, const size_t D, int16_t* Lc, uint16_t* S)
+{
+	size_t d = 0;
+	int minLc = BIG_COST;
+#if MRPT_HAS_AVX2
+	{
+		const __m256i vP1 = _mm256_set1_epi16(P1),
+					  vMinLpP2 = _mm256_set1_epi16(minLp + P2),
+					  vMinLp = _mm256_set1_epi16(minLp);
+		__m256i vmin = _mm256_set1_epi16(BIG_COST);
+		for (; d + 16 <= D; d += 16)
+		{
+			const __m256i c = _mm256_cvtepu8_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(C + d)));
+			const __m256i lp =
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(Lp + d));
+			const __m256i lm = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(Lp + d - 1));
+			const __m256i lq = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(Lp + d + 1));
+			__m256i m = _mm256_min_epi16(
+				_mm256_adds_epi16(lm, vP1), _mm256_adds_epi16(lq, vP1));
+			m = _mm256_min_epi16(_mm256_min_epi16(m, lp), vMinLpP2);
+			const __m256i l =
+				_mm256_add_epi16(c, _mm256_sub_epi16(m, vMinLp));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(Lc + d), l);
+			vmin = _mm256_min_epi16(vmin, l);
+			__m256i* s = reinterpret_cast<__m256i*>(S + d);
+			_mm256_storeu_si256(
+				s, _mm256_add_epi16(_mm256_loadu_si256(s), l));
+		}
+		__m128i v = _mm_min_epi16(
+			_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+		v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		minLc = int16_t(_mm_cvtsi128_si32(v) & 0xFFFF);
+	}
+#elif MRPT_HAS_SSE2
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i vP1 = _mm_set1_epi16(P1),
+					  vMinLpP2 = _mm_set1_epi16(minLp + P2),
+					  vMinLp = _mm_set1_epi16(minLp);
+		__m128i vmin = _mm_set1_epi16(BIG_COST);
+		for (; d + 8 <= D; d += 8)
+		{
+			const __m128i c = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(C + d)),
+				zero);
+			const __m128i lp =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(Lp + d));
+			const __m128i lm =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(Lp + d - 1));
+			const __m128i lq =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(Lp + d + 1));
+			__m128i m =
+				_mm_min_epi16(_mm_adds_epi16(lm, vP1), _mm_adds_epi16(lq, vP1));
+			m = _mm_min_epi16(_mm_min_epi16(m, lp), vMinLpP2);
+			const __m128i l = _mm_add_epi16(c, _mm_sub_epi16(m, vMinLp));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Lc + d), l);
+			vmin = _mm_min_epi16(vmin, l);
+			__m128i* s = reinterpret_cast<__m128i*>(S + d);
+			_mm_storeu_si128(s, _mm_add_epi16(_mm_loadu_si128(s), l));
+		}
+		__m128i v = vmin;
+		v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		minLc = int16_t(_mm_cvtsi128_si32(v) & 0xFFFF);
+	}
+#endif
+	for (; d < D; d++)
+	{
+		const int m = std::min(
+			std::min<int>(Lp[d], std::min(Lp[d - 1], Lp[d + 1]) + P1),
+			minLp + P2);
+		const int l = C[d] + m - minLp;
+		Lc[d] = l;
+		S[d] += l;
+		minLc = std::min(minLc, l);
+	}
+	return minLc;
+}
+
+/** Aggregates the costs along the \a n paths which start at \a starts and
+ * advance by (dx,dy) until leaving the image. Paths are advanced in lockstep
+ * so that neighboring paths access neighboring memory. \a buffers has room
+ * for two rows of D costs with padding for each path. */
+void aggregate_scanlines(
+	const uint8_t* costs, uint16_t* S, const int w, const int h,
+	const size_t D, const int P1, const int P2,
+	const std::pair<int, int>* starts, const size_t n, const int dx,
+	const int dy, std::vector<int16_t>& buffers)
+{
+	const size_t buf_len = 2 * (D + 2 * PAD);
+	buffers.resize(n * buf_len);
+	int16_t* Lp[SCANLINES_PER_JOB];
+	int16_t* Lc[SCANLINES_PER_JOB];
+	int minLp[SCANLINES_PER_JOB];
+	ASSERT_(n <= SCANLINES_PER_JOB)
+
+	// The first pixel: just its costs
+	for (size_t i = 0; i < n; i++)
+	{
+		Lp[i] = &buffers[i * buf_len + PAD];
+		Lc[i] = &buffers[i * buf_len + D + 3 * PAD];
+		Lp[i][-1] = Lp[i][D] = Lc[i][-1] = Lc[i][D] = BIG_COST;
+
+		const size_t idx =
+			(size_t(starts[i].second) * w + starts[i].first) * D;
+		minLp[i] = BIG_COST;
+		for (size_t d = 0; d < D; d++)
+		{
+			Lp[i][d] = costs[idx + d];
+			S[idx + d] += costs[idx + d];
+			minLp[i] = std::min<int>(minLp[i], Lp[i][d]);
+		}
+	}
+	for (int step = 1;; step++)
+	{
+		bool any = false;
+		for (size_t i = 0; i < n; i++)
+		{
+			const int x = starts[i].first + step * dx,
+					  y = starts[i].second + step * dy;
+			if (x < 0 || y < 0 || x >= w || y >= h) continue;
+			any = true;
+			const size_t idx = (size_t(y) * w + x) * D;
+			minLp[i] = aggregate_pixel(
+				&costs[idx], Lp[i], minLp[i], P1, P2, D, Lc[i], &S[idx]);
+			std::swap(Lp[i], Lc[i]);
+		}
+		if (!any) break;
+	}
+}
+}  // namespace
+
+/*---------------------------------------------------------------
+					TOptions
+  ---------------------------------------------------------------*/
+CStereoSGM::TOptions::TOptions()
+	: min_disparity(0),
+	  num_disparities(64),
+	  P1(10),
+	  P2(120),
+	  num_paths(8),
+	  uniqueness_ratio(0.05f),
+	  left_right_check(true),
+	  lr_max_diff(1),
+	  subpixel(true),
+	  max_depth(0),
+	  num_threads(0)
+{
+}
+
+void CStereoSGM::TOptions::loadFromConfigFile(
+	const mrpt::utils::CConfigFileBase& iniFile, const std::string& section)
+{
+	const int min_disp =
+		iniFile.read_int(section, "min_disparity", min_disparity);
+	ASSERTMSG_(min_disp >= 0, "min_disparity must not be negative")
+	min_disparity = min_disp;
+	MRPT_LOAD_CONFIG_VAR(num_disparities, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(P1, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(P2, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(num_paths, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(uniqueness_ratio, float, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(left_right_check, bool, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(lr_max_diff, int, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(subpixel, bool, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(max_depth, float, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(num_threads, int, iniFile, section)
+}
+
+void CStereoSGM::TOptions::dumpToTextStream(mrpt::utils::CStream& out) const
+{
+	out.printf("\n----------- [CStereoSGM::TOptions] ------------ \n\n");
+	LOADABLEOPTS_DUMP_VAR(min_disparity, int)
+	LOADABLEOPTS_DUMP_VAR(num_disparities, int)
+	LOADABLEOPTS_DUMP_VAR(P1, int)
+	LOADABLEOPTS_DUMP_VAR(P2, int)
+	LOADABLEOPTS_DUMP_VAR(num_paths, int)
+	LOADABLEOPTS_DUMP_VAR(uniqueness_ratio, float)
+	LOADABLEOPTS_DUMP_VAR(left_right_check, bool)
+	LOADABLEOPTS_DUMP_VAR(lr_max_diff, int)
+	LOADABLEOPTS_DUMP_VAR(subpixel, bool)
+	LOADABLEOPTS_DUMP_VAR(max_depth, float)
+	LOADABLEOPTS_DUMP_VAR(num_threads, int)
+	out.printf("\n");
+}
+
+/*---------------------------------------------------------------
+					computeDisparity
+  ---------------------------------------------------------------*/
+void CStereoSGM::computeDisparity(
+	const uint8_t* left, const size_t left_stride, const uint8_t* right,
+	const size_t right_stride, const unsigned int width,
+	const unsigned int height, std::vector<float>& disparity) const
+{
+	MRPT_START
+	const TOptions& o = options;
+	ASSERT_(o.num_disparities > 0 && (o.num_disparities % 16) == 0)
+	ASSERT_(o.num_paths == 4 || o.num_paths == 8)
+	// (The sum of the 8 paths must fit in 16 bits)
+	ASSERT_(o.P1 < o.P2 && o.P2 < 4096)
+	ASSERT_(width > 0 && height > 0)
+
+	const int w = width, h = height;
+	const size_t D = o.num_disparities, N = size_t(w) * h;
+	const int dmin = o.min_disparity;
+	ASSERT_(dmin >= 0)
+
+	const size_t num_threads = o.num_threads;
+	const size_t num_row_jobs = (height + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+
+	// Census of both images and matching costs, by blocks of rows:
+	m_census_left.resize(N);
+	m_census_right.resize(N);
+	m_costs.resize(N * D);
+	m_aggr_costs.assign(N * D, 0);
+	parallel_for_jobs(num_row_jobs, num_threads, [&](const size_t j) {
+		const int y0 = j * ROWS_PER_JOB,
+				  y1 = std::min<int>(h, y0 + ROWS_PER_JOB);
+		census_rows(left, left_stride, w, h, y0, y1, &m_census_left[0]);
+		census_rows(right, right_stride, w, h, y0, y1, &m_census_right[0]);
+		for (int y = y0; y < y1; y++)
+		{
+			const uint64_t* cl = &m_census_left[size_t(y) * w];
+			const uint64_t* cr = &m_census_right[size_t(y) * w];
+			for (int x = 0; x < w; x++)
+			{
+				uint8_t* c = &m_costs[(size_t(y) * w + x) * D];
+				for (size_t d = 0; d < D; d++)
+				{
+					const int xr = x - dmin - int(d);
+					c[d] = xr >= 0 ? popcount64(cl[x] ^ cr[xr]) : MAX_COST;
+				}
+			}
+		}
+	});
+
+	// Aggregation: for each direction, its scanlines are independent and
+	// write to different pixels, so they are processed in parallel:
+	const int dirs[8][2] = {{1, 0},  {-1, 0}, {0, 1},  {0, -1},
+							{1, 1},  {-1, -1}, {1, -1}, {-1, 1}};
+	for (unsigned int k = 0; k < o.num_paths; k++)
+	{
+		const int dx = dirs[k][0], dy = dirs[k][1];
+		// Scanlines start at the border pixels whose previous pixel is out:
+		std::vector<std::pair<int, int>> starts;
+		auto add_if_start = [&](const int x, const int y) {
+			const int px = x - dx, py = y - dy;
+			if (px < 0 || py < 0 || px >= w || py >= h)
+				starts.emplace_back(x, y);
+		};
+		for (int x = 0; x < w; x++)
+		{
+			add_if_start(x, 0);
+			if (h > 1) add_if_start(x, h - 1);
+		}
+		for (int y = 1; y < h - 1; y++)
+		{
+			add_if_start(0, y);
+			if (w > 1) add_if_start(w - 1, y);
+		}
+
+		const size_t num_jobs =
+			(starts.size() + SCANLINES_PER_JOB - 1) / SCANLINES_PER_JOB;
+		parallel_for_jobs(num_jobs, num_threads, [&](const size_t j) {
+			std::vector<int16_t> buffers;
+			const size_t i0 = j * SCANLINES_PER_JOB;
+			const size_t i1 = std::min(starts.size(), i0 + SCANLINES_PER_JOB);
+			aggregate_scanlines(
+				&m_costs[0], &m_aggr_costs[0], w, h, D, o.P1, o.P2,
+				&starts[i0], i1 - i0, dx, dy, buffers);
+		});
+	}
+
+	// Winner-takes-all, by rows:
+	disparity.resize(N);
+	parallel_for_jobs(num_row_jobs, num_threads, [&](const size_t j) {
+		const int y0 = j * ROWS_PER_JOB,
+				  y1 = std::min<int>(h, y0 + ROWS_PER_JOB);
+		std::vector<int> best_left(w), best_right(w);
+		std::vector<uint16_t> best_right_cost(w);
+		for (int y = y0; y < y1; y++)
+		{
+			const uint16_t* S = &m_aggr_costs[size_t(y) * w * D];
+			float* disp = &disparity[size_t(y) * w];
+
+			// The best disparity of each right pixel xr is updated from the
+			// costs of the left pixels xr+dmin+d while scanning them, so the
+			// costs are read sequentially:
+			std::fill(best_right.begin(), best_right.end(), -1);
+			std::fill(best_right_cost.begin(), best_right_cost.end(), 0xFFFF);
+			for (int x = 0; x < w; x++)
+			{
+				best_left[x] = -1;
+				const int nd = std::min<int>(D, x - dmin + 1);
+				if (nd <= 0) continue;
+				const uint16_t* s = S + size_t(x) * D;
+				uint16_t min_cost = s[0];
+				for (int d = 1; d < nd; d++)
+					min_cost = std::min(min_cost, s[d]);
+				int best = 0;
+				while (s[best] != min_cost) best++;
+				best_left[x] = best;
+
+				if (o.left_right_check)
+					for (int d = 0, xr = x - dmin; d < nd; d++, xr--)
+					{
+						// (Branchless: the outcome is hard to predict)
+						const bool better = s[d] < best_right_cost[xr];
+						best_right_cost[xr] =
+							better ? s[d] : best_right_cost[xr];
+						best_right[xr] = better ? d : best_right[xr];
+					}
+			}
+
+			for (int x = 0; x < w; x++)
+			{
+				disp[x] = INVALID_DISPARITY;
+				const int best = best_left[x];
+				if (best < 0) continue;
+				const int nd = std::min<int>(D, x - dmin + 1);
+				const uint16_t* s = S + size_t(x) * D;
+
+				if (o.uniqueness_ratio > 0)
+				{
+					// Smallest cost but the best one and its neighbors:
+					uint16_t second = 0xFFFF;
+					for (int d = 0; d < best - 1; d++)
+						second = std::min(second, s[d]);
+					for (int d = best + 2; d < nd; d++)
+						second = std::min(second, s[d]);
+					if (second < (1 + o.uniqueness_ratio) * s[best]) continue;
+				}
+				if (o.left_right_check &&
+					std::abs(best_right[x - dmin - best] - best) >
+						int(o.lr_max_diff))
+					continue;
+
+				float delta = 0;
+				if (o.subpixel && best > 0 && best < nd - 1)
+				{
+					const int c0 = s[best - 1], c1 = s[best], c2 = s[best + 1];
+					const int den = c0 - 2 * c1 + c2;
+					if (den > 0) delta = (c0 - c2) / (2.0f * den);
+				}
+				disp[x] = dmin + best + delta;
+			}
+		}
+	});
+	MRPT_END
+}
+
+void CStereoSGM::computeDisparity(
+	const mrpt::utils::CImage& left, const mrpt::utils::CImage& right,
+	mrpt::math::CMatrixFloat& disparity) const
+{
+	MRPT_START
+#if MRPT_HAS_OPENCV
+	ASSERT_(
+		left.getWidth() == right.getWidth() &&
+		left.getHeight() == right.getHeight())
+	const CImage gray_left = left.isColor() ? left.grayscale() : left;
+	const CImage gray_right = right.isColor() ? right.grayscale() : right;
+	const unsigned int w = left.getWidth(), h = left.getHeight();
+
+	std::vector<float> disp;
+	computeDisparity(
+		gray_left.get_unsafe(0, 0), gray_left.getRowStride(),
+		gray_right.get_unsafe(0, 0), gray_right.getRowStride(), w, h, disp);
+	disparity.setSize(h, w);
+	for (unsigned int y = 0; y < h; y++)
+		for (unsigned int x = 0; x < w; x++)
+			disparity(y, x) = disp[size_t(y) * w + x];
+#else
+	MRPT_UNUSED_PARAM(left);
+	MRPT_UNUSED_PARAM(right);
+	MRPT_UNUSED_PARAM(disparity);
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
+#endif
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					computeRangeScan
+  ---------------------------------------------------------------*/
+void CStereoSGM::computeRangeScan(
+	const CObservationStereoImages& stereo_obs,
+	CObservation3DRangeScan& out_obs) const
+{
+	MRPT_START
+	ASSERT_(stereo_obs.hasImageRight)
+
+	// Depth from disparity in rectified images, whose principal points may
+	// not coincide: d = fx*B/Z + (cx_left - cx_right)
+	const TCamera& cam = stereo_obs.leftCamera;
+	const double fx_B =
+		cam.fx() * stereo_obs.rightCameraPose.m_coords.norm();
+	const double doffs = cam.cx() - stereo_obs.rightCamera.cx();
+	ASSERT_ABOVE_(fx_B, 0)
+
+	mrpt::math::CMatrixFloat disparity;
+	computeDisparity(stereo_obs.imageLeft, stereo_obs.imageRight, disparity);
+
+	const int h = disparity.rows(), w = disparity.cols();
+	out_obs.rangeImage_setSize(h, w);
+	for (int y = 0; y < h; y++)
+		for (int x = 0; x < w; x++)
+		{
+			const float d = disparity(y, x);
+			float depth = 0;
+			if (d != INVALID_DISPARITY && d - doffs > 0)
+			{
+				depth = fx_B / (d - doffs);
+				if (options.max_depth > 0 && depth > options.max_depth)
+					depth = 0;
+			}
+			out_obs.rangeImage(y, x) = depth;
+		}
+	out_obs.hasRangeImage = true;
+	out_obs.range_is_depth = true;
+	out_obs.hasPoints3D = false;
+	out_obs.hasConfidenceImage = false;
+
+	out_obs.hasIntensityImage = true;
+	out_obs.intensityImage = stereo_obs.imageLeft;
+	out_obs.intensityImageChannel = CObservation3DRangeScan::CH_VISIBLE;
+
+	// Both the depth and intensity "cameras" are the left camera:
+	out_obs.cameraParams = cam;
+	out_obs.cameraParamsIntensity = cam;
+	const CPose3D camera_wrt_depth(0, 0, 0, DEG2RAD(-90), 0, DEG2RAD(-90));
+	out_obs.relativePoseIntensityWRTDepth = camera_wrt_depth;
+	out_obs.sensorPose =
+		CPose3D(stereo_obs.cameraPose) + (CPose3D() - camera_wrt_depth);
+	const double max_disp_depth =
+		fx_B / std::max(1.0, options.min_disparity - doffs);
+	out_obs.maxRange =
+		options.max_depth > 0 ? options.max_depth : max_disp_depth;
+
+	out_obs.timestamp = stereo_obs.timestamp;
+	out_obs.sensorLabel = stereo_obs.sensorLabel;
+	MRPT_END
+}
@@ -0,0 +1,119 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CStereoSGM.h>
+#include <mrpt/utils/CConfigFileMemory.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::random;
+using namespace std;
+
+static const unsigned int W = 128, H = 96;
+
+/** A random texture, smoothed horizontally, and a right image such that the
+ * left pixel (x,y) is seen at x-disp(y) in the right image */
+template <class DISP>
+static void createStereoPair(
+	vector<uint8_t>& left, vector<uint8_t>& right, DISP disp)
+{
+	const unsigned int TW = 2 * W;
+	randomGenerator.randomize(1);
+	vector<uint8_t> tex(TW * H);
+	for (unsigned int y = 0; y < H; y++)
+	{
+		int prev = randomGenerator.drawUniform32bit() % 256;
+		for (unsigned int x = 0; x < TW; x++)
+		{
+			prev = (prev + int(randomGenerator.drawUniform32bit() % 256)) / 2;
+			tex[y * TW + x] = prev;
+		}
+	}
+	left.resize(W * H);
+	right.resize(W * H);
+	for (unsigned int y = 0; y < H; y++)
+		for (unsigned int x = 0; x < W; x++)
+		{
+			left[y * W + x] = tex[y * TW + x];
+			right[y * W + x] = tex[y * TW + x + disp(y)];
+		}
+}
+
+TEST(CStereoSGM, ConstantDisparity)
+{
+	const unsigned int disp = 13;
+	vector<uint8_t> left, right;
+	createStereoPair(left, right, [&](unsigned int) { return disp; });
+
+	CStereoSGM sgm;
+	sgm.options.min_disparity = 4;
+	sgm.options.num_disparities = 32;
+	vector<float> d;
+	sgm.computeDisparity(&left[0], W, &right[0], W, W, H, d);
+	ASSERT_EQ(d.size(), size_t(W * H));
+
+	size_t num_ok = 0, num = 0;
+	for (unsigned int y = 0; y < H; y++)
+		for (unsigned int x = 4 + 32; x < W; x++, num++)
+			if (d[y * W + x] != CStereoSGM::INVALID_DISPARITY &&
+				std::abs(d[y * W + x] - disp) < 0.5f)
+				num_ok++;
+	EXPECT_GT(num_ok, 0.95 * num);
+	// No match is possible for x < min_disparity:
+	for (unsigned int y = 0; y < H; y++)
+		for (unsigned int x = 0; x < 4; x++)
+			EXPECT_EQ(d[y * W + x], CStereoSGM::INVALID_DISPARITY);
+}
+
+TEST(CStereoSGM, SameResultsWithThreads)
+{
+	// Disparities changing from row to row:
+	auto disp = [](unsigned int y) { return 5 + y / 8; };
+	vector<uint8_t> left, right;
+	createStereoPair(left, right, disp);
+
+	for (unsigned int num_paths = 4; num_paths <= 8; num_paths += 4)
+	{
+		CStereoSGM sgm;
+		sgm.options.num_disparities = 32;
+		sgm.options.num_paths = num_paths;
+		sgm.options.num_threads = 1;
+		vector<float> d1, d3;
+		sgm.computeDisparity(&left[0], W, &right[0], W, W, H, d1);
+		sgm.options.num_threads = 3;
+		sgm.computeDisparity(&left[0], W, &right[0], W, W, H, d3);
+		EXPECT_TRUE(d1 == d3);
+
+		size_t num_ok = 0, num = 0;
+		for (unsigned int y = 0; y < H; y++)
+			for (unsigned int x = 32; x < W; x++, num++)
+				if (std::abs(d1[y * W + x] - float(disp(y))) <= 1.0f)
+					num_ok++;
+		EXPECT_GT(num_ok, 0.85 * num);
+	}
+}
+
+TEST(CStereoSGM, NegativeMinDisparity)
+{
+	mrpt::utils::CConfigFileMemory cfg;
+	cfg.write("SGM", "min_disparity", -4);
+	CStereoSGM sgm;
+	EXPECT_ANY_THROW(sgm.options.loadFromConfigFile(cfg, "SGM"));
+
+	// Values that do not fit in an int are rejected too:
+	vector<uint8_t> left, right;
+	createStereoPair(left, right, [](unsigned int) { return 8; });
+	sgm.options.min_disparity = static_cast<unsigned int>(-4);
+	vector<float> d;
+	EXPECT_ANY_THROW(
+		sgm.computeDisparity(&left[0], W, &right[0], W, W, H, d));
+}
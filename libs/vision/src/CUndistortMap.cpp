@@ -15,72 +15,83 @@
 
 using namespace mrpt;
 using namespace mrpt::vision;
+using namespace mrpt::utils;
 
 // Ctor: Leave all vectors empty
-CUndistortMap::CUndistortMap() {}
+CUndistortMap::CUndistortMap() : m_num_threads(0) {}
 /** Prepares the mapping from the distortion parameters of a camera.
   * Must be called before invoking \a undistort().
   */
 void CUndistortMap::setFromCamParams(const mrpt::utils::TCamera& campar)
 {
 	MRPT_START
-#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
 	m_camera_params = campar;
 
-	// Convert to opencv's format:
-	double aux1[3][3], aux2[1][5];
-	for (int i = 0; i < 3; i++)
-		for (int j = 0; j < 3; j++) aux1[i][j] = campar.intrinsicParams(i, j);
-	for (int i = 0; i < 5; i++) aux2[0][i] = campar.dist[i];
-
-	const cv::Mat inMat(3, 3, CV_64F, aux1);
-	const cv::Mat distM(1, 5, CV_64F, aux2);
-
-	m_dat_mapx.resize(2 * campar.nrows * campar.ncols);
-	m_dat_mapy.resize(campar.nrows * campar.ncols);
-
-	CvMat mapx = cvMat(campar.nrows, campar.ncols, CV_16SC2, &m_dat_mapx[0]);
-	CvMat mapy = cvMat(campar.nrows, campar.ncols, CV_16UC1, &m_dat_mapy[0]);
-
-	cv::Mat _mapx = cv::cvarrToMat(&mapx, false);
-	cv::Mat _mapy = cv::cvarrToMat(&mapy, false);
-
-	cv::initUndistortRectifyMap(
-		inMat, distM, cv::Mat(), inMat, _mapx.size(), _mapx.type(), _mapx,
-		_mapy);
-#else
-	THROW_EXCEPTION("MRPT built without OpenCV >=2.0.0!")
-#endif
+	// Same intrinsic parameters, no rotation:
+	mrpt::math::CMatrixDouble33 R;
+	R.setIdentity();
+	m_lut.setFromCamera(
+		campar, R, campar.intrinsicParams, campar.ncols, campar.nrows);
 	MRPT_END
 }
 
-/** Undistort the input image and saves the result in-place- \a
+/** Undistort the input image and saves the result in the output one - \a
  * setFromCamParams() must have been set prior to calling this.
   */
 void CUndistortMap::undistort(
 	const mrpt::utils::CImage& in_img, mrpt::utils::CImage& out_img) const
 {
 	MRPT_START
-	if (m_dat_mapx.empty())
+	if (m_lut.empty())
 		THROW_EXCEPTION(
 			"Error: setFromCamParams() must be called prior to undistort().")
 
-#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
-	CvMat mapx = cvMat(
-		m_camera_params.nrows, m_camera_params.ncols, CV_16SC2,
-		const_cast<int16_t*>(
-			&m_dat_mapx[0]));  // Wrappers on the data as a CvMat's.
-	CvMat mapy = cvMat(
-		m_camera_params.nrows, m_camera_params.ncols, CV_16UC1,
-		const_cast<uint16_t*>(&m_dat_mapy[0]));
-
-	const IplImage* srcImg = in_img.getAs<IplImage>();  // Source Image
-	IplImage* outImg =
-		cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
-	cvRemap(srcImg, outImg, &mapx, &mapy);  // cv::remap(src, dst_part,
-	// map1_part, map2_part,
-	// INTER_LINEAR, BORDER_CONSTANT );
-	out_img.setFromIplImage(outImg);
+#if MRPT_HAS_OPENCV
+	ASSERT_(
+		in_img.getWidth() == m_lut.src_width &&
+		in_img.getHeight() == m_lut.src_height)
+
+	if (&in_img == &out_img)
+	{
+		// The source must not be overwritten while remapping:
+		mrpt::utils::CImage tmp;
+		undistort(in_img, tmp);
+		out_img.swap(tmp);
+		return;
+	}
+
+	const IplImage* srcImg = in_img.getAs<IplImage>();
+	const TImageChannels nch = in_img.getChannelCount();
+	if (srcImg->depth == IPL_DEPTH_8U && (nch == 1 || nch == 3))
+	{
+		out_img.resize(
+			m_lut.width, m_lut.height, nch, in_img.isOriginTopLeft());
+		m_lut.remap(
+			in_img.get_unsafe(0, 0), in_img.getRowStride(),
+			out_img.get_unsafe(0, 0), out_img.getRowStride(), nch, false,
+			m_num_threads);
+	}
+	else
+	{
+		// Other pixel formats: OpenCV's remap() with the maps in its format
+		std::vector<int16_t> map_xy;
+		std::vector<uint16_t> map_frac;
+		m_lut.getAsOpenCVMaps(map_xy, map_frac);
+		const cv::Mat mapx(m_lut.height, m_lut.width, CV_16SC2, &map_xy[0]);
+		const cv::Mat mapy(m_lut.height, m_lut.width, CV_16UC1, &map_frac[0]);
+		IplImage* outImg = cvCreateImage(
+			cvSize(m_lut.width, m_lut.height), srcImg->depth,
+			srcImg->nChannels);
+		cv::Mat dst = cv::cvarrToMat(outImg);
+		cv::remap(
+			cv::cvarrToMat(srcImg), dst, mapx, mapy, cv::INTER_LINEAR,
+			cv::BORDER_CONSTANT, cvScalarAll(0));
+		out_img.setFromIplImage(outImg);
+	}
+#else
+	MRPT_UNUSED_PARAM(in_img);
+	MRPT_UNUSED_PARAM(out_img);
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
 #endif
 	MRPT_END
 }
@@ -91,26 +102,8 @@ void CUndistortMap::undistort(
 void CUndistortMap::undistort(mrpt::utils::CImage& in_out_img) const
 {
 	MRPT_START
-	if (m_dat_mapx.empty())
-		THROW_EXCEPTION(
-			"Error: setFromCamParams() must be called prior to undistort().")
-
-#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
-	CvMat mapx = cvMat(
-		m_camera_params.nrows, m_camera_params.ncols, CV_16SC2,
-		const_cast<int16_t*>(
-			&m_dat_mapx[0]));  // Wrappers on the data as a CvMat's.
-	CvMat mapy = cvMat(
-		m_camera_params.nrows, m_camera_params.ncols, CV_16UC1,
-		const_cast<uint16_t*>(&m_dat_mapy[0]));
-
-	const IplImage* srcImg = in_out_img.getAs<IplImage>();  // Source Image
-	IplImage* outImg =
-		cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
-	cvRemap(srcImg, outImg, &mapx, &mapy);  // cv::remap(src, dst_part,
-	// map1_part, map2_part,
-	// INTER_LINEAR, BORDER_CONSTANT );
-	in_out_img.setFromIplImage(outImg);
-#endif
+	mrpt::utils::CImage out_img;
+	undistort(in_out_img, out_img);
+	in_out_img.swap(out_img);
 	MRPT_END
 }
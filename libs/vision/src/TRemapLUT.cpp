@@ -0,0 +1,449 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/TRemapLUT.h>
+#include <mrpt/utils/SSE_types.h>
+#include <mrpt/utils/parallel.h>
+#include <cmath>
+#include <cstring>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::math;
+using namespace std;
+
+const int TRemapLUT::FRAC_BITS;
+const int TRemapLUT::FRAC_ONE;
+const uint8_t TRemapLUT::INVALID;
+
+namespace
+{
+/** Output rows remapped by each thread at a time */
+const unsigned int ROWS_PER_JOB = 16;
+
+const int FRAC_BITS = TRemapLUT::FRAC_BITS;
+const int FRAC_ONE = TRemapLUT::FRAC_ONE;
+
+/** Stores the source of the output pixel `i`, given as the integer and
+ * fractional parts of its coordinates, which must be within the source
+ * image. The last column (row) is reached from the previous one with a
+ * fraction of FRAC_ONE, so the 2x2 neighborhood is always in the image. */
+void set_lut_pixel(
+	TRemapLUT& lut, const size_t i, int ix, int iy, int fx, int fy)
+{
+	const int w = lut.src_width, h = lut.src_height;
+	if (ix < 0 || iy < 0 || ix >= w || iy >= h || (ix == w - 1 && fx) ||
+		(iy == h - 1 && fy))
+	{
+		lut.src_x[i] = lut.src_y[i] = 0;
+		lut.frac_x[i] = TRemapLUT::INVALID;
+		lut.frac_y[i] = 0;
+		return;
+	}
+	if (ix == w - 1)
+	{
+		ix--;
+		fx = FRAC_ONE;
+	}
+	if (iy == h - 1)
+	{
+		iy--;
+		fy = FRAC_ONE;
+	}
+	lut.src_x[i] = ix;
+	lut.src_y[i] = iy;
+	lut.frac_x[i] = fx;
+	lut.frac_y[i] = fy;
+}
+
+/** The value of channel `c` of one output pixel with bilinear interpolation.
+ * The SIMD kernels below give exactly the same result. */
+inline uint8_t bilinear_pixel(
+	const uint8_t* p, const size_t stride, const unsigned int nch, const int fx,
+	const int fy)
+{
+	const int top = p[0] * (FRAC_ONE - fx) + p[nch] * fx;
+	const int bot = p[stride] * (FRAC_ONE - fx) + p[stride + nch] * fx;
+	return static_cast<uint8_t>(
+		(top * (FRAC_ONE - fy) + bot * fy + (1 << (2 * FRAC_BITS - 1))) >>
+		(2 * FRAC_BITS));
+}
+
+/** The pair of horizontal neighbors p[0] and p[nch], as the low and high
+ * bytes of a 16-bit word */
+template <unsigned int NCH>
+inline int16_t pixel_pair(const uint8_t* p)
+{
+	return static_cast<int16_t>(p[0] | (p[NCH] << 8));
+}
+
+#if MRPT_HAS_SSE2
+/** Bilinear interpolation of 8 pixels: T and B hold the pixel pairs of the
+ * top and bottom rows (see pixel_pair()), wx/wy the fractional coordinates
+ * and `invalid` the mask of the pixels to set to zero. Returns the 8 output
+ * values in the low 64 bits. */
+inline __m128i bilinear_sse2(
+	const __m128i T, const __m128i B, const __m128i wx0, const __m128i wx1,
+	const __m128i wy0, const __m128i wy1, const __m128i invalid)
+{
+	const __m128i lo_byte = _mm_set1_epi16(0x00FF);
+	const __m128i round = _mm_set1_epi32(1 << (2 * FRAC_BITS - 1));
+	// Horizontal pass (fits in 16 bits: 255*FRAC_ONE):
+	const __m128i t = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_and_si128(T, lo_byte), wx0),
+		_mm_mullo_epi16(_mm_srli_epi16(T, 8), wx1));
+	const __m128i b = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_and_si128(B, lo_byte), wx0),
+		_mm_mullo_epi16(_mm_srli_epi16(B, 8), wx1));
+	// Vertical pass, in 32 bits:
+	__m128i r_lo = _mm_madd_epi16(
+		_mm_unpacklo_epi16(t, b), _mm_unpacklo_epi16(wy0, wy1));
+	__m128i r_hi = _mm_madd_epi16(
+		_mm_unpackhi_epi16(t, b), _mm_unpackhi_epi16(wy0, wy1));
+	r_lo = _mm_srai_epi32(_mm_add_epi32(r_lo, round), 2 * FRAC_BITS);
+	r_hi = _mm_srai_epi32(_mm_add_epi32(r_hi, round), 2 * FRAC_BITS);
+	const __m128i r = _mm_andnot_si128(invalid, _mm_packs_epi32(r_lo, r_hi));
+	return _mm_packus_epi16(r, r);
+}
+
+/** Remaps the 8 output pixels starting at LUT index `idx` */
+template <unsigned int NCH>
+inline void remap8_sse2(
+	const TRemapLUT& lut, const size_t idx, const uint8_t* src,
+	const size_t src_stride, uint8_t* dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(FRAC_ONE);
+	__m128i wx1 = _mm_unpacklo_epi8(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&lut.frac_x[idx])),
+		zero);
+	const __m128i wy1 = _mm_unpacklo_epi8(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&lut.frac_y[idx])),
+		zero);
+	const __m128i invalid =
+		_mm_cmpeq_epi16(wx1, _mm_set1_epi16(TRemapLUT::INVALID));
+	wx1 = _mm_andnot_si128(invalid, wx1);
+	const __m128i wx0 = _mm_sub_epi16(one, wx1), wy0 = _mm_sub_epi16(one, wy1);
+
+	const uint8_t* p[8];
+	for (int k = 0; k < 8; k++)
+		p[k] = src + lut.src_y[idx + k] * src_stride + lut.src_x[idx + k] * NCH;
+
+	for (unsigned int c = 0; c < NCH; c++)
+	{
+		const __m128i T = _mm_setr_epi16(
+			pixel_pair<NCH>(p[0] + c), pixel_pair<NCH>(p[1] + c),
+			pixel_pair<NCH>(p[2] + c), pixel_pair<NCH>(p[3] + c),
+			pixel_pair<NCH>(p[4] + c), pixel_pair<NCH>(p[5] + c),
+			pixel_pair<NCH>(p[6] + c), pixel_pair<NCH>(p[7] + c));
+		const size_t s = src_stride + c;
+		const __m128i B = _mm_setr_epi16(
+			pixel_pair<NCH>(p[0] + s), pixel_pair<NCH>(p[1] + s),
+			pixel_pair<NCH>(p[2] + s), pixel_pair<NCH>(p[3] + s),
+			pixel_pair<NCH>(p[4] + s), pixel_pair<NCH>(p[5] + s),
+			pixel_pair<NCH>(p[6] + s), pixel_pair<NCH>(p[7] + s));
+		const __m128i r = bilinear_sse2(T, B, wx0, wx1, wy0, wy1, invalid);
+		if (NCH == 1)
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), r);
+		else
+		{
+			uint8_t out[16];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), r);
+			for (int k = 0; k < 8; k++) dst[k * NCH + c] = out[k];
+		}
+	}
+}
+#endif
+
+#if MRPT_HAS_AVX2
+/** Like bilinear_sse2(), for 16 pixels (returned in the low 128 bits) */
+inline __m128i bilinear_avx2(
+	const __m256i T, const __m256i B, const __m256i wx0, const __m256i wx1,
+	const __m256i wy0, const __m256i wy1, const __m256i invalid)
+{
+	const __m256i lo_byte = _mm256_set1_epi16(0x00FF);
+	const __m256i round = _mm256_set1_epi32(1 << (2 * FRAC_BITS - 1));
+	const __m256i t = _mm256_add_epi16(
+		_mm256_mullo_epi16(_mm256_and_si256(T, lo_byte), wx0),
+		_mm256_mullo_epi16(_mm256_srli_epi16(T, 8), wx1));
+	const __m256i b = _mm256_add_epi16(
+		_mm256_mullo_epi16(_mm256_and_si256(B, lo_byte), wx0),
+		_mm256_mullo_epi16(_mm256_srli_epi16(B, 8), wx1));
+	// unpack/pack work within each 128-bit lane, so pixels keep their order:
+	__m256i r_lo = _mm256_madd_epi16(
+		_mm256_unpacklo_epi16(t, b), _mm256_unpacklo_epi16(wy0, wy1));
+	__m256i r_hi = _mm256_madd_epi16(
+		_mm256_unpackhi_epi16(t, b), _mm256_unpackhi_epi16(wy0, wy1));
+	r_lo = _mm256_srai_epi32(_mm256_add_epi32(r_lo, round), 2 * FRAC_BITS);
+	r_hi = _mm256_srai_epi32(_mm256_add_epi32(r_hi, round), 2 * FRAC_BITS);
+	const __m256i r =
+		_mm256_andnot_si256(invalid, _mm256_packs_epi32(r_lo, r_hi));
+	const __m256i r8 = _mm256_permute4x64_epi64(
+		_mm256_packus_epi16(r, r), _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm256_castsi256_si128(r8);
+}
+
+/** Remaps the 16 output pixels starting at LUT index `idx` of a grayscale
+ * image */
+inline void remap16_avx2(
+	const TRemapLUT& lut, const size_t idx, const uint8_t* src,
+	const size_t src_stride, uint8_t* dst)
+{
+	const __m256i one = _mm256_set1_epi16(FRAC_ONE);
+	__m256i wx1 = _mm256_cvtepu8_epi16(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(&lut.frac_x[idx])));
+	const __m256i wy1 = _mm256_cvtepu8_epi16(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(&lut.frac_y[idx])));
+	const __m256i invalid =
+		_mm256_cmpeq_epi16(wx1, _mm256_set1_epi16(TRemapLUT::INVALID));
+	wx1 = _mm256_andnot_si256(invalid, wx1);
+	const __m256i wx0 = _mm256_sub_epi16(one, wx1),
+				  wy0 = _mm256_sub_epi16(one, wy1);
+
+	const uint8_t* p[16];
+	for (int k = 0; k < 16; k++)
+		p[k] = src + lut.src_y[idx + k] * src_stride + lut.src_x[idx + k];
+	const size_t s = src_stride;
+	const __m256i T = _mm256_setr_epi16(
+		pixel_pair<1>(p[0]), pixel_pair<1>(p[1]), pixel_pair<1>(p[2]),
+		pixel_pair<1>(p[3]), pixel_pair<1>(p[4]), pixel_pair<1>(p[5]),
+		pixel_pair<1>(p[6]), pixel_pair<1>(p[7]), pixel_pair<1>(p[8]),
+		pixel_pair<1>(p[9]), pixel_pair<1>(p[10]), pixel_pair<1>(p[11]),
+		pixel_pair<1>(p[12]), pixel_pair<1>(p[13]), pixel_pair<1>(p[14]),
+		pixel_pair<1>(p[15]));
+	const __m256i B = _mm256_setr_epi16(
+		pixel_pair<1>(p[0] + s), pixel_pair<1>(p[1] + s),
+		pixel_pair<1>(p[2] + s), pixel_pair<1>(p[3] + s),
+		pixel_pair<1>(p[4] + s), pixel_pair<1>(p[5] + s),
+		pixel_pair<1>(p[6] + s), pixel_pair<1>(p[7] + s),
+		pixel_pair<1>(p[8] + s), pixel_pair<1>(p[9] + s),
+		pixel_pair<1>(p[10] + s), pixel_pair<1>(p[11] + s),
+		pixel_pair<1>(p[12] + s), pixel_pair<1>(p[13] + s),
+		pixel_pair<1>(p[14] + s), pixel_pair<1>(p[15] + s));
+	_mm_storeu_si128(
+		reinterpret_cast<__m128i*>(dst),
+		bilinear_avx2(T, B, wx0, wx1, wy0, wy1, invalid));
+}
+#endif
+
+template <unsigned int NCH>
+void remap_rows(
+	const TRemapLUT& lut, const uint8_t* src, const size_t src_stride,
+	uint8_t* dst, const size_t dst_stride, const unsigned int row0,
+	const unsigned int row1, const bool nearest)
+{
+	const unsigned int w = lut.width;
+	for (unsigned int row = row0; row < row1; row++)
+	{
+		const size_t idx0 = size_t(row) * w;
+		uint8_t* d = dst + row * dst_stride;
+		unsigned int i = 0;
+		if (!nearest)
+		{
+#if MRPT_HAS_AVX2
+			// (For color images, the de-interleaving of the 16 pixels costs
+			// more than what AVX2 saves: use SSE2)
+			if (NCH == 1)
+				for (; i + 16 <= w; i += 16)
+					remap16_avx2(lut, idx0 + i, src, src_stride, d + i);
+#endif
+#if MRPT_HAS_SSE2
+			for (; i + 8 <= w; i += 8)
+				remap8_sse2<NCH>(lut, idx0 + i, src, src_stride, d + i * NCH);
+#endif
+		}
+		for (; i < w; i++)
+		{
+			const size_t idx = idx0 + i;
+			uint8_t* out = d + i * NCH;
+			const int fx = lut.frac_x[idx], fy = lut.frac_y[idx];
+			if (fx == TRemapLUT::INVALID)
+			{
+				for (unsigned int c = 0; c < NCH; c++) out[c] = 0;
+				continue;
+			}
+			if (nearest)
+			{
+				const size_t x = lut.src_x[idx] + (2 * fx >= FRAC_ONE),
+							 y = lut.src_y[idx] + (2 * fy >= FRAC_ONE);
+				const uint8_t* p = src + y * src_stride + x * NCH;
+				for (unsigned int c = 0; c < NCH; c++) out[c] = p[c];
+			}
+			else
+			{
+				const uint8_t* p = src + lut.src_y[idx] * src_stride +
+								   lut.src_x[idx] * NCH;
+				for (unsigned int c = 0; c < NCH; c++)
+					out[c] = bilinear_pixel(p + c, src_stride, NCH, fx, fy);
+			}
+		}
+	}
+}
+}  // namespace
+
+void TRemapLUT::clear()
+{
+	width = height = src_width = src_height = 0;
+	src_x.clear();
+	src_y.clear();
+	frac_x.clear();
+	frac_y.clear();
+}
+
+void TRemapLUT::setFromCamera(
+	const mrpt::utils::TCamera& cam, const CMatrixDouble33& R,
+	const CMatrixDouble33& new_K, unsigned int out_width,
+	unsigned int out_height)
+{
+	MRPT_START
+	ASSERT_(cam.ncols >= 2 && cam.nrows >= 2)
+	ASSERT_(cam.ncols <= 0xFFFF && cam.nrows <= 0xFFFF)
+
+	width = out_width;
+	height = out_height;
+	src_width = cam.ncols;
+	src_height = cam.nrows;
+	const size_t N = size_t(width) * height;
+	src_x.resize(N);
+	src_y.resize(N);
+	frac_x.resize(N);
+	frac_y.resize(N);
+
+	// From output pixels to rays of the (unrotated) camera:
+	const CMatrixDouble33 iR = (new_K * R).inverse();
+	const double fx = cam.fx(), fy = cam.fy(), cx = cam.cx(), cy = cam.cy();
+	const double k1 = cam.k1(), k2 = cam.k2(), p1 = cam.p1(), p2 = cam.p2(),
+				 k3 = cam.k3();
+
+	for (unsigned int v = 0; v < height; v++)
+	{
+		// Ray for u=0 and its increment for each output column:
+		double X = iR(0, 1) * v + iR(0, 2), Y = iR(1, 1) * v + iR(1, 2),
+			   W = iR(2, 1) * v + iR(2, 2);
+		for (unsigned int u = 0; u < width;
+			 u++, X += iR(0, 0), Y += iR(1, 0), W += iR(2, 0))
+		{
+			const size_t i = size_t(v) * width + u;
+			const double w = 1.0 / W, x = X * w, y = Y * w;
+			const double x2 = x * x, y2 = y * y, r2 = x2 + y2, _2xy = 2 * x * y;
+			const double kr = 1 + ((k3 * r2 + k2) * r2 + k1) * r2;
+			const double su =
+				fx * (x * kr + p1 * _2xy + p2 * (r2 + 2 * x2)) + cx;
+			const double sv =
+				fy * (y * kr + p1 * (r2 + 2 * y2) + p2 * _2xy) + cy;
+			// (The negated test also catches NaNs)
+			if (!(W > 0 && su > -1 && sv > -1 && su < src_width &&
+				  sv < src_height))
+			{
+				set_lut_pixel(*this, i, -1, -1, 0, 0);
+				continue;
+			}
+			const int qx = static_cast<int>(std::floor(su * FRAC_ONE + 0.5)),
+					  qy = static_cast<int>(std::floor(sv * FRAC_ONE + 0.5));
+			if (qx < 0 || qy < 0)
+			{
+				set_lut_pixel(*this, i, -1, -1, 0, 0);
+				continue;
+			}
+			set_lut_pixel(
+				*this, i, qx >> FRAC_BITS, qy >> FRAC_BITS, qx & (FRAC_ONE - 1),
+				qy & (FRAC_ONE - 1));
+		}
+	}
+	MRPT_END
+}
+
+void TRemapLUT::setFromOpenCVMaps(
+	const std::vector<int16_t>& map_xy, const std::vector<uint16_t>& map_frac,
+	unsigned int out_width, unsigned int out_height, unsigned int _src_width,
+	unsigned int _src_height)
+{
+	MRPT_START
+	const size_t N = size_t(out_width) * out_height;
+	ASSERT_EQUAL_(map_xy.size(), 2 * N)
+	ASSERT_EQUAL_(map_frac.size(), N)
+	ASSERT_(_src_width >= 2 && _src_height >= 2)
+
+	width = out_width;
+	height = out_height;
+	src_width = _src_width;
+	src_height = _src_height;
+	src_x.resize(N);
+	src_y.resize(N);
+	frac_x.resize(N);
+	frac_y.resize(N);
+	for (size_t i = 0; i < N; i++)
+		set_lut_pixel(
+			*this, i, map_xy[2 * i], map_xy[2 * i + 1],
+			map_frac[i] & (FRAC_ONE - 1),
+			(map_frac[i] >> FRAC_BITS) & (FRAC_ONE - 1));
+	MRPT_END
+}
+
+void TRemapLUT::getAsOpenCVMaps(
+	std::vector<int16_t>& map_xy, std::vector<uint16_t>& map_frac) const
+{
+	const size_t N = frac_x.size();
+	map_xy.resize(2 * N);
+	map_frac.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		if (frac_x[i] == INVALID)
+		{
+			map_xy[2 * i] = map_xy[2 * i + 1] = -1;
+			map_frac[i] = 0;
+			continue;
+		}
+		// Undo the shift of the last column (row):
+		const int dx = frac_x[i] == FRAC_ONE, dy = frac_y[i] == FRAC_ONE;
+		map_xy[2 * i] = src_x[i] + dx;
+		map_xy[2 * i + 1] = src_y[i] + dy;
+		map_frac[i] = (dy ? 0 : frac_y[i]) * FRAC_ONE + (dx ? 0 : frac_x[i]);
+	}
+}
+
+void TRemapLUT::remapRows(
+	const uint8_t* src, const size_t src_stride, uint8_t* dst,
+	const size_t dst_stride, const unsigned int nChannels,
+	const unsigned int row0, const unsigned int row1, const bool nearest) const
+{
+	MRPT_START
+	ASSERT_(!empty())
+	ASSERT_(row0 <= row1 && row1 <= height)
+	switch (nChannels)
+	{
+		case 1:
+			remap_rows<1>(
+				*this, src, src_stride, dst, dst_stride, row0, row1, nearest);
+			break;
+		case 3:
+			remap_rows<3>(
+				*this, src, src_stride, dst, dst_stride, row0, row1, nearest);
+			break;
+		default:
+			THROW_EXCEPTION("Only images with 1 or 3 channels are supported")
+	};
+	MRPT_END
+}
+
+void TRemapLUT::remap(
+	const uint8_t* src, const size_t src_stride, uint8_t* dst,
+	const size_t dst_stride, const unsigned int nChannels, const bool nearest,
+	unsigned int num_threads) const
+{
+	const size_t num_jobs = (height + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+	mrpt::utils::parallel_for_jobs(num_jobs, num_threads, [&](const size_t j) {
+		const unsigned int row0 = j * ROWS_PER_JOB;
+		remapRows(
+			src, src_stride, dst, dst_stride, nChannels, row0,
+			std::min(height, row0 + ROWS_PER_JOB), nearest);
+	});
+}
@@ -0,0 +1,237 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/TRemapLUT.h>
+#include <mrpt/vision/CStereoRectifyMap.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/poses/CPose3DQuat.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+// Universal include for all versions of OpenCV
+#include <mrpt/otherlibs/do_opencv_includes.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+static TCamera createCamera(const double k1)
+{
+	TCamera cam;
+	cam.ncols = 160;
+	cam.nrows = 120;
+	cam.setIntrinsicParamsFromValues(130, 132, 81.5, 58.7);
+	cam.setDistortionParamsFromValues(k1, 0.05, 1e-3, -2e-3);
+	return cam;
+}
+
+TEST(TRemapLUT, IdentityWithoutDistortion)
+{
+	const TCamera cam = createCamera(0);
+	TCamera cam0 = cam;
+	cam0.dist.fill(0);
+	mrpt::math::CMatrixDouble33 R;
+	R.setIdentity();
+	TRemapLUT lut;
+	lut.setFromCamera(cam0, R, cam0.intrinsicParams, cam.ncols, cam.nrows);
+
+	randomGenerator.randomize(1);
+	vector<uint8_t> src(cam.ncols * cam.nrows), dst(src.size());
+	for (auto& v : src) v = randomGenerator.drawUniform32bit() % 256;
+	lut.remap(&src[0], cam.ncols, &dst[0], cam.ncols, 1);
+	EXPECT_TRUE(src == dst);
+}
+
+TEST(TRemapLUT, BilinearAndThreads)
+{
+	mrpt::math::CMatrixDouble33 R;
+	R.setIdentity();
+	// Barrel and pincushion distortion (with black pixels):
+	for (double k1 : {-0.3, 0.3})
+	{
+		const TCamera cam = createCamera(k1);
+		TRemapLUT lut;
+		lut.setFromCamera(cam, R, cam.intrinsicParams, cam.ncols, cam.nrows);
+		ASSERT_EQ(lut.frac_x.size(), size_t(cam.ncols * cam.nrows));
+
+		for (unsigned int nch : {1U, 3U})
+		{
+			const size_t stride = cam.ncols * nch + 5;
+			vector<uint8_t> src(stride * cam.nrows), dst(src.size(), 0),
+				dst_mt(src.size(), 0);
+			for (auto& v : src) v = randomGenerator.drawUniform32bit() % 256;
+			lut.remap(&src[0], stride, &dst[0], stride, nch, false, 1);
+			lut.remap(&src[0], stride, &dst_mt[0], stride, nch, false, 3);
+			EXPECT_TRUE(dst == dst_mt);
+
+			for (size_t i = 0; i < lut.frac_x.size(); i++)
+			{
+				const size_t x = i % cam.ncols, y = i / cam.ncols;
+				for (unsigned int c = 0; c < nch; c++)
+				{
+					const int out = dst[y * stride + x * nch + c];
+					if (lut.frac_x[i] == TRemapLUT::INVALID)
+					{
+						EXPECT_EQ(out, 0);
+						continue;
+					}
+					const double one = TRemapLUT::FRAC_ONE;
+					const double fx = lut.frac_x[i] / one,
+								 fy = lut.frac_y[i] / one;
+					const uint8_t* p =
+						&src[lut.src_y[i] * stride + lut.src_x[i] * nch + c];
+					const double ref =
+						(p[0] * (1 - fx) + p[nch] * fx) * (1 - fy) +
+						(p[stride] * (1 - fx) + p[stride + nch] * fx) * fy;
+					EXPECT_NEAR(out, ref, 0.5 + 1e-9);
+				}
+			}
+		}
+	}
+}
+
+TEST(TRemapLUT, OpenCVMapsRoundTrip)
+{
+	const TCamera cam = createCamera(0.3);
+	mrpt::math::CMatrixDouble33 R;
+	R.setIdentity();
+	TRemapLUT lut, lut2;
+	lut.setFromCamera(cam, R, cam.intrinsicParams, cam.ncols, cam.nrows);
+
+	vector<int16_t> map_xy;
+	vector<uint16_t> map_frac;
+	lut.getAsOpenCVMaps(map_xy, map_frac);
+	lut2.setFromOpenCVMaps(
+		map_xy, map_frac, cam.ncols, cam.nrows, cam.ncols, cam.nrows);
+	EXPECT_TRUE(lut.src_x == lut2.src_x);
+	EXPECT_TRUE(lut.src_y == lut2.src_y);
+	EXPECT_TRUE(lut.frac_x == lut2.frac_x);
+	EXPECT_TRUE(lut.frac_y == lut2.frac_y);
+}
+
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM >= 0x200
+// The table must be the same than OpenCV's fixed-point maps, up to rounding
+TEST(TRemapLUT, SameAsOpenCVInitUndistortRectifyMap)
+{
+	const mrpt::math::CMatrixDouble33 R =
+		mrpt::poses::CPose3D(0, 0, 0, DEG2RAD(2), DEG2RAD(-1), DEG2RAD(1.5))
+			.getRotationMatrix();
+	const unsigned int out_w = 150, out_h = 110;
+	const size_t N = out_w * out_h;
+	for (double k1 : {-0.3, 0.3})
+	{
+		const TCamera cam = createCamera(k1);
+		mrpt::math::CMatrixDouble33 new_K = cam.intrinsicParams;
+		new_K(0, 0) *= 0.9;
+		new_K(1, 1) *= 0.9;
+		new_K(0, 2) -= 4;
+		TRemapLUT lut;
+		lut.setFromCamera(cam, R, new_K, out_w, out_h);
+
+		cv::Mat cv_K(3, 3, CV_64F), cv_new_K(3, 3, CV_64F), cv_R(3, 3, CV_64F),
+			cv_dist(1, 5, CV_64F);
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+			{
+				cv_K.at<double>(r, c) = cam.intrinsicParams(r, c);
+				cv_new_K.at<double>(r, c) = new_K(r, c);
+				cv_R.at<double>(r, c) = R(r, c);
+			}
+		for (int i = 0; i < 5; i++) cv_dist.at<double>(0, i) = cam.dist[i];
+		cv::Mat map1, map2;
+		cv::initUndistortRectifyMap(
+			cv_K, cv_dist, cv_R, cv_new_K, cv::Size(out_w, out_h), CV_16SC2,
+			map1, map2);
+		ASSERT_TRUE(map1.isContinuous() && map2.isContinuous());
+		const int16_t* xy = map1.ptr<int16_t>();
+		const uint16_t* frac = map2.ptr<uint16_t>();
+		TRemapLUT lut_cv;
+		lut_cv.setFromOpenCVMaps(
+			vector<int16_t>(xy, xy + 2 * N), vector<uint16_t>(frac, frac + N),
+			out_w, out_h, cam.ncols, cam.nrows);
+
+		// Source coordinates in 1/FRAC_ONE pixels:
+		auto qx = [](const TRemapLUT& l, size_t i) {
+			return int(l.src_x[i]) * TRemapLUT::FRAC_ONE + l.frac_x[i];
+		};
+		auto qy = [](const TRemapLUT& l, size_t i) {
+			return int(l.src_y[i]) * TRemapLUT::FRAC_ONE + l.frac_y[i];
+		};
+		size_t nValid = 0, nDiffValid = 0;
+		for (size_t i = 0; i < N; i++)
+		{
+			const bool valid = lut.frac_x[i] != TRemapLUT::INVALID,
+					   valid_cv = lut_cv.frac_x[i] != TRemapLUT::INVALID;
+			if (valid != valid_cv) nDiffValid++;
+			if (!valid || !valid_cv) continue;
+			nValid++;
+			EXPECT_NEAR(qx(lut, i), qx(lut_cv, i), 1) << "pixel: " << i;
+			EXPECT_NEAR(qy(lut, i), qy(lut_cv, i), 1) << "pixel: " << i;
+		}
+		EXPECT_GT(nValid, N / 2);
+		// Only pixels at the border of the source image may differ:
+		EXPECT_LT(nDiffValid, N / 100);
+	}
+}
+
+// 16 bit images are rectified with OpenCV, like the 8 bit ones with the LUTs
+TEST(CStereoRectifyMap, Rectify16BitImages)
+{
+	TStereoCamera params;
+	params.leftCamera = createCamera(0.1);
+	params.rightCamera = createCamera(-0.1);
+	params.rightCameraPose = mrpt::poses::CPose3DQuat(
+		mrpt::poses::CPose3D(0.1, 0.002, 0, DEG2RAD(1), 0, 0));
+	CStereoRectifyMap rmap;
+	rmap.setFromCamParams(params);
+	const TStereoCamera& rect = rmap.getRectifiedImageParams();
+	const CvSize in_size =
+		cvSize(params.leftCamera.ncols, params.leftCamera.nrows);
+	const CvSize out_size =
+		cvSize(rect.leftCamera.ncols, rect.leftCamera.nrows);
+
+	// The same random images, in 8 and 16 bit:
+	randomGenerator.randomize(1);
+	IplImage *in8[2], *in16[2], *out8[2], *out16[2];
+	for (int k = 0; k < 2; k++)
+	{
+		in8[k] = cvCreateImage(in_size, IPL_DEPTH_8U, 1);
+		in16[k] = cvCreateImage(in_size, IPL_DEPTH_16U, 1);
+		out8[k] = cvCreateImage(out_size, IPL_DEPTH_8U, 1);
+		out16[k] = cvCreateImage(out_size, IPL_DEPTH_16U, 1);
+		for (int y = 0; y < in_size.height; y++)
+			for (int x = 0; x < in_size.width; x++)
+			{
+				const unsigned int v = randomGenerator.drawUniform32bit() % 256;
+				CV_IMAGE_ELEM(in8[k], uint8_t, y, x) = v;
+				CV_IMAGE_ELEM(in16[k], uint16_t, y, x) = v * 256;
+			}
+	}
+	rmap.rectify_IPL(in8[0], in8[1], out8[0], out8[1]);
+	EXPECT_NO_THROW(rmap.rectify_IPL(in16[0], in16[1], out16[0], out16[1]));
+
+	// Both are bilinear interpolations of the same pixels (up to rounding):
+	for (int k = 0; k < 2; k++)
+	{
+		for (int y = 0; y < out_size.height; y++)
+			for (int x = 0; x < out_size.width; x++)
+				EXPECT_NEAR(
+					CV_IMAGE_ELEM(out16[k], uint16_t, y, x) / 256.0,
+					CV_IMAGE_ELEM(out8[k], uint8_t, y, x), 1.0)
+					<< "image: " << k << " x: " << x << " y: " << y;
+		cvReleaseImage(&in8[k]);
+		cvReleaseImage(&in16[k]);
+		cvReleaseImage(&out8[k]);
+		cvReleaseImage(&out16[k]);
+	}
+}
+#endif
@@ -0,0 +1,639 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/bundle_adjustment.h>
+#include <mrpt/vision/pinhole.h>
+#include <mrpt/utils/CTimeLogger.h>
+#include <mrpt/math/CSparseBlockCholesky.h>
+#include <mrpt/math/robust_kernels.h>
+#include <mrpt/math/ops_containers.h>
+#include <mrpt/utils/parallel.h>
+
+#include "ba_internals.h"
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::math;
+
+using mrpt::aligned_containers;
+
+namespace
+{
+/** Minimum number of items (observations, points or cameras) per thread */
+const size_t MIN_ITEMS_PER_THREAD = 16;
+
+typedef CMatrixFixedNumeric<double, 6, 6> Matrix_FxF;
+typedef CMatrixFixedNumeric<double, 3, 3> Matrix_PxP;
+typedef CMatrixFixedNumeric<double, 6, 3> Matrix_FxP;
+typedef CArrayDouble<6> Array_F;
+typedef CArrayDouble<3> Array_P;
+
+/** A list of indices grouped by some key (cameras or points), in compressed
+ * form: the items of key k are items[ptr[k]:ptr[k+1]) */
+struct TIndexLists
+{
+	std::vector<size_t> ptr, items;
+
+	/** Builds the lists from the key of each item (items with key<0 are not
+	 * stored). Items keep their relative order in each list. */
+	void build(const std::vector<int>& keys, const size_t num_keys)
+	{
+		ptr.assign(num_keys + 1, 0);
+		for (int k : keys)
+			if (k >= 0) ptr[k + 1]++;
+		for (size_t k = 0; k < num_keys; k++) ptr[k + 1] += ptr[k];
+		items.resize(ptr[num_keys]);
+		std::vector<size_t> next(ptr.begin(), ptr.end() - 1);
+		for (size_t i = 0; i < keys.size(); i++)
+			if (keys[i] >= 0) items[next[keys[i]]++] = i;
+	}
+	inline size_t size(const size_t k) const { return ptr[k + 1] - ptr[k]; }
+};
+
+/** The normal equations reduced to the free camera poses (Schur complement
+ * of the points): the matrix S, with dense 6x6 blocks in the pattern of
+ * the pairs of cameras which observe a common point, and the vector e. */
+struct TReducedCameraSystem
+{
+	size_t num_cams;
+	/** Coordinates (row>col) of the off-diagonal blocks, without repetitions
+	 */
+	std::vector<std::pair<size_t, size_t>> lower;
+	/** The num_cams diagonal blocks, then one block for each entry in lower
+	 */
+	aligned_containers<Matrix_FxF>::vector_t blocks;
+	/** The right-hand side vector */
+	CVectorDouble e;
+
+	/** y = S*x */
+	void multiply(const CVectorDouble& x, CVectorDouble& y) const
+	{
+		y.setZero(x.size());
+		for (size_t i = 0; i < num_cams; i++)
+			y.segment<6>(6 * i).noalias() += blocks[i] * x.segment<6>(6 * i);
+		for (size_t k = 0; k < lower.size(); k++)
+		{
+			const size_t r = lower[k].first, c = lower[k].second;
+			const Matrix_FxF& B = blocks[num_cams + k];
+			y.segment<6>(6 * r).noalias() += B * x.segment<6>(6 * c);
+			y.segment<6>(6 * c).noalias() +=
+				B.transpose() * x.segment<6>(6 * r);
+		}
+	}
+};
+
+/** Solves S*x=e with the conjugate gradient method, preconditioned with the
+ * inverse of the diagonal blocks of S. Returns the number of iterations.
+ * \exception CExceptionNotDefPos If a diagonal block is not positive
+ * definite */
+size_t solvePCG(
+	const TReducedCameraSystem& sys, const size_t max_iters,
+	const double tolerance, CVectorDouble& x)
+{
+	const size_t n = sys.num_cams;
+	aligned_containers<Matrix_FxF>::vector_t precond(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		const Eigen::LLT<Eigen::Matrix<double, 6, 6>> llt(sys.blocks[i]);
+		if (llt.info() != Eigen::Success)
+			throw CExceptionNotDefPos("solvePCG: Not positive definite");
+		precond[i] = llt.solve(Eigen::Matrix<double, 6, 6>::Identity());
+	}
+	auto apply_precond = [&](const CVectorDouble& r, CVectorDouble& z) {
+		z.resize(r.size());
+		for (size_t i = 0; i < n; i++)
+			z.segment<6>(6 * i).noalias() = precond[i] * r.segment<6>(6 * i);
+	};
+
+	x.setZero(6 * n);
+	CVectorDouble r = sys.e, z, p, q;
+	apply_precond(r, z);
+	p = z;
+	double rz = r.dot(z);
+	const double stop_norm = tolerance * sys.e.norm();
+	size_t it = 0;
+	for (; it < max_iters && r.norm() > stop_norm; it++)
+	{
+		sys.multiply(p, q);
+		const double pq = p.dot(q);
+		if (pq <= 0)
+			throw CExceptionNotDefPos("solvePCG: Not positive definite");
+		const double alpha = rz / pq;
+		x.noalias() += alpha * p;
+		r.noalias() -= alpha * q;
+		apply_precond(r, z);
+		const double rz_new = r.dot(z);
+		p = z + (rz_new / rz) * p;
+		rz = rz_new;
+	}
+	return it;
+}
+}  // namespace
+
+/* ----------------------------------------------------------
+					bundle_adj_sparse
+
+	See bundle_adjustment.h for docs.
+   ---------------------------------------------------------- */
+double mrpt::vision::bundle_adj_sparse(
+	const TSequenceFeatureObservations& observations,
+	const TCamera& camera_params, TFramePosesVec& frame_poses,
+	TLandmarkLocationsVec& landmark_points,
+	const mrpt::utils::TParametersDouble& extra_params,
+	const TBundleAdjustmentFeedbackFunctor user_feedback)
+{
+	MRPT_START
+
+	// Extra params:
+	const TRobustKernelType kernel_type = static_cast<TRobustKernelType>(
+		static_cast<int>(extra_params.getWithDefaultVal("robust_kernel", 1)));
+	const bool verbose = 0 != extra_params.getWithDefaultVal("verbose", 0);
+	const double initial_mu = extra_params.getWithDefaultVal("mu", -1);
+	const size_t max_iters =
+		extra_params.getWithDefaultVal("max_iterations", 50);
+	const size_t num_fix_frames =
+		extra_params.getWithDefaultVal("num_fix_frames", 1);
+	const size_t num_fix_points =
+		extra_params.getWithDefaultVal("num_fix_points", 0);
+	const double kernel_param =
+		extra_params.getWithDefaultVal("kernel_param", 3.0);
+	const bool use_pcg = 0 != extra_params.getWithDefaultVal("solver", 0);
+	const size_t pcg_max_iters =
+		extra_params.getWithDefaultVal("pcg_max_iterations", 200);
+	const double pcg_tolerance =
+		extra_params.getWithDefaultVal("pcg_tolerance", 1e-8);
+	const size_t num_threads = extra_params.getWithDefaultVal("num_threads", 0);
+
+	const bool enable_profiler =
+		0 != extra_params.getWithDefaultVal("profiler", 0);
+
+	mrpt::utils::CTimeLogger profiler(enable_profiler);
+
+	profiler.enter("bundle_adj_sparse (complete run)");
+
+	// Input data sizes:
+	const size_t num_points = landmark_points.size();
+	const size_t num_frames = frame_poses.size();
+	const size_t num_obs = observations.size();
+
+	ASSERT_ABOVE_(num_frames, 0)
+	ASSERT_ABOVE_(num_points, 0)
+	ASSERT_(num_fix_frames >= 1)
+	ASSERT_ABOVEEQ_(num_frames, num_fix_frames);
+	ASSERT_ABOVEEQ_(num_points, num_fix_points);
+	ASSERT_(kernel_type == rkLeastSquares || kernel_type == rkPseudoHuber)
+
+	const size_t num_free_frames = num_frames - num_fix_frames;
+	const size_t num_free_points = num_points - num_fix_points;
+	const size_t len_free_frames = 6 * num_free_frames;
+	const size_t len_free_points = 3 * num_free_points;
+
+	// Structure of the problem, which does not change between iterations:
+	// the free camera and point of each observation (-1 if fixed), the
+	// observations of each free camera and point, and the position of each
+	// observation in the list of its point.
+	profiler.enter("build_structure");
+	std::vector<int> obs_cam(num_obs), obs_pt(num_obs);
+	for (size_t i = 0; i < num_obs; i++)
+	{
+		const TCameraPoseID f = observations[i].id_frame;
+		const TLandmarkID p = observations[i].id_feature;
+		ASSERT_BELOW_(f, num_frames)
+		ASSERT_BELOW_(p, num_points)
+		obs_cam[i] = f >= num_fix_frames ? int(f - num_fix_frames) : -1;
+		obs_pt[i] = p >= num_fix_points ? int(p - num_fix_points) : -1;
+	}
+	TIndexLists cam_obs, pt_obs;
+	cam_obs.build(obs_cam, num_free_frames);
+	pt_obs.build(obs_pt, num_free_points);
+	std::vector<size_t> obs_pos_in_pt(num_obs, 0);
+	for (size_t p = 0; p < num_free_points; p++)
+		for (size_t a = pt_obs.ptr[p]; a < pt_obs.ptr[p + 1]; a++)
+			obs_pos_in_pt[pt_obs.items[a]] = a - pt_obs.ptr[p];
+
+	// Blocks of the reduced system: for each pair of observations (a,b) of a
+	// point, with cam(a)>cam(b), the index of the block (cam(a),cam(b)).
+	TReducedCameraSystem sys;
+	sys.num_cams = num_free_frames;
+	std::vector<size_t> pair_ptr(num_free_points + 1, 0);
+	for (size_t p = 0; p < num_free_points; p++)
+		pair_ptr[p + 1] = pair_ptr[p] + pt_obs.size(p) * pt_obs.size(p);
+	std::vector<size_t> pair_block(pair_ptr[num_free_points], 0);
+	{
+		std::vector<std::pair<size_t, size_t>> all_pairs;
+		for (size_t p = 0; p < num_free_points; p++)
+		{
+			const size_t* obs = &pt_obs.items[pt_obs.ptr[p]];
+			for (size_t a = 0; a < pt_obs.size(p); a++)
+				for (size_t b = 0; b < pt_obs.size(p); b++)
+					if (obs_cam[obs[a]] > obs_cam[obs[b]] &&
+						obs_cam[obs[b]] >= 0)
+						all_pairs.push_back(
+							std::make_pair(obs_cam[obs[a]], obs_cam[obs[b]]));
+		}
+		sys.lower = all_pairs;
+		std::sort(sys.lower.begin(), sys.lower.end());
+		sys.lower.erase(
+			std::unique(sys.lower.begin(), sys.lower.end()), sys.lower.end());
+
+		for (size_t p = 0; p < num_free_points; p++)
+		{
+			const size_t m = pt_obs.size(p);
+			const size_t* obs = &pt_obs.items[pt_obs.ptr[p]];
+			for (size_t a = 0; a < m; a++)
+				for (size_t b = 0; b < m; b++)
+					if (obs_cam[obs[a]] > obs_cam[obs[b]] &&
+						obs_cam[obs[b]] >= 0)
+						pair_block[pair_ptr[p] + a * m + b] =
+							num_free_frames +
+							(std::lower_bound(
+								 sys.lower.begin(), sys.lower.end(),
+								 std::pair<size_t, size_t>(
+									 obs_cam[obs[a]], obs_cam[obs[b]])) -
+							 sys.lower.begin());
+		}
+	}
+	sys.blocks.resize(num_free_frames + sys.lower.size());
+
+	CSparseBlockCholesky<6> chol;
+	std::vector<size_t> chol_idxs;  // Index in chol of each block in lower
+	if (!use_pcg && num_free_frames > 0)
+		chol.setPattern(num_free_frames, sys.lower, chol_idxs);
+	profiler.leave("build_structure");
+
+	VERBOSE_COUT << "Reduced camera system: " << num_free_frames
+				 << " cameras, " << sys.lower.size()
+				 << " off-diagonal blocks\n";
+
+	// *Warning*: As bundle_adj_full(), this implementation works with inverse
+	// camera poses: inverse them at the entrance and at exit:
+	for (size_t i = 0; i < num_frames; i++) frame_poses[i].inverse();
+
+	// Residuals, robust kernel weights and total cost of a solution:
+	auto evaluate = [&](const TFramePosesVec& frames,
+						const TLandmarkLocationsVec& points,
+						std::vector<CArray<double, 2>>& residuals,
+						std::vector<double>& weights) -> double {
+		residuals.resize(num_obs);
+		weights.resize(num_obs);
+		std::vector<double> costs(num_obs);
+		mrpt::utils::parallel_for_ranges(
+			num_obs, num_threads,
+			[&](size_t, size_t first, size_t last) {
+				RobustKernel<rkLeastSquares> kernel_ls;
+				RobustKernel<rkPseudoHuber> kernel_ph;
+				kernel_ph.param_sq = square(kernel_param);
+				for (size_t i = first; i < last; i++)
+				{
+					const TFeatureObservation& OBS = observations[i];
+					const TPixelCoordf z_pred =
+						pinhole::projectPoint_no_distortion<true>(
+							camera_params, frames[OBS.id_frame],
+							points[OBS.id_feature]);
+					residuals[i][0] = OBS.px.x - z_pred.x;
+					residuals[i][1] = OBS.px.y - z_pred.y;
+					const double r2 =
+						square(residuals[i][0]) + square(residuals[i][1]);
+					double d2;
+					costs[i] = kernel_type == rkPseudoHuber
+								   ? kernel_ph.eval(r2, weights[i], d2)
+								   : kernel_ls.eval(r2, weights[i], d2);
+				}
+			},
+			MIN_ITEMS_PER_THREAD);
+		// Sum in a fixed order, so the result does not depend on the threads:
+		double sum = 0;
+		for (double c : costs) sum += c;
+		return sum;
+	};
+
+	std::vector<CArray<double, 2>> residuals;
+	std::vector<double> weights;
+	profiler.enter("evaluate");
+	double res = evaluate(frame_poses, landmark_points, residuals, weights);
+	profiler.leave("evaluate");
+	MRPT_CHECK_NORMAL_NUMBER(res)
+	VERBOSE_COUT << "res: " << res << endl;
+
+	// Linear system at the current solution. Gradients (g_*) and Hessian
+	// blocks (U: cameras, V: points, W: camera-point) are weighted with the
+	// robust kernel (IRLS).
+	aligned_containers<JacData<6, 3, 2>>::vector_t jacobians(num_obs);
+	aligned_containers<Matrix_FxF>::vector_t U(num_free_frames);
+	aligned_containers<Array_F>::vector_t g_frame(num_free_frames);
+	aligned_containers<Matrix_PxP>::vector_t V(num_free_points);
+	aligned_containers<Array_P>::vector_t g_point(num_free_points);
+	aligned_containers<Matrix_FxP>::vector_t W(num_obs), Y(num_obs);
+	aligned_containers<Matrix_PxP>::vector_t V_inv(num_free_points);
+
+	auto linearize = [&]() {
+		mrpt::utils::parallel_for_ranges(
+			num_obs, num_threads,
+			[&](size_t, size_t first, size_t last) {
+				for (size_t i = first; i < last; i++)
+				{
+					const TFeatureObservation& OBS = observations[i];
+					JacData<6, 3, 2>& D = jacobians[i];
+					D.J_frame_valid = obs_cam[i] >= 0;
+					D.J_point_valid = obs_pt[i] >= 0;
+					if (D.J_frame_valid)
+						frameJac<true>(
+							camera_params, frame_poses[OBS.id_frame],
+							landmark_points[OBS.id_feature], D.J_frame);
+					if (D.J_point_valid)
+						pointJac<true>(
+							camera_params, frame_poses[OBS.id_frame],
+							landmark_points[OBS.id_feature], D.J_point);
+					if (D.J_frame_valid && D.J_point_valid)
+						W[i].noalias() =
+							weights[i] * D.J_frame.transpose() * D.J_point;
+				}
+			},
+			MIN_ITEMS_PER_THREAD);
+		mrpt::utils::parallel_for_ranges(
+			num_free_frames, num_threads,
+			[&](size_t, size_t first, size_t last) {
+				for (size_t j = first; j < last; j++)
+				{
+					U[j].setZero();
+					g_frame[j].setZero();
+					for (size_t k = cam_obs.ptr[j]; k < cam_obs.ptr[j + 1]; k++)
+					{
+						const size_t i = cam_obs.items[k];
+						const auto& J = jacobians[i].J_frame;
+						const Eigen::Matrix<double, 2, 1> r(&residuals[i][0]);
+						U[j].noalias() += weights[i] * J.transpose() * J;
+						g_frame[j].noalias() += weights[i] * J.transpose() * r;
+					}
+				}
+			},
+			MIN_ITEMS_PER_THREAD);
+		mrpt::utils::parallel_for_ranges(
+			num_free_points, num_threads,
+			[&](size_t, size_t first, size_t last) {
+				for (size_t p = first; p < last; p++)
+				{
+					V[p].setZero();
+					g_point[p].setZero();
+					for (size_t k = pt_obs.ptr[p]; k < pt_obs.ptr[p + 1]; k++)
+					{
+						const size_t i = pt_obs.items[k];
+						const auto& J = jacobians[i].J_point;
+						const Eigen::Matrix<double, 2, 1> r(&residuals[i][0]);
+						V[p].noalias() += weights[i] * J.transpose() * J;
+						g_point[p].noalias() += weights[i] * J.transpose() * r;
+					}
+				}
+			},
+			MIN_ITEMS_PER_THREAD);
+	};
+
+	profiler.enter("linearize");
+	linearize();
+	profiler.leave("linearize");
+
+	double nu = 2;
+	const double eps = 1e-16;
+	bool stop = false;
+	double mu = initial_mu;
+
+	// Automatic guess of "mu":
+	if (mu < 0)
+	{
+		double norm_max_A = 0;
+		for (size_t j = 0; j < num_free_frames; ++j)
+			for (size_t dim = 0; dim < 6; dim++)
+				keep_max(norm_max_A, U[j](dim, dim));
+		for (size_t i = 0; i < num_free_points; ++i)
+			for (size_t dim = 0; dim < 3; dim++)
+				keep_max(norm_max_A, V[i](dim, dim));
+		const double tau = 1e-3;
+		mu = tau * norm_max_A;
+	}
+
+	CVectorDouble delta(len_free_frames + len_free_points);
+	CVectorDouble delta_frames;
+
+	for (size_t iter = 0; iter < max_iters; iter++)
+	{
+		VERBOSE_COUT << "iteration: " << iter << endl;
+
+		// provide feedback to the user:
+		if (user_feedback)
+			(*user_feedback)(
+				iter, res, max_iters, observations, frame_poses,
+				landmark_points);
+
+		bool has_improved = false;
+		do
+		{
+			profiler.enter("COMPLETE_ITER");
+			VERBOSE_COUT << "mu: " << mu << endl;
+
+			// Schur complement of the points: Y = W * (V+mu*I)^-1
+			profiler.enter("Schur.points");
+			mrpt::utils::parallel_for_ranges(
+				num_free_points, num_threads,
+				[&](size_t, size_t first, size_t last) {
+					for (size_t p = first; p < last; p++)
+					{
+						Matrix_PxP Vmu = V[p];
+						Vmu.diagonal().array() += mu;
+						Vmu.inv_fast(V_inv[p]);
+						for (size_t k = pt_obs.ptr[p]; k < pt_obs.ptr[p + 1];
+							 k++)
+						{
+							const size_t i = pt_obs.items[k];
+							if (obs_cam[i] >= 0)
+								Y[i].noalias() = W[i] * V_inv[p];
+						}
+					}
+				},
+				MIN_ITEMS_PER_THREAD);
+			profiler.leave("Schur.points");
+
+			// S = U + mu*I - sum(Y*W^t), e = g_frame - sum(Y*g_point)
+			// Each thread fills the rows of S of its cameras, so no block is
+			// written by two threads.
+			profiler.enter("Schur.build.reduced.frames");
+			sys.e.resize(len_free_frames);
+			for (auto& B : sys.blocks) B.setZero();
+			mrpt::utils::parallel_for_ranges(
+				num_free_frames, num_threads,
+				[&](size_t, size_t first, size_t last) {
+					for (size_t j = first; j < last; j++)
+					{
+						Matrix_FxF& Sjj = sys.blocks[j];
+						Sjj = U[j];
+						Sjj.diagonal().array() += mu;
+						Array_F e_j = g_frame[j];
+						for (size_t k = cam_obs.ptr[j]; k < cam_obs.ptr[j + 1];
+							 k++)
+						{
+							const size_t a = cam_obs.items[k];
+							const int p = obs_pt[a];
+							if (p < 0) continue;
+							e_j.noalias() -= Y[a] * g_point[p];
+							const size_t m = pt_obs.size(p);
+							const size_t* obs = &pt_obs.items[pt_obs.ptr[p]];
+							for (size_t b = 0; b < m; b++)
+							{
+								const int cam_b = obs_cam[obs[b]];
+								if (cam_b < 0 || cam_b > int(j)) continue;
+								Matrix_FxF& dst =
+									cam_b == int(j)
+										? Sjj
+										: sys.blocks
+											  [pair_block
+												   [pair_ptr[p] +
+													obs_pos_in_pt[a] * m + b]];
+								dst.noalias() -= Y[a] * W[obs[b]].transpose();
+							}
+						}
+						sys.e.segment<6>(6 * j) = e_j;
+					}
+				},
+				MIN_ITEMS_PER_THREAD);
+			profiler.leave("Schur.build.reduced.frames");
+
+			try
+			{
+				profiler.enter("Schur.solve");
+				if (num_free_frames == 0)
+					delta_frames.resize(0);
+				else if (use_pcg)
+				{
+					const size_t n = solvePCG(
+						sys, pcg_max_iters, pcg_tolerance, delta_frames);
+					VERBOSE_COUT << "PCG iterations: " << n << endl;
+				}
+				else
+				{
+					for (size_t j = 0; j < num_free_frames; j++)
+						chol.entry(j) = sys.blocks[j];
+					for (size_t k = 0; k < sys.lower.size(); k++)
+						chol.entry(chol_idxs[k]) =
+							sys.blocks[num_free_frames + k];
+					chol.factorize();
+					chol.solve(sys.e, delta_frames);
+				}
+				profiler.leave("Schur.solve");
+			}
+			catch (CExceptionNotDefPos&)
+			{
+				profiler.leave("Schur.solve");
+				profiler.leave("COMPLETE_ITER");
+				// not positive definite so increase mu and try again
+				mu *= nu;
+				nu *= 2.;
+				stop = (mu > 999999999.f);
+				continue;
+			}
+
+			// Back-substitution of the points:
+			// dp = V_inv * (g_point - sum(W^t * d_frame))
+			profiler.enter("PostSchur.landmarks");
+			if (len_free_frames)
+				delta.head(len_free_frames) = delta_frames;
+			mrpt::utils::parallel_for_ranges(
+				num_free_points, num_threads,
+				[&](size_t, size_t first, size_t last) {
+					for (size_t p = first; p < last; p++)
+					{
+						Array_P tmp = g_point[p];
+						for (size_t k = pt_obs.ptr[p]; k < pt_obs.ptr[p + 1];
+							 k++)
+						{
+							const size_t i = pt_obs.items[k];
+							if (obs_cam[i] >= 0)
+								tmp.noalias() -=
+									W[i].transpose() *
+									delta_frames.segment<6>(6 * obs_cam[i]);
+						}
+						delta.segment<3>(len_free_frames + 3 * p).noalias() =
+							V_inv[p] * tmp;
+					}
+				},
+				MIN_ITEMS_PER_THREAD);
+			profiler.leave("PostSchur.landmarks");
+
+			// Vars for temptative new estimates:
+			TFramePosesVec new_frame_poses;
+			TLandmarkLocationsVec new_landmark_points;
+			add_se3_deltas_to_frames(
+				frame_poses, delta, 0, len_free_frames, new_frame_poses,
+				num_fix_frames);
+			add_3d_deltas_to_points(
+				landmark_points, delta, len_free_frames, len_free_points,
+				new_landmark_points, num_fix_points);
+
+			std::vector<CArray<double, 2>> new_residuals;
+			std::vector<double> new_weights;
+			profiler.enter("evaluate");
+			const double res_new = evaluate(
+				new_frame_poses, new_landmark_points, new_residuals,
+				new_weights);
+			profiler.leave("evaluate");
+			MRPT_CHECK_NORMAL_NUMBER(res_new)
+
+			has_improved = (res_new < res);
+
+			if (has_improved)
+			{
+				VERBOSE_COUT << "new total sqr.err=" << res_new
+							 << " avr.err(px):" << std::sqrt(res / num_obs)
+							 << "->" << std::sqrt(res_new / num_obs) << endl;
+
+				frame_poses.swap(new_frame_poses);
+				landmark_points.swap(new_landmark_points);
+				residuals.swap(new_residuals);
+				weights.swap(new_weights);
+				res = res_new;
+
+				double g_max = 0;
+				for (const auto& g : g_frame)
+					keep_max(g_max, g.array().abs().maxCoeff());
+				for (const auto& g : g_point)
+					keep_max(g_max, g.array().abs().maxCoeff());
+
+				profiler.enter("linearize");
+				linearize();
+				profiler.leave("linearize");
+
+				stop = g_max <= eps;
+				mu *= 0.1;
+				mu = std::max(mu, 1e-100);
+				nu = 2.0;
+			}
+			else
+			{
+				VERBOSE_COUT << "no update: res vs.res_new " << res << " vs. "
+							 << res_new << endl;
+				mu *= nu;
+				nu *= 2.0;
+				stop = (mu > 1e9);
+			}
+
+			profiler.leave("COMPLETE_ITER");
+		} while (!has_improved && !stop);
+
+		if (stop) break;
+	}  // end for each "iter"
+
+	for (size_t i = 0; i < num_frames; i++) frame_poses[i].inverse();
+
+	profiler.leave("bundle_adj_sparse (complete run)");
+
+	return res;
+	MRPT_END
+}
@@ -0,0 +1,142 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/bundle_adjustment.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+// A camera moving sideways in front of random points, with noisy pixel
+// observations, and a perturbed initial estimate of poses and points.
+struct TSyntheticBA
+{
+	TCamera cam;
+	TSequenceFeatureObservations obs;
+	TFramePosesVec frames;
+	TLandmarkLocationsVec points;
+
+	TSyntheticBA(const int nFrames, const int nPoints)
+	{
+		randomGenerator.randomize(123);
+		cam.ncols = 640;
+		cam.nrows = 480;
+		cam.setIntrinsicParamsFromValues(500, 500, 320, 240);
+
+		TFramePosesVec gt_frames(nFrames);
+		TLandmarkLocationsVec gt_points(nPoints);
+		for (int i = 0; i < nFrames; i++)
+			gt_frames[i] = CPose3D(0.2 * i, 0.05 * sin(i), 0, 0.01 * i, 0, 0);
+		for (int i = 0; i < nPoints; i++)
+			gt_points[i] = TPoint3D(
+				randomGenerator.drawUniform(-2, 0.2 * nFrames + 2),
+				randomGenerator.drawUniform(-2, 2),
+				randomGenerator.drawUniform(5, 10));
+
+		for (int f = 0; f < nFrames; f++)
+			for (int p = 0; p < nPoints; p++)
+			{
+				double x, y, z;
+				gt_frames[f].inverseComposePoint(
+					gt_points[p].x, gt_points[p].y, gt_points[p].z, x, y, z);
+				const double u = 320 + 500 * x / z, v = 240 + 500 * y / z;
+				if (z < 0.5 || u < 0 || v < 0 || u >= 640 || v >= 480)
+					continue;
+				obs.push_back(TFeatureObservation(
+					p, f, TPixelCoordf(
+							  u + randomGenerator.drawGaussian1D(0, 0.5),
+							  v + randomGenerator.drawGaussian1D(0, 0.5))));
+			}
+
+		frames = gt_frames;
+		points = gt_points;
+		for (int i = 1; i < nFrames; i++)
+			frames[i] = CPose3D(
+				frames[i].x() + randomGenerator.drawGaussian1D(0, 0.03),
+				frames[i].y() + randomGenerator.drawGaussian1D(0, 0.03),
+				frames[i].z(), frames[i].yaw() + 0.01, frames[i].pitch(),
+				frames[i].roll());
+		for (int i = 0; i < nPoints; i++)
+		{
+			points[i].x += randomGenerator.drawGaussian1D(0, 0.1);
+			points[i].z += randomGenerator.drawGaussian1D(0, 0.1);
+		}
+	}
+};
+
+static void expectSamePoses(
+	const TFramePosesVec& f1, const TFramePosesVec& f2, const double tol)
+{
+	ASSERT_EQ(f1.size(), f2.size());
+	for (size_t i = 0; i < f1.size(); i++)
+	{
+		const CVectorDouble v1 = f1[i].getAsVectorVal(),
+							v2 = f2[i].getAsVectorVal();
+		for (int k = 0; k < 6; k++) EXPECT_NEAR(v1[k], v2[k], tol);
+	}
+}
+
+TEST(bundle_adj_sparse, SameSolutionThanFull)
+{
+	const TSyntheticBA ba(8, 80);
+
+	TParametersDouble params;
+	params["max_iterations"] = 30;
+	params["robust_kernel"] = 0;
+
+	TFramePosesVec frames_full = ba.frames, frames_sparse = ba.frames;
+	TLandmarkLocationsVec points_full = ba.points, points_sparse = ba.points;
+	const double res_full = bundle_adj_full(
+		ba.obs, ba.cam, frames_full, points_full, params);
+	const double res_sparse = bundle_adj_sparse(
+		ba.obs, ba.cam, frames_sparse, points_sparse, params);
+
+	EXPECT_NEAR(res_sparse, res_full, 1e-6 * res_full);
+	// ~0.5 px noise:
+	EXPECT_LT(res_sparse, ba.obs.size() * 0.5);
+	expectSamePoses(frames_full, frames_sparse, 1e-4);
+}
+
+TEST(bundle_adj_sparse, SolversAndThreads)
+{
+	const TSyntheticBA ba(15, 150);
+
+	TParametersDouble params;
+	params["max_iterations"] = 30;
+	params["num_threads"] = 1;
+
+	TFramePosesVec frames_ref = ba.frames;
+	TLandmarkLocationsVec points_ref = ba.points;
+	const double res_ref =
+		bundle_adj_sparse(ba.obs, ba.cam, frames_ref, points_ref, params);
+
+	// More threads: exactly the same computations.
+	params["num_threads"] = 4;
+	TFramePosesVec frames = ba.frames;
+	TLandmarkLocationsVec points = ba.points;
+	EXPECT_EQ(
+		res_ref, bundle_adj_sparse(ba.obs, ba.cam, frames, points, params));
+	expectSamePoses(frames_ref, frames, 0);
+
+	// PCG instead of Cholesky:
+	params["solver"] = 1;
+	frames = ba.frames;
+	points = ba.points;
+	EXPECT_NEAR(
+		res_ref, bundle_adj_sparse(ba.obs, ba.cam, frames, points, params),
+		1e-6 * res_ref);
+	expectSamePoses(frames_ref, frames, 1e-5);
+}
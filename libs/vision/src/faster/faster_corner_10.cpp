@@ -54,7 +54,7 @@ void faster_corner_detect_10(
 		*ptr_feat_index_by_row++ = corners.size();
 	}
 
-	const int w = I->width;
+	const int w = I->widthStep;
 	const int stride = 3 * I->widthStep;  // 3*w;
 
 	// The compiler refuses to reserve a register for this
@@ -243,7 +243,11 @@ void fast_corner_detect_10(
 	else if (I->width < 22 || I->height < 7)
 		return;
 
-#if MRPT_HAS_SSE2
+#if MRPT_HAS_AVX2
+	fast_corner_detect_avx2_10(
+		(const uint8_t*)I->imageData, I->width, I->height, I->widthStep,
+		corners, barrier, octave, out_feats_index_by_row);
+#elif MRPT_HAS_SSE2
 	if (mrpt::system::is_aligned<16>(I->imageData) &&
 		mrpt::system::is_aligned<16>(I->imageData + I->widthStep))
 		faster_corner_detect_10<true>(
@@ -100,7 +100,8 @@ void faster_corner_detect_12(
 	}
 
 	const int w = I->width;
-	const int stride = 3 * I->widthStep;  // 3*w;
+	const int ws = I->widthStep;
+	const int stride = 3 * ws;  // 3*w;
 	typedef std::list<const uint8_t*> Passed;
 	Passed passed;
 
@@ -151,7 +152,7 @@ void faster_corner_detect_12(
 						(both_ud & (left_flags | right_flags));
 					if (at_least_three)
 					{
-						process_16<4>(at_least_three, p, w, barrier, passed);
+						process_16<4>(at_least_three, p, ws, barrier, passed);
 					}
 				}
 			}
@@ -177,14 +178,14 @@ void faster_corner_detect_12(
 					num_above += p[3] > cb;
 
 				// Only do a complete check if num_above is 3
-				if ((num_above & 1) && is_corner_12<Greater>(p, w, barrier))
+				if ((num_above & 1) && is_corner_12<Greater>(p, ws, barrier))
 					passed.push_back(p);
 			}
 			else if (num_below & 2)
 			{
 				if (!(num_below & 1)) num_below += p[3] < c_b;
 
-				if ((num_below & 1) && is_corner_12<Less>(p, w, barrier))
+				if ((num_below & 1) && is_corner_12<Less>(p, ws, barrier))
 					passed.push_back(p);
 			}
 		}
@@ -247,7 +248,11 @@ void fast_corner_detect_12(
 	else if (I->width < 22 || I->height < 7)
 		return;
 
-#if MRPT_HAS_SSE2
+#if MRPT_HAS_AVX2
+	fast_corner_detect_avx2_12(
+		(const uint8_t*)I->imageData, I->width, I->height, I->widthStep,
+		corners, barrier, octave, out_feats_index_by_row);
+#elif MRPT_HAS_SSE2
 	if (mrpt::system::is_aligned<16>(I->imageData) &&
 		mrpt::system::is_aligned<16>(I->imageData + I->widthStep))
 		faster_corner_detect_12<true>(
@@ -46,7 +46,7 @@ void faster_corner_detect_9(
 		ptr_feat_index_by_row = nullptr;
 	}
 
-	const int w = I->width;
+	const int w = I->widthStep;
 	const int stride = 3 * I->widthStep;  // 3*w;
 
 	// The compiler refuses to reserve a register for this
@@ -318,7 +318,11 @@ void fast_corner_detect_9(
 	else if (I->width < 22 || I->height < 7)
 		return;
 
-#if MRPT_HAS_SSE2
+#if MRPT_HAS_AVX2
+	fast_corner_detect_avx2_9(
+		(const uint8_t*)I->imageData, I->width, I->height, I->widthStep,
+		corners, barrier, octave, out_feats_index_by_row);
+#elif MRPT_HAS_SSE2
 	if (mrpt::system::is_aligned<16>(I->imageData) &&
 		mrpt::system::is_aligned<16>(I->imageData + I->widthStep))
 		faster_corner_detect_9<true>(
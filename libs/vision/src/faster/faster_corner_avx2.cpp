@@ -0,0 +1,191 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/utils_defs.h>
+#include "faster_corner_prototypes.h"
+
+#include <mrpt/utils/SSE_types.h>
+#include "faster_corner_utilities.h"
+#include "corner_9.h"
+#include "corner_10.h"
+#include "corner_12.h"
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::utils;
+
+#if MRPT_HAS_AVX2
+
+namespace
+{
+/** Scalar test of one pixel, used for the last columns of each row */
+template <int N>
+bool is_corner(const uint8_t* p, const int w, const int barrier);
+template <>
+bool is_corner<9>(const uint8_t* p, const int w, const int barrier)
+{
+	return is_corner_9<Less>(p, w, barrier) ||
+		   is_corner_9<Greater>(p, w, barrier);
+}
+template <>
+bool is_corner<10>(const uint8_t* p, const int w, const int barrier)
+{
+	return is_corner_10<Less>(p, w, barrier) ||
+		   is_corner_10<Greater>(p, w, barrier);
+}
+template <>
+bool is_corner<12>(const uint8_t* p, const int w, const int barrier)
+{
+	return is_corner_12<Less>(p, w, barrier) ||
+		   is_corner_12<Greater>(p, w, barrier);
+}
+
+/** Byte masks (0xFF) of the pixels for which at least N contiguous pixels of
+ * the circle have their flag set in \a m (one mask per circle pixel). The
+ * runs are built by doubling: runs of 2, 4 and 8 pixels starting at each
+ * position, then extended to N with the runs that follow them. */
+template <int N>
+inline __m256i contiguousArc(const __m256i* m)
+{
+	__m256i r2[16], r4[16], r8[16];
+	for (int s = 0; s < 16; s++)
+		r2[s] = _mm256_and_si256(m[s], m[(s + 1) & 15]);
+	for (int s = 0; s < 16; s++)
+		r4[s] = _mm256_and_si256(r2[s], r2[(s + 2) & 15]);
+	for (int s = 0; s < 16; s++)
+		r8[s] = _mm256_and_si256(r4[s], r4[(s + 4) & 15]);
+
+	__m256i any = _mm256_setzero_si256();
+	for (int s = 0; s < 16; s++)
+	{
+		const int e = (s + 8) & 15;
+		const __m256i tail = N == 9 ? m[e] : (N == 10 ? r2[e] : r4[e]);
+		any = _mm256_or_si256(any, _mm256_and_si256(r8[s], tail));
+	}
+	return any;
+}
+
+/** FAST-N corners of a grayscale image, 32 pixels at a time. The output is
+ * identical to that of the plain and SSE2 versions, in the same order. */
+template <int N>
+void faster_corner_detect_avx2(
+	const uint8_t* data, const int width, const int height, const int stride,
+	TSimpleFeatureList& corners, const int barrier, const uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row)
+{
+	if (out_feats_index_by_row)
+		out_feats_index_by_row->assign(std::max(height, 0), corners.size());
+	if (width < 7 || height < 7) return;
+
+	corners.reserve(corners.size() + 500);
+
+	// Offsets of the Bresenham circle of radius 3, in circular order:
+	const int ring[16] = {
+		3 * stride,		 1 + 3 * stride,  2 + 2 * stride, 3 + stride,
+		3,				 3 - stride,	  2 - 2 * stride, 1 - 3 * stride,
+		-3 * stride,	 -1 - 3 * stride, -2 - 2 * stride, -3 - stride,
+		-3,				 -3 + stride,	  -2 + 2 * stride, -1 + 3 * stride};
+
+	const __m256i barriers = _mm256_set1_epi8((char)(uint8_t)barrier);
+	const __m256i zeros = _mm256_setzero_si256();
+	const __m256i ones = _mm256_cmpeq_epi8(zeros, zeros);
+
+	for (int y = 3; y < height - 3; y++)
+	{
+		if (out_feats_index_by_row)
+			(*out_feats_index_by_row)[y] = corners.size();
+
+		const uint8_t* row = data + stride * y;
+		int x = 3;
+		for (; x + 32 <= width - 3; x += 32)
+		{
+			const uint8_t* p = row + x;
+			const __m256i here = _mm256_loadu_si256((const __m256i*)p);
+			const __m256i lo = _mm256_subs_epu8(here, barriers);
+			const __m256i hi = _mm256_adds_epu8(here, barriers);
+
+			// Darker (below lo) and brighter (above hi) flags of each pixel
+			// of the circle (first, only for the compass points):
+			__m256i dark[16], bright[16];
+			auto compare = [&](const int k) {
+				const __m256i o =
+					_mm256_loadu_si256((const __m256i*)(p + ring[k]));
+				dark[k] = _mm256_xor_si256(
+					_mm256_cmpeq_epi8(_mm256_subs_epu8(lo, o), zeros), ones);
+				bright[k] = _mm256_xor_si256(
+					_mm256_cmpeq_epi8(_mm256_subs_epu8(o, hi), zeros), ones);
+			};
+
+			// Quick rejection: any arc of 9 or more pixels contains two
+			// consecutive compass points (0, 4, 8, 12).
+			for (int k = 0; k < 16; k += 4) compare(k);
+			__m256i candidates = zeros;
+			for (int k = 0; k < 16; k += 4)
+			{
+				const int k2 = (k + 4) & 15;
+				candidates = _mm256_or_si256(
+					candidates,
+					_mm256_or_si256(
+						_mm256_and_si256(dark[k], dark[k2]),
+						_mm256_and_si256(bright[k], bright[k2])));
+			}
+			if (!_mm256_movemask_epi8(candidates)) continue;
+
+			for (int k = 0; k < 16; k++)
+				if (k & 3) compare(k);
+			const __m256i is_corner_mask = _mm256_or_si256(
+				contiguousArc<N>(dark), contiguousArc<N>(bright));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(is_corner_mask);
+			for (int i = 0; mask; i++, mask >>= 1)
+				if (mask & 1)
+					corners.push_back_fast((x + i) << octave, y << octave);
+		}
+
+		// Remaining pixels of the row:
+		for (; x < width - 3; x++)
+			if (is_corner<N>(row + x, stride, barrier))
+				corners.push_back_fast(x << octave, y << octave);
+	}
+
+	// 3 last rows have no features:
+	if (out_feats_index_by_row)
+		for (int y = std::max(height - 3, 3); y < height; y++)
+			(*out_feats_index_by_row)[y] = corners.size();
+}
+}  // namespace
+
+void fast_corner_detect_avx2_9(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row)
+{
+	faster_corner_detect_avx2<9>(
+		data, width, height, stride, corners, barrier, octave,
+		out_feats_index_by_row);
+}
+void fast_corner_detect_avx2_10(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row)
+{
+	faster_corner_detect_avx2<10>(
+		data, width, height, stride, corners, barrier, octave,
+		out_feats_index_by_row);
+}
+void fast_corner_detect_avx2_12(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row)
+{
+	faster_corner_detect_avx2<12>(
+		data, width, height, stride, corners, barrier, octave,
+		out_feats_index_by_row);
+}
+
+#endif  // MRPT_HAS_AVX2
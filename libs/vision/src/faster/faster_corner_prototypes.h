@@ -19,6 +19,41 @@ using mrpt::utils::TPixelCoord;
 using mrpt::vision::TSimpleFeatureList;
 using std::vector;
 
+#if MRPT_HAS_AVX2
+// AVX2 versions, for any 8-bit grayscale buffer with "stride" bytes per row
+// (they do not depend on OpenCV):
+void fast_corner_detect_avx2_9(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row);
+void fast_corner_detect_avx2_10(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row);
+void fast_corner_detect_avx2_12(
+	const uint8_t* data, int width, int height, int stride,
+	TSimpleFeatureList& corners, int barrier, uint8_t octave,
+	std::vector<size_t>* out_feats_index_by_row);
+#endif
+
+// Detection by tiles, for any 8-bit grayscale buffer with "stride" bytes per
+// row (it uses the AVX2 versions if available, or else those for IplImage's):
+/** FAST score of a corner: the sum of the differences (minus the barrier)
+ * of the brighter or of the darker pixels of the circle, the largest. */
+int fast_corner_score(const uint8_t* p, const int stride, const int barrier);
+/** FAST-N corners (N=9,10,12) within the tile [x0,x1)x[y0,y1) of the image,
+ * which are appended to \a corners sorted by rows, with their FAST score as
+ * response (the rest of fields are left uninitialized). With \a
+ * nonmax_suppression, only the corners whose score is above that of its 8
+ * neighbor corners are kept: neighbors outside of the tile are also
+ * considered, so the result for a tiling of the image does not depend on the
+ * tiles. */
+void fast_corner_detect_tile(
+	const int N, const uint8_t* data, const int width, const int height,
+	const int stride, const int x0, const int y0, const int x1, const int y1,
+	const int barrier, const bool nonmax_suppression,
+	TSimpleFeatureList& corners);
+
 #if MRPT_HAS_OPENCV
 
 // Prototypes of functions exported from "vision/src/faster/*" to
@@ -0,0 +1,165 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/utils_defs.h>
+#include "faster_corner_prototypes.h"
+
+#include "faster_corner_utilities.h"
+#include "corner_9.h"
+#include "corner_10.h"
+#include "corner_12.h"
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::utils;
+using mrpt::vision::TSimpleFeature;
+
+namespace
+{
+/** FAST-N corners of a whole grayscale buffer, with the fastest available
+ * implementation */
+void detect_corners(
+	const int N, const uint8_t* data, const int width, const int height,
+	const int stride, const int barrier, TSimpleFeatureList& corners)
+{
+#if MRPT_HAS_AVX2
+	switch (N)
+	{
+		case 9:
+			fast_corner_detect_avx2_9(
+				data, width, height, stride, corners, barrier, 0, nullptr);
+			break;
+		case 10:
+			fast_corner_detect_avx2_10(
+				data, width, height, stride, corners, barrier, 0, nullptr);
+			break;
+		default:
+			fast_corner_detect_avx2_12(
+				data, width, height, stride, corners, barrier, 0, nullptr);
+	};
+#elif MRPT_HAS_OPENCV
+	// An image header for the buffer (no pixel is copied):
+	IplImage I;
+	cvInitImageHeader(&I, cvSize(width, height), IPL_DEPTH_8U, 1);
+	cvSetData(&I, const_cast<uint8_t*>(data), stride);
+	switch (N)
+	{
+		case 9:
+			fast_corner_detect_9(&I, corners, barrier, 0, nullptr);
+			break;
+		case 10:
+			fast_corner_detect_10(&I, corners, barrier, 0, nullptr);
+			break;
+		default:
+			fast_corner_detect_12(&I, corners, barrier, 0, nullptr);
+	};
+#else
+	for (int y = 3; y < height - 3; y++)
+		for (int x = 3; x < width - 3; x++)
+		{
+			const uint8_t* p = data + stride * y + x;
+			bool is_corner;
+			switch (N)
+			{
+				case 9:
+					is_corner = is_corner_9<Less>(p, stride, barrier) ||
+								is_corner_9<Greater>(p, stride, barrier);
+					break;
+				case 10:
+					is_corner = is_corner_10<Less>(p, stride, barrier) ||
+								is_corner_10<Greater>(p, stride, barrier);
+					break;
+				default:
+					is_corner = is_corner_12<Less>(p, stride, barrier) ||
+								is_corner_12<Greater>(p, stride, barrier);
+			};
+			if (is_corner) corners.push_back_fast(x, y);
+		}
+#endif
+}
+}  // namespace
+
+int fast_corner_score(const uint8_t* p, const int stride, const int barrier)
+{
+	const int ring[16] = {
+		3 * stride,		 1 + 3 * stride,  2 + 2 * stride, 3 + stride,
+		3,				 3 - stride,	  2 - 2 * stride, 1 - 3 * stride,
+		-3 * stride,	 -1 - 3 * stride, -2 - 2 * stride, -3 - stride,
+		-3,				 -3 + stride,	  -2 + 2 * stride, -1 + 3 * stride};
+
+	const int c = *p;
+	int sum_bright = 0, sum_dark = 0;
+	for (int k = 0; k < 16; k++)
+	{
+		const int v = p[ring[k]];
+		if (v > c + barrier)
+			sum_bright += v - c - barrier;
+		else if (v < c - barrier)
+			sum_dark += c - v - barrier;
+	}
+	return std::max(sum_bright, sum_dark);
+}
+
+void fast_corner_detect_tile(
+	const int N, const uint8_t* data, const int width, const int height,
+	const int stride, const int x0, const int y0, const int x1, const int y1,
+	const int barrier, const bool nonmax_suppression,
+	TSimpleFeatureList& corners)
+{
+	ASSERT_(N == 9 || N == 10 || N == 12)
+	ASSERT_(x0 >= 0 && y0 >= 0 && x1 <= width && y1 <= height)
+	if (x0 >= x1 || y0 >= y1) return;
+
+	// The tile is enlarged with the 3 pixels of the radius of the circle, so
+	// its border pixels can be tested, plus one more pixel, so the neighbors
+	// of its border pixels are also known for the non-maximum suppression:
+	const int M = 3 + 1;
+	const int ex0 = std::max(0, x0 - M), ey0 = std::max(0, y0 - M);
+	const int ex1 = std::min(width, x1 + M), ey1 = std::min(height, y1 + M);
+	const int ew = ex1 - ex0, eh = ey1 - ey0;
+
+	TSimpleFeatureList found;
+	detect_corners(
+		N, data + stride * ey0 + ex0, ew, eh, stride, barrier, found);
+
+	// Scores of the corners, in a map of the enlarged tile (0=no corner):
+	std::vector<int> scores;
+	if (nonmax_suppression) scores.assign(ew * eh, 0);
+	for (size_t i = 0; i < found.size(); i++)
+	{
+		TSimpleFeature& f = found[i];
+		const int x = f.pt.x + ex0, y = f.pt.y + ey0;
+		const int score =
+			fast_corner_score(data + stride * y + x, stride, barrier);
+		f.response = score;
+		if (nonmax_suppression) scores[ew * f.pt.y + f.pt.x] = score;
+	}
+
+	for (size_t i = 0; i < found.size(); i++)
+	{
+		const TSimpleFeature& f = found[i];
+		const int x = f.pt.x + ex0, y = f.pt.y + ey0;
+		if (x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+
+		// Keep only strict local maxima of the score among the 8 neighbors:
+		if (nonmax_suppression)
+		{
+			const int* s = &scores[ew * f.pt.y + f.pt.x];
+			const int score = *s;
+			if (s[-1] >= score || s[1] >= score || s[-ew - 1] >= score ||
+				s[-ew] >= score || s[-ew + 1] >= score ||
+				s[ew - 1] >= score || s[ew] >= score || s[ew + 1] >= score)
+				continue;
+		}
+
+		TSimpleFeature c(x, y);
+		c.response = f.response;
+		corners.push_back(c);
+	}
+}
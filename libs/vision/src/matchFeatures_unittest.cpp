@@ -0,0 +1,289 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/utils.h>
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/math/lightweight_geom_data.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::math;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+typedef set<pair<TFeatureID, TFeatureID>> match_set_t;
+
+static double descriptorDistance(
+	const CFeature& f1, const CFeature& f2,
+	const TMatchingOptions::TMatchingMethod method)
+{
+	switch (method)
+	{
+		case TMatchingOptions::mmDescriptorSIFT:
+			return f1.descriptorSIFTDistanceTo(f2);
+		case TMatchingOptions::mmDescriptorSURF:
+			return f1.descriptorSURFDistanceTo(f2);
+		default:
+			return f1.descriptorORBDistanceTo(f2);
+	}
+}
+
+// Brute-force reference: the two best matches of each feature of list1 among
+// all the features of list2 fulfilling the restrictions, and the conflicts
+// between matches solved in the order of list1.
+static match_set_t referenceMatches(
+	const CFeatureList& list1, const CFeatureList& list2,
+	const TMatchingOptions& opts, const CMatrixDouble33& F)
+{
+	const int sz1 = list1.size(), sz2 = list2.size();
+	vector<int> idxLeft(sz1, -1), idxRight(sz2, -1);
+	vector<double> dists(sz1);
+	for (int i = 0; i < sz1; i++)
+	{
+		const CFeature& f1 = *list1[i];
+		double min1 = 1e5, min2 = 1e5;
+		int best = -1;
+		for (int j = 0; j < sz2; j++)
+		{
+			const CFeature& f2 = *list2[j];
+			double d = 0;
+			if (opts.parallelOpticalAxis)
+				d = f1.y - f2.y;
+			else
+			{
+				CMatrixDouble31 p, l;
+				p(0, 0) = f1.x;
+				p(1, 0) = f1.y;
+				p(2, 0) = 1;
+				l = F * p;
+				d = TLine2D(l(0, 0), l(1, 0), l(2, 0))
+						.distance(TPoint2D(f2.x, f2.y));
+			}
+			if (!(fabs(d) < opts.epipolar_TH)) continue;
+			if (opts.useXRestriction && !(f1.x - f2.x > 0)) continue;
+			const double dist =
+				descriptorDistance(f1, f2, opts.matching_method);
+			if (dist < min1)
+			{
+				min2 = min1;
+				min1 = dist;
+				best = j;
+			}
+			else if (dist < min2)
+				min2 = dist;
+		}
+		bool ok = false;
+		switch (opts.matching_method)
+		{
+			case TMatchingOptions::mmDescriptorSIFT:
+				ok = min1 < opts.maxEDD_TH && min1 / min2 < opts.EDD_RATIO;
+				break;
+			case TMatchingOptions::mmDescriptorSURF:
+				ok = min1 < opts.maxEDSD_TH && min1 / min2 < opts.EDSD_RATIO;
+				break;
+			default:
+				ok = min1 < opts.maxORB_dist &&
+					 (opts.ORB_RATIO >= 1 || min1 / min2 < opts.ORB_RATIO);
+		}
+		if (best < 0 || !ok) continue;
+		const int prev = idxRight[best];
+		if (prev < 0)
+		{
+			idxRight[best] = i;
+			idxLeft[i] = best;
+			dists[i] = min1;
+		}
+		else if (dists[prev] > min1)
+		{
+			idxRight[best] = i;
+			idxLeft[i] = best;
+			dists[i] = min1;
+			idxLeft[prev] = -1;
+		}
+	}
+	match_set_t ret;
+	for (int i = 0; i < sz1; i++)
+		if (idxLeft[i] >= 0)
+			ret.insert(make_pair(list1[i]->ID, list2[idxLeft[i]]->ID));
+	return ret;
+}
+
+static CFeature::Ptr newFeature(
+	const TFeatureID id, const float x, const float y,
+	const TMatchingOptions::TMatchingMethod method,
+	const CFeature* similar_to = nullptr)
+{
+	CFeature::Ptr f = std::make_shared<CFeature>();
+	f->ID = id;
+	f->x = x;
+	f->y = y;
+	switch (method)
+	{
+		case TMatchingOptions::mmDescriptorSIFT:
+			f->descriptors.SIFT.resize(128);
+			for (size_t k = 0; k < 128; k++)
+				f->descriptors.SIFT[k] = similar_to
+					? saturate_val<int>(
+						  similar_to->descriptors.SIFT[k] +
+							  randomGenerator.drawUniform32bit() % 11 - 5,
+						  0, 255)
+					: randomGenerator.drawUniform32bit() % 256;
+			break;
+		case TMatchingOptions::mmDescriptorSURF:
+			f->descriptors.SURF.resize(64);
+			for (size_t k = 0; k < 64; k++)
+				f->descriptors.SURF[k] =
+					(similar_to ? similar_to->descriptors.SURF[k] : 0) +
+					randomGenerator.drawUniform(
+						similar_to ? -0.01 : -0.1, similar_to ? 0.01 : 0.1);
+			break;
+		default:
+			f->descriptors.ORB.resize(32);
+			for (size_t k = 0; k < 32; k++)
+				f->descriptors.ORB[k] =
+					similar_to ? similar_to->descriptors.ORB[k]
+							   : randomGenerator.drawUniform32bit() % 256;
+			if (similar_to)  // Flip a few bits
+				for (int k = 0; k < 8; k++)
+				{
+					const size_t byte = randomGenerator.drawUniform32bit() % 32;
+					f->descriptors.ORB[byte] ^=
+						1 << (randomGenerator.drawUniform32bit() % 8);
+				}
+	}
+	return f;
+}
+
+// Two lists of features: pairs of features with similar descriptors in the
+// same epipolar line (or row), and random ones.
+static void createLists(
+	const TMatchingOptions& opts, const CMatrixDouble33& F,
+	CFeatureList& list1, CFeatureList& list2)
+{
+	list1.clear();
+	list2.clear();
+	for (TFeatureID i = 0; i < 400; i++)
+		list1.push_back(newFeature(
+			i, randomGenerator.drawUniform(100, 640),
+			randomGenerator.drawUniform(0, 480), opts.matching_method));
+	for (TFeatureID i = 0; i < 300; i++)
+	{
+		const CFeature& f1 = *list1[i];
+		float x2 = f1.x - randomGenerator.drawUniform(1, 80),
+			  y2 = f1.y + randomGenerator.drawUniform(-1, 1);
+		if (!opts.parallelOpticalAxis)
+		{
+			// A point near the epipolar line:
+			CMatrixDouble31 p, l;
+			p(0, 0) = f1.x;
+			p(1, 0) = f1.y;
+			p(2, 0) = 1;
+			l = F * p;
+			const double noise = randomGenerator.drawUniform(-0.5, 0.5);
+			if (fabs(l(1, 0)) >= fabs(l(0, 0)))
+				y2 = -(l(0, 0) * x2 + l(2, 0)) / l(1, 0) + noise;
+			else
+			{
+				y2 = randomGenerator.drawUniform(0, 480);
+				x2 = -(l(1, 0) * y2 + l(2, 0)) / l(0, 0) + noise;
+			}
+		}
+		list2.push_back(
+			newFeature(1000 + i, x2, y2, opts.matching_method, &f1));
+	}
+	for (TFeatureID i = 0; i < 200; i++)
+		list2.push_back(newFeature(
+			2000 + i, randomGenerator.drawUniform(0, 640),
+			randomGenerator.drawUniform(0, 480), opts.matching_method));
+}
+
+static match_set_t toSet(const CMatchedFeatureList& matches)
+{
+	match_set_t ret;
+	for (const auto& m : matches)
+		ret.insert(make_pair(m.first->ID, m.second->ID));
+	return ret;
+}
+
+/** The epipolar restriction of the tests */
+enum TEpipolarLines
+{
+	/** Parallel optical axes (rows) */
+	elRows,
+	/** Fundamental matrix with epipolar lines close to the horizontal */
+	elHorizontal,
+	/** Fundamental matrix with epipolar lines close to the vertical */
+	elVertical
+};
+
+static void testAgainstBruteForce(
+	const TMatchingOptions::TMatchingMethod method,
+	const TEpipolarLines lines, const float ORB_RATIO = 1)
+{
+	TMatchingOptions opts;
+	opts.matching_method = method;
+	opts.parallelOpticalAxis = (lines == elRows);
+	opts.hasFundamentalMatrix = (lines != elRows);
+	opts.useXRestriction = (lines != elVertical);
+	opts.ORB_RATIO = ORB_RATIO;
+
+	TStereoSystemParams params;
+	// Lines with some slope, for a nearly rectified stereo pair (swapping
+	// the first two rows turns them into nearly vertical lines):
+	const double F[3][3] = {
+		{0, 1e-5, -2e-3}, {-1e-5, 1e-5, -1}, {3e-3, 1, 0.5}};
+	const int rows_horz[3] = {0, 1, 2}, rows_vert[3] = {1, 0, 2};
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			params.F(r, c) =
+				F[lines == elVertical ? rows_vert[r] : rows_horz[r]][c];
+
+	CFeatureList list1, list2;
+	createLists(opts, params.F, list1, list2);
+	const match_set_t ref = referenceMatches(list1, list2, opts, params.F);
+	EXPECT_GT(ref.size(), 200U);
+
+	for (unsigned int num_threads : {1U, 4U})
+	{
+		opts.num_threads = num_threads;
+		CMatchedFeatureList matches;
+		const size_t n = matchFeatures(list1, list2, matches, opts, params);
+		EXPECT_EQ(n, ref.size());
+		EXPECT_TRUE(toSet(matches) == ref) << "num_threads=" << num_threads;
+	}
+}
+
+TEST(matchFeatures, SIFTRowsAsBruteForce)
+{
+	randomGenerator.randomize(1);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorSIFT, elRows);
+}
+TEST(matchFeatures, SIFTEpipolarAsBruteForce)
+{
+	randomGenerator.randomize(2);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorSIFT, elHorizontal);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorSIFT, elVertical);
+}
+TEST(matchFeatures, SURFAsBruteForce)
+{
+	randomGenerator.randomize(3);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorSURF, elRows);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorSURF, elVertical);
+}
+TEST(matchFeatures, ORBAsBruteForce)
+{
+	randomGenerator.randomize(4);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorORB, elRows);
+	testAgainstBruteForce(TMatchingOptions::mmDescriptorORB, elVertical);
+	testAgainstBruteForce(
+		TMatchingOptions::mmDescriptorORB, elHorizontal, 0.8f);
+}
@@ -0,0 +1,636 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/utils/types_math.h>  // Eigen must be included first via MRPT to enable the plugin system
+#include <mrpt/vision/pnp_algos.h>
+#include <mrpt/utils/mrpt_macros.h>
+#include <mrpt/utils/CTicTac.h>
+#include <mrpt/utils/SSE_types.h>
+#include <mrpt/utils/parallel.h>
+#include <bitset>
+#include <cmath>
+#include <limits>
+
+#include "p3p.h"
+
+using namespace mrpt::vision::pnp;
+using mrpt::utils::CTicTac;
+
+namespace
+{
+/** Hypotheses per round: SPRT parameters and the best model are updated
+ * between rounds, so results do not depend on the number of threads */
+const size_t HYPOTHESES_PER_ROUND = 64;
+const size_t HYPOTHESES_PER_JOB = 8;
+/** The SPRT decision is taken after each chunk of points */
+const size_t SPRT_CHUNK = 32;
+/** Time to generate a model, in units of point verifications, and average
+ * number of models per sample (P3P gives up to 4), for the SPRT threshold */
+const double SPRT_T_M = 200, SPRT_M_S = 2;
+const unsigned int LO_GAUSS_NEWTON_ITERS = 3;
+
+/** A small, fast generator (splitmix64), one per hypothesis */
+struct TRandom
+{
+	uint64_t state;
+	explicit TRandom(const uint64_t seed) : state(seed) {}
+	uint64_t operator()()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+};
+
+/** The correspondences in structure-of-arrays layout (in float), in a
+ * random order (for the SPRT), with image coordinates relative to the
+ * principal point */
+struct TPoints
+{
+	std::vector<float> X, Y, Z, u, v;
+	/** Index of each point in the input */
+	std::vector<size_t> index;
+	float fx, fy;
+	size_t size() const { return X.size(); }
+
+	/** The input, in double, to refine the models */
+	const Eigen::Ref<const Eigen::MatrixXd>*obj_pts, *img_pts;
+	Eigen::Matrix3d K;
+	/** The input object point of the point `i` */
+	Eigen::Vector3d objPoint(const size_t i) const
+	{
+		return obj_pts->col(index[i]);
+	}
+	/** The input image point of the point `i`, relative to the principal
+	 * point */
+	Eigen::Vector2d imgPoint(const size_t i) const
+	{
+		const size_t j = index[i];
+		return Eigen::Vector2d(
+			(*img_pts)(0, j) - K(0, 2), (*img_pts)(1, j) - K(1, 2));
+	}
+};
+
+/** A model in float, for scoring */
+struct TModelF
+{
+	float r[9], t[3];
+};
+
+struct TModel
+{
+	Eigen::Matrix3d R;
+	Eigen::Vector3d t;
+	TModelF asFloat() const
+	{
+		TModelF m;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++) m.r[3 * i + j] = R(i, j);
+			m.t[i] = t[i];
+		}
+		return m;
+	}
+};
+
+/** Counts the inliers among the points [i0,i1) and, optionally, marks them
+ * in \a mask. A point is an inlier if it is in front of the camera and its
+ * squared reprojection error is below \a th2, which is tested without
+ * divisions as |f*xc - u*zc|^2 < th2*zc^2. */
+size_t count_inliers(
+	const TPoints& p, const TModelF& m, const float th2, size_t i0,
+	const size_t i1, uint8_t* mask = nullptr)
+{
+	size_t count = 0;
+	const float* r = m.r;
+#if MRPT_HAS_AVX2
+	{
+		const __m256 r0 = _mm256_set1_ps(r[0]), r1 = _mm256_set1_ps(r[1]),
+					 r2 = _mm256_set1_ps(r[2]), r3 = _mm256_set1_ps(r[3]),
+					 r4 = _mm256_set1_ps(r[4]), r5 = _mm256_set1_ps(r[5]),
+					 r6 = _mm256_set1_ps(r[6]), r7 = _mm256_set1_ps(r[7]),
+					 r8 = _mm256_set1_ps(r[8]);
+		const __m256 t0 = _mm256_set1_ps(m.t[0]), t1 = _mm256_set1_ps(m.t[1]),
+					 t2 = _mm256_set1_ps(m.t[2]);
+		const __m256 fx = _mm256_set1_ps(p.fx), fy = _mm256_set1_ps(p.fy),
+					 vth2 = _mm256_set1_ps(th2), zero = _mm256_setzero_ps();
+		for (; i0 + 8 <= i1; i0 += 8)
+		{
+			const __m256 X = _mm256_loadu_ps(&p.X[i0]),
+						 Y = _mm256_loadu_ps(&p.Y[i0]),
+						 Z = _mm256_loadu_ps(&p.Z[i0]);
+			const __m256 xc = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(r0, X), _mm256_mul_ps(r1, Y)),
+				_mm256_add_ps(_mm256_mul_ps(r2, Z), t0));
+			const __m256 yc = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(r3, X), _mm256_mul_ps(r4, Y)),
+				_mm256_add_ps(_mm256_mul_ps(r5, Z), t1));
+			const __m256 zc = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(r6, X), _mm256_mul_ps(r7, Y)),
+				_mm256_add_ps(_mm256_mul_ps(r8, Z), t2));
+			const __m256 ex = _mm256_sub_ps(
+				_mm256_mul_ps(fx, xc),
+				_mm256_mul_ps(_mm256_loadu_ps(&p.u[i0]), zc));
+			const __m256 ey = _mm256_sub_ps(
+				_mm256_mul_ps(fy, yc),
+				_mm256_mul_ps(_mm256_loadu_ps(&p.v[i0]), zc));
+			const __m256 e2 = _mm256_add_ps(
+				_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+			const __m256 in = _mm256_and_ps(
+				_mm256_cmp_ps(zc, zero, _CMP_GT_OQ),
+				_mm256_cmp_ps(
+					e2, _mm256_mul_ps(vth2, _mm256_mul_ps(zc, zc)),
+					_CMP_LT_OQ));
+			const unsigned int bits = _mm256_movemask_ps(in);
+			count += std::bitset<8>(bits).count();
+			if (mask)
+				for (int k = 0; k < 8; k++) mask[i0 + k] = (bits >> k) & 1;
+		}
+	}
+#elif MRPT_HAS_SSE2
+	{
+		const __m128 r0 = _mm_set1_ps(r[0]), r1 = _mm_set1_ps(r[1]),
+					 r2 = _mm_set1_ps(r[2]), r3 = _mm_set1_ps(r[3]),
+					 r4 = _mm_set1_ps(r[4]), r5 = _mm_set1_ps(r[5]),
+					 r6 = _mm_set1_ps(r[6]), r7 = _mm_set1_ps(r[7]),
+					 r8 = _mm_set1_ps(r[8]);
+		const __m128 t0 = _mm_set1_ps(m.t[0]), t1 = _mm_set1_ps(m.t[1]),
+					 t2 = _mm_set1_ps(m.t[2]);
+		const __m128 fx = _mm_set1_ps(p.fx), fy = _mm_set1_ps(p.fy),
+					 vth2 = _mm_set1_ps(th2), zero = _mm_setzero_ps();
+		for (; i0 + 4 <= i1; i0 += 4)
+		{
+			const __m128 X = _mm_loadu_ps(&p.X[i0]), Y = _mm_loadu_ps(&p.Y[i0]),
+						 Z = _mm_loadu_ps(&p.Z[i0]);
+			const __m128 xc = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(r0, X), _mm_mul_ps(r1, Y)),
+				_mm_add_ps(_mm_mul_ps(r2, Z), t0));
+			const __m128 yc = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(r3, X), _mm_mul_ps(r4, Y)),
+				_mm_add_ps(_mm_mul_ps(r5, Z), t1));
+			const __m128 zc = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(r6, X), _mm_mul_ps(r7, Y)),
+				_mm_add_ps(_mm_mul_ps(r8, Z), t2));
+			const __m128 ex = _mm_sub_ps(
+				_mm_mul_ps(fx, xc), _mm_mul_ps(_mm_loadu_ps(&p.u[i0]), zc));
+			const __m128 ey = _mm_sub_ps(
+				_mm_mul_ps(fy, yc), _mm_mul_ps(_mm_loadu_ps(&p.v[i0]), zc));
+			const __m128 e2 =
+				_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+			const __m128 in = _mm_and_ps(
+				_mm_cmpgt_ps(zc, zero),
+				_mm_cmplt_ps(e2, _mm_mul_ps(vth2, _mm_mul_ps(zc, zc))));
+			const unsigned int bits = _mm_movemask_ps(in);
+			count += std::bitset<4>(bits).count();
+			if (mask)
+				for (int k = 0; k < 4; k++) mask[i0 + k] = (bits >> k) & 1;
+		}
+	}
+#endif
+	for (; i0 < i1; i0++)
+	{
+		const float X = p.X[i0], Y = p.Y[i0], Z = p.Z[i0];
+		const float xc = (r[0] * X + r[1] * Y) + (r[2] * Z + m.t[0]);
+		const float yc = (r[3] * X + r[4] * Y) + (r[5] * Z + m.t[1]);
+		const float zc = (r[6] * X + r[7] * Y) + (r[8] * Z + m.t[2]);
+		const float ex = p.fx * xc - p.u[i0] * zc;
+		const float ey = p.fy * yc - p.v[i0] * zc;
+		const bool in = zc > 0 && ex * ex + ey * ey < th2 * (zc * zc);
+		count += in;
+		if (mask) mask[i0] = in;
+	}
+	return count;
+}
+
+/** SPRT state: log-likelihood ratio increments and decision threshold */
+struct TSPRT
+{
+	double epsilon, delta;
+	double log_in, log_out, log_A;
+
+	void update(const double eps, const double dlt)
+	{
+		epsilon = eps;
+		delta = dlt;
+		log_in = std::log(delta / epsilon);
+		log_out = std::log((1 - delta) / (1 - epsilon));
+		// Optimal threshold A = A0 + log(A) (Chum & Matas, eq. 17)
+		const double C = (1 - delta) * log_out + delta * log_in;
+		const double A0 = SPRT_T_M * C / SPRT_M_S + 1;
+		double A = A0;
+		for (int it = 0; it < 10; it++) A = A0 + std::log(A);
+		log_A = std::log(A);
+	}
+	double A() const { return std::exp(log_A); }
+};
+
+struct TScore
+{
+	/** Inliers (all points evaluated) or consistent points among the
+	 * evaluated ones (rejected by the SPRT) */
+	size_t inliers, evaluated;
+	bool rejected;
+};
+
+/** Scores a model, optionally with the SPRT */
+TScore score_model(
+	const TPoints& p, const TModel& model, const float th2,
+	const TSPRT* sprt)
+{
+	const TModelF m = model.asFloat();
+	TScore s{0, 0, false};
+	const size_t n = p.size();
+	if (!sprt)
+	{
+		s.inliers = count_inliers(p, m, th2, 0, n);
+		s.evaluated = n;
+		return s;
+	}
+	double log_lambda = 0;
+	for (size_t i = 0; i < n; i += SPRT_CHUNK)
+	{
+		const size_t i1 = std::min(n, i + SPRT_CHUNK);
+		const size_t k = count_inliers(p, m, th2, i, i1);
+		s.inliers += k;
+		s.evaluated = i1;
+		log_lambda += k * sprt->log_in + (i1 - i - k) * sprt->log_out;
+		if (log_lambda > sprt->log_A)
+		{
+			s.rejected = true;
+			break;
+		}
+	}
+	return s;
+}
+
+/** Gauss-Newton refinement of a model, minimizing the reprojection error
+ * of the given points (indices into \a p), with the input in double */
+void refine_model(
+	const TPoints& p, const std::vector<size_t>& idxs, TModel& model,
+	const unsigned int iters)
+{
+	if (idxs.size() < 4) return;
+	const double fx = p.K(0, 0), fy = p.K(1, 1);
+	for (unsigned int it = 0; it < iters; it++)
+	{
+		Eigen::Matrix<double, 6, 6> H = Eigen::Matrix<double, 6, 6>::Zero();
+		Eigen::Matrix<double, 6, 1> g = Eigen::Matrix<double, 6, 1>::Zero();
+		for (const size_t i : idxs)
+		{
+			const Eigen::Vector3d Xc = model.R * p.objPoint(i) + model.t;
+			if (Xc.z() <= 0) continue;
+			const double iz = 1.0 / Xc.z();
+			const double x = Xc.x() * iz, y = Xc.y() * iz;
+			const Eigen::Vector2d e =
+				Eigen::Vector2d(fx * x, fy * y) - p.imgPoint(i);
+			// d(proj)/d(Xc), and d(Xc)/d(w,v) = [-[Xc]x, I] for the
+			// perturbation R <- exp(w)*R, t <- exp(w)*t+v:
+			Eigen::Matrix<double, 2, 3> Jp;
+			Jp << fx * iz, 0, -fx * x * iz, 0, fy * iz, -fy * y * iz;
+			Eigen::Matrix<double, 3, 6> Jx;
+			Jx << 0, Xc.z(), -Xc.y(), 1, 0, 0, -Xc.z(), 0, Xc.x(), 0, 1, 0,
+				Xc.y(), -Xc.x(), 0, 0, 0, 1;
+			const Eigen::Matrix<double, 2, 6> J = Jp * Jx;
+			H.noalias() += J.transpose() * J;
+			g.noalias() += J.transpose() * e;
+		}
+		const Eigen::Matrix<double, 6, 1> delta = -H.ldlt().solve(g);
+		if (!delta.allFinite()) return;
+		const Eigen::Vector3d w = delta.head<3>();
+		const double angle = w.norm();
+		const Eigen::Matrix3d dR =
+			angle > 0
+				? Eigen::AngleAxisd(angle, w / angle).toRotationMatrix()
+				: Eigen::Matrix3d::Identity();
+		model.R = dR * model.R;
+		model.t = dR * model.t + delta.tail<3>();
+		if (delta.norm() < 1e-10) break;
+	}
+}
+
+/** Indices (into \a p) of the inliers of a model */
+void get_inliers(
+	const TPoints& p, const TModel& model, const float th2,
+	std::vector<size_t>& idxs)
+{
+	std::vector<uint8_t> mask(p.size());
+	count_inliers(p, model.asFloat(), th2, 0, p.size(), &mask[0]);
+	idxs.clear();
+	for (size_t i = 0; i < p.size(); i++)
+		if (mask[i]) idxs.push_back(i);
+}
+
+/** LO-RANSAC: refine with the inliers and re-select them, while their
+ * number grows */
+size_t local_optimization(
+	const TPoints& p, TModel& model, const float th2,
+	const unsigned int iters)
+{
+	std::vector<size_t> idxs, new_idxs;
+	get_inliers(p, model, th2, idxs);
+	for (unsigned int it = 0; it < iters; it++)
+	{
+		TModel m = model;
+		refine_model(p, idxs, m, LO_GAUSS_NEWTON_ITERS);
+		get_inliers(p, m, th2, new_idxs);
+		if (new_idxs.size() < idxs.size()) break;
+		model = m;
+		const bool grown = new_idxs.size() > idxs.size();
+		idxs.swap(new_idxs);
+		if (!grown) break;
+	}
+	return idxs.size();
+}
+
+/** Number of hypotheses needed for the given confidence, with an inlier
+ * ratio w and an SPRT which rejects good models with probability 1/A */
+size_t required_iterations(
+	const double confidence, const double w, const double A)
+{
+	const double p_good = w * w * w * (A > 1 ? 1 - 1 / A : 1.0);
+	if (p_good <= 0) return std::numeric_limits<size_t>::max();
+	if (p_good >= 1) return 1;
+	const double n = std::log(1 - confidence) / std::log(1 - p_good);
+	return n >= 1e9 ? std::numeric_limits<size_t>::max() : size_t(n) + 1;
+}
+}  // namespace
+
+CPnPRansac::TOptions::TOptions()
+	: max_reproj_error(2.0),
+	  confidence(0.99),
+	  max_iterations(1000),
+	  min_inliers(6),
+	  local_optimization(true),
+	  lo_iterations(5),
+	  use_sprt(true),
+	  sprt_epsilon(0.1),
+	  sprt_delta(0.01),
+	  num_threads(0),
+	  seed(1)
+{
+}
+
+CPnPRansac::TResult::TResult()
+	: success(false),
+	  R(Eigen::Matrix3d::Identity()),
+	  t(Eigen::Vector3d::Zero()),
+	  rms_reproj_error(0),
+	  num_hypotheses(0),
+	  num_models(0),
+	  num_sprt_rejected(0),
+	  num_local_opt(0),
+	  time_total(0),
+	  time_hypotheses(0),
+	  time_local_opt(0),
+	  time_refine(0)
+{
+}
+
+bool CPnPRansac::solve(
+	const Eigen::Ref<const Eigen::MatrixXd>& obj_pts,
+	const Eigen::Ref<const Eigen::MatrixXd>& img_pts,
+	const Eigen::Matrix3d& cam_intrinsic, TResult& result) const
+{
+	MRPT_START
+	const TOptions& o = options;
+	ASSERT_(obj_pts.rows() == 3)
+	ASSERT_(img_pts.rows() == 2 || img_pts.rows() == 3)
+	ASSERT_(obj_pts.cols() == img_pts.cols())
+	ASSERT_(o.confidence > 0 && o.confidence < 1)
+	ASSERT_(o.sprt_delta > 0 && o.sprt_delta < o.sprt_epsilon)
+	ASSERT_(o.sprt_epsilon < 1)
+
+	CTicTac tictac, tictac_total;
+	result = TResult();
+	const size_t n = obj_pts.cols();
+	if (n < 4 || n < o.min_inliers) return false;
+
+	const double fx = cam_intrinsic(0, 0), fy = cam_intrinsic(1, 1),
+				 cx = cam_intrinsic(0, 2), cy = cam_intrinsic(1, 2);
+	const float th2 = o.max_reproj_error * o.max_reproj_error;
+
+	// Points in a random order, so the SPRT sees a random subset first:
+	TRandom rnd_perm(o.seed);
+	TPoints pts;
+	pts.index.resize(n);
+	for (size_t i = 0; i < n; i++) pts.index[i] = i;
+	for (size_t i = n - 1; i > 0; i--)
+		std::swap(pts.index[i], pts.index[rnd_perm() % (i + 1)]);
+	pts.X.resize(n);
+	pts.Y.resize(n);
+	pts.Z.resize(n);
+	pts.u.resize(n);
+	pts.v.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		const size_t j = pts.index[i];
+		pts.X[i] = obj_pts(0, j);
+		pts.Y[i] = obj_pts(1, j);
+		pts.Z[i] = obj_pts(2, j);
+		pts.u[i] = img_pts(0, j) - cx;
+		pts.v[i] = img_pts(1, j) - cy;
+	}
+	pts.fx = fx;
+	pts.fy = fy;
+	pts.obj_pts = &obj_pts;
+	pts.img_pts = &img_pts;
+	pts.K = cam_intrinsic;
+
+	TSPRT sprt;
+	sprt.update(o.sprt_epsilon, o.sprt_delta);
+	double sum_rejected_consistency = 0;
+
+	TModel best_model;
+	size_t best_inliers = 0;
+	size_t needed_iterations = o.max_iterations;
+
+	struct THypothesis
+	{
+		TModel models[4];
+		TScore scores[4];
+		int num_models;
+	};
+	std::vector<THypothesis> round(HYPOTHESES_PER_ROUND);
+
+	while (result.num_hypotheses < needed_iterations)
+	{
+		// Generate and score a round of hypotheses in parallel:
+		tictac.Tic();
+		const size_t h0 = result.num_hypotheses;
+		const size_t num_hyps = std::min<size_t>(
+			HYPOTHESES_PER_ROUND, needed_iterations - h0);
+		const size_t num_jobs =
+			(num_hyps + HYPOTHESES_PER_JOB - 1) / HYPOTHESES_PER_JOB;
+		const TSPRT* round_sprt = o.use_sprt ? &sprt : nullptr;
+		mrpt::utils::parallel_for_jobs(
+			num_jobs, o.num_threads, [&](const size_t j) {
+				mrpt::vision::pnp::p3p solver(fx, fy, cx, cy);
+				const size_t k1 =
+					std::min(num_hyps, (j + 1) * HYPOTHESES_PER_JOB);
+				for (size_t k = j * HYPOTHESES_PER_JOB; k < k1; k++)
+				{
+					THypothesis& hyp = round[k];
+					TRandom rnd(
+						o.seed ^ ((h0 + k + 1) * 0xD1B54A32D192ED03ULL));
+					size_t s[3];
+					s[0] = rnd() % n;
+					do
+						s[1] = rnd() % n;
+					while (s[1] == s[0]);
+					do
+						s[2] = rnd() % n;
+					while (s[2] == s[0] || s[2] == s[1]);
+
+					double Rs[4][3][3], ts[4][3];
+					hyp.num_models = solver.solve(
+						Rs, ts, pts.u[s[0]] + cx, pts.v[s[0]] + cy,
+						pts.X[s[0]], pts.Y[s[0]], pts.Z[s[0]],
+						pts.u[s[1]] + cx, pts.v[s[1]] + cy, pts.X[s[1]],
+						pts.Y[s[1]], pts.Z[s[1]], pts.u[s[2]] + cx,
+						pts.v[s[2]] + cy, pts.X[s[2]], pts.Y[s[2]],
+						pts.Z[s[2]]);
+					for (int i = 0; i < hyp.num_models; i++)
+					{
+						TModel& m = hyp.models[i];
+						for (int r = 0; r < 3; r++)
+						{
+							for (int c = 0; c < 3; c++) m.R(r, c) = Rs[i][r][c];
+							m.t[r] = ts[i][r];
+						}
+						hyp.scores[i] = m.R.allFinite() && m.t.allFinite()
+											? score_model(
+												  pts, m, th2, round_sprt)
+											: TScore{0, 0, false};
+					}
+				}
+			});
+		result.num_hypotheses += num_hyps;
+		result.time_hypotheses += tictac.Tac();
+
+		// Best model of the round (the first one, on ties):
+		const TModel* round_best = nullptr;
+		size_t round_best_inliers = 0;
+		for (size_t k = 0; k < num_hyps; k++)
+			for (int i = 0; i < round[k].num_models; i++)
+			{
+				const TScore& s = round[k].scores[i];
+				result.num_models++;
+				if (s.rejected)
+				{
+					result.num_sprt_rejected++;
+					sum_rejected_consistency += double(s.inliers) / s.evaluated;
+				}
+				else if (s.inliers > round_best_inliers)
+				{
+					round_best = &round[k].models[i];
+					round_best_inliers = s.inliers;
+				}
+			}
+		if (round_best && round_best_inliers > best_inliers)
+		{
+			best_model = *round_best;
+			best_inliers = round_best_inliers;
+			if (o.local_optimization && best_inliers >= 4)
+			{
+				tictac.Tic();
+				best_inliers = std::max(
+					best_inliers,
+					local_optimization(
+						pts, best_model, th2, o.lo_iterations));
+				result.num_local_opt++;
+				result.time_local_opt += tictac.Tac();
+			}
+		}
+
+		// Adapt the SPRT to the current estimates (Chum & Matas, sec. 3.2)
+		if (o.use_sprt)
+		{
+			const double eps =
+				best_inliers ? double(best_inliers) / n : o.sprt_epsilon;
+			double dlt = o.sprt_delta;
+			if (result.num_sprt_rejected > 0)
+				dlt = sum_rejected_consistency / result.num_sprt_rejected;
+			dlt = std::min(std::max(dlt, 1e-4), 0.5 * eps);
+			if (eps < 1) sprt.update(eps, dlt);
+		}
+		if (best_inliers > 0)
+			needed_iterations = std::min<size_t>(
+				o.max_iterations,
+				required_iterations(
+					o.confidence, double(best_inliers) / n,
+					o.use_sprt ? sprt.A() : 0));
+	}
+
+	if (best_inliers < std::max<size_t>(o.min_inliers, 4))
+	{
+		result.time_total = tictac_total.Tac();
+		return false;
+	}
+
+	// Final refinement with all the inliers:
+	tictac.Tic();
+	std::vector<size_t> idxs;
+	get_inliers(pts, best_model, th2, idxs);
+	TModel refined = best_model;
+	refine_model(pts, idxs, refined, 2 * LO_GAUSS_NEWTON_ITERS);
+	std::vector<size_t> refined_idxs;
+	get_inliers(pts, refined, th2, refined_idxs);
+	if (refined_idxs.size() >= idxs.size())
+	{
+		best_model = refined;
+		idxs.swap(refined_idxs);
+	}
+
+	double sum_err2 = 0;
+	for (const size_t i : idxs)
+	{
+		const Eigen::Vector3d Xc =
+			best_model.R * pts.objPoint(i) + best_model.t;
+		sum_err2 += (Eigen::Vector2d(fx * Xc.x(), fy * Xc.y()) / Xc.z() -
+					 pts.imgPoint(i))
+						.squaredNorm();
+	}
+	result.rms_reproj_error =
+		idxs.empty() ? 0 : std::sqrt(sum_err2 / idxs.size());
+	result.inliers.resize(idxs.size());
+	for (size_t i = 0; i < idxs.size(); i++)
+		result.inliers[i] = pts.index[idxs[i]];
+	std::sort(result.inliers.begin(), result.inliers.end());
+
+	result.R = best_model.R;
+	result.t = best_model.t;
+	result.success = result.inliers.size() >= o.min_inliers;
+	result.time_refine = tictac.Tac();
+	result.time_total = tictac_total.Tac();
+	return result.success;
+	MRPT_END
+}
+
+void CPnPRansac::solveBatch(
+	const std::vector<Eigen::MatrixXd>& obj_pts,
+	const std::vector<Eigen::MatrixXd>& img_pts,
+	const Eigen::Matrix3d& cam_intrinsic,
+	std::vector<TResult>& results) const
+{
+	MRPT_START
+	ASSERT_(obj_pts.size() == img_pts.size())
+	results.resize(obj_pts.size());
+
+	// One problem per job, each one solved in one thread:
+	CPnPRansac single = *this;
+	single.options.num_threads = 1;
+	mrpt::utils::parallel_for_jobs(
+		obj_pts.size(), options.num_threads, [&](const size_t i) {
+			single.solve(obj_pts[i], img_pts[i], cam_intrinsic, results[i]);
+		});
+	MRPT_END
+}
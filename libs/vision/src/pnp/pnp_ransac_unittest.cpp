@@ -0,0 +1,131 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#include <mrpt/utils/types_math.h>
+#include <mrpt/vision/pnp_algos.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace mrpt::vision::pnp;
+using namespace mrpt::random;
+
+class CPnPRansacTest : public ::testing::Test
+{
+   public:
+	Eigen::Matrix3d K, R;
+	Eigen::Vector3d t;
+
+	virtual void SetUp()
+	{
+		K << 500, 0, 320, 0, 510, 240, 0, 0, 1;
+		R = Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, -1).normalized())
+				.toRotationMatrix();
+		t << 0.5, -0.2, 4.0;
+	}
+
+	/** n correspondences, the first n_outliers of them wrong */
+	void createProblem(
+		const size_t n, const size_t n_outliers, const unsigned int seed,
+		Eigen::MatrixXd& obj_pts, Eigen::MatrixXd& img_pts,
+		const double pixel_noise = 0.3)
+	{
+		randomGenerator.randomize(seed);
+		obj_pts.resize(3, n);
+		img_pts.resize(3, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			// Points in front of the camera:
+			const Eigen::Vector3d pc(
+				randomGenerator.drawUniform(-2, 2),
+				randomGenerator.drawUniform(-1.5, 1.5),
+				randomGenerator.drawUniform(3, 8));
+			obj_pts.col(i) = R.transpose() * (pc - t);
+			const Eigen::Vector3d px = K * pc;
+			img_pts.col(i) << px.x() / px.z() +
+								  randomGenerator.drawGaussian1D(0, pixel_noise),
+				px.y() / px.z() +
+					randomGenerator.drawGaussian1D(0, pixel_noise),
+				1;
+			if (i < n_outliers)
+				img_pts.col(i).head<2>() << randomGenerator.drawUniform(0, 640),
+					randomGenerator.drawUniform(0, 480);
+		}
+	}
+};
+
+TEST_F(CPnPRansacTest, OutliersAreRejected)
+{
+	const size_t n = 300, n_outliers = 150;
+	Eigen::MatrixXd obj_pts, img_pts;
+	createProblem(n, n_outliers, 1, obj_pts, img_pts);
+
+	CPnPRansac ransac;
+	ransac.options.num_threads = 1;
+	CPnPRansac::TResult res;
+	ASSERT_TRUE(ransac.solve(obj_pts, img_pts, K, res));
+
+	EXPECT_LT((res.t - t).norm(), 0.05);
+	EXPECT_LT((res.R - R).norm(), 0.01);
+	EXPECT_LT(res.rms_reproj_error, 1.0);
+	// All the good points, and (almost) none of the outliers:
+	size_t num_good = 0;
+	for (const size_t i : res.inliers) num_good += (i >= n_outliers);
+	EXPECT_GT(num_good, 0.97 * (n - n_outliers));
+	EXPECT_LT(res.inliers.size() - num_good, 5u);
+	EXPECT_TRUE(std::is_sorted(res.inliers.begin(), res.inliers.end()));
+	EXPECT_LE(res.num_hypotheses, ransac.options.max_iterations);
+
+	// Not enough inliers:
+	ransac.options.min_inliers = n;
+	EXPECT_FALSE(ransac.solve(obj_pts, img_pts, K, res));
+}
+
+TEST_F(CPnPRansacTest, ExactRefinementWithoutNoise)
+{
+	Eigen::MatrixXd obj_pts, img_pts;
+	createProblem(200, 50, 7, obj_pts, img_pts, 0);
+
+	CPnPRansac ransac;
+	CPnPRansac::TResult res;
+	ASSERT_TRUE(ransac.solve(obj_pts, img_pts, K, res));
+	// The final refinement works on the input (in double), not on the
+	// float copies used to score the hypotheses:
+	EXPECT_LT(res.rms_reproj_error, 1e-6);
+	EXPECT_LT((res.t - t).norm(), 1e-8);
+	EXPECT_LT((res.R - R).norm(), 1e-8);
+}
+
+TEST_F(CPnPRansacTest, SameResultsWithThreadsAndBatches)
+{
+	std::vector<Eigen::MatrixXd> obj_pts(5), img_pts(5);
+	for (unsigned int i = 0; i < obj_pts.size(); i++)
+		createProblem(100 + 50 * i, 20 * i, i + 2, obj_pts[i], img_pts[i]);
+
+	CPnPRansac ransac;
+	std::vector<CPnPRansac::TResult> batch;
+	ransac.options.num_threads = 3;
+	ransac.solveBatch(obj_pts, img_pts, K, batch);
+	ASSERT_EQ(batch.size(), obj_pts.size());
+
+	for (unsigned int i = 0; i < obj_pts.size(); i++)
+	{
+		CPnPRansac::TResult res1, res4;
+		ransac.options.num_threads = 1;
+		ransac.solve(obj_pts[i], img_pts[i], K, res1);
+		ransac.options.num_threads = 4;
+		ransac.solve(obj_pts[i], img_pts[i], K, res4);
+
+		EXPECT_TRUE(res1.success);
+		EXPECT_TRUE(res1.R == res4.R && res1.t == res4.t);
+		EXPECT_TRUE(res1.R == batch[i].R && res1.t == batch[i].t);
+		EXPECT_TRUE(res1.inliers == res4.inliers);
+		EXPECT_TRUE(res1.inliers == batch[i].inliers);
+		EXPECT_EQ(res1.num_hypotheses, batch[i].num_hypotheses);
+	}
+}
@@ -9,29 +9,422 @@
 
 #include "vision-precomp.h"  // Precompiled headers
 
-#include <mrpt/system/memory.h>
 #include <mrpt/vision/tracking.h>
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/utils/SSE_types.h>
+#include <mrpt/utils/parallel.h>
+#include <cstring>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
 
-#if HAVE_ALLOCA_H
-#include <alloca.h>
-#endif
-
 using namespace mrpt;
 using namespace mrpt::vision;
 using namespace mrpt::utils;
 using namespace std;
 
+#if MRPT_HAS_OPENCV
+namespace
+{
+/** Features tracked by each thread at a time */
+const size_t FEATURES_PER_BATCH = 32;
+
+#if MRPT_HAS_AVX2
+inline __m256 load8_ps(const uint8_t* p)
+{
+	return _mm256_cvtepi32_ps(
+		_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p)));
+}
+inline __m256 load8_ps(const int16_t* p)
+{
+	return _mm256_cvtepi32_ps(
+		_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p)));
+}
+inline float horizontal_sum(const __m256 v)
+{
+	const __m128 s =
+		_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	const __m128 s2 = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	return _mm_cvtss_f32(_mm_add_ss(s2, _mm_shuffle_ps(s2, s2, 1)));
+}
+#endif
+#if MRPT_HAS_SSE2
+inline __m128 load4_ps(const uint8_t* p)
+{
+	int32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	const __m128i zeros = _mm_setzero_si128();
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(
+		_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zeros), zeros));
+}
+inline __m128 load4_ps(const int16_t* p)
+{
+	const __m128i v = _mm_loadl_epi64((const __m128i*)p);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+inline float horizontal_sum(const __m128 v)
+{
+	const __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+#endif
+
+/** Bilinear interpolation of n consecutive pixels of a row, all of them with
+ * the same weights \a w for their 4 neighbors:
+ * out[i] = w[0]*r0[i] + w[1]*r0[i+1] + w[2]*r1[i] + w[3]*r1[i+1] */
+template <typename T>
+void bilinearRow(
+	const T* r0, const T* r1, const int n, const float* w, float* out)
+{
+	int i = 0;
+#if MRPT_HAS_AVX2
+	{
+		const __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]),
+					 w2 = _mm256_set1_ps(w[2]), w3 = _mm256_set1_ps(w[3]);
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256 v = _mm256_mul_ps(w0, load8_ps(r0 + i));
+			v = _mm256_add_ps(v, _mm256_mul_ps(w1, load8_ps(r0 + i + 1)));
+			v = _mm256_add_ps(v, _mm256_mul_ps(w2, load8_ps(r1 + i)));
+			v = _mm256_add_ps(v, _mm256_mul_ps(w3, load8_ps(r1 + i + 1)));
+			_mm256_storeu_ps(out + i, v);
+		}
+	}
+#endif
+#if MRPT_HAS_SSE2
+	{
+		const __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]),
+					 w2 = _mm_set1_ps(w[2]), w3 = _mm_set1_ps(w[3]);
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 v = _mm_mul_ps(w0, load4_ps(r0 + i));
+			v = _mm_add_ps(v, _mm_mul_ps(w1, load4_ps(r0 + i + 1)));
+			v = _mm_add_ps(v, _mm_mul_ps(w2, load4_ps(r1 + i)));
+			v = _mm_add_ps(v, _mm_mul_ps(w3, load4_ps(r1 + i + 1)));
+			_mm_storeu_ps(out + i, v);
+		}
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = w[0] * r0[i] + w[1] * r0[i + 1] + w[2] * r1[i] +
+				 w[3] * r1[i + 1];
+}
+
+/** The Gauss-Newton vector: bx=sum((I-J)*Ix), by=sum((I-J)*Iy) */
+void mismatchVector(
+	const float* I, const float* J, const float* Ix, const float* Iy,
+	const int n, float& bx, float& by)
+{
+	int i = 0;
+	bx = by = 0;
+#if MRPT_HAS_AVX2
+	{
+		__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps();
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256 d = _mm256_sub_ps(
+				_mm256_loadu_ps(I + i), _mm256_loadu_ps(J + i));
+			sx = _mm256_add_ps(sx, _mm256_mul_ps(d, _mm256_loadu_ps(Ix + i)));
+			sy = _mm256_add_ps(sy, _mm256_mul_ps(d, _mm256_loadu_ps(Iy + i)));
+		}
+		bx += horizontal_sum(sx);
+		by += horizontal_sum(sy);
+	}
+#endif
+#if MRPT_HAS_SSE2
+	{
+		__m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps();
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128 d =
+				_mm_sub_ps(_mm_loadu_ps(I + i), _mm_loadu_ps(J + i));
+			sx = _mm_add_ps(sx, _mm_mul_ps(d, _mm_loadu_ps(Ix + i)));
+			sy = _mm_add_ps(sy, _mm_mul_ps(d, _mm_loadu_ps(Iy + i)));
+		}
+		bx += horizontal_sum(sx);
+		by += horizontal_sum(sy);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		const float d = I[i] - J[i];
+		bx += d * Ix[i];
+		by += d * Iy[i];
+	}
+}
+
+/** Parameters of the tracking of each feature */
+struct TKLTParams
+{
+	int half_w, half_h;
+	unsigned int max_iters;
+	float epsilon;
+	float min_eigenvalue;
+	float max_error;
+};
+
+/** Working memory of one thread: the window in the old image (I) and its
+ * gradients (Ix, Iy), and the window in the new image (J) */
+struct TKLTBuffers
+{
+	std::vector<float> I, Ix, Iy, J;
+};
+
+/** Bilinear sampling of the window of size (2*half_w+1)x(2*half_h+1)
+ * centered at (x,y), from the image (and its gradients, if \a Ix is not
+ * null). Returns false if the window is not fully inside the level. */
+bool sampleWindow(
+	const TKLTPyramid::TLevel& lev, const float x, const float y,
+	const TKLTParams& p, float* I, float* Ix, float* Iy)
+{
+	if (!(x >= p.half_w && y >= p.half_h && x < lev.width - p.half_w - 1 &&
+		  y < lev.height - p.half_h - 1))
+		return false;
+
+	const int ix = static_cast<int>(x), iy = static_cast<int>(y);
+	const float a = x - ix, b = y - iy;
+	const float w[4] = {(1 - a) * (1 - b), a * (1 - b), (1 - a) * b, a * b};
+	// Gradients are 32 times the actual change of intensity:
+	const float wg[4] = {w[0] / 32, w[1] / 32, w[2] / 32, w[3] / 32};
+
+	const int win_w = 2 * p.half_w + 1, win_h = 2 * p.half_h + 1;
+	const size_t first = lev.width * (iy - p.half_h) + ix - p.half_w;
+	for (int r = 0; r < win_h; r++)
+	{
+		const size_t idx = first + r * lev.width;
+		bilinearRow(
+			&lev.img[idx], &lev.img[idx + lev.width], win_w, w, I + r * win_w);
+		if (!Ix) continue;
+		bilinearRow(
+			&lev.grad_x[idx], &lev.grad_x[idx + lev.width], win_w, wg,
+			Ix + r * win_w);
+		bilinearRow(
+			&lev.grad_y[idx], &lev.grad_y[idx + lev.width], win_w, wg,
+			Iy + r * win_w);
+	}
+	return true;
+}
+
+/** Pyramidal Lucas-Kanade tracking of one point (J.Y. Bouguet, "Pyramidal
+ * implementation of the Lucas Kanade feature tracker"). Returns the status of
+ * the feature, and its new coordinates in (out_x,out_y) if it was tracked. */
+TFeatureTrackStatus trackPoint(
+	const TKLTPyramid& prev, const TKLTPyramid& cur, const float x,
+	const float y, const TKLTParams& p, TKLTBuffers& buf, float& out_x,
+	float& out_y, CFeatureTracker_KL::TTrackingStats& stats)
+{
+	const int N = (2 * p.half_w + 1) * (2 * p.half_h + 1);
+	buf.I.resize(N);
+	buf.Ix.resize(N);
+	buf.Iy.resize(N);
+	buf.J.resize(N);
+
+	// Displacement guessed from the coarser levels, in the current level:
+	float gx = 0, gy = 0;
+	for (int L = int(prev.levels.size()) - 1; L >= 0; L--)
+	{
+		const float scale = 1.0f / (1 << L);
+		const float ux = x * scale, uy = y * scale;
+		float dx = 0, dy = 0;
+
+		if (sampleWindow(
+				prev.levels[L], ux, uy, p, &buf.I[0], &buf.Ix[0], &buf.Iy[0]))
+		{
+			float Gxx = 0, Gxy = 0, Gyy = 0;
+			for (int i = 0; i < N; i++)
+			{
+				Gxx += buf.Ix[i] * buf.Ix[i];
+				Gxy += buf.Ix[i] * buf.Iy[i];
+				Gyy += buf.Iy[i] * buf.Iy[i];
+			}
+			const float det = Gxx * Gyy - Gxy * Gxy;
+			const float min_eig =
+				(Gxx + Gyy -
+				 std::sqrt((Gxx - Gyy) * (Gxx - Gyy) + 4 * Gxy * Gxy)) /
+				(2 * N);
+			if (L == 0) stats.min_eigenvalue = min_eig;
+
+			if (min_eig >= p.min_eigenvalue && det > 1e-6f)
+			{
+				for (unsigned int it = 0; it < p.max_iters; it++)
+				{
+					if (!sampleWindow(
+							cur.levels[L], ux + gx + dx, uy + gy + dy, p,
+							&buf.J[0], nullptr, nullptr))
+					{
+						if (L == 0) return status_OOB;
+						break;
+					}
+					stats.iterations++;
+
+					float bx, by;
+					mismatchVector(
+						&buf.I[0], &buf.J[0], &buf.Ix[0], &buf.Iy[0], N, bx,
+						by);
+					const float step_x = (Gyy * bx - Gxy * by) / det;
+					const float step_y = (Gxx * by - Gxy * bx) / det;
+					dx += step_x;
+					dy += step_y;
+					if (step_x * step_x + step_y * step_y <=
+						p.epsilon * p.epsilon)
+					{
+						if (L == 0) stats.converged = true;
+						break;
+					}
+				}
+			}
+			else if (L == 0)
+				return status_LOST;  // Not trackable
+		}
+		else if (L == 0)
+			return status_OOB;
+
+		if (L > 0)
+		{
+			gx = 2 * (gx + dx);
+			gy = 2 * (gy + dy);
+		}
+		else
+		{
+			out_x = x + gx + dx;
+			out_y = y + gy + dy;
+		}
+	}
+
+	// Residual at the final position:
+	if (!sampleWindow(
+			cur.levels[0], out_x, out_y, p, &buf.J[0], nullptr, nullptr))
+		return status_OOB;
+	float sum_abs_diff = 0;
+	for (int i = 0; i < N; i++) sum_abs_diff += std::abs(buf.I[i] - buf.J[i]);
+	stats.residual = sum_abs_diff / N;
+
+	return stats.residual > p.max_error ? status_LOST : status_TRACKED;
+}
+}  // namespace
+#endif
+
+/*-------------------------------------------------------------
+						TKLTPyramid
+-------------------------------------------------------------*/
+size_t TKLTPyramid::numLevelsFor(
+	const int width, const int height, const size_t nLevels)
+{
+	size_t n = 1;
+	for (int w = (width + 1) / 2, h = (height + 1) / 2;
+		 n < nLevels && w >= MIN_LEVEL_SIZE && h >= MIN_LEVEL_SIZE;
+		 w = (w + 1) / 2, h = (h + 1) / 2)
+		n++;
+	return n;
+}
+
+void TKLTPyramid::build(
+	const uint8_t* data, const int width, const int height, const int stride,
+	const size_t nLevels)
+{
+	ASSERT_(width > 0 && height > 0 && stride >= width)
+	levels.resize(numLevelsFor(width, height, nLevels));
+
+	TLevel& lev0 = levels[0];
+	lev0.width = width;
+	lev0.height = height;
+	lev0.img.resize(size_t(width) * height);
+	for (int y = 0; y < height; y++)
+		std::memcpy(&lev0.img[size_t(width) * y], data + stride * y, width);
+
+	// Each level: 5x5 binomial filter of the previous one, taking every other
+	// pixel (as cv::pyrDown), replicating the border pixels.
+	std::vector<int> col_sums;
+	for (size_t l = 1; l < levels.size(); l++)
+	{
+		const TLevel& src = levels[l - 1];
+		TLevel& dst = levels[l];
+		dst.width = (src.width + 1) / 2;
+		dst.height = (src.height + 1) / 2;
+		dst.img.resize(size_t(dst.width) * dst.height);
+		col_sums.resize(src.width);
+
+		for (int y = 0; y < dst.height; y++)
+		{
+			const uint8_t* r[5];
+			for (int k = 0; k < 5; k++)
+				r[k] = &src.img[size_t(src.width) *
+								std::min(std::max(2 * y + k - 2, 0),
+										 src.height - 1)];
+			for (int x = 0; x < src.width; x++)
+				col_sums[x] =
+					r[0][x] + 4 * (r[1][x] + r[3][x]) + 6 * r[2][x] + r[4][x];
+
+			uint8_t* out = &dst.img[size_t(dst.width) * y];
+			const int last = src.width - 1;
+			for (int x = 0; x < dst.width; x++)
+			{
+				const int c = 2 * x;
+				const int s = col_sums[std::max(c - 2, 0)] +
+							  4 * (col_sums[std::max(c - 1, 0)] +
+								   col_sums[std::min(c + 1, last)]) +
+							  6 * col_sums[c] + col_sums[std::min(c + 2, last)];
+				out[x] = static_cast<uint8_t>((s + 128) >> 8);
+			}
+		}
+	}
+
+	for (auto& lev : levels)
+	{
+		lev.grad_x.clear();
+		lev.grad_y.clear();
+	}
+}
+
+bool TKLTPyramid::isBuiltFrom(
+	const uint8_t* data, const int width, const int height, const int stride,
+	const size_t nLevels) const
+{
+	if (levels.empty() || levels[0].width != width ||
+		levels[0].height != height ||
+		levels.size() != numLevelsFor(width, height, nLevels))
+		return false;
+	for (int y = 0; y < height; y++)
+		if (std::memcmp(
+				&levels[0].img[size_t(width) * y], data + stride * y, width))
+			return false;
+	return true;
+}
+
+void TKLTPyramid::computeGradients()
+{
+	if (hasGradients()) return;
+	for (auto& lev : levels)
+	{
+		const int w = lev.width, h = lev.height;
+		lev.grad_x.resize(size_t(w) * h);
+		lev.grad_y.resize(size_t(w) * h);
+		for (int y = 0; y < h; y++)
+		{
+			// Scharr operator, replicating the border pixels:
+			const uint8_t* r0 = &lev.img[size_t(w) * std::max(y - 1, 0)];
+			const uint8_t* r1 = &lev.img[size_t(w) * y];
+			const uint8_t* r2 = &lev.img[size_t(w) * std::min(y + 1, h - 1)];
+			int16_t* gx = &lev.grad_x[size_t(w) * y];
+			int16_t* gy = &lev.grad_y[size_t(w) * y];
+			for (int x = 0; x < w; x++)
+			{
+				const int xl = std::max(x - 1, 0), xr = std::min(x + 1, w - 1);
+				gx[x] = static_cast<int16_t>(
+					3 * (r0[xr] - r0[xl] + r2[xr] - r2[xl]) +
+					10 * (r1[xr] - r1[xl]));
+				gy[x] = static_cast<int16_t>(
+					3 * (r2[xl] - r0[xl] + r2[xr] - r0[xr]) +
+					10 * (r2[x] - r0[x]));
+			}
+		}
+	}
+}
+
 /** Track a set of features from old_img -> new_img using sparse optimal flow
   *(classic KL method)
-  *  Optional parameters that can be passed in "extra_params":
-  *		- "window_width"  (Default=15)
-  *		- "window_height" (Default=15)
-  *
-  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
+  *  Optional parameters that can be passed in "extra_params": see the
+  *documentation of CFeatureTracker_KL.
   */
 template <typename FEATLIST>
 void CFeatureTracker_KL::trackFeatures_impl_templ(
@@ -47,9 +440,14 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 
 	const int LK_levels = extra_params.getWithDefaultVal("LK_levels", 3);
 	const int LK_max_iters = extra_params.getWithDefaultVal("LK_max_iters", 10);
-	const int LK_epsilon = extra_params.getWithDefaultVal("LK_epsilon", 0.1);
+	const double LK_epsilon = extra_params.getWithDefaultVal("LK_epsilon", 0.1);
 	const float LK_max_tracking_error =
 		extra_params.getWithDefaultVal("LK_max_tracking_error", 150.0f);
+	const float LK_min_eigenvalue =
+		extra_params.getWithDefaultVal("LK_min_eigenvalue", 0.0f);
+	const size_t num_threads = extra_params.getWithDefaultVal("num_threads", 0);
+
+	ASSERT_(window_width > 0 && window_height > 0 && LK_levels >= 0)
 
 	// Both images must be of the same size
 	ASSERT_(
@@ -60,87 +458,90 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 	const size_t img_height = old_img.getHeight();
 
 	const size_t nFeatures = featureList.size();  // Number of features
+	last_tracking_stats.assign(nFeatures, TTrackingStats());
+	if (!nFeatures) return;
 
 	// Grayscale images
 	const CImage prev_gray(old_img, FAST_REF_OR_CONVERT_TO_GRAY);
 	const CImage cur_gray(new_img, FAST_REF_OR_CONVERT_TO_GRAY);
+	const IplImage* prev_ipl = prev_gray.getAs<IplImage>();
+	const IplImage* cur_ipl = cur_gray.getAs<IplImage>();
+	const uint8_t* prev_data =
+		reinterpret_cast<const uint8_t*>(prev_ipl->imageData);
+	const uint8_t* cur_data =
+		reinterpret_cast<const uint8_t*>(cur_ipl->imageData);
 
-	// Array conversion MRPT->OpenCV
-	if (nFeatures > 0)
-	{
-		CvPoint2D32f* points[2];
-
-		points[0] = reinterpret_cast<CvPoint2D32f*>(
-			mrpt_alloca(sizeof(CvPoint2D32f) * nFeatures));
-		points[1] = reinterpret_cast<CvPoint2D32f*>(
-			mrpt_alloca(sizeof(CvPoint2D32f) * nFeatures));
-
-		std::vector<char> status(nFeatures);
-
-		for (size_t i = 0; i < nFeatures; ++i)
-		{
-			points[0][i].x = featureList.getFeatureX(i);
-			points[0][i].y = featureList.getFeatureY(i);
-		}  // end for
-
-		// local scope for auxiliary variables around cvCalcOpticalFlowPyrLK()
-		const IplImage* prev_gray_ipl = prev_gray.getAs<IplImage>();
-		const IplImage* cur_gray_ipl = cur_gray.getAs<IplImage>();
+	// Pyramids: the new image of the last call is usually the old one now.
+	m_timlog.enter("[CFeatureTracker_KL] build pyramids");
+	const size_t nLevels = LK_levels + 1;
+	if (m_cur_pyramid.isBuiltFrom(
+			prev_data, img_width, img_height, prev_ipl->widthStep, nLevels))
+		std::swap(m_prev_pyramid, m_cur_pyramid);
+	else if (!m_prev_pyramid.isBuiltFrom(
+				 prev_data, img_width, img_height, prev_ipl->widthStep,
+				 nLevels))
+		m_prev_pyramid.build(
+			prev_data, img_width, img_height, prev_ipl->widthStep, nLevels);
+	m_prev_pyramid.computeGradients();
+	if (!m_cur_pyramid.isBuiltFrom(
+			cur_data, img_width, img_height, cur_ipl->widthStep, nLevels))
+		m_cur_pyramid.build(
+			cur_data, img_width, img_height, cur_ipl->widthStep, nLevels);
+	m_timlog.leave("[CFeatureTracker_KL] build pyramids");
 
-		// Pyramids
-		// JL: It seems that cache'ing the pyramids of previous images doesn't
-		// really improve the efficiency (!?!?)
-		IplImage* pPyr = nullptr;
-		IplImage* cPyr = nullptr;
+	TKLTParams params;
+	params.half_w = window_width / 2;
+	params.half_h = window_height / 2;
+	params.max_iters = LK_max_iters;
+	params.epsilon = LK_epsilon;
+	params.min_eigenvalue = LK_min_eigenvalue;
+	params.max_error = LK_max_tracking_error;
 
-		int flags = 0;
+	std::vector<float> new_x(nFeatures), new_y(nFeatures);
+	std::vector<TFeatureTrackStatus> status(nFeatures);
 
-		float* track_error =
-			reinterpret_cast<float*>(mrpt_alloca(sizeof(float) * nFeatures));
+	m_timlog.enter("[CFeatureTracker_KL] track features");
+	const size_t nBatches =
+		(nFeatures + FEATURES_PER_BATCH - 1) / FEATURES_PER_BATCH;
+	mrpt::utils::parallel_for_jobs(
+		nBatches, num_threads, [&](const size_t batch) {
+			TKLTBuffers buf;
+			const size_t last =
+				std::min(nFeatures, (batch + 1) * FEATURES_PER_BATCH);
+			for (size_t i = batch * FEATURES_PER_BATCH; i < last; i++)
+				status[i] = trackPoint(
+					m_prev_pyramid, m_cur_pyramid, featureList.getFeatureX(i),
+					featureList.getFeatureY(i), params, buf, new_x[i],
+					new_y[i], last_tracking_stats[i]);
+		});
+	m_timlog.leave("[CFeatureTracker_KL] track features");
 
-		cvCalcOpticalFlowPyrLK(
-			prev_gray_ipl, cur_gray_ipl, pPyr, cPyr, &points[0][0],
-			&points[1][0], nFeatures, cvSize(window_width, window_height),
-			LK_levels, &status[0], track_error,
-			cvTermCriteria(
-				CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, LK_max_iters, LK_epsilon),
-			flags);
-
-		cvReleaseImage(&pPyr);
-		cvReleaseImage(&cPyr);
-
-		for (size_t i = 0; i < nFeatures; ++i)
+	for (size_t i = 0; i < nFeatures; ++i)
+	{
+		if (status[i] == status_TRACKED && new_x[i] > 0 && new_y[i] > 0 &&
+			new_x[i] < img_width && new_y[i] < img_height)
+		{
+			// Feature could be tracked
+			featureList.setFeatureXf(i, new_x[i]);
+			featureList.setFeatureYf(i, new_y[i]);
+			featureList.setTrackStatus(i, status_TRACKED);
+		}  // end if
+		else  // Feature could not be tracked
 		{
-			const bool trck_err_too_large =
-				track_error[i] > LK_max_tracking_error;
+			featureList.setFeatureX(i, -1);
+			featureList.setFeatureY(i, -1);
+			featureList.setTrackStatus(
+				i, status[i] == status_LOST ? status_LOST : status_OOB);
+		}  // end else
+	}  // end for
 
-			if (status[i] == 1 && !trck_err_too_large && points[1][i].x > 0 &&
-				points[1][i].y > 0 && points[1][i].x < img_width &&
-				points[1][i].y < img_height)
-			{
-				// Feature could be tracked
-				featureList.setFeatureXf(i, points[1][i].x);
-				featureList.setFeatureYf(i, points[1][i].y);
-				featureList.setTrackStatus(i, status_TRACKED);
-			}  // end if
-			else  // Feature could not be tracked
-			{
-				featureList.setFeatureX(i, -1);
-				featureList.setFeatureY(i, -1);
-				featureList.setTrackStatus(
-					i, trck_err_too_large ? status_LOST : status_OOB);
-			}  // end else
-		}  // end for
-
-		mrpt_alloca_free(points[0]);
-		mrpt_alloca_free(points[1]);
-		mrpt_alloca_free(track_error);
-
-		// In case it needs to rebuild a kd-tree or whatever
-		featureList.mark_as_outdated();
-	}
+	// In case it needs to rebuild a kd-tree or whatever
+	featureList.mark_as_outdated();
 
 #else
+	MRPT_UNUSED_PARAM(old_img);
+	MRPT_UNUSED_PARAM(new_img);
+	MRPT_UNUSED_PARAM(featureList);
 	THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
 #endif
 
@@ -0,0 +1,105 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2017, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/tracking.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_OPENCV  // CImage needs OpenCV
+
+// A smooth texture (sum of sinusoids), shifted by (sx,sy) pixels:
+static CImage createImage(const int w, const int h, double sx, double sy)
+{
+	CImage img(w, h, CH_GRAY);
+	for (int y = 0; y < h; y++)
+		for (int x = 0; x < w; x++)
+		{
+			const double u = x - sx, v = y - sy;
+			const double val = 128 + 40 * sin(0.11 * u + 0.07 * v) +
+							   35 * sin(0.05 * u - 0.13 * v + 1.0) +
+							   25 * cos(0.17 * u + 0.03 * v + 2.0);
+			*img(x, y) = static_cast<uint8_t>(val);
+		}
+	return img;
+}
+
+static TSimpleFeaturefList gridOfFeatures()
+{
+	TSimpleFeaturefList feats;
+	for (int y = 40; y < 200; y += 20)
+		for (int x = 40; x < 280; x += 20)
+			feats.push_back(TSimpleFeaturef(x, y));
+	return feats;
+}
+
+TEST(CFeatureTracker_KL, TrackShiftedImage)
+{
+	const double sx = 3.4, sy = -2.7;
+	const CImage img1 = createImage(320, 240, 0, 0);
+	const CImage img2 = createImage(320, 240, sx, sy);
+
+	CFeatureTracker_KL tracker;
+	tracker.extra_params["LK_epsilon"] = 0.01;
+	TSimpleFeaturefList feats = gridOfFeatures();
+	const TSimpleFeaturefList orig = feats;
+	tracker.trackFeatures(img1, img2, feats);
+
+	ASSERT_EQ(tracker.last_tracking_stats.size(), orig.size());
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		EXPECT_EQ(feats[i].track_status, status_TRACKED);
+		EXPECT_NEAR(feats[i].pt.x, orig[i].pt.x + sx, 0.2);
+		EXPECT_NEAR(feats[i].pt.y, orig[i].pt.y + sy, 0.2);
+		EXPECT_TRUE(tracker.last_tracking_stats[i].converged);
+		EXPECT_GT(tracker.last_tracking_stats[i].iterations, 0U);
+	}
+}
+
+TEST(CFeatureTracker_KL, IndependentOfThreadsAndCache)
+{
+	const CImage img1 = createImage(320, 240, 0, 0);
+	const CImage img2 = createImage(320, 240, 1.5, 2.2);
+	const CImage img3 = createImage(320, 240, 2.8, 4.1);
+
+	// Reference: fresh trackers, single thread.
+	TSimpleFeaturefList ref2 = gridOfFeatures(), ref3;
+	{
+		CFeatureTracker_KL tracker;
+		tracker.extra_params["num_threads"] = 1;
+		tracker.trackFeatures(img1, img2, ref2);
+	}
+	ref3 = ref2;
+	{
+		CFeatureTracker_KL tracker;
+		tracker.extra_params["num_threads"] = 1;
+		tracker.trackFeatures(img2, img3, ref3);
+	}
+
+	// The same tracker for both frames (the pyramid of img2 is reused):
+	CFeatureTracker_KL tracker;
+	tracker.extra_params["num_threads"] = 4;
+	TSimpleFeaturefList feats = gridOfFeatures();
+	tracker.trackFeatures(img1, img2, feats);
+	tracker.trackFeatures(img2, img3, feats);
+
+	ASSERT_EQ(feats.size(), ref3.size());
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		EXPECT_EQ(feats[i].pt.x, ref3[i].pt.x);
+		EXPECT_EQ(feats[i].pt.y, ref3[i].pt.y);
+		EXPECT_EQ(feats[i].track_status, ref3[i].track_status);
+	}
+}
+
+#endif
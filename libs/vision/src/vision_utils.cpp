@@ -13,6 +13,7 @@
 #include <mrpt/vision/pinhole.h>
 #include <mrpt/vision/CFeatureExtraction.h>
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/CCompactFeatureList.h>
 
 #include <mrpt/poses/CPoint3D.h>
 #include <mrpt/maps/CLandmarksMap.h>
@@ -21,6 +22,7 @@
 #include <mrpt/obs/CObservationBearingRange.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/utils/CTicTac.h>
+#include <mrpt/utils/parallel.h>
 #include <mrpt/math/utils.h>
 #include <mrpt/math/ops_vectors.h>
 #include <mrpt/math/lightweight_geom_data.h>
@@ -29,6 +31,12 @@
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
 
+#if MRPT_HAS_SSE2
+#include <mrpt/utils/SSE_types.h>
+#endif
+
+#include <cstring>
+
 using namespace mrpt;
 using namespace mrpt::vision;
 using namespace mrpt::utils;
@@ -454,375 +462,593 @@ void vision::normalizeImage(const CImage& image, CImage& nimage)
 /*-------------------------------------------------------------
 						matchFeatures
 -------------------------------------------------------------*/
-size_t vision::matchFeatures(
-	const CFeatureList& list1, const CFeatureList& list2,
-	CMatchedFeatureList& matches, const TMatchingOptions& options,
-	const TStereoSystemParams& params)
+namespace
 {
-	// Clear the output structure
-	MRPT_START
-	// matches.clear();
+/** Minimum number of features of the first list per thread in matchFeatures()
+ */
+const size_t MIN_FEATURES_PER_THREAD = 64;
 
-	// Preliminary comprobations
-	size_t sz1 = list1.size(), sz2 = list2.size();
+/** Squared Euclidean distance between two SIFT descriptors (exact, computed
+ * with integers) */
+uint32_t sqrDistanceSIFT(const uint8_t* a, const uint8_t* b, const size_t n)
+{
+	size_t i = 0;
+	uint32_t sum = 0;
+#if MRPT_HAS_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16)
+	{
+		const __m128i va =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i vb =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		// Differences as 16-bit integers, squared and added in pairs:
+		const __m128i dlo = _mm_sub_epi16(
+			_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+		const __m128i dhi = _mm_sub_epi16(
+			_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(dlo, dlo));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(dhi, dhi));
+	}
+	alignas(16) uint32_t lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+	for (; i < n; i++)
+	{
+		const int d = int(a[i]) - int(b[i]);
+		sum += d * d;
+	}
+	return sum;
+}
 
-	ASSERT_((sz1 > 0) && (sz2 > 0));  // Both lists have features within it
-	ASSERT_(
-		list1.get_type() ==
-		list2.get_type());  // Both lists must be of the same type
+/** Squared Euclidean distance between two SURF descriptors */
+float sqrDistanceSURF(const float* a, const float* b, const size_t n)
+{
+	size_t i = 0;
+	float sum = 0;
+#if MRPT_HAS_SSE2
+	__m128 acc = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+		acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+	}
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, acc);
+	sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+	for (; i < n; i++)
+	{
+		const float d = a[i] - b[i];
+		sum += d * d;
+	}
+	return sum;
+}
 
-	CFeatureList::const_iterator itList1, itList2;  // Iterators for the lists
+inline unsigned int popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<unsigned int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
 
-	// For SIFT & SURF
-	float distDesc;  // EDD or EDSD
-	float minDist1;  // Minimum EDD or EDSD
-	float minDist2;  // Second minimum EDD or EDSD
+/** Hamming distance between two ORB descriptors, 64 bits at a time */
+unsigned int distanceORB(const uint8_t* a, const uint8_t* b, const size_t n)
+{
+	size_t i = 0;
+	unsigned int dist = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t wa, wb;
+		std::memcpy(&wa, a + i, sizeof(wa));
+		std::memcpy(&wb, b + i, sizeof(wb));
+		dist += popcount64(wa ^ wb);
+	}
+	for (; i < n; i++) dist += popcount64(uint64_t(a[i] ^ b[i]));
+	return dist;
+}
 
-	// For Harris
-	double maxCC1;  // Maximum CC
-	double maxCC2;  // Second maximum CC
+/** Cross correlation between the patches of two features */
+double patchCrossCorrelation(const CFeature& f1, const CFeature& f2)
+{
+	size_t u, v;  // Coordinates of the peak
+	double res;  // Value of the peak
+	vision::openCV_cross_correlation(f1.patch, f2.patch, u, v, res);
+	return res;
+}
 
-	// For SAD
-	double minSAD1, minSAD2;
+/** Sum of absolute differences (range [0,1]) between the patches of two
+ * features */
+double patchSAD(const CFeature& f1, const CFeature& f2)
+{
+	ASSERT_(f2.patchSize == f1.patchSize);
+#if !MRPT_HAS_OPENCV
+	MRPT_UNUSED_PARAM(f1);
+	MRPT_UNUSED_PARAM(f2);
+	THROW_EXCEPTION("MRPT has been compiled without OpenCV");
+#else
+	IplImage *aux1, *aux2;
+	const bool color = f1.patch.isColor() && f2.patch.isColor();
+	if (color)
+	{
+		const IplImage* preAux1 = f1.patch.getAs<IplImage>();
+		const IplImage* preAux2 = f2.patch.getAs<IplImage>();
 
-	vector<int> idxLeftList, idxRightList;
-	idxLeftList.resize(sz1, FEAT_FREE);
-	idxRightList.resize(sz2, FEAT_FREE);
-	vector<double> distCorrs(sz1);
-	int lFeat, rFeat;
-	int minLeftIdx = 0, minRightIdx;
-	int nMatches = 0;
+		aux1 = cvCreateImage(
+			cvSize(f1.patch.getHeight(), f1.patch.getWidth()), IPL_DEPTH_8U, 1);
+		aux2 = cvCreateImage(
+			cvSize(f2.patch.getHeight(), f2.patch.getWidth()), IPL_DEPTH_8U, 1);
 
-	// For each feature in list1 ...
-	for (lFeat = 0, itList1 = list1.begin(); itList1 != list1.end();
-		 ++itList1, ++lFeat)
+		cvCvtColor(preAux1, aux1, CV_BGR2GRAY);
+		cvCvtColor(preAux2, aux2, CV_BGR2GRAY);
+	}
+	else
 	{
-		// For SIFT & SURF
-		minDist1 = 1e5;
-		minDist2 = 1e5;
+		aux1 = const_cast<IplImage*>(f1.patch.getAs<IplImage>());
+		aux2 = const_cast<IplImage*>(f2.patch.getAs<IplImage>());
+	}
 
-		// For Harris
-		maxCC1 = 0;
-		maxCC2 = 0;
+	double res = 0;
+	for (unsigned int ii = 0; ii < (unsigned int)aux1->height; ++ii)  // Rows
+		for (unsigned int jj = 0; jj < (unsigned int)aux1->width;
+			 ++jj)  // Cols
+			res += fabs(
+				(double)(aux1->imageData[ii * aux1->widthStep + jj]) -
+				((double)(aux2->imageData[ii * aux2->widthStep + jj])));
+	res = res / (255.0f * aux1->width * aux1->height);
 
-		// For SAD
-		minSAD1 = 1e5;
-		minSAD2 = 1e5;
+	if (color)
+	{
+		cvReleaseImage(&aux1);
+		cvReleaseImage(&aux2);
+	}
+	return res;
+#endif
+}
 
-		// For all the cases
-		minRightIdx = 0;
+/** The two lowest scores found for a feature, and the index of the lowest
+ * one. Ties are resolved to the lowest index, so the result does not depend
+ * on the order in which the candidates are visited. */
+struct TBestTwo
+{
+	TBestTwo(const double init) : best1(init), best2(init), idx(FEAT_FREE) {}
+	double best1, best2;
+	int idx;
 
-		for (rFeat = 0, itList2 = list2.begin(); itList2 != list2.end();
-			 ++itList2, ++rFeat)  // ... compare with all the features in list2.
+	inline void update(const double v, const int i)
+	{
+		if (v < best1 || (v == best1 && i < idx))
 		{
-			// Filter out by epipolar constraint
-			double d = 0.0;  // Distance to the epipolar line
-			if (options.useEpipolarRestriction)
-			{
-				if (options.parallelOpticalAxis)
-					d = (*itList1)->y - (*itList2)->y;
-				else
-				{
-					ASSERT_(options.hasFundamentalMatrix);
-
-					// Compute epipolar line Ax + By + C = 0
-					TLine2D epiLine;
-					TPoint2D oPoint((*itList2)->x, (*itList2)->y);
+			best2 = best1;
+			best1 = v;
+			idx = i;
+		}
+		else if (v < best2)
+			best2 = v;
+	}
+};
 
-					CMatrixDouble31 l, p;
-					p(0, 0) = (*itList1)->x;
-					p(1, 0) = (*itList1)->y;
-					p(2, 0) = 1;
+template <class SCORE>
+TBestTwo findBestTwo(
+	const std::vector<int>& candidates, const double init, SCORE score)
+{
+	TBestTwo best(init);
+	for (const int j : candidates) best.update(score(j), j);
+	return best;
+}
 
-					l = params.F * p;
+/** Finds the features of the second list which fulfill the epipolar and
+ * x-coordinate restrictions of matchFeatures() for a feature of the first
+ * list, visiting only those near its epipolar line: the second list is
+ * sorted by rows if the optical axes are parallel, or bucketed in a grid of
+ * square cells otherwise. */
+class TMatchCandidatesFinder
+{
+   public:
+	TMatchCandidatesFinder(
+		const CCompactFeatureList& feats2, const TMatchingOptions& options,
+		const CMatrixDouble33& F)
+		: m_opts(options), m_F(F), m_x(feats2.x), m_y(feats2.y)
+	{
+		const int N = static_cast<int>(feats2.size());
+		if (!m_opts.useEpipolarRestriction) return;
 
-					epiLine.coefs[0] = l(0, 0);
-					epiLine.coefs[1] = l(1, 0);
-					epiLine.coefs[2] = l(2, 0);
+		if (m_opts.parallelOpticalAxis)
+		{
+			m_sorted_by_y.resize(N);
+			for (int i = 0; i < N; i++) m_sorted_by_y[i] = i;
+			std::sort(
+				m_sorted_by_y.begin(), m_sorted_by_y.end(),
+				[this](int i, int j) { return m_y[i] < m_y[j]; });
+			return;
+		}
 
-					d = epiLine.distance(oPoint);
-				}  // end else
-			}  // end if
+		// Grid of cells, in CSR format (the features of each cell are
+		// consecutive in m_cell_items):
+		const auto x_lims = std::minmax_element(m_x.begin(), m_x.end());
+		const auto y_lims = std::minmax_element(m_y.begin(), m_y.end());
+		m_x0 = *x_lims.first;
+		m_y0 = *y_lims.first;
+		const double extent =
+			std::max(*x_lims.second - m_x0, *y_lims.second - m_y0);
+		m_cell_size = std::max(
+			std::max(4.0 * m_opts.epipolar_TH, 16.0),
+			extent / (MAX_CELLS_PER_AXIS - 1));
+		m_nx = 1 + cellIndex(*x_lims.second - m_x0, MAX_CELLS_PER_AXIS - 1);
+		m_ny = 1 + cellIndex(*y_lims.second - m_y0, MAX_CELLS_PER_AXIS - 1);
+		std::vector<int> cell(N);
+		m_cell_start.assign(m_nx * m_ny + 1, 0);
+		for (int i = 0; i < N; i++)
+		{
+			cell[i] = std::min(cellIndex(m_x[i] - m_x0, m_nx - 1), m_nx - 1) +
+					  m_nx * std::min(
+								 cellIndex(m_y[i] - m_y0, m_ny - 1), m_ny - 1);
+			m_cell_start[cell[i] + 1]++;
+		}
+		for (size_t c = 1; c < m_cell_start.size(); c++)
+			m_cell_start[c] += m_cell_start[c - 1];
+		m_cell_items.resize(N);
+		std::vector<int> next(m_cell_start.begin(), m_cell_start.end() - 1);
+		for (int i = 0; i < N; i++) m_cell_items[next[cell[i]]++] = i;
+	}
 
-			bool c1 = options.useEpipolarRestriction
-						  ? fabs(d) < options.epipolar_TH
-						  : true;  // Use epipolar restriction
-			bool c2 = options.useXRestriction
-						  ? ((*itList1)->x - (*itList2)->x) > 0
-						  : true;  // Use x-coord restriction
+	/** Fills `out` with the indices of the candidates to match a feature
+	 * at (x,y) in the first image */
+	void find(const float x, const float y, std::vector<int>& out) const
+	{
+		out.clear();
+		const int N = static_cast<int>(m_x.size());
+		const double TH = m_opts.epipolar_TH;
 
-			if (c1 && c2)
+		if (!m_opts.useEpipolarRestriction)
+		{
+			for (int j = 0; j < N; j++)
+				if (fulfillsXRestriction(x, j)) out.push_back(j);
+		}
+		else if (m_opts.parallelOpticalAxis)
+		{
+			auto it = std::lower_bound(
+				m_sorted_by_y.begin(), m_sorted_by_y.end(), y - TH,
+				[this](int j, double v) { return m_y[j] < v; });
+			for (; it != m_sorted_by_y.end() && m_y[*it] <= y + TH; ++it)
 			{
-				switch (options.matching_method)
+				const double d = y - m_y[*it];
+				if (fabs(d) < TH && fulfillsXRestriction(x, *it))
+					out.push_back(*it);
+			}
+		}
+		else
+		{
+			// Epipolar line a*x+b*y+c=0 in the second image:
+			const double a = m_F(0, 0) * x + m_F(0, 1) * y + m_F(0, 2),
+						 b = m_F(1, 0) * x + m_F(1, 1) * y + m_F(1, 2),
+						 c = m_F(2, 0) * x + m_F(2, 1) * y + m_F(2, 2);
+			const double norm = sqrt(a * a + b * b);
+			if (!(norm > 0)) return;
+
+			auto visit_cell = [&](const int cx, const int cy) {
+				const int cell = cx + m_nx * cy;
+				for (int k = m_cell_start[cell]; k < m_cell_start[cell + 1];
+					 k++)
 				{
-					case TMatchingOptions::mmDescriptorSIFT:
-					{
-						// Ensure that both features have SIFT descriptors
-						ASSERT_(
-							(*itList1)->descriptors.hasDescriptorSIFT() &&
-							(*itList2)->descriptors.hasDescriptorSIFT());
+					const int j = m_cell_items[k];
+					const double d = fabs(a * m_x[j] + b * m_y[j] + c) / norm;
+					if (d < TH && fulfillsXRestriction(x, j))
+						out.push_back(j);
+				}
+			};
+			// Walk along the cells of the band |distance to the line| < TH,
+			// by columns (or rows) of cells for lines closer to the
+			// horizontal (or vertical) direction:
+			const bool horizontal = fabs(b) >= fabs(a);
+			const double half_band =
+				TH * norm / (horizontal ? fabs(b) : fabs(a));
+			const int n_outer = horizontal ? m_nx : m_ny;
+			const int n_inner = horizontal ? m_ny : m_nx;
+			const double o0 = horizontal ? m_x0 : m_y0;
+			const double i0 = horizontal ? m_y0 : m_x0;
+			const double k_outer = horizontal ? a : b,
+						 k_inner = horizontal ? b : a;
+			for (int co = 0; co < n_outer; co++)
+			{
+				const double s0 = o0 + co * m_cell_size, s1 = s0 + m_cell_size;
+				const double t0 = -(c + k_outer * s0) / k_inner,
+							 t1 = -(c + k_outer * s1) / k_inner;
+				const int ci_min = std::max(
+					0, cellIndex(std::min(t0, t1) - half_band - i0, n_inner));
+				const int ci_max = std::min(
+					n_inner - 1,
+					cellIndex(std::max(t0, t1) + half_band - i0, n_inner));
+				for (int ci = ci_min; ci <= ci_max; ci++)
+				{
+					if (horizontal)
+						visit_cell(co, ci);
+					else
+						visit_cell(ci, co);
+				}
+			}
+		}
+	}
 
-						// Compute the Euclidean distance between descriptors
-						distDesc =
-							(*itList1)->descriptorSIFTDistanceTo(*(*itList2));
+   private:
+	/** Limit to the size of the grid (the cells are enlarged for features
+	 * spread too far away) */
+	static const int MAX_CELLS_PER_AXIS = 4096;
+
+	const TMatchingOptions& m_opts;
+	const CMatrixDouble33& m_F;
+	/** Coordinates of the features of the second list */
+	const std::vector<float>& m_x;
+	const std::vector<float>& m_y;
+	/** Parallel optical axes: indices of the features, sorted by rows */
+	std::vector<int> m_sorted_by_y;
+	/** Otherwise: grid of cells */
+	double m_cell_size = 1, m_x0 = 0, m_y0 = 0;
+	int m_nx = 0, m_ny = 0;
+	std::vector<int> m_cell_start, m_cell_items;
+
+	/** Index of the cell for a coordinate relative to the grid origin,
+	 * saturated to [-1,n] */
+	int cellIndex(const double v, const int n) const
+	{
+		const double c = std::floor(v / m_cell_size);
+		if (!(c >= 0)) return -1;  // (also for NaN)
+		return c >= n ? n : static_cast<int>(c);
+	}
 
-						// Search for the two minimum values
-						if (distDesc < minDist1)
-						{
-							minDist2 = minDist1;
-							minDist1 = distDesc;
-							minLeftIdx = lFeat;
-							minRightIdx = rFeat;
-						}
-						else if (distDesc < minDist2)
-							minDist2 = distDesc;
-
-						break;
-					}  // end mmDescriptorSIFT
-
-					case TMatchingOptions::mmCorrelation:
-					{
-						size_t u, v;  // Coordinates of the peak
-						double res;  // Value of the peak
-
-						// Ensure that both features have patches
-						ASSERT_(
-							(*itList1)->patchSize > 0 &&
-							(*itList2)->patchSize > 0);
-						vision::openCV_cross_correlation(
-							(*itList1)->patch, (*itList2)->patch, u, v, res);
-
-						// Search for the two maximum values
-						if (res > maxCC1)
-						{
-							maxCC2 = maxCC1;
-							maxCC1 = res;
-							minLeftIdx = lFeat;
-							minRightIdx = rFeat;
-						}
-						else if (res > maxCC2)
-							maxCC2 = res;
-
-						break;
-					}  // end mmCorrelation
-
-					case TMatchingOptions::mmDescriptorSURF:
-					{
-						// Ensure that both features have SURF descriptors
-						ASSERT_(
-							(*itList1)->descriptors.hasDescriptorSURF() &&
-							(*itList2)->descriptors.hasDescriptorSURF());
+	bool fulfillsXRestriction(const float x, const int j) const
+	{
+		return !m_opts.useXRestriction || (x - m_x[j]) > 0;
+	}
+};
+/** The core of matchFeatures(): finds the index of the feature of the
+ * second list matched to each feature of the first one (or FEAT_FREE). The
+ * features with the image patches (`patches1`, `patches2`) are only required
+ * by the mmCorrelation and mmSAD methods. */
+void findMatches(
+	const CCompactFeatureList& list1, const CCompactFeatureList& list2,
+	const std::vector<const CFeature*>& patches1,
+	const std::vector<const CFeature*>& patches2,
+	const TMatchingOptions& options, const CMatrixDouble33& F,
+	std::vector<int>& idxLeftList)
+{
+	const size_t sz1 = list1.size(), sz2 = list2.size();
 
-						// Compute the Euclidean distance between descriptors
-						distDesc =
-							(*itList1)->descriptorSURFDistanceTo(*(*itList2));
+	// Check the required data:
+	switch (options.matching_method)
+	{
+		case TMatchingOptions::mmDescriptorSIFT:
+			ASSERTMSG_(
+				list1.hasDescriptorSIFT() && list2.hasDescriptorSIFT(),
+				"Features without SIFT descriptors");
+			ASSERT_EQUAL_(list1.SIFT.cols(), list2.SIFT.cols());
+			break;
+		case TMatchingOptions::mmDescriptorSURF:
+			ASSERTMSG_(
+				list1.hasDescriptorSURF() && list2.hasDescriptorSURF(),
+				"Features without SURF descriptors");
+			ASSERT_EQUAL_(list1.SURF.cols(), list2.SURF.cols());
+			break;
+		case TMatchingOptions::mmDescriptorORB:
+			ASSERTMSG_(
+				list1.hasDescriptorORB() && list2.hasDescriptorORB(),
+				"Features without ORB descriptors");
+			ASSERT_EQUAL_(list1.ORB.cols(), list2.ORB.cols());
+			break;
+		case TMatchingOptions::mmCorrelation:
+		case TMatchingOptions::mmSAD:
+			ASSERTMSG_(
+				patches1.size() == sz1 && patches2.size() == sz2,
+				"This matching method requires the image patches");
+			// Load the patches now, not concurrently from the threads below:
+			for (const auto* feats : {&patches1, &patches2})
+				for (const CFeature* f : *feats)
+				{
+					ASSERT_(f->patchSize > 0);
+					f->patch.forceLoad();
+				}
+			break;
+		default:
+			THROW_EXCEPTION("Invalid value of 'matching_method'");
+	}
 
-						// Search for the two minimum values
-						if (distDesc < minDist1)
-						{
-							minDist2 = minDist1;
-							minDist1 = distDesc;
-							minLeftIdx = lFeat;
-							minRightIdx = rFeat;
-						}
-						else if (distDesc < minDist2)
-							minDist2 = distDesc;
-
-						break;  // end case featSURF
-					}  // end mmDescriptorSURF
-
-					case TMatchingOptions::mmDescriptorORB:
-					{
-						// Ensure that both features have SURF descriptors
-						ASSERT_(
-							(*itList1)->descriptors.hasDescriptorORB() &&
-							(*itList2)->descriptors.hasDescriptorORB());
-						distDesc =
-							(*itList1)->descriptorORBDistanceTo(*(*itList2));
-
-						// Search for the two minimum values
-						if (distDesc < minDist1)
-						{
-							minDist2 = minDist1;
-							minDist1 = distDesc;
-							minLeftIdx = lFeat;
-							minRightIdx = rFeat;
-						}
-						else if (distDesc < minDist2)
-							minDist2 = distDesc;
-
-						break;
-					}  // end mmDescriptorORB
-
-					case TMatchingOptions::mmSAD:
-					{
-						// Ensure that both features have patches
-						ASSERT_(
-							(*itList1)->patchSize > 0 &&
-							(*itList2)->patchSize == (*itList1)->patchSize);
-#if !MRPT_HAS_OPENCV
-						THROW_EXCEPTION("MRPT has been compiled without OpenCV")
-#else
-						IplImage *aux1, *aux2;
-						if ((*itList1)->patch.isColor() &&
-							(*itList2)->patch.isColor())
-						{
-							const IplImage* preAux1 =
-								(*itList1)->patch.getAs<IplImage>();
-							const IplImage* preAux2 =
-								(*itList2)->patch.getAs<IplImage>();
-
-							aux1 = cvCreateImage(
-								cvSize(
-									(*itList1)->patch.getHeight(),
-									(*itList1)->patch.getWidth()),
-								IPL_DEPTH_8U, 1);
-							aux2 = cvCreateImage(
-								cvSize(
-									(*itList2)->patch.getHeight(),
-									(*itList2)->patch.getWidth()),
-								IPL_DEPTH_8U, 1);
-
-							cvCvtColor(preAux1, aux1, CV_BGR2GRAY);
-							cvCvtColor(preAux2, aux2, CV_BGR2GRAY);
-						}
-						else
-						{
-							aux1 = const_cast<IplImage*>(
-								(*itList1)->patch.getAs<IplImage>());
-							aux2 = const_cast<IplImage*>(
-								(*itList2)->patch.getAs<IplImage>());
-						}
-
-						// OLD CODE (for checking purposes)
-						//					for( unsigned int ii = 0; ii <
-						//(unsigned
-						// int)aux1->imageSize; ++ii )
-						//						m1 += aux1->imageData[ii];
-						//					m1 /= (double)aux1->imageSize;
-
-						//					for( unsigned int ii = 0; ii <
-						//(unsigned
-						// int)aux2->imageSize; ++ii )
-						//						m2 += aux2->imageData[ii];
-						//					m2 /= (double)aux2->imageSize;
-
-						//					for( unsigned int ii = 0; ii <
-						//(unsigned
-						// int)aux1->imageSize; ++ii )
-						//						res += fabs(
-						// fabs((double)aux1->imageData[ii]-m1) -
-						// fabs((double)aux2->imageData[ii]-m2) );
-
-						// NEW CODE
-						double res = 0;
-						for (unsigned int ii = 0;
-							 ii < (unsigned int)aux1->height; ++ii)  // Rows
-							for (unsigned int jj = 0;
-								 jj < (unsigned int)aux1->width; ++jj)  // Cols
-								res += fabs(
-									(double)(aux1->imageData[ii * aux1->widthStep + jj]) -
-									((double)(aux2->imageData[ii * aux2->widthStep + jj])));
-						res = res / (255.0f * aux1->width * aux1->height);
-
-						if (res < minSAD1)
-						{
-							minSAD2 = minSAD1;
-							minSAD1 = res;
-							minLeftIdx = lFeat;
-							minRightIdx = rFeat;
-						}
-						else if (res < minSAD2)
-							minSAD2 = res;
-#endif
-						break;
-					}  // end mmSAD
-				}  // end switch
-			}  // end if
-		}  // end for 'list2' (right features)
+	const TMatchCandidatesFinder finder(list2, options, F);
 
-		bool cond1 = false, cond2 = false;
-		double minVal = 1.0;
-		switch (options.matching_method)
-		{
-			case TMatchingOptions::mmDescriptorSIFT:
-				cond1 = minDist1 < options.maxEDD_TH;  // Maximum Euclidean
-				// Distance between SIFT
-				// descriptors (EDD)
-				cond2 = (minDist1 / minDist2) <
-						options.EDD_RATIO;  // Ratio between the two lowest EDSD
-				minVal = minDist1;
-				break;
-			case TMatchingOptions::mmCorrelation:
-				cond1 = maxCC1 >
-						options.minCC_TH;  // Minimum cross correlation value
-				cond2 = (maxCC2 / maxCC1) <
-						options.rCC_TH;  // Ratio between the two highest cross
-				// correlation values
-				minVal = 1 - maxCC1;
-				break;
-			case TMatchingOptions::mmDescriptorSURF:
-				cond1 = minDist1 < options.maxEDSD_TH;  // Maximum Euclidean
-				// Distance between SURF
-				// descriptors (EDSD)
-				cond2 =
-					(minDist1 / minDist2) <
-					options.EDSD_RATIO;  // Ratio between the two lowest EDSD
-				minVal = minDist1;
-				break;
-			case TMatchingOptions::mmSAD:
-				cond1 = minSAD1 < options.maxSAD_TH;
-				cond2 = (minSAD1 / minSAD2) < options.SAD_RATIO;
-				minVal = minSAD1;
-				break;
-			case TMatchingOptions::mmDescriptorORB:
-				cond1 = minDist1 < options.maxORB_dist;
-				cond2 = true;
-				minVal = minDist1;
-				break;
-			default:
-				THROW_EXCEPTION("Invalid value of 'matching_method'");
-		}
+	// Find the best match in list2 for each feature in list1, and decide
+	// whether it is good enough. This is done in parallel:
+	std::vector<int> bestIdx(sz1, FEAT_FREE);
+	std::vector<double> bestVal(sz1, 1.0);
 
-		// PROCESS THE RESULTS
-		if (cond1 && cond2)  // The minimum distance must be below a threshold
+	auto match_range = [&](size_t, size_t first, size_t last) {
+		std::vector<int> candidates;
+		for (size_t i = first; i < last; i++)
 		{
-			int auxIdx = idxRightList[minRightIdx];
-			if (auxIdx != FEAT_FREE)
+			finder.find(list1.x[i], list1.y[i], candidates);
+
+			bool cond1 = false, cond2 = false;
+			double minVal = 1.0;
+			TBestTwo best(0);
+			switch (options.matching_method)
 			{
-				if (distCorrs[auxIdx] > minVal)
+				case TMatchingOptions::mmDescriptorSIFT:
 				{
-					// We've found a better match
-					//                    cout << "Better match found: [R] " <<
-					//                    idxLeftList[auxIdx] << " was with [L]
-					//                    " << auxIdx << "(" << distCorrs[
-					//                    auxIdx ] << ")";
-					//                    cout << " now is with [L] " <<
-					//                    minLeftIdx << "(" << minVal << ")" <<
-					//                    endl;
-					distCorrs[minLeftIdx] = minVal;
-					idxLeftList[minLeftIdx] = minRightIdx;
-					idxRightList[minRightIdx] = minLeftIdx;
-
-					distCorrs[auxIdx] = 1.0;
-					idxLeftList[auxIdx] = FEAT_FREE;
-				}  // end-if
-				//                else
-				//                    cout << "Conflict but not better match" <<
-				//                    endl;
-			}  // end-if
-			else
+					const uint8_t* d1 = list1.SIFT[i];
+					// (Normalized as in CFeature::descriptorSIFTDistanceTo())
+					const size_t len = list1.SIFT.cols(),
+								 stride = list1.SIFT.stride();
+					best = findBestTwo(candidates, 1e5, [&](int j) {
+						const float d2 =
+							sqrDistanceSIFT(d1, list2.SIFT[j], stride);
+						return double(std::sqrt(d2 / len) / 64.0f);
+					});
+					// Maximum Euclidean Distance between SIFT descriptors
+					// (EDD), and ratio between the two lowest EDD:
+					cond1 = best.best1 < options.maxEDD_TH;
+					cond2 = (best.best1 / best.best2) < options.EDD_RATIO;
+					minVal = best.best1;
+					break;
+				}
+				case TMatchingOptions::mmCorrelation:
+				{
+					const CFeature& f1 = *patches1[i];
+					// Look for the two highest cross correlation values:
+					best = findBestTwo(candidates, 0, [&](int j) {
+						return -patchCrossCorrelation(f1, *patches2[j]);
+					});
+					const double maxCC1 = -best.best1, maxCC2 = -best.best2;
+					// Minimum cross correlation value, and ratio between the
+					// two highest values:
+					cond1 = maxCC1 > options.minCC_TH;
+					cond2 = (maxCC2 / maxCC1) < options.rCC_TH;
+					minVal = 1 - maxCC1;
+					break;
+				}
+				case TMatchingOptions::mmDescriptorSURF:
+				{
+					const float* d1 = list1.SURF[i];
+					// (Normalized as in CFeature::descriptorSURFDistanceTo())
+					const size_t len = list1.SURF.cols(),
+								 stride = list1.SURF.stride();
+					best = findBestTwo(candidates, 1e5, [&](int j) {
+						const float d2 =
+							sqrDistanceSURF(d1, list2.SURF[j], stride);
+						return double(std::sqrt(d2 / len) / 0.20f);
+					});
+					// Maximum Euclidean Distance between SURF descriptors
+					// (EDSD), and ratio between the two lowest EDSD:
+					cond1 = best.best1 < options.maxEDSD_TH;
+					cond2 = (best.best1 / best.best2) < options.EDSD_RATIO;
+					minVal = best.best1;
+					break;
+				}
+				case TMatchingOptions::mmSAD:
+				{
+					const CFeature& f1 = *patches1[i];
+					best = findBestTwo(candidates, 1e5, [&](int j) {
+						return patchSAD(f1, *patches2[j]);
+					});
+					cond1 = best.best1 < options.maxSAD_TH;
+					cond2 = (best.best1 / best.best2) < options.SAD_RATIO;
+					minVal = best.best1;
+					break;
+				}
+				case TMatchingOptions::mmDescriptorORB:
+				{
+					const uint8_t* d1 = list1.ORB[i];
+					const size_t stride = list1.ORB.stride();
+					best = findBestTwo(candidates, 1e5, [&](int j) {
+						return double(distanceORB(d1, list2.ORB[j], stride));
+					});
+					cond1 = best.best1 < options.maxORB_dist;
+					cond2 = options.ORB_RATIO >= 1 ||
+							(best.best1 / best.best2) < options.ORB_RATIO;
+					minVal = best.best1;
+					break;
+				}
+			}
+
+			if (best.idx != FEAT_FREE && cond1 && cond2)
 			{
-				//		        cout << "New match found: [R] " << minRightIdx
-				//<<
-				//" with [L] " << minLeftIdx << "(" << minVal << ")" << endl;
-				idxRightList[minRightIdx] = minLeftIdx;
-				idxLeftList[minLeftIdx] = minRightIdx;
-				distCorrs[minLeftIdx] = minVal;
-				nMatches++;
+				bestIdx[i] = best.idx;
+				bestVal[i] = minVal;
 			}
-		}  // end if
+		}
+	};
+	mrpt::utils::parallel_for_ranges(
+		sz1, options.num_threads, match_range, MIN_FEATURES_PER_THREAD);
+
+	// PROCESS THE RESULTS: solve conflicts between features of list1 matched
+	// to the same feature of list2, in the order of list1.
+	idxLeftList.assign(sz1, FEAT_FREE);
+	vector<int> idxRightList(sz2, FEAT_FREE);
+	vector<double> distCorrs(sz1);
+	for (int minLeftIdx = 0; minLeftIdx < (int)sz1; ++minLeftIdx)
+	{
+		const int minRightIdx = bestIdx[minLeftIdx];
+		if (minRightIdx == FEAT_FREE) continue;
+		const double minVal = bestVal[minLeftIdx];
+
+		int auxIdx = idxRightList[minRightIdx];
+		if (auxIdx != FEAT_FREE)
+		{
+			if (distCorrs[auxIdx] > minVal)
+			{
+				// We've found a better match
+				distCorrs[minLeftIdx] = minVal;
+				idxLeftList[minLeftIdx] = minRightIdx;
+				idxRightList[minRightIdx] = minLeftIdx;
+
+				distCorrs[auxIdx] = 1.0;
+				idxLeftList[auxIdx] = FEAT_FREE;
+			}  // end-if
+		}  // end-if
+		else
+		{
+			idxRightList[minRightIdx] = minLeftIdx;
+			idxLeftList[minLeftIdx] = minRightIdx;
+			distCorrs[minLeftIdx] = minVal;
+		}
 	}  // end for 'list1' (left features)
+}
+}  // namespace
+
+size_t vision::matchFeatures(
+	const CFeatureList& list1, const CFeatureList& list2,
+	CMatchedFeatureList& matches, const TMatchingOptions& options,
+	const TStereoSystemParams& params)
+{
+	MRPT_START
+
+	// Preliminary comprobations
+	const size_t sz1 = list1.size(), sz2 = list2.size();
+
+	ASSERT_((sz1 > 0) && (sz2 > 0));  // Both lists have features within it
+	ASSERT_(
+		list1.get_type() ==
+		list2.get_type());  // Both lists must be of the same type
+	if (options.useEpipolarRestriction && !options.parallelOpticalAxis)
+		ASSERT_(options.hasFundamentalMatrix);
+
+	// Copy the coordinates, and only the descriptors to be matched, into
+	// contiguous arrays:
+	unsigned int descriptors = 0;
+	switch (options.matching_method)
+	{
+		case TMatchingOptions::mmDescriptorSIFT:
+			descriptors = descSIFT;
+			break;
+		case TMatchingOptions::mmDescriptorSURF:
+			descriptors = descSURF;
+			break;
+		case TMatchingOptions::mmDescriptorORB:
+			descriptors = descORB;
+			break;
+		default:
+			break;
+	}
+	const CCompactFeatureList compact1(list1, descriptors),
+		compact2(list2, descriptors);
+
+	std::vector<const CFeature*> feats1, feats2;
+	if (options.matching_method == TMatchingOptions::mmCorrelation ||
+		options.matching_method == TMatchingOptions::mmSAD)
+	{
+		feats1.reserve(sz1);
+		feats2.reserve(sz2);
+		for (const auto& f : list1) feats1.push_back(f.get());
+		for (const auto& f : list2) feats2.push_back(f.get());
+	}
+
+	std::vector<int> idxLeftList;
+	findMatches(
+		compact1, compact2, feats1, feats2, options, params.F, idxLeftList);
 
 	if (!options.addMatches) matches.clear();
 
@@ -903,6 +1129,36 @@ size_t vision::matchFeatures(
 	MRPT_END
 }
 
+size_t vision::matchFeatures(
+	const CCompactFeatureList& list1, const CCompactFeatureList& list2,
+	std::vector<std::pair<size_t, size_t>>& matches,
+	const TMatchingOptions& options, const TStereoSystemParams& params)
+{
+	MRPT_START
+
+	ASSERT_((list1.size() > 0) && (list2.size() > 0));
+	ASSERT_(list1.get_type() == list2.get_type());
+	if (options.useEpipolarRestriction && !options.parallelOpticalAxis)
+		ASSERT_(options.hasFundamentalMatrix);
+	ASSERTMSG_(
+		options.matching_method != TMatchingOptions::mmCorrelation &&
+			options.matching_method != TMatchingOptions::mmSAD,
+		"Only descriptor-based matching methods are supported");
+
+	std::vector<int> idxLeftList;
+	findMatches(
+		list1, list2, std::vector<const CFeature*>(),
+		std::vector<const CFeature*>(), options, params.F, idxLeftList);
+
+	if (!options.addMatches) matches.clear();
+	for (size_t i = 0; i < idxLeftList.size(); i++)
+		if (idxLeftList[i] != FEAT_FREE)
+			matches.push_back(std::make_pair(i, size_t(idxLeftList[i])));
+	return matches.size();
+
+	MRPT_END
+}
+
 /*-------------------------------------------------------------
 			generateMask
 -------------------------------------------------------------*/
@@ -2437,9 +2693,14 @@ TMatchingOptions::TMatchingOptions()
 	  maxSAD_TH(0.4),
 	  SAD_RATIO(0.5),
 
+	  // ORB
+	  maxORB_dist(64.0),
+	  ORB_RATIO(1.0f),  // Disabled
+
 	  // For estimating depth
 	  estimateDepth(false),
-	  maxDepthThreshold(15.0)
+	  maxDepthThreshold(15.0),
+	  num_threads(0)
 {
 }  // end constructor TMatchingOptions
 
@@ -2498,6 +2759,7 @@ void TMatchingOptions::loadFromConfigFile(
 	SAD_RATIO = iniFile.read_float(section.c_str(), "SAD_RATIO", SAD_RATIO);
 	maxORB_dist =
 		iniFile.read_float(section.c_str(), "maxORB_dist", maxORB_dist);
+	ORB_RATIO = iniFile.read_float(section.c_str(), "ORB_RATIO", ORB_RATIO);
 
 	estimateDepth =
 		iniFile.read_bool(section.c_str(), "estimateDepth", estimateDepth);
@@ -2508,6 +2770,8 @@ void TMatchingOptions::loadFromConfigFile(
 	//	cy                  = iniFile.read_float(section.c_str(),"cy",cy);
 	//	baseline            =
 	// iniFile.read_float(section.c_str(),"baseline",baseline);
+	num_threads =
+		iniFile.read_int(section.c_str(), "num_threads", num_threads);
 }  // end TMatchingOptions::loadFromConfigFile
 
 /*---------------------------------------------------------------
@@ -2543,6 +2807,7 @@ void TMatchingOptions::dumpToTextStream(CStream& out) const
 		case mmDescriptorORB:
 			out.printf("ORB\n");
 			out.printf("· Max. distance between desc:	%f\n", maxORB_dist);
+			out.printf("· ORB Ratio:                    %f\n", ORB_RATIO);
 			break;
 	}  // end switch
 	out.printf("Epipolar Thres:                 %.2f px\n", epipolar_TH);
@@ -2573,5 +2838,6 @@ void TMatchingOptions::dumpToTextStream(CStream& out) const
 	}
 	out.printf("Add matches to list?:           ");
 	out.printf(addMatches ? "Yes\n" : "No\n");
+	out.printf("Number of threads:              %u\n", num_threads);
 	out.printf("-------------------------------------------------------- \n");
 }  // end TMatchingOptions::dumpToTextStream